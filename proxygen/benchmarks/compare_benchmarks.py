@@ -0,0 +1,133 @@
+#!/usr/bin/env python3
+# Copyright (c) 2019-present, Facebook, Inc.
+# All rights reserved.
+#
+# This source code is licensed under the BSD-style license found in the
+# LICENSE file in the root directory of this source tree. An additional grant
+# of patent rights can be found in the PATENTS file in the same directory.
+"""
+Runs the proxygen benchmark binaries and compares the results against a
+saved baseline.
+
+Record a baseline from a release build:
+
+    ./compare_benchmarks.py --bin-dir build/proxygen/benchmarks \
+        --record baselines/v2019.08
+
+Compare the current build against it:
+
+    ./compare_benchmarks.py --bin-dir build/proxygen/benchmarks \
+        --baseline baselines/v2019.08 --threshold 5
+
+The exit status is non-zero if any benchmark regressed by more than the
+threshold percentage, so this can gate a release pipeline.
+"""
+
+import argparse
+import json
+import os
+import subprocess
+import sys
+
+BENCHMARKS = [
+    "HTTP1xCodecBenchmark",
+    "HTTP2CodecBenchmark",
+    "HPACKBenchmark",
+    "HuffmanBenchmark",
+    "HTTPHeadersBenchmark",
+    "PerfectIndexMapBenchmark",
+]
+
+
+def run_benchmark(binary):
+    """Returns {benchmark name: seconds per iteration}."""
+    output = subprocess.check_output([binary, "--json"]).decode("utf-8")
+    raw = json.loads(output)
+    results = {}
+    for name, value in raw.items():
+        # folly --json emits {name: sec/iter}; be tolerant of list-shaped
+        # values from --bm_json_verbose style output
+        if isinstance(value, list):
+            value = next(v for v in value if isinstance(v, (int, float)))
+        results[name] = float(value)
+    return results
+
+
+def collect(bin_dir):
+    results = {}
+    for bench in BENCHMARKS:
+        binary = os.path.join(bin_dir, bench)
+        if not os.path.exists(binary):
+            print("skipping %s (not built)" % bench)
+            continue
+        results[bench] = run_benchmark(binary)
+    return results
+
+
+def record(results, baseline_dir):
+    os.makedirs(baseline_dir, exist_ok=True)
+    for bench, data in results.items():
+        with open(os.path.join(baseline_dir, bench + ".json"), "w") as f:
+            json.dump(data, f, indent=2, sort_keys=True)
+    print("recorded baseline for %d binaries in %s" %
+          (len(results), baseline_dir))
+
+
+def compare(results, baseline_dir, threshold_pct):
+    regressions = 0
+    for bench, data in sorted(results.items()):
+        path = os.path.join(baseline_dir, bench + ".json")
+        if not os.path.exists(path):
+            print("%s: no baseline recorded" % bench)
+            continue
+        with open(path) as f:
+            baseline = json.load(f)
+        for name, secs in sorted(data.items()):
+            base = baseline.get(name)
+            if base is None or base <= 0:
+                print("  %-50s NEW      %12.2fns" % (name, secs * 1e9))
+                continue
+            delta_pct = (secs - base) / base * 100.0
+            flag = ""
+            if delta_pct > threshold_pct:
+                flag = "  << REGRESSION"
+                regressions += 1
+            print("  %-50s %+7.2f%% %12.2fns%s" %
+                  (name, delta_pct, secs * 1e9, flag))
+    return regressions
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument("--bin-dir", required=True,
+                        help="directory containing the benchmark binaries")
+    parser.add_argument("--record", metavar="DIR",
+                        help="write results to DIR as the new baseline")
+    parser.add_argument("--baseline", metavar="DIR",
+                        help="compare results against the baseline in DIR")
+    parser.add_argument("--threshold", type=float, default=5.0,
+                        help="regression threshold in percent (default 5)")
+    args = parser.parse_args()
+
+    if not args.record and not args.baseline:
+        parser.error("one of --record or --baseline is required")
+
+    results = collect(args.bin_dir)
+    if not results:
+        print("no benchmark binaries found in " + args.bin_dir)
+        return 1
+
+    if args.record:
+        record(results, args.record)
+        return 0
+
+    regressions = compare(results, args.baseline, args.threshold)
+    if regressions:
+        print("%d benchmark(s) regressed more than %.1f%%" %
+              (regressions, args.threshold))
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -241,6 +241,13 @@ struct http_parser {
 
   /** PUBLIC **/
   void *data; /* A pointer to get hook to the "connection" or "socket" object */
+
+  /* When nonzero, header values are scanned with a vectorized (SSE2/SWAR)
+   * fast path instead of the byte-at-a-time unrolled loop.  Semantics are
+   * identical; set it right after http_parser_init() and leave it alone
+   * while parsing.
+   */
+  unsigned char simd_scan;
 };
 
 
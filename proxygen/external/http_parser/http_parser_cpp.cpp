@@ -27,6 +27,7 @@
 #include <stddef.h>
 #include <limits.h>
 #include <stdlib.h>
+#include <string.h>
 
 #if __cplusplus
 #include <limits>
@@ -426,6 +427,69 @@ enum http_host_state
 #define IS_HEADER_CHAR(ch)                                                     \
   (ch == CR || ch == LF || ch == 9 || ((unsigned char)ch > 31 && ch != 127))
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/* Fast-forward over a run of ordinary header-value bytes, i.e. bytes that
+ * the h_general state would consume without a transition.  Returns a pointer
+ * to the first byte in [p, end) that is CR, LF, '"', '\\' or not a valid
+ * header char (see IS_HEADER_CHAR), or end if there is none.  Used when
+ * parser->simd_scan is set; the scalar MOVE_FAST unroll remains the default.
+ */
+static const char *
+scan_header_value (const char *p, const char *end)
+{
+#if defined(__SSE2__)
+  while (end - p >= 16) {
+    __m128i v = _mm_loadu_si128((const __m128i *)p);
+    /* bytes < 0x20 (unsigned): min(v, 0x1f) == v */
+    __m128i lt32 = _mm_cmpeq_epi8(_mm_min_epu8(v, _mm_set1_epi8(0x1f)), v);
+    __m128i tab = _mm_cmpeq_epi8(v, _mm_set1_epi8(9));
+    __m128i del = _mm_cmpeq_epi8(v, _mm_set1_epi8(127));
+    __m128i qt  = _mm_cmpeq_epi8(v, _mm_set1_epi8(QT));
+    __m128i bs  = _mm_cmpeq_epi8(v, _mm_set1_epi8(BS));
+    __m128i stop = _mm_or_si128(_mm_andnot_si128(tab, lt32),
+                                _mm_or_si128(_mm_or_si128(del, qt), bs));
+    int mask = _mm_movemask_epi8(stop);
+    if (mask != 0) {
+      return p + __builtin_ctz((unsigned)mask);
+    }
+    p += 16;
+  }
+#elif defined(__GNUC__) && defined(__BYTE_ORDER__) &&                          \
+    __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+  /* SWAR fallback: flag bytes < 0x20 (excluding tab) and 0x7f/0x22/0x5c */
+#define HTTP_PARSER_SWAR_ONES   0x0101010101010101ULL
+#define HTTP_PARSER_SWAR_HIGHS  0x8080808080808080ULL
+#define HTTP_PARSER_SWAR_HASZERO(v)                                            \
+  (((v) - HTTP_PARSER_SWAR_ONES) & ~(v) & HTTP_PARSER_SWAR_HIGHS)
+  while (end - p >= 8) {
+    uint64_t v;
+    memcpy(&v, p, 8);
+    uint64_t lt32 = (v - HTTP_PARSER_SWAR_ONES * 0x20) & ~v &
+                    HTTP_PARSER_SWAR_HIGHS;
+    uint64_t tab = HTTP_PARSER_SWAR_HASZERO(v ^ (HTTP_PARSER_SWAR_ONES * 9));
+    uint64_t del = HTTP_PARSER_SWAR_HASZERO(v ^ (HTTP_PARSER_SWAR_ONES * 127));
+    uint64_t qt = HTTP_PARSER_SWAR_HASZERO(v ^ (HTTP_PARSER_SWAR_ONES * QT));
+    uint64_t bs = HTTP_PARSER_SWAR_HASZERO(v ^ (HTTP_PARSER_SWAR_ONES * BS));
+    uint64_t stop = (lt32 & ~tab) | del | qt | bs;
+    if (stop != 0) {
+      return p + (__builtin_ctzll(stop) >> 3);
+    }
+    p += 8;
+  }
+#endif
+  while (p != end) {
+    char ch = *p;
+    if (ch == QT || ch == BS || !IS_HEADER_CHAR(ch) || ch == CR || ch == LF) {
+      return p;
+    }
+    p++;
+  }
+  return end;
+}
+
 #define start_state (parser->type == HTTP_REQUEST ? s_pre_start_req : s_pre_start_res)
 
 #define STRICT_CHECK(cond)
@@ -1712,6 +1776,14 @@ size_t http_parser_execute (http_parser *parser,
               }                                       \
             } while(0);
 
+            if (parser->simd_scan) {
+              /* Jump to the next special byte in one vectorized scan; the
+               * main loop's increment lands p on it for re-dispatch.
+               */
+              p = scan_header_value(p + 1, data + len) - 1;
+              break;
+            }
+
             if (data + len - p >= 12) {
               MOVE_FAST
               MOVE_FAST
@@ -2175,6 +2247,7 @@ http_parser_init (http_parser *parser, enum http_parser_type t)
   parser->http_major = 0;
   parser->http_minor = 0;
   parser->http_errno = HPE_OK;
+  parser->simd_scan = 0;
 }
 
 const char *
@@ -0,0 +1,116 @@
+/*
+ *  Copyright (c) 2015-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include <proxygen/httpserver/DelegatedResponseChannel.h>
+
+#include <glog/logging.h>
+
+namespace proxygen {
+
+constexpr size_t DelegatedResponseChannel::kDefaultQueueCapacity;
+
+DelegatedResponseChannel::DelegatedResponseChannel(ResponseHandler* downstream,
+                                                   folly::EventBase* evb,
+                                                   size_t queueCapacity)
+    : downstream_(CHECK_NOTNULL(downstream)),
+      evb_(CHECK_NOTNULL(evb)),
+      queue_(std::max<size_t>(queueCapacity, 2)) {
+  DCHECK(evb_->isInEventBaseThread());
+}
+
+DelegatedResponseChannel::~DelegatedResponseChannel() {
+  DCHECK(evb_->isInEventBaseThread());
+  *alive_ = false;
+}
+
+bool DelegatedResponseChannel::write(std::unique_ptr<folly::IOBuf> body) {
+  Chunk chunk;
+  chunk.body = std::move(body);
+  if (!queue_.write(std::move(chunk))) {
+    return false;
+  }
+  notifyConsumer();
+  return true;
+}
+
+bool DelegatedResponseChannel::writeEOM() {
+  Chunk chunk;
+  chunk.eom = true;
+  if (!queue_.write(std::move(chunk))) {
+    return false;
+  }
+  notifyConsumer();
+  return true;
+}
+
+void DelegatedResponseChannel::notifyConsumer() {
+  // Only the first chunk since the last drain pays for a cross-thread
+  // post; everything the producer queues before the loop callback runs
+  // rides along with it
+  if (!wakeupScheduled_.exchange(true, std::memory_order_acq_rel)) {
+    auto alive = alive_;
+    evb_->runInEventBaseThread([this, alive] {
+      if (*alive) {
+        drain();
+      }
+    });
+  }
+}
+
+void DelegatedResponseChannel::drain() {
+  // Clear the flag before reading so a producer enqueueing after the
+  // last read below schedules a fresh wakeup rather than getting lost
+  wakeupScheduled_.store(false, std::memory_order_release);
+  if (paused_ || finished_) {
+    // Chunks stay queued; onEgressResumed() picks them back up.  The
+    // flag stays clear so the producer's next write re-arms the wakeup,
+    // but resume must drain on its own since that write may never come.
+    return;
+  }
+  Chunk chunk;
+  while (queue_.read(chunk)) {
+    if (finished_) {
+      // cancelled mid-drain; discard the rest
+      continue;
+    }
+    if (chunk.body) {
+      downstream_->sendBody(std::move(chunk.body));
+    }
+    if (chunk.eom) {
+      downstream_->sendEOM();
+      finished_ = true;
+    }
+    if (paused_) {
+      // sendBody backed the transaction up; leave the rest queued
+      break;
+    }
+  }
+}
+
+void DelegatedResponseChannel::onEgressPaused() {
+  DCHECK(evb_->isInEventBaseThread());
+  paused_ = true;
+}
+
+void DelegatedResponseChannel::onEgressResumed() {
+  DCHECK(evb_->isInEventBaseThread());
+  paused_ = false;
+  drain();
+}
+
+void DelegatedResponseChannel::cancel() {
+  DCHECK(evb_->isInEventBaseThread());
+  finished_ = true;
+  downstream_ = nullptr;
+  Chunk chunk;
+  while (queue_.read(chunk)) {
+  }
+}
+
+} // namespace proxygen
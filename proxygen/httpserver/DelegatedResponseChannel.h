@@ -0,0 +1,126 @@
+/*
+ *  Copyright (c) 2015-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#pragma once
+
+#include <atomic>
+#include <folly/ProducerConsumerQueue.h>
+#include <folly/io/IOBuf.h>
+#include <folly/io/async/EventBase.h>
+#include <proxygen/httpserver/ResponseHandler.h>
+
+namespace proxygen {
+
+/**
+ * Hands the egress side of a response to a single producer thread.
+ *
+ * A RequestHandler that renders its body off the session's EventBase
+ * otherwise pays one cross-thread post per chunk.  The channel replaces
+ * that with a bounded lock-free single-producer single-consumer queue
+ * and batched wakeups: the producer enqueues chunks from its own thread
+ * and only the first chunk after a drain posts to the EventBase; one
+ * loop callback then drains everything queued since.
+ *
+ * Flow control stays on the owner loop.  Drained chunks go through the
+ * ResponseHandler, so the transaction's egress accounting applies as
+ * usual, and the handler should forward its onEgressPaused /
+ * onEgressResumed callbacks so draining stops while the transaction is
+ * paused.  While paused, chunks back up in the bounded queue and
+ * write() starts returning false, which is the producer's backpressure
+ * signal.
+ *
+ * Threading contract: construct, pause/resume, cancel and destroy on
+ * the session's EventBase; call write()/writeEOM() from exactly one
+ * other thread.  The producer must stop writing (and the channel be
+ * cancelled) before the handler detaches, e.g. from onError(); the
+ * channel must outlive any in-flight write() call.
+ */
+class DelegatedResponseChannel {
+ public:
+  static constexpr size_t kDefaultQueueCapacity = 64;
+
+  /**
+   * @param downstream  where drained chunks are sent; must stay valid
+   *                    until the channel is cancelled or finished
+   * @param evb         the session's EventBase
+   */
+  DelegatedResponseChannel(ResponseHandler* downstream,
+                           folly::EventBase* evb,
+                           size_t queueCapacity = kDefaultQueueCapacity);
+
+  ~DelegatedResponseChannel();
+
+  /**
+   * Producer thread: enqueue a body chunk.  Returns false when the
+   * queue is full - the consumer is behind or the transaction is
+   * paused - and the producer should back off and retry.
+   */
+  bool write(std::unique_ptr<folly::IOBuf> body);
+
+  /**
+   * Producer thread: mark the end of the body.  The EOM is delivered
+   * after every queued chunk has drained.  Returns false when the
+   * queue is full, like write().
+   */
+  bool writeEOM();
+
+  /**
+   * Owner loop: stop draining while the transaction's egress is paused.
+   * Forward these from RequestHandler::onEgressPaused/onEgressResumed.
+   */
+  void onEgressPaused();
+  void onEgressResumed();
+
+  /**
+   * Owner loop: detach from the downstream handler.  Anything still
+   * queued (and anything written afterwards) is discarded.  Call before
+   * the handler goes away, e.g. from onError().
+   */
+  void cancel();
+
+  /**
+   * @returns true once the EOM has been drained or the channel was
+   *          cancelled.  Owner loop only.
+   */
+  bool finished() const {
+    return finished_;
+  }
+
+ private:
+  struct Chunk {
+    std::unique_ptr<folly::IOBuf> body;
+    bool eom{false};
+  };
+
+  void notifyConsumer();
+  void drain();
+
+  ResponseHandler* downstream_{nullptr};
+  folly::EventBase* evb_{nullptr};
+  folly::ProducerConsumerQueue<Chunk> queue_;
+
+  /**
+   * Set by the producer when a wakeup is in flight or the consumer has
+   * yet to drain; cleared by the consumer before draining, so each
+   * burst of writes costs one cross-thread post.
+   */
+  std::atomic<bool> wakeupScheduled_{false};
+
+  // Owner-loop state
+  bool paused_{false};
+  bool finished_{false};
+
+  /**
+   * Invalidated in the destructor so a wakeup still queued on the
+   * EventBase when the channel is destroyed becomes a no-op.
+   */
+  std::shared_ptr<bool> alive_{std::make_shared<bool>(true)};
+};
+
+} // namespace proxygen
@@ -0,0 +1,48 @@
+/*
+ *  Copyright (c) 2019-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include <proxygen/httpserver/EarlyHints.h>
+
+#include <unordered_map>
+
+#include <folly/String.h>
+#include <folly/Synchronized.h>
+
+namespace proxygen {
+
+std::shared_ptr<const HTTPMessage> EarlyHints::getResponse(
+    const std::vector<std::string>& links) {
+  using Cache =
+      std::unordered_map<std::string, std::shared_ptr<const HTTPMessage>>;
+  static folly::Synchronized<Cache> cache;
+
+  // Link values cannot contain newlines, so the join is unambiguous
+  auto key = folly::join('\n', links);
+  {
+    auto rlock = cache.rlock();
+    auto it = rlock->find(key);
+    if (it != rlock->end()) {
+      return it->second;
+    }
+  }
+
+  auto msg = std::make_shared<HTTPMessage>();
+  msg->setHTTPVersion(1, 1);
+  msg->setStatusCode(103);
+  msg->setStatusMessage("Early Hints");
+  for (const auto& link : links) {
+    msg->getHeaders().add(HTTP_HEADER_LINK, link);
+  }
+
+  auto wlock = cache.wlock();
+  // emplace keeps the winner if another thread built the same template
+  return wlock->emplace(std::move(key), std::move(msg)).first->second;
+}
+
+} // namespace proxygen
@@ -0,0 +1,40 @@
+/*
+ *  Copyright (c) 2019-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <proxygen/lib/http/HTTPMessage.h>
+
+namespace proxygen {
+
+/**
+ * Template cache for 103 Early Hints interim responses.
+ *
+ * A hints response is fully determined by its Link header values, and in
+ * practice a handful of link sets cover almost all pages, so the
+ * HTTPMessage is built once per distinct set and shared immutably
+ * afterwards; the per-request cost is a single lookup.  Sending hints
+ * before the handler computes the real response overlaps the client's
+ * preload fetches with backend time.
+ */
+class EarlyHints {
+ public:
+  /**
+   * Return the shared 103 response carrying one Link header per entry,
+   * building and caching it on first use.  Thread-safe.
+   */
+  static std::shared_ptr<const HTTPMessage> getResponse(
+      const std::vector<std::string>& links);
+};
+
+} // namespace proxygen
@@ -0,0 +1,482 @@
+/*
+ *  Copyright (c) 2015-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#pragma once
+
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include <proxygen/httpserver/RequestHandler.h>
+#include <proxygen/httpserver/RequestHandlerFactory.h>
+#include <proxygen/httpserver/ResponseHandler.h>
+
+namespace proxygen {
+
+/**
+ * Compile-time composed filters.
+ *
+ * A chain of Filter objects costs one heap allocation per filter per request
+ * and a virtual hop per filter on every callback.  FilterStack composes the
+ * filter types at compile time instead: all filter state for a request lives
+ * in one contiguous block, and calls between adjacent filters are plain
+ * member calls the compiler can inline.  Virtual dispatch remains only at
+ * the two ends of the stack - toward the session and toward the terminal
+ * RequestHandler.
+ *
+ * An inline filter derives from InlineFilter and shadows the hooks it cares
+ * about.  Each hook receives a link to the rest of the stack, so a filter
+ * can observe, modify, drop or reorder what flows through it:
+ *
+ *   class StatsFilter : public InlineFilter {
+ *    public:
+ *     template <typename Next>
+ *     void onRequest(Next next,
+ *                    std::unique_ptr<HTTPMessage> headers) noexcept {
+ *       ++requests_;
+ *       next.onRequest(std::move(headers));
+ *     }
+ *
+ *    private:
+ *     uint32_t requests_{0};
+ *   };
+ *
+ * Install one FilterStackFactory in place of the per-filter factories:
+ *
+ *   options.handlerFactories = RequestHandlerChain()
+ *       .addThen<FilterStackFactory<StatsFilter, RewriteFilter>>()
+ *       .addThen<AppHandlerFactory>()
+ *       .build();
+ *
+ * Ingress hooks run outermost (client side) first and egress hooks run
+ * innermost first, mirroring a chain of Filter objects declared in the same
+ * order.  Hooks that Filter only ever forwards unmodified (refreshTimeout,
+ * pauseIngress/resumeIngress, canHandleExpect, push and ex-stream creation,
+ * transport info) bypass the filters and go straight to the respective end
+ * of the stack.
+ */
+class InlineFilter {
+ public:
+  // Ingress hooks; Next is the adjacent layer toward the application
+  template <typename Next>
+  void onRequest(Next next, std::unique_ptr<HTTPMessage> headers) noexcept {
+    next.onRequest(std::move(headers));
+  }
+
+  template <typename Next>
+  void onBody(Next next, std::unique_ptr<folly::IOBuf> body) noexcept {
+    next.onBody(std::move(body));
+  }
+
+  template <typename Next>
+  void onUpgrade(Next next, UpgradeProtocol protocol) noexcept {
+    next.onUpgrade(protocol);
+  }
+
+  template <typename Next>
+  void onEOM(Next next) noexcept {
+    next.onEOM();
+  }
+
+  template <typename Next>
+  void onEgressPaused(Next next) noexcept {
+    next.onEgressPaused();
+  }
+
+  template <typename Next>
+  void onEgressResumed(Next next) noexcept {
+    next.onEgressResumed();
+  }
+
+  template <typename Next>
+  void requestComplete(Next next) noexcept {
+    next.requestComplete();
+  }
+
+  template <typename Next>
+  void onError(Next next, ProxygenError err) noexcept {
+    next.onError(err);
+  }
+
+  // Egress hooks; Prev is the adjacent layer toward the client
+  template <typename Prev>
+  void sendHeaders(Prev prev, HTTPMessage& msg) noexcept {
+    prev.sendHeaders(msg);
+  }
+
+  template <typename Prev>
+  void sendChunkHeader(Prev prev, size_t len) noexcept {
+    prev.sendChunkHeader(len);
+  }
+
+  template <typename Prev>
+  void sendBody(Prev prev, std::unique_ptr<folly::IOBuf> body) noexcept {
+    prev.sendBody(std::move(body));
+  }
+
+  template <typename Prev>
+  void sendChunkTerminator(Prev prev) noexcept {
+    prev.sendChunkTerminator();
+  }
+
+  template <typename Prev>
+  void sendEOM(Prev prev) noexcept {
+    prev.sendEOM();
+  }
+
+  template <typename Prev>
+  void sendAbort(Prev prev) noexcept {
+    prev.sendAbort();
+  }
+};
+
+template <typename... FilterTypes>
+class FilterStack : public RequestHandler, public ResponseHandler {
+  static_assert(sizeof...(FilterTypes) > 0,
+                "FilterStack requires at least one filter");
+  static constexpr size_t kNumFilters = sizeof...(FilterTypes);
+
+ public:
+  explicit FilterStack(RequestHandler* upstream)
+      : ResponseHandler(upstream) {
+  }
+
+  FilterStack(RequestHandler* upstream,
+              const std::tuple<FilterTypes...>& prototypes)
+      : ResponseHandler(upstream), filters_(prototypes) {
+  }
+
+  // Request handler
+  void setResponseHandler(ResponseHandler* handler) noexcept override {
+    // Save downstream handler and pass ourselves as downstream handler
+    downstream_ = handler;
+    txn_ = handler->getTransaction();
+    upstream_->setResponseHandler(this);
+  }
+
+  void onRequest(std::unique_ptr<HTTPMessage> headers) noexcept override {
+    ingressOnRequest(Index<0>(), std::move(headers));
+  }
+
+  void onBody(std::unique_ptr<folly::IOBuf> body) noexcept override {
+    ingressOnBody(Index<0>(), std::move(body));
+  }
+
+  void onUpgrade(UpgradeProtocol protocol) noexcept override {
+    ingressOnUpgrade(Index<0>(), protocol);
+  }
+
+  void onEOM() noexcept override {
+    ingressOnEOM(Index<0>());
+  }
+
+  void onEgressPaused() noexcept override {
+    ingressOnEgressPaused(Index<0>());
+  }
+
+  void onEgressResumed() noexcept override {
+    ingressOnEgressResumed(Index<0>());
+  }
+
+  void requestComplete() noexcept override {
+    downstream_ = nullptr;
+    ingressRequestComplete(Index<0>());
+    delete this;
+  }
+
+  void onError(ProxygenError err) noexcept override {
+    downstream_ = nullptr;
+    ingressOnError(Index<0>(), err);
+    delete this;
+  }
+
+  bool canHandleExpect() noexcept override {
+    return upstream_->canHandleExpect();
+  }
+
+  ExMessageHandler* getExHandler() noexcept override {
+    return upstream_->getExHandler();
+  }
+
+  // Response handler
+  void sendHeaders(HTTPMessage& msg) noexcept override {
+    egressSendHeaders(Index<kNumFilters>(), msg);
+  }
+
+  void sendChunkHeader(size_t len) noexcept override {
+    egressSendChunkHeader(Index<kNumFilters>(), len);
+  }
+
+  void sendBody(std::unique_ptr<folly::IOBuf> body) noexcept override {
+    egressSendBody(Index<kNumFilters>(), std::move(body));
+  }
+
+  void sendChunkTerminator() noexcept override {
+    egressSendChunkTerminator(Index<kNumFilters>());
+  }
+
+  void sendEOM() noexcept override {
+    egressSendEOM(Index<kNumFilters>());
+  }
+
+  void sendAbort() noexcept override {
+    egressSendAbort(Index<kNumFilters>());
+  }
+
+  void refreshTimeout() noexcept override {
+    downstream_->refreshTimeout();
+  }
+
+  void pauseIngress() noexcept override {
+    downstream_->pauseIngress();
+  }
+
+  void resumeIngress() noexcept override {
+    downstream_->resumeIngress();
+  }
+
+  ResponseHandler* newPushedResponse(PushHandler* handler) noexcept override {
+    return downstream_->newPushedResponse(handler);
+  }
+
+  ResponseHandler* newExMessage(
+      ExMessageHandler* exHandler,
+      bool unidirectional) noexcept override {
+    return downstream_->newExMessage(exHandler, unidirectional);
+  }
+
+  const wangle::TransportInfo& getSetupTransportInfo() const noexcept override {
+    return downstream_->getSetupTransportInfo();
+  }
+
+  void getCurrentTransportInfo(wangle::TransportInfo* tinfo) const override {
+    downstream_->getCurrentTransportInfo(tinfo);
+  }
+
+  /**
+   * Access a filter's state, e.g. from tests or from the terminal handler.
+   */
+  template <size_t I>
+  typename std::tuple_element<I, std::tuple<FilterTypes...>>::type&
+  getFilter() {
+    return std::get<I>(filters_);
+  }
+
+ private:
+  template <size_t I>
+  using Index = std::integral_constant<size_t, I>;
+
+  /**
+   * Continuation handed to filter I-1's ingress hooks; delivers to filter I,
+   * or to the terminal RequestHandler once the stack is exhausted.
+   */
+  template <size_t I>
+  struct IngressLink {
+    FilterStack* stack;
+
+    void onRequest(std::unique_ptr<HTTPMessage> headers) noexcept {
+      stack->ingressOnRequest(Index<I>(), std::move(headers));
+    }
+    void onBody(std::unique_ptr<folly::IOBuf> body) noexcept {
+      stack->ingressOnBody(Index<I>(), std::move(body));
+    }
+    void onUpgrade(UpgradeProtocol protocol) noexcept {
+      stack->ingressOnUpgrade(Index<I>(), protocol);
+    }
+    void onEOM() noexcept {
+      stack->ingressOnEOM(Index<I>());
+    }
+    void onEgressPaused() noexcept {
+      stack->ingressOnEgressPaused(Index<I>());
+    }
+    void onEgressResumed() noexcept {
+      stack->ingressOnEgressResumed(Index<I>());
+    }
+    void requestComplete() noexcept {
+      stack->ingressRequestComplete(Index<I>());
+    }
+    void onError(ProxygenError err) noexcept {
+      stack->ingressOnError(Index<I>(), err);
+    }
+  };
+
+  /**
+   * Continuation handed to filter I's egress hooks; delivers to filter I-1,
+   * or to downstream_ once the stack is exhausted.
+   */
+  template <size_t I>
+  struct EgressLink {
+    FilterStack* stack;
+
+    void sendHeaders(HTTPMessage& msg) noexcept {
+      stack->egressSendHeaders(Index<I>(), msg);
+    }
+    void sendChunkHeader(size_t len) noexcept {
+      stack->egressSendChunkHeader(Index<I>(), len);
+    }
+    void sendBody(std::unique_ptr<folly::IOBuf> body) noexcept {
+      stack->egressSendBody(Index<I>(), std::move(body));
+    }
+    void sendChunkTerminator() noexcept {
+      stack->egressSendChunkTerminator(Index<I>());
+    }
+    void sendEOM() noexcept {
+      stack->egressSendEOM(Index<I>());
+    }
+    void sendAbort() noexcept {
+      stack->egressSendAbort(Index<I>());
+    }
+  };
+
+  template <size_t I>
+  void ingressOnRequest(Index<I>, std::unique_ptr<HTTPMessage> headers) {
+    std::get<I>(filters_).onRequest(IngressLink<I + 1>{this},
+                                    std::move(headers));
+  }
+  void ingressOnRequest(Index<kNumFilters>,
+                        std::unique_ptr<HTTPMessage> headers) {
+    upstream_->onRequest(std::move(headers));
+  }
+
+  template <size_t I>
+  void ingressOnBody(Index<I>, std::unique_ptr<folly::IOBuf> body) {
+    std::get<I>(filters_).onBody(IngressLink<I + 1>{this}, std::move(body));
+  }
+  void ingressOnBody(Index<kNumFilters>, std::unique_ptr<folly::IOBuf> body) {
+    upstream_->onBody(std::move(body));
+  }
+
+  template <size_t I>
+  void ingressOnUpgrade(Index<I>, UpgradeProtocol protocol) {
+    std::get<I>(filters_).onUpgrade(IngressLink<I + 1>{this}, protocol);
+  }
+  void ingressOnUpgrade(Index<kNumFilters>, UpgradeProtocol protocol) {
+    upstream_->onUpgrade(protocol);
+  }
+
+  template <size_t I>
+  void ingressOnEOM(Index<I>) {
+    std::get<I>(filters_).onEOM(IngressLink<I + 1>{this});
+  }
+  void ingressOnEOM(Index<kNumFilters>) {
+    upstream_->onEOM();
+  }
+
+  template <size_t I>
+  void ingressOnEgressPaused(Index<I>) {
+    std::get<I>(filters_).onEgressPaused(IngressLink<I + 1>{this});
+  }
+  void ingressOnEgressPaused(Index<kNumFilters>) {
+    upstream_->onEgressPaused();
+  }
+
+  template <size_t I>
+  void ingressOnEgressResumed(Index<I>) {
+    std::get<I>(filters_).onEgressResumed(IngressLink<I + 1>{this});
+  }
+  void ingressOnEgressResumed(Index<kNumFilters>) {
+    upstream_->onEgressResumed();
+  }
+
+  template <size_t I>
+  void ingressRequestComplete(Index<I>) {
+    std::get<I>(filters_).requestComplete(IngressLink<I + 1>{this});
+  }
+  void ingressRequestComplete(Index<kNumFilters>) {
+    upstream_->requestComplete();
+  }
+
+  template <size_t I>
+  void ingressOnError(Index<I>, ProxygenError err) {
+    std::get<I>(filters_).onError(IngressLink<I + 1>{this}, err);
+  }
+  void ingressOnError(Index<kNumFilters>, ProxygenError err) {
+    upstream_->onError(err);
+  }
+
+  template <size_t I>
+  void egressSendHeaders(Index<I>, HTTPMessage& msg) {
+    std::get<I - 1>(filters_).sendHeaders(EgressLink<I - 1>{this}, msg);
+  }
+  void egressSendHeaders(Index<0>, HTTPMessage& msg) {
+    downstream_->sendHeaders(msg);
+  }
+
+  template <size_t I>
+  void egressSendChunkHeader(Index<I>, size_t len) {
+    std::get<I - 1>(filters_).sendChunkHeader(EgressLink<I - 1>{this}, len);
+  }
+  void egressSendChunkHeader(Index<0>, size_t len) {
+    downstream_->sendChunkHeader(len);
+  }
+
+  template <size_t I>
+  void egressSendBody(Index<I>, std::unique_ptr<folly::IOBuf> body) {
+    std::get<I - 1>(filters_).sendBody(EgressLink<I - 1>{this},
+                                       std::move(body));
+  }
+  void egressSendBody(Index<0>, std::unique_ptr<folly::IOBuf> body) {
+    downstream_->sendBody(std::move(body));
+  }
+
+  template <size_t I>
+  void egressSendChunkTerminator(Index<I>) {
+    std::get<I - 1>(filters_).sendChunkTerminator(EgressLink<I - 1>{this});
+  }
+  void egressSendChunkTerminator(Index<0>) {
+    downstream_->sendChunkTerminator();
+  }
+
+  template <size_t I>
+  void egressSendEOM(Index<I>) {
+    std::get<I - 1>(filters_).sendEOM(EgressLink<I - 1>{this});
+  }
+  void egressSendEOM(Index<0>) {
+    downstream_->sendEOM();
+  }
+
+  template <size_t I>
+  void egressSendAbort(Index<I>) {
+    std::get<I - 1>(filters_).sendAbort(EgressLink<I - 1>{this});
+  }
+  void egressSendAbort(Index<0>) {
+    downstream_->sendAbort();
+  }
+
+  std::tuple<FilterTypes...> filters_;
+};
+
+/**
+ * Factory that instantiates one FilterStack per request.  Filter state for
+ * each request starts as a copy of the prototype filters given to the
+ * factory, so per-server configuration lives in the prototypes.
+ */
+template <typename... FilterTypes>
+class FilterStackFactory : public RequestHandlerFactory {
+ public:
+  explicit FilterStackFactory(FilterTypes... prototypes)
+      : prototypes_(std::move(prototypes)...) {
+  }
+
+  void onServerStart(folly::EventBase*) noexcept override {
+  }
+
+  void onServerStop() noexcept override {
+  }
+
+  RequestHandler* onRequest(RequestHandler* handler,
+                            HTTPMessage*) noexcept override {
+    return new FilterStack<FilterTypes...>(handler, prototypes_);
+  }
+
+ private:
+  std::tuple<FilterTypes...> prototypes_;
+};
+
+}
@@ -84,11 +84,24 @@ class Filter : public RequestHandler, public ResponseHandler {
     return upstream_->getExHandler();
   }
 
+  std::shared_ptr<const HTTPMessage> getEarlyHints(
+      const HTTPMessage& request) noexcept override {
+    return upstream_->getEarlyHints(request);
+  }
+
   // Response handler
   void sendHeaders(HTTPMessage& msg) noexcept override {
     downstream_->sendHeaders(msg);
   }
 
+  void sendEarlyHints(const HTTPMessage& msg) noexcept override {
+    downstream_->sendEarlyHints(msg);
+  }
+
+  void setEgressBodySizeHint(uint64_t bytes) noexcept override {
+    downstream_->setEgressBodySizeHint(bytes);
+  }
+
   void sendChunkHeader(size_t len) noexcept override {
     downstream_->sendChunkHeader(len);
   }
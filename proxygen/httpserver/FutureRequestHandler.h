@@ -0,0 +1,117 @@
+/*
+ *  Copyright (c) 2015-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#pragma once
+
+#include <folly/futures/Future.h>
+#include <folly/io/IOBufQueue.h>
+#include <folly/io/async/EventBaseManager.h>
+#include <proxygen/httpserver/RequestHandler.h>
+#include <proxygen/httpserver/ResponseBuilder.h>
+
+namespace proxygen {
+
+/**
+ * A RequestHandler variant for handlers whose work awaits something
+ * upstream (another service, a thread pool, a cache fill) before a
+ * response can be produced.
+ *
+ * The base class buffers the request body and hands the complete message
+ * to onFullRequest(), which returns a Future for the response. The future
+ * may complete on any thread; the response is sent back on the request's
+ * EventBase, and an exceptional future becomes a plain 500. This replaces
+ * the per-request chain of callback state objects that handlers otherwise
+ * hand-roll to bridge onEOM() and their upstream completion.
+ *
+ * Because the transaction can die while the future is outstanding (client
+ * disconnect, timeout), the completion callback holds a shared liveness
+ * flag that the destructor clears; a late response is then dropped on the
+ * floor rather than touching a dead downstream_.
+ *
+ * Not suitable for streaming requests or responses -- the body is fully
+ * buffered in both directions. Use the callback interface for those.
+ */
+class FutureRequestHandler : public RequestHandler {
+ public:
+  struct FullRequest {
+    std::unique_ptr<HTTPMessage> headers;
+    std::unique_ptr<folly::IOBuf> body; // may be null for bodyless requests
+  };
+
+  struct Response {
+    uint16_t status{200};
+    std::string statusMessage{"OK"};
+    HTTPHeaders headers;
+    std::unique_ptr<folly::IOBuf> body;
+  };
+
+  /**
+   * Invoked once the request has been fully received. May complete its
+   * future from any thread.
+   */
+  virtual folly::Future<Response> onFullRequest(
+      FullRequest request) noexcept = 0;
+
+  void onRequest(std::unique_ptr<HTTPMessage> headers) noexcept override {
+    requestHeaders_ = std::move(headers);
+  }
+
+  void onBody(std::unique_ptr<folly::IOBuf> body) noexcept override {
+    bodyQueue_.append(std::move(body));
+  }
+
+  void onUpgrade(UpgradeProtocol /*prot*/) noexcept override {
+  }
+
+  void onEOM() noexcept override {
+    FullRequest request{std::move(requestHeaders_), bodyQueue_.move()};
+    auto evb = folly::EventBaseManager::get()->getEventBase();
+    auto alive = alive_;
+    onFullRequest(std::move(request))
+        .via(evb)
+        .thenTry([this, alive](folly::Try<Response> result) {
+          if (!*alive) {
+            return; // transaction completed underneath the future
+          }
+          if (result.hasException()) {
+            ResponseBuilder(downstream_)
+                .status(500, "Internal Server Error")
+                .sendWithEOM();
+            return;
+          }
+          auto& response = result.value();
+          ResponseBuilder builder(downstream_);
+          builder.status(response.status, response.statusMessage);
+          response.headers.forEach(
+              [&](const std::string& name, const std::string& value) {
+                builder.header(name, value);
+              });
+          builder.body(std::move(response.body)).sendWithEOM();
+        });
+  }
+
+  void requestComplete() noexcept override {
+    delete this;
+  }
+
+  void onError(ProxygenError /*err*/) noexcept override {
+    delete this;
+  }
+
+  ~FutureRequestHandler() override {
+    *alive_ = false;
+  }
+
+ private:
+  std::unique_ptr<HTTPMessage> requestHeaders_;
+  folly::IOBufQueue bodyQueue_{folly::IOBufQueue::cacheChainLength()};
+  const std::shared_ptr<bool> alive_{std::make_shared<bool>(true)};
+};
+
+} // namespace proxygen
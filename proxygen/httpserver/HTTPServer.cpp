@@ -10,11 +10,22 @@
 
 #include <proxygen/httpserver/HTTPServer.h>
 
+#include <pthread.h>
+#include <array>
+#include <map>
+#include <mutex>
+#include <thread>
+
+#include <folly/FileUtil.h>
+#include <folly/Random.h>
+#include <folly/String.h>
+#include <folly/synchronization/Baton.h>
 #include <folly/executors/thread_factory/NamedThreadFactory.h>
 #include <folly/system/ThreadName.h>
 #include <folly/io/async/EventBaseManager.h>
 #include <proxygen/httpserver/HTTPServerAcceptor.h>
 #include <proxygen/httpserver/SignalHandler.h>
+#include <proxygen/httpserver/SocketHandoff.h>
 #include <proxygen/httpserver/filters/RejectConnectFilter.h>
 #include <proxygen/httpserver/filters/CompressionFilter.h>
 #include <wangle/ssl/SSLContextManager.h>
@@ -37,6 +48,77 @@ class AcceptorFactory : public wangle::AcceptorFactory {
       sessionInfoCb_(sessionInfoCb) {}
   std::shared_ptr<wangle::Acceptor> newAcceptor(
       folly::EventBase* eventBase) override {
+    {
+      std::lock_guard<std::mutex> guard(prewarmMutex_);
+      auto it = prewarmed_.find(eventBase);
+      if (it != prewarmed_.end()) {
+        auto acc = std::move(it->second);
+        prewarmed_.erase(it);
+        return acc;
+      }
+    }
+    return makeAcceptor(eventBase);
+  }
+
+  /**
+   * Constructs this factory's acceptor on every worker of the given
+   * executors ahead of bind(), so per-worker TLS context setup (cert and
+   * key parsing in particular) runs in parallel across workers instead of
+   * serializing as each listener binds.  newAcceptor() then hands the
+   * prewarmed acceptor out to the bootstrap.  Blocks until every worker
+   * finishes; the first construction error is rethrown on the calling
+   * thread so strictSSL failures surface exactly as they would from
+   * bind().
+   */
+  void prewarm(const std::vector<folly::IOThreadPoolExecutor*>& execs,
+               size_t threadsPerExec) {
+    size_t total = execs.size() * threadsPerExec;
+    if (total == 0) {
+      return;
+    }
+    std::atomic<size_t> remaining{total};
+    folly::Baton<> done;
+    std::mutex errorMutex;
+    std::exception_ptr error;
+    for (auto* exec : execs) {
+      for (size_t i = 0; i < threadsPerExec; i++) {
+        exec->add([&] {
+          auto evb = folly::EventBaseManager::get()->getExistingEventBase();
+          try {
+            std::shared_ptr<wangle::Acceptor> acc;
+            {
+              std::lock_guard<std::mutex> guard(prewarmMutex_);
+              if (prewarmed_.count(evb) == 0) {
+                acc = nullptr;
+              } else {
+                acc = prewarmed_[evb];
+              }
+            }
+            if (!acc) {
+              acc = makeAcceptor(evb);
+              std::lock_guard<std::mutex> guard(prewarmMutex_);
+              prewarmed_.emplace(evb, std::move(acc));
+            }
+          } catch (...) {
+            std::lock_guard<std::mutex> guard(errorMutex);
+            if (!error) {
+              error = std::current_exception();
+            }
+          }
+          if (remaining.fetch_sub(1) == 1) {
+            done.post();
+          }
+        });
+      }
+    }
+    done.wait();
+    if (error) {
+      std::rethrow_exception(error);
+    }
+  }
+
+ private:
+  std::shared_ptr<wangle::Acceptor> makeAcceptor(folly::EventBase* eventBase) {
     auto acc = std::shared_ptr<HTTPServerAcceptor>(
       HTTPServerAcceptor::make(config_, *options_, codecFactory_).release());
     if (sessionInfoCb_) {
@@ -46,11 +128,15 @@ class AcceptorFactory : public wangle::AcceptorFactory {
     return acc;
   }
 
- private:
   std::shared_ptr<HTTPServerOptions> options_;
   std::shared_ptr<HTTPCodecFactory> codecFactory_;
   AcceptorConfiguration config_;
   HTTPSession::InfoCallback* sessionInfoCb_;
+
+  // Acceptors built ahead of bind() by prewarm(), keyed by the worker
+  // event base they were initialized on
+  std::mutex prewarmMutex_;
+  std::map<folly::EventBase*, std::shared_ptr<wangle::Acceptor>> prewarmed_;
 };
 
 HTTPServer::HTTPServer(HTTPServerOptions options):
@@ -113,27 +199,186 @@ class HandlerCallbacks : public ThreadPoolExecutor::Observer {
   std::shared_ptr<HTTPServerOptions> options_;
 };
 
+class CpuPinningCallbacks : public ThreadPoolExecutor::Observer {
+ public:
+  explicit CpuPinningCallbacks(std::vector<size_t> cpus)
+      : cpus_(std::move(cpus)) {}
+
+  void threadStarted(ThreadPoolExecutor::ThreadHandle* h) override {
+    auto evb = IOThreadPoolExecutor::getEventBase(h);
+    CHECK(evb) << "Invariant violated - started thread must have an EventBase";
+    evb->runInEventBaseThread([cpus = cpus_] {
+#ifdef __linux__
+      auto numCpus = std::thread::hardware_concurrency();
+      if (numCpus == 0 || cpus.empty()) {
+        return;
+      }
+      cpu_set_t cpuSet;
+      CPU_ZERO(&cpuSet);
+      for (auto cpu : cpus) {
+        CPU_SET(cpu % numCpus, &cpuSet);
+      }
+      auto rc =
+          pthread_setaffinity_np(pthread_self(), sizeof(cpuSet), &cpuSet);
+      if (rc != 0) {
+        LOG(WARNING) << "failed to pin worker to cpus ["
+                     << folly::join(',', cpus) << "]: " << folly::errnoStr(rc);
+      }
+#else
+      (void)cpus;
+#endif
+    });
+  }
+
+  void threadStopped(ThreadPoolExecutor::ThreadHandle* /*h*/) override {
+  }
+
+ private:
+  const std::vector<size_t> cpus_;
+};
+
+/**
+ * Reads the CPUs belonging to each NUMA node from sysfs.  Returns an
+ * empty vector when the topology is unavailable (non-Linux, sysfs not
+ * mounted) so callers can fall back to node-oblivious placement.
+ */
+std::vector<std::vector<size_t>> readNumaNodeCpus() {
+  std::vector<std::vector<size_t>> nodes;
+  for (size_t node = 0;; node++) {
+    std::string cpulist;
+    auto path = folly::to<std::string>(
+        "/sys/devices/system/node/node", node, "/cpulist");
+    if (!folly::readFile(path.c_str(), cpulist)) {
+      break;
+    }
+    std::vector<size_t> cpus;
+    std::vector<folly::StringPiece> ranges;
+    folly::split(',', folly::trimWhitespace(cpulist), ranges, true);
+    for (auto range : ranges) {
+      // Entries are either a single CPU ("7") or a range ("0-15")
+      auto dash = range.find('-');
+      auto lo = folly::tryTo<size_t>(range.subpiece(0, dash));
+      auto hi = (dash == folly::StringPiece::npos)
+                    ? lo
+                    : folly::tryTo<size_t>(range.subpiece(dash + 1));
+      if (!lo.hasValue() || !hi.hasValue() || *hi < *lo) {
+        LOG(WARNING) << "unparseable cpulist for node " << node << ": "
+                     << cpulist;
+        return {};
+      }
+      for (size_t cpu = *lo; cpu <= *hi; cpu++) {
+        cpus.push_back(cpu);
+      }
+    }
+    nodes.push_back(std::move(cpus));
+  }
+  return nodes;
+}
+
 
 void HTTPServer::start(std::function<void()> onSuccess,
                        std::function<void(std::exception_ptr)> onError) {
   mainEventBase_ = EventBaseManager::get()->getEventBase();
 
-  auto accExe = std::make_shared<IOThreadPoolExecutor>(1);
-  auto exe = std::make_shared<IOThreadPoolExecutor>(options_->threads,
-    std::make_shared<folly::NamedThreadFactory>("HTTPSrvExec"));
   auto exeObserver = std::make_shared<HandlerCallbacks>(options_);
-  // Observer has to be set before bind(), so onServerStart() callbacks run
-  exe->addObserver(exeObserver);
+  std::shared_ptr<IOThreadPoolExecutor> accExe;
+  std::shared_ptr<IOThreadPoolExecutor> exe;
+  std::vector<std::shared_ptr<IOThreadPoolExecutor>> workerExes;
+  if (options_->useReusePortSharding) {
+    CHECK(options_->preboundSockets_.empty())
+        << "SO_REUSEPORT sharding requires binding by address";
+    // With NUMA placement requested, workers round-robin across the
+    // nodes; on single-node hosts the topology degenerates and we fall
+    // back to one-core-per-worker pinning below.
+    std::vector<std::vector<size_t>> numaNodes;
+    if (options_->numaPinShardedWorkers) {
+      numaNodes = readNumaNodeCpus();
+      if (numaNodes.size() < 2) {
+        VLOG(1) << "NUMA worker placement requested but host has "
+                << numaNodes.size() << " node(s); using per-core pinning";
+        numaNodes.clear();
+      }
+    }
+    for (size_t j = 0; j < options_->threads; j++) {
+      auto workerExe = std::make_shared<IOThreadPoolExecutor>(
+          1,
+          std::make_shared<folly::NamedThreadFactory>(
+              "HTTPSrvExec" + std::to_string(j) + "-"));
+      // Observers have to be set before bind(), so onServerStart() runs
+      workerExe->addObserver(exeObserver);
+      if (!numaNodes.empty()) {
+        workerExe->addObserver(std::make_shared<CpuPinningCallbacks>(
+            numaNodes[j % numaNodes.size()]));
+      } else if (options_->pinShardedWorkers ||
+                 options_->numaPinShardedWorkers) {
+        workerExe->addObserver(
+            std::make_shared<CpuPinningCallbacks>(std::vector<size_t>{j}));
+      }
+      workerExes.push_back(std::move(workerExe));
+    }
+  } else {
+    accExe = std::make_shared<IOThreadPoolExecutor>(1);
+    exe = std::make_shared<IOThreadPoolExecutor>(options_->threads,
+      std::make_shared<folly::NamedThreadFactory>("HTTPSrvExec"));
+    // Observer has to be set before bind(), so onServerStart() callbacks run
+    exe->addObserver(exeObserver);
+  }
+
+  // Session tickets minted by one worker must decrypt on every other
+  // worker (and, with SO_REUSEPORT sharding, on whichever listener the
+  // kernel picks), so all acceptors have to agree on ticket seeds.  When
+  // the config does not pin seeds, generate a process-wide set once
+  // instead of letting each acceptor fall back to its own random keys.
+  wangle::TLSTicketKeySeeds generatedSeeds;
 
   try {
     FOR_EACH_RANGE (i, 0, addresses_.size()) {
       auto codecFactory = addresses_[i].codecFactory;
       auto accConfig = HTTPServerAcceptor::makeConfig(addresses_[i], *options_);
+      if (!addresses_[i].sslConfigs.empty() &&
+          accConfig.initialTicketSeeds.currentSeeds.empty()) {
+        if (generatedSeeds.currentSeeds.empty()) {
+          std::array<unsigned char, 32> seed;
+          folly::Random::secureRandom(seed.data(), seed.size());
+          generatedSeeds.currentSeeds.push_back(
+              folly::hexlify(folly::ByteRange(seed.data(), seed.size())));
+        }
+        accConfig.initialTicketSeeds = generatedSeeds;
+      }
       auto factory = std::make_shared<AcceptorFactory>(
           options_,
           codecFactory,
           accConfig,
           sessionInfoCb_);
+      // Build every worker's acceptor (and with it the TLS contexts) in
+      // parallel up front; with many certs configured the per-worker
+      // context setup otherwise serializes across the binds below.
+      if (options_->useReusePortSharding) {
+        std::vector<folly::IOThreadPoolExecutor*> execs;
+        for (auto& workerExe : workerExes) {
+          execs.push_back(workerExe.get());
+        }
+        factory->prewarm(execs, 1);
+        // One listener per worker, all bound to the same address with
+        // SO_REUSEPORT; the kernel shards incoming connections between
+        // them and each worker accepts on its own event loop.
+        for (auto& workerExe : workerExes) {
+          bootstrap_.push_back(
+              wangle::ServerBootstrap<wangle::DefaultPipeline>());
+          auto& bootstrap = bootstrap_.back();
+          bootstrap.childHandler(factory);
+          bootstrap.setReusePort(true);
+          if (accConfig.enableTCPFastOpen) {
+            bootstrap.socketConfig.enableTCPFastOpen = true;
+            bootstrap.socketConfig.fastOpenQueueSize =
+                accConfig.fastOpenQueueSize;
+          }
+          bootstrap.group(workerExe, workerExe);
+          bootstrap.bind(addresses_[i].address);
+        }
+        continue;
+      }
+      factory->prewarm({exe.get()}, options_->threads);
       bootstrap_.push_back(
           wangle::ServerBootstrap<wangle::DefaultPipeline>());
       bootstrap_[i].childHandler(factory);
@@ -240,6 +485,39 @@ int HTTPServer::getListenSocket() const {
 }
 
 
+std::vector<int> HTTPServer::getListenFds() const {
+  std::vector<int> fds;
+  for (const auto& bootstrap : bootstrap_) {
+    for (const auto& socket : bootstrap.getSockets()) {
+      auto serverSocket =
+          std::dynamic_pointer_cast<folly::AsyncServerSocket>(socket);
+      if (!serverSocket) {
+        continue;
+      }
+      for (auto networkSocket : serverSocket->getNetworkSockets()) {
+        fds.push_back(networkSocket.toFd());
+      }
+    }
+  }
+  return fds;
+}
+
+bool HTTPServer::handoffSockets(const std::string& path,
+                                std::chrono::milliseconds timeout) {
+  auto fds = getListenFds();
+  if (fds.empty()) {
+    LOG(ERROR) << "No listener fds to hand off; is the server started?";
+    return false;
+  }
+  if (!SocketHandoff::serveFds(path, fds, timeout)) {
+    return false;
+  }
+  // The successor holds (and accepts on) the same sockets now; stop
+  // accepting here so new connections all land in the new process
+  stopListening();
+  return true;
+}
+
 void HTTPServer::updateTLSCredentials() {
   for (auto& bootstrap : bootstrap_) {
     bootstrap.forEachWorker([&](wangle::Acceptor* acceptor) {
@@ -257,6 +535,34 @@ void HTTPServer::updateTLSCredentials() {
   }
 }
 
+void HTTPServer::updateServerOptions(const HTTPServerOptions& options) {
+  for (size_t i = 0; i < bootstrap_.size(); i++) {
+    // With SO_REUSEPORT sharding there is one bootstrap per worker per
+    // address; otherwise the two line up one to one
+    size_t addrIdx =
+        options_->useReusePortSharding ? i / options_->threads : i;
+    if (addrIdx >= addresses_.size()) {
+      break;
+    }
+    auto config =
+        HTTPServerAcceptor::makeConfig(addresses_[addrIdx], options);
+    bootstrap_[i].forEachWorker([&](wangle::Acceptor* acceptor) {
+      auto httpAcceptor = dynamic_cast<HTTPAcceptor*>(acceptor);
+      if (!httpAcceptor) {
+        return;
+      }
+      auto evb = acceptor->getEventBase();
+      if (!evb) {
+        return;
+      }
+      // Each worker swaps its own copy at a loop boundary
+      evb->runInEventBaseThread([httpAcceptor, config] {
+        httpAcceptor->updateConfig(config);
+      });
+    });
+  }
+}
+
 void HTTPServer::updateTicketSeeds(wangle::TLSTicketKeySeeds seeds) {
   for (auto& bootstrap : bootstrap_) {
     bootstrap.forEachWorker([&](wangle::Acceptor* acceptor) {
@@ -154,6 +154,31 @@ class HTTPServer final {
    */
   int getListenSocket() const;
 
+  /**
+   * Returns the file descriptors of every listening socket, in bind()
+   * address order.  Empty before start().
+   */
+  std::vector<int> getListenFds() const;
+
+  /**
+   * Old-process side of a zero-downtime deploy: serve this server's
+   * listener fds at the given unix socket path (see SocketHandoff) and,
+   * once the successor process has received and acked them, stop
+   * accepting new connections here.  The kernel keeps delivering new
+   * connections to the successor's accepts on the same sockets, so the
+   * listen queue never closes.  Established connections are unaffected;
+   * call stop() afterwards to drain them as usual.
+   *
+   * The successor passes the received fds to
+   * HTTPServerOptions::useExistingSockets before start().
+   *
+   * Blocks up to timeout waiting for the successor; returns false (and
+   * keeps accepting) if no successor shows up or the transfer fails.
+   * May only be called after start() has called onSuccess.
+   */
+  bool handoffSockets(const std::string& path,
+                      std::chrono::milliseconds timeout);
+
   /**
    * Re-reads the certificate / key pair for all SSL vips on all acceptors
    */
@@ -164,6 +189,21 @@ class HTTPServer final {
    */
   void updateTicketSeeds(wangle::TLSTicketKeySeeds seeds);
 
+  /**
+   * Apply updated timeout and session settings to a running server
+   * without disturbing established connections.  For each listener a new
+   * AcceptorConfiguration is rebuilt from the given options and swapped
+   * in on the acceptor's own event loop, so new connections pick it up
+   * at a loop boundary with no locking on the request path.  Established
+   * connections keep the settings they were accepted with and drain
+   * naturally.
+   *
+   * Listener-level settings (addresses, TLS contexts, thread count) and
+   * the handler factory chain are fixed at bind() and are not updated
+   * here.
+   */
+  void updateServerOptions(const HTTPServerOptions& options);
+
  private:
   std::shared_ptr<HTTPServerOptions> options_;
 
@@ -33,6 +33,10 @@ AcceptorConfiguration HTTPServerAcceptor::makeConfig(
   conf.receiveSessionWindowSize = opts.receiveSessionWindowSize;
   conf.acceptBacklog = opts.listenBacklog;
   conf.maxConcurrentIncomingStreams = opts.maxConcurrentIncomingStreams;
+  conf.enableDynamicTLSRecordSizing = opts.enableDynamicTLSRecordSizing;
+  conf.enableKTLSOffload = opts.enableKTLS;
+  conf.egressPacingBytesPerSec = opts.egressPacingBytesPerSec;
+  conf.egressPacingBurstBytes = opts.egressPacingBurstBytes;
 
   if (opts.enableExHeaders) {
     conf.egressSettings.push_back(
@@ -49,6 +49,35 @@ class HTTPServerOptions {
    */
   size_t threads = 1;
 
+  /**
+   * If true, each worker thread binds its own SO_REUSEPORT listener and
+   * accepts connections directly on its event loop, instead of a single
+   * accept thread round-robining accepted file descriptors to the workers.
+   * The kernel spreads incoming connections across the listeners, which
+   * removes the cross-thread handoff and accept contention during
+   * connection storms. Not compatible with prebound sockets.
+   */
+  bool useReusePortSharding = false;
+
+  /**
+   * With sharded accept, additionally pin worker i to CPU i (modulo the
+   * number of CPUs) so each listener stays on its own core. Only
+   * effective on Linux; a no-op elsewhere.
+   */
+  bool pinShardedWorkers = false;
+
+  /**
+   * With sharded accept, pin worker i to every CPU of NUMA node
+   * (i modulo the node count) instead of a single core.  Workers spread
+   * round-robin across the sockets and, under the kernel's default
+   * local-allocation policy, each worker's session and buffer memory is
+   * first-touched on its own node, so sessions never pay cross-socket
+   * latencies.  Reads the topology from sysfs; falls back to
+   * pinShardedWorkers behavior on single-node hosts and is a no-op on
+   * non-Linux platforms.
+   */
+  bool numaPinShardedWorkers = false;
+
   /**
    * Chain of RequestHandlerFactory that are used to create RequestHandler
    * which handles requests.
@@ -113,6 +142,39 @@ class HTTPServerOptions {
    */
   uint32_t maxConcurrentIncomingStreams{100};
 
+  /**
+   * Set to true to chunk egress on TLS connections so records start small
+   * (fast first paint for a fresh client) and grow toward 16KB as the
+   * connection proves bulk behavior.  Has no effect on plaintext
+   * connections.
+   */
+  bool enableDynamicTLSRecordSizing{false};
+
+  /**
+   * Set to true to move record crypto for eligible TLS connections
+   * (TLS 1.2 AES-128-GCM) into the kernel after the handshake, freeing
+   * the userspace encrypt path on static-heavy tiers.  Connections with
+   * other ciphers, and hosts without the kernel tls module, fall back
+   * to the userspace stack transparently.
+   */
+  bool enableKTLS{false};
+
+  /**
+   * Per-session egress pacing rate in bytes per second; 0 (the default)
+   * disables pacing.  Instead of flushing at line rate - bursts that can
+   * overrun shallow-buffered top-of-rack switches - each session meters
+   * its writes through a token bucket and releases held-back bytes off
+   * the event base's shared timer wheel.
+   */
+  uint64_t egressPacingBytesPerSec{0};
+
+  /**
+   * Token bucket depth for egress pacing, i.e. the largest burst a paced
+   * session may put on the wire at once.  0 picks one write's worth.
+   * Only meaningful with egressPacingBytesPerSec set.
+   */
+  uint64_t egressPacingBurstBytes{0};
+
   /**
    * Set to true to enable gzip content compression. Currently false for
    * backwards compatibility.
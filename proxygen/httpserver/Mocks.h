@@ -29,6 +29,7 @@ class MockResponseHandler : public ResponseHandler {
 # endif
 #endif
   GMOCK_METHOD1_(, noexcept, , sendHeaders, void(HTTPMessage&));
+  GMOCK_METHOD1_(, noexcept, , sendEarlyHints, void(const HTTPMessage&));
   GMOCK_METHOD1_(, noexcept, , sendChunkHeader, void(size_t));
   GMOCK_METHOD1_(, noexcept, , sendBody, void(std::shared_ptr<folly::IOBuf>));
   GMOCK_METHOD0_(, noexcept, , sendChunkTerminator, void());
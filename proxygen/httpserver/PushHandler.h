@@ -14,6 +14,12 @@
 
 namespace proxygen {
 
+/**
+ * Minimal handler for the egress side of a pushed transaction.  When
+ * fanning the same resource out to many sessions, build the promise
+ * message once and share it via HTTPMessage::makeImmutableShared()
+ * instead of copying it per pushed stream.
+ */
 class PushHandler : public RequestHandler {
  public:
   PushHandler()
@@ -43,6 +43,11 @@ class RequestHandler {
 
   /**
    * Invoked when we get part of body for the request.
+   *
+   * Handlers that scan the body (content filters and the like) should
+   * walk the chain with IOBufScanner rather than coalesce() it; the
+   * scanner finds bytes and patterns across buffer boundaries without
+   * flattening the chain.
    */
   virtual void onBody(std::unique_ptr<folly::IOBuf> body) noexcept = 0;
 
@@ -95,6 +100,18 @@ class RequestHandler {
     return false;
   }
 
+  /**
+   * Return a 103 Early Hints template to emit for this request, or
+   * nullptr for none.  Called as soon as the request headers arrive,
+   * before onRequest(), so the hints go out while the handler is still
+   * computing; implementations should only do a cheap lookup here (see
+   * EarlyHints::getResponse).
+   */
+  virtual std::shared_ptr<const HTTPMessage> getEarlyHints(
+      const HTTPMessage& /*request*/) noexcept {
+    return nullptr;
+  }
+
   /**
    * Implement in control stream handler to support incoming child EX streams.
    */
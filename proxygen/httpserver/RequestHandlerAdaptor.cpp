@@ -60,6 +60,14 @@ void RequestHandlerAdaptor::onHeadersComplete(std::unique_ptr<HTTPMessage> msg)
 
   // Only in case of no error
   if (err_ == kErrorNone) {
+    // Emit 103 hints before the handler starts computing, so the client's
+    // preload fetches overlap with our response time.  Interim responses
+    // predate HTTP/1.1 clients, so don't confuse a 1.0 client with one.
+    if (msg->getHTTPVersion() >= HTTPMessage::kHTTPVersion11) {
+      if (auto hints = upstream_->getEarlyHints(*msg)) {
+        sendEarlyHints(*hints);
+      }
+    }
     upstream_->onRequest(std::move(msg));
   }
 }
@@ -142,6 +150,17 @@ void RequestHandlerAdaptor::sendHeaders(HTTPMessage& msg) noexcept {
   txn_->sendHeaders(msg);
 }
 
+void RequestHandlerAdaptor::sendEarlyHints(const HTTPMessage& msg) noexcept {
+  DCHECK(msg.is1xxResponse());
+  if (txn_->canSendHeaders()) {
+    txn_->sendHeaders(msg);
+  }
+}
+
+void RequestHandlerAdaptor::setEgressBodySizeHint(uint64_t bytes) noexcept {
+  txn_->setEgressBodySizeHint(bytes);
+}
+
 void RequestHandlerAdaptor::sendChunkHeader(size_t len) noexcept {
   txn_->sendChunkHeader(len);
 }
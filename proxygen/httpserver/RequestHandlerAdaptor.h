@@ -56,6 +56,8 @@ class RequestHandlerAdaptor
 
   // ResponseHandler
   void sendHeaders(HTTPMessage& msg) noexcept override;
+  void sendEarlyHints(const HTTPMessage& msg) noexcept override;
+  void setEgressBodySizeHint(uint64_t bytes) noexcept override;
   void sendChunkHeader(size_t len) noexcept override;
   void sendBody(std::unique_ptr<folly::IOBuf> body) noexcept override;
   void sendChunkTerminator() noexcept override;
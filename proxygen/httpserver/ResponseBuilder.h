@@ -9,7 +9,9 @@
  */
 #pragma once
 
+#include <folly/Optional.h>
 #include <folly/ScopeGuard.h>
+#include <proxygen/httpserver/EarlyHints.h>
 #include <proxygen/httpserver/ResponseHandler.h>
 
 namespace proxygen {
@@ -122,6 +124,17 @@ class ResponseBuilder {
         folly::to<std::string>(std::forward<T>(t))));
   }
 
+  /**
+   * Declare the total body size up front, for responses built up over
+   * several send() calls where no Content-Length gets set.  The hint is
+   * advisory and flows to the filters and the transaction before the
+   * headers go out.
+   */
+  ResponseBuilder& bodySizeHint(uint64_t bytes) {
+    bodySizeHint_ = bytes;
+    return *this;
+  }
+
   ResponseBuilder& closeConnection() {
     return header(HTTP_HEADER_CONNECTION, "close");
   }
@@ -131,6 +144,16 @@ class ResponseBuilder {
     return *this;
   }
 
+  /**
+   * Emit a 103 Early Hints interim response with one Link header per
+   * entry, drawn from the shared template cache so the hot path is a
+   * lookup and a send.  Call before status()/send(); the real response
+   * follows through the builder as usual.
+   */
+  void sendEarlyHints(const std::vector<std::string>& links) {
+    txn_->sendEarlyHints(*EarlyHints::getResponse(links));
+  }
+
   void sendWithEOM() {
     sendEOM_ = true;
     send();
@@ -161,6 +184,10 @@ class ResponseBuilder {
         }
       }
 
+      if (bodySizeHint_) {
+        txn_->setEgressBodySizeHint(*bodySizeHint_);
+        bodySizeHint_ = folly::none;
+      }
       txn_->sendHeaders(*headers_);
     }
 
@@ -223,6 +250,7 @@ class ResponseBuilder {
   std::unique_ptr<HTTPMessage> headers_;
   std::unique_ptr<folly::IOBuf> body_;
   std::unique_ptr<HTTPHeaders> trailers_;
+  folly::Optional<uint64_t> bodySizeHint_;
 
   // If true, sends EOM.
   bool sendEOM_{false};
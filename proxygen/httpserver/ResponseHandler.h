@@ -58,6 +58,27 @@ class ResponseHandler {
    */
   virtual void sendHeaders(HTTPMessage& msg) noexcept = 0;
 
+  /**
+   * Advisory: declare how many body bytes the response will carry, when the
+   * handler knows the size before sendHeaders().  Filters consult it where
+   * Content-Length is unavailable - e.g. the compression decision on a
+   * chunked response - and it lands on the transaction for the session's
+   * buffering decisions.  The default ignores the hint, so declaring a
+   * size is always safe; nothing enforces that the body matches it.
+   */
+  virtual void setEgressBodySizeHint(uint64_t /*bytes*/) noexcept {
+  }
+
+  /**
+   * Send an interim 1xx response ahead of the real one, typically a
+   * 103 Early Hints carrying Link headers (see EarlyHints for the shared
+   * template cache).  Must be called before sendHeaders(); the final
+   * response still follows as usual.  The default drops the hints, which
+   * is always a correct (if slower) outcome.
+   */
+  virtual void sendEarlyHints(const HTTPMessage& /*msg*/) noexcept {
+  }
+
   virtual void sendChunkHeader(size_t len) noexcept = 0;
 
   virtual void sendBody(std::unique_ptr<folly::IOBuf> body) noexcept = 0;
@@ -0,0 +1,121 @@
+/*
+ *  Copyright (c) 2019-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include <proxygen/httpserver/ResponseTemplate.h>
+
+#include <folly/Conv.h>
+#include <folly/io/IOBufQueue.h>
+
+namespace proxygen {
+
+ResponseTemplate::ResponseTemplate(uint16_t statusCode,
+                                   const std::string& statusMessage,
+                                   folly::StringPiece bodyTemplate) {
+  prototype_.setHTTPVersion(1, 1);
+  prototype_.setStatusCode(statusCode);
+  prototype_.setStatusMessage(statusMessage);
+  compile(bodyTemplate);
+}
+
+ResponseTemplate& ResponseTemplate::header(HTTPHeaderCode code,
+                                           const std::string& value) {
+  prototype_.getHeaders().add(code, value);
+  return *this;
+}
+
+ResponseTemplate& ResponseTemplate::header(const std::string& name,
+                                           const std::string& value) {
+  prototype_.getHeaders().add(name, value);
+  return *this;
+}
+
+void ResponseTemplate::compile(folly::StringPiece bodyTemplate) {
+  folly::StringPiece rest = bodyTemplate;
+  while (true) {
+    auto open = rest.find("{{");
+    if (open == folly::StringPiece::npos) {
+      break;
+    }
+    auto close = rest.find("}}", open + 2);
+    CHECK_NE(close, folly::StringPiece::npos)
+        << "Unterminated {{slot}} in response template";
+    auto name = rest.subpiece(open + 2, close - open - 2);
+
+    Fragment frag;
+    if (open > 0) {
+      frag.staticBytes = folly::IOBuf::copyBuffer(rest.data(), open);
+      staticLength_ += open;
+    }
+    frag.slot = findSlot(name);
+    if (frag.slot < 0) {
+      frag.slot = slotNames_.size();
+      slotNames_.emplace_back(name.str());
+    }
+    fragments_.push_back(std::move(frag));
+    rest.advance(close + 2);
+  }
+  if (!rest.empty()) {
+    Fragment frag;
+    frag.staticBytes = folly::IOBuf::copyBuffer(rest.data(), rest.size());
+    staticLength_ += rest.size();
+    fragments_.push_back(std::move(frag));
+  }
+}
+
+int32_t ResponseTemplate::findSlot(folly::StringPiece name) const {
+  for (size_t i = 0; i < slotNames_.size(); ++i) {
+    if (name == slotNames_[i]) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+ResponseTemplate::Renderer::Renderer(const ResponseTemplate* tmpl)
+    : tmpl_(tmpl), values_(tmpl->slotNames_.size()) {
+}
+
+ResponseTemplate::Renderer& ResponseTemplate::Renderer::set(
+    folly::StringPiece slot, std::string value) {
+  auto index = tmpl_->findSlot(slot);
+  DCHECK_GE(index, 0) << "Unknown slot " << slot << " in response template";
+  if (index >= 0) {
+    values_[index] = std::move(value);
+  }
+  return *this;
+}
+
+std::unique_ptr<folly::IOBuf> ResponseTemplate::Renderer::renderBody() {
+  folly::IOBufQueue body{folly::IOBufQueue::cacheChainLength()};
+  for (const auto& frag : tmpl_->fragments_) {
+    if (frag.staticBytes) {
+      // shares the template's buffer; nothing static is re-encoded
+      body.append(frag.staticBytes->clone());
+    }
+    if (frag.slot >= 0 && !values_[frag.slot].empty()) {
+      body.append(folly::IOBuf::copyBuffer(values_[frag.slot]));
+    }
+  }
+  return body.move();
+}
+
+void ResponseTemplate::Renderer::sendTo(ResponseHandler* txn) {
+  auto body = renderBody();
+  HTTPMessage headers(tmpl_->prototype_);
+  headers.getHeaders().add(
+      HTTP_HEADER_CONTENT_LENGTH,
+      folly::to<std::string>(body ? body->computeChainDataLength() : 0));
+  txn->sendHeaders(headers);
+  if (body) {
+    txn->sendBody(std::move(body));
+  }
+  txn->sendEOM();
+}
+
+} // namespace proxygen
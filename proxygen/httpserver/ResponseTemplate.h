@@ -0,0 +1,109 @@
+/*
+ *  Copyright (c) 2019-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <folly/Range.h>
+#include <folly/io/IOBuf.h>
+#include <proxygen/httpserver/ResponseHandler.h>
+
+namespace proxygen {
+
+/**
+ * Pre-compiled response template for handlers whose responses are
+ * mostly static - JSON envelopes and the like where only a few fields
+ * vary per request.
+ *
+ * The body template is split once, at construction, around {{slot}}
+ * markers; the static pieces between markers are encoded into IOBufs
+ * that every render() shares by clone, so per request the handler only
+ * materializes the variable fields and a handful of IOBuf headers.
+ * The response headers are likewise built once into an HTTPMessage
+ * prototype and copied per send with just Content-Length stamped in.
+ * On HTTP/2 the repeated header block is cheap after the first response
+ * anyway (HPACK indexes it); the prototype saves the per-request
+ * HTTPMessage assembly that ResponseBuilder would redo every time.
+ *
+ * Templates are immutable once built, so one instance may be shared
+ * across threads; each Renderer is single-use and single-threaded.
+ *
+ *   static const ResponseTemplate kUserEnvelope{
+ *       200, "OK",
+ *       "{\"status\":\"ok\",\"user\":\"{{user}}\",\"data\":{{data}}}"};
+ *
+ *   kUserEnvelope.render()
+ *       .set("user", std::move(name))
+ *       .set("data", std::move(json))
+ *       .sendTo(downstream_);
+ */
+class ResponseTemplate {
+ public:
+  ResponseTemplate(uint16_t statusCode,
+                   const std::string& statusMessage,
+                   folly::StringPiece bodyTemplate);
+
+  /**
+   * Add a header baked into every rendered response.  Call at template
+   * construction time only.
+   */
+  ResponseTemplate& header(HTTPHeaderCode code, const std::string& value);
+  ResponseTemplate& header(const std::string& name, const std::string& value);
+
+  /**
+   * Per-request fill-in of one template.  Slots left unset render
+   * empty.
+   */
+  class Renderer {
+   public:
+    Renderer& set(folly::StringPiece slot, std::string value);
+
+    /** Assemble the body: shared clones of the static pieces with the
+        variable fields spliced into the gaps. */
+    std::unique_ptr<folly::IOBuf> renderBody();
+
+    /** Send the complete response - headers, body, EOM - downstream. */
+    void sendTo(ResponseHandler* txn);
+
+   private:
+    friend class ResponseTemplate;
+    explicit Renderer(const ResponseTemplate* tmpl);
+
+    const ResponseTemplate* tmpl_;
+    std::vector<std::string> values_;
+  };
+
+  Renderer render() const {
+    return Renderer(this);
+  }
+
+  size_t getNumSlots() const {
+    return slotNames_.size();
+  }
+
+ private:
+  // One run of pre-encoded static bytes, followed by the slot (if any)
+  // that fills the gap before the next fragment
+  struct Fragment {
+    std::unique_ptr<folly::IOBuf> staticBytes; // may be null
+    int32_t slot{-1};                          // -1: no slot follows
+  };
+
+  void compile(folly::StringPiece bodyTemplate);
+  int32_t findSlot(folly::StringPiece name) const;
+
+  HTTPMessage prototype_;
+  std::vector<Fragment> fragments_;
+  std::vector<std::string> slotNames_;
+  size_t staticLength_{0};
+};
+
+} // namespace proxygen
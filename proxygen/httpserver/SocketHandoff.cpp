@@ -0,0 +1,188 @@
+/*
+ *  Copyright (c) 2015-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include <proxygen/httpserver/SocketHandoff.h>
+
+#include <cstring>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <folly/FileUtil.h>
+#include <folly/ScopeGuard.h>
+#include <glog/logging.h>
+
+namespace {
+
+bool waitReadable(int fd, std::chrono::milliseconds timeout) {
+  struct pollfd pfd;
+  pfd.fd = fd;
+  pfd.events = POLLIN;
+  int rc = poll(&pfd, 1, int(timeout.count()));
+  return rc > 0 && (pfd.revents & POLLIN);
+}
+
+bool fillUnixAddress(const std::string& path, struct sockaddr_un& addr) {
+  if (path.size() >= sizeof(addr.sun_path)) {
+    LOG(ERROR) << "Handoff path too long: " << path;
+    return false;
+  }
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  memcpy(addr.sun_path, path.data(), path.size());
+  return true;
+}
+
+} // namespace
+
+namespace proxygen {
+
+constexpr size_t SocketHandoff::kMaxFds;
+
+bool SocketHandoff::serveFds(const std::string& path,
+                             const std::vector<int>& fds,
+                             std::chrono::milliseconds timeout) {
+  if (fds.empty() || fds.size() > kMaxFds) {
+    LOG(ERROR) << "Cannot hand off " << fds.size() << " fds";
+    return false;
+  }
+  struct sockaddr_un addr;
+  if (!fillUnixAddress(path, addr)) {
+    return false;
+  }
+
+  int listenFd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  if (listenFd < 0) {
+    PLOG(ERROR) << "socket() for handoff listener";
+    return false;
+  }
+  SCOPE_EXIT {
+    ::close(listenFd);
+    ::unlink(path.c_str());
+  };
+
+  // replace any socket file a crashed predecessor left behind
+  ::unlink(path.c_str());
+  if (::bind(listenFd, (struct sockaddr*)&addr, sizeof(addr)) != 0 ||
+      ::listen(listenFd, 1) != 0) {
+    PLOG(ERROR) << "bind/listen on handoff path " << path;
+    return false;
+  }
+
+  if (!waitReadable(listenFd, timeout)) {
+    LOG(WARNING) << "Timed out waiting for handoff peer on " << path;
+    return false;
+  }
+  int peerFd = ::accept(listenFd, nullptr, nullptr);
+  if (peerFd < 0) {
+    PLOG(ERROR) << "accept() on handoff listener";
+    return false;
+  }
+  SCOPE_EXIT {
+    ::close(peerFd);
+  };
+
+  // one data byte carrying the fd count, fds in the control message
+  uint8_t count = uint8_t(fds.size());
+  struct iovec iov;
+  iov.iov_base = &count;
+  iov.iov_len = 1;
+  char cmsgBuf[CMSG_SPACE(sizeof(int) * kMaxFds)];
+  struct msghdr msg;
+  memset(&msg, 0, sizeof(msg));
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = cmsgBuf;
+  msg.msg_controllen = CMSG_SPACE(sizeof(int) * fds.size());
+  struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+  cmsg->cmsg_level = SOL_SOCKET;
+  cmsg->cmsg_type = SCM_RIGHTS;
+  cmsg->cmsg_len = CMSG_LEN(sizeof(int) * fds.size());
+  memcpy(CMSG_DATA(cmsg), fds.data(), sizeof(int) * fds.size());
+
+  if (::sendmsg(peerFd, &msg, 0) != 1) {
+    PLOG(ERROR) << "sendmsg() of " << fds.size() << " listener fds";
+    return false;
+  }
+
+  if (!waitReadable(peerFd, timeout)) {
+    LOG(WARNING) << "Timed out waiting for handoff ack";
+    return false;
+  }
+  char ack = 0;
+  if (folly::readNoInt(peerFd, &ack, 1) != 1) {
+    PLOG(ERROR) << "reading handoff ack";
+    return false;
+  }
+  VLOG(2) << "Handed off " << fds.size() << " listener fds via " << path;
+  return true;
+}
+
+std::vector<int> SocketHandoff::requestFds(const std::string& path,
+                                           std::chrono::milliseconds timeout) {
+  struct sockaddr_un addr;
+  if (!fillUnixAddress(path, addr)) {
+    return {};
+  }
+  int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0) {
+    PLOG(ERROR) << "socket() for handoff request";
+    return {};
+  }
+  SCOPE_EXIT {
+    ::close(fd);
+  };
+  if (::connect(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0) {
+    PLOG(ERROR) << "connect() to handoff path " << path;
+    return {};
+  }
+  if (!waitReadable(fd, timeout)) {
+    LOG(WARNING) << "Timed out waiting for handoff fds from " << path;
+    return {};
+  }
+
+  uint8_t count = 0;
+  struct iovec iov;
+  iov.iov_base = &count;
+  iov.iov_len = 1;
+  char cmsgBuf[CMSG_SPACE(sizeof(int) * kMaxFds)];
+  struct msghdr msg;
+  memset(&msg, 0, sizeof(msg));
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = cmsgBuf;
+  msg.msg_controllen = sizeof(cmsgBuf);
+
+  if (::recvmsg(fd, &msg, 0) != 1) {
+    PLOG(ERROR) << "recvmsg() of listener fds";
+    return {};
+  }
+  struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+  if (!cmsg || cmsg->cmsg_level != SOL_SOCKET ||
+      cmsg->cmsg_type != SCM_RIGHTS || count == 0 || count > kMaxFds ||
+      cmsg->cmsg_len != CMSG_LEN(sizeof(int) * count)) {
+    LOG(ERROR) << "Malformed handoff message";
+    return {};
+  }
+  std::vector<int> fds(count);
+  memcpy(fds.data(), CMSG_DATA(cmsg), sizeof(int) * count);
+
+  char ack = 'K';
+  if (folly::writeNoInt(fd, &ack, 1) != 1) {
+    PLOG(ERROR) << "writing handoff ack";
+    for (auto received : fds) {
+      ::close(received);
+    }
+    return {};
+  }
+  return fds;
+}
+
+} // namespace proxygen
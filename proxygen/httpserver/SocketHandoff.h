@@ -0,0 +1,57 @@
+/*
+ *  Copyright (c) 2015-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#pragma once
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+namespace proxygen {
+
+/**
+ * Transfers listening socket file descriptors between processes over a
+ * unix domain socket (SCM_RIGHTS), for zero-downtime deploys: the new
+ * binary receives the old binary's listeners and starts accepting on
+ * them (HTTPServerOptions::useExistingSockets) before the old one stops,
+ * so the shared kernel accept queue never closes and no SYN is dropped
+ * during the rollout.
+ *
+ * Protocol: the old process serves the fds at a filesystem path; the new
+ * process connects and receives them, then sends a one-byte ack.  The
+ * ack tells the old process the handoff landed, at which point it is
+ * safe to stop accepting and drain (see HTTPServer::handoffSockets).
+ *
+ * Both calls block up to the given timeout and are intended for deploy
+ * orchestration paths, not event loops.
+ */
+class SocketHandoff {
+ public:
+  /**
+   * Serve the given fds at path (any stale socket file is replaced),
+   * accept a single peer, send the fds, and wait for the ack.  Returns
+   * true once the peer has acked receipt.
+   */
+  static bool serveFds(const std::string& path,
+                       const std::vector<int>& fds,
+                       std::chrono::milliseconds timeout);
+
+  /**
+   * Connect to path, receive the fds, and ack.  Returns the received
+   * fds (owned by the caller), or an empty vector on failure or
+   * timeout.
+   */
+  static std::vector<int> requestFds(const std::string& path,
+                                     std::chrono::milliseconds timeout);
+
+  // Upper bound on fds per transfer, limited by the cmsg buffer
+  static constexpr size_t kMaxFds = 64;
+};
+
+} // namespace proxygen
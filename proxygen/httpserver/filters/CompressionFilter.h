@@ -9,13 +9,17 @@
  */
 #pragma once
 
+#include <deque>
+#include <folly/Executor.h>
 #include <folly/Memory.h>
+#include <folly/io/async/EventBaseManager.h>
 
 #include <proxygen/httpserver/Filters.h>
 #include <proxygen/httpserver/RequestHandlerFactory.h>
 #include <proxygen/lib/http/RFC2616.h>
 #include <proxygen/lib/utils/StreamCompressor.h>
 #include <proxygen/lib/utils/ZlibStreamCompressor.h>
+#include <proxygen/lib/utils/ZstdStreamCompressor.h>
 
 namespace proxygen {
 
@@ -33,17 +37,30 @@ class CompressionFilter : public Filter {
       uint32_t minimumCompressionSize,
       StreamCompressorFactory factory,
       std::string headerEncoding,
-      const std::shared_ptr<std::set<std::string>> compressibleContentTypes)
+      const std::shared_ptr<std::set<std::string>> compressibleContentTypes,
+      folly::Executor* offloadExecutor = nullptr,
+      uint32_t offloadThreshold = kDefaultOffloadThreshold)
       : Filter(downstream),
         minimumCompressionSize_(minimumCompressionSize),
         compressorFactory_(std::move(factory)),
         headerEncoding_(std::move(headerEncoding)),
-        compressibleContentTypes_(compressibleContentTypes) {
+        compressibleContentTypes_(compressibleContentTypes),
+        offloadExecutor_(offloadExecutor),
+        offloadThreshold_(offloadThreshold) {
   }
 
   virtual ~CompressionFilter() override {
+    if (offloadState_) {
+      // Outstanding offload jobs own the compressor through the shared
+      // state; flag them to drop their output instead of touching us
+      offloadState_->alive = false;
+    }
   }
 
+  // Body chunks at least this large ship to the offload executor when one
+  // is configured, so a multi-MB response doesn't stall the worker's loop
+  static constexpr uint32_t kDefaultOffloadThreshold = 1u << 20;
+
   void sendHeaders(HTTPMessage& msg) noexcept override {
     DCHECK(compressor_ == nullptr);
     DCHECK(header_ == false);
@@ -56,9 +73,12 @@ class CompressionFilter : public Filter {
              .getSingleOrEmpty(HTTP_HEADER_CONTENT_ENCODING)
              .empty();
 
-    // Make final determination of whether to compress
+    // Make final determination of whether to compress.  Chunked responses
+    // have no Content-Length to check against the minimum, so they
+    // compress unless a declared body size says they are too small.
     compress_ = !alreadyCompressed && isCompressibleContentType(msg) &&
-                (chunked_ || isMinimumCompressibleSize(msg));
+                (chunked_ ? hintAllowsCompression()
+                          : isMinimumCompressibleSize(msg));
 
     // Add the header
     if (compress_) {
@@ -83,6 +103,11 @@ class CompressionFilter : public Filter {
     }
   }
 
+  void setEgressBodySizeHint(uint64_t bytes) noexcept override {
+    bodySizeHint_ = bytes;
+    Filter::setEgressBodySizeHint(bytes);
+  }
+
   void sendChunkHeader(size_t len) noexcept override {
     // The headers should have always been sent since the message is chunked
     DCHECK_EQ(header_, true) << "Headers should have already been sent.";
@@ -106,6 +131,16 @@ class CompressionFilter : public Filter {
       return;
     }
 
+    // Once a chunk has shipped to the offload executor, everything after it
+    // must queue behind it to keep the compression stream and the response
+    // ordered
+    if (offloading_ ||
+        (offloadExecutor_ &&
+         body->computeChainDataLength() >= offloadThreshold_)) {
+      offloadEnqueue(OffloadEvent::Type::BODY, std::move(body), !chunked_);
+      return;
+    }
+
     CHECK(compressor_ && !compressor_->hasError());
 
     // If it's chunked, never write the trailer, it will be written on EOM
@@ -134,7 +169,25 @@ class CompressionFilter : public Filter {
     Filter::sendBody(std::move(compressed));
   }
 
+  void sendChunkTerminator() noexcept override {
+    if (offloading_) {
+      offloadEnqueue(OffloadEvent::Type::TERMINATOR, nullptr, false);
+      return;
+    }
+    Filter::sendChunkTerminator();
+  }
+
   void sendEOM() noexcept override {
+    if (offloading_) {
+      // The stream trailer needs the compressor, so it rides the queue like
+      // a body chunk; EOM is emitted once everything ahead of it has drained
+      if (compress_ && chunked_) {
+        offloadEnqueue(
+            OffloadEvent::Type::BODY, folly::IOBuf::copyBuffer(""), true);
+      }
+      offloadEnqueue(OffloadEvent::Type::EOM, nullptr, false);
+      return;
+    }
 
     // Need to send the trailer for compressed chunked messages
     if (compress_ && chunked_) {
@@ -162,6 +215,144 @@ class CompressionFilter : public Filter {
     Filter::sendAbort();
   }
 
+  /**
+   * Offload pipeline.  Body chunks (and the stream trailer) are compressed
+   * on the executor one at a time - the compressor is a sequential stream -
+   * and their output is re-injected on the event base in arrival order.
+   * Terminators and the EOM carry no compression work, but still ride the
+   * queue so nothing overtakes a chunk that is off being compressed.
+   */
+  // NB: aggregate - default member initializers would break brace
+  // construction in C++14
+  struct OffloadEvent {
+    enum class Type : uint8_t { BODY, TERMINATOR, EOM };
+    Type type;
+    std::unique_ptr<folly::IOBuf> body;
+    bool trailer;
+  };
+
+  /**
+   * Shared with in-flight executor jobs.  Owns the compressor once
+   * offloading starts; alive is cleared on the event base thread by the
+   * filter destructor so late completions drop their output.
+   */
+  struct OffloadState {
+    folly::EventBase* evb{nullptr};
+    std::unique_ptr<StreamCompressor> compressor;
+    bool alive{true};
+  };
+
+  void offloadEnqueue(OffloadEvent::Type type,
+                      std::unique_ptr<folly::IOBuf> body,
+                      bool trailer) {
+    if (!offloading_) {
+      // First offloaded chunk: compression moves off this thread for the
+      // rest of the response
+      offloading_ = true;
+      offloadState_ = std::make_shared<OffloadState>();
+      offloadState_->evb = folly::EventBaseManager::get()->getEventBase();
+      offloadState_->compressor = std::move(compressor_);
+    }
+    if (body) {
+      offloadQueuedBytes_ += body->computeChainDataLength();
+    }
+    offloadQueue_.push_back({type, std::move(body), trailer});
+    // Backpressure into the handler's egress: stop it producing while more
+    // than two thresholds' worth of uncompressed bytes are queued
+    if (!offloadPaused_ &&
+        offloadQueuedBytes_ >= 2 * uint64_t(offloadThreshold_)) {
+      offloadPaused_ = true;
+      upstream_->onEgressPaused();
+    }
+    offloadProcess();
+  }
+
+  void offloadProcess() {
+    while (!offloadQueue_.empty() && !offloadJobInFlight_) {
+      if (offloadQueue_.front().type == OffloadEvent::Type::TERMINATOR) {
+        offloadQueue_.pop_front();
+        Filter::sendChunkTerminator();
+      } else if (offloadQueue_.front().type == OffloadEvent::Type::EOM) {
+        offloadQueue_.pop_front();
+        Filter::sendEOM();
+      } else {
+        offloadDispatch();
+        break;
+      }
+    }
+    if (offloadPaused_ && offloadQueuedBytes_ < offloadThreshold_) {
+      offloadPaused_ = false;
+      upstream_->onEgressResumed();
+    }
+  }
+
+  void offloadDispatch() {
+    DCHECK(!offloadJobInFlight_);
+    auto event = std::move(offloadQueue_.front());
+    offloadQueue_.pop_front();
+    offloadJobInFlight_ = true;
+    auto state = offloadState_;
+    offloadExecutor_->add([this,
+                           state,
+                           body = std::move(event.body),
+                           trailer = event.trailer]() mutable {
+      auto uncompressedLength = body->computeChainDataLength();
+      auto compressed = state->compressor->compress(body.get(), trailer);
+      bool error = !compressed || state->compressor->hasError();
+      state->evb->runInEventBaseThread([this,
+                                        state,
+                                        compressed = std::move(compressed),
+                                        error,
+                                        uncompressedLength,
+                                        trailer]() mutable {
+        if (!state->alive) {
+          return;
+        }
+        offloadComplete(std::move(compressed), error, uncompressedLength,
+                        trailer);
+      });
+    });
+  }
+
+  void offloadComplete(std::unique_ptr<folly::IOBuf> compressed,
+                       bool error,
+                       uint64_t uncompressedLength,
+                       bool trailer) {
+    offloadJobInFlight_ = false;
+    offloadQueuedBytes_ -= uncompressedLength;
+    if (error) {
+      fail();
+      return;
+    }
+
+    auto compressedBodyLength = compressed->computeChainDataLength();
+    if (chunked_) {
+      Filter::sendChunkHeader(compressedBodyLength);
+      Filter::sendBody(std::move(compressed));
+      if (trailer) {
+        // The final flush was "injected" as its own chunk, see sendEOM
+        Filter::sendChunkTerminator();
+      }
+    } else {
+      // Send the content length on compressed, non-chunked messages
+      DCHECK(header_ == false);
+      auto& headers = responseMessage_->getHeaders();
+      headers.set(HTTP_HEADER_CONTENT_LENGTH,
+                  folly::to<std::string>(compressedBodyLength));
+      Filter::sendHeaders(*responseMessage_);
+      header_ = true;
+      Filter::sendBody(std::move(compressed));
+    }
+
+    offloadProcess();
+  }
+
+  // With no declared size assume the response is large enough; with one,
+  // hold it to the same minimum as a Content-Length
+  bool hintAllowsCompression() const noexcept {
+    return !bodySizeHint_ || *bodySizeHint_ >= minimumCompressionSize_;
+  }
+
   // Verify the response is large enough to compress
   bool isMinimumCompressibleSize(const HTTPMessage& msg) const noexcept {
     auto contentLengthHeader =
@@ -203,9 +394,19 @@ class CompressionFilter : public Filter {
   StreamCompressorFactory compressorFactory_{};
   const std::string headerEncoding_{};
   const std::shared_ptr<std::set<std::string>> compressibleContentTypes_;
+  folly::Optional<uint64_t> bodySizeHint_;
   bool header_{false};
   bool chunked_{false};
   bool compress_{false};
+
+  folly::Executor* offloadExecutor_{nullptr};
+  const uint32_t offloadThreshold_{kDefaultOffloadThreshold};
+  std::shared_ptr<OffloadState> offloadState_;
+  std::deque<OffloadEvent> offloadQueue_;
+  uint64_t offloadQueuedBytes_{0};
+  bool offloading_{false};
+  bool offloadJobInFlight_{false};
+  bool offloadPaused_{false};
 };
 
 class CompressionFilterFactory : public RequestHandlerFactory {
@@ -213,6 +414,7 @@ class CompressionFilterFactory : public RequestHandlerFactory {
   enum class CodecType : uint8_t {
     ZLIB = 0,
     NO_COMPRESSION = 1,
+    ZSTD = 2,
   };
 
  public:
@@ -221,11 +423,27 @@ class CompressionFilterFactory : public RequestHandlerFactory {
     uint32_t minimumCompressionSize = 1000;
     std::set<std::string> compressibleContentTypes = {};
     int32_t zlibCompressionLevel = 4;
+    // Serve "zstd" to clients that accept it, in preference to gzip
+    bool enableZstd = false;
+    // With no explicit level, one is picked per response size - see
+    // ZstdStreamCompressor::selectLevel
+    folly::Optional<int32_t> zstdCompressionLevel;
+    // When set, body chunks of at least compressionOffloadThreshold bytes
+    // (and everything behind them in the same response) are compressed on
+    // this executor instead of the event base thread.  Must outlive the
+    // server.
+    folly::Executor* compressionOffloadExecutor = nullptr;
+    uint32_t compressionOffloadThreshold =
+        CompressionFilter::kDefaultOffloadThreshold;
   };
 
   CompressionFilterFactory(const Options& opts)
       : minimumCompressionSize_(opts.minimumCompressionSize),
         zlibCompressionLevel_(opts.zlibCompressionLevel),
+        enableZstd_(opts.enableZstd),
+        zstdCompressionLevel_(opts.zstdCompressionLevel),
+        offloadExecutor_(opts.compressionOffloadExecutor),
+        offloadThreshold_(opts.compressionOffloadThreshold),
         compressibleContentTypes_(std::make_shared<std::set<std::string>>(
             opts.compressibleContentTypes)) {
   }
@@ -252,7 +470,21 @@ class CompressionFilterFactory : public RequestHandlerFactory {
                   proxygen::CompressionType::GZIP, level);
             },
             "gzip",
-            compressibleContentTypes_};
+            compressibleContentTypes_,
+            offloadExecutor_,
+            offloadThreshold_};
+      case CodecType::ZSTD:
+        return new CompressionFilter{
+            h,
+            minimumCompressionSize_,
+            [level =
+                 zstdCompressionLevel_]() -> std::unique_ptr<StreamCompressor> {
+              return std::make_unique<ZstdStreamCompressor>(level);
+            },
+            "zstd",
+            compressibleContentTypes_,
+            offloadExecutor_,
+            offloadThreshold_};
       case CodecType::NO_COMPRESSION:
         return h;
     };
@@ -273,6 +505,18 @@ class CompressionFilterFactory : public RequestHandlerFactory {
       return CodecType::NO_COMPRESSION;
     }
 
+    // Prefer zstd when the client accepts it: comparable ratios to gzip at
+    // a fraction of the compression CPU
+    if (enableZstd_) {
+      auto zstdIt = std::find_if(
+          output.begin(), output.end(), [](RFC2616::TokenQPair elem) {
+            return elem.first.compare(folly::StringPiece("zstd")) == 0;
+          });
+      if (zstdIt != output.end()) {
+        return CodecType::ZSTD;
+      }
+    }
+
     auto it = std::find_if(
         output.begin(), output.end(), [](RFC2616::TokenQPair elem) {
           return elem.first.compare(folly::StringPiece("gzip")) == 0;
@@ -286,6 +530,10 @@ class CompressionFilterFactory : public RequestHandlerFactory {
 
   const uint32_t minimumCompressionSize_;
   const int32_t zlibCompressionLevel_;
+  const bool enableZstd_;
+  const folly::Optional<int32_t> zstdCompressionLevel_;
+  folly::Executor* const offloadExecutor_;
+  const uint32_t offloadThreshold_;
   const std::shared_ptr<std::set<std::string>> compressibleContentTypes_;
 };
 } // namespace proxygen
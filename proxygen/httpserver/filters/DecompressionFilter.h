@@ -0,0 +1,198 @@
+/*
+ *  Copyright (c) 2015-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#pragma once
+
+#include <folly/io/IOBufQueue.h>
+#include <memory>
+#include <string>
+
+#include <proxygen/httpserver/Filters.h>
+#include <proxygen/httpserver/RequestHandlerFactory.h>
+#include <proxygen/httpserver/ResponseBuilder.h>
+#include <proxygen/lib/http/session/HTTPSessionBase.h>
+#include <proxygen/lib/utils/UtilInl.h>
+#include <proxygen/lib/utils/ZlibStreamDecompressor.h>
+#include <proxygen/lib/utils/ZstdStreamDecompressor.h>
+
+namespace proxygen {
+
+/**
+ * A server filter decompressing compressed request bodies before they reach
+ * the handler - the ingress peer of CompressionFilter.  The factory selects
+ * a decompressor from the request's Content-Encoding (gzip, deflate, zstd)
+ * and strips the encoding headers, so handlers always see a plain stream.
+ *
+ * Decompression bombs are contained by a hard byte cap and an
+ * expansion-ratio cap; a request exceeding either is answered with
+ * 413 on the handler's behalf and its remaining ingress is swallowed.
+ * Small decompressed chunks are coalesced up to a window before delivery
+ * so handlers are not peppered with the decompressor's growth-sized blocks.
+ */
+class DecompressionFilter : public Filter {
+ public:
+  DecompressionFilter(RequestHandler* upstream,
+                      std::unique_ptr<StreamDecompressor> decompressor,
+                      uint64_t maxDecompressedBytes,
+                      uint32_t maxCompressionRatio,
+                      uint32_t coalesceWindow)
+      : Filter(upstream),
+        decompressor_(std::move(decompressor)),
+        maxDecompressedBytes_(maxDecompressedBytes),
+        maxCompressionRatio_(maxCompressionRatio),
+        coalesceWindow_(coalesceWindow) {
+  }
+
+  void onRequest(std::unique_ptr<HTTPMessage> headers) noexcept override {
+    // The handler sees the decompressed stream; the encoding is consumed
+    // here and any Content-Length refers to the compressed bytes
+    headers->getHeaders().remove(HTTP_HEADER_CONTENT_ENCODING);
+    headers->getHeaders().remove(HTTP_HEADER_CONTENT_LENGTH);
+    Filter::onRequest(std::move(headers));
+  }
+
+  void onBody(std::unique_ptr<folly::IOBuf> body) noexcept override {
+    if (error_) {
+      return;
+    }
+
+    compressedBytes_ += body->computeChainDataLength();
+    auto decompressed = decompressor_->decompress(body.get());
+    if (decompressor_->hasError()) {
+      reject(400, "Bad Request");
+      return;
+    }
+    if (!decompressed) {
+      return;
+    }
+
+    decompressedBytes_ += decompressed->computeChainDataLength();
+    if (exceedsLimits()) {
+      reject(413, "Payload Too Large");
+      return;
+    }
+
+    pending_.append(std::move(decompressed));
+    if (pending_.chainLength() >= coalesceWindow_) {
+      flushPending();
+    }
+  }
+
+  void onEOM() noexcept override {
+    if (error_) {
+      return;
+    }
+    flushPending();
+    Filter::onEOM();
+  }
+
+ protected:
+  bool exceedsLimits() const noexcept {
+    if (decompressedBytes_ > maxDecompressedBytes_) {
+      return true;
+    }
+    // Only call it a bomb once the expansion is past the coalescing
+    // window; tiny bodies legitimately blow past any ratio
+    return decompressedBytes_ > coalesceWindow_ &&
+           decompressedBytes_ > maxCompressionRatio_ * compressedBytes_;
+  }
+
+  /**
+   * Respond on the handler's behalf and swallow the rest of the request.
+   * The handler never gets onEOM(), so it will not respond itself, and it
+   * still receives its usual terminal callback when the transaction ends.
+   */
+  void reject(uint16_t statusCode, const std::string& reason) noexcept {
+    error_ = true;
+    pending_.move();
+    decompressor_.reset();
+    ResponseBuilder(this)
+        .status(statusCode, reason)
+        .closeConnection()
+        .sendWithEOM();
+  }
+
+  void flushPending() noexcept {
+    if (pending_.chainLength() > 0) {
+      Filter::onBody(pending_.move());
+    }
+  }
+
+  std::unique_ptr<StreamDecompressor> decompressor_;
+  folly::IOBufQueue pending_{folly::IOBufQueue::cacheChainLength()};
+  const uint64_t maxDecompressedBytes_;
+  const uint32_t maxCompressionRatio_;
+  const uint32_t coalesceWindow_;
+  uint64_t compressedBytes_{0};
+  uint64_t decompressedBytes_{0};
+  bool error_{false};
+};
+
+class DecompressionFilterFactory : public RequestHandlerFactory {
+ public:
+  struct Options {
+    Options() = default;
+    // Hard cap on decompressed request bytes, scaled from the sessions'
+    // ingress buffer limit so raising one raises the other
+    uint64_t maxDecompressedBytes =
+        uint64_t(HTTPSessionBase::getDefaultReadBufferLimit()) * 1024;
+    // Maximum decompressed:compressed expansion before a request is
+    // treated as a decompression bomb
+    uint32_t maxCompressionRatio = 100;
+    // Decompressed chunks are batched up to this many bytes before
+    // delivery to the handler
+    uint32_t coalesceWindow = 16 * 1024;
+  };
+
+  explicit DecompressionFilterFactory(const Options& opts = Options())
+      : options_(opts) {
+  }
+
+  void onServerStart(folly::EventBase* /*evb*/) noexcept override {
+  }
+
+  void onServerStop() noexcept override {
+  }
+
+  RequestHandler* onRequest(RequestHandler* h,
+                            HTTPMessage* msg) noexcept override {
+    auto decompressor = makeDecompressor(
+        msg->getHeaders().getSingleOrEmpty(HTTP_HEADER_CONTENT_ENCODING));
+    if (!decompressor) {
+      return h;
+    }
+    return new DecompressionFilter(h,
+                                   std::move(decompressor),
+                                   options_.maxDecompressedBytes,
+                                   options_.maxCompressionRatio,
+                                   options_.coalesceWindow);
+  }
+
+ private:
+  static std::unique_ptr<StreamDecompressor> makeDecompressor(
+      const std::string& encoding) noexcept {
+    if (caseInsensitiveEqual(encoding, "gzip") ||
+        caseInsensitiveEqual(encoding, "x-gzip")) {
+      return std::make_unique<ZlibStreamDecompressor>(CompressionType::GZIP);
+    }
+    if (caseInsensitiveEqual(encoding, "deflate")) {
+      return std::make_unique<ZlibStreamDecompressor>(
+          CompressionType::DEFLATE);
+    }
+    if (caseInsensitiveEqual(encoding, "zstd")) {
+      return std::make_unique<ZstdStreamDecompressor>();
+    }
+    // unencoded or an encoding we don't speak; leave the body alone
+    return nullptr;
+  }
+
+  const Options options_;
+};
+
+} // namespace proxygen
@@ -0,0 +1,294 @@
+/*
+ *  Copyright (c) 2015-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <folly/ThreadLocal.h>
+#include <folly/hash/SpookyHashV2.h>
+#include <folly/lang/Bits.h>
+#include <limits>
+#include <proxygen/httpserver/Filters.h>
+#include <proxygen/httpserver/RequestHandlerFactory.h>
+#include <proxygen/httpserver/ResponseBuilder.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace proxygen {
+
+/**
+ * Request rate limiter for one worker thread.  Each worker owns its own
+ * instance (see RateLimitFilterFactory), so admission runs without any
+ * locking: the usual handler-side alternative is a mutex-guarded map
+ * shared by all workers, checked only after the full request has been
+ * assembled.
+ *
+ * Keys named in the config get an exact token bucket in a flat array,
+ * resolved through a map that is read-only after construction.  All
+ * other keys - client IPs and the like, whose cardinality is unbounded -
+ * are counted in a count-min sketch that is wiped each one-second
+ * window, so per-key state for them is O(1) and an adversary spraying
+ * keys cannot grow it.  The sketch only ever overestimates, so it can
+ * throttle an innocent key that collides with a hot one, but never lets
+ * a hot key through.
+ *
+ * Limits are enforced per worker.  Connections from one client spread
+ * across workers, so configure roughly the global limit divided by the
+ * worker count.
+ */
+class RequestRateLimiter {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  struct Config {
+    /**
+     * Requests per second for specific keys, enforced by exact token
+     * buckets.
+     */
+    std::vector<std::pair<std::string, uint32_t>> keyLimits;
+
+    /**
+     * Requests per second for every key not named above, enforced
+     * through the sketch.  0 admits them all.
+     */
+    uint32_t defaultLimit{0};
+
+    /**
+     * Bucket depth for the configured keys, in requests; 0 picks the
+     * key's per-second limit.
+     */
+    uint32_t burst{0};
+
+    /**
+     * Counters per sketch row, rounded up to a power of two.  Collision
+     * rate falls linearly with width; 4KB per row at the default.
+     */
+    size_t sketchWidth{1024};
+  };
+
+  explicit RequestRateLimiter(const Config& config)
+      : defaultLimit_(config.defaultLimit) {
+    buckets_.reserve(config.keyLimits.size());
+    for (const auto& keyLimit : config.keyLimits) {
+      keyIndex_.emplace(keyLimit.first, buckets_.size());
+      Bucket bucket;
+      bucket.ratePerSec = keyLimit.second;
+      bucket.burst = config.burst > 0 ? config.burst : keyLimit.second;
+      bucket.tokens = bucket.burst;
+      buckets_.push_back(bucket);
+    }
+    sketchMask_ = folly::nextPowTwo(config.sketchWidth) - 1;
+    if (defaultLimit_ > 0) {
+      sketch_.resize(kSketchRows * (sketchMask_ + 1), 0);
+    }
+  }
+
+  bool allow(folly::StringPiece key) {
+    return allow(key, Clock::now());
+  }
+
+  /**
+   * True if a request under key may proceed now.  Also the debit: an
+   * admitted request consumes a token / bumps the sketch.
+   */
+  bool allow(folly::StringPiece key, Clock::time_point now) {
+    if (!keyIndex_.empty()) {
+      auto it = keyIndex_.find(key.str());
+      if (it != keyIndex_.end()) {
+        return allowBucket(buckets_[it->second], now);
+      }
+    }
+    if (defaultLimit_ == 0) {
+      return true;
+    }
+    return allowSketch(key, now);
+  }
+
+ private:
+  struct Bucket {
+    double tokens{0};
+    double ratePerSec{0};
+    double burst{0};
+    Clock::time_point lastRefill{Clock::time_point::min()};
+  };
+
+  bool allowBucket(Bucket& bucket, Clock::time_point now) {
+    if (bucket.lastRefill == Clock::time_point::min()) {
+      bucket.lastRefill = now;
+    }
+    const std::chrono::duration<double> elapsed = now - bucket.lastRefill;
+    bucket.tokens = std::min(
+        bucket.burst, bucket.tokens + elapsed.count() * bucket.ratePerSec);
+    bucket.lastRefill = now;
+    if (bucket.tokens < 1) {
+      return false;
+    }
+    bucket.tokens -= 1;
+    return true;
+  }
+
+  bool allowSketch(folly::StringPiece key, Clock::time_point now) {
+    const auto window =
+        std::chrono::duration_cast<std::chrono::seconds>(now.time_since_epoch())
+            .count();
+    if (window != sketchWindow_) {
+      sketchWindow_ = window;
+      std::fill(sketch_.begin(), sketch_.end(), 0);
+    }
+    // Increment one counter per row; the minimum is the estimate, which
+    // overcounts only if the key collides in every row
+    uint32_t estimate = std::numeric_limits<uint32_t>::max();
+    const size_t width = sketchMask_ + 1;
+    for (size_t row = 0; row < kSketchRows; ++row) {
+      const uint64_t hash =
+          folly::hash::SpookyHashV2::Hash64(key.data(), key.size(), row);
+      uint32_t& counter = sketch_[row * width + (hash & sketchMask_)];
+      if (counter < std::numeric_limits<uint32_t>::max()) {
+        ++counter;
+      }
+      estimate = std::min(estimate, counter);
+    }
+    return estimate <= defaultLimit_;
+  }
+
+  static constexpr size_t kSketchRows = 4;
+
+  const uint32_t defaultLimit_;
+  // Read-only after construction
+  std::unordered_map<std::string, size_t> keyIndex_;
+  std::vector<Bucket> buckets_;
+  // kSketchRows rows of sketchMask_+1 counters, wiped each window
+  std::vector<uint32_t> sketch_;
+  size_t sketchMask_{0};
+  int64_t sketchWindow_{-1};
+};
+
+/**
+ * Sends the 429 for a request the worker's limiter turned away.  The
+ * response goes out before any body is read, so rejected traffic never
+ * pays request assembly, and the status lands in the acceptor's
+ * TLResponseCodeStats like any other response.
+ */
+class RateLimitFilter : public Filter {
+ public:
+  explicit RateLimitFilter(RequestHandler* upstream) : Filter(upstream) {
+  }
+
+  void onRequest(std::unique_ptr<HTTPMessage> /*msg*/) noexcept override {
+    upstream_->onError(kErrorDropped);
+    upstream_ = nullptr;
+
+    ResponseBuilder(downstream_)
+        .status(429, "Too Many Requests")
+        .header(HTTP_HEADER_RETRY_AFTER, "1")
+        .sendWithEOM();
+  }
+
+  void onBody(std::unique_ptr<folly::IOBuf> /*body*/) noexcept override {
+  }
+
+  void onUpgrade(UpgradeProtocol /*protocol*/) noexcept override {
+  }
+
+  void onEOM() noexcept override {
+  }
+
+  void requestComplete() noexcept override {
+    CHECK(!upstream_);
+    delete this;
+  }
+
+  void onError(ProxygenError err) noexcept override {
+    // If onError is invoked before we forward the error
+    if (upstream_) {
+      upstream_->onError(err);
+      upstream_ = nullptr;
+    }
+
+    delete this;
+  }
+
+  void onEgressPaused() noexcept override {
+  }
+
+  void onEgressResumed() noexcept override {
+  }
+
+  // Response handler
+  void sendHeaders(HTTPMessage& /*msg*/) noexcept override {
+  }
+
+  void sendChunkHeader(size_t /*len*/) noexcept override {
+  }
+
+  void sendBody(std::unique_ptr<folly::IOBuf> /*body*/) noexcept override {
+  }
+
+  void sendChunkTerminator() noexcept override {
+  }
+
+  void sendEOM() noexcept override {
+  }
+
+  void sendAbort() noexcept override {
+  }
+
+  void refreshTimeout() noexcept override {
+  }
+};
+
+class RateLimitFilterFactory : public RequestHandlerFactory {
+ public:
+  struct Options {
+    RequestRateLimiter::Config limits;
+
+    /**
+     * Maps a request to its throttling key; defaults to the client IP.
+     * Runs before the handler chain, so it only sees headers.
+     */
+    std::function<std::string(const HTTPMessage&)> keyExtractor;
+  };
+
+  explicit RateLimitFilterFactory(Options options)
+      : options_(std::move(options)) {
+  }
+
+  void onServerStart(folly::EventBase* /*evb*/) noexcept override {
+    // One limiter per worker thread; all admission on a worker stays on
+    // its own instance, so no lock is ever taken
+    limiter_.reset(new RequestRateLimiter(options_.limits));
+  }
+
+  void onServerStop() noexcept override {
+    limiter_.reset();
+  }
+
+  RequestHandler* onRequest(RequestHandler* h,
+                            HTTPMessage* msg) noexcept override {
+    auto* limiter = limiter_.get();
+    if (!limiter) {
+      return h;
+    }
+    const auto key =
+        options_.keyExtractor ? options_.keyExtractor(*msg) : msg->getClientIP();
+    if (limiter->allow(key)) {
+      // No need to insert this filter
+      return h;
+    }
+    return new RateLimitFilter(h);
+  }
+
+ private:
+  Options options_;
+  folly::ThreadLocalPtr<RequestRateLimiter> limiter_;
+};
+
+} // namespace proxygen
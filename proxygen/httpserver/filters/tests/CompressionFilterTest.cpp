@@ -9,12 +9,15 @@
  */
 #include <folly/Conv.h>
 #include <folly/ScopeGuard.h>
+#include <folly/executors/InlineExecutor.h>
 #include <folly/io/IOBuf.h>
+#include <folly/io/async/EventBaseManager.h>
 
 #include <folly/portability/GMock.h>
 #include <folly/portability/GTest.h>
 #include <proxygen/httpserver/filters/CompressionFilter.h>
 #include <proxygen/lib/utils/ZlibStreamCompressor.h>
+#include <proxygen/lib/utils/ZstdStreamDecompressor.h>
 #include <proxygen/httpserver/Mocks.h>
 #include <proxygen/httpserver/ResponseBuilder.h>
 
@@ -64,7 +67,13 @@ class CompressionFilterTest : public Test {
                             std::unique_ptr<folly::IOBuf> originalResponseBody,
                             int32_t compressionLevel = 4,
                             uint32_t minimumCompressionSize = 1,
-                            bool sendCompressedResponse = false) {
+                            bool sendCompressedResponse = false,
+                            bool offload = false) {
+
+    // The fixture's decompressor defaults to gzip
+    if (expectedEncoding == "zstd") {
+      zd_ = std::make_unique<ZstdStreamDecompressor>();
+    }
 
     // If there is only one IOBuf, then it's not chunked.
     bool isResponseChunked = originalResponseBody->isChained();
@@ -150,6 +159,13 @@ class CompressionFilterTest : public Test {
     opts.zlibCompressionLevel = compressionLevel;
     opts.minimumCompressionSize = minimumCompressionSize;
     opts.compressibleContentTypes = compressibleTypes;
+    opts.enableZstd = true;
+    if (offload) {
+      // Compress inline but re-inject through the event base, same as a
+      // real CPU executor would
+      opts.compressionOffloadExecutor = &folly::InlineExecutor::instance();
+      opts.compressionOffloadThreshold = 1;
+    }
     auto filterFactory = std::make_unique<CompressionFilterFactory>(opts);
 
     auto filter = filterFactory->onRequest(requestHandler_, &msg);
@@ -194,6 +210,11 @@ class CompressionFilterTest : public Test {
           .sendWithEOM();
     }
 
+    if (offload) {
+      // Drain the re-injection callbacks before tearing the filter down
+      folly::EventBaseManager::get()->getEventBase()->loop();
+    }
+
     filter->requestComplete();
 
     EXPECT_THAT(responseBody, IOBufEquals(originalRequestBody));
@@ -245,6 +266,78 @@ TEST_F(CompressionFilterTest, ChunkedCompression) {
   });
 }
 
+TEST_F(CompressionFilterTest, NonchunkedZstdCompression) {
+  ASSERT_NO_FATAL_FAILURE({
+    exercise_compression(true,
+                         std::string("http://locahost/foo.compressme"),
+                         std::string("zstd"),
+                         std::string("zstd"),
+                         std::string("Hello World"),
+                         std::string("text/html"),
+                         folly::IOBuf::copyBuffer("Hello World"));
+  });
+}
+
+TEST_F(CompressionFilterTest, ChunkedZstdCompression) {
+  std::vector<std::string> chunks = {"Hello", " World"};
+  ASSERT_NO_FATAL_FAILURE({
+    exercise_compression(true,
+                         std::string("http://locahost/foo.compressme"),
+                         std::string("zstd"),
+                         std::string("zstd"),
+                         std::string("Hello World"),
+                         std::string("text/html"),
+                         createResponseChain(chunks));
+  });
+}
+
+// Zstd is preferred when the client accepts both
+TEST_F(CompressionFilterTest, ZstdPreferredOverGzip) {
+  ASSERT_NO_FATAL_FAILURE({
+    exercise_compression(true,
+                         std::string("http://locahost/foo.compressme"),
+                         std::string("gzip, zstd"),
+                         std::string("zstd"),
+                         std::string("Hello World"),
+                         std::string("text/html"),
+                         folly::IOBuf::copyBuffer("Hello World"));
+  });
+}
+
+// Every chunk clears the threshold, so the whole body rides the offload queue
+TEST_F(CompressionFilterTest, NonchunkedOffloadCompression) {
+  ASSERT_NO_FATAL_FAILURE({
+    exercise_compression(true,
+                         std::string("http://locahost/foo.compressme"),
+                         std::string("gzip"),
+                         std::string("gzip"),
+                         std::string("Hello World"),
+                         std::string("text/html"),
+                         folly::IOBuf::copyBuffer("Hello World"),
+                         4,
+                         1,
+                         false,
+                         true /*offload*/);
+  });
+}
+
+TEST_F(CompressionFilterTest, ChunkedOffloadCompression) {
+  std::vector<std::string> chunks = {"Hello", " World"};
+  ASSERT_NO_FATAL_FAILURE({
+    exercise_compression(true,
+                         std::string("http://locahost/foo.compressme"),
+                         std::string("gzip"),
+                         std::string("gzip"),
+                         std::string("Hello World"),
+                         std::string("text/html"),
+                         createResponseChain(chunks),
+                         4,
+                         1,
+                         false,
+                         true /*offload*/);
+  });
+}
+
 TEST_F(CompressionFilterTest, ParameterizedContenttype) {
   ASSERT_NO_FATAL_FAILURE({
     exercise_compression(true,
@@ -395,6 +488,88 @@ TEST_F(CompressionFilterTest, SmallChunksCompress) {
   });
 }
 
+// A declared body size below the minimum disables compression even on
+// chunked responses, which otherwise always compress because their
+// length is unknown at headers time
+TEST_F(CompressionFilterTest, SmallChunksWithSizeHintDontCompress) {
+  ASSERT_NO_FATAL_FAILURE({
+    // Request Handler Expectations
+    EXPECT_CALL(*requestHandler_, onBody(_)).Times(1);
+    EXPECT_CALL(*requestHandler_, onEOM()).Times(1);
+
+    EXPECT_CALL(*requestHandler_, setResponseHandler(_))
+        .WillOnce(DoAll(SaveArg<0>(&downstream_), Return()));
+
+    // Response Handler Expectations
+    EXPECT_CALL(*responseHandler_, sendHeaders(_)).WillOnce(DoAll(
+        Invoke([&](HTTPMessage& msg) {
+          EXPECT_TRUE(msg.getHeaders()
+                          .getSingleOrEmpty(HTTP_HEADER_CONTENT_ENCODING)
+                          .empty());
+          EXPECT_TRUE(msg.getIsChunked());
+        }),
+        Return()));
+
+    EXPECT_CALL(*responseHandler_, sendChunkHeader(_)).Times(2);
+    EXPECT_CALL(*responseHandler_, sendChunkTerminator()).Times(2);
+
+    std::unique_ptr<folly::IOBuf> responseBody;
+    EXPECT_CALL(*responseHandler_, sendBody(_))
+        .Times(2)
+        .WillRepeatedly(DoAll(
+            Invoke([&](std::shared_ptr<folly::IOBuf> body) {
+              auto plainBody = folly::IOBuf::copyBuffer(
+                  body->data(), body->length(), 0, 0);
+              if (responseBody) {
+                responseBody->prependChain(std::move(plainBody));
+              } else {
+                responseBody = std::move(plainBody);
+              }
+            }),
+            Return()));
+
+    EXPECT_CALL(*responseHandler_, sendEOM()).Times(1);
+
+    /* Simulate Request/Response */
+
+    HTTPMessage msg;
+    msg.setURL("http://locahost/foo.smallfry");
+    msg.getHeaders().set(HTTP_HEADER_ACCEPT_ENCODING, "gzip");
+
+    CompressionFilterFactory::Options opts;
+    opts.minimumCompressionSize = 1000;
+    opts.compressibleContentTypes = {"text/html"};
+    auto filterFactory = std::make_unique<CompressionFilterFactory>(opts);
+
+    auto filter = filterFactory->onRequest(requestHandler_, &msg);
+    filter->setResponseHandler(responseHandler_.get());
+
+    // Send fake request
+    filter->onBody(folly::IOBuf::copyBuffer("Hello World"));
+    filter->onEOM();
+
+    // Send a chunked response declaring its total size up front
+    ResponseBuilder(downstream_)
+        .status(200, "OK")
+        .header(HTTP_HEADER_CONTENT_TYPE, "text/html")
+        .bodySizeHint(11)
+        .send();
+
+    ResponseBuilder(downstream_)
+        .body(folly::IOBuf::copyBuffer("Hello"))
+        .send();
+    ResponseBuilder(downstream_)
+        .body(folly::IOBuf::copyBuffer(" World"))
+        .send();
+
+    ResponseBuilder(downstream_).sendWithEOM();
+
+    filter->requestComplete();
+
+    EXPECT_THAT(responseBody, IOBufEquals(std::string("Hello World")));
+  });
+}
+
 TEST_F(CompressionFilterTest, MinimumCompressSizeEqualToRequestSize){
   auto requestBody = std::string("Hello World");
   ASSERT_NO_FATAL_FAILURE({
@@ -455,6 +630,7 @@ TEST_F(CompressionFilterTest, NoResponseBody){
     opts.zlibCompressionLevel = compressionLevel;
     opts.minimumCompressionSize = minimumCompressionSize;
     opts.compressibleContentTypes = compressibleTypes;
+    opts.enableZstd = true;
     auto filterFactory = std::make_unique<CompressionFilterFactory>(opts);
 
     auto filter = filterFactory->onRequest(requestHandler_, &msg);
@@ -0,0 +1,154 @@
+/*
+ *  Copyright (c) 2015-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include <folly/io/IOBuf.h>
+#include <folly/portability/GMock.h>
+#include <folly/portability/GTest.h>
+#include <proxygen/httpserver/Mocks.h>
+#include <proxygen/httpserver/filters/DecompressionFilter.h>
+#include <proxygen/lib/utils/ZlibStreamCompressor.h>
+
+using namespace proxygen;
+using namespace testing;
+
+class DecompressionFilterTest : public Test {
+ public:
+  void SetUp() override {
+    requestHandler_ = new MockRequestHandler();
+    responseHandler_ = std::make_unique<MockResponseHandler>(requestHandler_);
+  }
+
+  void TearDown() override {
+    Mock::VerifyAndClear(requestHandler_);
+    Mock::VerifyAndClear(responseHandler_.get());
+
+    delete requestHandler_;
+  }
+
+ protected:
+  MockRequestHandler* requestHandler_;
+  std::unique_ptr<MockResponseHandler> responseHandler_;
+
+  static std::unique_ptr<HTTPMessage> makeRequest(
+      const std::string& encoding) {
+    auto msg = std::make_unique<HTTPMessage>();
+    msg->setURL("http://localhost/upload");
+    if (!encoding.empty()) {
+      msg->getHeaders().set(HTTP_HEADER_CONTENT_ENCODING, encoding);
+    }
+    return msg;
+  }
+
+  static std::unique_ptr<folly::IOBuf> gzipCompress(
+      const std::string& plain) {
+    ZlibStreamCompressor zc(CompressionType::GZIP, 4);
+    auto compressed = zc.compress(folly::IOBuf::copyBuffer(plain).get(), true);
+    CHECK(!zc.hasError());
+    return compressed;
+  }
+};
+
+TEST_F(DecompressionFilterTest, GzipRequestBodyDecompressed) {
+  std::string plainBody = "Hello World";
+
+  EXPECT_CALL(*requestHandler_, setResponseHandler(_)).Times(1);
+  EXPECT_CALL(*requestHandler_, onRequest(_))
+      .WillOnce(Invoke([](std::shared_ptr<HTTPMessage> msg) {
+        // The handler must see a plain request
+        EXPECT_FALSE(msg->getHeaders().exists(HTTP_HEADER_CONTENT_ENCODING));
+        EXPECT_FALSE(msg->getHeaders().exists(HTTP_HEADER_CONTENT_LENGTH));
+      }));
+
+  std::string receivedBody;
+  EXPECT_CALL(*requestHandler_, onBody(_))
+      .WillRepeatedly(Invoke([&](std::shared_ptr<folly::IOBuf> body) {
+        auto br = body->coalesce();
+        receivedBody.append((const char*)br.data(), br.size());
+      }));
+  EXPECT_CALL(*requestHandler_, onEOM()).Times(1);
+  EXPECT_CALL(*requestHandler_, requestComplete()).Times(1);
+
+  DecompressionFilterFactory factory;
+  auto msg = makeRequest("gzip");
+  RequestHandler* filter = factory.onRequest(requestHandler_, msg.get());
+  ASSERT_NE(filter, requestHandler_);
+  filter->setResponseHandler(responseHandler_.get());
+
+  filter->onRequest(std::move(msg));
+  filter->onBody(gzipCompress(plainBody));
+  filter->onEOM();
+  filter->requestComplete();
+
+  EXPECT_EQ(receivedBody, plainBody);
+}
+
+TEST_F(DecompressionFilterTest, UnencodedRequestPassesThrough) {
+  DecompressionFilterFactory factory;
+  auto msg = makeRequest("");
+  EXPECT_EQ(factory.onRequest(requestHandler_, msg.get()), requestHandler_);
+
+  msg = makeRequest("br");
+  EXPECT_EQ(factory.onRequest(requestHandler_, msg.get()), requestHandler_);
+}
+
+TEST_F(DecompressionFilterTest, DecompressionBombRejected) {
+  // 1MB of 'a' compresses far past a 10:1 expansion ratio
+  std::string plainBody(1024 * 1024, 'a');
+
+  EXPECT_CALL(*requestHandler_, setResponseHandler(_)).Times(1);
+  EXPECT_CALL(*requestHandler_, onRequest(_)).Times(1);
+  // The handler never sees the bomb's body or an EOM
+  EXPECT_CALL(*requestHandler_, onBody(_)).Times(0);
+  EXPECT_CALL(*requestHandler_, onEOM()).Times(0);
+  EXPECT_CALL(*requestHandler_, requestComplete()).Times(1);
+
+  // The filter answers 413 on the handler's behalf
+  EXPECT_CALL(*responseHandler_, sendHeaders(_))
+      .WillOnce(Invoke([](HTTPMessage& msg) {
+        EXPECT_EQ(msg.getStatusCode(), 413);
+      }));
+  EXPECT_CALL(*responseHandler_, sendEOM()).Times(1);
+
+  DecompressionFilterFactory::Options opts;
+  opts.maxCompressionRatio = 10;
+  DecompressionFilterFactory factory(opts);
+
+  auto msg = makeRequest("gzip");
+  RequestHandler* filter = factory.onRequest(requestHandler_, msg.get());
+  filter->setResponseHandler(responseHandler_.get());
+
+  filter->onRequest(std::move(msg));
+  filter->onBody(gzipCompress(plainBody));
+  filter->onEOM();
+  filter->requestComplete();
+}
+
+TEST_F(DecompressionFilterTest, CorruptBodyRejected) {
+  EXPECT_CALL(*requestHandler_, setResponseHandler(_)).Times(1);
+  EXPECT_CALL(*requestHandler_, onRequest(_)).Times(1);
+  EXPECT_CALL(*requestHandler_, onBody(_)).Times(0);
+  EXPECT_CALL(*requestHandler_, onEOM()).Times(0);
+  EXPECT_CALL(*requestHandler_, requestComplete()).Times(1);
+
+  EXPECT_CALL(*responseHandler_, sendHeaders(_))
+      .WillOnce(Invoke([](HTTPMessage& msg) {
+        EXPECT_EQ(msg.getStatusCode(), 400);
+      }));
+  EXPECT_CALL(*responseHandler_, sendEOM()).Times(1);
+
+  DecompressionFilterFactory factory;
+  auto msg = makeRequest("gzip");
+  RequestHandler* filter = factory.onRequest(requestHandler_, msg.get());
+  filter->setResponseHandler(responseHandler_.get());
+
+  filter->onRequest(std::move(msg));
+  filter->onBody(folly::IOBuf::copyBuffer("this is not a gzip stream"));
+  filter->onEOM();
+  filter->requestComplete();
+}
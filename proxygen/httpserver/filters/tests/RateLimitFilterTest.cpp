@@ -0,0 +1,67 @@
+/*
+ *  Copyright (c) 2015-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include <folly/portability/GTest.h>
+#include <proxygen/httpserver/filters/RateLimitFilter.h>
+
+using namespace proxygen;
+
+using Clock = RequestRateLimiter::Clock;
+
+TEST(RequestRateLimiter, ConfiguredKeyTokenBucket) {
+  RequestRateLimiter::Config config;
+  config.keyLimits = {{"tenant-a", 2}};
+  RequestRateLimiter limiter(config);
+  const auto now = Clock::now();
+
+  // Burst defaults to the per-second limit
+  EXPECT_TRUE(limiter.allow("tenant-a", now));
+  EXPECT_TRUE(limiter.allow("tenant-a", now));
+  EXPECT_FALSE(limiter.allow("tenant-a", now));
+
+  // Half a second refills one token at 2/sec
+  EXPECT_TRUE(limiter.allow("tenant-a", now + std::chrono::milliseconds(500)));
+  EXPECT_FALSE(limiter.allow("tenant-a", now + std::chrono::milliseconds(500)));
+
+  // Unconfigured keys are unlimited when defaultLimit is 0
+  for (int i = 0; i < 100; i++) {
+    EXPECT_TRUE(limiter.allow("tenant-b", now));
+  }
+}
+
+TEST(RequestRateLimiter, SketchLimitsUnconfiguredKeys) {
+  RequestRateLimiter::Config config;
+  config.defaultLimit = 3;
+  RequestRateLimiter limiter(config);
+  const auto now = Clock::now();
+
+  for (int i = 0; i < 3; i++) {
+    EXPECT_TRUE(limiter.allow("10.0.0.1", now));
+  }
+  EXPECT_FALSE(limiter.allow("10.0.0.1", now));
+
+  // A distinct key (no full-row collision at this width) is unaffected
+  EXPECT_TRUE(limiter.allow("10.0.0.2", now));
+
+  // The sketch is wiped at the window boundary
+  EXPECT_TRUE(limiter.allow("10.0.0.1", now + std::chrono::seconds(1)));
+}
+
+TEST(RequestRateLimiter, BurstOverridesBucketDepth) {
+  RequestRateLimiter::Config config;
+  config.keyLimits = {{"tenant-a", 1}};
+  config.burst = 5;
+  RequestRateLimiter limiter(config);
+  const auto now = Clock::now();
+
+  for (int i = 0; i < 5; i++) {
+    EXPECT_TRUE(limiter.allow("tenant-a", now));
+  }
+  EXPECT_FALSE(limiter.allow("tenant-a", now));
+}
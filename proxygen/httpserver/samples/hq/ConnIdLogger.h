@@ -13,9 +13,10 @@
 
 #include <folly/Conv.h>
 #include <folly/File.h>
+#include <folly/Optional.h>
+#include <folly/Range.h>
 #include <folly/Synchronized.h>
 #include <memory>
-#include <regex>
 #include <string>
 
 #include <proxygen/httpserver/samples/hq/HQParams.h>
@@ -38,9 +39,9 @@ struct ConnIdLogSink : google::LogSink {
             const char* message,
             size_t message_len) override {
     folly::StringPiece testMsg(message, message_len);
-    std::match_results<const char*> cidMatch;
-    if (std::regex_match(testMsg.begin(), testMsg.end(), cidMatch, cidRegex_)) {
-      auto cid = cidMatch[1].str();
+    auto cidPiece = findCid(testMsg);
+    if (cidPiece) {
+      auto cid = cidPiece->str();
       int fd = -1;
       {
         auto now = std::chrono::system_clock::now();
@@ -73,9 +74,9 @@ struct ConnIdLogSink : google::LogSink {
                                         ':',
                                         line,
                                         ' ',
-                                        testMsg);
+                                        testMsg,
+                                        "<br/>");
       FOLLY_MAYBE_UNUSED auto writeRes = ::write(fd, msg.c_str(), msg.size());
-      writeRes = ::write(fd, "<br/>", 5);
     } // else, not for a specific CID
   }
 
@@ -86,6 +87,31 @@ struct ConnIdLogSink : google::LogSink {
  private:
   using FdMap = std::map<std::string, FileEntry>;
 
+  /**
+   * Extracts the connection id following " CID=": a run of lowercase hex
+   * digits terminated by ',' or ' '.  Hand rolled because running a
+   * std::regex over every log line dominated the cost of sinking.
+   */
+  static folly::Optional<folly::StringPiece> findCid(folly::StringPiece msg) {
+    const folly::StringPiece kTag{" CID="};
+    auto pos = msg.find(kTag);
+    while (pos != std::string::npos) {
+      auto start = pos + kTag.size();
+      auto end = start;
+      while (end < msg.size() &&
+             ((msg[end] >= '0' && msg[end] <= '9') ||
+              (msg[end] >= 'a' && msg[end] <= 'f'))) {
+        end++;
+      }
+      if (end > start && end < msg.size() &&
+          (msg[end] == ',' || msg[end] == ' ')) {
+        return msg.subpiece(start, end - start);
+      }
+      pos = msg.find(kTag, start);
+    }
+    return folly::none;
+  }
+
   void closeOldFds(FdMap& fdMap, std::chrono::system_clock::time_point now) {
     // Close any logfiles open for > 1 min
     for (auto it = fdMap.begin(); it != fdMap.end();) {
@@ -100,7 +126,6 @@ struct ConnIdLogSink : google::LogSink {
 
   std::string logDir_;
   std::string prefix_;
-  std::regex cidRegex_{".* CID=([a-f0-9]+)[, ].*"};
   folly::Synchronized<FdMap> fdMap_;
   std::array<char, 5> severityMap{{'V', 'I', 'W', 'E', 'F'}};
   const std::chrono::seconds kMaxAge{60};
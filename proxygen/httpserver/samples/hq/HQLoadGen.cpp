@@ -0,0 +1,376 @@
+/*
+ *  Copyright (c) 2019-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include <proxygen/httpserver/samples/hq/HQLoadGen.h>
+
+#include <algorithm>
+#include <thread>
+#include <utility>
+
+#include <folly/Random.h>
+#include <folly/String.h>
+
+#include <proxygen/httpserver/samples/hq/FizzContext.h>
+#include <proxygen/httpserver/samples/hq/InsecureVerifierDangerousDoNotUseInProduction.h>
+#include <quic/api/QuicSocket.h>
+#include <quic/client/QuicClientTransport.h>
+#include <quic/congestion_control/CongestionControllerFactory.h>
+
+namespace quic { namespace samples {
+
+using std::chrono::duration_cast;
+using std::chrono::microseconds;
+using std::chrono::steady_clock;
+
+RequestMix::RequestMix(const HQParams& params) {
+  auto addRequest = [&](folly::StringPiece path, uint32_t weight) {
+    proxygen::HTTPMessage request;
+    request.setMethod(proxygen::HTTPMethod::GET);
+    request.setHTTPVersion(params->httpVersion.major,
+                           params->httpVersion.minor);
+    request.setURL(path.str());
+    request.setSecure(true);
+    // Host is already set by initializeHttpSettings
+    request.getHeaders() = params->httpHeaders;
+    totalWeight_ += weight;
+    requests_.push_back(std::move(request));
+    cumulativeWeights_.push_back(totalWeight_);
+  };
+
+  std::vector<folly::StringPiece> entries;
+  folly::split(',', params->loadMixString, entries, /*ignoreEmpty=*/true);
+  for (auto entry : entries) {
+    uint32_t weight = 1;
+    auto pos = entry.rfind(':');
+    if (pos != folly::StringPiece::npos) {
+      weight = std::max(folly::to<uint32_t>(entry.subpiece(pos + 1)), 1u);
+      entry = entry.subpiece(0, pos);
+    }
+    addRequest(entry, weight);
+  }
+  if (requests_.empty()) {
+    for (auto path : params->httpPaths) {
+      addRequest(path, 1);
+    }
+  }
+  CHECK(!requests_.empty()) << "RequestMix needs at least one path";
+}
+
+const proxygen::HTTPMessage& RequestMix::pick() const {
+  if (requests_.size() == 1) {
+    return requests_.front();
+  }
+  auto roll = folly::Random::rand32(totalWeight_);
+  auto it = std::upper_bound(
+      cumulativeWeights_.begin(), cumulativeWeights_.end(), roll);
+  return requests_[it - cumulativeWeights_.begin()];
+}
+
+void LoadTxnHandler::begin(proxygen::HTTPTransaction* txn,
+                           const proxygen::HTTPMessage& request) {
+  failed_ = false;
+  startTime_ = steady_clock::now();
+  txn->sendHeadersWithEOM(request);
+}
+
+void LoadTxnHandler::setTransaction(proxygen::HTTPTransaction* txn) noexcept {
+  txn_ = txn;
+}
+
+void LoadTxnHandler::detachTransaction() noexcept {
+  txn_ = nullptr;
+  worker_.recycle(this);
+}
+
+void LoadTxnHandler::onHeadersComplete(
+    std::unique_ptr<proxygen::HTTPMessage> /*msg*/) noexcept {
+}
+
+void LoadTxnHandler::onBody(std::unique_ptr<folly::IOBuf> /*chain*/) noexcept {
+  // The body is dropped on the floor; this tool measures the server and
+  // the transport, not the client's ability to consume payloads
+}
+
+void LoadTxnHandler::onChunkHeader(size_t /*length*/) noexcept {
+}
+
+void LoadTxnHandler::onChunkComplete() noexcept {
+}
+
+void LoadTxnHandler::onTrailers(
+    std::unique_ptr<proxygen::HTTPHeaders> /*trailers*/) noexcept {
+}
+
+void LoadTxnHandler::onEOM() noexcept {
+  auto latency = duration_cast<microseconds>(steady_clock::now() - startTime_);
+  worker_.recordResponse(latency.count());
+}
+
+void LoadTxnHandler::onUpgrade(proxygen::UpgradeProtocol /*protocol*/) noexcept {
+}
+
+void LoadTxnHandler::onError(const proxygen::HTTPException& error) noexcept {
+  if (!failed_) {
+    failed_ = true;
+    VLOG(4) << "request error: " << error.what();
+    worker_.recordError();
+  }
+}
+
+void LoadTxnHandler::onEgressPaused() noexcept {
+}
+
+void LoadTxnHandler::onEgressResumed() noexcept {
+}
+
+HQLoadConnection::HQLoadConnection(HQLoadWorker& worker,
+                                   const HQParams& params,
+                                   folly::EventBase* evb,
+                                   TimerHighRes::SharedPtr pacingTimer)
+    : worker_(worker),
+      params_(params),
+      evb_(evb),
+      pacingTimer_(std::move(pacingTimer)) {
+}
+
+void HQLoadConnection::connect() {
+  // Same transport recipe as HQClient::initializeQuicClient, minus the
+  // qlogger: per-packet logging defeats the purpose of a load driver
+  auto sock = std::make_unique<folly::AsyncUDPSocket>(evb_);
+  auto client =
+      std::make_shared<quic::QuicClientTransport>(evb_, std::move(sock));
+  client->setPacingTimer(pacingTimer_);
+  client->setHostname(params_->host);
+  client->setFizzClientContext(createFizzClientContext(params_));
+  // This is only for testing, this should not be use in prod
+  client->setCertificateVerifier(
+      std::make_unique<
+          proxygen::InsecureVerifierDangerousDoNotUseInProduction>());
+  client->addNewPeerAddress(params_->remoteAddress.value());
+  client->setCongestionControllerFactory(
+      std::make_shared<quic::DefaultCongestionControllerFactory>());
+  client->setTransportSettings(params_->transportSettings);
+  client->setSupportedVersions(params_->quicVersions);
+  client->setPskCache(params_->pskCache);
+  quicClient_ = std::move(client);
+
+  wangle::TransportInfo tinfo;
+  session_ = new proxygen::HQUpstreamSession(params_->txnTimeout,
+                                             std::chrono::milliseconds(2000),
+                                             nullptr, // controller
+                                             tinfo,
+                                             nullptr);
+  session_->setForceUpstream1_1(false);
+  session_->setSocket(quicClient_);
+  session_->setConnectCallback(this);
+  session_->setInfoCallback(this);
+  session_->startNow();
+  quicClient_->start(session_);
+}
+
+proxygen::HTTPTransaction* FOLLY_NULLABLE
+HQLoadConnection::newTransaction(proxygen::HTTPTransactionHandler* handler) {
+  if (!session_ || !connected_) {
+    return nullptr;
+  }
+  return session_->newTransaction(handler);
+}
+
+void HQLoadConnection::close() {
+  if (session_) {
+    session_->drain();
+    session_->closeWhenIdle();
+  }
+}
+
+void HQLoadConnection::connectSuccess() {
+  connected_ = true;
+}
+
+void HQLoadConnection::onReplaySafe() {
+  VLOG(10) << "Transport replay safe";
+}
+
+void HQLoadConnection::connectError(
+    std::pair<quic::QuicErrorCode, std::string> error) {
+  LOG(ERROR) << "HQLoadConnection failed to connect, error="
+             << toString(error.first) << ", msg=" << error.second;
+  worker_.recordConnectError();
+}
+
+void HQLoadConnection::onDestroy(const proxygen::HTTPSessionBase&) {
+  session_ = nullptr;
+  connected_ = false;
+}
+
+HQLoadWorker::HQLoadWorker(const HQParams& params,
+                           const RequestMix& mix,
+                           uint64_t requestsPerSecond,
+                           proxygen::SparseHistogram& latencyUsec)
+    : params_(params),
+      mix_(mix),
+      latencyUsec_(latencyUsec),
+      rate_(requestsPerSecond) {
+  // The base AsyncTimeout would run before evb_ is constructed, so attach
+  // here instead of in the initializer list
+  attachEventBase(&evb_);
+  if (params->transportSettings.pacingEnabled) {
+    pacingTimer_ = TimerHighRes::newTimer(
+        &evb_, params->transportSettings.pacingTimerTickInterval);
+  }
+}
+
+void HQLoadWorker::run() {
+  handlerStorage_.reserve(params_->loadMaxOutstanding);
+  idleHandlers_.reserve(params_->loadMaxOutstanding);
+  for (uint32_t i = 0; i < params_->loadMaxOutstanding; i++) {
+    handlerStorage_.push_back(std::make_unique<LoadTxnHandler>(*this));
+    idleHandlers_.push_back(handlerStorage_.back().get());
+  }
+
+  connections_.reserve(params_->loadConnections);
+  for (uint32_t i = 0; i < params_->loadConnections; i++) {
+    connections_.push_back(std::make_unique<HQLoadConnection>(
+        *this, params_, &evb_, pacingTimer_));
+    connections_.back()->connect();
+  }
+
+  lastTick_ = steady_clock::now();
+  deadline_ = lastTick_ + params_->loadDuration;
+  scheduleTimeout(1);
+  evb_.loop();
+}
+
+void HQLoadWorker::recordResponse(uint64_t latencyUsec) {
+  latencyUsec_.record(latencyUsec);
+  counters_.responses++;
+}
+
+void HQLoadWorker::recordError() {
+  counters_.errors++;
+}
+
+void HQLoadWorker::recordConnectError() {
+  counters_.connectErrors++;
+}
+
+void HQLoadWorker::recycle(LoadTxnHandler* handler) {
+  idleHandlers_.push_back(handler);
+}
+
+void HQLoadWorker::timeoutExpired() noexcept {
+  auto now = steady_clock::now();
+  if (now >= deadline_) {
+    shutdown();
+    return;
+  }
+  // Open loop: arrivals are a function of elapsed time only, never of how
+  // many responses came back
+  creditUsec_ += duration_cast<microseconds>(now - lastTick_).count() * rate_;
+  lastTick_ = now;
+  while (creditUsec_ >= 1000000) {
+    creditUsec_ -= 1000000;
+    sendOne();
+  }
+  scheduleTimeout(1);
+}
+
+void HQLoadWorker::sendOne() {
+  if (idleHandlers_.empty()) {
+    counters_.shed++;
+    return;
+  }
+  auto* handler = idleHandlers_.back();
+  for (size_t i = 0; i < connections_.size(); i++) {
+    auto& conn = *connections_[nextConnection_];
+    nextConnection_ = (nextConnection_ + 1) % connections_.size();
+    auto* txn = conn.newTransaction(handler);
+    if (!txn) {
+      continue;
+    }
+    idleHandlers_.pop_back();
+    handler->begin(txn, mix_.pick());
+    counters_.requestsSent++;
+    return;
+  }
+  // No connection could take the request; shed it and move on
+  counters_.shed++;
+}
+
+void HQLoadWorker::shutdown() {
+  for (auto& conn : connections_) {
+    conn->close();
+  }
+  // Give drains a moment to collect straggling responses, then cut the
+  // loop; anything still in flight stays unaccounted, as it should be at
+  // the end of a fixed-duration run
+  evb_.runAfterDelay([this] { evb_.terminateLoopSoon(); }, 500);
+}
+
+void startLoadGen(const HQParams& params) {
+  RequestMix mix(params);
+  proxygen::SparseHistogram latencyUsec;
+
+  auto numThreads = std::max<uint32_t>(params->loadThreads, 1);
+  auto rps = params->loadRequestsPerSecond;
+  std::vector<std::unique_ptr<HQLoadWorker>> workers;
+  workers.reserve(numThreads);
+  for (uint32_t i = 0; i < numThreads; i++) {
+    // Spread the target rate evenly; the first workers absorb the remainder
+    uint64_t rate = rps / numThreads + (i < rps % numThreads ? 1 : 0);
+    workers.push_back(
+        std::make_unique<HQLoadWorker>(params, mix, rate, latencyUsec));
+  }
+
+  LOG(INFO) << "Load generating " << rps << " rps across " << numThreads
+            << " threads x " << params->loadConnections << " connections for "
+            << params->loadDuration.count() << "s against "
+            << params->remoteAddress->describe();
+
+  auto start = steady_clock::now();
+  std::vector<std::thread> threads;
+  threads.reserve(numThreads);
+  for (auto& worker : workers) {
+    threads.emplace_back([&worker] { worker->run(); });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  double seconds =
+      duration_cast<microseconds>(steady_clock::now() - start).count() / 1e6;
+
+  HQLoadWorker::Counters total;
+  for (const auto& worker : workers) {
+    const auto& c = worker->counters();
+    total.requestsSent += c.requestsSent;
+    total.responses += c.responses;
+    total.errors += c.errors;
+    total.shed += c.shed;
+    total.connectErrors += c.connectErrors;
+  }
+
+  LOG(INFO) << "Load complete: sent=" << total.requestsSent
+            << " responses=" << total.responses << " errors=" << total.errors
+            << " shed=" << total.shed
+            << " connect_errors=" << total.connectErrors;
+  LOG(INFO) << "Achieved "
+            << (seconds > 0 ? total.responses / seconds : 0.0)
+            << " responses/sec over " << seconds << "s";
+
+  auto snapshot = latencyUsec.getSnapshot();
+  if (snapshot.totalCount > 0) {
+    LOG(INFO) << "Latency usec: avg=" << snapshot.sum / snapshot.totalCount
+              << " p50=" << snapshot.estimatePercentile(50)
+              << " p90=" << snapshot.estimatePercentile(90)
+              << " p99=" << snapshot.estimatePercentile(99)
+              << " p99.9=" << snapshot.estimatePercentile(99.9);
+  }
+}
+
+}} // namespace quic::samples
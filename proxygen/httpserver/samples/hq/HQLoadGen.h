@@ -0,0 +1,199 @@
+/*
+ *  Copyright (c) 2019-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#pragma once
+
+#include <chrono>
+#include <memory>
+#include <vector>
+
+#include <folly/io/async/AsyncTimeout.h>
+#include <folly/io/async/EventBase.h>
+#include <proxygen/httpserver/samples/hq/HQParams.h>
+#include <proxygen/lib/http/session/HQUpstreamSession.h>
+#include <proxygen/lib/stats/SparseHistogram.h>
+#include <quic/common/Timers.h>
+
+namespace quic {
+
+class QuicClientTransport;
+
+namespace samples {
+
+class HQLoadWorker;
+
+/**
+ * Weighted set of requests parsed once at startup from --load_mix
+ * ("path[:weight],..."; empty falls back to --path with equal weights).
+ * The HTTPMessages are fully built here so the send path only copies
+ * headers into the codec and never touches strings or gflags.
+ */
+class RequestMix {
+ public:
+  explicit RequestMix(const HQParams& params);
+
+  const proxygen::HTTPMessage& pick() const;
+
+ private:
+  std::vector<proxygen::HTTPMessage> requests_;
+  std::vector<uint32_t> cumulativeWeights_;
+  uint32_t totalWeight_{0};
+};
+
+/**
+ * Pooled transaction handler. A worker preallocates --load_max_outstanding
+ * of these; begin() stamps the start time and sends the request, the
+ * response latency is recorded on EOM, and detachTransaction() returns the
+ * handler to the worker's free list, so steady-state load runs without any
+ * per-request allocation in the driver.
+ */
+class LoadTxnHandler : public proxygen::HTTPTransactionHandler {
+ public:
+  explicit LoadTxnHandler(HQLoadWorker& worker) : worker_(worker) {
+  }
+
+  void begin(proxygen::HTTPTransaction* txn,
+             const proxygen::HTTPMessage& request);
+
+  // HTTPTransactionHandler
+  void setTransaction(proxygen::HTTPTransaction* txn) noexcept override;
+  void detachTransaction() noexcept override;
+  void onHeadersComplete(
+      std::unique_ptr<proxygen::HTTPMessage> msg) noexcept override;
+  void onBody(std::unique_ptr<folly::IOBuf> chain) noexcept override;
+  void onChunkHeader(size_t length) noexcept override;
+  void onChunkComplete() noexcept override;
+  void onTrailers(
+      std::unique_ptr<proxygen::HTTPHeaders> trailers) noexcept override;
+  void onEOM() noexcept override;
+  void onUpgrade(proxygen::UpgradeProtocol protocol) noexcept override;
+  void onError(const proxygen::HTTPException& error) noexcept override;
+  void onEgressPaused() noexcept override;
+  void onEgressResumed() noexcept override;
+
+ private:
+  HQLoadWorker& worker_;
+  proxygen::HTTPTransaction* txn_{nullptr};
+  std::chrono::steady_clock::time_point startTime_;
+  bool failed_{false};
+};
+
+/**
+ * One upstream h3 connection owned by a worker. The transport setup
+ * mirrors HQClient; the connection only reports readiness and hands out
+ * transactions, all driving is done by the worker.
+ */
+class HQLoadConnection
+    : private proxygen::HQSession::ConnectCallback
+    , private proxygen::HTTPSessionBase::InfoCallback {
+ public:
+  HQLoadConnection(HQLoadWorker& worker,
+                   const HQParams& params,
+                   folly::EventBase* evb,
+                   TimerHighRes::SharedPtr pacingTimer);
+
+  ~HQLoadConnection() override = default;
+
+  void connect();
+
+  proxygen::HTTPTransaction* FOLLY_NULLABLE
+  newTransaction(proxygen::HTTPTransactionHandler* handler);
+
+  bool connected() const {
+    return connected_;
+  }
+
+  void close();
+
+ private:
+  // HQSession::ConnectCallback
+  void connectSuccess() override;
+  void onReplaySafe() override;
+  void connectError(std::pair<quic::QuicErrorCode, std::string> error) override;
+
+  // HTTPSessionBase::InfoCallback; the session deletes itself when the
+  // transport goes away, so this is how the dangling pointer gets cleared
+  void onDestroy(const proxygen::HTTPSessionBase&) override;
+
+  HQLoadWorker& worker_;
+  const HQParams& params_;
+  folly::EventBase* evb_;
+  TimerHighRes::SharedPtr pacingTimer_;
+  std::shared_ptr<quic::QuicClientTransport> quicClient_;
+  proxygen::HQUpstreamSession* session_{nullptr};
+  bool connected_{false};
+};
+
+/**
+ * One load-generation thread: its own EventBase, --load_connections
+ * upstream connections and an open-loop arrival scheduler. A 1ms timer
+ * converts elapsed time into request credits at the configured rate and
+ * spends them immediately, regardless of how many responses have come
+ * back; when every pooled handler is in flight the arrival is shed and
+ * counted rather than queued, so a saturated server shows up as shed
+ * arrivals and rising percentiles instead of a silently slowed client.
+ */
+class HQLoadWorker : private folly::AsyncTimeout {
+ public:
+  struct Counters {
+    uint64_t requestsSent{0};
+    uint64_t responses{0};
+    uint64_t errors{0};
+    uint64_t shed{0};
+    uint64_t connectErrors{0};
+  };
+
+  HQLoadWorker(const HQParams& params,
+               const RequestMix& mix,
+               uint64_t requestsPerSecond,
+               proxygen::SparseHistogram& latencyUsec);
+
+  ~HQLoadWorker() override = default;
+
+  /**
+   * Connect and drive load until the configured duration elapses.
+   * Blocks; run one worker per thread.
+   */
+  void run();
+
+  const Counters& counters() const {
+    return counters_;
+  }
+
+  // Called back from handlers and connections on the worker's thread
+  void recordResponse(uint64_t latencyUsec);
+  void recordError();
+  void recordConnectError();
+  void recycle(LoadTxnHandler* handler);
+
+ private:
+  void timeoutExpired() noexcept override;
+  void sendOne();
+  void shutdown();
+
+  const HQParams& params_;
+  const RequestMix& mix_;
+  proxygen::SparseHistogram& latencyUsec_;
+  folly::EventBase evb_;
+  TimerHighRes::SharedPtr pacingTimer_;
+  std::vector<std::unique_ptr<HQLoadConnection>> connections_;
+  std::vector<std::unique_ptr<LoadTxnHandler>> handlerStorage_;
+  std::vector<LoadTxnHandler*> idleHandlers_;
+  size_t nextConnection_{0};
+  uint64_t rate_;
+  // Accumulates elapsed-usec * rate; one request is due per 1M credits
+  uint64_t creditUsec_{0};
+  std::chrono::steady_clock::time_point lastTick_;
+  std::chrono::steady_clock::time_point deadline_;
+  Counters counters_;
+};
+
+void startLoadGen(const HQParams& params);
+
+}} // namespace quic::samples
@@ -64,6 +64,25 @@ DEFINE_string(qlogger_path,
               "will be written. File is called <CID>.qlog");
 DEFINE_bool(pretty_json, true, "Whether to use pretty json for QLogger output");
 
+// Load generation flags. A non-zero --load_rps switches the client into
+// load-generation mode against an HQServer (see HQLoadGen.h):
+//    hq -mode client -load_rps 50000 -load_threads 4 -load_connections 100
+//    -load_duration_s 30 -load_mix "/index.html:9,/search:1"
+DEFINE_uint32(load_rps,
+              0,
+              "Target aggregate request rate; 0 disables load generation");
+DEFINE_uint32(load_connections, 1, "h3 connections per load thread");
+DEFINE_uint32(load_threads, 1, "Load generation threads");
+DEFINE_uint32(load_duration_s, 10, "Load generation run time, in seconds");
+DEFINE_uint32(load_max_outstanding,
+              1000,
+              "In-flight request cap per load thread; arrivals past the cap "
+              "are shed and counted rather than queued");
+DEFINE_string(load_mix,
+              "",
+              "Weighted request mix, 'path[:weight],...'; "
+              "empty uses --path with equal weights");
+
 // Partially reliable flags.
 DEFINE_bool(use_pr, false, "Use partial reliability");
 DEFINE_uint32(pr_chunk_size,
@@ -253,6 +272,15 @@ void initializeQLogSettings(HQParamsBuilder& builder) {
   builder.prettyJson = FLAGS_pretty_json;
 } // initializeQLogSettings
 
+void initializeLoadSettings(HQParamsBuilder& builder) {
+  builder.loadRequestsPerSecond = FLAGS_load_rps;
+  builder.loadConnections = FLAGS_load_connections;
+  builder.loadThreads = FLAGS_load_threads;
+  builder.loadMaxOutstanding = FLAGS_load_max_outstanding;
+  builder.loadDuration = std::chrono::seconds(FLAGS_load_duration_s);
+  builder.loadMixString = FLAGS_load_mix;
+} // initializeLoadSettings
+
 void initializeFizzSettings(HQParamsBuilder& builder) {
   builder.earlyData = FLAGS_early_data;
   builder.certificateFilePath = FLAGS_cert;
@@ -321,6 +349,23 @@ HQParamsBuilder::HQInvalidParams validate(const HQParamsBuilder& params) {
       INVALID_PARAM(congestion, "unrecognized congestion control");
     }
   }
+  // Validate the load generation section
+  if (params.loadRequestsPerSecond > 0) {
+    if (params.mode != HQMode::CLIENT) {
+      INVALID_PARAM(load_rps, "load generation requires --mode=client");
+    }
+    if (params.loadConnections == 0) {
+      INVALID_PARAM(load_connections, "at least one connection is required");
+    }
+    if (params.loadThreads == 0) {
+      INVALID_PARAM(load_threads, "at least one thread is required");
+    }
+    if (params.loadMaxOutstanding == 0) {
+      INVALID_PARAM(load_max_outstanding,
+                    "the in-flight cap must be non-zero");
+    }
+  }
+
   // Validate the HTTP section
   if (params.mode == HQMode::SERVER) {
     if (!params.httpBody.empty()) {
@@ -392,6 +437,8 @@ HQParamsBuilder::HQParamsBuilder(initializer_list initial) {
 
   initializeQLogSettings(*this);
 
+  initializeLoadSettings(*this);
+
   initializeFizzSettings(*this);
 
   for (auto& err : validate(*this)) {
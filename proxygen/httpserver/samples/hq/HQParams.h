@@ -118,6 +118,14 @@ class HQParamsBuilder {
   std::string qLoggerPath;
   bool prettyJson;
 
+  // Load generation section
+  uint64_t loadRequestsPerSecond{0};
+  uint32_t loadConnections{0};
+  uint32_t loadThreads{0};
+  uint32_t loadMaxOutstanding{0};
+  std::chrono::seconds loadDuration{0};
+  std::string loadMixString;
+
   // Fizz options
   std::string certificateFilePath;
   std::string keyFilePath;
@@ -14,6 +14,7 @@
 
 #include <proxygen/httpserver/samples/hq/ConnIdLogger.h>
 #include <proxygen/httpserver/samples/hq/HQClient.h>
+#include <proxygen/httpserver/samples/hq/HQLoadGen.h>
 #include <proxygen/httpserver/samples/hq/HQParams.h>
 #include <proxygen/httpserver/samples/hq/HQServer.h>
 #include <proxygen/lib/transport/PersistentQuicPskCache.h>
@@ -45,7 +46,11 @@ int main(int argc, char* argv[]) {
             startServer(params);
             break;
           case HQMode::CLIENT:
-            startClient(params);
+            if (params->loadRequestsPerSecond > 0) {
+              startLoadGen(params);
+            } else {
+              startClient(params);
+            }
             break;
           default:
             LOG(ERROR) << "Unknown mode specified: ";
@@ -0,0 +1,90 @@
+/*
+ *  Copyright (c) 2015-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include "StaticCache.h"
+
+#include <folly/hash/Hash.h>
+#include <glog/logging.h>
+#include <proxygen/lib/utils/ZlibStreamCompressor.h>
+
+namespace StaticService {
+
+constexpr size_t StaticCache::kMaxCacheableSize;
+constexpr size_t StaticCache::kDefaultIndexSlots;
+constexpr size_t StaticCache::kProbeWindow;
+
+StaticCache::StaticCache(size_t indexSlots) : slots_(indexSlots) {
+  CHECK_EQ(indexSlots & (indexSlots - 1), 0) << "index must be a power of two";
+}
+
+StaticCache& StaticCache::get() {
+  static StaticCache cache;
+  return cache;
+}
+
+uint64_t StaticCache::hashPath(folly::StringPiece path) {
+  auto hash = folly::hash::fnv64_buf(path.data(), path.size());
+  // 0 marks an empty slot
+  return hash == 0 ? 1 : hash;
+}
+
+StaticCache::ObjectPtr StaticCache::find(folly::StringPiece path) {
+  const auto hash = hashPath(path);
+  const auto mask = slots_.size() - 1;
+  std::lock_guard<std::mutex> g(lock_);
+  for (size_t i = 0; i < kProbeWindow; i++) {
+    auto& slot = slots_[(hash + i) & mask];
+    if (slot.hash == hash && slot.object && slot.object->path == path) {
+      slot.lastAccess = ++tick_;
+      return slot.object;
+    }
+  }
+  return nullptr;
+}
+
+StaticCache::ObjectPtr StaticCache::insert(folly::StringPiece path,
+                                           std::unique_ptr<folly::IOBuf> body,
+                                           std::string etag) {
+  auto object = std::make_shared<Object>();
+  object->path = path.str();
+  object->etag = std::move(etag);
+
+  // Gzip before taking the lock; keep the variant only if it helps
+  const auto bodyLen = body->computeChainDataLength();
+  proxygen::ZlibStreamCompressor compressor(proxygen::CompressionType::GZIP,
+                                            6 /* level */);
+  auto gzipped = compressor.compress(body.get(), true /* trailer */);
+  if (!compressor.hasError() && gzipped &&
+      gzipped->computeChainDataLength() < bodyLen) {
+    object->gzipBody = std::move(gzipped);
+  }
+  object->body = std::move(body);
+
+  const auto hash = hashPath(path);
+  const auto mask = slots_.size() - 1;
+  std::lock_guard<std::mutex> g(lock_);
+  Slot* victim = nullptr;
+  for (size_t i = 0; i < kProbeWindow; i++) {
+    auto& slot = slots_[(hash + i) & mask];
+    if (slot.hash == 0 ||
+        (slot.hash == hash && slot.object && slot.object->path == path)) {
+      victim = &slot;
+      break;
+    }
+    if (!victim || slot.lastAccess < victim->lastAccess) {
+      victim = &slot;
+    }
+  }
+  victim->hash = hash;
+  victim->lastAccess = ++tick_;
+  victim->object = object;
+  return object;
+}
+
+} // namespace StaticService
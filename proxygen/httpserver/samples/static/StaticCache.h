@@ -0,0 +1,90 @@
+/*
+ *  Copyright (c) 2015-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <folly/Range.h>
+#include <folly/io/IOBuf.h>
+
+namespace StaticService {
+
+/**
+ * A process-wide cache of hot static objects, shared by all workers.
+ *
+ * The index is a fixed-size open-addressed table of cache-line-sized
+ * slots keyed on the path hash with linear probing.  Eviction is
+ * LRU-ish: when a probe window fills up, the slot with the stalest
+ * access tick in the window is replaced.  A hit hands out a shared
+ * pointer to an immutable object whose body IOBufs are cloned (not
+ * copied) into each response, so serving is allocation of a few IOBuf
+ * headers and nothing else.
+ *
+ * Objects carry a pre-gzipped variant so Accept-Encoding: gzip requests
+ * skip compression entirely, and an ETag so If-None-Match revalidations
+ * can be answered straight from the index.
+ */
+class StaticCache {
+ public:
+  struct Object {
+    std::string path;
+    std::string etag;
+    std::unique_ptr<folly::IOBuf> body;
+    // Pre-gzipped variant; null when gzip did not shrink the body
+    std::unique_ptr<folly::IOBuf> gzipBody;
+  };
+
+  using ObjectPtr = std::shared_ptr<const Object>;
+
+  // Objects larger than this stay on the streaming path
+  static constexpr size_t kMaxCacheableSize = 4 << 20;
+
+  explicit StaticCache(size_t indexSlots = kDefaultIndexSlots);
+
+  /**
+   * The cache shared by all workers of this process.
+   */
+  static StaticCache& get();
+
+  /**
+   * Returns the cached object for path, or null on a miss.
+   */
+  ObjectPtr find(folly::StringPiece path);
+
+  /**
+   * Build an object (gzipping the body off-lock) and publish it,
+   * possibly evicting the stalest entry in the probe window.  Returns
+   * the inserted object so the caller can serve from it.
+   */
+  ObjectPtr insert(folly::StringPiece path,
+                   std::unique_ptr<folly::IOBuf> body,
+                   std::string etag);
+
+ private:
+  struct alignas(64) Slot {
+    uint64_t hash{0}; // 0 means empty
+    uint64_t lastAccess{0};
+    ObjectPtr object;
+  };
+
+  static constexpr size_t kDefaultIndexSlots = 512; // must be a power of two
+  static constexpr size_t kProbeWindow = 8;
+
+  static uint64_t hashPath(folly::StringPiece path);
+
+  std::mutex lock_;
+  uint64_t tick_{0};
+  std::vector<Slot> slots_;
+};
+
+} // namespace StaticService
@@ -9,8 +9,15 @@
  */
 #include "StaticHandler.h"
 
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <algorithm>
+
 #include <proxygen/httpserver/RequestHandler.h>
 #include <proxygen/httpserver/ResponseBuilder.h>
+#include <folly/Format.h>
+#include <folly/hash/SpookyHashV2.h>
 #include <folly/io/async/EventBaseManager.h>
 #include <folly/FileUtil.h>
 #include <folly/executors/GlobalExecutor.h>
@@ -19,10 +26,108 @@ using namespace proxygen;
 
 namespace StaticService {
 
+namespace {
+
+// How much of the mapping goes out per body chunk
+constexpr size_t kMmapChunkSize = 1 << 20;
+
+// Each egress chunk owns one of these; dropping it releases the chunk's
+// reference on the mapping
+void releaseMmapRef(void* /*buf*/, void* userData) {
+  delete static_cast<std::shared_ptr<void>*>(userData);
+}
+
+// Outcome of matching a Range header against a representation of known size
+enum class RangeParse { kNone, kValid, kUnsatisfiable };
+
+// Parses a single "bytes=first-last" or "bytes=-suffix" range.
+// Multi-range requests and anything malformed are ignored and answered
+// with the full body, which RFC 7233 permits.
+RangeParse parseRange(folly::StringPiece spec,
+                      size_t size,
+                      size_t& start,
+                      size_t& len) {
+  if (!spec.startsWith("bytes=")) {
+    return RangeParse::kNone;
+  }
+  spec.advance(6);
+  if (spec.find(',') != folly::StringPiece::npos) {
+    return RangeParse::kNone;
+  }
+  const auto dash = spec.find('-');
+  if (dash == folly::StringPiece::npos) {
+    return RangeParse::kNone;
+  }
+  const auto first = spec.subpiece(0, dash);
+  const auto last = spec.subpiece(dash + 1);
+  try {
+    if (first.empty()) {
+      // Suffix range: the last N bytes
+      auto n = folly::to<size_t>(last);
+      if (n == 0) {
+        return RangeParse::kUnsatisfiable;
+      }
+      n = std::min(n, size);
+      start = size - n;
+      len = n;
+    } else {
+      start = folly::to<size_t>(first);
+      if (start >= size) {
+        return RangeParse::kUnsatisfiable;
+      }
+      size_t end = last.empty() ? size - 1 : folly::to<size_t>(last);
+      if (end < start) {
+        return RangeParse::kNone;
+      }
+      end = std::min(end, size - 1);
+      len = end - start + 1;
+    }
+  } catch (const folly::ConversionError&) {
+    return RangeParse::kNone;
+  }
+  return RangeParse::kValid;
+}
+
+std::string contentRangeOf(size_t start, size_t len, size_t size) {
+  return folly::to<std::string>(
+      "bytes ", start, "-", start + len - 1, "/", size);
+}
+
+// A range is honored only when If-Range is absent or matches our ETag;
+// a stale validator downgrades the request to a full 200
+RangeParse requestedRange(const HTTPHeaders& reqHeaders,
+                          const std::string& etag,
+                          size_t size,
+                          size_t& start,
+                          size_t& len) {
+  const auto& ifRange = reqHeaders.getSingleOrEmpty(HTTP_HEADER_IF_RANGE);
+  if (!ifRange.empty() && ifRange != etag) {
+    return RangeParse::kNone;
+  }
+  return parseRange(
+      reqHeaders.getSingleOrEmpty(HTTP_HEADER_RANGE), size, start, len);
+}
+
+// Strong ETag from the file contents, one pass of a fast non-crypto hash
+// over the mapping.  Unlike the size-mtime tag used for streamed files it
+// is stable across restarts and copies, so clients keep revalidating
+// successfully after a redeploy.
+std::string contentEtag(const void* data, size_t size) {
+  const auto hash = folly::hash::SpookyHashV2::Hash64(data, size, 0);
+  return folly::sformat("\"{:016x}\"", hash);
+}
+
+} // namespace
+
 /**
  * Handles requests by serving the file named in path.  Only supports GET.
- * reads happen in a CPU thread pool since read(2) is blocking.
- * If egress pauses, file reading is also paused.
+ * Regular files are mmap()ed up front and egressed as IOBufs wrapping the
+ * mapping, so the file contents are never copied into user-space buffers;
+ * the transport writes the mapped pages directly.  If egress pauses, the
+ * send loop pauses with it.  Files that cannot be mapped fall back to
+ * read(2) in a CPU thread pool, 4k at a time.  Responses carry an ETag
+ * and If-None-Match revalidations are answered with a 304 before any
+ * body work is scheduled.
  */
 
 void StaticHandler::onRequest(std::unique_ptr<HTTPMessage> headers) noexcept {
@@ -33,11 +138,19 @@ void StaticHandler::onRequest(std::unique_ptr<HTTPMessage> headers) noexcept {
       .sendWithEOM();
     return;
   }
+  // Hot objects are served straight from the shared cache, including
+  // If-None-Match revalidations
+  // + 1 to kill leading /
+  const std::string path = headers->getPath().substr(1);
+  auto cached = StaticCache::get().find(path);
+  if (cached) {
+    serveCached(*headers, cached);
+    return;
+  }
   // a real webserver would validate this path didn't contain malicious
   // characters like '//' or '..'
   try {
-    // + 1 to kill leading /
-    file_ = std::make_unique<folly::File>(headers->getPath().c_str() + 1);
+    file_ = std::make_unique<folly::File>(path.c_str());
   } catch (const std::system_error& ex) {
     ResponseBuilder(downstream_)
       .status(404, "Not Found")
@@ -46,6 +159,73 @@ void StaticHandler::onRequest(std::unique_ptr<HTTPMessage> headers) noexcept {
       .sendWithEOM();
     return;
   }
+  if (tryMmapFile()) {
+    if (fileSize_ <= StaticCache::kMaxCacheableSize) {
+      // Fill the cache with one copy of the mapping and serve from it.
+      // Cached objects carry a content-hash ETag so revalidations keep
+      // matching across restarts; serveCached answers If-None-Match hits
+      // with a 304 straight from the index.
+      etag_ = contentEtag(mmapRegion_->data, fileSize_);
+      auto body = folly::IOBuf::copyBuffer(mmapRegion_->data, fileSize_);
+      cached =
+          StaticCache::get().insert(path, std::move(body), std::move(etag_));
+      mmapRegion_.reset();
+      file_.reset();
+      serveCached(*headers, cached);
+      return;
+    }
+    // Answer revalidations before any body chunk is scheduled; a 304
+    // drops the mapping without touching the file pages
+    if (headers->getHeaders().getSingleOrEmpty(HTTP_HEADER_IF_NONE_MATCH) ==
+        etag_) {
+      mmapRegion_.reset();
+      file_.reset();
+      ResponseBuilder(downstream_)
+        .status(304, "Not Modified")
+        .header(HTTP_HEADER_ETAG, etag_)
+        .sendWithEOM();
+      return;
+    }
+    size_t start = 0;
+    size_t len = 0;
+    switch (requestedRange(
+        headers->getHeaders(), etag_, fileSize_, start, len)) {
+      case RangeParse::kUnsatisfiable:
+        mmapRegion_.reset();
+        file_.reset();
+        ResponseBuilder(downstream_)
+          .status(416, "Range Not Satisfiable")
+          .header(HTTP_HEADER_ETAG, etag_)
+          .header(HTTP_HEADER_CONTENT_RANGE,
+                  folly::to<std::string>("bytes */", fileSize_))
+          .sendWithEOM();
+        return;
+      case RangeParse::kValid:
+        // Seek by pointing the send loop at the requested window; only
+        // the mapped pages inside it are ever touched
+        mmapOffset_ = start;
+        mmapEnd_ = start + len;
+        ResponseBuilder(downstream_)
+          .status(206, "Partial Content")
+          .header(HTTP_HEADER_ETAG, etag_)
+          .header(HTTP_HEADER_ACCEPT_RANGES, "bytes")
+          .header(HTTP_HEADER_CONTENT_RANGE,
+                  contentRangeOf(start, len, fileSize_))
+          .send();
+        sendMmapChunks();
+        return;
+      case RangeParse::kNone:
+        break;
+    }
+    mmapEnd_ = fileSize_;
+    ResponseBuilder(downstream_)
+      .status(200, "Ok")
+      .header(HTTP_HEADER_ETAG, etag_)
+      .header(HTTP_HEADER_ACCEPT_RANGES, "bytes")
+      .send();
+    sendMmapChunks();
+    return;
+  }
   ResponseBuilder(downstream_)
     .status(200, "Ok")
     .send();
@@ -56,6 +236,114 @@ void StaticHandler::onRequest(std::unique_ptr<HTTPMessage> headers) noexcept {
               folly::EventBaseManager::get()->getEventBase()));
 }
 
+void StaticHandler::serveCached(const HTTPMessage& headers,
+                                const StaticCache::ObjectPtr& cached) {
+  const auto& reqHeaders = headers.getHeaders();
+  if (reqHeaders.getSingleOrEmpty(HTTP_HEADER_IF_NONE_MATCH) ==
+      cached->etag) {
+    ResponseBuilder(downstream_)
+      .status(304, "Not Modified")
+      .header(HTTP_HEADER_ETAG, cached->etag)
+      .sendWithEOM();
+    return;
+  }
+  const size_t size = cached->body->computeChainDataLength();
+  size_t start = 0;
+  size_t len = 0;
+  switch (requestedRange(reqHeaders, cached->etag, size, start, len)) {
+    case RangeParse::kUnsatisfiable:
+      ResponseBuilder(downstream_)
+        .status(416, "Range Not Satisfiable")
+        .header(HTTP_HEADER_ETAG, cached->etag)
+        .header(HTTP_HEADER_CONTENT_RANGE,
+                folly::to<std::string>("bytes */", size))
+        .sendWithEOM();
+      return;
+    case RangeParse::kValid: {
+      // The clone shares the cached buffers; trimming just moves the
+      // head/tail pointers, so a partial response copies no body bytes
+      folly::IOBufQueue q;
+      q.append(cached->body->clone());
+      q.trimStart(start);
+      ResponseBuilder(downstream_)
+        .status(206, "Partial Content")
+        .header(HTTP_HEADER_ETAG, cached->etag)
+        .header(HTTP_HEADER_ACCEPT_RANGES, "bytes")
+        .header(HTTP_HEADER_CONTENT_RANGE, contentRangeOf(start, len, size))
+        .body(q.split(len))
+        .sendWithEOM();
+      return;
+    }
+    case RangeParse::kNone:
+      break;
+  }
+  ResponseBuilder builder(downstream_);
+  builder.status(200, "Ok")
+    .header(HTTP_HEADER_ETAG, cached->etag)
+    .header(HTTP_HEADER_ACCEPT_RANGES, "bytes");
+  const auto& acceptEnc =
+      reqHeaders.getSingleOrEmpty(HTTP_HEADER_ACCEPT_ENCODING);
+  if (cached->gzipBody && acceptEnc.find("gzip") != std::string::npos) {
+    builder.header(HTTP_HEADER_CONTENT_ENCODING, "gzip")
+      .body(cached->gzipBody->clone());
+  } else {
+    builder.body(cached->body->clone());
+  }
+  builder.sendWithEOM();
+}
+
+StaticHandler::MmapRegion::MmapRegion(void* data, size_t size)
+    : data(data), size(size) {
+}
+
+StaticHandler::MmapRegion::~MmapRegion() {
+  munmap(data, size);
+}
+
+bool StaticHandler::tryMmapFile() {
+  struct stat st;
+  if (fstat(file_->fd(), &st) != 0 || !S_ISREG(st.st_mode) ||
+      st.st_size <= 0) {
+    return false;
+  }
+  auto size = static_cast<size_t>(st.st_size);
+  auto data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, file_->fd(), 0);
+  if (data == MAP_FAILED) {
+    VLOG(4) << "mmap failed, falling back to read(2)";
+    return false;
+  }
+  // Ask the kernel to read ahead of the send loop
+  madvise(data, size, MADV_SEQUENTIAL);
+  mmapRegion_ = std::make_shared<MmapRegion>(data, size);
+  fileSize_ = size;
+  etag_ = folly::to<std::string>("\"", st.st_size, "-", st.st_mtime, "\"");
+  return true;
+}
+
+void StaticHandler::sendMmapChunks() {
+  while (!paused_ && mmapOffset_ < mmapEnd_) {
+    auto len = std::min(kMmapChunkSize, mmapEnd_ - mmapOffset_);
+    auto ref = std::make_unique<std::shared_ptr<void>>(mmapRegion_);
+    auto body = folly::IOBuf::takeOwnership(
+        static_cast<char*>(mmapRegion_->data) + mmapOffset_,
+        len,
+        len,
+        releaseMmapRef,
+        ref.release());
+    mmapOffset_ += len;
+    // May synchronously pause egress, terminating the loop
+    ResponseBuilder(downstream_)
+      .body(std::move(body))
+      .send();
+  }
+  if (mmapOffset_ >= mmapEnd_) {
+    mmapRegion_.reset();
+    file_.reset();
+    ResponseBuilder(downstream_)
+      .sendWithEOM();
+  }
+}
+
 void StaticHandler::readFile(folly::EventBase* evb) {
   folly::IOBufQueue buf;
   while (file_ && !paused_) {
@@ -109,6 +397,10 @@ void StaticHandler::onEgressPaused() noexcept {
 void StaticHandler::onEgressResumed() noexcept {
   VLOG(4) << "StaticHandler resumed";
   paused_ = false;
+  if (mmapRegion_) {
+    sendMmapChunks();
+    return;
+  }
   // If readFileScheduled_, it will reschedule itself
   if (!readFileScheduled_ && file_) {
     readFileScheduled_ = true;
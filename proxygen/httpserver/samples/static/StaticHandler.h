@@ -13,6 +13,8 @@
 #include <folly/File.h>
 #include <proxygen/httpserver/RequestHandler.h>
 
+#include "StaticCache.h"
+
 namespace proxygen {
 class ResponseHandler;
 }
@@ -39,10 +41,31 @@ class StaticHandler : public proxygen::RequestHandler {
   void onEgressResumed() noexcept override;
 
  private:
+  /**
+   * A read-only mapping of the file being served. Egress chunks each hold
+   * a reference, so the mapping persists until the last byte has been
+   * handed to the transport even if the handler dies first.
+   */
+  struct MmapRegion {
+    MmapRegion(void* data, size_t size);
+    ~MmapRegion();
+    void* const data;
+    const size_t size;
+  };
+
+  bool tryMmapFile();
+  void sendMmapChunks();
+  void serveCached(const proxygen::HTTPMessage& headers,
+                   const StaticCache::ObjectPtr& cached);
   void readFile(folly::EventBase* evb);
   bool checkForCompletion();
 
   std::unique_ptr<folly::File> file_;
+  std::shared_ptr<MmapRegion> mmapRegion_;
+  std::string etag_;
+  size_t fileSize_{0};
+  size_t mmapOffset_{0};
+  size_t mmapEnd_{0};
   bool readFileScheduled_{false};
   std::atomic<bool> paused_{false};
   bool finished_{false};
@@ -0,0 +1,112 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include <proxygen/httpserver/FilterStack.h>
+#include "proxygen/httpserver/Mocks.h"
+#include <folly/portability/GMock.h>
+#include <folly/portability/GTest.h>
+
+using namespace proxygen;
+using namespace testing;
+
+namespace {
+
+// Appends its tag to a shared trace on the hooks it shadows
+class TraceFilter : public InlineFilter {
+ public:
+  TraceFilter() = default;
+  TraceFilter(char tag, std::string* trace) : tag_(tag), trace_(trace) {}
+
+  template <typename Next>
+  void onRequest(Next next, std::unique_ptr<HTTPMessage> headers) noexcept {
+    trace_->push_back(tag_);
+    next.onRequest(std::move(headers));
+  }
+
+  template <typename Prev>
+  void sendEOM(Prev prev) noexcept {
+    trace_->push_back(tag_);
+    prev.sendEOM();
+  }
+
+ private:
+  char tag_{'?'};
+  std::string* trace_{nullptr};
+};
+
+class CountingFilter : public InlineFilter {
+ public:
+  template <typename Next>
+  void onBody(Next next, std::unique_ptr<folly::IOBuf> body) noexcept {
+    bytes_ += body ? body->computeChainDataLength() : 0;
+    next.onBody(std::move(body));
+  }
+
+  uint64_t bytes_{0};
+};
+
+}
+
+TEST(FilterStackTest, PassThroughAndOrder) {
+  std::string trace;
+  NiceMock<MockRequestHandler> app;
+  auto stack = new FilterStack<TraceFilter, TraceFilter>(
+      &app,
+      std::make_tuple(TraceFilter('a', &trace), TraceFilter('b', &trace)));
+  MockResponseHandler client(stack);
+
+  EXPECT_CALL(app, setResponseHandler(stack));
+  static_cast<RequestHandler*>(stack)->setResponseHandler(&client);
+
+  // Ingress runs outermost (client side) filter first
+  EXPECT_CALL(app, onRequest(_));
+  static_cast<RequestHandler*>(stack)->onRequest(
+      std::make_unique<HTTPMessage>());
+  EXPECT_EQ(trace, "ab");
+
+  // Egress runs innermost filter first
+  EXPECT_CALL(client, sendEOM());
+  static_cast<ResponseHandler*>(stack)->sendEOM();
+  EXPECT_EQ(trace, "abba");
+
+  // requestComplete traverses the stack, then the stack frees itself
+  EXPECT_CALL(app, requestComplete());
+  static_cast<RequestHandler*>(stack)->requestComplete();
+}
+
+TEST(FilterStackTest, FilterStatePersistsAcrossCallbacks) {
+  NiceMock<MockRequestHandler> app;
+  auto stack = new FilterStack<CountingFilter>(&app);
+
+  EXPECT_CALL(app, onBody(_)).Times(2);
+  RequestHandler* handler = stack;
+  handler->onBody(folly::IOBuf::copyBuffer("12345"));
+  handler->onBody(folly::IOBuf::copyBuffer("67"));
+  EXPECT_EQ(stack->getFilter<0>().bytes_, 7);
+
+  EXPECT_CALL(app, onError(kErrorTimeout));
+  handler->onError(kErrorTimeout);
+}
+
+TEST(FilterStackTest, FactoryCopiesPrototypes) {
+  std::string trace;
+  FilterStackFactory<TraceFilter> factory(TraceFilter('x', &trace));
+
+  for (int i = 0; i < 2; i++) {
+    NiceMock<MockRequestHandler> app;
+    auto handler = factory.onRequest(&app, nullptr);
+
+    EXPECT_CALL(app, onRequest(_));
+    handler->onRequest(std::make_unique<HTTPMessage>());
+
+    EXPECT_CALL(app, requestComplete());
+    handler->requestComplete();
+  }
+  EXPECT_EQ(trace, "xx");
+}
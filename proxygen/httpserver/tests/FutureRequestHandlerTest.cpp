@@ -0,0 +1,108 @@
+/*
+ *  Copyright (c) 2015-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include <proxygen/httpserver/FutureRequestHandler.h>
+#include "proxygen/httpserver/Mocks.h"
+#include <folly/portability/GMock.h>
+#include <folly/portability/GTest.h>
+
+using namespace proxygen;
+using namespace testing;
+
+namespace {
+
+// Completes its response from a test-owned promise so the test controls
+// when the "upstream" finishes, possibly after the handler is gone.
+struct PromiseHandler : public FutureRequestHandler {
+  explicit PromiseHandler(folly::Promise<Response>& promise)
+      : promise_(promise) {}
+
+  folly::Future<Response> onFullRequest(FullRequest request) noexcept
+      override {
+    if (request.body) {
+      requestBody_ = request.body->moveToFbString().toStdString();
+    }
+    return promise_.getFuture();
+  }
+
+  folly::Promise<Response>& promise_;
+  std::string requestBody_;
+};
+
+} // namespace
+
+TEST(FutureRequestHandlerTest, DeferredResponse) {
+  folly::Promise<FutureRequestHandler::Response> promise;
+  auto handler = new PromiseHandler(promise);
+  StrictMock<MockResponseHandler> responseHandler(handler);
+  handler->setResponseHandler(&responseHandler);
+
+  handler->onRequest(std::make_unique<HTTPMessage>());
+  handler->onBody(folly::IOBuf::copyBuffer("hello"));
+  handler->onEOM();
+  EXPECT_EQ(handler->requestBody_, "hello");
+
+  std::string sentBody;
+  EXPECT_CALL(responseHandler, sendHeaders(_))
+      .WillOnce(Invoke([](HTTPMessage& msg) {
+        EXPECT_EQ(msg.getStatusCode(), 200);
+        EXPECT_EQ(msg.getHeaders().getSingleOrEmpty("X-Test"), "yes");
+      }));
+  EXPECT_CALL(responseHandler, sendBody(_))
+      .WillOnce(Invoke([&](std::shared_ptr<folly::IOBuf> body) {
+        sentBody = body->moveToFbString().toStdString();
+      }));
+  EXPECT_CALL(responseHandler, sendEOM());
+
+  FutureRequestHandler::Response response;
+  response.headers.add("X-Test", "yes");
+  response.body = folly::IOBuf::copyBuffer("world");
+  promise.setValue(std::move(response));
+  folly::EventBaseManager::get()->getEventBase()->loop();
+  EXPECT_EQ(sentBody, "world");
+
+  handler->requestComplete();
+}
+
+TEST(FutureRequestHandlerTest, FailedFutureSends500) {
+  folly::Promise<FutureRequestHandler::Response> promise;
+  auto handler = new PromiseHandler(promise);
+  StrictMock<MockResponseHandler> responseHandler(handler);
+  handler->setResponseHandler(&responseHandler);
+
+  handler->onRequest(std::make_unique<HTTPMessage>());
+  handler->onEOM();
+
+  EXPECT_CALL(responseHandler, sendHeaders(_))
+      .WillOnce(Invoke([](HTTPMessage& msg) {
+        EXPECT_EQ(msg.getStatusCode(), 500);
+      }));
+  EXPECT_CALL(responseHandler, sendEOM());
+
+  promise.setException(std::runtime_error("upstream exploded"));
+  folly::EventBaseManager::get()->getEventBase()->loop();
+
+  handler->requestComplete();
+}
+
+TEST(FutureRequestHandlerTest, LateCompletionDropped) {
+  folly::Promise<FutureRequestHandler::Response> promise;
+  auto handler = new PromiseHandler(promise);
+  StrictMock<MockResponseHandler> responseHandler(handler);
+  handler->setResponseHandler(&responseHandler);
+
+  handler->onRequest(std::make_unique<HTTPMessage>());
+  handler->onEOM();
+
+  // The transaction dies before the upstream finishes; the strict mock
+  // verifies the late response never reaches the dead downstream.
+  handler->onError(kErrorTimeout);
+  promise.setValue(FutureRequestHandler::Response());
+  folly::EventBaseManager::get()->getEventBase()->loop();
+}
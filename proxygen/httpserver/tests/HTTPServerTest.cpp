@@ -120,6 +120,85 @@ TEST(HttpServerStartStop, TestRepeatStopCalls) {
   server->stop();
 }
 
+TEST(HttpServerStartStop, TestUpdateServerOptions) {
+  std::vector<HTTPServer::IPConfig> ips = {
+    {
+      folly::SocketAddress("127.0.0.1", 0),
+      HTTPServer::Protocol::HTTP
+    }
+  };
+
+  HTTPServerOptions options;
+  options.threads = 2;
+  options.idleTimeout = std::chrono::milliseconds(60000);
+
+  auto server = std::make_unique<HTTPServer>(std::move(options));
+  server->bind(ips);
+  auto st = std::make_unique<ServerThread>(server.get());
+  EXPECT_TRUE(st->start());
+
+  // Swap in a tighter idle timeout on the running server; the update
+  // lands on each acceptor's loop and must not disturb the listeners
+  HTTPServerOptions updated;
+  updated.threads = 2;
+  updated.idleTimeout = std::chrono::milliseconds(1000);
+  server->updateServerOptions(updated);
+
+  server->stop();
+}
+
+TEST(ReusePortSharding, ListenerPerWorker) {
+  std::vector<HTTPServer::IPConfig> ips = {
+    {
+      folly::SocketAddress("127.0.0.1", 0),
+      HTTPServer::Protocol::HTTP
+    }
+  };
+
+  HTTPServerOptions options;
+  options.threads = 2;
+  options.useReusePortSharding = true;
+
+  auto server = std::make_unique<HTTPServer>(std::move(options));
+  server->bind(ips);
+
+  ServerThread st(server.get());
+  EXPECT_TRUE(st.start());
+
+  // One listener per worker, all sharing the same port
+  auto sockets = server->getSockets();
+  ASSERT_EQ(sockets.size(), 2);
+  SocketAddress addr0, addr1;
+  sockets[0]->getAddress(&addr0);
+  sockets[1]->getAddress(&addr1);
+  EXPECT_NE(addr0.getPort(), 0);
+  EXPECT_EQ(addr0.getPort(), addr1.getPort());
+  EXPECT_EQ(server->addresses().front().address.getPort(), addr0.getPort());
+}
+
+TEST(ReusePortSharding, NumaPlacementStartsEverywhere) {
+  // NUMA placement must degrade gracefully on hosts without multiple
+  // nodes (or without sysfs); the server still comes up sharded
+  std::vector<HTTPServer::IPConfig> ips = {
+    {
+      folly::SocketAddress("127.0.0.1", 0),
+      HTTPServer::Protocol::HTTP
+    }
+  };
+
+  HTTPServerOptions options;
+  options.threads = 2;
+  options.useReusePortSharding = true;
+  options.numaPinShardedWorkers = true;
+
+  auto server = std::make_unique<HTTPServer>(std::move(options));
+  server->bind(ips);
+
+  ServerThread st(server.get());
+  EXPECT_TRUE(st.start());
+  EXPECT_EQ(server->getSockets().size(), 2);
+}
+
 // Make an SSL connection to the server
 class Cb : public folly::AsyncSocket::ConnectCallback {
  public:
@@ -7,6 +7,7 @@
  *  of patent rights can be found in the PATENTS file in the same directory.
  *
  */
+#include <proxygen/httpserver/EarlyHints.h>
 #include <proxygen/httpserver/RequestHandlerAdaptor.h>
 #include "proxygen/httpserver/Mocks.h"
 #include "proxygen/lib/http/session/test/HTTPTransactionMocks.h"
@@ -79,3 +80,62 @@ TEST(RequestHandlerAdaptorTest, onStreamAbortError) {
   EXPECT_CALL(requestHandler_, onError(kErrorStreamAbort));
   txn.onError(ex);
 }
+
+struct HintingRequestHandler : public NiceMock<MockRequestHandler> {
+  std::shared_ptr<const HTTPMessage> getEarlyHints(
+      const HTTPMessage& /*request*/) noexcept override {
+    return EarlyHints::getResponse({"</style.css>; rel=preload; as=style"});
+  }
+};
+
+struct HintCapturingAdaptor : public StubRequestHandlerAdaptor {
+  using StubRequestHandlerAdaptor::StubRequestHandlerAdaptor;
+
+  void sendEarlyHints(const HTTPMessage& msg) noexcept override {
+    // prevent using txn_
+    hintsSent_++;
+    hintStatus_ = msg.getStatusCode();
+  }
+
+  uint32_t hintsSent_{0};
+  uint16_t hintStatus_{0};
+};
+
+TEST(RequestHandlerAdaptorTest, EarlyHintsBeforeHandler) {
+  HintingRequestHandler requestHandler;
+  auto adaptor = std::make_shared<HintCapturingAdaptor>(&requestHandler);
+  EXPECT_CALL(requestHandler, onRequest(_))
+      .WillOnce(InvokeWithoutArgs([&] {
+        // Hints go out before the handler sees the request
+        EXPECT_EQ(adaptor->hintsSent_, 1);
+      }));
+  auto msg = std::make_unique<HTTPMessage>();
+  msg->setHTTPVersion(1, 1);
+  auto txHandler = std::dynamic_pointer_cast<HTTPTransactionHandler>(adaptor);
+  txHandler->onHeadersComplete(std::move(msg));
+  EXPECT_EQ(adaptor->hintsSent_, 1);
+  EXPECT_EQ(adaptor->hintStatus_, 103);
+}
+
+TEST(RequestHandlerAdaptorTest, NoEarlyHintsForHttp10) {
+  HintingRequestHandler requestHandler;
+  auto adaptor = std::make_shared<HintCapturingAdaptor>(&requestHandler);
+  EXPECT_CALL(requestHandler, onRequest(_));
+  auto msg = std::make_unique<HTTPMessage>();
+  msg->setHTTPVersion(1, 0);
+  auto txHandler = std::dynamic_pointer_cast<HTTPTransactionHandler>(adaptor);
+  txHandler->onHeadersComplete(std::move(msg));
+  EXPECT_EQ(adaptor->hintsSent_, 0);
+}
+
+TEST(RequestHandlerAdaptorTest, EarlyHintsTemplateCache) {
+  std::vector<std::string> links{"</a.js>; rel=preload; as=script",
+                                 "</b.css>; rel=preload; as=style"};
+  auto first = EarlyHints::getResponse(links);
+  auto second = EarlyHints::getResponse(links);
+  // Same link set yields the same shared template
+  EXPECT_EQ(first.get(), second.get());
+  EXPECT_EQ(first->getStatusCode(), 103);
+  EXPECT_TRUE(first->is1xxResponse());
+  EXPECT_EQ(first->getHeaders().getNumberOfValues(HTTP_HEADER_LINK), 2);
+}
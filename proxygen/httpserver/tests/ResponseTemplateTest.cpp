@@ -0,0 +1,89 @@
+/*
+ *  Copyright (c) 2019-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include <proxygen/httpserver/ResponseTemplate.h>
+#include "proxygen/httpserver/Mocks.h"
+#include <folly/portability/GMock.h>
+#include <folly/portability/GTest.h>
+
+using namespace proxygen;
+using namespace testing;
+
+namespace {
+
+std::string bodyToString(const folly::IOBuf* buf) {
+  std::string out;
+  for (auto range : *buf) {
+    out.append(reinterpret_cast<const char*>(range.data()), range.size());
+  }
+  return out;
+}
+
+} // namespace
+
+TEST(ResponseTemplateTest, RendersVariableFieldsIntoGaps) {
+  ResponseTemplate tmpl(
+      200, "OK", "{\"status\":\"ok\",\"user\":\"{{user}}\",\"data\":{{data}}}");
+  EXPECT_EQ(tmpl.getNumSlots(), 2);
+
+  auto body = tmpl.render()
+                  .set("user", "alice")
+                  .set("data", "[1,2,3]")
+                  .renderBody();
+  EXPECT_EQ(bodyToString(body.get()),
+            "{\"status\":\"ok\",\"user\":\"alice\",\"data\":[1,2,3]}");
+
+  // Same template, different fill; unset slots render empty
+  auto second = tmpl.render().set("data", "null").renderBody();
+  EXPECT_EQ(bodyToString(second.get()),
+            "{\"status\":\"ok\",\"user\":\"\",\"data\":null}");
+}
+
+TEST(ResponseTemplateTest, StaticBytesAreShared) {
+  ResponseTemplate tmpl(200, "OK", "prefix {{x}} suffix");
+  auto a = tmpl.render().set("x", "1").renderBody();
+  auto b = tmpl.render().set("x", "2").renderBody();
+  // The static pieces of both renders point at the template's buffers
+  EXPECT_EQ(a->data(), b->data());
+  EXPECT_EQ(bodyToString(a.get()), "prefix 1 suffix");
+  EXPECT_EQ(bodyToString(b.get()), "prefix 2 suffix");
+}
+
+TEST(ResponseTemplateTest, RepeatedSlotAndEdges) {
+  // Slot at the very start, repeated in the middle, static tail
+  ResponseTemplate tmpl(200, "OK", "{{id}}: value for {{id}} here");
+  EXPECT_EQ(tmpl.getNumSlots(), 1);
+  auto body = tmpl.render().set("id", "k42").renderBody();
+  EXPECT_EQ(bodyToString(body.get()), "k42: value for k42 here");
+}
+
+TEST(ResponseTemplateTest, SendsCompleteResponse) {
+  ResponseTemplate tmpl(200, "OK", "{\"n\":{{n}}}");
+  tmpl.header(HTTP_HEADER_CONTENT_TYPE, "application/json");
+
+  NiceMock<MockRequestHandler> requestHandler;
+  MockResponseHandler handler(&requestHandler);
+  HTTPMessage sentHeaders;
+  std::shared_ptr<folly::IOBuf> sentBody;
+  EXPECT_CALL(handler, sendHeaders(_)).WillOnce(SaveArg<0>(&sentHeaders));
+  EXPECT_CALL(handler, sendBody(A<std::shared_ptr<folly::IOBuf>>()))
+      .WillOnce(SaveArg<0>(&sentBody));
+  EXPECT_CALL(handler, sendEOM());
+
+  tmpl.render().set("n", "17").sendTo(&handler);
+
+  EXPECT_EQ(sentHeaders.getStatusCode(), 200);
+  EXPECT_EQ(sentHeaders.getHeaders().getSingleOrEmpty(
+                HTTP_HEADER_CONTENT_TYPE),
+            "application/json");
+  EXPECT_EQ(sentHeaders.getHeaders().getSingleOrEmpty(
+                HTTP_HEADER_CONTENT_LENGTH),
+            "8");
+  EXPECT_EQ(bodyToString(sentBody.get()), "{\"n\":17}");
+}
@@ -0,0 +1,112 @@
+/*
+ *  Copyright (c) 2015-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include <proxygen/httpserver/SocketHandoff.h>
+
+#include <cstring>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+
+#include <folly/FileUtil.h>
+#include <folly/experimental/TestUtil.h>
+#include <folly/portability/GTest.h>
+
+using namespace proxygen;
+
+namespace {
+const std::chrono::milliseconds kTimeout{5000};
+}
+
+TEST(SocketHandoff, TransfersUsableFds) {
+  folly::test::TemporaryDirectory dir("socket_handoff");
+  auto path = (dir.path() / "handoff.sock").string();
+
+  // transfer the write end of a pipe; the receiver's fd must reach the
+  // same kernel object
+  int pipeFds[2];
+  ASSERT_EQ(pipe(pipeFds), 0);
+
+  std::thread server([&] {
+    EXPECT_TRUE(SocketHandoff::serveFds(path, {pipeFds[1]}, kTimeout));
+  });
+
+  std::vector<int> received;
+  // retry until the server side has the unix socket listening
+  for (int i = 0; i < 100 && received.empty(); i++) {
+    received = SocketHandoff::requestFds(path, kTimeout);
+    if (received.empty()) {
+      /* sleep override */
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+  }
+  server.join();
+  ASSERT_EQ(received.size(), 1);
+  ASSERT_GE(received[0], 0);
+  EXPECT_NE(received[0], pipeFds[1]);
+
+  EXPECT_EQ(folly::writeNoInt(received[0], "hi", 2), 2);
+  char buf[2];
+  EXPECT_EQ(folly::readNoInt(pipeFds[0], buf, 2), 2);
+  EXPECT_EQ(memcmp(buf, "hi", 2), 0);
+
+  close(received[0]);
+  close(pipeFds[0]);
+  close(pipeFds[1]);
+}
+
+TEST(SocketHandoff, TransfersMultipleFds) {
+  folly::test::TemporaryDirectory dir("socket_handoff");
+  auto path = (dir.path() / "handoff.sock").string();
+
+  int a[2];
+  int b[2];
+  ASSERT_EQ(pipe(a), 0);
+  ASSERT_EQ(pipe(b), 0);
+
+  std::thread server([&] {
+    EXPECT_TRUE(SocketHandoff::serveFds(path, {a[1], b[1]}, kTimeout));
+  });
+
+  std::vector<int> received;
+  for (int i = 0; i < 100 && received.empty(); i++) {
+    received = SocketHandoff::requestFds(path, kTimeout);
+    if (received.empty()) {
+      /* sleep override */
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+  }
+  server.join();
+  ASSERT_EQ(received.size(), 2);
+  for (auto fd : received) {
+    close(fd);
+  }
+  for (int i = 0; i < 2; i++) {
+    close(a[i]);
+    close(b[i]);
+  }
+}
+
+TEST(SocketHandoff, ServeTimesOutWithoutPeer) {
+  folly::test::TemporaryDirectory dir("socket_handoff");
+  auto path = (dir.path() / "handoff.sock").string();
+
+  int pipeFds[2];
+  ASSERT_EQ(pipe(pipeFds), 0);
+  EXPECT_FALSE(SocketHandoff::serveFds(
+      path, {pipeFds[1]}, std::chrono::milliseconds(50)));
+  close(pipeFds[0]);
+  close(pipeFds[1]);
+}
+
+TEST(SocketHandoff, RequestFailsWithoutServer) {
+  folly::test::TemporaryDirectory dir("socket_handoff");
+  auto path = (dir.path() / "nobody.sock").string();
+  EXPECT_TRUE(SocketHandoff::requestFds(path, kTimeout).empty());
+}
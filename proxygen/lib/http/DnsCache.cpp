@@ -0,0 +1,131 @@
+/*
+ *  Copyright (c) 2015-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include <proxygen/lib/http/DnsCache.h>
+
+#include <algorithm>
+#include <glog/logging.h>
+
+namespace proxygen {
+
+DnsCache::DnsCache(DnsResolver* resolver, Config config)
+    : resolver_(CHECK_NOTNULL(resolver)), config_(config) {
+}
+
+DnsCache::~DnsCache() {
+  for (auto& kv : inflight_) {
+    resolver_->cancelResolve(kv.second);
+    delete kv.second;
+  }
+}
+
+void DnsCache::getAddresses(const std::string& hostname, Callback* cb) {
+  auto now = getCurrentTime();
+  auto it = entries_.find(hostname);
+  if (it != entries_.end() && now < it->second.expiry) {
+    Entry& entry = it->second;
+    touch(entry, hostname);
+    if (!entry.negative && now >= entry.refreshAt &&
+        inflight_.find(hostname) == inflight_.end()) {
+      // still fresh enough to serve, but re-resolve in the background so
+      // the entry never actually expires under steady use
+      VLOG(4) << "background refresh of " << hostname;
+      startResolve(hostname, nullptr);
+    }
+    if (entry.negative) {
+      cb->resolveError(entry.error);
+    } else {
+      cb->resolveSuccess(entry.answer);
+    }
+    return;
+  }
+  startResolve(hostname, cb);
+}
+
+void DnsCache::startResolve(const std::string& hostname, Callback* waiter) {
+  auto it = inflight_.find(hostname);
+  if (it != inflight_.end()) {
+    // share the resolution already in flight
+    if (waiter) {
+      it->second->waiters.push_back(waiter);
+    }
+    return;
+  }
+  auto job = new ResolveJob(this, hostname);
+  if (waiter) {
+    job->waiters.push_back(waiter);
+  }
+  inflight_.emplace(hostname, job);
+  resolver_->resolve(hostname, job);
+}
+
+void DnsCache::onResolveDone(ResolveJob* job,
+                             folly::Optional<DnsResolver::Answer> answer,
+                             const std::string& error) {
+  inflight_.erase(job->hostname);
+
+  auto now = getCurrentTime();
+  auto it = entries_.find(job->hostname);
+  if (it == entries_.end()) {
+    evictIfNeeded();
+    lru_.push_front(job->hostname);
+    it = entries_.emplace(job->hostname, Entry()).first;
+    it->second.lruIter = lru_.begin();
+  }
+  Entry& entry = it->second;
+  if (answer) {
+    auto ttl = std::max(std::chrono::seconds(1),
+                        std::min(answer->ttl, config_.maxTtl));
+    entry.answer = std::move(*answer);
+    entry.negative = false;
+    entry.error.clear();
+    entry.expiry = now + ttl;
+    entry.refreshAt =
+        now + std::chrono::milliseconds(static_cast<int64_t>(
+                  config_.refreshThreshold * 1000 * ttl.count()));
+  } else {
+    entry.answer = DnsResolver::Answer();
+    entry.negative = true;
+    entry.error = error;
+    entry.expiry = now + config_.negativeTtl;
+  }
+
+  for (auto waiter : job->waiters) {
+    if (entry.negative) {
+      waiter->resolveError(entry.error);
+    } else {
+      waiter->resolveSuccess(entry.answer);
+    }
+  }
+  delete job;
+}
+
+void DnsCache::cancelLookup(Callback* cb) {
+  for (auto& kv : inflight_) {
+    kv.second->waiters.remove(cb);
+  }
+}
+
+void DnsCache::touch(Entry& entry, const std::string& hostname) {
+  if (entry.lruIter != lru_.begin()) {
+    lru_.erase(entry.lruIter);
+    lru_.push_front(hostname);
+    entry.lruIter = lru_.begin();
+  }
+}
+
+void DnsCache::evictIfNeeded() {
+  while (entries_.size() >= config_.capacity && !lru_.empty()) {
+    VLOG(4) << "evicting DNS entry for " << lru_.back();
+    entries_.erase(lru_.back());
+    lru_.pop_back();
+  }
+}
+
+} // namespace proxygen
@@ -0,0 +1,155 @@
+/*
+ *  Copyright (c) 2015-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#pragma once
+
+#include <chrono>
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <folly/IPAddress.h>
+#include <folly/Optional.h>
+#include <proxygen/lib/utils/Time.h>
+
+namespace proxygen {
+
+/**
+ * Asynchronous hostname resolution interface.  proxygen does not ship a
+ * resolver; applications plug in whatever they use (a c-ares wrapper, a
+ * sidecar client, etc.).  Implementations must deliver each callback
+ * exactly once, on the caller's thread, and must support cancelResolve
+ * for callers that go away mid-flight.
+ */
+class DnsResolver {
+ public:
+  struct Answer {
+    std::vector<folly::IPAddress> addrs;
+    std::chrono::seconds ttl{0};
+  };
+
+  class Callback {
+   public:
+    virtual ~Callback() {
+    }
+    virtual void resolveSuccess(Answer answer) noexcept = 0;
+    virtual void resolveError(const std::string& msg) noexcept = 0;
+  };
+
+  virtual ~DnsResolver() {
+  }
+
+  virtual void resolve(const std::string& hostname, Callback* cb) = 0;
+
+  /**
+   * Forget a callback passed to resolve() whose result has not been
+   * delivered yet.  No-op if the callback is unknown.
+   */
+  virtual void cancelResolve(Callback* /*cb*/) {
+  }
+};
+
+/**
+ * Per-worker TTL-aware DNS cache in front of a DnsResolver, with both
+ * positive and negative entries.  A fresh entry answers inline with no
+ * resolver round trip; once an entry ages past the refresh threshold a
+ * lookup still answers inline from cache but kicks a background
+ * re-resolve, so steadily used hostnames never expire out and no
+ * request ever waits on resolution after the first.  Concurrent misses
+ * for the same hostname share one in-flight resolution.
+ *
+ * Like the connectors it feeds (see ResolvingHTTPConnector), the cache
+ * is single-threaded: one instance per worker, used on its event base
+ * thread only.
+ */
+class DnsCache {
+ public:
+  struct Config {
+    // Max hostnames retained; least recently used entries are evicted
+    size_t capacity{1024};
+    // Positive TTLs from the resolver are clamped to [1s, maxTtl]
+    std::chrono::seconds maxTtl{300};
+    // How long a failed resolution suppresses retries
+    std::chrono::seconds negativeTtl{5};
+    // Fraction of the TTL after which a lookup triggers a background
+    // refresh of the still-served cached answer
+    double refreshThreshold{0.75};
+  };
+
+  using Callback = DnsResolver::Callback;
+
+  explicit DnsCache(DnsResolver* resolver, Config config = Config());
+  ~DnsCache();
+
+  DnsCache(const DnsCache&) = delete;
+  DnsCache& operator=(const DnsCache&) = delete;
+
+  /**
+   * Look up a hostname.  On a fresh cache hit (positive or negative)
+   * the callback is invoked inline before this returns; otherwise it is
+   * invoked when the shared resolution completes.  Callbacks that may
+   * be destroyed first must call cancelLookup.
+   */
+  void getAddresses(const std::string& hostname, Callback* cb);
+
+  /**
+   * Forget a callback awaiting a resolution.  No-op if it is not
+   * waiting on anything.
+   */
+  void cancelLookup(Callback* cb);
+
+  size_t size() const {
+    return entries_.size();
+  }
+
+ private:
+  // One in-flight resolution; owns the waiter list so completion can
+  // fan out to every lookup that missed while it ran
+  struct ResolveJob : public DnsResolver::Callback {
+    ResolveJob(DnsCache* cacheIn, std::string hostnameIn)
+        : cache(cacheIn), hostname(std::move(hostnameIn)) {
+    }
+    void resolveSuccess(DnsResolver::Answer answer) noexcept override {
+      cache->onResolveDone(this, std::move(answer), "");
+    }
+    void resolveError(const std::string& msg) noexcept override {
+      cache->onResolveDone(this, folly::none, msg);
+    }
+
+    DnsCache* cache;
+    std::string hostname;
+    std::list<Callback*> waiters;
+  };
+
+  struct Entry {
+    DnsResolver::Answer answer;
+    bool negative{false};
+    std::string error;
+    TimePoint expiry;
+    TimePoint refreshAt;
+    std::list<std::string>::iterator lruIter;
+  };
+
+  void startResolve(const std::string& hostname, Callback* waiter);
+  void onResolveDone(ResolveJob* job,
+                     folly::Optional<DnsResolver::Answer> answer,
+                     const std::string& error);
+  void touch(Entry& entry, const std::string& hostname);
+  void evictIfNeeded();
+
+  DnsResolver* resolver_;
+  const Config config_;
+  // Front of lru_ is the most recently used hostname
+  std::list<std::string> lru_;
+  std::unordered_map<std::string, Entry> entries_;
+  std::unordered_map<std::string, ResolveJob*> inflight_;
+};
+
+} // namespace proxygen
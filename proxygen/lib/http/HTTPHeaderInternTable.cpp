@@ -0,0 +1,133 @@
+/*
+ *  Copyright (c) 2015-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include <proxygen/lib/http/HTTPHeaderInternTable.h>
+
+#include <memory>
+#include <unordered_map>
+#include <unordered_set>
+
+#include <folly/SharedMutex.h>
+#include <folly/ThreadLocal.h>
+#include <folly/hash/Hash.h>
+
+namespace {
+
+using folly::StringPiece;
+
+// Process-wide store.  Entries are unique_ptr<std::string> so the interned
+// pointers are stable across rehashing; the map key views the stored bytes.
+struct Store {
+  std::unordered_map<StringPiece, std::unique_ptr<std::string>, folly::Hash>
+      byName;
+  std::unordered_set<const std::string*> ptrs;
+  size_t maxEntries{proxygen::HTTPHeaderInternTable::kDefaultMaxEntries};
+};
+
+folly::SharedMutex& storeLock() {
+  static folly::SharedMutex lock;
+  return lock;
+}
+
+Store& store() {
+  static Store s;
+  return s;
+}
+
+// Per-thread caches so the common case (name seen before on this thread)
+// takes no lock: a name -> pointer map for intern() and a pointer set for
+// isInterned().
+struct ThreadCache {
+  std::unordered_map<std::string, const std::string*> byName;
+  std::unordered_set<const std::string*> ptrs;
+};
+
+folly::ThreadLocal<ThreadCache>& threadCache() {
+  static folly::ThreadLocal<ThreadCache> cache;
+  return cache;
+}
+
+} // anonymous namespace
+
+namespace proxygen {
+
+std::atomic<bool> HTTPHeaderInternTable::enabled_{false};
+std::atomic<bool> HTTPHeaderInternTable::everEnabled_{false};
+
+void HTTPHeaderInternTable::enable(size_t maxEntries) {
+  folly::SharedMutex::WriteHolder holder(storeLock());
+  store().maxEntries = maxEntries;
+  everEnabled_.store(true, std::memory_order_relaxed);
+  enabled_.store(true, std::memory_order_relaxed);
+}
+
+void HTTPHeaderInternTable::disable() {
+  // Entries deliberately stay allocated so outstanding pointers remain
+  // valid; we only stop interning new names.
+  enabled_.store(false, std::memory_order_relaxed);
+}
+
+const std::string* HTTPHeaderInternTable::intern(folly::StringPiece name) {
+  if (!enabled()) {
+    return nullptr;
+  }
+  auto& cache = *threadCache();
+  auto cached = cache.byName.find(name.str());
+  if (cached != cache.byName.end()) {
+    return cached->second;
+  }
+  {
+    folly::SharedMutex::ReadHolder holder(storeLock());
+    auto it = store().byName.find(name);
+    if (it != store().byName.end()) {
+      const std::string* interned = it->second.get();
+      cache.byName.emplace(name.str(), interned);
+      cache.ptrs.insert(interned);
+      return interned;
+    }
+    if (store().byName.size() >= store().maxEntries) {
+      return nullptr;
+    }
+  }
+  folly::SharedMutex::WriteHolder holder(storeLock());
+  auto it = store().byName.find(name);
+  if (it == store().byName.end()) {
+    if (store().byName.size() >= store().maxEntries) {
+      return nullptr;
+    }
+    auto entry = std::make_unique<std::string>(name.data(), name.size());
+    StringPiece key(*entry);
+    it = store().byName.emplace(key, std::move(entry)).first;
+    store().ptrs.insert(it->second.get());
+  }
+  const std::string* interned = it->second.get();
+  cache.byName.emplace(name.str(), interned);
+  cache.ptrs.insert(interned);
+  return interned;
+}
+
+bool HTTPHeaderInternTable::isInterned(const std::string* name) {
+  if (!everEnabled_.load(std::memory_order_relaxed)) {
+    return false;
+  }
+  auto& cache = *threadCache();
+  if (cache.ptrs.count(name)) {
+    return true;
+  }
+  // The header may have been handed off from another thread; fall back to
+  // the shared set and cache a hit for next time.
+  folly::SharedMutex::ReadHolder holder(storeLock());
+  if (store().ptrs.count(name)) {
+    cache.ptrs.insert(name);
+    return true;
+  }
+  return false;
+}
+
+} // namespace proxygen
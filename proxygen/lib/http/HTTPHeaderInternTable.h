@@ -0,0 +1,77 @@
+/*
+ *  Copyright (c) 2015-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#pragma once
+
+#include <atomic>
+#include <string>
+
+#include <folly/Range.h>
+#include <proxygen/lib/utils/Export.h>
+
+namespace proxygen {
+
+/**
+ * An interning table for header names that fall outside the
+ * HTTPCommonHeaders perfect-hash set (HTTP_HEADER_OTHER), i.e. custom
+ * headers a deployment sees over and over.  intern() hands back a stable
+ * const std::string* for repeated name bytes so HTTPHeaders does not have
+ * to heap-allocate a fresh copy per message.
+ *
+ * The table is process-wide and append-only: entries are never evicted or
+ * freed, so interned pointers stay valid for the process lifetime and a
+ * message carrying them can safely cross threads.  Growth is capped; once
+ * the cap is hit, intern() returns nullptr and callers fall back to owned
+ * allocations.  Each thread keeps a lock-free cache of its hits, so the
+ * steady state does one thread-local hash lookup per unknown name.
+ *
+ * Interning is off by default; call enable() once at process startup.
+ */
+class HTTPHeaderInternTable {
+ public:
+  static const size_t kDefaultMaxEntries = 1024;
+
+  /**
+   * Turn interning on, with a cap on the number of distinct names the
+   * process will ever intern.  Call before serving traffic.
+   */
+  FB_EXPORT static void enable(size_t maxEntries = kDefaultMaxEntries);
+
+  /**
+   * Stop interning new names.  Existing entries (and the pointers handed
+   * out for them) remain valid forever, by design.
+   */
+  FB_EXPORT static void disable();
+
+  static bool enabled() {
+    return enabled_.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * Return a stable pointer for the given name bytes, interning them on
+   * first sight.  Returns nullptr if interning is disabled or the table is
+   * full; the caller then owns its allocation as usual.
+   */
+  FB_EXPORT static const std::string* intern(folly::StringPiece name);
+
+  /**
+   * True if the pointer was handed out by intern(); such names must not be
+   * deleted by their holders.  Cheap no-op when interning was never
+   * enabled.
+   */
+  FB_EXPORT static bool isInterned(const std::string* name);
+
+ private:
+  // Set once interning has ever been on; lets isInterned() short-circuit
+  // in processes that never use the table.
+  static std::atomic<bool> enabled_;
+  static std::atomic<bool> everEnabled_;
+};
+
+} // namespace proxygen
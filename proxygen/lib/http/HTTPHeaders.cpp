@@ -10,6 +10,7 @@
 #define PROXYGEN_HTTPHEADERS_IMPL
 #include <proxygen/lib/http/HTTPHeaders.h>
 
+#include <cctype>
 
 #include <glog/logging.h>
 
@@ -40,6 +41,52 @@ bitset<256>& HTTPHeaders::perHopHeaderCodes() {
   return perHopHeaderCodes;
 }
 
+uint32_t HTTPHeaders::hashName(folly::StringPiece name) {
+  // FNV-1a over lowercased bytes, so it agrees with caseInsensitiveEqual
+  uint32_t hash = 2166136261u;
+  for (char c : name) {
+    hash ^= uint8_t(tolower(c));
+    hash *= 16777619u;
+  }
+  return hash;
+}
+
+const HTTPHeaders::OverflowIndex* HTTPHeaders::getIndex() const {
+  if (index_ && index_->entries == codes_.size() &&
+      index_->deleted == deletedCount_) {
+    return index_.get();
+  }
+  if (size() <= kOverflowIndexThreshold ||
+      codes_.size() > std::numeric_limits<uint16_t>::max()) {
+    index_.reset();
+    return nullptr;
+  }
+  if (!index_) {
+    index_ = std::make_unique<OverflowIndex>();
+  } else {
+    index_->codes.fill(OverflowIndex::CodeEntry());
+    index_->uncommonNames.clear();
+  }
+  for (size_t i = 0; i < codes_.size(); ++i) {
+    const auto code = codes_[i];
+    if (code == HTTP_HEADER_NONE) {
+      continue;
+    }
+    auto& entry = index_->codes[code];
+    if (entry.count == 0) {
+      entry.firstPos = uint16_t(i);
+    }
+    entry.count++;
+    if (code == HTTP_HEADER_OTHER) {
+      // emplace keeps the earliest position when hashes collide
+      index_->uncommonNames.emplace(hashName(*headerNames_[i]), uint16_t(i));
+    }
+  }
+  index_->entries = codes_.size();
+  index_->deleted = deletedCount_;
+  return index_.get();
+}
+
 HTTPHeaders::HTTPHeaders() :
   deletedCount_(0) {
   codes_.reserve(kInitialVectorReserve);
@@ -52,7 +99,7 @@ void HTTPHeaders::add(folly::StringPiece name, folly::StringPiece value) {
   const HTTPHeaderCode code = HTTPCommonHeaders::hash(name.data(), name.size());
   codes_.push_back(code);
   headerNames_.push_back((code == HTTP_HEADER_OTHER)
-      ? new std::string(name.data(), name.size())
+      ? allocHeaderName(name)
       : HTTPCommonHeaders::getPointerToName(code));
   headerValues_.emplace_back(value.data(), value.size());
 }
@@ -76,12 +123,41 @@ void HTTPHeaders::addFromCodec(const char* str, size_t len, string&& value) {
   const HTTPHeaderCode code = HTTPCommonHeaders::hash(str, len);
   codes_.push_back(code);
   headerNames_.push_back((code == HTTP_HEADER_OTHER)
-      ? new string(str, len)
+      ? allocHeaderName(folly::StringPiece(str, len))
       : HTTPCommonHeaders::getPointerToName(code));
   headerValues_.emplace_back(
       folly::rtrimWhitespace(std::move(value)).toString());
 }
 
+void HTTPHeaders::addFromCodecBorrowed(const char* str,
+                                       size_t len,
+                                       folly::StringPiece value) {
+  const HTTPHeaderCode code = HTTPCommonHeaders::hash(str, len);
+  codes_.push_back(code);
+  headerNames_.push_back((code == HTTP_HEADER_OTHER)
+      ? allocHeaderName(folly::StringPiece(str, len))
+      : HTTPCommonHeaders::getPointerToName(code));
+  headerValues_.push_back(
+      HTTPHeaderValue::makeBorrowed(folly::rtrimWhitespace(value)));
+}
+
+bool HTTPHeaders::hasBorrowedValues() const {
+  for (size_t i = 0; i < codes_.size(); ++i) {
+    if (codes_[i] != HTTP_HEADER_NONE && headerValues_[i].isBorrowed()) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void HTTPHeaders::materializeBorrowedValues() {
+  for (size_t i = 0; i < codes_.size(); ++i) {
+    if (codes_[i] != HTTP_HEADER_NONE && headerValues_[i].isBorrowed()) {
+      headerValues_[i].materialize();
+    }
+  }
+}
+
 bool HTTPHeaders::exists(folly::StringPiece name) const {
   const HTTPHeaderCode code = HTTPCommonHeaders::hash(name.data(),
                                                       name.size());
@@ -101,6 +177,9 @@ bool HTTPHeaders::exists(HTTPHeaderCode code) const {
 }
 
 size_t HTTPHeaders::getNumberOfValues(HTTPHeaderCode code) const {
+  if (auto* index = getIndex()) {
+    return index->codes[code].count;
+  }
   size_t count = 0;
   ITERATE_OVER_CODES(code, {
       (void)pos;
@@ -126,7 +205,7 @@ bool HTTPHeaders::remove(folly::StringPiece name) {
   } else {
     bool removed = false;
     ITERATE_OVER_STRINGS(name, {
-      delete headerNames_[pos];
+      disposeHeaderName(headerNames_[pos]);
       codes_[pos] = HTTP_HEADER_NONE;
       removed = true;
       ++deletedCount_;
@@ -152,7 +231,7 @@ bool HTTPHeaders::removeAllVersions(HTTPHeaderCode code,
     removed = remove(code);
   }
   ITERATE_OVER_STRINGS_ALL_VERSION(name, {
-    delete headerNames_[pos];
+    disposeHeaderName(headerNames_[pos]);
     codes_[pos] = HTTP_HEADER_NONE;
     removed = true;
     ++deletedCount_;
@@ -161,9 +240,13 @@ bool HTTPHeaders::removeAllVersions(HTTPHeaderCode code,
 }
 
 void HTTPHeaders::disposeOfHeaderNames() {
+  if (arena_) {
+    // Arena-owned names are reclaimed wholesale by the arena's owner
+    return;
+  }
   for (size_t i = 0; i < codes_.size(); ++i) {
     if (codes_[i] == HTTP_HEADER_OTHER) {
-      delete headerNames_[i];
+      disposeHeaderName(headerNames_[i]);
     }
   }
 }
@@ -177,9 +260,10 @@ HTTPHeaders::HTTPHeaders(const HTTPHeaders& hdrs) :
   headerNames_(hdrs.headerNames_),
   headerValues_(hdrs.headerValues_),
   deletedCount_(hdrs.deletedCount_) {
+  // Copies always own their names; they do not share the source's arena
   for (size_t i = 0; i < codes_.size(); ++i) {
     if (codes_[i] == HTTP_HEADER_OTHER) {
-      headerNames_[i] = new string(*hdrs.headerNames_[i]);
+      headerNames_[i] = allocHeaderName(*hdrs.headerNames_[i]);
     }
   }
 }
@@ -188,7 +272,8 @@ HTTPHeaders::HTTPHeaders(HTTPHeaders&& hdrs) noexcept :
     codes_(std::move(hdrs.codes_)),
     headerNames_(std::move(hdrs.headerNames_)),
     headerValues_(std::move(hdrs.headerValues_)),
-    deletedCount_(hdrs.deletedCount_) {
+    deletedCount_(hdrs.deletedCount_),
+    arena_(hdrs.arena_) {
   hdrs.removeAll();
 }
 
@@ -199,9 +284,11 @@ HTTPHeaders& HTTPHeaders::operator= (const HTTPHeaders& hdrs) {
     headerNames_ = hdrs.headerNames_;
     headerValues_ = hdrs.headerValues_;
     deletedCount_ = hdrs.deletedCount_;
+    arena_ = nullptr;
+    index_.reset();
     for (size_t i = 0; i < codes_.size(); ++i) {
       if (codes_[i] == HTTP_HEADER_OTHER) {
-        headerNames_[i] = new string(*hdrs.headerNames_[i]);
+        headerNames_[i] = allocHeaderName(*hdrs.headerNames_[i]);
       }
     }
   }
@@ -214,6 +301,8 @@ HTTPHeaders& HTTPHeaders::operator= (HTTPHeaders&& hdrs) {
     headerNames_ = std::move(hdrs.headerNames_);
     headerValues_ = std::move(hdrs.headerValues_);
     deletedCount_ = hdrs.deletedCount_;
+    arena_ = hdrs.arena_;
+    index_.reset();
 
     hdrs.removeAll();
   }
@@ -243,8 +332,15 @@ HTTPHeaders::transferHeaderIfPresent(folly::StringPiece name,
   if (code == HTTP_HEADER_OTHER) {
     ITERATE_OVER_STRINGS(name, {
       strippedHeaders.codes_.push_back(HTTP_HEADER_OTHER);
-      // in the next line, ownership of pointer goes to strippedHeaders
-      strippedHeaders.headerNames_.push_back(headerNames_[pos]);
+      // Ownership of the name goes to strippedHeaders; if the two groups
+      // have different allocators the name must be re-allocated there
+      if (arena_ == strippedHeaders.arena_) {
+        strippedHeaders.headerNames_.push_back(headerNames_[pos]);
+      } else {
+        strippedHeaders.headerNames_.push_back(
+            strippedHeaders.allocHeaderName(*headerNames_[pos]));
+        disposeHeaderName(headerNames_[pos]);
+      }
       strippedHeaders.headerValues_.push_back(headerValues_[pos]);
       codes_[pos] = HTTP_HEADER_NONE;
       transferred = true;
@@ -314,7 +410,14 @@ HTTPHeaders::stripPerHopHeaders(HTTPHeaders& strippedHeaders) {
   for (size_t i = 0; i < codes_.size(); ++i) {
     if (perHopHeaders[codes_[i]]) {
       strippedHeaders.codes_.push_back(codes_[i]);
-      strippedHeaders.headerNames_.push_back(headerNames_[i]);
+      if (codes_[i] == HTTP_HEADER_OTHER &&
+          arena_ != strippedHeaders.arena_) {
+        strippedHeaders.headerNames_.push_back(
+            strippedHeaders.allocHeaderName(*headerNames_[i]));
+        disposeHeaderName(headerNames_[i]);
+      } else {
+        strippedHeaders.headerNames_.push_back(headerNames_[i]);
+      }
       strippedHeaders.headerValues_.push_back(headerValues_[i]);
       codes_[i] = HTTP_HEADER_NONE;
       ++deletedCount_;
@@ -328,7 +431,7 @@ void HTTPHeaders::copyTo(HTTPHeaders& hdrs) const {
     if (codes_[i] != HTTP_HEADER_NONE) {
       hdrs.codes_.push_back(codes_[i]);
       hdrs.headerNames_.push_back((codes_[i] == HTTP_HEADER_OTHER) ?
-          new string(*headerNames_[i]) : headerNames_[i]);
+          hdrs.allocHeaderName(*headerNames_[i]) : headerNames_[i]);
       hdrs.headerValues_.push_back(headerValues_[i]);
     }
   }
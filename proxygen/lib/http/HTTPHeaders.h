@@ -13,13 +13,19 @@
 #include <folly/Range.h>
 #include <folly/String.h>
 #include <proxygen/lib/http/HTTPCommonHeaders.h>
+#include <proxygen/lib/http/HTTPHeaderInternTable.h>
 #include <proxygen/lib/utils/Export.h>
+#include <proxygen/lib/utils/StringArena.h>
 #include <proxygen/lib/utils/UtilInl.h>
 
+#include <array>
 #include <bitset>
 #include <cstring>
+#include <limits>
+#include <memory>
 #include <string>
 #include <initializer_list>
+#include <unordered_map>
 
 namespace proxygen {
 
@@ -37,6 +43,68 @@ inline bool isLWS(char c) {
   return false;
 }
 
+/**
+ * Storage for a single header value.  Normally the value is an owned
+ * std::string, but values added via HTTPHeaders::addFromCodecBorrowed() are
+ * StringPiece views pinned to the ingress buffer the codec parsed from; a
+ * pure pass-through never copies the bytes.  A borrowed value is lazily
+ * materialized into an owned string the first time someone asks for it as a
+ * std::string, and HTTPHeaders::materializeBorrowedValues() provides the
+ * clone-on-detach escape hatch for when the ingress buffer is about to go
+ * away.
+ */
+class HTTPHeaderValue {
+ public:
+  HTTPHeaderValue() : owned_(true) {}
+  /* implicit */ HTTPHeaderValue(std::string&& value)
+      : value_(std::move(value)), owned_(true) {}
+  /* implicit */ HTTPHeaderValue(const std::string& value)
+      : value_(value), owned_(true) {}
+  /* implicit */ HTTPHeaderValue(folly::StringPiece value)
+      : value_(value.data(), value.size()), owned_(true) {}
+  HTTPHeaderValue(const char* data, size_t len)
+      : value_(data, len), owned_(true) {}
+
+  static HTTPHeaderValue makeBorrowed(folly::StringPiece value) {
+    HTTPHeaderValue v;
+    v.borrow_ = value;
+    v.owned_ = false;
+    return v;
+  }
+
+  /**
+   * The value as an owned string; materializes a borrowed value on first
+   * use.
+   */
+  const std::string& str() const {
+    if (!owned_) {
+      materialize();
+    }
+    return value_;
+  }
+
+  /**
+   * The value bytes without copying, whether owned or borrowed.
+   */
+  folly::StringPiece piece() const {
+    return owned_ ? folly::StringPiece(value_) : borrow_;
+  }
+
+  bool isBorrowed() const {
+    return !owned_;
+  }
+
+  void materialize() const {
+    value_.assign(borrow_.data(), borrow_.size());
+    owned_ = true;
+  }
+
+ private:
+  mutable std::string value_;
+  folly::StringPiece borrow_;
+  mutable bool owned_;
+};
+
 /**
  * A collection of HTTP headers.
  *
@@ -113,6 +181,26 @@ class HTTPHeaders {
 
   void addFromCodec(const char* str, size_t len, std::string&& value);
 
+  /**
+   * Add a header whose value is a borrowed view into the ingress buffer the
+   * codec parsed from.  The caller must guarantee the buffer outlives this
+   * collection, or call materializeBorrowedValues() before it goes away.
+   */
+  void addFromCodecBorrowed(const char* str,
+                            size_t len,
+                            folly::StringPiece value);
+
+  /**
+   * True if any value is still a borrowed view into an ingress buffer.
+   */
+  bool hasBorrowedValues() const;
+
+  /**
+   * Clone-on-detach: copy every borrowed value into owned storage so the
+   * collection no longer references the ingress buffer.
+   */
+  void materializeBorrowedValues();
+
   /**
    * For the header 'name', set its value to the single header 'value',
    * removing any other instances of this header.
@@ -185,6 +273,14 @@ class HTTPHeaders {
   template <typename LAMBDA>
   inline void forEachWithCode(LAMBDA func) const;
 
+  /**
+   * Like forEachWithCode, but hands the value out as a StringPiece without
+   * materializing borrowed values; the zero-copy counterpart for egress
+   * paths that only need to look at (or re-encode) the bytes.
+   */
+  template <typename LAMBDA>
+  inline void forEachWithCodePiece(LAMBDA func) const;
+
   /**
    * Process the list of all headers, in the order that they were seen:
    * for each header:value pair, the function/functor/lambda-expression
@@ -279,6 +375,18 @@ class HTTPHeaders {
    */
   static std::bitset<256>& perHopHeaderCodes();
 
+  /**
+   * Draw all subsequently-added uncommon header names from the given arena
+   * instead of the heap.  The arena must outlive this object (or at least
+   * every name added while it was set) and must be set while the collection
+   * is empty.  Copies of this object always own their names; moves carry the
+   * arena along.
+   */
+  void setArena(StringArena* arena) {
+    assert(codes_.empty());
+    arena_ = arena;
+  }
+
  private:
   // vector storing the 1-byte hashes of header names
   folly::fbvector<HTTPHeaderCode> codes_;
@@ -289,16 +397,86 @@ class HTTPHeaders {
    */
   folly::fbvector<const std::string *> headerNames_;
 
-  folly::fbvector<std::string> headerValues_;
+  folly::fbvector<HTTPHeaderValue> headerValues_;
 
   size_t deletedCount_;
 
+  /**
+   * Optional bump allocator for uncommon header names; nullptr means names
+   * are individually heap-allocated and owned as before.
+   */
+  StringArena* arena_{nullptr};
+
   /**
    * The initial capacity of the three vectors, reserved right after
    * construction.
    */
   static const size_t kInitialVectorReserve = 16;
 
+  /**
+   * Live entry count above which lookups build the overflow index.  The
+   * memchr scan wins below this.
+   */
+  static const size_t kOverflowIndexThreshold = 16;
+
+  /**
+   * Lookup accelerator for collections that outgrow the linear scan
+   * (gateways annotate requests past 60 headers).  Per header code it
+   * holds the first position and live count, so a lookup knows instantly
+   * whether the header exists and where to start scanning; uncommon
+   * names go through a case-insensitive hash map to their first
+   * position.  The index is a pure cache over the parallel vectors:
+   * it records the entry/deleted counts it was built against and is
+   * rebuilt lazily whenever they have moved on, so mutations never
+   * maintain it and iteration order is untouched.
+   */
+  struct OverflowIndex {
+    struct CodeEntry {
+      uint16_t firstPos{0};
+      uint16_t count{0};
+    };
+    std::array<CodeEntry, 256> codes{};
+    // case-insensitive name hash -> earliest position with that hash
+    std::unordered_map<uint32_t, uint16_t> uncommonNames;
+    uint32_t entries{0};
+    uint32_t deleted{0};
+  };
+
+  mutable std::unique_ptr<OverflowIndex> index_;
+
+  static uint32_t hashName(folly::StringPiece name);
+
+  /**
+   * Returns a current overflow index, (re)building it if the collection
+   * is large enough, or nullptr when the linear scan should be used.
+   */
+  const OverflowIndex* getIndex() const;
+
+  /**
+   * Allocate storage for an uncommon header name, preferring the intern
+   * table when enabled, then the arena when one is attached.
+   */
+  const std::string* allocHeaderName(folly::StringPiece name) {
+    if (HTTPHeaderInternTable::enabled()) {
+      if (auto interned = HTTPHeaderInternTable::intern(name)) {
+        return interned;
+      }
+    }
+    return arena_ ? arena_->newString(name)
+                  : new std::string(name.data(), name.size());
+  }
+
+  /**
+   * Release an uncommon header name previously obtained from
+   * allocHeaderName(); interned names live for the process lifetime and
+   * arena-owned names are reclaimed wholesale instead.
+   */
+  void disposeHeaderName(const std::string* name) {
+    if (!arena_ && !HTTPHeaderInternTable::isInterned(name)) {
+      delete name;
+    }
+  }
+
   /**
    * Moves the named header and values from this group to the destination
    * group.  No-op if the header doesn't exist.  Returns true if header(s) were
@@ -318,7 +496,7 @@ void HTTPHeaders::add(folly::StringPiece name, T&& value) {
   const HTTPHeaderCode code = HTTPCommonHeaders::hash(name.data(), name.size());
   codes_.push_back(code);
   headerNames_.push_back((code == HTTP_HEADER_OTHER)
-      ? new std::string(name.data(), name.size())
+      ? allocHeaderName(name)
       : HTTPCommonHeaders::getPointerToName(code));
   auto s = folly::rtrimWhitespace(std::forward<T>(value));
   headerValues_.emplace_back(s);
@@ -366,7 +544,7 @@ template <typename LAMBDA> // (const string &, const string &) -> void
 void HTTPHeaders::forEach(LAMBDA func) const {
   for (size_t i = 0; i < codes_.size(); ++i) {
     if (codes_[i] != HTTP_HEADER_NONE) {
-      func(*headerNames_[i], headerValues_[i]);
+      func(*headerNames_[i], headerValues_[i].str());
     }
   }
 }
@@ -375,7 +553,16 @@ template <typename LAMBDA>
 void HTTPHeaders::forEachWithCode(LAMBDA func) const {
   for (size_t i = 0; i < codes_.size(); ++i) {
     if (codes_[i] != HTTP_HEADER_NONE) {
-      func(codes_[i], *headerNames_[i], headerValues_[i]);
+      func(codes_[i], *headerNames_[i], headerValues_[i].str());
+    }
+  }
+}
+
+template <typename LAMBDA>
+void HTTPHeaders::forEachWithCodePiece(LAMBDA func) const {
+  for (size_t i = 0; i < codes_.size(); ++i) {
+    if (codes_[i] != HTTP_HEADER_NONE) {
+      func(codes_[i], *headerNames_[i], headerValues_[i].piece());
     }
   }
 }
@@ -387,8 +574,25 @@ bool HTTPHeaders::forEachValueOfHeader(folly::StringPiece name,
   if (code != HTTP_HEADER_OTHER) {
     return forEachValueOfHeader(code, func);
   } else {
+    if (auto* index = getIndex()) {
+      auto it = index->uncommonNames.find(hashName(name));
+      if (it == index->uncommonNames.end()) {
+        return false;
+      }
+      // the stored position is the earliest of any name sharing the hash,
+      // so a forward scan from it sees every occurrence of this name
+      for (size_t pos = it->second; pos < codes_.size(); ++pos) {
+        if (codes_[pos] == HTTP_HEADER_OTHER &&
+            caseInsensitiveEqual(name, *headerNames_[pos])) {
+          if (func(headerValues_[pos].str())) {
+            return true;
+          }
+        }
+      }
+      return false;
+    }
     ITERATE_OVER_STRINGS(name, {
-      if (func(headerValues_[pos])) {
+      if (func(headerValues_[pos].str())) {
         return true;
       }
     });
@@ -399,8 +603,21 @@ bool HTTPHeaders::forEachValueOfHeader(folly::StringPiece name,
 template <typename LAMBDA> // const string & -> bool
 bool HTTPHeaders::forEachValueOfHeader(HTTPHeaderCode code,
                                        LAMBDA func) const {
+  if (auto* index = getIndex()) {
+    const auto& entry = index->codes[code];
+    size_t seen = 0;
+    for (size_t pos = entry.firstPos; seen < entry.count; ++pos) {
+      if (codes_[pos] == code) {
+        ++seen;
+        if (func(headerValues_[pos].str())) {
+          return true;
+        }
+      }
+    }
+    return false;
+  }
   ITERATE_OVER_CODES(code, {
-    if (func(headerValues_[pos])) {
+    if (func(headerValues_[pos].str())) {
       return true;
     }
   });
@@ -428,12 +645,12 @@ bool HTTPHeaders::removeByPredicate(LAMBDA func) {
   bool removed = false;
   for (size_t i = 0; i < codes_.size(); ++i) {
     if (codes_[i] == HTTP_HEADER_NONE ||
-        !func(codes_[i], *headerNames_[i], headerValues_[i])) {
+        !func(codes_[i], *headerNames_[i], headerValues_[i].str())) {
       continue;
     }
 
     if (codes_[i] == HTTP_HEADER_OTHER) {
-      delete headerNames_[i];
+      disposeHeaderName(headerNames_[i]);
       headerNames_[i] = nullptr;
     }
 
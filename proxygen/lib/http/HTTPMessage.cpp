@@ -9,10 +9,13 @@
  */
 #include <proxygen/lib/http/HTTPMessage.h>
 
+#include <algorithm>
 #include <boost/algorithm/string.hpp>
 #include <folly/Format.h>
 #include <folly/Range.h>
 #include <folly/SingletonThreadLocal.h>
+#include <proxygen/lib/utils/HTTPTime.h>
+#include <proxygen/lib/utils/URLScan.h>
 #include <string>
 #include <vector>
 
@@ -66,7 +69,7 @@ HTTPMessage::HTTPMessage() :
     fields_(),
     version_(1,0),
     sslVersion_(0), sslCipher_(nullptr), protoStr_(nullptr), pri_(0),
-    parsedCookies_(false), parsedQueryParams_(false),
+    parsedCookies_(false), parsedURL_(true), parsedQueryParams_(false),
     chunked_(false), upgraded_(false), wantsKeepalive_(true),
     trailersAllowed_(false), secure_(false), partiallyReliable_(false),
     upgradeWebsocket_(HTTPMessage::WebSocketUpgrade::NONE) {
@@ -84,7 +87,6 @@ HTTPMessage::HTTPMessage(const HTTPMessage& message) :
     localIP_(message.localIP_),
     versionStr_(message.versionStr_),
     fields_(message.fields_),
-    cookies_(message.cookies_),
     queryParams_(message.queryParams_),
     version_(message.version_),
     headers_(message.headers_),
@@ -94,7 +96,9 @@ HTTPMessage::HTTPMessage(const HTTPMessage& message) :
     protoStr_(message.protoStr_),
     pri_(message.pri_),
     h2Pri_(message.h2Pri_),
-    parsedCookies_(message.parsedCookies_),
+    // cookies_ indexes the source's header storage; rebuild on demand
+    parsedCookies_(false),
+    parsedURL_(message.parsedURL_),
     parsedQueryParams_(message.parsedQueryParams_),
     chunked_(message.chunked_),
     upgraded_(message.upgraded_),
@@ -106,6 +110,21 @@ HTTPMessage::HTTPMessage(const HTTPMessage& message) :
   if (message.trailers_) {
     trailers_ = std::make_unique<HTTPHeaders>(*message.trailers_);
   }
+  if (message.metadataHeaders_) {
+    metadataHeaders_ = std::make_unique<HTTPHeaders>(*message.metadataHeaders_);
+  }
+  headerBlockReusable_ = message.headerBlockReusable_;
+  if (message.reusableHeaderBlock_) {
+    reusableHeaderBlock_ = message.reusableHeaderBlock_->clone();
+    reusableHeaderBlockSize_ = message.reusableHeaderBlockSize_;
+  }
+  contentLength_ = message.contentLength_;
+  maxForwards_ = message.maxForwards_;
+  maxForwardsState_ = message.maxForwardsState_;
+  connectionTokens_ = message.connectionTokens_;
+  parsedContentLength_ = message.parsedContentLength_;
+  hasContentLength_ = message.hasContentLength_;
+  parsedConnectionTokens_ = message.parsedConnectionTokens_;
 }
 
 HTTPMessage::HTTPMessage(HTTPMessage&& message) noexcept :
@@ -117,18 +136,21 @@ HTTPMessage::HTTPMessage(HTTPMessage&& message) noexcept :
     localIP_(std::move(message.localIP_)),
     versionStr_(std::move(message.versionStr_)),
     fields_(std::move(message.fields_)),
-    cookies_(std::move(message.cookies_)),
     queryParams_(std::move(message.queryParams_)),
     version_(message.version_),
+    arena_(std::move(message.arena_)),
     headers_(std::move(message.headers_)),
     strippedPerHopHeaders_(std::move(message.strippedPerHopHeaders_)),
     trailers_(std::move(message.trailers_)),
+    metadataHeaders_(std::move(message.metadataHeaders_)),
     sslVersion_(message.sslVersion_),
     sslCipher_(message.sslCipher_),
     protoStr_(message.protoStr_),
     pri_(message.pri_),
     h2Pri_(message.h2Pri_),
-    parsedCookies_(message.parsedCookies_),
+    // cookies_ indexes the source's header storage; rebuild on demand
+    parsedCookies_(false),
+    parsedURL_(message.parsedURL_),
     parsedQueryParams_(message.parsedQueryParams_),
     chunked_(message.chunked_),
     upgraded_(message.upgraded_),
@@ -137,6 +159,16 @@ HTTPMessage::HTTPMessage(HTTPMessage&& message) noexcept :
     secure_(message.secure_),
     partiallyReliable_(message.partiallyReliable_),
     upgradeWebsocket_(message.upgradeWebsocket_) {
+  headerBlockReusable_ = message.headerBlockReusable_;
+  reusableHeaderBlock_ = std::move(message.reusableHeaderBlock_);
+  reusableHeaderBlockSize_ = message.reusableHeaderBlockSize_;
+  contentLength_ = message.contentLength_;
+  maxForwards_ = message.maxForwards_;
+  maxForwardsState_ = message.maxForwardsState_;
+  connectionTokens_ = message.connectionTokens_;
+  parsedContentLength_ = message.parsedContentLength_;
+  hasContentLength_ = message.hasContentLength_;
+  parsedConnectionTokens_ = message.parsedConnectionTokens_;
 }
 
 HTTPMessage& HTTPMessage::operator=(const HTTPMessage& message) {
@@ -151,9 +183,9 @@ HTTPMessage& HTTPMessage::operator=(const HTTPMessage& message) {
   localIP_ = message.localIP_;
   versionStr_ = message.versionStr_;
   fields_ = message.fields_;
-  cookies_ = message.cookies_;
   queryParams_ = message.queryParams_;
   version_ = message.version_;
+  arena_.reset();
   headers_ = message.headers_;
   strippedPerHopHeaders_ = message.strippedPerHopHeaders_;
   sslVersion_ = message.sslVersion_;
@@ -161,7 +193,9 @@ HTTPMessage& HTTPMessage::operator=(const HTTPMessage& message) {
   protoStr_ = message.protoStr_;
   pri_ = message.pri_;
   h2Pri_ = message.h2Pri_;
-  parsedCookies_ = message.parsedCookies_;
+  // cookies_ indexes the source's header storage; rebuild on demand
+  unparseCookies();
+  parsedURL_ = message.parsedURL_;
   parsedQueryParams_ = message.parsedQueryParams_;
   chunked_ = message.chunked_;
   upgraded_ = message.upgraded_;
@@ -175,6 +209,25 @@ HTTPMessage& HTTPMessage::operator=(const HTTPMessage& message) {
   } else {
     trailers_.reset();
   }
+  if (message.metadataHeaders_) {
+    metadataHeaders_ = std::make_unique<HTTPHeaders>(*message.metadataHeaders_);
+  } else {
+    metadataHeaders_.reset();
+  }
+  headerBlockReusable_ = message.headerBlockReusable_;
+  if (message.reusableHeaderBlock_) {
+    reusableHeaderBlock_ = message.reusableHeaderBlock_->clone();
+    reusableHeaderBlockSize_ = message.reusableHeaderBlockSize_;
+  } else {
+    reusableHeaderBlock_.reset();
+  }
+  contentLength_ = message.contentLength_;
+  maxForwards_ = message.maxForwards_;
+  maxForwardsState_ = message.maxForwardsState_;
+  connectionTokens_ = message.connectionTokens_;
+  parsedContentLength_ = message.parsedContentLength_;
+  hasContentLength_ = message.hasContentLength_;
+  parsedConnectionTokens_ = message.parsedConnectionTokens_;
   return *this;
 }
 
@@ -190,9 +243,9 @@ HTTPMessage& HTTPMessage::operator=(HTTPMessage&& message) {
   localIP_ = std::move(message.localIP_);
   versionStr_ = std::move(message.versionStr_);
   fields_ = std::move(message.fields_);
-  cookies_ = std::move(message.cookies_);
   queryParams_ = std::move(message.queryParams_);
   version_ = message.version_;
+  arena_ = std::move(message.arena_);
   headers_ = std::move(message.headers_);
   strippedPerHopHeaders_ = std::move(message.strippedPerHopHeaders_);
   sslVersion_ = message.sslVersion_;
@@ -200,7 +253,9 @@ HTTPMessage& HTTPMessage::operator=(HTTPMessage&& message) {
   protoStr_ = message.protoStr_;
   pri_ = message.pri_;
   h2Pri_ = message.h2Pri_;
-  parsedCookies_ = message.parsedCookies_;
+  // cookies_ indexes the source's header storage; rebuild on demand
+  unparseCookies();
+  parsedURL_ = message.parsedURL_;
   parsedQueryParams_ = message.parsedQueryParams_;
   chunked_ = message.chunked_;
   upgraded_ = message.upgraded_;
@@ -210,6 +265,17 @@ HTTPMessage& HTTPMessage::operator=(HTTPMessage&& message) {
   upgradeWebsocket_ = message.upgradeWebsocket_;
 
   trailers_ = std::move(message.trailers_);
+  metadataHeaders_ = std::move(message.metadataHeaders_);
+  headerBlockReusable_ = message.headerBlockReusable_;
+  reusableHeaderBlock_ = std::move(message.reusableHeaderBlock_);
+  reusableHeaderBlockSize_ = message.reusableHeaderBlockSize_;
+  contentLength_ = message.contentLength_;
+  maxForwards_ = message.maxForwards_;
+  maxForwardsState_ = message.maxForwardsState_;
+  connectionTokens_ = message.connectionTokens_;
+  parsedContentLength_ = message.parsedContentLength_;
+  hasContentLength_ = message.hasContentLength_;
+  parsedConnectionTokens_ = message.parsedConnectionTokens_;
   return *this;
 }
 
@@ -263,25 +329,54 @@ const pair<uint8_t, uint8_t>& HTTPMessage::getHTTPVersion() const {
   return version_;
 }
 
+void HTTPMessage::parseMaxForwards() const {
+  const string& value = headers_.getSingleOrEmpty(HTTP_HEADER_MAX_FORWARDS);
+  if (value.empty()) {
+    maxForwardsState_ = MaxForwardsState::ABSENT;
+    return;
+  }
+  try {
+    maxForwards_ = folly::to<int64_t>(value);
+    maxForwardsState_ = MaxForwardsState::VALID;
+  } catch (const std::range_error& ex) {
+    maxForwardsState_ = MaxForwardsState::MALFORMED;
+  }
+}
+
+folly::Optional<int64_t> HTTPMessage::getMaxForwards() const {
+  if (maxForwardsState_ == MaxForwardsState::NOT_PARSED) {
+    parseMaxForwards();
+  }
+  if (maxForwardsState_ == MaxForwardsState::VALID) {
+    return maxForwards_;
+  }
+  return folly::none;
+}
+
 int HTTPMessage::processMaxForwards() {
   if (getMethod() == HTTPMethod::TRACE || getMethod()  == HTTPMethod::OPTIONS) {
-    const string& value = headers_.getSingleOrEmpty(HTTP_HEADER_MAX_FORWARDS);
-    if (value.length() > 0) {
-      int64_t max_forwards = 0;
-      try {
-        max_forwards = folly::to<int64_t>(value);
-      } catch (const std::range_error& ex) {
-        return 400;
-      }
-
-      if (max_forwards < 0) {
+    if (maxForwardsState_ == MaxForwardsState::NOT_PARSED) {
+      parseMaxForwards();
+    }
+    switch (maxForwardsState_) {
+      case MaxForwardsState::ABSENT:
+        break;
+      case MaxForwardsState::MALFORMED:
         return 400;
-      } else if (max_forwards == 0) {
-        return 501;
-      } else {
-        headers_.set(HTTP_HEADER_MAX_FORWARDS,
-                     folly::to<string>(max_forwards - 1));
-      }
+      case MaxForwardsState::VALID:
+        if (maxForwards_ < 0) {
+          return 400;
+        } else if (maxForwards_ == 0) {
+          return 501;
+        } else {
+          // keep the cached value in sync with the rewritten header
+          maxForwards_ -= 1;
+          headers_.set(HTTP_HEADER_MAX_FORWARDS,
+                       folly::to<string>(maxForwards_));
+        }
+        break;
+      case MaxForwardsState::NOT_PARSED:
+        break;
     }
   }
   return 0;
@@ -305,12 +400,7 @@ struct FormattedDate {
       std::chrono::system_clock::now());
 
     if (now != lastTime) {
-      char buff[1024];
-      tm timeTupple;
-      gmtime_r(&now, &timeTupple);
-
-      strftime(buff, 1024, "%a, %d %b %Y %H:%M:%S %Z", &timeTupple);
-      date = std::string(buff);
+      date = formatHTTPDateTime(now);
       lastTime = now;
     }
     return date;
@@ -386,11 +476,19 @@ void HTTPMessage::parseCookies() const {
                                 [&](const string& headerval) {
     splitNameValuePieces(headerval, ';', '=',
         [this](StringPiece cookieName, StringPiece cookieValue) {
-          cookies_.emplace(cookieName, cookieValue);
+          cookies_.emplace_back(cookieName, cookieValue);
         });
 
     return false; // continue processing "cookie" headers
   });
+  // Stable so a duplicated name keeps its first occurrence in front,
+  // matching what the old map's emplace() kept
+  std::stable_sort(cookies_.begin(),
+                   cookies_.end(),
+                   [](const std::pair<StringPiece, StringPiece>& a,
+                      const std::pair<StringPiece, StringPiece>& b) {
+                     return a.first < b.first;
+                   });
 }
 
 void HTTPMessage::unparseCookies() const {
@@ -399,24 +497,49 @@ void HTTPMessage::unparseCookies() const {
 }
 
 const StringPiece HTTPMessage::getCookie(const string& name) const {
- // clear previous parsed cookies.  They might store raw pointers to a vector
-  // in headers_, which can resize on add()
-  // Parse the cookies if we haven't done so yet
-  unparseCookies();
   if (!parsedCookies_) {
     parseCookies();
   }
 
-  auto it = cookies_.find(name);
-  if (it == cookies_.end()) {
+  auto it = std::lower_bound(
+      cookies_.begin(),
+      cookies_.end(),
+      StringPiece(name),
+      [](const std::pair<StringPiece, StringPiece>& entry, StringPiece key) {
+        return entry.first < key;
+      });
+  if (it == cookies_.end() || it->first != StringPiece(name)) {
     return StringPiece();
+  }
+  return it->second;
+}
+
+const std::vector<std::pair<StringPiece, StringPiece>>&
+HTTPMessage::getCookies() const {
+  if (!parsedCookies_) {
+    parseCookies();
+  }
+  return cookies_;
+}
+
+void HTTPMessage::parseURL() const {
+  DCHECK(!parsedURL_);
+  parsedURL_ = true;
+
+  const Request& req = request();
+  ParseURL u(req.url_);
+  if (u.valid()) {
+    VLOG(9) << "set path: " << u.path() << " query:" << u.query();
+    req.path_ = u.path().str();
+    req.query_ = u.query().str();
   } else {
-    return it->second;
+    VLOG(4) << "Error in parsing URL: " << req.url_;
   }
 }
 
 void HTTPMessage::parseQueryParams() const {
   DCHECK(!parsedQueryParams_);
+  ensureURLParsed();
   const Request& req = request();
 
   parsedQueryParams_ = true;
@@ -483,10 +606,8 @@ std::string HTTPMessage::getDecodedQueryParam(const std::string& name) const {
   auto val = getQueryParam(name);
 
   std::string result;
-  try {
-    folly::uriUnescape(val, result, folly::UriEscapeMode::QUERY);
-  } catch (const std::exception& ex) {
-    LOG(WARNING) << "Invalid escaped query param: " << folly::exceptionStr(ex);
+  if (!urlUnescapeQuery(result, val)) {
+    LOG(WARNING) << "Invalid escaped query param: " << name;
   }
   return result;
 }
@@ -694,6 +815,7 @@ void HTTPMessage::describe(std::ostream& os) const {
 
   if (fields_.type() == typeid(Request)) {
     // Request fields.
+    ensureURLParsed();
     const Request& req = request();
     fields.push_back(make_pair("client_ip", &req.clientIP_));
     fields.push_back(make_pair("client_port", &req.clientPort_));
@@ -756,7 +878,7 @@ bool HTTPMessage::computeKeepalive() const {
   //
   // Note that we only perform ASCII lowering here.  This is good enough,
   // since the token we are looking for is ASCII.
-  if (checkForHeaderToken(HTTP_HEADER_CONNECTION, "close", false)) {
+  if (hasConnectionToken(CONN_CLOSE)) {
     // The Connection header contained a "close" token, so keepalive
     // is disabled.
     return false;
@@ -766,8 +888,7 @@ bool HTTPMessage::computeKeepalive() const {
   if (version_ == kHTTPVersion10) {
       // HTTP 1.0 persistent connections require a Connection: Keep-Alive
       // header to be present for the connection to be persistent.
-      if (checkForHeaderToken(
-              HTTP_HEADER_CONNECTION, kKeepAliveConnToken.c_str(), false) ||
+      if (hasConnectionToken(CONN_KEEP_ALIVE) ||
           doHeaderTokenCheck(strippedPerHopHeaders_,
                              HTTP_HEADER_CONNECTION,
                              kKeepAliveConnToken.c_str(),
@@ -787,6 +908,105 @@ bool HTTPMessage::checkForHeaderToken(const HTTPHeaderCode headerCode,
   return doHeaderTokenCheck(headers_, headerCode, token, caseSensitive);
 }
 
+folly::Optional<uint64_t> HTTPMessage::getContentLength() const {
+  if (!parsedContentLength_) {
+    parsedContentLength_ = true;
+    const string& value =
+        headers_.getSingleOrEmpty(HTTP_HEADER_CONTENT_LENGTH);
+    if (!value.empty()) {
+      try {
+        contentLength_ = folly::to<uint64_t>(value);
+        hasContentLength_ = true;
+      } catch (const folly::ConversionError& ex) {
+        LOG(ERROR) << "Invalid content-length: " << value
+                   << ", ex=" << ex.what();
+      }
+    }
+  }
+  if (hasContentLength_) {
+    return contentLength_;
+  }
+  return folly::none;
+}
+
+uint8_t HTTPMessage::parseConnectionTokens() const {
+  uint8_t mask = 0;
+  headers_.forEachValueOfHeader(
+      HTTP_HEADER_CONNECTION, [&mask] (const string& value) {
+    // We only perform ASCII lowering, same as doHeaderTokenCheck()
+    string lower = value;
+    boost::to_lower(lower, defaultLocale);
+    StringPiece remainder(lower);
+    while (!remainder.empty()) {
+      auto comma = remainder.find(',');
+      StringPiece token = remainder.subpiece(0, comma);
+      if (comma == StringPiece::npos) {
+        remainder.clear();
+      } else {
+        remainder.advance(comma + 1);
+      }
+      while (!token.empty() && isLWS(token.front())) {
+        token.pop_front();
+      }
+      while (!token.empty() && isLWS(token.back())) {
+        token.subtract(1);
+      }
+      if (token == "close") {
+        mask |= CONN_CLOSE;
+      } else if (token == "keep-alive") {
+        mask |= CONN_KEEP_ALIVE;
+      } else if (token == "upgrade") {
+        mask |= CONN_UPGRADE;
+      }
+    }
+    return false; // continue processing "Connection" headers
+  });
+  return mask;
+}
+
+bool HTTPMessage::hasConnectionToken(ConnectionToken token) const {
+  if (!parsedConnectionTokens_) {
+    connectionTokens_ = parseConnectionTokens();
+    parsedConnectionTokens_ = true;
+  }
+  return connectionTokens_ & token;
+}
+
+std::shared_ptr<const HTTPMessage> HTTPMessage::makeImmutableShared(
+    HTTPMessage msg) {
+  auto shared = std::make_shared<HTTPMessage>(std::move(msg));
+  shared->prepareForSharing();
+  return shared;
+}
+
+void HTTPMessage::prepareForSharing() {
+  // Every lazily-built cache is written through a const accessor on
+  // first use; build them all now so concurrent const readers on other
+  // session threads never observe a write
+  headers_.materializeBorrowedValues();
+  if (isRequest()) {
+    ensureURLParsed();
+    getMethod();
+    if (!parsedQueryParams_) {
+      parseQueryParams();
+    }
+    getClientIP();
+    getClientPort();
+  }
+  if (!parsedCookies_) {
+    parseCookies();
+  }
+  getDstIP();
+  getDstPort();
+  getContentLength();
+  getMaxForwards();
+  hasConnectionToken(CONN_CLOSE);
+  // A block cached on the source rides along; set the flag directly
+  // since setHeaderBlockReusable() would drop it
+  headerBlockReusable_ = true;
+  immutableShared_ = true;
+}
+
 bool HTTPMessage::doHeaderTokenCheck(const HTTPHeaders& headers,
                                      const HTTPHeaderCode headerCode,
                                      char const* token,
@@ -210,6 +210,7 @@ class HTTPMessage {
     }
 
     request().url_ = std::forward<T>(url);
+    parsedURL_ = true;
     return u;
   }
   // The template function above doesn't work with char*,
@@ -217,6 +218,29 @@ class HTTPMessage {
   void setURL(const char* url) {
     setURL(std::string(url));
   }
+
+  /**
+   * Set the URL without decomposing it (fpreq)
+   *
+   * Unlike setURL, this defers running ParseURL until the path or query
+   * string is actually accessed, which skips the decomposition entirely for
+   * handlers that only look at the raw URL (or nothing at all).  Prefer
+   * this on hot ingress paths; use setURL when the caller needs the
+   * ParseURL result right away.
+   */
+  template <typename T> // T = string
+  void setURLLazy(T&& url) {
+    VLOG(9) << "setURLLazy: " << url;
+    auto& req = request();
+    req.path_.clear();
+    req.query_.clear();
+    unparseQueryParams();
+    req.url_ = std::forward<T>(url);
+    parsedURL_ = false;
+  }
+  void setURLLazy(const char* url) {
+    setURLLazy(std::string(url));
+  }
   const std::string& getURL() const {
     return request().url_;
   }
@@ -228,6 +252,7 @@ class HTTPMessage {
    * Access the path component (fpreq)
    */
   const std::string& getPath() const {
+    ensureURLParsed();
     return request().path_;
   }
 
@@ -235,6 +260,7 @@ class HTTPMessage {
    * Access the query component (fpreq)
    */
   const std::string& getQueryString() const {
+    ensureURLParsed();
     return request().query_;
   }
 
@@ -289,6 +315,24 @@ class HTTPMessage {
   HTTPHeaders& getHeaders() { return headers_; }
   const HTTPHeaders& getHeaders() const { return headers_; }
 
+  /**
+   * Attach a per-request bump allocator; uncommon header names added to this
+   * message's headers from now on are drawn from the arena and reclaimed
+   * wholesale when the arena is released, instead of being individually
+   * heap-allocated.  Must be called before any headers are added (typically
+   * right after construction, before handing the message to a codec).  The
+   * message keeps the arena alive via shared_ptr; transactions that recycle
+   * arenas can clear() them once the message is destroyed.
+   */
+  void setAllocationArena(std::shared_ptr<StringArena> arena) {
+    arena_ = std::move(arena);
+    headers_.setArena(arena_.get());
+  }
+
+  const std::shared_ptr<StringArena>& getAllocationArena() const {
+    return arena_;
+  }
+
   /**
    * Move headers out of current message (returns rvalue ref)
    */
@@ -316,6 +360,31 @@ class HTTPMessage {
     return std::move(trailers_);
   }
 
+  /**
+   * Attach a pass-through metadata header.  Metadata headers ride at the
+   * end of the same header block as the regular headers, but the HTTP/2
+   * and HTTP/3 codecs encode them as never-indexed literals - bypassing
+   * the header indexing strategy and the compression table entirely, and
+   * telling intermediaries to do the same.  Use them for values that
+   * change on every message (trace ids and the like), which would
+   * otherwise churn the dynamic table and hurt compression of everything
+   * else.  Codecs without header compression do not serialize them.
+   */
+  void setMetadataHeader(folly::StringPiece name, const std::string& value) {
+    if (!metadataHeaders_) {
+      metadataHeaders_ = std::make_unique<HTTPHeaders>();
+    }
+    metadataHeaders_->set(name, value);
+  }
+
+  /**
+   * Access the pass-through metadata headers, nullptr when none are set
+   */
+  HTTPHeaders* getMetadataHeaders() { return metadataHeaders_.get(); }
+  const HTTPHeaders* getMetadataHeaders() const {
+    return metadataHeaders_.get();
+  }
+
   /**
    * Decrements Max-Forwards header, when present on OPTIONS or TRACE methods.
    *
@@ -478,8 +547,8 @@ class HTTPMessage {
   /**
    * Get the query parameter with the specified name after percent decoding.
    *
-   * Returns empty string if parameter is missing or folly::uriUnescape
-   * query param
+   * Returns empty string if parameter is missing or contains a malformed
+   * percent escape
    */
   std::string getDecodedQueryParam(const std::string& name) const;
 
@@ -521,9 +590,22 @@ class HTTPMessage {
    * only valid as long as the Cookie Header in HTTPMessage object exists.
    * Applications should make sure they call unparseCookies() when editing
    * the Cookie Header, so that the StringPiece references are cleared.
+   *
+   * The Cookie header is parsed once per message into a flat index
+   * sorted by name; lookups binary-search it, so reading several
+   * cookies off the same request costs one parse total.
    */
   const folly::StringPiece getCookie(const std::string& name) const;
 
+  /**
+   * All cookies on the message as (name, value) pairs sorted by name,
+   * parsing the Cookie header first if needed.  The same lifetime and
+   * unparseCookies() caveats as getCookie() apply to the returned
+   * StringPieces.
+   */
+  const std::vector<std::pair<folly::StringPiece, folly::StringPiece>>&
+  getCookies() const;
+
   /**
    * Print the message out.
    */
@@ -654,6 +736,36 @@ class HTTPMessage {
                            char const* token,
                            bool caseSensitive) const;
 
+  /**
+   * Content-Length parsed as an integer, or none when the header is
+   * absent or malformed.  The value is parsed lazily on the first access
+   * and cached, like the cookie and query parameter caches; callers that
+   * modify the Content-Length header afterwards won't see the new value
+   * through this accessor.
+   */
+  folly::Optional<uint64_t> getContentLength() const;
+
+  /**
+   * Max-Forwards parsed as an integer, with the same lazy caching as
+   * getContentLength().  None when the header is absent or malformed;
+   * negative values are returned as parsed.  processMaxForwards() keeps
+   * the cache in sync when it decrements the header.
+   */
+  folly::Optional<int64_t> getMaxForwards() const;
+
+  /**
+   * Tokens of the Connection header that hot paths test repeatedly.  The
+   * header is scanned once and the result cached as a bitmask, replacing
+   * a checkForHeaderToken() scan per query; as with the other lazy
+   * caches, later changes to the header are not reflected.
+   */
+  enum ConnectionToken : uint8_t {
+    CONN_CLOSE = 1 << 0,
+    CONN_KEEP_ALIVE = 1 << 1,
+    CONN_UPGRADE = 1 << 2,
+  };
+  bool hasConnectionToken(ConnectionToken token) const;
+
   /**
    * Forget about the parsed cookies.
    *
@@ -742,18 +854,106 @@ class HTTPMessage {
     return partiallyReliable_;
   }
 
+  /**
+   * Opt this message into reuse of its encoded header block.  When set,
+   * codecs that support it (HPACK) encode the headers without touching
+   * connection compression state and cache the block here, so sending
+   * the same message again - e.g. retrying a request on a different
+   * upstream session - replays the cached bytes instead of re-encoding.
+   * The trade-off is that the first send forgoes dynamic-table
+   * compression for this message's headers.
+   *
+   * The cache must be invalidated (by setting this again) if the headers
+   * are modified after the first send.
+   */
+  void setHeaderBlockReusable(bool reusable) {
+    headerBlockReusable_ = reusable;
+    reusableHeaderBlock_.reset();
+  }
+
+  bool isHeaderBlockReusable() const {
+    return headerBlockReusable_;
+  }
+
+  const folly::IOBuf* getReusableHeaderBlock() const {
+    return reusableHeaderBlock_.get();
+  }
+
+  const HTTPHeaderSize& getReusableHeaderBlockSize() const {
+    return reusableHeaderBlockSize_;
+  }
+
+  // Invoked by the codec on first encode; const as codecs only see a
+  // const message
+  void cacheReusableHeaderBlock(std::unique_ptr<folly::IOBuf> block,
+                                const HTTPHeaderSize& size) const {
+    reusableHeaderBlock_ = std::move(block);
+    reusableHeaderBlockSize_ = size;
+  }
+
+  /**
+   * Freeze a message into an immutable, reference-counted snapshot for
+   * fan-out: pushing the same resource set to thousands of sessions
+   * encodes from the one shared message instead of copying ~1KB of
+   * headers per pushed stream.  Freezing runs every lazy parse up front
+   * (URL, cookies, query params, the cached header values) and
+   * materializes borrowed header values, since those caches are written
+   * through const accessors on first use - unsafe once the message is
+   * shared across session threads.  The snapshot is marked header-block
+   * reusable, and any block already cached on the source rides along;
+   * codecs never write a cache back into a snapshot (see
+   * HTTP2Codec::generateHeaderImpl, which also re-encodes through the
+   * connection's dynamic table when the same snapshot repeats on one
+   * connection).  Copying a snapshot yields an ordinary mutable message.
+   */
+  static std::shared_ptr<const HTTPMessage> makeImmutableShared(
+      HTTPMessage msg);
+
+  bool isImmutableShared() const {
+    return immutableShared_;
+  }
+
  protected:
   // Message start time, in msec since the epoch.
   TimePoint startTime_;
   int32_t seqNo_;
 
+  // Commit the message direction up front instead of deciding it lazily
+  // on the first typed accessor; used by the typed subclasses below.
+  void initRequest() {
+    request();
+  }
+  void initResponse() {
+    response();
+  }
+
  private:
 
   void parseCookies() const;
 
+  void parseMaxForwards() const;
+
+  uint8_t parseConnectionTokens() const;
+
+  /**
+   * Decompose a lazily-set URL into path and query, once, on first access.
+   */
+  void ensureURLParsed() const {
+    if (!parsedURL_) {
+      parseURL();
+    }
+  }
+  void parseURL() const;
+
   void parseQueryParams() const;
   void unparseQueryParams();
 
+  /**
+   * Force all lazily-built caches so a frozen message never writes
+   * through its mutable members again; see makeImmutableShared().
+   */
+  void prepareForSharing();
+
   bool doHeaderTokenCheck(const HTTPHeaders& headers_,
                           const HTTPHeaderCode headerCode,
                           char const* token,
@@ -774,8 +974,10 @@ class HTTPMessage {
     mutable std::string clientIP_;
     mutable std::string clientPort_;
     mutable boost::variant<boost::blank, std::string, HTTPMethod> method_;
-    std::string path_;
-    std::string query_;
+    // path_/query_ are mutable so a lazily-set URL (setURLLazy) can be
+    // decomposed on first access from const accessors
+    mutable std::string path_;
+    mutable std::string query_;
     std::string url_;
 
     uint16_t pushStatus_;
@@ -797,13 +999,19 @@ class HTTPMessage {
 
   mutable boost::variant<boost::blank, Request, Response> fields_;
 
+  // The accessors use the pointer form of boost::get, which returns
+  // nullptr on a type mismatch instead of throwing; the direction is
+  // already pinned by the checks above, so every access site sheds the
+  // boost::bad_get throw path that the reference form drags in.
   Request& request() {
     DCHECK(fields_.which() == 0 || fields_.which() == 1) << fields_.which();
     if (fields_.which() == 0) {
       fields_ = Request();
     }
 
-    return boost::get<Request>(fields_);
+    auto req = boost::get<Request>(&fields_);
+    DCHECK(req);
+    return *req;
   }
 
   const Request& request() const {
@@ -812,7 +1020,9 @@ class HTTPMessage {
       fields_ = Request();
     }
 
-    return boost::get<const Request>(fields_);
+    auto req = boost::get<const Request>(&fields_);
+    DCHECK(req);
+    return *req;
   }
 
   Response& response() {
@@ -821,7 +1031,9 @@ class HTTPMessage {
       fields_ = Response();
     }
 
-    return boost::get<Response>(fields_);
+    auto resp = boost::get<Response>(&fields_);
+    DCHECK(resp);
+    return *resp;
   }
 
   const Response& response() const {
@@ -830,7 +1042,9 @@ class HTTPMessage {
       fields_ = Response();
     }
 
-    return boost::get<const Response>(fields_);
+    auto resp = boost::get<const Response>(&fields_);
+    DCHECK(resp);
+    return *resp;
   }
 
   /*
@@ -838,15 +1052,21 @@ class HTTPMessage {
    * These are mutable since we parse them lazily in getCookie() and
    * getQueryParam()
    */
-  mutable std::map<folly::StringPiece, folly::StringPiece> cookies_;
+  // Flat cookie index sorted by name; built once per message and
+  // binary-searched by getCookie()
+  mutable std::vector<std::pair<folly::StringPiece, folly::StringPiece>>
+      cookies_;
   // TODO: use StringPiece for queryParams_ and delete splitNameValue()
   mutable std::map<std::string, std::string> queryParams_;
 
   std::pair<uint8_t, uint8_t> version_;
+  // Optional per-request allocator backing uncommon header names
+  std::shared_ptr<StringArena> arena_;
   HTTPHeaders headers_;
   HTTPHeaders strippedPerHopHeaders_;
   HTTPHeaderSize size_;
   std::unique_ptr<HTTPHeaders> trailers_;
+  std::unique_ptr<HTTPHeaders> metadataHeaders_;
 
   int sslVersion_;
   const char* sslCipher_;
@@ -855,6 +1075,7 @@ class HTTPMessage {
   folly::Optional<HTTPPriority> h2Pri_;
 
   mutable bool parsedCookies_:1;
+  mutable bool parsedURL_:1;
   mutable bool parsedQueryParams_:1;
   bool chunked_:1;
   bool upgraded_:1;
@@ -869,6 +1090,31 @@ class HTTPMessage {
   // transaction.
   bool partiallyReliable_ : 1;
 
+  // Lazily parsed header value caches; see getContentLength()
+  enum class MaxForwardsState : uint8_t {
+    NOT_PARSED,
+    ABSENT,
+    MALFORMED,
+    VALID,
+  };
+  mutable uint64_t contentLength_{0};
+  mutable int64_t maxForwards_{0};
+  mutable MaxForwardsState maxForwardsState_{MaxForwardsState::NOT_PARSED};
+  mutable uint8_t connectionTokens_{0};
+  mutable bool parsedContentLength_{false};
+  mutable bool hasContentLength_{false};
+  mutable bool parsedConnectionTokens_{false};
+
+  // Whether codecs may cache this message's encoded header block for
+  // reuse across sessions; see setHeaderBlockReusable()
+  bool headerBlockReusable_{false};
+  mutable std::unique_ptr<folly::IOBuf> reusableHeaderBlock_;
+  mutable HTTPHeaderSize reusableHeaderBlockSize_;
+
+  // Set by makeImmutableShared(); deliberately not propagated by the
+  // copy/move constructors so a copy of a snapshot is mutable again
+  bool immutableShared_{false};
+
   // used by atomicDumpMessage
   static std::mutex mutexDump_;
 
@@ -878,6 +1124,33 @@ class HTTPMessage {
 
 std::ostream& operator<<(std::ostream& os, const HTTPMessage& msg);
 
+/**
+ * Typed HTTPMessage variants that fix the direction at construction.
+ *
+ * HTTPMessage decides whether it is a request or a response lazily, on
+ * the first typed accessor, so construction sites that already know the
+ * direction - codecs do, it follows from the transport direction -
+ * otherwise defer that decision into the parsing hot path.  Constructing
+ * the matching subclass commits the direction once; the DCHECKs in the
+ * accessors then catch any access against the grain as usual.
+ *
+ * HTTPMessage remains the interchange type everywhere.  The subclasses
+ * add no members, so slicing them back down is harmless.
+ */
+class HTTPRequestMessage : public HTTPMessage {
+ public:
+  HTTPRequestMessage() {
+    initRequest();
+  }
+};
+
+class HTTPResponseMessage : public HTTPMessage {
+ public:
+  HTTPResponseMessage() {
+    initResponse();
+  }
+};
+
 /**
  * Returns a std::string that has the control characters removed from the
  * input string.
@@ -0,0 +1,113 @@
+/*
+ *  Copyright (c) 2015-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include <proxygen/lib/http/QueryParamIndex.h>
+
+#include <glog/logging.h>
+#include <proxygen/lib/utils/URLScan.h>
+
+namespace proxygen {
+
+QueryParamIndex::QueryParamIndex(std::vector<std::string> paramNames)
+    : names_(std::move(paramNames)) {
+  buildTable();
+}
+
+uint32_t QueryParamIndex::hash(folly::StringPiece name) const {
+  uint32_t h = seed_;
+  for (char c : name) {
+    h = h * 31 + static_cast<uint8_t>(c);
+  }
+  return h;
+}
+
+void QueryParamIndex::buildTable() {
+  // Size the table at least 2x the key count so most seeds work on the
+  // first few tries; double it if a collision-free seed is elusive.
+  size_t tableSize = 4;
+  while (tableSize < 2 * names_.size()) {
+    tableSize *= 2;
+  }
+  for (;; tableSize *= 2) {
+    tableMask_ = tableSize - 1;
+    for (seed_ = 1; seed_ <= 64; ++seed_) {
+      table_.assign(tableSize, 0);
+      bool collided = false;
+      for (size_t slot = 0; slot < names_.size() && !collided; ++slot) {
+        uint32_t& bucket = table_[hash(names_[slot]) & tableMask_];
+        if (bucket != 0) {
+          CHECK_NE(names_[bucket - 1], names_[slot])
+              << "duplicate query param in schema";
+          collided = true;
+        } else {
+          bucket = slot + 1;
+        }
+      }
+      if (!collided) {
+        return;
+      }
+    }
+  }
+}
+
+folly::Optional<size_t> QueryParamIndex::slotOf(folly::StringPiece name) const {
+  uint32_t bucket = table_[hash(name) & tableMask_];
+  if (bucket != 0 && names_[bucket - 1] == name) {
+    return bucket - 1;
+  }
+  return folly::none;
+}
+
+QueryParamIndex::ParsedQuery QueryParamIndex::parse(
+    folly::StringPiece query) const {
+  ParsedQuery result(names_.size());
+  while (!query.empty()) {
+    auto pairEnd = query.find('&');
+    auto pair = query.subpiece(0, pairEnd);
+    query.advance(pairEnd == folly::StringPiece::npos ? query.size()
+                                                      : pairEnd + 1);
+    if (pair.empty()) {
+      continue;
+    }
+    auto valueStart = pair.find('=');
+    folly::StringPiece name = pair.subpiece(0, valueStart);
+    folly::StringPiece value = (valueStart == folly::StringPiece::npos)
+                                   ? folly::StringPiece()
+                                   : pair.subpiece(valueStart + 1);
+    auto slot = slotOf(name);
+    if (slot) {
+      // last duplicate wins, matching HTTPMessage::parseQueryParams
+      result.present_[*slot] = true;
+      result.raw_[*slot] = value;
+      result.decoded_[*slot] = nullptr;
+    }
+  }
+  return result;
+}
+
+folly::Optional<folly::StringPiece> QueryParamIndex::ParsedQuery::decodedValue(
+    size_t slot) const {
+  if (!present_[slot]) {
+    return folly::none;
+  }
+  if (!decoded_[slot]) {
+    std::string out;
+    if (!urlUnescapeQuery(out, raw_[slot])) {
+      VLOG(4) << "Invalid escaped query param value";
+      return folly::none;
+    }
+    if (!arena_) {
+      arena_ = std::make_unique<StringArena>(256);
+    }
+    decoded_[slot] = arena_->newString(out);
+  }
+  return folly::StringPiece(*decoded_[slot]);
+}
+
+} // namespace proxygen
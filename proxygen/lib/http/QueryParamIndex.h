@@ -0,0 +1,131 @@
+/*
+ *  Copyright (c) 2015-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <folly/Optional.h>
+#include <folly/Range.h>
+#include <folly/small_vector.h>
+#include <proxygen/lib/utils/StringArena.h>
+
+namespace proxygen {
+
+/**
+ * A fixed query-parameter schema with collision-free name lookup.
+ *
+ * HTTPMessage::getQueryParam parses the query string on demand into a
+ * std::map per message, which is wasted work on API routes whose
+ * parameter sets are fixed and known.  The intended flow mirrors
+ * RouteProfileStore: the application's RequestRouter (see
+ * HTTPSessionBase::setRequestRouter) builds one QueryParamIndex per
+ * route at registration time, and on match calls parse() once with
+ * msg.getQueryString(), handing the ParsedQuery to the route's handler.
+ * Handlers then address parameters by slot — the position of the name
+ * in the registered schema — instead of by string key.
+ *
+ * Lookup uses the same shape as the generated perfect-hash tables (see
+ * gen_perfect_hash_table.sh): one hash, one probe, one comparison.
+ * gperf runs at build time over static key sets, so for runtime schemas
+ * the constructor searches multiplier seeds until the registered names
+ * hash collision-free into a power-of-two table; parameter sets are
+ * small, so this converges in a handful of attempts.
+ *
+ * Unknown names in the query string are skipped during parse; handlers
+ * that need open-ended parameters should fall back to
+ * HTTPMessage::getQueryParams.
+ */
+class QueryParamIndex {
+ public:
+  /**
+   * Values parsed from one query string.  Raw slots are views into the
+   * query string passed to parse(), which must outlive this object (for
+   * the usual flow, HTTPMessage owns it for the transaction lifetime).
+   * Percent-decoded values are materialized lazily into a per-parse
+   * arena, so repeated decodedValue() calls do not reallocate.
+   */
+  class ParsedQuery {
+   public:
+    bool hasParam(size_t slot) const {
+      return present_[slot];
+    }
+
+    /**
+     * The value exactly as it appeared on the wire, or empty if the
+     * parameter was absent or had no value.
+     */
+    folly::StringPiece rawValue(size_t slot) const {
+      return raw_[slot];
+    }
+
+    /**
+     * The percent-decoded value.  Returns none if the parameter was
+     * absent or its escaping is invalid.
+     */
+    folly::Optional<folly::StringPiece> decodedValue(size_t slot) const;
+
+   private:
+    friend class QueryParamIndex;
+    explicit ParsedQuery(size_t numSlots)
+        : present_(numSlots, false),
+          raw_(numSlots),
+          decoded_(numSlots, nullptr) {
+    }
+
+    folly::small_vector<bool, 8> present_;
+    folly::small_vector<folly::StringPiece, 8> raw_;
+    // cache of arena-backed decoded values, filled on first access; the
+    // arena itself is created lazily so raw-only consumers pay nothing
+    mutable folly::small_vector<const std::string*, 8> decoded_;
+    mutable std::unique_ptr<StringArena> arena_;
+  };
+
+  /**
+   * Builds the index over the given names.  Slot i corresponds to
+   * paramNames[i].  Duplicate names are not allowed.
+   */
+  explicit QueryParamIndex(std::vector<std::string> paramNames);
+
+  size_t numParams() const {
+    return names_.size();
+  }
+
+  const std::string& nameOf(size_t slot) const {
+    return names_[slot];
+  }
+
+  /**
+   * Slot of the given name, or none if it is not in the schema.
+   */
+  folly::Optional<size_t> slotOf(folly::StringPiece name) const;
+
+  /**
+   * Parses the query string (the part after '?', as returned by
+   * HTTPMessage::getQueryString) in one pass.  Matches
+   * HTTPMessage::parseQueryParams semantics: pairs split on '&' and
+   * '=', and the last occurrence of a duplicated parameter wins.
+   */
+  ParsedQuery parse(folly::StringPiece query) const;
+
+ private:
+  uint32_t hash(folly::StringPiece name) const;
+  void buildTable();
+
+  std::vector<std::string> names_;
+  // slot + 1 per bucket; 0 means empty.  Sized so the registered names
+  // hash collision-free with the chosen seed.
+  std::vector<uint32_t> table_;
+  uint32_t tableMask_{0};
+  uint32_t seed_{0};
+};
+
+} // namespace proxygen
@@ -0,0 +1,126 @@
+/*
+ *  Copyright (c) 2015-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include <proxygen/lib/http/RacingHTTPConnector.h>
+
+#include <proxygen/lib/http/connpool/SessionPool.h>
+#include <proxygen/lib/http/session/HTTPUpstreamSession.h>
+
+using folly::AsyncSocketException;
+
+namespace proxygen {
+
+RacingHTTPConnector::RacingHTTPConnector(Callback* callback,
+                                         folly::EventBase* eventBase,
+                                         const WheelTimerInstance& timeout)
+    : cb_(CHECK_NOTNULL(callback)),
+      eventBase_(CHECK_NOTNULL(eventBase)),
+      timeout_(timeout) {
+  staggerTimeout_ = folly::AsyncTimeout::make(
+      *eventBase_, [this]() noexcept { launchNextAttempt(); });
+}
+
+RacingHTTPConnector::~RacingHTTPConnector() {
+  reset();
+}
+
+void RacingHTTPConnector::connect(
+    const std::vector<folly::SocketAddress>& addrs,
+    std::chrono::milliseconds timeoutMs,
+    const folly::AsyncSocket::OptionMap& socketOptions) {
+  DCHECK(!busy_);
+  CHECK(!addrs.empty());
+  addrs_ = addrs;
+  connectTimeout_ = timeoutMs;
+  socketOptions_ = socketOptions;
+  errorCount_ = 0;
+  lastError_ = folly::none;
+  winnerDelivered_ = false;
+  busy_ = true;
+  launchNextAttempt();
+}
+
+void RacingHTTPConnector::reset() {
+  staggerTimeout_->cancelTimeout();
+  busy_ = false;
+  cancelStragglers();
+  attempts_.clear();
+  addrs_.clear();
+}
+
+void RacingHTTPConnector::launchNextAttempt() {
+  const size_t index = attempts_.size();
+  if (index >= addrs_.size() || winnerDelivered_) {
+    return;
+  }
+  auto attempt = std::make_unique<Attempt>(this, index);
+  attempt->connector =
+      std::make_unique<HTTPConnector>(attempt.get(), timeout_);
+  if (!plaintextProtocol_.empty()) {
+    attempt->connector->setPlaintextProtocol(plaintextProtocol_);
+  }
+  attempts_.push_back(std::move(attempt));
+  if (attempts_.size() < addrs_.size()) {
+    staggerTimeout_->scheduleTimeout(staggerDelay_);
+  }
+  // May invoke onAttemptError inline, so launch after the bookkeeping
+  attempts_[index]->connector->connect(
+      eventBase_, addrs_[index], connectTimeout_, socketOptions_);
+}
+
+void RacingHTTPConnector::onAttemptSuccess(size_t index,
+                                           HTTPUpstreamSession* session) {
+  if (!winnerDelivered_) {
+    VLOG(4) << "racing connect won by rank=" << index << " addr="
+            << addrs_[index].describe();
+    winnerDelivered_ = true;
+    busy_ = false;
+    staggerTimeout_->cancelTimeout();
+    if (!stragglerPool_) {
+      cancelStragglers();
+    }
+    cb_->connectSuccess(session);
+    return;
+  }
+  // A straggler landed after the winner; the pool keeps the warm socket
+  DCHECK(stragglerPool_);
+  VLOG(4) << "pooling straggler session addr=" << addrs_[index].describe();
+  stragglerPool_->putSession(session);
+}
+
+void RacingHTTPConnector::onAttemptError(size_t index,
+                                         const AsyncSocketException& ex) {
+  if (winnerDelivered_) {
+    return;
+  }
+  errorCount_++;
+  lastError_ = ex;
+  VLOG(4) << "racing connect attempt rank=" << index
+          << " failed: " << ex.what();
+  if (errorCount_ == addrs_.size()) {
+    busy_ = false;
+    cb_->connectError(*lastError_);
+    return;
+  }
+  if (errorCount_ == attempts_.size() && attempts_.size() < addrs_.size()) {
+    // Everything in flight has failed; no point waiting out the stagger
+    staggerTimeout_->cancelTimeout();
+    launchNextAttempt();
+  }
+}
+
+void RacingHTTPConnector::cancelStragglers() {
+  for (auto& attempt : attempts_) {
+    if (attempt->connector) {
+      attempt->connector->reset();
+    }
+  }
+}
+
+} // namespace proxygen
@@ -0,0 +1,139 @@
+/*
+ *  Copyright (c) 2015-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#pragma once
+
+#include <folly/io/async/AsyncTimeout.h>
+#include <proxygen/lib/http/HTTPConnector.h>
+#include <vector>
+
+namespace proxygen {
+
+class SessionPool;
+
+/**
+ * Races staggered connection attempts against a ranked list of hosts -
+ * typically the top ranks of the rendezvous ordering - and delivers the
+ * first session that comes up, so one slow host during a partial
+ * failure no longer holds the connect p99 hostage.
+ *
+ * Attempt 0 starts immediately; each later attempt starts after the
+ * stagger delay, or right away when every attempt in flight has already
+ * failed.  Once a winner is delivered, in-flight stragglers are either
+ * left to finish and handed to an optional SessionPool when they land
+ * (the connection work is already paid for, so keep the warm socket) or
+ * cancelled immediately if no pool is set.  If every attempt fails, the
+ * callback gets connectError with the last error seen.
+ *
+ * Like HTTPConnector, one object services one race at a time and
+ * deleting it cancels everything without further callbacks.
+ */
+class RacingHTTPConnector {
+ public:
+  using Callback = HTTPConnector::Callback;
+
+  /**
+   * @param callback Receives the winning session or the final error.
+   *                 MUST outlive this connector and MUST NOT be null.
+   * @param eventBase The event base the race runs on.
+   * @param timeout The timeout set for transactions on created sessions.
+   */
+  RacingHTTPConnector(Callback* callback,
+                      folly::EventBase* eventBase,
+                      const WheelTimerInstance& timeout);
+
+  ~RacingHTTPConnector();
+
+  /**
+   * Delay between launching consecutive attempts.  Defaults to 50ms -
+   * long enough that a healthy first-ranked host usually wins alone,
+   * short enough to cap the penalty when it is sick.
+   */
+  void setStaggerDelay(std::chrono::milliseconds delay) {
+    staggerDelay_ = delay;
+  }
+
+  void setPlaintextProtocol(const std::string& plaintextProto) {
+    plaintextProtocol_ = plaintextProto;
+  }
+
+  /**
+   * Pool to absorb straggler sessions that finish connecting after the
+   * winner.  Without a pool, stragglers are cancelled as soon as the
+   * winner is declared.  The pool must outlive this connector.
+   */
+  void setStragglerPool(SessionPool* pool) {
+    stragglerPool_ = pool;
+  }
+
+  /**
+   * Start a plaintext race to the given addresses, best-ranked first.
+   * May invoke the callback inline.  The per-attempt connect timeout
+   * and socket options apply to every attempt.
+   */
+  void connect(const std::vector<folly::SocketAddress>& addrs,
+               std::chrono::milliseconds timeoutMs =
+                   std::chrono::milliseconds(0),
+               const folly::AsyncSocket::OptionMap& socketOptions =
+                   folly::AsyncSocket::emptyOptionMap);
+
+  /**
+   * Cancel the race and all in-flight attempts.  No callbacks result.
+   */
+  void reset();
+
+  /**
+   * @returns true while a race is in progress and undecided.
+   */
+  bool isBusy() const {
+    return busy_;
+  }
+
+ private:
+  // Per-attempt shim routing HTTPConnector results back with an index
+  struct Attempt : public HTTPConnector::Callback {
+    Attempt(RacingHTTPConnector* parentIn, size_t indexIn)
+        : parent(parentIn), index(indexIn) {
+    }
+    void connectSuccess(HTTPUpstreamSession* session) override {
+      parent->onAttemptSuccess(index, session);
+    }
+    void connectError(const folly::AsyncSocketException& ex) override {
+      parent->onAttemptError(index, ex);
+    }
+
+    RacingHTTPConnector* parent;
+    size_t index;
+    std::unique_ptr<HTTPConnector> connector;
+  };
+
+  void launchNextAttempt();
+  void onAttemptSuccess(size_t index, HTTPUpstreamSession* session);
+  void onAttemptError(size_t index, const folly::AsyncSocketException& ex);
+  void cancelStragglers();
+
+  Callback* cb_;
+  folly::EventBase* eventBase_;
+  WheelTimerInstance timeout_;
+  std::chrono::milliseconds staggerDelay_{50};
+  std::string plaintextProtocol_;
+  SessionPool* stragglerPool_{nullptr};
+
+  std::vector<folly::SocketAddress> addrs_;
+  std::chrono::milliseconds connectTimeout_{0};
+  folly::AsyncSocket::OptionMap socketOptions_;
+  std::vector<std::unique_ptr<Attempt>> attempts_;
+  std::unique_ptr<folly::AsyncTimeout> staggerTimeout_;
+  size_t errorCount_{0};
+  folly::Optional<folly::AsyncSocketException> lastError_;
+  bool busy_{false};
+  bool winnerDelivered_{false};
+};
+
+} // namespace proxygen
@@ -0,0 +1,73 @@
+/*
+ *  Copyright (c) 2015-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include <proxygen/lib/http/ResolvingHTTPConnector.h>
+
+namespace proxygen {
+
+ResolvingHTTPConnector::ResolvingHTTPConnector(Callback* callback,
+                                               folly::EventBase* eventBase,
+                                               const WheelTimerInstance& timeout,
+                                               DnsCache* dnsCache)
+    : cb_(CHECK_NOTNULL(callback)),
+      dnsCache_(CHECK_NOTNULL(dnsCache)),
+      racer_(callback, eventBase, timeout) {
+}
+
+ResolvingHTTPConnector::~ResolvingHTTPConnector() {
+  reset();
+}
+
+void ResolvingHTTPConnector::connect(
+    const std::string& hostname,
+    uint16_t port,
+    std::chrono::milliseconds timeoutMs,
+    const folly::AsyncSocket::OptionMap& socketOptions) {
+  CHECK(!isBusy()) << "Call connect() only when not busy";
+  port_ = port;
+  connectTimeout_ = timeoutMs;
+  socketOptions_ = socketOptions;
+  // On a warm cache this completes inline and the race starts before
+  // getAddresses returns
+  resolving_ = true;
+  dnsCache_->getAddresses(hostname, this);
+}
+
+void ResolvingHTTPConnector::reset() {
+  if (resolving_) {
+    dnsCache_->cancelLookup(this);
+    resolving_ = false;
+  }
+  racer_.reset();
+}
+
+void ResolvingHTTPConnector::resolveSuccess(
+    DnsResolver::Answer answer) noexcept {
+  resolving_ = false;
+  std::vector<folly::SocketAddress> addrs;
+  addrs.reserve(answer.addrs.size());
+  for (const auto& ip : answer.addrs) {
+    addrs.emplace_back(ip, port_);
+  }
+  if (addrs.empty()) {
+    cb_->connectError(folly::AsyncSocketException(
+        folly::AsyncSocketException::NOT_OPEN,
+        "resolution returned no addresses"));
+    return;
+  }
+  racer_.connect(addrs, connectTimeout_, socketOptions_);
+}
+
+void ResolvingHTTPConnector::resolveError(const std::string& msg) noexcept {
+  resolving_ = false;
+  cb_->connectError(folly::AsyncSocketException(
+      folly::AsyncSocketException::NOT_OPEN, "resolution failed: " + msg));
+}
+
+} // namespace proxygen
@@ -0,0 +1,93 @@
+/*
+ *  Copyright (c) 2015-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#pragma once
+
+#include <proxygen/lib/http/DnsCache.h>
+#include <proxygen/lib/http/RacingHTTPConnector.h>
+
+namespace proxygen {
+
+/**
+ * Resolve-and-connect front end: takes a hostname instead of a
+ * pre-resolved SocketAddress, answers resolution from the worker's
+ * DnsCache, and feeds every address of the answer to a
+ * RacingHTTPConnector, best address first.  With a warm cache the race
+ * starts inline from connect(); only the first connect to a hostname
+ * (or one past its negative TTL) waits on the resolver, and the cache's
+ * background refresh keeps steadily used hostnames warm thereafter.
+ *
+ * Like the underlying connectors, one object services one connect at a
+ * time and deleting it cancels everything without further callbacks.
+ */
+class ResolvingHTTPConnector : private DnsResolver::Callback {
+ public:
+  using Callback = HTTPConnector::Callback;
+
+  /**
+   * @param callback Receives the winning session or the final error.
+   *                 MUST outlive this connector and MUST NOT be null.
+   * @param eventBase The event base the resolution and race run on.
+   * @param timeout The timeout set for transactions on created sessions.
+   * @param dnsCache The worker's cache; must outlive this connector.
+   */
+  ResolvingHTTPConnector(Callback* callback,
+                         folly::EventBase* eventBase,
+                         const WheelTimerInstance& timeout,
+                         DnsCache* dnsCache);
+
+  ~ResolvingHTTPConnector() override;
+
+  void setStaggerDelay(std::chrono::milliseconds delay) {
+    racer_.setStaggerDelay(delay);
+  }
+
+  void setPlaintextProtocol(const std::string& plaintextProto) {
+    racer_.setPlaintextProtocol(plaintextProto);
+  }
+
+  void setStragglerPool(SessionPool* pool) {
+    racer_.setStragglerPool(pool);
+  }
+
+  /**
+   * Resolve the hostname and start a plaintext race to its addresses.
+   * May invoke the callback inline.  The connect timeout and socket
+   * options apply per attempt, as in RacingHTTPConnector::connect.
+   */
+  void connect(const std::string& hostname,
+               uint16_t port,
+               std::chrono::milliseconds timeoutMs =
+                   std::chrono::milliseconds(0),
+               const folly::AsyncSocket::OptionMap& socketOptions =
+                   folly::AsyncSocket::emptyOptionMap);
+
+  /**
+   * Cancel resolution and any in-flight race.  No callbacks result.
+   */
+  void reset();
+
+  bool isBusy() const {
+    return resolving_ || racer_.isBusy();
+  }
+
+ private:
+  void resolveSuccess(DnsResolver::Answer answer) noexcept override;
+  void resolveError(const std::string& msg) noexcept override;
+
+  Callback* cb_;
+  DnsCache* dnsCache_;
+  RacingHTTPConnector racer_;
+  uint16_t port_{0};
+  std::chrono::milliseconds connectTimeout_{0};
+  folly::AsyncSocket::OptionMap socketOptions_;
+  bool resolving_{false};
+};
+
+} // namespace proxygen
@@ -0,0 +1,200 @@
+/*
+ *  Copyright (c) 2015-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include <proxygen/lib/http/RouteProfileStore.h>
+
+#include <algorithm>
+
+#include <folly/FileUtil.h>
+#include <folly/io/Cursor.h>
+#include <folly/io/IOBuf.h>
+
+namespace {
+
+const uint32_t kFileMagic = 0x52504631; // "RPF1"
+
+size_t roundUpPow2(size_t v) {
+  size_t p = 1;
+  while (p < v) {
+    p <<= 1;
+  }
+  return p;
+}
+
+size_t clampPow2(size_t v, size_t lo, size_t hi) {
+  return std::min(std::max(roundUpPow2(v), lo), hi);
+}
+
+} // namespace
+
+namespace proxygen {
+
+constexpr size_t RouteProfileStore::kMaxRoutes;
+constexpr size_t RouteProfileStore::kNumBuckets;
+
+size_t RouteProfileStore::bucketOf(size_t bytes) {
+  size_t bucket = 0;
+  while (bytes > 1 && bucket < kNumBuckets - 1) {
+    bytes >>= 1;
+    bucket++;
+  }
+  return bucket;
+}
+
+size_t RouteProfileStore::p99UpperBound(
+    const std::array<uint64_t, kNumBuckets>& buckets, uint64_t count) {
+  if (count == 0) {
+    return 0;
+  }
+  // smallest bucket upper bound covering 99% of the samples
+  uint64_t threshold = count - count / 100;
+  uint64_t seen = 0;
+  for (size_t i = 0; i < kNumBuckets; i++) {
+    seen += buckets[i];
+    if (seen >= threshold) {
+      return size_t(1) << (i + 1);
+    }
+  }
+  return size_t(1) << kNumBuckets;
+}
+
+RouteProfileStore::Profile RouteProfileStore::makeProfile(const Entry& entry) {
+  Profile profile;
+  profile.txnCount = entry.txnCount;
+  profile.arenaBytesP99 = p99UpperBound(entry.arenaBuckets, entry.txnCount);
+  profile.bodyBytesP99 = p99UpperBound(entry.bodyBuckets, entry.txnCount);
+  return profile;
+}
+
+size_t RouteProfileStore::Profile::suggestedArenaBlockSize() const {
+  return clampPow2(arenaBytesP99, 1024, 64 * 1024);
+}
+
+size_t RouteProfileStore::Profile::suggestedEgressReservation() const {
+  return clampPow2(bodyBytesP99, 4 * 1024, 256 * 1024);
+}
+
+size_t RouteProfileStore::Profile::suggestedCoalescingWindow() const {
+  return clampPow2(bodyBytesP99, 4 * 1024, 64 * 1024);
+}
+
+void RouteProfileStore::recordTransaction(folly::StringPiece route,
+                                          size_t arenaBytes,
+                                          size_t bodyBytes) {
+  std::lock_guard<std::mutex> g(mutex_);
+  auto it = entries_.find(route.str());
+  if (it == entries_.end()) {
+    if (entries_.size() >= kMaxRoutes) {
+      return;
+    }
+    it = entries_.emplace(route.str(), Entry()).first;
+  }
+  auto& entry = it->second;
+  entry.txnCount++;
+  entry.arenaBuckets[bucketOf(arenaBytes)]++;
+  entry.bodyBuckets[bucketOf(bodyBytes)]++;
+}
+
+folly::Optional<RouteProfileStore::Profile> RouteProfileStore::getProfile(
+    folly::StringPiece route) const {
+  std::lock_guard<std::mutex> g(mutex_);
+  auto it = entries_.find(route.str());
+  if (it == entries_.end()) {
+    return folly::none;
+  }
+  return makeProfile(it->second);
+}
+
+size_t RouteProfileStore::getNumRoutes() const {
+  std::lock_guard<std::mutex> g(mutex_);
+  return entries_.size();
+}
+
+bool RouteProfileStore::saveToFile(const std::string& path) const {
+  folly::IOBufQueue queue(folly::IOBufQueue::cacheChainLength());
+  folly::io::QueueAppender appender(&queue, 4096);
+  {
+    std::lock_guard<std::mutex> g(mutex_);
+    appender.writeLE<uint32_t>(kFileMagic);
+    appender.writeLE<uint32_t>(kNumBuckets);
+    appender.writeLE<uint32_t>(uint32_t(entries_.size()));
+    for (const auto& kv : entries_) {
+      appender.writeLE<uint32_t>(uint32_t(kv.first.size()));
+      appender.push(folly::StringPiece(kv.first));
+      appender.writeLE<uint64_t>(kv.second.txnCount);
+      for (auto count : kv.second.arenaBuckets) {
+        appender.writeLE<uint64_t>(count);
+      }
+      for (auto count : kv.second.bodyBuckets) {
+        appender.writeLE<uint64_t>(count);
+      }
+    }
+  }
+  auto buf = queue.move();
+  buf->coalesce();
+  return folly::writeFile(
+      folly::ByteRange(buf->data(), buf->length()), path.c_str());
+}
+
+bool RouteProfileStore::loadFromFile(const std::string& path) {
+  std::string content;
+  if (!folly::readFile(path.c_str(), content)) {
+    return false;
+  }
+  auto buf = folly::IOBuf::wrapBuffer(content.data(), content.size());
+  folly::io::Cursor cursor(buf.get());
+  // Parse into a scratch map first so a truncated or incompatible file
+  // leaves the store untouched
+  std::unordered_map<std::string, Entry> loaded;
+  try {
+    if (cursor.readLE<uint32_t>() != kFileMagic ||
+        cursor.readLE<uint32_t>() != kNumBuckets) {
+      return false;
+    }
+    uint32_t numRoutes = cursor.readLE<uint32_t>();
+    if (numRoutes > kMaxRoutes) {
+      return false;
+    }
+    for (uint32_t i = 0; i < numRoutes; i++) {
+      uint32_t len = cursor.readLE<uint32_t>();
+      auto route = cursor.readFixedString(len);
+      Entry entry;
+      entry.txnCount = cursor.readLE<uint64_t>();
+      for (auto& count : entry.arenaBuckets) {
+        count = cursor.readLE<uint64_t>();
+      }
+      for (auto& count : entry.bodyBuckets) {
+        count = cursor.readLE<uint64_t>();
+      }
+      loaded.emplace(std::move(route), entry);
+    }
+  } catch (const std::out_of_range&) {
+    return false;
+  }
+
+  std::lock_guard<std::mutex> g(mutex_);
+  for (auto& kv : loaded) {
+    auto it = entries_.find(kv.first);
+    if (it == entries_.end()) {
+      if (entries_.size() < kMaxRoutes) {
+        entries_.emplace(kv.first, kv.second);
+      }
+      continue;
+    }
+    // histograms merge by addition
+    it->second.txnCount += kv.second.txnCount;
+    for (size_t i = 0; i < kNumBuckets; i++) {
+      it->second.arenaBuckets[i] += kv.second.arenaBuckets[i];
+      it->second.bodyBuckets[i] += kv.second.bodyBuckets[i];
+    }
+  }
+  return true;
+}
+
+} // namespace proxygen
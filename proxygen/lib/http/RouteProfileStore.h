@@ -0,0 +1,129 @@
+/*
+ *  Copyright (c) 2015-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#pragma once
+
+#include <array>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include <folly/Optional.h>
+#include <folly/Range.h>
+
+namespace proxygen {
+
+/**
+ * Learns per-route sizing profiles from observed traffic.  Different
+ * routes have wildly different header and body shapes, so a single
+ * global arena block size or coalescing window over-allocates for some
+ * routes and reallocates for others.
+ *
+ * The intended flow: the application's RequestRouter (see
+ * HTTPSessionBase::setRequestRouter) knows which route a request
+ * matched; when the transaction finishes it calls recordTransaction()
+ * with the arena bytes the request consumed (StringArena::
+ * bytesAllocated) and the body size.  For subsequent requests on the
+ * same route, getProfile() yields suggested sizes for the request
+ * arena block, the egress buffer reservation, and the ingress body
+ * coalescing window (HTTPTransaction::setIngressBodyCoalescing), all
+ * derived from the route's p99.
+ *
+ * Per-route usage is kept as compact exponential histograms (one
+ * bucket per power of two), so recording is a couple of increments and
+ * a p99 read is one scan; histograms also merge trivially, which is
+ * what makes the on-disk format a plain dump.  saveToFile() /
+ * loadFromFile() persist the learned profiles across restarts in a
+ * compact binary file, so a freshly started process sizes correctly
+ * from the first request.
+ *
+ * All methods are thread-safe; the store is typically shared by all
+ * worker threads.
+ */
+class RouteProfileStore {
+ public:
+  struct Profile {
+    uint64_t txnCount{0};
+    // Upper bounds on the route's p99 arena usage and body size
+    size_t arenaBytesP99{0};
+    size_t bodyBytesP99{0};
+
+    /**
+     * Arena block size covering p99 of the route's requests in one
+     * block, clamped to [1KB, 64KB].
+     */
+    size_t suggestedArenaBlockSize() const;
+
+    /**
+     * Egress buffer reservation covering p99 of response bodies,
+     * clamped to [4KB, 256KB].
+     */
+    size_t suggestedEgressReservation() const;
+
+    /**
+     * Ingress body coalescing window: large enough to deliver a p99
+     * body in one callback, clamped to [4KB, 64KB].
+     */
+    size_t suggestedCoalescingWindow() const;
+  };
+
+  /**
+   * Record one finished transaction for the route.  New routes beyond
+   * kMaxRoutes are dropped so pathological route cardinality cannot
+   * grow the store without bound.
+   */
+  void recordTransaction(folly::StringPiece route,
+                         size_t arenaBytes,
+                         size_t bodyBytes);
+
+  /**
+   * Returns the route's profile, or none if the route has not been
+   * seen (or was dropped by the cardinality cap).
+   */
+  folly::Optional<Profile> getProfile(folly::StringPiece route) const;
+
+  size_t getNumRoutes() const;
+
+  /**
+   * Persist all profiles to a compact binary file, replacing it.
+   * Returns false on I/O failure.
+   */
+  bool saveToFile(const std::string& path) const;
+
+  /**
+   * Merge profiles from a file written by saveToFile() into the store.
+   * Returns false if the file is missing, truncated, or from an
+   * incompatible version; the store is left unchanged in that case.
+   */
+  bool loadFromFile(const std::string& path);
+
+  // Bound on distinct routes retained
+  static constexpr size_t kMaxRoutes = 1024;
+
+ private:
+  // Bucket i counts samples in [2^i, 2^(i+1)); 28 buckets cover sizes
+  // up to 128MB
+  static constexpr size_t kNumBuckets = 28;
+
+  struct Entry {
+    uint64_t txnCount{0};
+    std::array<uint64_t, kNumBuckets> arenaBuckets{};
+    std::array<uint64_t, kNumBuckets> bodyBuckets{};
+  };
+
+  static size_t bucketOf(size_t bytes);
+  static size_t p99UpperBound(const std::array<uint64_t, kNumBuckets>& buckets,
+                              uint64_t count);
+  static Profile makeProfile(const Entry& entry);
+
+  mutable std::mutex mutex_;
+  std::unordered_map<std::string, Entry> entries_;
+};
+
+} // namespace proxygen
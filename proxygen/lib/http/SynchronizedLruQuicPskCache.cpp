@@ -9,16 +9,34 @@
  */
 #include <proxygen/lib/http/SynchronizedLruQuicPskCache.h>
 
+#include <functional>
+
 namespace proxygen {
 
-SynchronizedLruQuicPskCache::SynchronizedLruQuicPskCache(uint64_t mapMax)
-    : cache_(EvictingPskMap(mapMax)) {
+SynchronizedLruQuicPskCache::SynchronizedLruQuicPskCache(uint64_t mapMax) {
+  size_t numShards = 1;
+  while (numShards * 2 <= kMaxShards && numShards * 2 <= mapMax) {
+    numShards *= 2;
+  }
+  uint64_t perShard = (mapMax + numShards - 1) / numShards;
+  shards_.reserve(numShards);
+  for (size_t i = 0; i < numShards; i++) {
+    shards_.push_back(
+        std::make_unique<folly::Synchronized<EvictingPskMap>>(
+            EvictingPskMap(perShard)));
+  }
+}
+
+folly::Synchronized<SynchronizedLruQuicPskCache::EvictingPskMap>&
+SynchronizedLruQuicPskCache::shardFor(const std::string& identity) {
+  // shards_.size() is a power of two
+  return *shards_[std::hash<std::string>()(identity) & (shards_.size() - 1)];
 }
 
 folly::Optional<quic::QuicCachedPsk> SynchronizedLruQuicPskCache::getPsk(
     const std::string& identity) {
-  auto cacheMap = cache_.wlock();
-  auto result = cacheMap->find(identity);
+  auto cacheMap = shardFor(identity).rlock();
+  auto result = cacheMap->findWithoutPromotion(identity);
   if (result != cacheMap->end()) {
     return result->second;
   } else {
@@ -28,12 +46,12 @@ folly::Optional<quic::QuicCachedPsk> SynchronizedLruQuicPskCache::getPsk(
 
 void SynchronizedLruQuicPskCache::putPsk(const std::string& identity,
                                          quic::QuicCachedPsk psk) {
-  auto cacheMap = cache_.wlock();
+  auto cacheMap = shardFor(identity).wlock();
   cacheMap->set(identity, std::move(psk));
 }
 
 void SynchronizedLruQuicPskCache::removePsk(const std::string& identity) {
-  auto cacheMap = cache_.wlock();
+  auto cacheMap = shardFor(identity).wlock();
   cacheMap->erase(identity);
 }
 
@@ -13,8 +13,22 @@
 #include <folly/container/EvictingCacheMap.h>
 #include <quic/client/handshake/QuicPskCache.h>
 
+#include <memory>
+#include <vector>
+
 namespace proxygen {
 
+/**
+ * LRU PSK cache sharded by identity hash so concurrent resumption
+ * attempts on different workers do not serialize on one mutex.  Each
+ * shard is its own EvictingCacheMap with a proportional share of the
+ * capacity, and the get path takes only the shard's shared (reader)
+ * lock: lookups do not promote the entry in the LRU order, so hits on
+ * the same shard proceed in parallel.  Recency is therefore tracked per
+ * write rather than per read; QUIC PSKs are effectively single-use
+ * (a get is typically followed by a putPsk of the replacement ticket,
+ * which does promote), so the eviction order stays close to true LRU.
+ */
 class SynchronizedLruQuicPskCache : public quic::QuicPskCache {
  public:
   ~SynchronizedLruQuicPskCache() override = default;
@@ -31,7 +45,14 @@ class SynchronizedLruQuicPskCache : public quic::QuicPskCache {
  private:
   using EvictingPskMap =
       folly::EvictingCacheMap<std::string, quic::QuicCachedPsk>;
-  folly::Synchronized<EvictingPskMap> cache_;
+
+  folly::Synchronized<EvictingPskMap>& shardFor(const std::string& identity);
+
+  // Enough shards to spread the worker threads out; capped by the cache
+  // capacity so tiny caches do not round their size up
+  static const size_t kMaxShards = 16;
+
+  std::vector<std::unique_ptr<folly::Synchronized<EvictingPskMap>>> shards_;
 };
 
 } // namespace proxygen
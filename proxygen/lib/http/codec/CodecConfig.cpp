@@ -0,0 +1,53 @@
+/*
+ *  Copyright (c) 2015-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include <proxygen/lib/http/codec/CodecConfig.h>
+
+#include <glog/logging.h>
+#include <proxygen/lib/http/codec/HTTP2Constants.h>
+#include <proxygen/lib/http/codec/SPDYCodec.h>
+#include <proxygen/lib/http/codec/compress/HeaderIndexingStrategy.h>
+#include <proxygen/lib/services/AcceptorConfiguration.h>
+
+namespace proxygen {
+
+CodecConfig::Ptr CodecConfig::fromAcceptorConfiguration(
+    const AcceptorConfiguration& accConfig) {
+  auto config = std::make_shared<CodecConfig>();
+
+  auto version = SPDYCodec::getVersion(accConfig.plaintextProtocol);
+  if (version) {
+    config->plaintextSpdyVersion = *version;
+  } else if (accConfig.plaintextProtocol ==
+             http2::kProtocolCleartextString) {
+    config->plaintextHTTP2 = true;
+  } else if (!accConfig.plaintextProtocol.empty()) {
+    LOG(WARNING) << "Unrecognized plaintext protocol '"
+                 << accConfig.plaintextProtocol << "', ignoring";
+  }
+
+  config->trustedIngress = accConfig.trustedIngress;
+
+  config->spdyCompressionLevel = accConfig.spdyCompressionLevel;
+  if (config->spdyCompressionLevel < Z_DEFAULT_COMPRESSION ||
+      config->spdyCompressionLevel > Z_BEST_COMPRESSION) {
+    LOG(WARNING) << "Invalid spdyCompressionLevel "
+                 << config->spdyCompressionLevel << ", using none";
+    config->spdyCompressionLevel = Z_NO_COMPRESSION;
+  }
+
+  config->allowedPlaintextUpgradeProtocols =
+      accConfig.allowedPlaintextUpgradeProtocols;
+
+  config->headerIndexingStrategy = HeaderIndexingStrategy::getDefaultInstance();
+
+  return config;
+}
+
+} // namespace proxygen
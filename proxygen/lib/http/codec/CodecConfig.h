@@ -0,0 +1,68 @@
+/*
+ *  Copyright (c) 2015-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#pragma once
+
+#include <list>
+#include <memory>
+#include <string>
+
+#include <folly/Optional.h>
+#include <proxygen/lib/http/codec/SPDYVersion.h>
+
+namespace proxygen {
+
+class AcceptorConfiguration;
+class HeaderIndexingStrategy;
+
+/**
+ * Immutable, pre-validated snapshot of the configuration a codec
+ * factory consults per accepted connection.  All the derivable work —
+ * resolving the plaintext protocol string to a concrete codec choice,
+ * clamping the SPDY compression level, picking the header indexing
+ * strategy — happens once in fromAcceptorConfiguration at config(-swap)
+ * time, so per-connection codec construction reads resolved fields and
+ * stores a couple of pointers.
+ *
+ * Snapshots are shared via shared_ptr<const CodecConfig>: a hot reload
+ * builds a fresh snapshot and swaps the pointer on the factory
+ * (HTTPDefaultSessionCodecFactory::updateCodecConfig); connections
+ * already holding the old snapshot keep it alive until they finish.
+ */
+class CodecConfig {
+ public:
+  using Ptr = std::shared_ptr<const CodecConfig>;
+
+  /**
+   * Validates and resolves the acceptor configuration into a snapshot.
+   * Invalid values are clamped with a warning rather than rejected, so
+   * a bad config swap degrades instead of dropping connections.
+   */
+  static Ptr fromAcceptorConfiguration(const AcceptorConfiguration& accConfig);
+
+  // Resolved from AcceptorConfiguration::plaintextProtocol: at most one
+  // of these is set, forcing the codec choice on non-TLS connections
+  folly::Optional<SPDYVersion> plaintextSpdyVersion;
+  bool plaintextHTTP2{false};
+
+  // Peers on trusted listeners are pre-authenticated; codecs skip
+  // per-byte header validation
+  bool trustedIngress{false};
+
+  // Clamped to zlib's valid range
+  int spdyCompressionLevel{0};
+
+  std::list<std::string> allowedPlaintextUpgradeProtocols;
+
+  // Applied to HPACK-capable codecs at construction; never null after
+  // fromAcceptorConfiguration
+  const HeaderIndexingStrategy* headerIndexingStrategy{nullptr};
+};
+
+} // namespace proxygen
@@ -9,10 +9,65 @@
  */
 #include <proxygen/lib/http/codec/CodecUtil.h>
 
+#include <folly/Portability.h>
 #include <folly/ThreadLocal.h>
+#include <folly/lang/Bits.h>
 #include <proxygen/lib/http/RFC2616.h>
 #include <proxygen/lib/http/codec/HeaderConstants.h>
 
+#if FOLLY_SSE_PREREQ(2, 0)
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+using folly::ByteRange;
+
+#if FOLLY_SSE_PREREQ(2, 0)
+// Unsigned x <= bound, lane-wise.  SSE2 only has signed compares; min
+// against the bound and test for equality instead.
+inline __m128i lanesAtMost(__m128i block, uint8_t bound) {
+  return _mm_cmpeq_epi8(_mm_min_epu8(block, _mm_set1_epi8(bound)), block);
+}
+#endif
+
+/**
+ * Returns the index of the first byte at or after `start` that
+ * validateHeaderValue's state machine has to look at: a CTL (anything
+ * below 0x20, which covers HT and CR), DEL, a quote or a backslash.
+ * Everything else is plain TEXT that cannot change the machine's state,
+ * so the caller may jump straight over it.  Returns value.size() when
+ * the rest of the value is all plain.
+ */
+size_t findInterestingHeaderByte(ByteRange value, size_t start) {
+  const uint8_t* data = value.data();
+  size_t i = start;
+#if FOLLY_SSE_PREREQ(2, 0)
+  for (; i + 16 <= value.size(); i += 16) {
+    __m128i block =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+    __m128i interesting = _mm_or_si128(
+        _mm_or_si128(lanesAtMost(block, 0x1f),
+                     _mm_cmpeq_epi8(block, _mm_set1_epi8(0x7f))),
+        _mm_or_si128(_mm_cmpeq_epi8(block, _mm_set1_epi8('"')),
+                     _mm_cmpeq_epi8(block, _mm_set1_epi8('\\'))));
+    uint32_t mask = _mm_movemask_epi8(interesting);
+    if (mask != 0) {
+      return i + folly::findFirstSet(mask) - 1;
+    }
+  }
+#endif
+  for (; i < value.size(); ++i) {
+    const uint8_t c = data[i];
+    if (c < 0x20 || c == 0x7f || c == '"' || c == '\\') {
+      return i;
+    }
+  }
+  return i;
+}
+
+} // namespace
+
 namespace proxygen {
 
 /**
@@ -58,6 +113,113 @@ const char CodecUtil::http_tokens[256] = {
        'x',     'y',     'z',      0,      '|',     '}',     '~',       0
 };
 
+bool CodecUtil::validateURL(folly::ByteRange url) {
+  const uint8_t* data = url.data();
+  size_t i = 0;
+#if FOLLY_SSE_PREREQ(2, 0)
+  for (; i + 16 <= url.size(); i += 16) {
+    __m128i block =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+    __m128i bad = _mm_or_si128(
+        lanesAtMost(block, 0x20),
+        _mm_cmpeq_epi8(block, _mm_set1_epi8(0x7f)));
+    if (_mm_movemask_epi8(bad) != 0) {
+      return false;
+    }
+  }
+#endif
+  for (; i < url.size(); ++i) {
+    if (data[i] <= 0x20 || data[i] == 0x7f) {
+      // no controls or unescaped spaces
+      return false;
+    }
+  }
+  return true;
+}
+
+bool CodecUtil::validateHeaderValue(folly::ByteRange value,
+                                    CtlEscapeMode mode) {
+  bool escape = false;
+  bool quote = false;
+  enum { lws_none,
+         lws_expect_nl,
+         lws_expect_ws1,
+         lws_expect_ws2 } state = lws_none;
+
+  for (size_t i = 0; i < value.size(); ++i) {
+    if (state == lws_none && !escape) {
+      // Plain TEXT cannot change quote or LWS state; classify a block at
+      // a time and fast-forward to the next byte that can
+      i = findInterestingHeaderByte(value, i);
+      if (i >= value.size()) {
+        break;
+      }
+    }
+    const uint8_t c = value[i];
+    if (escape) {
+      escape = false;
+      if (mode == COMPLIANT) {
+        // prev char escaped.  Turn off escape and go to next char
+        // COMPLIANT mode only
+        assert(quote);
+        continue;
+      }
+    }
+    switch (state) {
+      case lws_none:
+        switch (c) {
+          case '\\':
+            if (quote) {
+              escape = true;
+            }
+            break;
+          case '\"':
+            quote = !quote;
+            break;
+          case '\r':
+            state = lws_expect_nl;
+            break;
+          default:
+            if ((c < 0x20 || c == 0x7f) && c != '\t') {
+              // unexpected ctl per rfc2616, HT OK
+              return false;
+            }
+            break;
+        }
+        break;
+      case lws_expect_nl:
+        if (c != '\n') {
+          // unescaped \r must be LWS
+          return false;
+        }
+        state = lws_expect_ws1;
+        break;
+      case lws_expect_ws1:
+        if (c != ' ' && c != '\t') {
+          // unescaped \r\n must be LWS
+          return false;
+        }
+        state = lws_expect_ws2;
+        break;
+      case lws_expect_ws2:
+        if (c != ' ' && c != '\t') {
+          // terminated LWS
+          state = lws_none;
+          // check this char again
+          i--;
+        }
+        break;
+    }
+  }
+  // Unterminated quotes are OK, since the value can be* TEXT which treats
+  // the " like any other char.
+  // Unterminated escapes are bad because it will escape the next character
+  // when converting to HTTP
+  // Unterminated LWS (dangling \r or \r\n) is bad because it could
+  // prematurely terminate the headers when converting to HTTP
+  return !escape && (state == lws_none || state == lws_expect_ws2);
+}
+
 bool CodecUtil::hasGzipAndDeflate(const std::string& value, bool& hasGzip,
                                  bool& hasDeflate) {
   static folly::ThreadLocal<std::vector<RFC2616::TokenQPair>> output;
@@ -125,6 +287,18 @@ void CodecUtil::prepareMessageForCompression(
     temps.emplace_back(HTTPMessage::formatDateHeader());
     allHeaders.emplace_back(HTTP_HEADER_DATE, temps.back());
   }
+
+  // Pass-through metadata rides at the end of the block as never-indexed
+  // literals; see HTTPMessage::setMetadataHeader
+  const HTTPHeaders* metadata = msg.getMetadataHeaders();
+  if (metadata) {
+    metadata->forEachWithCode([&](HTTPHeaderCode code,
+                                  const std::string& name,
+                                  const std::string& value) {
+      allHeaders.emplace_back(code, name, value);
+      allHeaders.back().neverIndex = true;
+    });
+  }
 }
 
 bool CodecUtil::appendHeaders(const HTTPHeaders& inputHeaders,
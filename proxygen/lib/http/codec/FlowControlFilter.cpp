@@ -20,6 +20,36 @@ HTTPException getException(const std::string& msg) {
 
 }
 
+size_t WindowUpdateBatcher::flushStream(HTTPCodec* codec,
+                                        folly::IOBufQueue& writeBuf,
+                                        HTTPCodec::StreamID stream,
+                                        uint64_t& delta) {
+  uint64_t toSend = delta - (delta % quantum_);
+  if (toSend == 0) {
+    return 0;
+  }
+  delta -= toSend;
+  return codec->generateWindowUpdate(writeBuf, stream, toSend);
+}
+
+size_t WindowUpdateBatcher::flush(HTTPCodec* codec,
+                                  folly::IOBufQueue& writeBuf) {
+  size_t written = 0;
+  // Conn-level update goes out ahead of the stream updates it covers
+  auto conn = pending_.find(0);
+  if (conn != pending_.end()) {
+    written += flushStream(codec, writeBuf, 0, conn->second);
+  }
+  for (auto it = pending_.begin(); it != pending_.end();) {
+    if (it->first != 0) {
+      written += flushStream(codec, writeBuf, it->first, it->second);
+    }
+    // Sub-quantum remainders ride along with the next threshold crossing
+    it = (it->second == 0) ? pending_.erase(it) : std::next(it);
+  }
+  return written;
+}
+
 FlowControlFilter::FlowControlFilter(Callback& callback,
                                      folly::IOBufQueue& writeBuf,
                                      HTTPCodec* codec,
@@ -55,6 +85,7 @@ void FlowControlFilter::setReceiveWindowSize(folly::IOBufQueue& writeBuf,
     return;
   }
   VLOG(4) << "Incrementing default conn-level recv window by " << delta;
+  settleRecvWindow();
   if (!recvWindow_.setCapacity(capacity)) {
     VLOG(2) << "Failed setting conn-level recv window capacity to " << capacity;
     return;
@@ -66,6 +97,58 @@ void FlowControlFilter::setReceiveWindowSize(folly::IOBufQueue& writeBuf,
   }
 }
 
+void FlowControlFilter::enableAutoTuning(uint32_t maxCapacity) {
+  if (maxCapacity < recvWindow_.getCapacity()) {
+    VLOG(4) << "Ignoring auto-tune cap below the current recv window";
+    return;
+  }
+  autoTuneMaxCapacity_ = maxCapacity;
+}
+
+void FlowControlFilter::onRttSample(std::chrono::microseconds rtt) {
+  rtt_ = rtt;
+}
+
+void FlowControlFilter::enableUpdateBatching(uint32_t quantum) {
+  if (!batcher_) {
+    batcher_ = std::make_unique<WindowUpdateBatcher>(quantum);
+  }
+}
+
+size_t FlowControlFilter::flushWindowUpdates(folly::IOBufQueue& writeBuf) {
+  if (!batcher_ || !batcher_->hasPending()) {
+    return 0;
+  }
+  return batcher_->flush(call_, writeBuf);
+}
+
+uint32_t FlowControlFilter::maybeAutoTuneWindow() {
+  if (autoTuneMaxCapacity_ == 0) {
+    return 0;
+  }
+  auto prev = lastWindowUpdate_;
+  lastWindowUpdate_ = getCurrentTime();
+  uint32_t capacity = recvWindow_.getCapacity();
+  if (rtt_.count() == 0 || !timePointInitialized(prev) ||
+      capacity >= autoTuneMaxCapacity_) {
+    return 0;
+  }
+  if (lastWindowUpdate_ - prev >= 2 * rtt_) {
+    // Updates are spaced well apart; the window is not the bottleneck
+    return 0;
+  }
+  // The peer drained half the window in under two RTTs, so the window is
+  // smaller than the bandwidth-delay product.  Double it, up to the cap.
+  auto newCapacity = uint32_t(
+      std::min(uint64_t(capacity) * 2, uint64_t(autoTuneMaxCapacity_)));
+  if (!recvWindow_.setCapacity(newCapacity)) {
+    VLOG(2) << "Failed auto-tuning conn-level recv window to " << newCapacity;
+    return 0;
+  }
+  VLOG(4) << "Auto-tuned conn-level recv window to " << newCapacity;
+  return newCapacity - capacity;
+}
+
 bool FlowControlFilter::ingressBytesProcessed(folly::IOBufQueue& writeBuf,
                                               uint32_t delta) {
   toAck_ += delta;
@@ -74,8 +157,15 @@ bool FlowControlFilter::ingressBytesProcessed(folly::IOBufQueue& writeBuf,
   VLOG(4) << "processed " << delta << " toAck_=" << toAck_
           << " bytes, will ack=" << willAck;
   if (willAck) {
+    settleRecvWindow();
     CHECK(recvWindow_.free(toAck_));
-    call_->generateWindowUpdate(writeBuf, 0, toAck_);
+    uint32_t update = toAck_ + maybeAutoTuneWindow();
+    if (batcher_) {
+      // Merged with any stream-level updates at the next egress flush
+      batcher_->addUpdate(0, update);
+    } else {
+      call_->generateWindowUpdate(writeBuf, 0, update);
+    }
     toAck_ = 0;
     return true;
   }
@@ -97,23 +187,37 @@ void FlowControlFilter::onBody(StreamID stream,
                                std::unique_ptr<folly::IOBuf> chain,
                                uint16_t padding) {
   uint64_t amount = chain->computeChainDataLength();
-  if (!recvWindow_.reserve(amount + padding)) {
+  // Same strict check reserve() would make, hoisted into one 64-bit
+  // comparison; the guarded Window arithmetic runs once per ack cycle
+  // in settleRecvWindow() instead of once per frame
+  if (static_cast<int64_t>(amount) + padding >
+      recvWindow_.getSize() - pendingReserve_) {
     error_ = true;
     HTTPException ex = getException(
       folly::to<std::string>(
         "Failed to reserve receive window, window size=",
-        recvWindow_.getSize(), ", amount=", amount));
+        recvWindow_.getSize() - pendingReserve_, ", amount=", amount));
     callback_->onError(0, ex, false);
   } else {
-    if (VLOG_IS_ON(4) && recvWindow_.getSize() == 0) {
+    // padding is reserved and freed in the same step, so only the data
+    // bytes stay outstanding
+    pendingReserve_ += amount;
+    if (VLOG_IS_ON(4) && recvWindow_.getSize() - pendingReserve_ == 0) {
       VLOG(4) << "recvWindow full";
     }
     toAck_ += padding;
-    CHECK(recvWindow_.free(padding));
     callback_->onBody(stream, std::move(chain), padding);
   }
 }
 
+void FlowControlFilter::settleRecvWindow() {
+  if (pendingReserve_ > 0) {
+    // Bounded by the per-frame checks above, so this cannot fail
+    CHECK(recvWindow_.reserve(pendingReserve_));
+    pendingReserve_ = 0;
+  }
+}
+
 void FlowControlFilter::onWindowUpdate(StreamID stream, uint32_t amount) {
   if (!stream) {
     bool success = sendWindow_.free(amount);
@@ -172,6 +276,10 @@ size_t FlowControlFilter::generateWindowUpdate(folly::IOBufQueue& writeBuf,
                                                StreamID stream,
                                                uint32_t delta) {
   CHECK(stream) << " someone tried to manually manipulate a conn-level window";
+  if (batcher_) {
+    batcher_->addUpdate(stream, delta);
+    return 0;
+  }
   return call_->generateWindowUpdate(writeBuf, stream, delta);
 }
 
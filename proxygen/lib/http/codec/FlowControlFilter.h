@@ -11,6 +11,11 @@
 
 #include <proxygen/lib/http/Window.h>
 #include <proxygen/lib/http/codec/HTTPCodecFilter.h>
+#include <proxygen/lib/utils/Time.h>
+
+#include <algorithm>
+#include <memory>
+#include <unordered_map>
 
 namespace folly {
 class IOBufQueue;
@@ -18,6 +23,49 @@ class IOBufQueue;
 
 namespace proxygen {
 
+/**
+ * Batches WINDOW_UPDATE generation across a loop pass. Without it, every
+ * stream that crosses its ack threshold and the session window each emit a
+ * frame immediately, so bulk transfers over many streams produce bursts of
+ * tiny frames. The batcher accumulates the deltas instead and emits them
+ * all at once when the session flushes egress, with the conn-level update
+ * first.
+ *
+ * Updates are quantized: only whole multiples of the configured quantum
+ * are emitted, and the remainder stays pending until later acks round it
+ * up. The holdback per stream is bounded by quantum - 1 bytes, which is
+ * negligible next to the half-window ack thresholds that feed the batcher.
+ */
+class WindowUpdateBatcher {
+ public:
+  explicit WindowUpdateBatcher(uint32_t quantum)
+      : quantum_(std::max(quantum, 1u)) {}
+
+  void addUpdate(HTTPCodec::StreamID stream, uint32_t delta) {
+    pending_[stream] += delta;
+  }
+
+  bool hasPending() const {
+    return !pending_.empty();
+  }
+
+  /**
+   * Emit the quantized portion of every pending update into writeBuf.
+   * @returns the number of bytes written
+   */
+  size_t flush(HTTPCodec* codec, folly::IOBufQueue& writeBuf);
+
+ private:
+  size_t flushStream(HTTPCodec* codec,
+                     folly::IOBufQueue& writeBuf,
+                     HTTPCodec::StreamID stream,
+                     uint64_t& delta);
+
+  uint32_t quantum_;
+  // stream -> pending ack bytes; stream 0 is the conn-level window
+  std::unordered_map<HTTPCodec::StreamID, uint64_t> pending_;
+};
+
 /**
  * This class implements the logic for managing per-session flow
  * control. Not every codec is interested in per-session flow control, so
@@ -64,6 +112,51 @@ class FlowControlFilter:
    */
   void setReceiveWindowSize(folly::IOBufQueue& writeBuf, uint32_t capacity);
 
+  /**
+   * Enable BDP-based auto-tuning of the conn-level receive window.
+   *
+   * When enabled, the filter tracks the pacing of its own WINDOW_UPDATE
+   * frames against the RTT estimates fed through onRttSample(). A peer
+   * that fills half the window in under two RTTs is being throttled by
+   * the window rather than by available bandwidth, so the window
+   * capacity is doubled, up to maxCapacity. The capacity increase rides
+   * along with the regular bulk WINDOW_UPDATE, so no extra frames are
+   * generated and the update rate stays constant as the window grows.
+   *
+   * @param maxCapacity Upper bound for the tuned receive window.
+   */
+  void enableAutoTuning(uint32_t maxCapacity);
+
+  /**
+   * Feed an RTT estimate for auto-tuning, e.g. from the transport's
+   * tcp_info. Auto-tuning stays inert until the first sample arrives.
+   */
+  void onRttSample(std::chrono::microseconds rtt);
+
+  /**
+   * Defer WINDOW_UPDATE generation into a WindowUpdateBatcher. Stream and
+   * session level updates accumulate there instead of each writing a frame,
+   * and the session drains them in one burst via flushWindowUpdates() when
+   * it flushes egress. Updates are emitted in multiples of quantum.
+   */
+  void enableUpdateBatching(uint32_t quantum);
+
+  /**
+   * @returns true iff batching is enabled and updates are waiting to be
+   *          flushed. The session must schedule a write when this holds,
+   *          since the deferred updates wrote nothing to the egress buffer.
+   */
+  bool hasPendingWindowUpdates() const {
+    return batcher_ && batcher_->hasPending();
+  }
+
+  /**
+   * Write all pending batched updates to writeBuf. A no-op unless
+   * enableUpdateBatching() was called.
+   * @returns the number of bytes written
+   */
+  size_t flushWindowUpdates(folly::IOBufQueue& writeBuf);
+
   /**
    * Notify the flow control filter that some ingress bytes were
    * processed. If the number of bytes to acknowledge exceeds half the
@@ -100,11 +193,32 @@ class FlowControlFilter:
                               uint32_t delta) override;
 
  private:
+  /**
+   * Grow the receive window if auto-tuning decides it is the bottleneck.
+   * Called when a conn-level WINDOW_UPDATE is about to be generated.
+   *
+   * @returns the capacity delta to fold into the WINDOW_UPDATE, or 0.
+   */
+  uint32_t maybeAutoTuneWindow();
+
+  /**
+   * Apply the accumulated ingress reservations to recvWindow_.  onBody
+   * validates each frame against the window in plain 64-bit arithmetic
+   * and batches the deltas here; the guarded Window update happens once
+   * per ack cycle rather than once per frame.  Must run before anything
+   * reads or resizes recvWindow_ directly.
+   */
+  void settleRecvWindow();
 
   Callback& notify_;
+  std::unique_ptr<WindowUpdateBatcher> batcher_;
   Window recvWindow_;
   Window sendWindow_;
+  int64_t pendingReserve_{0};
   int32_t toAck_{0};
+  uint32_t autoTuneMaxCapacity_{0};
+  std::chrono::microseconds rtt_{0};
+  TimePoint lastWindowUpdate_;
   bool error_:1;
   bool sendsBlocked_:1;
 };
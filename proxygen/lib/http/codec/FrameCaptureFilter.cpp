@@ -0,0 +1,77 @@
+/*
+ *  Copyright (c) 2015-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include <proxygen/lib/http/codec/FrameCaptureFilter.h>
+
+#include <sstream>
+
+#include <proxygen/lib/http/codec/HTTP2Framer.h>
+#include <proxygen/lib/utils/Time.h>
+
+namespace proxygen {
+
+constexpr size_t FrameCaptureFilter::kCapacity;
+
+void FrameCaptureFilter::onFrameHeader(StreamID streamID,
+                                       uint8_t flags,
+                                       uint64_t length,
+                                       uint64_t type,
+                                       uint16_t version) {
+  auto& entry = ring_[total_ % kCapacity];
+  entry.timestamp = millisecondsSinceEpoch();
+  entry.streamID = streamID;
+  entry.length = length;
+  entry.type = type;
+  entry.version = version;
+  entry.flags = flags;
+  ++total_;
+  callback_->onFrameHeader(streamID, flags, length, type, version);
+}
+
+void FrameCaptureFilter::onError(StreamID stream,
+                                 const HTTPException& error,
+                                 bool newStream) {
+  // Only session-level errors tear down the connection; dump the
+  // history for those.  Stream-level errors pass through untouched.
+  if (stream == 0) {
+    std::ostringstream history;
+    dumpHistory(history);
+    LOG(ERROR) << "Session-level codec error: " << error.what()
+               << ", last " << getNumCaptured()
+               << " ingress frames:" << history.str();
+  }
+  callback_->onError(stream, error, newStream);
+}
+
+void FrameCaptureFilter::dumpHistory(std::ostream& os) const {
+  size_t count = getNumCaptured();
+  for (size_t i = total_ - count; i < total_; i++) {
+    os << "\n  ";
+    describeEntry(os, ring_[i % kCapacity]);
+  }
+}
+
+void FrameCaptureFilter::describeEntry(std::ostream& os,
+                                       const Entry& entry) const {
+  os << "t=" << entry.timestamp.count() << "ms";
+  if (call_->getProtocol() == CodecProtocol::HTTP_2) {
+    os << " type="
+       << http2::getFrameTypeString(static_cast<http2::FrameType>(entry.type));
+  } else if (entry.version > 0) {
+    // SPDY control frame
+    os << " ctrl type=" << entry.type << " version=" << entry.version;
+  } else {
+    os << " type=" << entry.type;
+  }
+  os << " stream=" << entry.streamID << " flags=0x" << std::hex
+     << folly::to<unsigned int>(entry.flags) << std::dec
+     << " length=" << entry.length;
+}
+
+} // namespace proxygen
@@ -0,0 +1,91 @@
+/*
+ *  Copyright (c) 2015-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#pragma once
+
+#include <array>
+#include <ostream>
+
+#include <proxygen/lib/http/codec/HTTPCodecFilter.h>
+
+namespace proxygen {
+
+/**
+ * A codec filter that records the header of every ingress frame - stream
+ * id, type, flags, length, and a timestamp, never the payload - in a
+ * fixed-size ring.  Recording a frame is a handful of plain stores, so
+ * the filter is cheap enough to leave on in production, unlike
+ * HTTPCodecPrinter which formats eagerly to stdout.
+ *
+ * When the codec reports a session-level error the filter logs a decoded
+ * dump of the captured history before forwarding the error, so every
+ * protocol-level connection reset comes with the last frames that led up
+ * to it; dumpHistory() makes the same decode available to other error
+ * paths.  Decoding only happens at dump time - the hot path stores raw
+ * fields.
+ *
+ * Install with HTTPSessionBase::addCodecFilter<FrameCaptureFilter>().
+ */
+class FrameCaptureFilter : public PassThroughHTTPCodecFilter {
+ public:
+  struct Entry {
+    std::chrono::milliseconds timestamp{0};
+    StreamID streamID{0};
+    uint64_t length{0};
+    uint64_t type{0};
+    uint16_t version{0};
+    uint8_t flags{0};
+  };
+
+  // Frames of history retained per session.  At 40 bytes an entry the
+  // ring costs ~2.5KB per connection.
+  static constexpr size_t kCapacity = 64;
+
+  /*
+   * Called from SPDYCodec::parseIngress()
+   *             HTTP2Codec::onIngress()
+   * when SPDY and HTTP/2 frame headers are parsed
+   */
+  void onFrameHeader(StreamID streamID,
+                     uint8_t flags,
+                     uint64_t length,
+                     uint64_t type,
+                     uint16_t version = 0) override;
+
+  /*
+   * Called from SPDYCodec::failSession()
+   *             HTTP2Codec::checkConnectionError()
+   */
+  void onError(StreamID stream,
+               const HTTPException& error,
+               bool newStream = false) override;
+
+  /**
+   * Appends a human-readable decode of the captured history to os,
+   * oldest frame first.
+   */
+  void dumpHistory(std::ostream& os) const;
+
+  /**
+   * Number of frames currently held in the ring (saturates at
+   * kCapacity).
+   */
+  size_t getNumCaptured() const {
+    return std::min(total_, kCapacity);
+  }
+
+ private:
+  void describeEntry(std::ostream& os, const Entry& entry) const;
+
+  std::array<Entry, kCapacity> ring_;
+  // Frames ever captured; ring_[total_ % kCapacity] is the next slot.
+  size_t total_{0};
+};
+
+} // namespace proxygen
@@ -33,6 +33,13 @@ class HQFramedCodec : public HTTPCodec {
 
   ~HQFramedCodec() override = default;
 
+  /**
+   * Parse frames directly from the (possibly chained) transport-owned
+   * buffer.  Payload bytes delivered to the callback are refcounted
+   * slices of the input chain, not copies, so the caller must keep the
+   * chain alive until this returns; only bytes the callback retains keep
+   * their underlying buffers alive afterwards.
+   */
   size_t onFramedIngress(const folly::IOBuf& buf);
 
   // HTTPCodec API
@@ -506,6 +506,56 @@ void HQStreamCodec::generatePushPromise(folly::IOBufQueue& writeBuf,
   generateHeaderImpl(writeBuf, msg, pushId, size);
 }
 
+bool HQStreamCodec::generateHeaders(folly::IOBufQueue& writeBuf,
+                                    StreamID stream,
+                                    std::vector<compress::Header>& headers,
+                                    bool /*eom*/,
+                                    HTTPHeaderSize* size) {
+  DCHECK_EQ(stream, streamId_);
+  // The batch path carries no HTTPMessage, so it cannot piggyback the
+  // 0-length DATA frame partially reliable egress needs; callers there must
+  // use generateHeader().
+  CHECK(!egressPartiallyReliable_)
+      << ": batched headers not supported on partially reliable streams";
+
+  auto result = headerCodec_.encode(headers, streamId_, maxEncoderStreamData());
+  if (size) {
+    *size = headerCodec_.getEncodedSize();
+  }
+
+  if (headerCodec_.getEncodedSize().uncompressed >
+      ingressSettings_.getSetting(SettingsId::MAX_HEADER_LIST_SIZE,
+                                  std::numeric_limits<uint32_t>::max())) {
+    // The remote side told us they don't want headers this large...
+    // but this function has no mechanism to fail
+    string serializedHeaders;
+    for (const auto& header : headers) {
+      serializedHeaders = folly::to<string>(serializedHeaders, "\\n",
+                                            *header.name, ":", *header.value);
+    }
+    LOG(ERROR) << "generating HEADERS frame larger than peer maximum nHeaders="
+               << headers.size() << " all headers=" << serializedHeaders;
+  }
+
+  if (result.control) {
+    // Pack the instructions into the queue's tailroom: blocks encoded for
+    // different streams in the same loop pass then drain as one contiguous
+    // encoder stream write instead of a chain of tiny buffers
+    qpackEncoderWriteBuf_.append(std::move(result.control), true /* pack */);
+  }
+
+  auto res = hq::writeHeaders(writeBuf, std::move(result.stream));
+  if (res.hasValue()) {
+    totalEgressBytes_ += res.value();
+  } else {
+    LOG(ERROR) << __func__ << ": failed to write headers: " << res.error();
+  }
+
+  // A prepared batch is always a final header block
+  finalEgressHeadersSeen_ = true;
+  return true;
+}
+
 void HQStreamCodec::generateHeaderImpl(folly::IOBufQueue& writeBuf,
                                        const HTTPMessage& msg,
                                        folly::Optional<StreamID> pushId,
@@ -543,7 +593,10 @@ void HQStreamCodec::generateHeaderImpl(folly::IOBufQueue& writeBuf,
   // control stream
 
   if (result.control) {
-    qpackEncoderWriteBuf_.append(std::move(result.control));
+    // Pack the instructions into the queue's tailroom: blocks encoded for
+    // different streams in the same loop pass then drain as one contiguous
+    // encoder stream write instead of a chain of tiny buffers
+    qpackEncoderWriteBuf_.append(std::move(result.control), true /* pack */);
   }
 
   WriteResult res;
@@ -111,6 +111,12 @@ class HQStreamCodec
                       bool eom = false,
                       HTTPHeaderSize* size = nullptr) override;
 
+  bool generateHeaders(folly::IOBufQueue& writeBuf,
+                       StreamID stream,
+                       std::vector<compress::Header>& headers,
+                       bool eom,
+                       HTTPHeaderSize* size = nullptr) override;
+
   void generatePushPromise(folly::IOBufQueue& writeBuf,
                            StreamID stream,
                            const HTTPMessage& msg,
@@ -15,6 +15,8 @@
 #include <proxygen/lib/http/HTTPHeaderSize.h>
 #include <proxygen/lib/http/RFC2616.h>
 #include <proxygen/lib/http/codec/CodecProtocol.h>
+#include <proxygen/lib/http/codec/CodecUtil.h>
+#include <proxygen/lib/http/codec/compress/GzipHeaderCodec.h>
 #include <proxygen/lib/utils/Base64.h>
 
 using folly::IOBuf;
@@ -28,6 +30,25 @@ namespace {
 static const std::string kChunked = "chunked";
 const char CRLF[] = "\r\n";
 
+// Negotiated header-compression extension (see
+// HTTP1xCodec::enableHeaderCompression)
+static const std::string kHeaderCompressionHeader =
+  "Proxygen-Header-Compression";
+static const std::string kHeaderCompressionToken = "gzip";
+static const std::string kCompressedHeadersHeader =
+  "Proxygen-Compressed-Headers";
+
+// Chunks no larger than this are copied into the write buffer together with
+// their framing rather than linked in as separate IOBufs; see generateBody.
+constexpr size_t kChunkCoalesceThreshold = 512;
+
+// Unchunked bodies no larger than this are packed into the write
+// buffer's existing tailroom, so a small content-length response whose
+// size was reserved at header time serializes into one contiguous
+// buffer.  Packing never allocates: whatever does not fit is linked in
+// as usual.
+constexpr size_t kBodyPackThreshold = 16 * 1024;
+
 /**
  * Write an ASCII decimal representation of an integer value
  * @note This function does -not- append a trailing null byte.
@@ -78,7 +99,45 @@ appendString(IOBufQueue& queue, size_t& len, StringPiece str) {
 
 namespace proxygen {
 
-HTTP1xCodec::HTTP1xCodec(TransportDirection direction, bool forceUpstream1_1)
+namespace {
+
+// Fully assembled "HTTP/1.1 <code> <reason>" status lines for every
+// status code, built once at first use.  Every code is three digits, so
+// the reason phrase starts at a fixed offset in each line.
+const int kMinStatusCode = 100;
+const int kMaxStatusCode = 599;
+const size_t kReasonOffset = 13; // strlen("HTTP/1.1 nnn ")
+
+/**
+ * Return the precomputed status line for this response, or nullptr when
+ * the message carries a non-standard reason phrase and the line has to
+ * be assembled piece by piece.
+ */
+const std::string* getStatusLine11(int statusCode, StringPiece statusMessage) {
+  static const std::vector<std::string> lines = [] {
+    std::vector<std::string> table;
+    table.reserve(kMaxStatusCode - kMinStatusCode + 1);
+    for (int code = kMinStatusCode; code <= kMaxStatusCode; code++) {
+      table.push_back(folly::to<std::string>(
+          "HTTP/1.1 ", code, " ", HTTPMessage::getDefaultReason(code)));
+    }
+    return table;
+  }();
+  if (statusCode < kMinStatusCode || statusCode > kMaxStatusCode) {
+    return nullptr;
+  }
+  const auto& line = lines[statusCode - kMinStatusCode];
+  if (StringPiece(line).subpiece(kReasonOffset) != statusMessage) {
+    return nullptr;
+  }
+  return &line;
+}
+
+} // anonymous namespace
+
+HTTP1xCodec::HTTP1xCodec(TransportDirection direction,
+                         bool forceUpstream1_1,
+                         bool useSimdParsing)
     : callback_(nullptr),
       ingressTxnID_(0),
       egressTxnID_(0),
@@ -108,7 +167,9 @@ HTTP1xCodec::HTTP1xCodec(TransportDirection direction, bool forceUpstream1_1)
       ingressUpgradeComplete_(false),
       egressUpgrade_(false),
       nativeUpgrade_(false),
-      headersComplete_(false) {
+      headersComplete_(false),
+      headerCompressionEnabled_(false),
+      egressHeaderCompression_(false) {
   switch (direction) {
   case TransportDirection::DOWNSTREAM:
     http_parser_init(&parser_, HTTP_REQUEST);
@@ -120,6 +181,7 @@ HTTP1xCodec::HTTP1xCodec(TransportDirection direction, bool forceUpstream1_1)
     LOG(FATAL) << "Unknown transport direction.";
   }
   parser_.data = this;
+  parser_.simd_scan = useSimdParsing ? 1 : 0;
 }
 
 HTTP1xCodec::~HTTP1xCodec() {
@@ -450,6 +512,14 @@ HTTP1xCodec::generateHeader(IOBufQueue& writeBuf,
     if (version == HTTPMessage::kHTTPVersion09) {
       return;
     }
+    if (version == HTTPMessage::kHTTPVersion11) {
+      // The common case: one precomputed line, one copy
+      if (const std::string* line = getStatusLine11(statusCode,
+                                                    statusMessage)) {
+        appendString(writeBuf, len, *line);
+        break;
+      }
+    }
     appendLiteral(writeBuf, len, "HTTP/");
     appendUint(writeBuf, len, version.first);
     appendLiteral(writeBuf, len, ".");
@@ -508,6 +578,11 @@ HTTP1xCodec::generateHeader(IOBufQueue& writeBuf,
   size_t lastConnectionToken = 0;
   bool egressWebsocketUpgrade = msg.isEgressWebsocketUpgrade();
   bool hasUpgradeTokeninConnection = false;
+  // Divert non-framing headers into a single compressed block once the peer
+  // has advertised the extension (see enableHeaderCompression)
+  const bool compressEgressHeaders = egressHeaderCompression_ &&
+    headerCompressionCodec_ && !is1xxResponse_ && !egressWebsocketUpgrade;
+  std::vector<compress::Header> headersToCompress;
   msg.getHeaders().forEachWithCode([&] (HTTPHeaderCode code,
                                         const string& header,
                                         const string& value) {
@@ -562,6 +637,17 @@ HTTP1xCodec::generateHeader(IOBufQueue& writeBuf,
       // will generate our own accept per hop, not client's.
       return;
     }
+    if (compressEgressHeaders &&
+        code != HTTP_HEADER_TRANSFER_ENCODING &&
+        code != HTTP_HEADER_UPGRADE &&
+        code != HTTP_HEADER_DATE &&
+        !caseInsensitiveEqual(header, kHeaderCompressionHeader) &&
+        !caseInsensitiveEqual(header, kCompressedHeadersHeader)) {
+      // Anything the peer does not need to frame the message travels in the
+      // compressed block; name/value storage stays valid through encode()
+      headersToCompress.emplace_back(code, header, value);
+      return; // continue
+    }
     size_t lineLen = header.length() + value.length() + 4; // 4 for ": " + CRLF
     auto writable = writeBuf.preallocate(lineLen,
         std::max(lineLen, size_t(2000)));
@@ -622,23 +708,45 @@ HTTP1xCodec::generateHeader(IOBufQueue& writeBuf,
   if (!is1xxResponse_ || upstream || !connectionTokens.empty()) {
     // We don't seem to add keep-alive/close and let the application add any
     // for 1xx responses.
-    appendLiteral(writeBuf, len, "Connection: ");
-    if (connectionTokens.size() > 0) {
-      appendString(writeBuf, len, folly::join(", ", connectionTokens));
-    }
-    if (!is1xxResponse_) {
-      if (connectionTokens.size() > 0) {
-        appendString(writeBuf, len, ", ");
-      }
+    if (connectionTokens.empty() && !is1xxResponse_) {
+      // The common case: the whole header is one of two literals
       if (keepalive_) {
-        appendLiteral(writeBuf, len, "keep-alive");
+        appendLiteral(writeBuf, len, "Connection: keep-alive\r\n");
       } else {
-        appendLiteral(writeBuf, len, "close");
+        appendLiteral(writeBuf, len, "Connection: close\r\n");
+      }
+    } else {
+      appendLiteral(writeBuf, len, "Connection: ");
+      if (connectionTokens.size() > 0) {
+        appendString(writeBuf, len, folly::join(", ", connectionTokens));
+      }
+      if (!is1xxResponse_) {
+        if (connectionTokens.size() > 0) {
+          appendString(writeBuf, len, ", ");
+        }
+        if (keepalive_) {
+          appendLiteral(writeBuf, len, "keep-alive");
+        } else {
+          appendLiteral(writeBuf, len, "close");
+        }
       }
+      appendLiteral(writeBuf, len, "\r\n");
     }
-    appendLiteral(writeBuf, len, "\r\n");
   }
 
+  if (headerCompressionEnabled_ && !is1xxResponse_ &&
+      (upstream ? !egressHeaderCompression_ : egressHeaderCompression_)) {
+    // Upstream advertises until the peer confirms; downstream echoes the
+    // advertisement so the client knows it may compress subsequent requests
+    appendLiteral(writeBuf, len, "Proxygen-Header-Compression: gzip\r\n");
+  }
+  if (compressEgressHeaders && !headersToCompress.empty()) {
+    auto block = headerCompressionCodec_->encode(headersToCompress);
+    const auto encoded = Base64::encode(block->coalesce());
+    appendLiteral(writeBuf, len, "Proxygen-Compressed-Headers: ");
+    appendString(writeBuf, len, encoded);
+    appendLiteral(writeBuf, len, CRLF);
+  }
   if (deferredContentLength) {
     appendLiteral(writeBuf, len, "Content-Length: ");
     appendString(writeBuf, len, *deferredContentLength);
@@ -682,11 +790,22 @@ size_t HTTP1xCodec::generateBody(IOBufQueue& writeBuf,
     writeBuf.append(chunkLenBuf, rc);
     totLen += rc;
 
-    writeBuf.append(std::move(chain));
+    if (buflen <= kChunkCoalesceThreshold) {
+      // Tiny chunks (SSE events, incremental JSON) would otherwise cost
+      // three chain elements apiece: the size line, the linked-in body, and
+      // the trailing CRLF.  Copy the body into the write buffer so
+      // back-to-back sends pack into the same tail buffer and the transport
+      // sees one contiguous write per flush.
+      for (auto range : *chain) {
+        writeBuf.append(range.data(), range.size());
+      }
+    } else {
+      writeBuf.append(std::move(chain));
+    }
     writeBuf.append("\r\n", 2);
     totLen += 2;
   } else {
-    writeBuf.append(std::move(chain));
+    writeBuf.append(std::move(chain), buflen <= kBodyPackThreshold /* pack */);
   }
   if (eom) {
     totLen += generateEOM(writeBuf, txn);
@@ -814,12 +933,70 @@ const std::string& HTTP1xCodec::getAllowedUpgradeProtocols() {
   return allowedNativeUpgrades_;
 }
 
+void HTTP1xCodec::enableHeaderCompression(int compressionLevel) {
+  headerCompressionEnabled_ = true;
+  if (!headerCompressionCodec_) {
+    headerCompressionCodec_ =
+      std::make_unique<GzipHeaderCodec>(compressionLevel);
+  }
+}
+
+int HTTP1xCodec::decodeCompressedHeaders(const std::string& encoded) {
+  DCHECK(headerCompressionCodec_);
+  int padding = 0;
+  for (auto it = encoded.rbegin();
+       padding < 2 && it != encoded.rend() && *it == '=';
+       ++it) {
+    ++padding;
+  }
+  const string compressed = Base64::decode(encoded, padding);
+  auto buf = folly::IOBuf::wrapBuffer(compressed.data(), compressed.length());
+  folly::io::Cursor cursor(buf.get());
+  auto result = headerCompressionCodec_->decode(cursor, compressed.length());
+  if (result.hasError()) {
+    LOG(ERROR) << "Error inflating compressed headers, err="
+               << folly::to<string>(result.error());
+    return -1;
+  }
+  const auto& inHeaders = result->headers;
+  CHECK_EQ((inHeaders.size() & 1), 0);
+  HTTPHeaders& hdrs = msg_->getHeaders();
+  for (unsigned i = 0; i < inHeaders.size(); i += 2) {
+    folly::StringPiece name = inHeaders[i].str;
+    folly::StringPiece value = inHeaders[i + 1].str;
+    if (!CodecUtil::validateHeaderName(name) ||
+        !CodecUtil::validateHeaderValue(value, CodecUtil::STRICT)) {
+      LOG(ERROR) << "Bad header in compressed block: " << name;
+      return -1;
+    }
+    // Framing headers always travel in the clear; one smuggled into the
+    // compressed block never participated in http_parser's framing
+    // decisions, so reject the message rather than deliver it.
+    auto code = HTTPCommonHeaders::hash(name.data(), name.size());
+    if (code == HTTP_HEADER_CONTENT_LENGTH ||
+        code == HTTP_HEADER_TRANSFER_ENCODING ||
+        code == HTTP_HEADER_CONNECTION ||
+        code == HTTP_HEADER_UPGRADE) {
+      LOG(ERROR) << "Framing header in compressed block: " << name;
+      return -1;
+    }
+    hdrs.add(name, value);
+  }
+  return 0;
+}
+
 int
 HTTP1xCodec::onMessageBegin() {
   headersComplete_ = false;
   headerSize_.uncompressed = 0;
   headerParseState_ = HeaderParseState::kParsingHeaderStart;
-  msg_.reset(new HTTPMessage());
+  // Ingress direction is fixed by the transport direction; construct the
+  // typed message so the direction decision stays out of the parse path
+  if (transportDirection_ == TransportDirection::DOWNSTREAM) {
+    msg_ = std::make_unique<HTTPRequestMessage>();
+  } else {
+    msg_ = std::make_unique<HTTPResponseMessage>();
+  }
   trailers_.reset();
   if (transportDirection_ == TransportDirection::DOWNSTREAM) {
     requestPending_ = true;
@@ -929,6 +1106,24 @@ HTTP1xCodec::onHeadersComplete(size_t len) {
     pushHeaderNameAndValue(msg_->getHeaders());
   }
 
+  if (headerCompressionEnabled_) {
+    const std::string& block =
+      msg_->getHeaders().getSingleOrEmpty(kCompressedHeadersHeader);
+    if (!block.empty() && decodeCompressedHeaders(block) != 0) {
+      return -1;
+    }
+    const std::string& negotiation =
+      msg_->getHeaders().getSingleOrEmpty(kHeaderCompressionHeader);
+    if (caseInsensitiveEqual(negotiation, kHeaderCompressionToken)) {
+      // Requests advertise, responses confirm; either way the peer has the
+      // extension, so egress may compress from here on
+      egressHeaderCompression_ = true;
+    }
+    // Both extension headers are hop-by-hop; don't deliver them
+    msg_->getHeaders().remove(kHeaderCompressionHeader);
+    msg_->getHeaders().remove(kCompressedHeadersHeader);
+  }
+
   // discard messages with folded or multiple valued Transfer-Encoding headers
   // ex : "chunked , zorg\r\n" or "\r\n chunked \r\n" (t12767790)
   HTTPHeaders& hdrs = msg_->getHeaders();
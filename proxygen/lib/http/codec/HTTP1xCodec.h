@@ -18,10 +18,18 @@
 
 namespace proxygen {
 
+class GzipHeaderCodec;
+
 class HTTP1xCodec : public HTTPCodec {
  public:
+  /**
+   * useSimdParsing selects the vectorized (SSE2/SWAR) header tokenizer in
+   * the underlying parser; it is semantically identical to the scalar path
+   * and only changes how ingress bytes are scanned.
+   */
   explicit HTTP1xCodec(TransportDirection direction,
-                       bool forceUpstream1_1 = false);
+                       bool forceUpstream1_1 = false,
+                       bool useSimdParsing = false);
   ~HTTP1xCodec() override;
 
   HTTP1xCodec(HTTP1xCodec&&) = default;
@@ -89,6 +97,33 @@ class HTTP1xCodec : public HTTPCodec {
   void setAllowedUpgradeProtocols(std::list<std::string> protocols);
   const std::string& getAllowedUpgradeProtocols();
 
+  /**
+   * Enable the negotiated header-compression extension.
+   *
+   * An upstream codec with the extension enabled advertises
+   * "Proxygen-Header-Compression: gzip" on its requests; a downstream codec
+   * that also has it enabled echoes the header on its responses.  Once a
+   * peer has advertised, egress messages carry all non-framing headers in a
+   * single "Proxygen-Compressed-Headers" header holding the base64 of a
+   * zlib name/value block seeded with the SPDY shared dictionary (the same
+   * machinery GzipHeaderCodec provides to SPDYCodec, minus the SPDY frame
+   * layer).  Headers the peer needs to frame the message -- Content-Length,
+   * Transfer-Encoding, Connection, Upgrade and Date -- always stay in the
+   * clear, so a peer without the extension just sees one unknown header.
+   *
+   * compressionLevel is a zlib level; most of the win comes from the shared
+   * dictionary, so low levels are a reasonable CPU/bytes tradeoff.
+   */
+  void enableHeaderCompression(int compressionLevel = 4);
+
+  /**
+   * Whether the peer has advertised the extension and egress headers are
+   * being compressed.  Exposed mainly for tests and instrumentation.
+   */
+  bool isHeaderCompressionActive() const {
+    return egressHeaderCompression_;
+  }
+
   /**
    * @returns true if the codec supports the given NPN protocol.
    */
@@ -142,6 +177,10 @@ class HTTP1xCodec : public HTTPCodec {
   /** Push out header name-value pair to hdrs and clear currentHeader*_ */
   void pushHeaderNameAndValue(HTTPHeaders& hdrs);
 
+  /** Inflate a Proxygen-Compressed-Headers block into msg_'s headers.
+      Returns non-zero on a malformed block, failing the message. */
+  int decodeCompressedHeaders(const std::string& encoded);
+
   /** Serialize websocket headers into a buffer **/
   void serializeWebsocketHeader(folly::IOBufQueue& writeBuf, size_t& len,
       bool upstream);
@@ -164,6 +203,7 @@ class HTTP1xCodec : public HTTPCodec {
   http_parser parser_;
   const folly::IOBuf* currentIngressBuf_;
   std::unique_ptr<HTTPMessage> msg_;
+  std::unique_ptr<GzipHeaderCodec> headerCompressionCodec_;
   std::unique_ptr<HTTPMessage> upgradeRequest_;
   std::unique_ptr<HTTPHeaders> trailers_;
   std::string currentHeaderName_;
@@ -203,6 +243,8 @@ class HTTP1xCodec : public HTTPCodec {
   bool egressUpgrade_:1;
   bool nativeUpgrade_:1;
   bool headersComplete_:1;
+  bool headerCompressionEnabled_:1;
+  bool egressHeaderCompression_:1; // peer advertised; egress may compress
 
   // C-callable wrappers for the http_parser callbacks
   static int onMessageBeginCB(http_parser* parser);
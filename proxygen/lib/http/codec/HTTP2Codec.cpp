@@ -10,6 +10,7 @@
 #include <proxygen/lib/http/codec/HTTP2Codec.h>
 #include <proxygen/lib/http/codec/HTTP2Constants.h>
 #include <proxygen/lib/http/codec/CodecUtil.h>
+#include <proxygen/lib/utils/CycleProbe.h>
 #include <proxygen/lib/utils/Logging.h>
 #include <proxygen/lib/utils/Base64.h>
 
@@ -34,6 +35,10 @@ std::string base64url_decode(const std::string& str) {
   return proxygen::Base64::urlDecode(str);
 }
 
+// Payloads at or below this take the single-region copy path in
+// generateBody; above it the zero-copy batch path wins
+constexpr uint64_t kSmallDataFrameThreshold = 100;
+
 }
 
 namespace proxygen {
@@ -58,11 +63,26 @@ HTTP2Codec::HTTP2Codec(TransportDirection direction)
 
 HTTP2Codec::~HTTP2Codec() {}
 
+void HTTP2Codec::setSeedHeaderDictionary(
+    std::shared_ptr<const SeedHeaderDictionary> dict) {
+  seedDict_ = std::move(dict);
+  if (!seedDict_) {
+    return;
+  }
+  // We can decode seed references from this point on; advertise the
+  // fingerprint so the peer knows it may emit them.  Our encoder stays
+  // RFC-only until the peer's SETTINGS confirm the same fingerprint.
+  headerCodec_.setDecoderSeedDictionary(seedDict_);
+  egressSettings_.setSetting(SettingsId::HEADER_SEED_DICTIONARY,
+                             seedDict_->getFingerprint());
+}
+
 // HTTPCodec API
 
 size_t HTTP2Codec::onIngress(const folly::IOBuf& buf) {
   // TODO: ensure only 1 parse at a time on stack.
   FOLLY_SCOPED_TRACE_SECTION("HTTP2Codec - onIngress");
+  PROXYGEN_CYCLE_PROBE(H2_INGRESS);
 
   Cursor cursor(&buf);
   size_t parsed = 0;
@@ -141,8 +161,15 @@ size_t HTTP2Codec::onIngress(const folly::IOBuf& buf) {
       // Already parsed the common frame header
       const auto frameLen = curHeader_.length;
       if (bufLen >= frameLen) {
-        connError = parseFrame(cursor);
-        parsed += curHeader_.length;
+        if (curHeader_.type == http2::FrameType::DATA &&
+            expectedContinuationStream_ == 0) {
+          // Fully buffered DATA; parse it together with any directly
+          // following DATA frames for the same stream
+          connError = parseDataFrameTrain(cursor, bufLen, parsed);
+        } else {
+          connError = parseFrame(cursor);
+          parsed += curHeader_.length;
+        }
         frameState_ = FrameState::FRAME_HEADER;
       } else {
         break;
@@ -153,8 +180,56 @@ size_t HTTP2Codec::onIngress(const folly::IOBuf& buf) {
   return parsed;
 }
 
+const std::array<HTTP2Codec::FrameDispatch, 256>&
+HTTP2Codec::getFrameDispatchTable() {
+  static const std::array<FrameDispatch, 256> table = [] {
+    std::array<FrameDispatch, 256> t;
+    t.fill({&HTTP2Codec::skipFrame, 0});
+    auto set = [&t](http2::FrameType type,
+                    ErrorCode (HTTP2Codec::*parse)(folly::io::Cursor&),
+                    uint8_t preconditions = 0) {
+      t[static_cast<uint8_t>(type)] = {parse, preconditions};
+    };
+    // The hot types (DATA=0, HEADERS=1, WINDOW_UPDATE=8) occupy the low,
+    // dense indices, so their entries share a cache line
+    set(http2::FrameType::DATA, &HTTP2Codec::parseAllData);
+    set(http2::FrameType::HEADERS, &HTTP2Codec::parseHeaders,
+        kAffectsCompression);
+    set(http2::FrameType::PRIORITY, &HTTP2Codec::parsePriority);
+    set(http2::FrameType::RST_STREAM, &HTTP2Codec::parseRstStream);
+    set(http2::FrameType::SETTINGS, &HTTP2Codec::parseSettings);
+    set(http2::FrameType::PUSH_PROMISE, &HTTP2Codec::parsePushPromise,
+        kAffectsCompression);
+    set(http2::FrameType::PING, &HTTP2Codec::parsePing);
+    set(http2::FrameType::GOAWAY, &HTTP2Codec::parseGoaway);
+    set(http2::FrameType::WINDOW_UPDATE, &HTTP2Codec::parseWindowUpdate);
+    set(http2::FrameType::CONTINUATION, &HTTP2Codec::parseContinuation,
+        kAffectsCompression);
+    // ALTSVC stays on the unimplemented skipFrame default
+    set(http2::FrameType::EX_HEADERS, &HTTP2Codec::parseExHeaders,
+        kNeedsExHeadersSetting);
+    set(http2::FrameType::CERTIFICATE_REQUEST,
+        &HTTP2Codec::parseCertificateRequest);
+    set(http2::FrameType::CERTIFICATE, &HTTP2Codec::parseCertificate);
+    return t;
+  }();
+  return table;
+}
+
+ErrorCode HTTP2Codec::skipFrame(folly::io::Cursor& cursor) {
+  // Implementations MUST ignore and discard any frame that has a
+  // type that is unknown
+  VLOG(2) << "Skipping frame (type=" << (uint8_t)curHeader_.type << ")";
+  cursor.skip(curHeader_.length);
+  return ErrorCode::NO_ERROR;
+}
+
 ErrorCode HTTP2Codec::parseFrame(folly::io::Cursor& cursor) {
   FOLLY_SCOPED_TRACE_SECTION("HTTP2Codec - parseFrame");
+  const auto& dispatch =
+      getFrameDispatchTable()[static_cast<uint8_t>(curHeader_.type)];
+  const bool affectsCompression =
+      dispatch.preconditions & kAffectsCompression;
   if (expectedContinuationStream_ != 0 &&
        (curHeader_.type != http2::FrameType::CONTINUATION ||
         expectedContinuationStream_ != curHeader_.stream)) {
@@ -173,18 +248,16 @@ ErrorCode HTTP2Codec::parseFrame(folly::io::Cursor& cursor) {
     VLOG(4) << goawayErrorMessage_;
     return ErrorCode::PROTOCOL_ERROR;
   }
-  if (frameAffectsCompression(curHeader_.type) &&
+  if (affectsCompression &&
       curHeaderBlock_.chainLength() + curHeader_.length >
       egressSettings_.getSetting(SettingsId::MAX_HEADER_LIST_SIZE, 0)) {
-    // this may be off by up to the padding length (max 255), but
-    // these numbers are already so generous, and we're comparing the
-    // max-uncompressed to the actual compressed size.  Let's fail
-    // before buffering.
-
-    // TODO(t6513634): it would be nicer to stream-process this header
-    // block to keep the connection state consistent without consuming
-    // memory, and fail just the request per the HTTP/2 spec (section
-    // 10.3)
+    // Header blocks are decoded incrementally as fragments arrive, so
+    // curHeaderBlock_ normally holds no more than one partial header
+    // field.  Tripping this limit therefore means a single field (or an
+    // undecodable tail) bigger than the max uncompressed size -- fail
+    // before buffering it.  This may be off by up to the padding length
+    // (max 255), but these numbers are already so generous, and we're
+    // comparing the max-uncompressed to the actual compressed size.
     goawayErrorMessage_ = folly::to<string>(
       "Failing connection due to excessively large headers");
     LOG(ERROR) << goawayErrorMessage_;
@@ -192,54 +265,16 @@ ErrorCode HTTP2Codec::parseFrame(folly::io::Cursor& cursor) {
   }
 
   expectedContinuationStream_ =
-    (frameAffectsCompression(curHeader_.type) &&
+    (affectsCompression &&
      !(curHeader_.flags & http2::END_HEADERS)) ? curHeader_.stream : 0;
 
-  switch (curHeader_.type) {
-    case http2::FrameType::DATA:
-      return parseAllData(cursor);
-    case http2::FrameType::HEADERS:
-      return parseHeaders(cursor);
-    case http2::FrameType::PRIORITY:
-      return parsePriority(cursor);
-    case http2::FrameType::RST_STREAM:
-      return parseRstStream(cursor);
-    case http2::FrameType::SETTINGS:
-      return parseSettings(cursor);
-    case http2::FrameType::PUSH_PROMISE:
-      return parsePushPromise(cursor);
-    case http2::FrameType::EX_HEADERS:
-      if (ingressSettings_.getSetting(SettingsId::ENABLE_EX_HEADERS, 0)) {
-        return parseExHeaders(cursor);
-      } else {
-        VLOG(2) << "EX_HEADERS not enabled, ignoring the frame";
-        break;
-      }
-    case http2::FrameType::PING:
-      return parsePing(cursor);
-    case http2::FrameType::GOAWAY:
-      return parseGoaway(cursor);
-    case http2::FrameType::WINDOW_UPDATE:
-      return parseWindowUpdate(cursor);
-    case http2::FrameType::CONTINUATION:
-      return parseContinuation(cursor);
-    case http2::FrameType::ALTSVC:
-      // fall through, unimplemented
-      break;
-    case http2::FrameType::CERTIFICATE_REQUEST:
-      return parseCertificateRequest(cursor);
-    case http2::FrameType::CERTIFICATE:
-      return parseCertificate(cursor);
-    default:
-      // Implementations MUST ignore and discard any frame that has a
-      // type that is unknown
-      break;
+  if ((dispatch.preconditions & kNeedsExHeadersSetting) &&
+      !ingressSettings_.getSetting(SettingsId::ENABLE_EX_HEADERS, 0)) {
+    VLOG(2) << "EX_HEADERS not enabled, ignoring the frame";
+    return skipFrame(cursor);
   }
 
-  // Landing here means unknown, unimplemented or ignored frame.
-  VLOG(2) << "Skipping frame (type=" << (uint8_t)curHeader_.type << ")";
-  cursor.skip(curHeader_.length);
-  return ErrorCode::NO_ERROR;
+  return (this->*dispatch.parse)(cursor);
 }
 
 ErrorCode HTTP2Codec::handleEndStream() {
@@ -289,6 +324,77 @@ ErrorCode HTTP2Codec::parseAllData(Cursor& cursor) {
   return handleEndStream();
 }
 
+ErrorCode HTTP2Codec::parseDataFrameTrain(Cursor& cursor,
+                                          size_t bufLen,
+                                          size_t& parsed) {
+  FOLLY_SCOPED_TRACE_SECTION("HTTP2Codec - parseDataFrameTrain");
+  std::unique_ptr<IOBuf> outData;
+  uint16_t padding = 0;
+  VLOG(10) << "parsing DATA frame train for stream=" << curHeader_.stream <<
+    " length=" << curHeader_.length;
+  auto ret = http2::parseData(cursor, curHeader_, outData, padding);
+  RETURN_IF_ERROR(ret);
+  parsed += curHeader_.length;
+  bufLen -= curHeader_.length;
+
+  // Trains of back-to-back DATA frames dominate the ingest path; rather
+  // than dispatching one onBody per frame, fold every directly following
+  // fully-buffered unpadded DATA frame for this stream into a single
+  // delivery.  Peeking the next header up front also warms the payload
+  // cache lines before the clone touches them.
+  while (padding == 0 && !(curHeader_.flags & http2::END_STREAM) &&
+         bufLen >= http2::kFrameHeaderSize) {
+    Cursor peek(cursor);
+    http2::FrameHeader nextHeader;
+    if (parseFrameHeader(peek, nextHeader) != ErrorCode::NO_ERROR ||
+        nextHeader.type != http2::FrameType::DATA ||
+        nextHeader.stream != curHeader_.stream ||
+        frameHasPadding(nextHeader) ||
+        nextHeader.length > maxRecvFrameSize() ||
+        bufLen < http2::kFrameHeaderSize + nextHeader.length) {
+      // Not part of the train; the main loop parses it via the usual path
+      break;
+    }
+    cursor = peek;
+    curHeader_ = nextHeader;
+    parsed += http2::kFrameHeaderSize;
+    bufLen -= http2::kFrameHeaderSize;
+    if (callback_) {
+      callback_->onFrameHeader(
+        curHeader_.stream,
+        curHeader_.flags,
+        curHeader_.length,
+        static_cast<uint8_t>(curHeader_.type));
+    }
+#ifndef NDEBUG
+    receivedFrameCount_++;
+#endif
+    std::unique_ptr<IOBuf> nextData;
+    uint16_t nextPadding = 0;
+    ret = http2::parseData(cursor, curHeader_, nextData, nextPadding);
+    RETURN_IF_ERROR(ret);
+    DCHECK_EQ(nextPadding, 0);
+    parsed += curHeader_.length;
+    bufLen -= curHeader_.length;
+    if (nextData && !nextData->empty()) {
+      if (outData) {
+        outData->prependChain(std::move(nextData));
+      } else {
+        outData = std::move(nextData);
+      }
+    }
+  }
+
+  if (callback_ && (padding > 0 || (outData && !outData->empty()))) {
+    if (!outData) {
+      outData = std::make_unique<IOBuf>();
+    }
+    deliverCallbackIfAllowed(&HTTPCodec::Callback::onBody, "onBody",
+                             curHeader_.stream, std::move(outData), padding);
+  }
+  return handleEndStream();
+}
+
 ErrorCode HTTP2Codec::parseDataFrameData(Cursor& cursor,
                                          size_t bufLen,
                                          size_t& parsed) {
@@ -420,21 +526,67 @@ ErrorCode HTTP2Codec::parseHeadersImpl(
     const folly::Optional<http2::PriorityUpdate>& priority,
     const folly::Optional<uint32_t>& promisedStream,
     const folly::Optional<ExAttributes>& exAttributes) {
+  // if we're not parsing CONTINUATION, then it's start of new header block
+  if (curHeader_.type != http2::FrameType::CONTINUATION) {
+    headerBlockFrameType_ = curHeader_.type;
+    skipCurHeaderBlock_ = false;
+    bool isReq = false;
+    if (promisedStream) {
+      isReq = true;
+    } else if (exAttributes) {
+      isReq = isRequest(curHeader_.stream);
+    } else {
+      isReq = transportDirection_ == TransportDirection::DOWNSTREAM;
+    }
+
+    // Validate circular dependencies.
+    if (priority && (curHeader_.stream == priority->streamDependency)) {
+      streamError(
+          folly::to<string>("Circular dependency for txn=", curHeader_.stream),
+          ErrorCode::PROTOCOL_ERROR,
+          curHeader_.type == http2::FrameType::HEADERS);
+      // drop any CONTINUATION fragments of this block too
+      skipCurHeaderBlock_ = true;
+      return ErrorCode::NO_ERROR;
+    }
+
+    decodeInfo_.init(isReq, parsingDownstreamTrailers_);
+    if (priority) {
+      decodeInfo_.msg->setHTTP2Priority(
+          std::make_tuple(priority->streamDependency,
+                          priority->exclusive,
+                          priority->weight));
+    }
+  } else if (skipCurHeaderBlock_) {
+    return ErrorCode::NO_ERROR;
+  }
+
   curHeaderBlock_.append(std::move(headerBuf));
+  // Decode whatever complete header fields have arrived and release their
+  // compressed bytes right away; only a field split across the end of the
+  // fragment stays buffered until the next CONTINUATION.  This keeps the
+  // resident footprint of a large header block to roughly one field
+  // instead of the whole compressed block plus the decoded copy.
+  if (decodeInfo_.decodeError == HPACK::DecodeError::NONE) {
+    folly::IOBuf emptyBuf;
+    Cursor headerCursor(
+        curHeaderBlock_.empty() ? &emptyBuf : curHeaderBlock_.front());
+    auto consumed = headerCodec_.decodeStreamingFragment(
+        headerCursor,
+        curHeaderBlock_.chainLength(),
+        curHeader_.flags & http2::END_HEADERS,
+        this);
+    curHeaderBlock_.trimStart(consumed);
+  }
+
   std::unique_ptr<HTTPMessage> msg;
   if (curHeader_.flags & http2::END_HEADERS) {
-    auto errorCode =
-        parseHeadersDecodeFrames(priority, promisedStream, exAttributes, msg);
+    auto errorCode = parseHeadersDecodeFrames(msg);
     if (errorCode.hasValue()) {
       return errorCode.value();
     }
   }
 
-  // if we're not parsing CONTINUATION, then it's start of new header block
-  if (curHeader_.type != http2::FrameType::CONTINUATION) {
-    headerBlockFrameType_ = curHeader_.type;
-  }
-
   // Report back what we've parsed
   if (callback_) {
     auto concurError = parseHeadersCheckConcurrentStreams(priority);
@@ -485,7 +637,9 @@ ErrorCode HTTP2Codec::parseHeadersImpl(
                 << " direction=" << transportDirection_;
         auto trailerHeaders =
             std::make_unique<HTTPHeaders>(msg->extractHeaders());
-        msg.reset();
+        // The message was only a vehicle for the trailer block; recycle
+        // it so the next header block reuses the allocation
+        decodeInfo_.recycleMessage(std::move(msg));
         callback_->onTrailersComplete(headersCompleteStream,
                                       std::move(trailerHeaders));
       } else {
@@ -498,40 +652,9 @@ ErrorCode HTTP2Codec::parseHeadersImpl(
 }
 
 folly::Optional<ErrorCode> HTTP2Codec::parseHeadersDecodeFrames(
-    const folly::Optional<http2::PriorityUpdate>& priority,
-    const folly::Optional<uint32_t>& promisedStream,
-    const folly::Optional<ExAttributes>& exAttributes,
     std::unique_ptr<HTTPMessage>& msg) {
-  // decompress headers
-  Cursor headerCursor(curHeaderBlock_.front());
-  bool isReq = false;
-  if (promisedStream) {
-    isReq = true;
-  } else if (exAttributes) {
-    isReq = isRequest(curHeader_.stream);
-  } else {
-    isReq = transportDirection_ == TransportDirection::DOWNSTREAM;
-  }
-
-  // Validate circular dependencies.
-  if (priority && (curHeader_.stream == priority->streamDependency)) {
-    streamError(
-        folly::to<string>("Circular dependency for txn=", curHeader_.stream),
-        ErrorCode::PROTOCOL_ERROR,
-        curHeader_.type == http2::FrameType::HEADERS);
-    return ErrorCode::NO_ERROR;
-  }
-
-  decodeInfo_.init(isReq, parsingDownstreamTrailers_);
-  if (priority) {
-    decodeInfo_.msg->setHTTP2Priority(
-        std::make_tuple(priority->streamDependency,
-                        priority->exclusive,
-                        priority->weight));
-  }
-
-  headerCodec_.decodeStreaming(
-      headerCursor, curHeaderBlock_.chainLength(), this);
+  // The block itself was decoded incrementally as the fragments arrived;
+  // all that's left here is harvesting the message and checking errors
   msg = std::move(decodeInfo_.msg);
   // Saving this in case we need to log it on error
   auto g = folly::makeGuard([this] { curHeaderBlock_.move(); });
@@ -540,10 +663,12 @@ folly::Optional<ErrorCode> HTTP2Codec::parseHeadersDecodeFrames(
     static const std::string decodeErrorMessage =
         "Failed decoding header block for stream=";
     // Avoid logging header blocks that have failed decoding due to being
-    // excessively large.
-    if (decodeInfo_.decodeError != HPACK::DecodeError::HEADERS_TOO_LARGE) {
+    // excessively large.  Only the undecoded remainder of the block is
+    // still buffered at this point.
+    if (decodeInfo_.decodeError != HPACK::DecodeError::HEADERS_TOO_LARGE &&
+        !curHeaderBlock_.empty()) {
       LOG(ERROR) << decodeErrorMessage << curHeader_.stream
-                 << " header block=";
+                 << " header block remainder=";
       VLOG(3) << IOBufPrinter::printHexFolly(curHeaderBlock_.front(), true);
     } else {
       LOG(ERROR) << decodeErrorMessage << curHeader_.stream;
@@ -559,8 +684,7 @@ folly::Optional<ErrorCode> HTTP2Codec::parseHeadersDecodeFrames(
   // Check parsing error
   if (decodeInfo_.parsingError != "") {
     LOG(ERROR) << "Failed parsing header list for stream=" << curHeader_.stream
-               << ", error=" << decodeInfo_.parsingError << ", header block=";
-    VLOG(3) << IOBufPrinter::printHexFolly(curHeaderBlock_.front(), true);
+               << ", error=" << decodeInfo_.parsingError;
     HTTPException err(HTTPException::Direction::INGRESS,
                       folly::to<std::string>("HTTP2Codec stream error: ",
                                              "stream=",
@@ -718,7 +842,19 @@ void HTTP2Codec::handleSettingsAck() {
   }
 }
 
-ErrorCode HTTP2Codec::handleSettings(const std::deque<SettingPair>& settings) {
+bool HTTP2Codec::applyIngressSettingsHint(const SettingsList& settings) {
+  std::deque<SettingPair> pairs;
+  for (const auto& setting : settings) {
+    pairs.emplace_back(setting.id, setting.value);
+  }
+  // Suppress the onSettings callback: the session would otherwise ACK a
+  // SETTINGS frame that was never received
+  return handleSettings(pairs, false /* deliverCallback */) ==
+         ErrorCode::NO_ERROR;
+}
+
+ErrorCode HTTP2Codec::handleSettings(const std::deque<SettingPair>& settings,
+                                     bool deliverCallback) {
   SettingsList settingsList;
   for (auto& setting: settings) {
     switch (setting.first) {
@@ -800,6 +936,15 @@ ErrorCode HTTP2Codec::handleSettings(const std::deque<SettingPair>& settings) {
       case SettingsId::THRIFT_CHANNEL_ID:
       case SettingsId::THRIFT_CHANNEL_ID_DEPRECATED:
         break;
+      case SettingsId::HEADER_SEED_DICTIONARY:
+        if (seedDict_ && setting.second == seedDict_->getFingerprint()) {
+          // The peer holds the same artifact and can decode references
+          // to it, so the encoder may start using seed indexes
+          VLOG(4) << "peer confirmed seed dictionary fingerprint="
+                  << setting.second;
+          headerCodec_.setEncoderSeedDictionary(seedDict_);
+        }
+        break;
       case SettingsId::SETTINGS_HTTP_CERT_AUTH:
         break;
       default:
@@ -808,7 +953,12 @@ ErrorCode HTTP2Codec::handleSettings(const std::deque<SettingPair>& settings) {
     ingressSettings_.setSetting(setting.first, setting.second);
     settingsList.push_back(*ingressSettings_.getSetting(setting.first));
   }
-  if (callback_) {
+  // Refresh the cached hot values consulted in the per-frame path
+  ingressMaxFrameSize_ = (uint32_t)ingressSettings_.getSetting(
+      SettingsId::MAX_FRAME_SIZE, http2::kMaxFramePayloadLengthMin);
+  ingressMaxHeaderListSize_ = (uint32_t)ingressSettings_.getSetting(
+      SettingsId::MAX_HEADER_LIST_SIZE, std::numeric_limits<uint32_t>::max());
+  if (callback_ && deliverCallback) {
     callback_->onSettings(settingsList);
   }
   return ErrorCode::NO_ERROR;
@@ -1138,24 +1288,94 @@ void HTTP2Codec::generateHeaderImpl(
            exAttributes);
   }
 
-  folly::ThreadLocal<std::vector<std::string>> tempsTL;
-  folly::ThreadLocal<std::vector<compress::Header>> allHeadersTL;
-  auto& temps = *tempsTL.get();
-  auto& allHeaders = *allHeadersTL.get();
-  temps.clear();
-  allHeaders.clear();
-  CodecUtil::prepareMessageForCompression(msg, allHeaders, temps);
-  auto out = encodeHeaders(msg.getHeaders(), allHeaders, size);
+  std::unique_ptr<folly::IOBuf> out;
+  // An immutable snapshot's cached block is replayed verbatim, but a
+  // consecutive repeat of the same snapshot on this connection means its
+  // headers recur here, so re-encoding through the dynamic table is
+  // worth the CPU for the smaller blocks
+  const bool replayCached =
+      msg.isHeaderBlockReusable() && msg.getReusableHeaderBlock() &&
+      (!msg.isImmutableShared() ||
+       msg.getReusableHeaderBlock() != lastReplayedHeaderBlock_);
+  if (replayCached) {
+    // A cached block is free of connection compression state, so it can
+    // be replayed here verbatim without consulting the encoder
+    out = msg.getReusableHeaderBlock()->clone();
+    if (size) {
+      *size = msg.getReusableHeaderBlockSize();
+    }
+    lastReplayedHeaderBlock_ = msg.getReusableHeaderBlock();
+  } else {
+    folly::ThreadLocal<std::vector<std::string>> tempsTL;
+    folly::ThreadLocal<std::vector<compress::Header>> allHeadersTL;
+    auto& temps = *tempsTL.get();
+    auto& allHeaders = *allHeadersTL.get();
+    temps.clear();
+    allHeaders.clear();
+    CodecUtil::prepareMessageForCompression(msg, allHeaders, temps);
+    out = encodeHeaders(
+        allHeaders,
+        size,
+        msg.isHeaderBlockReusable() && !msg.isImmutableShared());
+    if (msg.isHeaderBlockReusable() && out && !msg.isImmutableShared()) {
+      // Never write a cache back into a shared snapshot: it may be
+      // concurrently encoded on other session threads, and its block
+      // was fixed when it was frozen
+      msg.cacheReusableHeaderBlock(out->clone(),
+                                   headerCodec_.getEncodedSize());
+    }
+  }
+
+  folly::Optional<http2::PriorityUpdate> pri;
+  auto res = msg.getHTTP2Priority();
+  if (res) {
+    pri = http2::PriorityUpdate{std::get<0>(*res), std::get<1>(*res),
+                                std::get<2>(*res)};
+  }
+  writeCompressedHeaders(
+      writeBuf, stream, std::move(out), pri, assocStream, exAttributes, eom);
+}
+
+bool HTTP2Codec::generateHeaders(folly::IOBufQueue& writeBuf,
+                                 StreamID stream,
+                                 std::vector<compress::Header>& headers,
+                                 bool eom,
+                                 HTTPHeaderSize* size) {
+  VLOG(4) << "generating batched HEADERS for stream=" << stream;
+  if (!isStreamIngressEgressAllowed(stream)) {
+    VLOG(2) << "Suppressing HEADERS for stream=" << stream <<
+      " ingressGoawayAck_=" << ingressGoawayAck_;
+    if (size) {
+      size->uncompressed = 0;
+      size->compressed = 0;
+    }
+    return true;
+  }
+  auto out = encodeHeaders(headers, size);
+  writeCompressedHeaders(writeBuf,
+                         stream,
+                         std::move(out),
+                         folly::none, /* pri */
+                         folly::none, /* assocStream */
+                         folly::none, /* exAttributes */
+                         eom);
+  return true;
+}
+
+void HTTP2Codec::writeCompressedHeaders(
+    folly::IOBufQueue& writeBuf,
+    StreamID stream,
+    std::unique_ptr<folly::IOBuf> headerBlock,
+    folly::Optional<http2::PriorityUpdate> pri,
+    const folly::Optional<StreamID>& assocStream,
+    const folly::Optional<HTTPCodec::ExAttributes>& exAttributes,
+    bool eom) {
   IOBufQueue queue(IOBufQueue::cacheChainLength());
-  queue.append(std::move(out));
+  queue.append(std::move(headerBlock));
   auto maxFrameSize = maxSendFrameSize();
   if (queue.chainLength() > 0) {
-    folly::Optional<http2::PriorityUpdate> pri;
-    auto res = msg.getHTTP2Priority();
     auto remainingFrameSize = maxFrameSize;
-    if (res) {
-      pri = http2::PriorityUpdate{std::get<0>(*res), std::get<1>(*res),
-                                  std::get<2>(*res)};
+    if (pri) {
       DCHECK_GE(remainingFrameSize, http2::kFramePrioritySize)
         << "no enough space for priority? frameHeadroom=" << remainingFrameSize;
       remainingFrameSize -= http2::kFramePrioritySize;
@@ -1225,29 +1445,27 @@ void HTTP2Codec::generateContinuation(folly::IOBufQueue& writeBuf,
 }
 
 std::unique_ptr<folly::IOBuf> HTTP2Codec::encodeHeaders(
-    const HTTPHeaders& headers,
     std::vector<compress::Header>& allHeaders,
-    HTTPHeaderSize* size) {
+    HTTPHeaderSize* size,
+    bool staticOnly) {
   headerCodec_.setEncodeHeadroom(http2::kFrameHeaderSize +
                                  http2::kFrameHeadersBaseMaxSize);
-  auto out = headerCodec_.encode(allHeaders);
+  auto out = staticOnly ? headerCodec_.encodeStaticOnly(allHeaders)
+                        : headerCodec_.encode(allHeaders);
   if (size) {
     *size = headerCodec_.getEncodedSize();
   }
 
-  if (headerCodec_.getEncodedSize().uncompressed >
-      ingressSettings_.getSetting(SettingsId::MAX_HEADER_LIST_SIZE,
-                                  std::numeric_limits<uint32_t>::max())) {
+  if (headerCodec_.getEncodedSize().uncompressed > ingressMaxHeaderListSize_) {
     // The remote side told us they don't want headers this large...
     // but this function has no mechanism to fail
     string serializedHeaders;
-    headers.forEach(
-      [&serializedHeaders] (const string& name, const string& value) {
-        serializedHeaders = folly::to<string>(serializedHeaders, "\\n", name,
-                                              ":", value);
-      });
+    for (const auto& header : allHeaders) {
+      serializedHeaders = folly::to<string>(serializedHeaders, "\\n",
+                                            *header.name, ":", *header.value);
+    }
     LOG(ERROR) << "generating HEADERS frame larger than peer maximum nHeaders="
-               << headers.size() << " all headers="
+               << allHeaders.size() << " all headers="
                << serializedHeaders;
   }
   return out;
@@ -1276,9 +1494,40 @@ size_t HTTP2Codec::generateBody(folly::IOBufQueue& writeBuf,
             << ingressGoawayAck_;
     return 0;
   }
+  size_t maxFrameSize = maxSendFrameSize();
+  if (!padding) {
+    const uint64_t dataLen = chain ? chain->computeChainDataLength() : 0;
+    if (dataLen == 0 && eom) {
+      // gRPC streams end with an empty trailing DATA frame; emit it from
+      // a patched constant template
+      written = http2::writeEmptyDataEom(writeBuf, stream);
+      return generateHeaderCallbackWrapper(
+          stream, http2::FrameType::DATA, written);
+    }
+    if (dataLen <= kSmallDataFrameThreshold && dataLen <= maxFrameSize) {
+      written = http2::writeSmallData(writeBuf, std::move(chain), stream, eom);
+      return generateHeaderCallbackWrapper(
+          stream, http2::FrameType::DATA, written);
+    }
+    // Unpadded bodies take the batch path: one contiguous region for all
+    // the frame headers instead of appender setup per frame
+    written = http2::writeDataFrames(writeBuf,
+                                     std::move(chain),
+                                     stream,
+                                     maxFrameSize,
+                                     eom);
+    uint64_t remaining = dataLen;
+    do {
+      const auto frameLen = std::min<uint64_t>(remaining, maxFrameSize);
+      remaining -= frameLen;
+      generateHeaderCallbackWrapper(stream,
+                                    http2::FrameType::DATA,
+                                    http2::kFrameHeaderSize + frameLen);
+    } while (remaining > 0);
+    return written;
+  }
   IOBufQueue queue(IOBufQueue::cacheChainLength());
   queue.append(std::move(chain));
-  size_t maxFrameSize = maxSendFrameSize();
   while (queue.chainLength() > maxFrameSize) {
     auto chunk = queue.split(maxFrameSize);
     written += generateHeaderCallbackWrapper(
@@ -1323,8 +1572,33 @@ size_t HTTP2Codec::generateTrailers(folly::IOBufQueue& writeBuf,
   std::vector<compress::Header> allHeaders;
   CodecUtil::appendHeaders(trailers, allHeaders, HTTP_HEADER_NONE);
 
+  std::string key;
+  trailers.forEach([&key](const std::string& name, const std::string& value) {
+    key += name;
+    key += '\0';
+    key += value;
+    key += '\0';
+  });
+
   HTTPHeaderSize size;
-  auto out = encodeHeaders(trailers, allHeaders, &size);
+  std::unique_ptr<folly::IOBuf> out;
+  if (lastTrailersBlock_ && key == lastTrailersKey_) {
+    // Replay the cached block; it holds no connection compression state
+    // so it is valid verbatim on any stream
+    out = lastTrailersBlock_->clone();
+    size = lastTrailersSize_;
+  } else if (key == lastTrailersKey_) {
+    // Same trailers as the previous stream: this set is repeating, so
+    // encode it static-only and keep the block for replay.  Repeating
+    // trailer sets draw no benefit from dynamic-table indexing anyway.
+    out = encodeHeaders(allHeaders, &size, true /* staticOnly */);
+    lastTrailersBlock_ = out->clone();
+    lastTrailersSize_ = size;
+  } else {
+    out = encodeHeaders(allHeaders, &size);
+    lastTrailersKey_ = std::move(key);
+    lastTrailersBlock_.reset();
+  }
 
   IOBufQueue queue(IOBufQueue::cacheChainLength());
   queue.append(std::move(out));
@@ -1507,6 +1781,11 @@ size_t HTTP2Codec::generateSettings(folly::IOBufQueue& writeBuf) {
       case SettingsId::THRIFT_CHANNEL_ID:
       case SettingsId::THRIFT_CHANNEL_ID_DEPRECATED:
         break;
+      case SettingsId::HEADER_SEED_DICTIONARY:
+        if (setting.value == 0) {
+          continue;
+        }
+        break;
       default:
         LOG(ERROR) << "ignore unknown settingsId="
                    << std::underlying_type<SettingsId>::type(setting.id)
@@ -1518,8 +1797,26 @@ size_t HTTP2Codec::generateSettings(folly::IOBufQueue& writeBuf) {
   }
   VLOG(4) << getTransportDirectionString(getTransportDirection())
           << " generating " << (unsigned)settings.size() << " settings";
+  // Every accepted connection on a worker serializes an identical
+  // SETTINGS list, so render the frame once per distinct list and replay
+  // clones; a config change simply misses and re-renders
+  struct SettingsFrameMemo {
+    std::deque<SettingPair> settings;
+    std::unique_ptr<folly::IOBuf> frame;
+    size_t size{0};
+  };
+  static folly::ThreadLocal<SettingsFrameMemo> memoTL;
+  auto& memo = *memoTL.get();
+  if (!memo.frame || memo.settings != settings) {
+    folly::IOBufQueue frameBuf{folly::IOBufQueue::cacheChainLength()};
+    memo.size = http2::writeSettings(frameBuf, settings);
+    memo.frame = frameBuf.move();
+    memo.frame->coalesce();
+    memo.settings = std::move(settings);
+  }
+  writeBuf.append(memo.frame->clone());
   return generateHeaderCallbackWrapper(0, http2::FrameType::SETTINGS,
-                                       http2::writeSettings(writeBuf, settings));
+                                       memo.size);
 }
 
 void HTTP2Codec::requestUpgrade(HTTPMessage& request) {
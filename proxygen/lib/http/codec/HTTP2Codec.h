@@ -17,7 +17,9 @@
 #include <proxygen/lib/http/codec/HTTPSettings.h>
 #include <proxygen/lib/http/codec/compress/HPACKCodec.h>
 
+#include <array>
 #include <bitset>
+#include <limits>
 #include <set>
 
 namespace proxygen {
@@ -53,6 +55,11 @@ public:
                       const HTTPMessage& msg,
                       bool eom = false,
                       HTTPHeaderSize* size = nullptr) override;
+  bool generateHeaders(folly::IOBufQueue& writeBuf,
+                       StreamID stream,
+                       std::vector<compress::Header>& headers,
+                       bool eom,
+                       HTTPHeaderSize* size = nullptr) override;
   void generateContinuation(folly::IOBufQueue& writeBuf,
                             folly::IOBufQueue& queue,
                             StreamID stream,
@@ -114,6 +121,7 @@ public:
     return &ingressSettings_;
   }
   HTTPSettings* getEgressSettings() override { return &egressSettings_; }
+  bool applyIngressSettingsHint(const SettingsList& settings) override;
   uint32_t getDefaultWindowSize() const override {
     return http2::kInitialWindow;
   }
@@ -168,6 +176,16 @@ public:
     reuseIOBufHeadroomForData_ = enabled;
   }
 
+  /**
+   * Skip the per-byte header name/value/URL scans on decoded ingress.
+   * Only for listeners whose peers are already authenticated (mTLS
+   * sidecars on loopback); public listeners must keep strict
+   * validation.  Semantic h2 checks are unaffected.
+   */
+  void setStrictValidation(bool strict) {
+    decodeInfo_.setValidate(strict);
+  }
+
   void setHeaderIndexingStrategy(const HeaderIndexingStrategy* indexingStrat) {
     headerCodec_.setHeaderIndexingStrategy(indexingStrat);
   }
@@ -175,6 +193,15 @@ public:
     return headerCodec_.getHeaderIndexingStrategy();
   }
 
+  /**
+   * Install the locally loaded HPACK seed dictionary (see
+   * SeedHeaderDictionary).  Arms the decoder, and advertises the
+   * fingerprint via SETTINGS so the peer may reference the dictionary;
+   * the encoder is only armed once the peer advertises the same
+   * fingerprint back.  Call before generateSettings().
+   */
+  void setSeedHeaderDictionary(std::shared_ptr<const SeedHeaderDictionary> dict);
+
  private:
   void generateHeaderImpl(folly::IOBufQueue& writeBuf,
                           StreamID stream,
@@ -184,14 +211,52 @@ public:
                           bool eom,
                           HTTPHeaderSize* size);
   std::unique_ptr<folly::IOBuf> encodeHeaders(
-      const HTTPHeaders& headers,
       std::vector<compress::Header>& allHeaders,
-      HTTPHeaderSize* size);
+      HTTPHeaderSize* size,
+      bool staticOnly = false);
+
+  void writeCompressedHeaders(
+      folly::IOBufQueue& writeBuf,
+      StreamID stream,
+      std::unique_ptr<folly::IOBuf> headerBlock,
+      folly::Optional<http2::PriorityUpdate> pri,
+      const folly::Optional<StreamID>& assocStream,
+      const folly::Optional<ExAttributes>& exAttributes,
+      bool eom);
 
   size_t generateHeaderCallbackWrapper(StreamID stream, http2::FrameType type, size_t length);
 
   ErrorCode parseFrame(folly::io::Cursor& cursor);
+
+  // Shared preconditions a frame type must satisfy before its parser
+  // runs, checked as a bitmask off the dispatch entry rather than
+  // re-derived per type
+  enum FramePrecondition : uint8_t {
+    // Counts against the header-list size limit and participates in the
+    // CONTINUATION expectation (http2::frameAffectsCompression)
+    kAffectsCompression = 1 << 0,
+    // Only parsed when the peer negotiated ENABLE_EX_HEADERS
+    kNeedsExHeadersSetting = 1 << 1,
+  };
+  struct FrameDispatch {
+    ErrorCode (HTTP2Codec::*parse)(folly::io::Cursor&){nullptr};
+    uint8_t preconditions{0};
+  };
+  // Indexed directly by the 8-bit frame type; unknown and unimplemented
+  // types are folded in as skipFrame entries, so dispatch is a single
+  // indexed load with no range check or default branch
+  static const std::array<FrameDispatch, 256>& getFrameDispatchTable();
+
+  ErrorCode skipFrame(folly::io::Cursor& cursor);
   ErrorCode parseAllData(folly::io::Cursor& cursor);
+  /**
+   * Parse a fully buffered DATA frame plus any directly following unpadded
+   * DATA frames for the same stream, delivering them as one onBody call.
+   */
+  ErrorCode parseDataFrameTrain(
+    folly::io::Cursor& cursor,
+    size_t bufLen,
+    size_t& parsed);
   ErrorCode parseDataFrameData(
     folly::io::Cursor& cursor,
     size_t bufLen,
@@ -215,9 +280,6 @@ public:
     const folly::Optional<uint32_t>& promisedStream,
     const folly::Optional<ExAttributes>& exAttributes);
   folly::Optional<ErrorCode> parseHeadersDecodeFrames(
-      const folly::Optional<http2::PriorityUpdate>& priority,
-      const folly::Optional<uint32_t>& promisedStream,
-      const folly::Optional<ExAttributes>& exAttributes,
       std::unique_ptr<HTTPMessage>& msg);
   folly::Optional<ErrorCode> parseHeadersCheckConcurrentStreams(
       const folly::Optional<http2::PriorityUpdate>& priority);
@@ -225,11 +287,11 @@ public:
   ErrorCode handleEndStream();
   ErrorCode checkNewStream(uint32_t stream, bool trailersAllowed);
   bool checkConnectionError(ErrorCode, const folly::IOBuf* buf);
-  ErrorCode handleSettings(const std::deque<SettingPair>& settings);
+  ErrorCode handleSettings(const std::deque<SettingPair>& settings,
+                           bool deliverCallback = true);
   void handleSettingsAck();
   size_t maxSendFrameSize() const {
-    return (uint32_t)ingressSettings_.getSetting(SettingsId::MAX_FRAME_SIZE,
-                                       http2::kMaxFramePayloadLengthMin);
+    return ingressMaxFrameSize_;
   }
   uint32_t maxRecvFrameSize() const {
     return (uint32_t)egressSettings_.getSetting(SettingsId::MAX_FRAME_SIZE,
@@ -239,6 +301,21 @@ public:
   bool parsingTrailers() const;
 
   HPACKCodec headerCodec_;
+  std::shared_ptr<const SeedHeaderDictionary> seedDict_;
+
+  // Cache of the most recently generated trailer block.  Trailer sets
+  // that repeat verbatim across streams (gRPC terminates every response
+  // with the same grpc-status trailer) are encoded connection-state-free
+  // once and the block replayed thereafter.  See generateTrailers.
+  std::string lastTrailersKey_;
+  std::unique_ptr<folly::IOBuf> lastTrailersBlock_;
+  HTTPHeaderSize lastTrailersSize_;
+
+  // The shared-snapshot header block most recently replayed on this
+  // connection (see HTTPMessage::makeImmutableShared).  Compared by
+  // address only, never dereferenced, to detect a consecutive repeat of
+  // the same snapshot and switch it to a dynamic-table re-encode.
+  const folly::IOBuf* lastReplayedHeaderBlock_{nullptr};
 
   // Current frame state
   http2::FrameHeader curHeader_;
@@ -264,6 +341,12 @@ public:
     { SettingsId::MAX_FRAME_SIZE, 16384 },
     { SettingsId::MAX_HEADER_LIST_SIZE, 1 << 17 }, // same as SPDYCodec
   };
+  // Hot ingress settings values cached as plain members; refreshed in
+  // handleSettings(), the only place the ingress settings change.  The
+  // egress settings are written behind the codec's back by the session, so
+  // egress-sourced values stay on the (indexed) settings lookup.
+  uint32_t ingressMaxFrameSize_{http2::kMaxFramePayloadLengthMin};
+  uint32_t ingressMaxHeaderListSize_{std::numeric_limits<uint32_t>::max()};
 #ifndef NDEBUG
   uint64_t receivedFrameCount_{0};
 #endif
@@ -292,6 +375,9 @@ public:
   // Applies only to DOWNSTREAM, for UPSTREAM we use
   // diffrent heuristic - lack of status code.
   bool parsingDownstreamTrailers_{false};
+  // Set when the stream owning the current header block has already been
+  // reset; remaining fragments of the block are dropped undecoded
+  bool skipCurHeaderBlock_{false};
 
   // CONTINUATION frame can follow either HEADERS or PUSH_PROMISE frames.
   // Keeps frame type of iniating frame of header block.
@@ -635,6 +635,115 @@ writeData(IOBufQueue& queue,
   return kFrameHeaderSize + frameLen;
 }
 
+size_t
+writeDataFrames(IOBufQueue& queue,
+                std::unique_ptr<IOBuf> data,
+                uint32_t stream,
+                uint32_t maxFrameSize,
+                bool endStream) noexcept {
+  DCHECK_NE(0, stream);
+  DCHECK_EQ(0, ~kUint31Mask & stream);
+  DCHECK_NE(0, maxFrameSize);
+  DCHECK_EQ(0, ~kLengthMask & maxFrameSize);
+
+  IOBufQueue dataQ(IOBufQueue::cacheChainLength());
+  dataQ.append(std::move(data));
+  const uint64_t dataLen = dataQ.chainLength();
+  const size_t numFrames =
+      dataLen == 0 ? 1 : (dataLen + maxFrameSize - 1) / maxFrameSize;
+
+  // Every header is identical except for the length and flags of the last
+  // one, so render them all into one pre-reserved contiguous buffer rather
+  // than setting up an appender per frame
+  auto headers = IOBuf::create(numFrames * kFrameHeaderSize);
+  Appender appender(headers.get(), 0);
+  uint64_t remaining = dataLen;
+  for (size_t i = 0; i < numFrames; i++) {
+    const auto length = std::min<uint64_t>(remaining, maxFrameSize);
+    remaining -= length;
+    uint8_t flags = 0;
+    if (i + 1 == numFrames && endStream) {
+      flags |= END_STREAM;
+    }
+    const uint32_t lengthAndType =
+      ((kLengthMask & length) << 8) | static_cast<uint8_t>(FrameType::DATA);
+    appender.writeBE<uint32_t>(lengthAndType);
+    appender.writeBE<uint8_t>(flags);
+    appender.writeBE<uint32_t>(kUint31Mask & stream);
+  }
+
+  // Interleave zero-copy slices of the header region with the payload
+  IOBufQueue headerQ;
+  headerQ.append(std::move(headers));
+  remaining = dataLen;
+  for (size_t i = 0; i < numFrames; i++) {
+    const auto length = std::min<uint64_t>(remaining, maxFrameSize);
+    remaining -= length;
+    queue.append(headerQ.split(kFrameHeaderSize), true /* pack */);
+    if (length > 0) {
+      queue.append(dataQ.split(length));
+    }
+  }
+  return numFrames * kFrameHeaderSize + dataLen;
+}
+
+size_t
+writeEmptyDataEom(IOBufQueue& queue,
+                  uint32_t stream) noexcept {
+  DCHECK_NE(0, stream);
+  DCHECK_EQ(0, ~kUint31Mask & stream);
+  // Only the stream id varies between empty EOM frames, so patch it into
+  // a copy of this constant template instead of rendering each field
+  static constexpr uint8_t kTemplate[9] = {
+      0, 0, 0,                               // length = 0
+      static_cast<uint8_t>(FrameType::DATA), // type
+      END_STREAM,                            // flags
+      0, 0, 0, 0};                           // stream id, patched below
+  DCHECK_EQ(sizeof(kTemplate), kFrameHeaderSize);
+  auto out = queue.preallocate(kFrameHeaderSize, kFrameHeaderSize);
+  auto* header = static_cast<uint8_t*>(out.first);
+  memcpy(header, kTemplate, kFrameHeaderSize);
+  const uint32_t streamBE = folly::Endian::big(stream);
+  memcpy(header + 5, &streamBE, sizeof(streamBE));
+  queue.postallocate(kFrameHeaderSize);
+  return kFrameHeaderSize;
+}
+
+size_t
+writeSmallData(IOBufQueue& queue,
+               std::unique_ptr<IOBuf> data,
+               uint32_t stream,
+               bool endStream) noexcept {
+  DCHECK_NE(0, stream);
+  DCHECK_EQ(0, ~kUint31Mask & stream);
+  const uint64_t dataLen = data ? data->computeChainDataLength() : 0;
+  DCHECK_LE(dataLen, kMaxFramePayloadLength);
+  // For payloads this small, copying them next to the header into one
+  // pre-reserved region beats a QueueAppender plus a chain append
+  const size_t total = kFrameHeaderSize + dataLen;
+  auto out = queue.preallocate(total, total);
+  auto* header = static_cast<uint8_t*>(out.first);
+  const uint32_t lengthAndType =
+    folly::Endian::big<uint32_t>(((kLengthMask & dataLen) << 8) |
+                                 static_cast<uint8_t>(FrameType::DATA));
+  memcpy(header, &lengthAndType, sizeof(lengthAndType));
+  header[4] = endStream ? END_STREAM : 0;
+  const uint32_t streamBE = folly::Endian::big(stream);
+  memcpy(header + 5, &streamBE, sizeof(streamBE));
+  auto* payload = header + kFrameHeaderSize;
+  const IOBuf* buf = data.get();
+  while (buf) {
+    memcpy(payload, buf->data(), buf->length());
+    payload += buf->length();
+    buf = buf->next();
+    if (buf == data.get()) {
+      break;
+    }
+  }
+  queue.postallocate(total);
+  return total;
+}
+
 size_t
 writeHeaders(IOBufQueue& queue,
              std::unique_ptr<IOBuf> headers,
@@ -405,6 +405,61 @@ writeData(folly::IOBufQueue& writeBuf,
           bool endStream,
           bool reuseIOBufHeadroom) noexcept;
 
+/**
+ * Generate a batch of unpadded DATA frames, splitting data into chunks of
+ * at most maxFrameSize bytes.  All of the common frame headers are written
+ * through a single appender into one contiguous region and zero-copy slices
+ * of that region are interleaved with the payload chunks, which is cheaper
+ * than a writeData call per frame for large bodies.
+ *
+ * @param writeBuf The output queue to write to. It may grow or add
+ *                 underlying buffers inside this function.
+ * @param data The body data to write out, can be nullptr for 0 length
+ * @param stream The stream identifier of the DATA frames.
+ * @param maxFrameSize Maximum payload length of each DATA frame.
+ * @param endStream True iff the last frame ends the stream.
+ * @return The number of bytes written to writeBuf.
+ */
+size_t
+writeDataFrames(folly::IOBufQueue& writeBuf,
+                std::unique_ptr<folly::IOBuf> data,
+                uint32_t stream,
+                uint32_t maxFrameSize,
+                bool endStream) noexcept;
+
+/**
+ * Generate a 0-length DATA frame with END_STREAM set, the common trailer
+ * of gRPC-style streams.  Only the stream id varies between such frames,
+ * so the header is patched into a copy of a constant template rather than
+ * rendered field by field through an appender.
+ *
+ * @param writeBuf The output queue to write to.
+ * @param stream The stream identifier of the DATA frame.
+ * @return The number of bytes written to writeBuf.
+ */
+size_t
+writeEmptyDataEom(folly::IOBufQueue& writeBuf,
+                  uint32_t stream) noexcept;
+
+/**
+ * Generate a single unpadded DATA frame for a small payload by copying
+ * the frame header and the payload into one pre-reserved contiguous
+ * region.  Below roughly a cache line or two of payload this is cheaper
+ * than writeData's appender setup and zero-copy chain append.  The
+ * payload MUST NOT exceed kMaxFramePayloadLength.
+ *
+ * @param writeBuf The output queue to write to.
+ * @param data The body data to write out, can be nullptr for 0 length
+ * @param stream The stream identifier of the DATA frame.
+ * @param endStream True iff this frame ends the stream.
+ * @return The number of bytes written to writeBuf.
+ */
+size_t
+writeSmallData(folly::IOBufQueue& writeBuf,
+               std::unique_ptr<folly::IOBuf> data,
+               uint32_t stream,
+               bool endStream) noexcept;
+
 /**
  * Generate an entire HEADERS frame, including the common frame header. The
  * combined length of the data buffer and the padding and priority fields MUST
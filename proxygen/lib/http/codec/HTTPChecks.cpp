@@ -10,11 +10,14 @@
 #include <proxygen/lib/http/codec/HTTPChecks.h>
 
 #include <proxygen/lib/http/RFC2616.h>
+#include <proxygen/lib/http/codec/FlowControlFilter.h>
 
 namespace proxygen {
 
-void HTTPChecks::onHeadersComplete(StreamID stream,
-                                   std::unique_ptr<HTTPMessage> msg) {
+template <class BaseFilter>
+void HTTPChecksFilter<BaseFilter>::onHeadersComplete(
+    HTTPCodec::StreamID stream,
+    std::unique_ptr<HTTPMessage> msg) {
 
   if (msg->isRequest() && (RFC2616::isRequestBodyAllowed(msg->getMethod())
                            == RFC2616::BodyAllowed::NOT_ALLOWED) &&
@@ -25,18 +28,19 @@ void HTTPChecks::onHeadersComplete(StreamID stream,
     // setting the status code means that the error is at the HTTP layer and
     // that parsing succeeded.
     ex.setHttpStatusCode(400);
-    callback_->onError(stream, ex, true);
+    this->callback_->onError(stream, ex, true);
     return;
   }
 
-  callback_->onHeadersComplete(stream, std::move(msg));
+  BaseFilter::onHeadersComplete(stream, std::move(msg));
 }
 
-void HTTPChecks::generateHeader(folly::IOBufQueue& writeBuf,
-                                StreamID stream,
-                                const HTTPMessage& msg,
-                                bool eom,
-                                HTTPHeaderSize* sizeOut) {
+template <class BaseFilter>
+void HTTPChecksFilter<BaseFilter>::generateHeader(folly::IOBufQueue& writeBuf,
+                                                  HTTPCodec::StreamID stream,
+                                                  const HTTPMessage& msg,
+                                                  bool eom,
+                                                  HTTPHeaderSize* sizeOut) {
   if (msg.isRequest() && RFC2616::bodyImplied(msg.getHeaders())) {
     CHECK(RFC2616::isRequestBodyAllowed(msg.getMethod()) !=
           RFC2616::BodyAllowed::NOT_ALLOWED);
@@ -44,7 +48,11 @@ void HTTPChecks::generateHeader(folly::IOBufQueue& writeBuf,
     // requests here too.
   }
 
-  call_->generateHeader(writeBuf, stream, msg, eom, sizeOut);
+  BaseFilter::generateHeader(writeBuf, stream, msg, eom, sizeOut);
 }
 
+// The filter stacks sessions actually build
+template class HTTPChecksFilter<PassThroughHTTPCodecFilter>;
+template class HTTPChecksFilter<FlowControlFilter>;
+
 }
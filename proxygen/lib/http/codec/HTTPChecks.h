@@ -13,26 +13,42 @@
 
 namespace proxygen {
 
+class FlowControlFilter;
+
 /**
  * This class enforces certain higher-level HTTP semantics. It does not enforce
  * conditions that require state to decide. That is, this class is stateless and
  * only examines the calls and callbacks that go through it.
+ *
+ * It is templatized on the filter it composes over so the checks can be
+ * fused into another filter at compile time instead of occupying their own
+ * node in the chain. Each chain node costs a virtual hop on every call and
+ * callback that passes through it -- including per-frame ones like onBody --
+ * so sessions that always install the checks next to another filter (e.g.
+ * the flow control filter) should instantiate the fused type rather than
+ * stacking two nodes. The composed-over filter's methods are invoked
+ * non-virtually.
  */
-
-class HTTPChecks: public PassThroughHTTPCodecFilter {
+template <class BaseFilter>
+class HTTPChecksFilter : public BaseFilter {
  public:
+  using BaseFilter::BaseFilter;
+
   // HTTPCodec::Callback methods
 
-  void onHeadersComplete(StreamID stream,
+  void onHeadersComplete(HTTPCodec::StreamID stream,
                          std::unique_ptr<HTTPMessage> msg) override;
 
   // HTTPCodec methods
 
   void generateHeader(folly::IOBufQueue& writeBuf,
-                      StreamID stream,
+                      HTTPCodec::StreamID stream,
                       const HTTPMessage& msg,
                       bool eom,
                       HTTPHeaderSize* sizeOut) override;
 };
 
+// The standalone variant, for chains with no adjacent filter to fuse into
+using HTTPChecks = HTTPChecksFilter<PassThroughHTTPCodecFilter>;
+
 }
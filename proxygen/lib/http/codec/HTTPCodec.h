@@ -499,6 +499,26 @@ class HTTPCodec {
                               bool eom = false,
                               HTTPHeaderSize* size = nullptr) = 0;
 
+  /**
+   * Write an already-prepared header list for the given transaction in one
+   * batch, bypassing the HTTPMessage walk in generateHeader().  The list
+   * must be complete and ordered, including any pseudo-headers the protocol
+   * requires (see CodecUtil::prepareMessageForCompression).  Codecs with a
+   * batch-compressing encoder (HTTP/2 HPACK, HQ QPACK) hand the whole list
+   * to the encoder in a single call so it can pre-size its output buffer.
+   *
+   * Returns true if the codec wrote the headers; the default implementation
+   * does nothing and returns false, and the caller should fall back to
+   * generateHeader().
+   */
+  virtual bool generateHeaders(folly::IOBufQueue& /*writeBuf*/,
+                               StreamID /*stream*/,
+                               std::vector<compress::Header>& /*headers*/,
+                               bool /*eom*/,
+                               HTTPHeaderSize* /*size*/ = nullptr) {
+    return false;
+  }
+
   virtual void generatePushPromise(folly::IOBufQueue& /* writeBuf */,
                                    StreamID /* stream */,
                                    const HTTPMessage& /* msg */,
@@ -668,6 +688,18 @@ class HTTPCodec {
     return nullptr;
   }
 
+  /**
+   * Optimistically apply a peer settings list remembered from a previous
+   * connection to the same endpoint, before the real SETTINGS frame
+   * arrives.  No onSettings callback is delivered and no ACK is
+   * generated; the peer's actual SETTINGS later overwrite the hint
+   * through the normal path.  Returns false if the codec does not
+   * support hints or rejected the list.
+   */
+  virtual bool applyIngressSettingsHint(const SettingsList& /* settings */) {
+    return false;
+  }
+
   /**
    * This enables HTTP/2 style behavior during graceful shutdown that allows
    * 2 GOAWAYs to be sent during shutdown.
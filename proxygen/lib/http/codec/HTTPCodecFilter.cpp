@@ -369,6 +369,11 @@ const HTTPSettings* PassThroughHTTPCodecFilter::getIngressSettings() const {
   return call_->getIngressSettings();
 }
 
+bool PassThroughHTTPCodecFilter::applyIngressSettingsHint(
+    const SettingsList& settings) {
+  return call_->applyIngressSettingsHint(settings);
+}
+
 void PassThroughHTTPCodecFilter::enableDoubleGoawayDrain() {
   return call_->enableDoubleGoawayDrain();
 }
@@ -231,6 +231,8 @@ class PassThroughHTTPCodecFilter: public HTTPCodecFilter {
 
   const HTTPSettings* getIngressSettings() const override;
 
+  bool applyIngressSettingsHint(const SettingsList& settings) override;
+
   void setHeaderCodecStats(HeaderCodec::Stats* stats) override;
 
   void enableDoubleGoawayDrain() override;
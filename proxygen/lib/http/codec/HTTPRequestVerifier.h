@@ -34,7 +34,7 @@ class HTTPRequestVerifier {
       error = "Duplicate method";
       return false;
     }
-    if (!CodecUtil::validateMethod(method)) {
+    if (validate_ && !CodecUtil::validateMethod(method)) {
       error = "Invalid method";
       return false;
     }
@@ -49,13 +49,15 @@ class HTTPRequestVerifier {
       error = "Duplicate path";
       return false;
     }
-    if (!CodecUtil::validateURL(path)) {
+    if (validate_ && !CodecUtil::validateURL(path)) {
       error = "Invalid url";
       return false;
     }
     hasPath_ = true;
     assert(msg_ != nullptr);
-    msg_->setURL(path.str());
+    // Defer URL decomposition; most routed requests never look past the
+    // raw URL and the path/query split happens on first access
+    msg_->setURLLazy(path.str());
     return true;
   }
 
@@ -65,7 +67,7 @@ class HTTPRequestVerifier {
       return false;
     }
     // This just checks for alpha chars
-    if (!CodecUtil::validateMethod(scheme)) {
+    if (validate_ && !CodecUtil::validateMethod(scheme)) {
       error = "Invalid scheme";
       return false;
     }
@@ -83,7 +85,8 @@ class HTTPRequestVerifier {
       error = "Duplicate authority";
       return false;
     }
-    if (!CodecUtil::validateHeaderValue(authority, CodecUtil::STRICT)) {
+    if (validate_ &&
+        !CodecUtil::validateHeaderValue(authority, CodecUtil::STRICT)) {
       error = "Invalid authority";
       return false;
     }
@@ -147,6 +150,17 @@ class HTTPRequestVerifier {
     hasUpgradeProtocol_ = val;
   }
 
+  /**
+   * Disables the per-byte method/URL/authority scans for ingress from
+   * peers the listener already trusts (see
+   * AcceptorConfiguration::trustedIngress).  Structural checks
+   * (duplicate pseudo-headers, malformed CONNECT) stay on.  Sticky
+   * across reset().
+   */
+  void setValidate(bool validate) {
+    validate_ = validate;
+  }
+
   bool hasUpgradeProtocol() {
     return hasUpgradeProtocol_;
   }
@@ -160,6 +174,7 @@ class HTTPRequestVerifier {
   bool hasScheme_{false};
   bool hasAuthority_{false};
   bool hasUpgradeProtocol_{false};
+  bool validate_{true};
 };
 
 } // proxygen
@@ -19,14 +19,25 @@ void HTTPSettings::setSetting(SettingsId id, SettingsValue val) {
     (*iter).value = val;
   } else {
     settings_.emplace_back(id, val);
+    if (isIndexed(id)) {
+      index_[static_cast<uint64_t>(id)] = settings_.size();
+    }
   }
 }
 
 void HTTPSettings::unsetSetting(SettingsId id) {
   auto iter = getSettingIter(id);
   if (iter != settings_.end()) {
+    if (isIndexed(id)) {
+      index_[static_cast<uint64_t>(id)] = 0;
+    }
     *iter = settings_.back();
     settings_.pop_back();
+    if (iter != settings_.end() && isIndexed(iter->id)) {
+      // The back entry moved into the vacated slot; fix up its index
+      index_[static_cast<uint64_t>(iter->id)] =
+          (iter - settings_.begin()) + 1;
+    }
   }
 }
 
@@ -50,6 +61,10 @@ SettingsValue HTTPSettings::getSetting(SettingsId id,
 }
 
 std::vector<HTTPSetting>::iterator HTTPSettings::getSettingIter(SettingsId id) {
+  if (isIndexed(id)) {
+    auto pos = index_[static_cast<uint64_t>(id)];
+    return pos ? settings_.begin() + (pos - 1) : settings_.end();
+  }
   return std::find_if(settings_.begin(),
                       settings_.end(),
                       [&](HTTPSetting const& s) { return s.id == id; });
@@ -57,6 +72,10 @@ std::vector<HTTPSetting>::iterator HTTPSettings::getSettingIter(SettingsId id) {
 
 std::vector<HTTPSetting>::const_iterator HTTPSettings::getSettingConstIter(
     SettingsId id) const {
+  if (isIndexed(id)) {
+    auto pos = index_[static_cast<uint64_t>(id)];
+    return pos ? settings_.begin() + (pos - 1) : settings_.end();
+  }
   return std::find_if(settings_.begin(),
                       settings_.end(),
                       [&](HTTPSetting const& s) { return s.id == id; });
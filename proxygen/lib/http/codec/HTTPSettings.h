@@ -9,15 +9,18 @@
  */
 #pragma once
 
+#include <array>
 #include <initializer_list>
 #include <proxygen/lib/http/codec/SettingsId.h>
 #include <vector>
 
 /*
  * HTTPSettings are stored in an underlying vector, presumably to limit the
- * amount of memory required.  Access various settings thus generally involves
- * iterating over available entries.  Removing entries does not require any
- * shifts.
+ * amount of memory required.  Removing entries does not require any shifts.
+ * Lookups of the standard settings ids (1..8) go through a small positional
+ * index and cost O(1); only non-standard ids fall back to scanning the
+ * vector.  This matters because codecs consult settings like MAX_FRAME_SIZE
+ * on the per-frame path.
  */
 
 namespace proxygen {
@@ -36,16 +39,15 @@ class HTTPSettings {
  public:
   // HTTP/2 Defaults
   HTTPSettings()
-      : settings_({{SettingsId::HEADER_TABLE_SIZE, 4096},
-                   {SettingsId::ENABLE_PUSH, 1},
-                   {SettingsId::MAX_FRAME_SIZE, 16384}}) {
+      : HTTPSettings({{SettingsId::HEADER_TABLE_SIZE, 4096},
+                      {SettingsId::ENABLE_PUSH, 1},
+                      {SettingsId::MAX_FRAME_SIZE, 16384}}) {
   }
   explicit HTTPSettings(
       const std::initializer_list<SettingPair>& initialSettings) {
     settings_.reserve(initialSettings.size());
-    // TODO: setSetting involves looping over all settings so the below actually
-    // models as O(n^2) which is pretty bad.  Can't change it outright without
-    // making sure we handle duplicates (same setting id)
+    // setSetting dedupes repeated ids; standard ids resolve through the
+    // index so this is only O(n^2) for lists of non-standard ids
     for (auto& setting : initialSettings) {
       setSetting(setting.first, setting.second);
     }
@@ -63,9 +65,17 @@ class HTTPSettings {
   }
   void clearSettings() {
     settings_.clear();
+    index_.fill(0);
   }
 
  private:
+  // The standard HTTP/2 settings ids get direct-indexed slots
+  static constexpr uint64_t kMaxIndexedSettingId = 8;
+
+  static bool isIndexed(SettingsId id) {
+    return static_cast<uint64_t>(id) <= kMaxIndexedSettingId;
+  }
+
   // Returns the specified type of iterator to the setting associated with the
   // specified id
   std::vector<HTTPSetting>::iterator getSettingIter(SettingsId id);
@@ -76,6 +86,9 @@ class HTTPSettings {
   // all settings so that size == capacity (else on push_backs capacity is
   // likely to be > size)
   std::vector<HTTPSetting> settings_;
+  // Position + 1 of each standard id in settings_; 0 means absent.  Slot 0
+  // is unused since there is no setting id 0.
+  std::array<uint32_t, kMaxIndexedSettingId + 1> index_{{}};
 };
 
 using SettingsList = std::vector<HTTPSetting>;
@@ -27,7 +27,28 @@ bool HeaderDecodeInfo::onHeader(const HPACKHeaderName& name,
   folly::StringPiece nameSp(name.get());
   folly::StringPiece valueSp(value);
 
-  if (nameSp.startsWith(':')) {
+  // Almost all ingress headers decode to a common header code, which
+  // already tells us whether this is a pseudo header and that the name is
+  // a valid token.  Dispatch on the code and save the string probe and the
+  // name scan for the HTTP_HEADER_OTHER fallback.
+  bool isPseudo = false;
+  switch (headerCode) {
+    case HTTP_HEADER_COLON_METHOD:
+    case HTTP_HEADER_COLON_SCHEME:
+    case HTTP_HEADER_COLON_AUTHORITY:
+    case HTTP_HEADER_COLON_PATH:
+    case HTTP_HEADER_COLON_PROTOCOL:
+    case HTTP_HEADER_COLON_STATUS:
+      isPseudo = true;
+      break;
+    case HTTP_HEADER_OTHER:
+      isPseudo = nameSp.startsWith(':');
+      break;
+    default:
+      break;
+  }
+
+  if (isPseudo) {
     pseudoHeaderSeen_ = true;
     if (regularHeaderSeen_) {
       parsingError = folly::to<string>("Illegal pseudo header name=", nameSp);
@@ -95,10 +116,13 @@ bool HeaderDecodeInfo::onHeader(const HPACKHeaderName& name,
         return false;
       }
       contentLength_ = cl;
+    } else if (headerCode == HTTP_HEADER_COOKIE) {
+      cookieHeaderCount_++;
     }
-    bool nameOk = headerCode != HTTP_HEADER_OTHER ||
+    bool nameOk = !validate_ || headerCode != HTTP_HEADER_OTHER ||
       CodecUtil::validateHeaderName(nameSp);
-    bool valueOk = CodecUtil::validateHeaderValue(valueSp, CodecUtil::STRICT);
+    bool valueOk = !validate_ ||
+      CodecUtil::validateHeaderValue(valueSp, CodecUtil::STRICT);
     if (!nameOk || !valueOk) {
       parsingError = folly::to<string>("Bad header value: name=",
                                        nameSp, " value=", valueSp);
@@ -118,9 +142,13 @@ void HeaderDecodeInfo::onHeadersComplete(HTTPHeaderSize decodedSize) {
   HTTPHeaders& headers = msg->getHeaders();
 
   if (isRequest_ && !isRequestTrailers_) {
-    auto combinedCookie = headers.combine(HTTP_HEADER_COOKIE, "; ");
-    if (!combinedCookie.empty()) {
-      headers.set(HTTP_HEADER_COOKIE, combinedCookie);
+    // Only scan for cookie crumbs if the block actually carried more than
+    // one cookie header; a single cookie is already in its final form
+    if (cookieHeaderCount_ > 1) {
+      auto combinedCookie = headers.combine(HTTP_HEADER_COOKIE, "; ");
+      if (!combinedCookie.empty()) {
+        headers.set(HTTP_HEADER_COOKIE, combinedCookie);
+      }
     }
     if (!verifier.validate()) {
       parsingError = verifier.error;
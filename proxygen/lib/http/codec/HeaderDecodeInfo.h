@@ -21,18 +21,55 @@ class HeaderDecodeInfo {
  public:
   void init(bool isRequestIn, bool isRequestTrailers) {
     CHECK(!msg);
-    msg.reset(new HTTPMessage());
+    // The direction is known here, so construct the typed message and
+    // skip the lazy direction decision on the first header
+    if (spareMsg_ && spareMsg_->isRequest() == isRequestIn) {
+      // Reset the recycled message in place instead of reallocating
+      if (isRequestIn) {
+        *spareMsg_ = HTTPRequestMessage();
+      } else {
+        *spareMsg_ = HTTPResponseMessage();
+      }
+      msg = std::move(spareMsg_);
+    } else if (isRequestIn) {
+      msg = std::make_unique<HTTPRequestMessage>();
+    } else {
+      msg = std::make_unique<HTTPResponseMessage>();
+    }
     isRequest_ = isRequestIn;
     isRequestTrailers_ = isRequestTrailers;
     hasStatus_ = false;
     contentLength_ = folly::none;
     regularHeaderSeen_ = false;
     pseudoHeaderSeen_ = false;
+    cookieHeaderCount_ = 0;
     parsingError = "";
     decodeError = HPACK::DecodeError::NONE;
     verifier.reset(msg.get());
   }
 
+  /**
+   * Hand back a message the codec decoded but will not deliver (e.g. a
+   * trailer block harvested into bare HTTPHeaders).  The next init()
+   * of the same direction resets it in place, so steady-state parsing
+   * of trailer-heavy traffic reuses one warm allocation per codec.
+   */
+  void recycleMessage(std::unique_ptr<HTTPMessage> m) {
+    spareMsg_ = std::move(m);
+  }
+
+  /**
+   * Disables the per-byte header name/value scans (and the verifier's
+   * method/URL scans) for ingress the listener already trusts.
+   * Semantic checks -- duplicate pseudo-headers, Connection in h2,
+   * conflicting content-lengths -- are stateful and stay on.  Sticky
+   * across init().
+   */
+  void setValidate(bool validate) {
+    validate_ = validate;
+    verifier.setValidate(validate);
+  }
+
   bool onHeader(const HPACKHeaderName& name, const folly::fbstring& value);
 
   void onHeadersComplete(HTTPHeaderSize decodedSize);
@@ -52,7 +89,10 @@ class HeaderDecodeInfo {
   bool hasStatus_{false};
   bool regularHeaderSeen_{false};
   bool pseudoHeaderSeen_{false};
+  uint32_t cookieHeaderCount_{0};
+  bool validate_{true};
   folly::Optional<uint32_t> contentLength_;
+  std::unique_ptr<HTTPMessage> spareMsg_;
 };
 
 }
@@ -562,7 +562,8 @@ unique_ptr<IOBuf> SPDYCodec::serializeResponseHeaders(
   string status;
 
   const HTTPHeaders& headers = msg.getHeaders();
-  vector<Header> allHeaders;
+  vector<Header>& allHeaders = egressScratchHeaders_;
+  allHeaders.clear();
   allHeaders.reserve(headers.size() + 4);
 
   if (msg.getStatusMessage().empty()) {
@@ -589,7 +590,8 @@ unique_ptr<IOBuf> SPDYCodec::serializeRequestHeaders(
   HTTPHeaderSize* size) {
 
   const HTTPHeaders& headers = msg.getHeaders();
-  vector<Header> allHeaders;
+  vector<Header>& allHeaders = egressScratchHeaders_;
+  allHeaders.clear();
   allHeaders.reserve(headers.size() + 6);
 
   const string& method = msg.getMethodString();
@@ -1057,7 +1059,14 @@ unique_ptr<HTTPMessage>
 SPDYCodec::parseHeaders(TransportDirection direction, StreamID streamID,
                         StreamID assocStreamID,
                         const HeaderPieceList& inHeaders) {
-  unique_ptr<HTTPMessage> msg(new HTTPMessage());
+  // Everything parsed here is a request except a SYN_REPLY arriving
+  // upstream; pushed streams carry an assocStreamID and are requests
+  unique_ptr<HTTPMessage> msg;
+  if (direction == TransportDirection::DOWNSTREAM || assocStreamID) {
+    msg = std::make_unique<HTTPRequestMessage>();
+  } else {
+    msg = std::make_unique<HTTPResponseMessage>();
+  }
   HTTPHeaders& headers = msg->getHeaders();
   bool newStream = (type_ != spdy::HEADERS);
 
@@ -375,6 +375,10 @@ public:
   bool ctrl_:1;
 
   GzipHeaderCodec headerCodec_;
+
+  // Scratch space for serialize{Request,Response}Headers; cleared per
+  // message so steady-state egress reuses the warm capacity
+  std::vector<compress::Header> egressScratchHeaders_;
 };
 
 } // proxygen
@@ -35,6 +35,10 @@ enum class SettingsId : uint64_t {
   ENABLE_EX_HEADERS = 0xfbfb,
   THRIFT_CHANNEL_ID = 0xf100,
 
+  // Fingerprint of a pre-agreed HPACK seed dictionary the sender can
+  // decode (see SeedHeaderDictionary); 0 means none
+  HEADER_SEED_DICTIONARY = 0xf0d0,
+
   // For secondary authentication in HTTP/2
   SETTINGS_HTTP_CERT_AUTH = 0xff00,
 
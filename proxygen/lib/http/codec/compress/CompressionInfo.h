@@ -25,6 +25,14 @@ struct CompressionInfoPart {
   uint32_t duplications_{0};
   uint32_t staticRefs_{0};
 
+  // Decoder-side head-of-line blocking (QPACK only): header blocks that
+  // had to queue behind missing encoder stream inserts, and how long
+  // they waited before becoming decodable.  Set after construction by
+  // the codec since only the QPACK decoder tracks them.
+  uint64_t holBlockCount_{0};
+  uint64_t holBlockDelayUs_{0};
+  uint64_t maxHolBlockDelayUs_{0};
+
   CompressionInfoPart(uint32_t headerTableSize,
                       uint32_t bytesStored,
                       uint32_t headersStored,
@@ -52,6 +60,9 @@ struct CompressionInfoPart {
     blockedInserts_ = other.blockedInserts_;
     duplications_ = other.duplications_;
     staticRefs_ = other.staticRefs_;
+    holBlockCount_ = other.holBlockCount_;
+    holBlockDelayUs_ = other.holBlockDelayUs_;
+    maxHolBlockDelayUs_ = other.maxHolBlockDelayUs_;
     return *this;
   }
 };
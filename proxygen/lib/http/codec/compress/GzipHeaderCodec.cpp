@@ -17,6 +17,7 @@
 #include <proxygen/lib/http/codec/SPDYCodec.h>
 #include <proxygen/lib/http/codec/SPDYConstants.h>
 #include <proxygen/lib/utils/Logging.h>
+#include <proxygen/lib/utils/WorkerBufferPool.h>
 #include <string>
 
 using folly::IOBuf;
@@ -255,16 +256,23 @@ unique_ptr<IOBuf> GzipHeaderCodec::encode(vector<Header>& headers) noexcept {
   dst = uncompressed.writableData();
   versionSettings_.appendSizeFun(dst, numHeaders);
 
-  // Allocate a contiguous space big enough to hold the compressed headers,
-  // plus any headroom requested by the caller.
+  // Grab a contiguous space big enough to hold the compressed headers,
+  // plus any headroom requested by the caller.  Nearly every header block
+  // fits in a pooled worker block, sparing a malloc per message; oversized
+  // blocks fall back to a dedicated allocation.
   size_t maxDeflatedSize = deflateBound(&deflater_, uncompressedLen);
-  unique_ptr<IOBuf> out(IOBuf::create(maxDeflatedSize + encodeHeadroom_));
+  unique_ptr<IOBuf> out;
+  if (maxDeflatedSize + encodeHeadroom_ <= WorkerBufferPool::kBlockSize) {
+    out = WorkerBufferPool::get()->allocate();
+  } else {
+    out = IOBuf::create(maxDeflatedSize + encodeHeadroom_);
+  }
   out->advance(encodeHeadroom_);
 
   // Compress
   deflater_.next_in = uncompressed.writableData();
   deflater_.avail_in = uncompressedLen;
-  deflater_.next_out = out->writableData();
+  deflater_.next_out = out->writableTail();
   deflater_.avail_out = maxDeflatedSize;
   int r = deflate(&deflater_, Z_SYNC_FLUSH);
   CHECK_EQ(r, Z_OK);
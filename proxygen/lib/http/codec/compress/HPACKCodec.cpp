@@ -35,6 +35,7 @@ uint32_t prepareHeaders(const vector<Header>& headers,
     // HPACKHeader automatically lowercases
     converted.emplace_back(*h.name, *h.value);
     auto& header = converted.back();
+    header.neverIndex = h.neverIndex;
     uncompressed += header.name.size() + header.value.size() + 2;
   }
   return uncompressed;
@@ -54,6 +55,16 @@ unique_ptr<IOBuf> HPACKCodec::encode(vector<Header>& headers) noexcept {
   return buf;
 }
 
+unique_ptr<IOBuf> HPACKCodec::encodeStaticOnly(
+    vector<Header>& headers) noexcept {
+  folly::ThreadLocal<std::vector<HPACKHeader>> preparedTL;
+  auto& prepared = *preparedTL.get();
+  encodedSize_.uncompressed = compress::prepareHeaders(headers, prepared);
+  auto buf = encoder_.encodeStaticOnly(prepared, encodeHeadroom_);
+  recordCompressedSize(buf.get());
+  return buf;
+}
+
 void HPACKCodec::recordCompressedSize(
   const IOBuf* stream) {
   encodedSize_.compressed = 0;
@@ -75,6 +86,16 @@ void HPACKCodec::decodeStreaming(
   decoder_.decodeStreaming(cursor, length, streamingCb);
 }
 
+uint32_t HPACKCodec::decodeStreamingFragment(
+    Cursor& cursor,
+    uint32_t length,
+    bool endOfBlock,
+    HPACK::StreamingCallback* streamingCb) noexcept {
+  streamingCb->stats = stats_;
+  return decoder_.decodeStreamingFragment(
+      cursor, length, endOfBlock, streamingCb);
+}
+
 void HPACKCodec::describe(std::ostream& stream) const {
   stream << "DecoderTable:\n" << decoder_;
   stream << "EncoderTable:\n" << encoder_;
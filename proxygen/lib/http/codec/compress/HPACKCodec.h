@@ -47,10 +47,29 @@ class HPACKCodec : public HeaderCodec {
   std::unique_ptr<folly::IOBuf> encode(
       std::vector<compress::Header>& headers) noexcept;
 
+  /**
+   * Encode a block free of connection compression state (static table
+   * references and non-indexing literals only), suitable for caching
+   * and replaying on other sessions.  See HPACKEncoder::encodeStaticOnly.
+   */
+  std::unique_ptr<folly::IOBuf> encodeStaticOnly(
+      std::vector<compress::Header>& headers) noexcept;
+
   void decodeStreaming(folly::io::Cursor& cursor,
                        uint32_t length,
                        HPACK::StreamingCallback* streamingCb) noexcept;
 
+  /**
+   * Incrementally decode one fragment of a header block; returns the
+   * number of bytes consumed so the caller only retains the unconsumed
+   * tail.  See HPACKDecoder::decodeStreamingFragment.
+   */
+  uint32_t decodeStreamingFragment(folly::io::Cursor& cursor,
+                                   uint32_t length,
+                                   bool endOfBlock,
+                                   HPACK::StreamingCallback* streamingCb)
+      noexcept;
+
   void setEncoderHeaderTableSize(uint32_t size) {
     encoder_.setHeaderTableSize(size);
   }
@@ -79,6 +98,21 @@ class HPACKCodec : public HeaderCodec {
                            0, 0, decoder_.getStaticRefs());
   }
 
+  /**
+   * The decoder side is armed as soon as we advertise the dictionary;
+   * the encoder side only once the peer's SETTINGS confirm it holds the
+   * same artifact (see HTTP2Codec::setSeedHeaderDictionary).
+   */
+  void setEncoderSeedDictionary(
+      std::shared_ptr<const SeedHeaderDictionary> dict) {
+    encoder_.setSeedDictionary(std::move(dict));
+  }
+
+  void setDecoderSeedDictionary(
+      std::shared_ptr<const SeedHeaderDictionary> dict) {
+    decoder_.setSeedDictionary(std::move(dict));
+  }
+
   void setHeaderIndexingStrategy(const HeaderIndexingStrategy* indexingStrat) {
     encoder_.setHeaderIndexingStrategy(indexingStrat);
   }
@@ -52,6 +52,10 @@ const Instruction Q_INDEXED_POST          { 0x10, 4 };
 const Instruction Q_LITERAL_NAME_REF      { 0x40, 4 };
 const Instruction Q_LITERAL_NAME_REF_POST { 0x00, 3 };
 const Instruction Q_LITERAL               { 0x20, 3 };
+// Same literal instructions with the N (never index) bit set; used for
+// pass-through metadata headers that intermediaries must not re-index
+const Instruction Q_LITERAL_NAME_REF_NEVER { 0x60, 4 };
+const Instruction Q_LITERAL_NEVER          { 0x30, 3 };
 
 const uint8_t Q_INDEXED_STATIC = 0x40;
 const uint8_t Q_INSERT_NAME_REF_STATIC = 0x40;
@@ -44,9 +44,17 @@ uint32_t HPACKContext::getIndex(const HPACKHeader& header) const {
   uint32_t dynamicIndex = table_.getIndex(header);
   if (dynamicIndex) {
     return dynamicToGlobalIndex(dynamicIndex);
-  } else {
-    return dynamicIndex;
   }
+
+  // Last, a negotiated seed dictionary; its indexes are the largest
+  // integers of the three tables, so dynamic hits stay preferred
+  if (seedDict_) {
+    uint32_t seedIndex = seedDict_->getIndex(header);
+    if (seedIndex) {
+      return kSeedIndexBase + seedIndex;
+    }
+  }
+  return 0;
 }
 
 uint32_t HPACKContext::nameIndex(const HPACKHeaderName& headerName) const {
@@ -59,6 +67,12 @@ uint32_t HPACKContext::nameIndex(const HPACKHeaderName& headerName) const {
   if (index) {
     return dynamicToGlobalIndex(index);
   }
+  if (seedDict_) {
+    index = seedDict_->nameIndex(headerName);
+    if (index) {
+      return kSeedIndexBase + index;
+    }
+  }
   return 0;
 }
 
@@ -67,6 +81,10 @@ bool HPACKContext::isStatic(uint32_t index) const {
 }
 
 const HPACKHeader& HPACKContext::getHeader(uint32_t index) {
+  if (isSeed(index)) {
+    staticRefs_++;
+    return seedDict_->getHeader(index - kSeedIndexBase);
+  }
   if (isStatic(index)) {
     staticRefs_++;
     return getStaticTable().getHeader(globalToStaticIndex(index));
@@ -11,6 +11,7 @@
 
 #include <proxygen/lib/http/codec/compress/HPACKConstants.h>
 #include <proxygen/lib/http/codec/compress/HeaderTable.h>
+#include <proxygen/lib/http/codec/compress/SeedHeaderDictionary.h>
 #include <proxygen/lib/http/codec/compress/StaticHeaderTable.h>
 
 namespace proxygen {
@@ -64,6 +65,22 @@ class HPACKContext {
 
   void seedHeaderTable(std::vector<HPACKHeader>& headers);
 
+  /**
+   * Install a negotiated seed dictionary (see SeedHeaderDictionary).
+   * Its entries are addressed at kSeedIndexBase + their dictionary
+   * index, a range no RFC static or dynamic index can reach, so this
+   * can be flipped on mid-connection - e.g. when the peer's SETTINGS
+   * arrive after we already encoded header blocks - without re-mapping
+   * any index either side has emitted.
+   */
+  void setSeedDictionary(std::shared_ptr<const SeedHeaderDictionary> dict) {
+    seedDict_ = std::move(dict);
+  }
+
+  // A dynamic index this high would need a multi-megabyte table; see
+  // setSeedDictionary
+  static constexpr uint32_t kSeedIndexBase = 1u << 16;
+
   void describe(std::ostream& os) const;
 
   uint32_t getStaticRefs() const {
@@ -92,7 +109,12 @@ class HPACKContext {
     return index;
   }
 
+  bool isSeed(uint32_t index) const {
+    return seedDict_ && index > kSeedIndexBase;
+  }
+
   HeaderTable table_;
+  std::shared_ptr<const SeedHeaderDictionary> seedDict_;
   mutable uint32_t staticRefs_{0};
 };
 
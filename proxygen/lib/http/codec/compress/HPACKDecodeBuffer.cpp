@@ -9,6 +9,8 @@
  */
 #include <proxygen/lib/http/codec/compress/HPACKDecodeBuffer.h>
 
+#include <algorithm>
+#include <cstring>
 #include <limits>
 #include <memory>
 #include <proxygen/lib/http/codec/compress/Huffman.h>
@@ -17,6 +19,19 @@ using folly::IOBuf;
 using std::unique_ptr;
 using proxygen::HPACK::DecodeError;
 
+namespace {
+
+/**
+ * Upper bound on the decoded length of a Huffman-encoded literal.  The
+ * shortest code in the HPACK Huffman table is 5 bits, so size encoded
+ * bytes expand to at most floor(size * 8 / 5) characters.
+ */
+uint64_t maxHuffmanDecodedSize(uint64_t size) {
+  return size * 8 / 5;
+}
+
+} // namespace
+
 namespace proxygen {
 
 void HPACKDecodeBuffer::EOB_LOG(std::string msg, DecodeError code) const {
@@ -80,26 +95,125 @@ DecodeError HPACKDecodeBuffer::decodeLiteral(uint8_t nbit,
     LOG(ERROR) << "Literal too large, size=" << size;
     return DecodeError::LITERAL_TOO_LARGE;
   }
-  const uint8_t* data;
-  unique_ptr<IOBuf> tmpbuf;
-  // handle the case where the buffer spans multiple buffers
+  static auto& huffmanTree = huffman::huffTree();
+  // one exact reservation up front instead of growing as the decode
+  // emits; maxHuffmanDecodedSize is a tight upper bound on the expansion
+  literal.reserve(huffman ? maxHuffmanDecodedSize(size) : size);
   if (cursor_.length() >= size) {
-    data = cursor_.data();
+    // the common case: the literal is contiguous in the current buffer
+    if (huffman) {
+      huffmanTree.decode(cursor_.data(), size, literal);
+    } else {
+      literal.append((const char*)cursor_.data(), size);
+    }
     cursor_.skip(size);
   } else {
-    // temporary buffer to pull the chunks together
-    tmpbuf = IOBuf::create(size);
-    // pull() will move the cursor
-    cursor_.pull(tmpbuf->writableData(), size);
-    data = tmpbuf->data();
+    // the literal spans buffers of the chain; feed the decoder chunk by
+    // chunk instead of pulling the bytes into a temporary contiguous copy
+    uint32_t state = 0;
+    bool ok = true;
+    uint32_t remaining = size;
+    while (remaining > 0) {
+      auto chunk = cursor_.peekBytes();
+      if (chunk.empty()) {
+        EOB_LOG("ran out of buffers mid-literal");
+        return DecodeError::BUFFER_UNDERFLOW;
+      }
+      uint32_t len = std::min<uint64_t>(remaining, chunk.size());
+      if (huffman) {
+        // on an invalid stream stop emitting, but keep consuming the
+        // declared length, same as a failed contiguous decode
+        if (ok) {
+          ok = huffmanTree.decodeChunk(state, chunk.data(), len, literal);
+        }
+      } else {
+        literal.append((const char*)chunk.data(), len);
+      }
+      cursor_.skip(len);
+      remaining -= len;
+    }
+  }
+  remainingBytes_ -= size;
+  return DecodeError::NONE;
+}
+
+DecodeError HPACKDecodeBuffer::decodeLiteral(folly::StringPiece& literal) {
+  return decodeLiteral(7, literal);
+}
+
+DecodeError HPACKDecodeBuffer::decodeLiteral(uint8_t nbit,
+                                             folly::StringPiece& literal) {
+  DCHECK(arena_) << "decodeLiteral(StringPiece) requires a scratch arena";
+  literal.clear();
+  if (remainingBytes_ == 0) {
+    EOB_LOG("remainingBytes_ == 0");
+    return DecodeError::BUFFER_UNDERFLOW;
+  }
+  auto byte = peek();
+  uint8_t huffmanCheck = uint8_t(1 << nbit);
+  bool huffman = byte & huffmanCheck;
+  uint64_t size;
+  DecodeError result = decodeInteger(nbit, size);
+  if (result != DecodeError::NONE) {
+    EOB_LOG("Could not decode literal size", result);
+    return result;
   }
-  if (huffman) {
-    static auto& huffmanTree = huffman::huffTree();
-    huffmanTree.decode(data, size, literal);
+  if (size > remainingBytes_) {
+    EOB_LOG(folly::to<std::string>(
+                "size(", size, ") > remainingBytes_(", remainingBytes_, ")"));
+    return DecodeError::BUFFER_UNDERFLOW;
+  }
+  if (size > maxLiteralSize_) {
+    LOG(ERROR) << "Literal too large, size=" << size;
+    return DecodeError::LITERAL_TOO_LARGE;
+  }
+  static auto& huffmanTree = huffman::huffTree();
+  // a single exact allocation; over-reserving by the decode bound costs
+  // only bump-pointer space reclaimed with everything else in the arena
+  char* out = static_cast<char*>(
+      arena_->allocate(huffman ? maxHuffmanDecodedSize(size) : size));
+  huffman::HuffTree::RawSink sink(out);
+  if (cursor_.length() >= size) {
+    // the common case: the literal is contiguous in the current buffer
+    if (huffman) {
+      uint32_t state = 0;
+      if (huffmanTree.decodeChunkSink(state, cursor_.data(), size, sink)) {
+        huffmanTree.decodeFinish(state);
+      }
+    } else {
+      memcpy(out, cursor_.data(), size);
+      sink.tail += size;
+    }
+    cursor_.skip(size);
   } else {
-    literal.append((const char *)data, size);
+    // the literal spans buffers of the chain; feed the decoder chunk by
+    // chunk instead of pulling the bytes into a temporary contiguous copy
+    uint32_t state = 0;
+    bool ok = true;
+    uint32_t remaining = size;
+    while (remaining > 0) {
+      auto chunk = cursor_.peekBytes();
+      if (chunk.empty()) {
+        EOB_LOG("ran out of buffers mid-literal");
+        return DecodeError::BUFFER_UNDERFLOW;
+      }
+      uint32_t len = std::min<uint64_t>(remaining, chunk.size());
+      if (huffman) {
+        // on an invalid stream stop emitting, but keep consuming the
+        // declared length, same as a failed contiguous decode
+        if (ok) {
+          ok = huffmanTree.decodeChunkSink(state, chunk.data(), len, sink);
+        }
+      } else {
+        memcpy(sink.tail, chunk.data(), len);
+        sink.tail += len;
+      }
+      cursor_.skip(len);
+      remaining -= len;
+    }
   }
   remainingBytes_ -= size;
+  literal.reset(out, sink.tail - out);
   return DecodeError::NONE;
 }
 
@@ -15,6 +15,7 @@
 #include <folly/io/IOBuf.h>
 #include <proxygen/lib/http/codec/compress/HPACKConstants.h>
 #include <proxygen/lib/http/codec/compress/Huffman.h>
+#include <proxygen/lib/utils/StringArena.h>
 
 namespace proxygen {
 
@@ -52,6 +53,14 @@ class HPACKDecodeBuffer {
     return cursor_;
   }
 
+  /**
+   * false when the caller is feeding a fragmented block and running dry
+   * mid-field is an expected outcome rather than an error
+   */
+  bool endOfBufferIsError() const {
+    return endOfBufferIsError_;
+  }
+
   /**
    * @returns true if there are no more bytes to decode. Calling this method
    * might move the cursor from the current IOBuf to the next one
@@ -86,6 +95,26 @@ class HPACKDecodeBuffer {
 
   HPACK::DecodeError decodeLiteral(uint8_t nbit, folly::fbstring& literal);
 
+  /**
+   * Provide an arena for the StringPiece decodeLiteral overloads below.
+   * Must outlive every literal decoded into it.
+   */
+  void setScratchArena(StringArena* arena) {
+    arena_ = arena;
+  }
+
+  /**
+   * Decode a literal into the scratch arena instead of an owning string.
+   * The returned piece points at arena storage, so an entire header block
+   * decodes without any individual allocation; setScratchArena() must
+   * have been called first.  Lifetime of the piece is the lifetime of the
+   * arena contents - a match for per-request arenas shared with the
+   * HTTPMessage the headers end up in.
+   */
+  HPACK::DecodeError decodeLiteral(folly::StringPiece& literal);
+
+  HPACK::DecodeError decodeLiteral(uint8_t nbit, folly::StringPiece& literal);
+
 private:
   void EOB_LOG(std::string msg,
                HPACK::DecodeError code=
@@ -96,6 +125,7 @@ private:
   uint32_t remainingBytes_;
   uint32_t maxLiteralSize_{std::numeric_limits<uint32_t>::max()};
   bool endOfBufferIsError_{true};
+  StringArena* arena_{nullptr};
 };
 
 }
@@ -10,15 +10,27 @@
 #include <proxygen/lib/http/codec/compress/HPACKDecoder.h>
 
 #include <proxygen/lib/http/codec/compress/HeaderCodec.h>
+#include <proxygen/lib/utils/CycleProbe.h>
 
 using folly::io::Cursor;
 
+namespace {
+// Underflow on a buffer fed fragment by fragment just means the field
+// continues in the next fragment; only log it as an error otherwise
+bool logAsError(const proxygen::HPACKDecodeBuffer& dbuf,
+                proxygen::HPACK::DecodeError err) {
+  return err != proxygen::HPACK::DecodeError::BUFFER_UNDERFLOW ||
+      dbuf.endOfBufferIsError();
+}
+} // namespace
+
 namespace proxygen {
 
 void HPACKDecoder::decodeStreaming(
     Cursor& cursor,
     uint32_t totalBytes,
     HPACK::StreamingCallback* streamingCb) {
+  PROXYGEN_CYCLE_PROBE(HPACK_DECODE);
   HPACKDecodeBuffer dbuf(cursor, totalBytes, maxUncompressed_);
   uint32_t emittedSize = 0;
 
@@ -38,6 +50,50 @@ void HPACKDecoder::decodeStreaming(
                  compressedSize, emittedSize);
 }
 
+uint32_t HPACKDecoder::decodeStreamingFragment(
+    Cursor& cursor,
+    uint32_t totalBytes,
+    bool endOfBlock,
+    HPACK::StreamingCallback* streamingCb) {
+  PROXYGEN_CYCLE_PROBE(HPACK_DECODE);
+  uint32_t consumed = 0;
+
+  while (!hasError() && consumed < totalBytes) {
+    // Snapshot the cursor so a field cut off by the end of the fragment
+    // can be retried from its first byte once more bytes arrive
+    Cursor fieldCursor(cursor);
+    HPACKDecodeBuffer dbuf(fieldCursor, totalBytes - consumed,
+                           maxUncompressed_, endOfBlock);
+    blockEmitted_ += decodeHeader(dbuf, streamingCb, nullptr);
+    if (!endOfBlock && err_ == HPACK::DecodeError::BUFFER_UNDERFLOW) {
+      // the field continues in the next fragment; leave it unconsumed
+      err_ = HPACK::DecodeError::NONE;
+      break;
+    }
+    if (hasError()) {
+      break;
+    }
+    consumed += dbuf.consumedBytes();
+    cursor = fieldCursor;
+
+    if (blockEmitted_ > maxUncompressed_) {
+      LOG(ERROR) << "exceeded uncompressed size limit of "
+                 << maxUncompressed_ << " bytes";
+      err_ = HPACK::DecodeError::HEADERS_TOO_LARGE;
+      break;
+    }
+    blockEmitted_ += 2;
+  }
+  blockConsumed_ += consumed;
+  if (endOfBlock || hasError()) {
+    completeDecode(HeaderCodec::Type::HPACK, streamingCb, blockConsumed_,
+                   blockConsumed_, blockEmitted_);
+    blockConsumed_ = 0;
+    blockEmitted_ = 0;
+  }
+  return consumed;
+}
+
 uint32_t HPACKDecoder::decodeLiteralHeader(
     HPACKDecodeBuffer& dbuf,
     HPACK::StreamingCallback* streamingCb,
@@ -57,7 +113,8 @@ uint32_t HPACKDecoder::decodeLiteralHeader(
     uint64_t index;
     err_ = dbuf.decodeInteger(length, index);
     if (err_ != HPACK::DecodeError::NONE) {
-      LOG(ERROR) << "Decode error decoding index err_=" << err_;
+      LOG_IF(ERROR, logAsError(dbuf, err_))
+          << "Decode error decoding index err_=" << err_;
       return 0;
     }
     // validate the index
@@ -74,15 +131,17 @@ uint32_t HPACKDecoder::decodeLiteralHeader(
     err_ = dbuf.decodeLiteral(headerName);
     header.name = headerName;
     if (err_ != HPACK::DecodeError::NONE) {
-      LOG(ERROR) << "Error decoding header name err_=" << err_;
+      LOG_IF(ERROR, logAsError(dbuf, err_))
+          << "Error decoding header name err_=" << err_;
       return 0;
     }
   }
   // value
   err_ = dbuf.decodeLiteral(header.value);
   if (err_ != HPACK::DecodeError::NONE) {
-    LOG(ERROR) << "Error decoding header value name=" << header.name
-               << " err_=" << err_;
+    LOG_IF(ERROR, logAsError(dbuf, err_))
+        << "Error decoding header value name=" << header.name
+        << " err_=" << err_;
     return 0;
   }
 
@@ -102,7 +161,8 @@ uint32_t HPACKDecoder::decodeIndexedHeader(
   uint64_t index;
   err_ = dbuf.decodeInteger(HPACK::INDEX_REF.prefixLength, index);
   if (err_ != HPACK::DecodeError::NONE) {
-    LOG(ERROR) << "Decode error decoding index err_=" << err_;
+    LOG_IF(ERROR, logAsError(dbuf, err_))
+        << "Decode error decoding index err_=" << err_;
     return 0;
   }
   // validate the index
@@ -119,6 +179,8 @@ uint32_t HPACKDecoder::decodeIndexedHeader(
 bool HPACKDecoder::isValid(uint32_t index) {
   if (isStatic(index)) {
     return getStaticTable().isValid(globalToStaticIndex(index));
+  } else if (isSeed(index)) {
+    return seedDict_->isValid(index - kSeedIndexBase);
   } else {
     return table_.isValid(globalToDynamicIndex(index));
   }
@@ -36,6 +36,22 @@ class HPACKDecoder : public HPACKDecoderBase,
                        uint32_t totalBytes,
                        HPACK::StreamingCallback* streamingCb);
 
+  /**
+   * Incrementally decode one fragment of a header block as it arrives off
+   * the wire.  Whole header fields are decoded and delivered to the
+   * callback right away; a field cut off by the end of the fragment is
+   * left untouched, and the number of bytes actually consumed is returned
+   * so the caller only needs to retain the unconsumed tail until more
+   * bytes arrive.  When endOfBlock is true this fragment finishes the
+   * block: leftover bytes become a decode error and completion is
+   * delivered to the callback.  The uncompressed size limit is enforced
+   * as fields are emitted, before the full block has been buffered.
+   */
+  uint32_t decodeStreamingFragment(folly::io::Cursor& cursor,
+                                   uint32_t totalBytes,
+                                   bool endOfBlock,
+                                   HPACK::StreamingCallback* streamingCb);
+
 
   void setHeaderTableMaxSize(uint32_t maxSize) {
     HPACKDecoderBase::setHeaderTableMaxSize(table_, maxSize);
@@ -55,6 +71,11 @@ class HPACKDecoder : public HPACKDecoderBase,
   uint32_t decodeHeader(HPACKDecodeBuffer& dbuf,
                         HPACK::StreamingCallback* streamingCb,
                         headers_t* emitted);
+
+  // Compressed bytes consumed and uncompressed bytes emitted so far across
+  // the fragments of the block being decoded incrementally
+  uint32_t blockConsumed_{0};
+  uint32_t blockEmitted_{0};
 };
 
 }
@@ -70,7 +70,9 @@ void HPACKDecoderBase::handleTableSizeUpdate(HPACKDecodeBuffer& dbuf,
   uint64_t arg = 0;
   err_ = dbuf.decodeInteger(HPACK::TABLE_SIZE_UPDATE.prefixLength, arg);
   if (err_ != HPACK::DecodeError::NONE) {
-    if (!isQpack || err_ != HPACK::DecodeError::BUFFER_UNDERFLOW) {
+    // underflow is expected when the caller is feeding a fragmented block
+    if (err_ != HPACK::DecodeError::BUFFER_UNDERFLOW ||
+        (!isQpack && dbuf.endOfBufferIsError())) {
       LOG(ERROR) << "Decode error decoding maxSize err_=" << err_;
     }
     return;
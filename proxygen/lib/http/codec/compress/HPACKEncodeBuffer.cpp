@@ -43,6 +43,12 @@ void HPACKEncodeBuffer::addHeadroom(uint32_t headroom) {
   bufQueue_.append(std::move(buf));
 }
 
+void HPACKEncodeBuffer::reserve(uint64_t bytes) {
+  if (bytes > 0) {
+    buf_.ensure(bytes);
+  }
+}
+
 void HPACKEncodeBuffer::append(uint8_t byte) {
   buf_.push(&byte, 1);
 }
@@ -107,8 +113,14 @@ uint32_t HPACKEncodeBuffer::encodeHuffman(folly::StringPiece literal) {
  */
 uint32_t HPACKEncodeBuffer::encodeHuffman(uint8_t instruction, uint8_t nbit,
                                           folly::StringPiece literal) {
+  return encodeHuffman(instruction, nbit, literal,
+                       huffman::huffTree().getEncodeSize(literal));
+}
+
+uint32_t HPACKEncodeBuffer::encodeHuffman(uint8_t instruction, uint8_t nbit,
+                                          folly::StringPiece literal,
+                                          uint32_t size) {
   static const auto& huffmanTree = huffman::huffTree();
-  uint32_t size = huffmanTree.getEncodeSize(literal);
   // add the length
   DCHECK_LE(nbit, 7);
   uint8_t huffmanOn = uint8_t(1 << nbit);
@@ -126,7 +138,12 @@ uint32_t HPACKEncodeBuffer::encodeLiteral(folly::StringPiece literal) {
 uint32_t HPACKEncodeBuffer::encodeLiteral(uint8_t instruction, uint8_t nbit,
                                           folly::StringPiece literal) {
   if (huffmanEnabled_) {
-    return encodeHuffman(instruction, nbit, literal);
+    // only huffman encode when it actually shrinks the literal; values
+    // like base64 blobs or uuids often expand instead
+    uint32_t huffmanSize = huffman::huffTree().getEncodeSize(literal);
+    if (huffmanSize < literal.size()) {
+      return encodeHuffman(instruction, nbit, literal, huffmanSize);
+    }
   }
   // otherwise use simple layout
   uint32_t count =
@@ -45,6 +45,13 @@ class HPACKEncodeBuffer {
    */
   void addHeadroom(uint32_t bytes);
 
+  /**
+   * Pre-size the buffer so the next `bytes` bytes of output can be written
+   * without intermediate reallocations.  Meant to be called once per header
+   * block with an estimate derived from the batch being encoded.
+   */
+  void reserve(uint64_t bytes);
+
   /**
    * Encode the integer value using variable-length layout and the given
    * instruction using an nbit prefix.  Per the spec, prefix is the portion
@@ -102,6 +109,13 @@ class HPACKEncodeBuffer {
 
  private:
 
+  /**
+   * variant that takes the huffman-encoded size already computed by the
+   * caller, so the literal is only scanned once
+   */
+  uint32_t encodeHuffman(uint8_t instruction, uint8_t nbit,
+                         folly::StringPiece literal, uint32_t size);
+
   /**
    * append one byte at the end of buffer ensuring we always have enough space
    */
@@ -19,12 +19,63 @@ HPACKEncoder::encode(const vector<HPACKHeader>& headers, uint32_t headroom) {
     streamBuffer_.addHeadroom(headroom);
   }
   handlePendingContextUpdate(streamBuffer_, table_.capacity());
+  // Pre-size the output from the whole batch: a header encodes to at most
+  // its literal size plus a few bytes of instruction/length prefixes, so
+  // this keeps the tight loop below free of buffer growth.
+  uint64_t estimate = 0;
+  for (const auto& header : headers) {
+    estimate += header.name.size() + header.value.size() + 8;
+  }
+  streamBuffer_.reserve(estimate);
   for (const auto& header : headers) {
     encodeHeader(header);
   }
   return streamBuffer_.release();
 }
 
+std::unique_ptr<folly::IOBuf>
+HPACKEncoder::encodeStaticOnly(const vector<HPACKHeader>& headers,
+                               uint32_t headroom) {
+  if (headroom) {
+    streamBuffer_.addHeadroom(headroom);
+  }
+  // Deliberately no handlePendingContextUpdate: a pending table size
+  // change belongs to this connection's stream and must not leak into a
+  // block meant to be replayed elsewhere; it stays pending for the next
+  // regular encode.
+  uint64_t estimate = 0;
+  for (const auto& header : headers) {
+    estimate += header.name.size() + header.value.size() + 8;
+  }
+  streamBuffer_.reserve(estimate);
+  for (const auto& header : headers) {
+    // Same static table applicability checks as HPACKContext::getIndex
+    bool consultStaticTable = false;
+    if (header.value.empty()) {
+      consultStaticTable = header.name.isCommonHeader();
+    } else {
+      consultStaticTable =
+          StaticHeaderTable::isHeaderCodeInTableWithNonEmptyValue(
+              header.name.getHeaderCode());
+    }
+    if (consultStaticTable) {
+      uint32_t staticIndex = getStaticTable().getIndex(header);
+      if (staticIndex) {
+        staticRefs_++;
+        encodeAsIndex(staticToGlobalIndex(staticIndex));
+        continue;
+      }
+    }
+    uint32_t staticNameIndex = getStaticTable().nameIndex(header.name);
+    if (staticNameIndex) {
+      staticRefs_++;
+      staticNameIndex = staticToGlobalIndex(staticNameIndex);
+    }
+    encodeLiteral(header, staticNameIndex, HPACK::LITERAL);
+  }
+  return streamBuffer_.release();
+}
+
 bool HPACKEncoder::encodeAsLiteral(const HPACKHeader& header, bool indexing) {
   if (header.bytes() > table_.capacity()) {
     // May want to investigate further whether or not this is wanted.
@@ -65,7 +116,48 @@ void HPACKEncoder::encodeAsIndex(uint32_t index) {
   streamBuffer_.encodeInteger(index, HPACK::INDEX_REF);
 }
 
+uint32_t HPACKEncoder::getCachedIndex(const HPACKHeader& header) {
+  if (cacheInsertCount_ != table_.getInsertCount() ||
+      cacheTableSize_ != table_.size()) {
+    // The dynamic table changed underneath the cache: inserts shift every
+    // index and evictions invalidate the highest ones
+    indexCache_.clear();
+    cacheInsertCount_ = table_.getInsertCount();
+    cacheTableSize_ = table_.size();
+  }
+  auto it = indexCache_.find(header.name);
+  if (it != indexCache_.end()) {
+    for (const auto& valueIndex : it->second) {
+      if (valueIndex.first == header.value) {
+        if (isStatic(valueIndex.second)) {
+          staticRefs_++;
+        }
+        return valueIndex.second;
+      }
+    }
+  }
+  auto index = getIndex(header);
+  if (index) {
+    indexCache_[header.name].emplace_back(header.value, index);
+  }
+  return index;
+}
+
 void HPACKEncoder::encodeHeader(const HPACKHeader& header) {
+  if (header.neverIndex) {
+    // Pass-through metadata fast path: skip the indexing strategy, the
+    // index cache and the table search entirely.  Only the static table
+    // is consulted for a name match, so the table's state is untouched
+    // and the never-index bit tells intermediaries to do the same.
+    uint32_t staticNameIndex = getStaticTable().nameIndex(header.name);
+    if (staticNameIndex) {
+      staticRefs_++;
+      staticNameIndex = staticToGlobalIndex(staticNameIndex);
+    }
+    encodeLiteral(header, staticNameIndex, HPACK::LITERAL_NEV_INDEX);
+    return;
+  }
+
   // First determine whether the header is defined as indexable using the
   // set strategy if applicable, else assume it is indexable
   bool indexable = !indexingStrat_ || indexingStrat_->indexHeader(header);
@@ -78,7 +170,7 @@ void HPACKEncoder::encodeHeader(const HPACKHeader& header) {
   // as an override so we assume this is desired if such a case occurs
   uint32_t index = 0;
   if (indexable) {
-    index = getIndex(header);
+    index = getCachedIndex(header);
   }
 
   // Finally encode the header as determined above
@@ -9,9 +9,12 @@
  */
 #pragma once
 
+#include <folly/container/F14Map.h>
 #include <folly/io/IOBuf.h>
+#include <folly/small_vector.h>
 #include <proxygen/lib/http/codec/compress/HPACKConstants.h>
 #include <proxygen/lib/http/codec/compress/HPACKEncoderBase.h>
+#include <utility>
 #include <vector>
 
 namespace proxygen {
@@ -32,6 +35,18 @@ class HPACKEncoder : public HPACKEncoderBase, public HPACKContext {
     const std::vector<HPACKHeader>& headers,
     uint32_t headroom = 0);
 
+  /**
+   * Encode the given headers using only static table references and
+   * non-indexing literals.  The resulting block carries no connection
+   * compression state - it neither reads nor writes the dynamic table
+   * and emits no table size update - so it is valid verbatim on any
+   * HPACK stream at any time, at the cost of dynamic-table compression
+   * for the headers it contains.
+   */
+  std::unique_ptr<folly::IOBuf> encodeStaticOnly(
+    const std::vector<HPACKHeader>& headers,
+    uint32_t headroom = 0);
+
   void setHeaderTableSize(uint32_t size) {
     HPACKEncoderBase::setHeaderTableSize(table_, size);
   }
@@ -46,6 +61,25 @@ class HPACKEncoder : public HPACKEncoderBase, public HPACKContext {
   void encodeLiteral(const HPACKHeader& header,
                      uint32_t nameIndex,
                      const HPACK::Instruction& instruction);
+
+  uint32_t getCachedIndex(const HPACKHeader& header);
+
+  /**
+   * Cache of full (name, value) -> global index matches, consulted before
+   * the static/dynamic table search.  Responses tend to repeat the same
+   * handful of header pairs on every message, so after the first lookup
+   * they encode from the cache in 1-2 bytes.  Indices into the dynamic
+   * table shift on every insert and disappear on eviction, so the cache is
+   * flushed whenever the table's insert count or size has changed since it
+   * was filled; static table hits never expire but are flushed along with
+   * the rest for simplicity.
+   */
+  using IndexCache = folly::F14FastMap<
+      HPACKHeaderName,
+      folly::small_vector<std::pair<folly::fbstring, uint32_t>, 1>>;
+  IndexCache indexCache_;
+  uint32_t cacheInsertCount_{0};
+  uint32_t cacheTableSize_{0};
 };
 
 }
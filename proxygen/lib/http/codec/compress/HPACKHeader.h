@@ -34,11 +34,13 @@ class HPACKHeader {
 
   HPACKHeader(HPACKHeader&& goner) noexcept
       : name(std::move(goner.name)),
-        value(std::move(goner.value)) {}
+        value(std::move(goner.value)),
+        neverIndex(goner.neverIndex) {}
 
   HPACKHeader& operator=(HPACKHeader&& goner) noexcept {
     std::swap(name, goner.name);
     std::swap(value, goner.value);
+    std::swap(neverIndex, goner.neverIndex);
     return *this;
   }
 
@@ -90,6 +92,13 @@ class HPACKHeader {
 
   HPACKHeaderName name;
   folly::fbstring value;
+  /**
+   * Encode as a never-indexed literal, skipping the indexing strategy and
+   * the dynamic table entirely.  Set for pass-through metadata whose value
+   * changes on every message (trace ids and the like), where attempting to
+   * index only churns the table and hurts compression of everything else.
+   */
+  bool neverIndex{false};
 };
 
 std::ostream& operator<<(std::ostream& os, const HPACKHeader& h);
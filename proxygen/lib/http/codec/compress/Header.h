@@ -22,6 +22,9 @@ struct Header {
   HTTPHeaderCode code;
   const std::string* name;
   const std::string* value;
+  // Encode as a never-indexed literal, bypassing the indexing strategy
+  // and the dynamic table; see HPACKHeader::neverIndex
+  bool neverIndex{false};
 
   Header(HTTPHeaderCode c,
          const std::string& v)
@@ -9,6 +9,7 @@
  */
 #include <proxygen/lib/http/codec/compress/HeaderTable.h>
 
+#include <folly/lang/Bits.h>
 #include <glog/logging.h>
 
 
@@ -19,7 +20,9 @@ void HeaderTable::init(uint32_t capacityVal) {
   size_ = 0;
   head_ = 0;
   capacity_ = capacityVal;
-  uint32_t initLength = getMaxTableLength(capacity_) / 2;
+  // Lengths are always powers of two so the ring wrap in next()/tail() and
+  // the index translations is a mask instead of a division
+  uint32_t initLength = folly::nextPowTwo(getMaxTableLength(capacity_) / 2);
   table_.reserve(initLength);
   for (uint32_t i = 0; i < initLength; i++) {
     table_.emplace_back();
@@ -44,8 +47,9 @@ bool HeaderTable::add(HPACKHeader header) {
   }
 
   if (size_ == length()) {
-    increaseTableLengthTo(std::min((uint32_t)ceil(size_ * 1.5),
-                                   getMaxTableLength(capacity_)));
+    increaseTableLengthTo(
+        folly::nextPowTwo(std::min((uint32_t)ceil(size_ * 1.5),
+                                   getMaxTableLength(capacity_))));
   }
   head_ = next(head_);
   // index name
@@ -96,8 +100,8 @@ const HPACKHeader& HeaderTable::getHeader(uint32_t index) const {
 uint32_t HeaderTable::getMaxTableLength(uint32_t capacityVal) const {
   // At a minimum an entry will take 32 bytes
   // No need to add an extra slot; i.e. a capacity of 32 to 63 bytes can hold
-  // at most one entry.
-  return (capacityVal >> 5);
+  // at most one entry.  Rounded up to a power of two to match the ring shape.
+  return folly::nextPowTwo(capacityVal >> 5);
 }
 
 uint32_t HeaderTable::removeLast() {
@@ -107,7 +111,7 @@ uint32_t HeaderTable::removeLast() {
   DCHECK(names_it != names_.end());
   auto &ilist = names_it->second;
   DCHECK_EQ(ilist.front(), t);
-  ilist.pop_front();
+  ilist.erase(ilist.begin());
 
   // remove the name if there are no indices associated with it
   if (ilist.empty()) {
@@ -156,6 +160,7 @@ bool HeaderTable::setCapacity(uint32_t newCapacity) {
 
 void HeaderTable::increaseTableLengthTo(uint32_t newLength) {
   DCHECK_GE(newLength, length());
+  DCHECK(folly::isPowTwo(newLength));
   uint32_t oldTail = (size_ > 0) ? tail() : 0;
   auto oldLength = length();
   resizeTable(newLength);
@@ -209,14 +214,14 @@ bool HeaderTable::isValid(uint32_t index) const {
 }
 
 uint32_t HeaderTable::next(uint32_t i) const {
-  return (i + 1) % length();
+  return (i + 1) & (length() - 1);
 }
 
 uint32_t HeaderTable::tail() const {
   // tail is private, and only called in the encoder, where head_ is always
   // valid
   DCHECK_GT(size_, 0) << "tail() undefined";
-  return (head_ + length() - size_ + 1) % length();
+  return (head_ + length() - size_ + 1) & (length() - 1);
 }
 
 uint32_t HeaderTable::toExternal(uint32_t internalIndex) const {
@@ -225,7 +230,8 @@ uint32_t HeaderTable::toExternal(uint32_t internalIndex) const {
 
 uint32_t HeaderTable::toExternal(uint32_t head, uint32_t length,
                                  uint32_t internalIndex) {
-  return ((head + length - internalIndex) % length) + 1;
+  DCHECK(folly::isPowTwo(length));
+  return ((head + length - internalIndex) & (length - 1)) + 1;
 }
 
 uint32_t HeaderTable::toInternal(uint32_t externalIndex) const {
@@ -234,9 +240,10 @@ uint32_t HeaderTable::toInternal(uint32_t externalIndex) const {
 
 uint32_t HeaderTable::toInternal(uint32_t head, uint32_t length,
                                  uint32_t externalIndex) {
+  DCHECK(folly::isPowTwo(length));
   // remove the offset
   --externalIndex;
-  return (head + length - externalIndex) % length;
+  return (head + length - externalIndex) & (length - 1);
 }
 
 bool HeaderTable::operator==(const HeaderTable& other) const {
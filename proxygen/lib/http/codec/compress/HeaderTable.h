@@ -9,24 +9,29 @@
  */
 #pragma once
 
-#include <list>
 #include <string>
 #include <vector>
 
 #include <folly/container/F14Map.h>
+#include <folly/small_vector.h>
 #include <proxygen/lib/http/codec/compress/HPACKHeader.h>
 
 namespace proxygen {
 
 /**
  * Data structure for maintaining indexed headers, based on a fixed-length ring
- * with FIFO semantics. Externally it acts as an array.
+ * with FIFO semantics. Externally it acts as an array.  The ring length is
+ * always a power of two so that wrapping an index is a mask rather than a
+ * division.
  */
 
 class HeaderTable {
  public:
-  // TODO: std::vector might be faster than std::list in the use case?
-  using names_map = folly::F14FastMap<HPACKHeaderName, std::list<uint32_t>>;
+  // Nearly every name maps to a single index, so keep it inline; insert
+  // and evict then touch no allocator, where the previous std::list paid
+  // a node allocation per index
+  using names_map =
+      folly::F14FastMap<HPACKHeaderName, folly::small_vector<uint32_t, 1>>;
 
   explicit HeaderTable(uint32_t capacityVal) {
     init(capacityVal);
@@ -98,7 +103,7 @@ class HeaderTable {
 
   /**
   * Returns the maximum table length required to support HPACK headers given
-  * the specified capacity bytes
+  * the specified capacity bytes, rounded up to a power of two
   */
   uint32_t getMaxTableLength(uint32_t capacityVal) const;
 
@@ -19,15 +19,113 @@ namespace proxygen { namespace huffman {
 HuffTree::HuffTree(const uint32_t* codes, const uint8_t* bits)
     : codes_(codes), bits_(bits) {
   buildTree();
+  buildDecodeTable();
 }
 
 HuffTree::HuffTree(const HuffTree& tree) :
     codes_(tree.codes_), bits_(tree.bits_) {
   buildTree();
+  buildDecodeTable();
 }
 
 bool HuffTree::decode(const uint8_t* buf, uint32_t size,
-                      folly::fbstring& literal)
+                      folly::fbstring& literal) const {
+  uint32_t state = 0;
+  if (!decodeChunk(state, buf, size, literal)) {
+    return false;
+  }
+  return decodeFinish(state);
+}
+
+bool HuffTree::decodeChunk(uint32_t& state, const uint8_t* buf, uint32_t size,
+                           folly::fbstring& literal) const {
+  return decodeChunkSink(state, buf, size, literal);
+}
+
+bool HuffTree::decodeFinish(uint32_t state) const {
+  // any trailing bits must be a prefix of EOS, i.e. all ones
+  return acceptState_[state];
+}
+
+/**
+ * Build the DFA the decoder runs on.  Nodes of the binary code tree that
+ * are reachable on a 4-bit boundary become states; each (state, nibble)
+ * transition pre-resolves the bit-by-bit walk, including the single
+ * character that can complete inside the nibble.
+ */
+void HuffTree::buildDecodeTable() {
+  // explicit binary code tree; node 0 is the root
+  struct TreeNode {
+    int32_t child[2]{-1, -1};
+    int32_t sym{-1};
+  };
+  std::vector<TreeNode> tree(1);
+  for (uint32_t ch = 0; ch < kTableSize; ch++) {
+    uint32_t code = codes_[ch];
+    uint8_t bits = bits_[ch];
+    int32_t node = 0;
+    while (bits > 0) {
+      uint8_t bit = (code >> (bits - 1)) & 1;
+      if (tree[node].child[bit] < 0) {
+        tree[node].child[bit] = tree.size();
+        tree.emplace_back();
+      }
+      node = tree[node].child[bit];
+      bits--;
+    }
+    tree[node].sym = ch;
+  }
+
+  // number the states lazily as the BFS over nibble transitions finds them
+  std::vector<int32_t> stateOfNode(tree.size(), -1);
+  std::vector<int32_t> nodeOfState;
+  auto stateFor = [&] (int32_t node) {
+    if (stateOfNode[node] < 0) {
+      stateOfNode[node] = nodeOfState.size();
+      nodeOfState.push_back(node);
+    }
+    return stateOfNode[node];
+  };
+  stateFor(0);
+
+  decodeTable_.clear();
+  for (uint32_t state = 0; state < nodeOfState.size(); state++) {
+    decodeTable_.resize((state + 1) * 16);
+    for (uint32_t nibble = 0; nibble < 16; nibble++) {
+      HuffDecodeEntry& entry = decodeTable_[(state << 4) | nibble];
+      int32_t node = nodeOfState[state];
+      for (int8_t bitpos = 3; bitpos >= 0; bitpos--) {
+        node = tree[node].child[(nibble >> bitpos) & 1];
+        if (node < 0) {
+          // prefix no symbol starts with; covers the tail of the EOS code
+          entry.flags = kHuffDecodeFail;
+          break;
+        }
+        if (tree[node].sym >= 0) {
+          entry.flags |= kHuffDecodeEmit;
+          entry.sym = tree[node].sym;
+          node = 0;
+        }
+      }
+      if (!(entry.flags & kHuffDecodeFail)) {
+        entry.next = stateFor(node);
+      }
+    }
+  }
+
+  // a state is a valid stop iff its prefix from the root is all ones
+  acceptState_.assign(nodeOfState.size(), false);
+  int32_t node = 0;
+  while (node >= 0) {
+    if (stateOfNode[node] >= 0) {
+      acceptState_[stateOfNode[node]] = true;
+    }
+    node = tree[node].child[1];
+  }
+}
+
+bool HuffTree::decodeTreeWalk(const uint8_t* buf, uint32_t size,
+                              folly::fbstring& literal)
     const {
   const SuperHuffNode* snode = &table_[0];
   uint32_t w = 0;
@@ -130,29 +228,23 @@ void HuffTree::buildTree() {
 
 uint32_t HuffTree::encode(folly::StringPiece literal,
                           folly::io::QueueAppender& buf) const {
-  uint32_t code;  // the huffman code of a given character
-  uint8_t bits;   // on how many bits code is represented
-  uint32_t w = 0; // 4-byte word used for packing bits and write it to memory
-  uint8_t wbits = 0;  // how many bits we have in 'w'
+  // 64-bit bit buffer: the longest code is 28 bits, so after draining to
+  // below 32 bits there is always room to append a whole symbol without
+  // the straddle/carry arithmetic the old 32-bit version needed
+  uint64_t w = 0;     // bit buffer, valid bits are the wbits least significant
+  uint32_t wbits = 0; // how many bits we have in 'w'
   uint32_t totalBytes = 0;
   for (size_t i = 0; i < literal.size(); i++) {
     uint8_t ch = literal[i];
-    code = codes_[ch];
-    bits = bits_[ch];
-
-    if (wbits + bits < 32) {
-      w = (w << bits) | code;
-      wbits += bits;
-    } else {
-      uint8_t xbits = wbits + bits - 32;
-      w = (w << (bits - xbits)) | (code >> xbits);
+    w = (w << bits_[ch]) | codes_[ch];
+    wbits += bits_[ch];
+    if (wbits >= 32) {
       // write the word into the buffer by converting to network order, which
       // takes care of the endianness problems
-      buf.writeBE<uint32_t>(w);
+      buf.writeBE<uint32_t>(uint32_t(w >> (wbits - 32)));
       totalBytes += 4;
-      // carry for next batch
-      wbits = xbits;
-      w = code & ((1 << xbits) - 1);
+      wbits -= 32;
+      w &= (uint64_t(1) << wbits) - 1;
     }
   }
   // we might have some padding at the byte level
@@ -160,18 +252,15 @@ uint32_t HuffTree::encode(folly::StringPiece literal,
     // padding bits
     uint8_t padbits = 8 - (wbits & 0x7);
     w = (w << padbits) | ((1 << padbits) - 1);
-
     wbits += padbits;
   }
   // we need to write the leftover bytes, from 1 to 4 bytes
   if (wbits > 0) {
     uint8_t bytes = wbits >> 3;
-    // align the bits to the MSB
-    w = w << (32 - wbits);
-    // set the bytes in the network order and copy w[0], w[1]...
-    w = htonl(w);
+    // align the bits to the MSB of a 32-bit word
+    uint32_t out = htonl(uint32_t(w << (32 - wbits)));
     // we need to use memcpy because we might write less than 4 bytes
-    buf.push((uint8_t*)&w, bytes);
+    buf.push((uint8_t*)&out, bytes);
     totalBytes += bytes;
   }
   return totalBytes;
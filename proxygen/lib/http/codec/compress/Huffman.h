@@ -14,6 +14,7 @@
 #include <folly/io/IOBuf.h>
 #include <proxygen/lib/http/codec/compress/HPACKConstants.h>
 #include <string>
+#include <vector>
 
 namespace proxygen { namespace huffman {
 
@@ -51,6 +52,24 @@ struct SuperHuffNode {
   HuffNode index[256];
 };
 
+/**
+ * entry of the flat DFA decode table; one per (state, nibble)
+ *
+ * A state is a position in the code tree that is reachable on a 4-bit
+ * boundary.  Stepping consumes 4 bits of input, emits at most one
+ * character (the shortest code is 5 bits, so a nibble can never complete
+ * two) and moves to the next state.  Undefined prefixes - including
+ * anything that would run into the EOS code - fail.
+ */
+struct HuffDecodeEntry {
+  uint16_t next;  // next DFA state
+  uint8_t flags;  // combination of the kHuffDecode* flags below
+  uint8_t sym;    // character to emit, valid when EMIT is set
+};
+
+const uint8_t kHuffDecodeEmit = 0x01;
+const uint8_t kHuffDecodeFail = 0x02;
+
 /**
  * Immutable Huffman tree used in the process of decoding. Traditionally the
  * huffman tree is binary, but using that approach leads to major inefficiencies
@@ -103,6 +122,75 @@ class HuffTree {
   bool decode(const uint8_t* buf, uint32_t size,
               folly::fbstring& literal) const;
 
+  /**
+   * stepwise variant of decode() for bit streams split across buffers.
+   * Feed each chunk through decodeChunk(), carrying the DFA state between
+   * calls - chunk boundaries fall on byte boundaries, which the DFA
+   * doesn't care about - then validate the final padding with
+   * decodeFinish().  decode() is one chunk followed by the finish check.
+   *
+   * @param state DFA state, must be 0 before the first chunk
+   * @return false if the stream is invalid; the state is then unusable
+   */
+  bool decodeChunk(uint32_t& state, const uint8_t* buf, uint32_t size,
+                   folly::fbstring& literal) const;
+  bool decodeFinish(uint32_t state) const;
+
+  /**
+   * Sink writing decoded symbols to a caller-provided buffer, for output
+   * that goes into arena storage instead of an owning string.  The caller
+   * must reserve for the worst case: a nibble step emits at most one
+   * symbol, so at most two symbols per encoded byte.
+   */
+  struct RawSink {
+    explicit RawSink(char* buf) : tail(buf) {
+    }
+    void push_back(char ch) {
+      *tail++ = ch;
+    }
+    char* tail;
+  };
+
+  /**
+   * decodeChunk() generalized over the output; Sink needs push_back(char).
+   * The fbstring overloads above forward here.
+   */
+  template <typename Sink>
+  bool decodeChunkSink(uint32_t& state,
+                       const uint8_t* buf,
+                       uint32_t size,
+                       Sink& sink) const {
+    for (uint32_t i = 0; i < size; i++) {
+      const uint8_t byte = buf[i];
+      const HuffDecodeEntry& hi = decodeTable_[(state << 4) | (byte >> 4)];
+      if (hi.flags & kHuffDecodeFail) {
+        return false;
+      }
+      if (hi.flags & kHuffDecodeEmit) {
+        sink.push_back(hi.sym);
+      }
+      state = hi.next;
+      const HuffDecodeEntry& lo = decodeTable_[(state << 4) | (byte & 0x0f)];
+      if (lo.flags & kHuffDecodeFail) {
+        return false;
+      }
+      if (lo.flags & kHuffDecodeEmit) {
+        sink.push_back(lo.sym);
+      }
+      state = lo.next;
+    }
+    return true;
+  }
+
+  /**
+   * the original 8-bit indexed tree walk; kept for comparison in
+   * benchmarks and tests.  decode() above runs a flat DFA instead: two
+   * table loads per input byte, no per-bit arithmetic, and it rejects
+   * streams with invalid padding or an embedded EOS code
+   */
+  bool decodeTreeWalk(const uint8_t* buf, uint32_t size,
+                      folly::fbstring& literal) const;
+
   /**
    * encode string literal into huffman encoded bit stream
    *
@@ -141,12 +229,18 @@ class HuffTree {
   void fillIndex(SuperHuffNode& snode, uint32_t code, uint8_t bits, uint8_t ch,
      uint8_t level);
   void buildTree();
+  void buildDecodeTable();
   void insert(uint32_t code, uint8_t bits, uint8_t ch);
 
   uint32_t nodes_{0};
   const uint32_t* codes_;
   const uint8_t* bits_;
 
+  // flat DFA decode table, 16 entries per state
+  std::vector<HuffDecodeEntry> decodeTable_;
+  // states whose tree prefix is all ones, i.e. valid final padding
+  std::vector<bool> acceptState_;
+
  protected:
   explicit HuffTree(const HuffTree& tree);
   SuperHuffNode table_[46];
@@ -9,6 +9,8 @@
  */
 #pragma once
 
+#include <algorithm>
+#include <folly/Optional.h>
 #include <memory>
 #include <proxygen/lib/http/codec/TransportDirection.h>
 #include <proxygen/lib/http/codec/compress/HPACKCodec.h> // table info
@@ -103,20 +105,41 @@ class QPACKCodec : public HeaderCodec {
   }
 
   CompressionInfo getCompressionInfo() const {
-    return CompressionInfo(encoder_.getTableSize(),
-                           encoder_.getBytesStored(),
-                           encoder_.getHeadersStored(),
-                           encoder_.getInsertCount(),
-                           encoder_.getBlockedInserts(),
-                           encoder_.getDuplications(),
-                           encoder_.getStaticRefs(),
-                           decoder_.getTableSize(),
-                           decoder_.getBytesStored(),
-                           decoder_.getHeadersStored(),
-                           decoder_.getInsertCount(),
-                           0, // decoder can't track blocked inserts
-                           decoder_.getDuplications(),
-                           decoder_.getStaticRefs());
+    CompressionInfo info(encoder_.getTableSize(),
+                         encoder_.getBytesStored(),
+                         encoder_.getHeadersStored(),
+                         encoder_.getInsertCount(),
+                         encoder_.getBlockedInserts(),
+                         encoder_.getDuplications(),
+                         encoder_.getStaticRefs(),
+                         decoder_.getTableSize(),
+                         decoder_.getBytesStored(),
+                         decoder_.getHeadersStored(),
+                         decoder_.getInsertCount(),
+                         0, // decoder can't track blocked inserts
+                         decoder_.getDuplications(),
+                         decoder_.getStaticRefs());
+    info.ingress.holBlockCount_ = decoder_.getHolBlockCount();
+    info.ingress.holBlockDelayUs_ = decoder_.getHolBlockDelayUs();
+    info.ingress.maxHolBlockDelayUs_ = decoder_.getMaxHolBlockDelayUs();
+    return info;
+  }
+
+  /**
+   * Snapshot of the decoder's dynamic table contents, oldest insertion
+   * first, for session migration.  Replaying the entries into a fresh
+   * table in this order reproduces the peer encoder's view.
+   */
+  std::vector<std::pair<std::string, std::string>> dumpDecoderTable() const {
+    std::vector<std::pair<std::string, std::string>> entries;
+    const auto& table = decoder_.getTable();
+    const auto size = table.size();
+    entries.reserve(size);
+    for (uint32_t i = size; i >= 1; i--) {
+      const auto& header = table.getHeader(i);
+      entries.emplace_back(header.name.get(), header.value.toStdString());
+    }
+    return entries;
   }
 
   void setHeaderIndexingStrategy(const HeaderIndexingStrategy* indexingStrat) {
@@ -134,12 +157,34 @@ class QPACKCodec : public HeaderCodec {
     return decoder_.getQueuedBytes();
   }
 
+  // Sets the hard limit on blocked streams, from the peer's
+  // QPACK_BLOCKED_STREAMS setting.  If a tuned budget is in effect it is
+  // re-clamped against the new limit.
   void setMaxVulnerable(uint32_t maxVulnerable) {
-    encoder_.setMaxVulnerable(maxVulnerable);
+    peerMaxBlocking_ = maxVulnerable;
+    applyBlockedStreamsBudget();
   }
 
+  // Sets the number of blocked streams we advertised to the peer in
+  // QPACK_BLOCKED_STREAMS
   void setMaxBlocking(uint32_t maxBlocking) {
-    decoder_.setMaxBlocking(maxBlocking);
+    advertisedMaxBlocking_ = maxBlocking;
+    applyBlockedStreamsBudget();
+  }
+
+  /**
+   * Runtime tuning of the blocked-stream budget, e.g. driven by a live RTT
+   * estimate - blocking is cheap on short-RTT connections and expensive on
+   * long ones.  The encoder will make at most
+   * min(budget, peer's QPACK_BLOCKED_STREAMS) streams blocking; the decoder
+   * will queue up to max(budget, our advertised limit) blocked streams, since
+   * shrinking the advertised limit mid-connection would error streams the
+   * peer was entitled to block.  Pass folly::none to fall back to the
+   * settings-negotiated limits.
+   */
+  void setBlockedStreamsBudget(folly::Optional<uint32_t> budget) {
+    blockedStreamsBudget_ = budget;
+    applyBlockedStreamsBudget();
   }
 
   void setMaxNumOutstandingBlocks(uint32_t value) {
@@ -153,7 +198,21 @@ class QPACKCodec : public HeaderCodec {
  private:
   void recordCompressedSize(const QPACKEncoder::EncodeResult& encodeRes);
 
+  void applyBlockedStreamsBudget() {
+    encoder_.setMaxVulnerable(
+        blockedStreamsBudget_ ? std::min(*blockedStreamsBudget_,
+                                         peerMaxBlocking_)
+                              : peerMaxBlocking_);
+    decoder_.setMaxBlocking(
+        blockedStreamsBudget_ ? std::max(*blockedStreamsBudget_,
+                                         advertisedMaxBlocking_)
+                              : advertisedMaxBlocking_);
+  }
+
   std::vector<HPACKHeader> decodedHeaders_;
+  uint32_t peerMaxBlocking_{HPACK::kDefaultBlocking};
+  uint32_t advertisedMaxBlocking_{HPACK::kDefaultBlocking};
+  folly::Optional<uint32_t> blockedStreamsBudget_;
 };
 
 std::ostream& operator<<(std::ostream& os, const QPACKCodec& codec);
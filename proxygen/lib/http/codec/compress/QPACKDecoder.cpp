@@ -10,6 +10,8 @@
 #include <proxygen/lib/http/codec/compress/QPACKDecoder.h>
 #include <proxygen/lib/http/codec/compress/HPACKEncodeBuffer.h>
 
+#include <algorithm>
+
 using folly::io::Cursor;
 
 namespace {
@@ -30,8 +32,8 @@ void QPACKDecoder::decodeStreaming(uint64_t streamID,
   if (requiredInsertCount > table_.getInsertCount()) {
     VLOG(5) << "requiredInsertCount=" << requiredInsertCount
             << " > insertCount=" << table_.getInsertCount() << ", queuing";
-    if (queue_.size() >= maxBlocking_) {
-      VLOG(2) << "QPACK queue is full size=" << queue_.size()
+    if (queuedBlocks_ >= maxBlocking_) {
+      VLOG(2) << "QPACK queue is full size=" << queuedBlocks_
               << " maxBlocking_=" << maxBlocking_;
       err_ = HPACK::DecodeError::TOO_MANY_BLOCKING;
       completeDecode(HeaderCodec::Type::QPACK, streamingCb, 0, 0, 0, false);
@@ -401,10 +403,17 @@ std::unique_ptr<folly::IOBuf> QPACKDecoder::encodeHeaderAck(
 
 std::unique_ptr<folly::IOBuf> QPACKDecoder::encodeCancelStream(
     uint64_t streamId) {
-  // Remove this stream from the queue
-  auto it = queue_.begin();
-  while (it != queue_.end()) {
-    if (it->second.streamID == streamId) {
+  // Remove this stream's blocks from the queue
+  for (auto it = queue_.begin(); it != queue_.end();) {
+    auto& bucket = it->second;
+    auto removeIt = std::remove_if(bucket.begin(),
+                                   bucket.end(),
+                                   [streamId](const PendingBlock& pending) {
+                                     return pending.streamID == streamId;
+                                   });
+    queuedBlocks_ -= std::distance(removeIt, bucket.end());
+    bucket.erase(removeIt, bucket.end());
+    if (bucket.empty()) {
       it = queue_.erase(it);
     } else {
       it++;
@@ -424,14 +433,13 @@ void QPACKDecoder::enqueueHeaderBlock(uint64_t streamID,
                                       HPACK::StreamingCallback* streamingCb) {
   // TDOO: this queue is currently unbounded and has no timeouts
   CHECK_GT(requiredInsertCount, table_.getInsertCount());
-  queue_.emplace(std::piecewise_construct,
-                 std::forward_as_tuple(requiredInsertCount),
-                 std::forward_as_tuple(streamID,
-                                       baseIndex,
-                                       length,
-                                       consumed,
-                                       std::move(block),
-                                       streamingCb));
+  queue_[requiredInsertCount].emplace_back(streamID,
+                                           baseIndex,
+                                           length,
+                                           consumed,
+                                           std::move(block),
+                                           streamingCb);
+  queuedBlocks_++;
   holBlockCount_++;
   VLOG(5) << "queued block=" << requiredInsertCount << " len=" << length;
   queuedBytes_ += length;
@@ -458,16 +466,32 @@ bool QPACKDecoder::decodeBlock(uint32_t requiredInsertCount,
 }
 
 void QPACKDecoder::drainQueue() {
-  auto it = queue_.begin();
-  while (!queue_.empty() && it->first <= table_.getInsertCount() &&
-         !hasError()) {
+  while (!queue_.empty() &&
+         queue_.begin()->first <= table_.getInsertCount() && !hasError()) {
+    // Every block in the leading bucket became eligible with the same
+    // insert; detach the whole bucket in one map operation and decode
+    // its blocks in arrival order
+    auto it = queue_.begin();
     auto id = it->first;
-    PendingBlock block = std::move(it->second);
+    auto bucket = std::move(it->second);
     queue_.erase(it);
-    if (decodeBlock(id, block)) {
-      return;
+    auto now = std::chrono::steady_clock::now();
+    for (auto& block : bucket) {
+      queuedBlocks_--;
+      uint64_t delayUs = std::chrono::duration_cast<std::chrono::microseconds>(
+                             now - block.enqueueTime)
+                             .count();
+      holBlockDelayUs_ += delayUs;
+      if (delayUs > maxHolBlockDelayUs_) {
+        maxHolBlockDelayUs_ = delayUs;
+      }
+      if (decodeBlock(id, block)) {
+        return;
+      }
+      if (hasError()) {
+        break;
+      }
     }
-    it = queue_.begin();
   }
 }
 
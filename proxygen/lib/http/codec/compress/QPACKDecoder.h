@@ -16,7 +16,9 @@
 #include <proxygen/lib/http/codec/compress/HPACKDecodeBuffer.h>
 #include <proxygen/lib/http/codec/compress/QPACKContext.h>
 #include <folly/io/async/DestructorCheck.h>
+#include <chrono>
 #include <map>
+#include <vector>
 
 namespace proxygen {
 
@@ -52,6 +54,18 @@ class QPACKDecoder : public HPACKDecoderBase,
     return queuedBytes_;
   }
 
+  /**
+   * Cumulative and maximum time header blocks spent queued waiting for
+   * encoder stream inserts, in microseconds.
+   */
+  uint64_t getHolBlockDelayUs() const {
+    return holBlockDelayUs_;
+  }
+
+  uint64_t getMaxHolBlockDelayUs() const {
+    return maxHolBlockDelayUs_;
+  }
+
   void setMaxBlocking(uint32_t maxBlocking) {
     maxBlocking_ = maxBlocking;
   }
@@ -118,6 +132,9 @@ class QPACKDecoder : public HPACKDecoderBase,
     uint32_t consumed;
     std::unique_ptr<folly::IOBuf> block;
     HPACK::StreamingCallback* cb;
+    // When the block was queued, for head-of-line delay stats
+    std::chrono::steady_clock::time_point enqueueTime{
+        std::chrono::steady_clock::now()};
   };
 
   // Returns true if this object was destroyed by its callback.  Callers
@@ -132,7 +149,17 @@ class QPACKDecoder : public HPACKDecoderBase,
   uint32_t holBlockCount_{0};
   uint32_t pendingEncoderBytes_{0};
   uint64_t queuedBytes_{0};
-  std::multimap<uint32_t, PendingBlock> queue_;
+  uint64_t holBlockDelayUs_{0};
+  uint64_t maxHolBlockDelayUs_{0};
+  // Number of blocks across all buckets of queue_
+  uint32_t queuedBlocks_{0};
+  /**
+   * Blocked header blocks, bucketed by required insert count.  An
+   * arriving insert makes every block in the leading buckets eligible
+   * at once, so drainQueue detaches whole buckets instead of erasing
+   * and re-seeking per block; within a bucket arrival order is kept.
+   */
+  std::map<uint32_t, std::vector<PendingBlock>> queue_;
 
   // This holds the state of a partially decoded literal insert on the control
   // stream
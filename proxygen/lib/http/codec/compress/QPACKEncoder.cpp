@@ -93,6 +93,22 @@ QPACKEncoder::EncodeResult QPACKEncoder::encodeQ(
 void QPACKEncoder::encodeHeaderQ(const HPACKHeader& header,
                                  uint32_t baseIndex,
                                  uint32_t* requiredInsertCount) {
+  if (header.neverIndex) {
+    // Pass-through metadata fast path: emit a literal with the N bit on
+    // the request stream, consulting only the static table for a name
+    // match.  Nothing touches the dynamic table or the encoder stream,
+    // so the block carries no references and can never block the decoder.
+    uint32_t nameIndex = getStaticTable().nameIndex(header.name);
+    encodeLiteralQHelper(streamBuffer_,
+                         header,
+                         nameIndex != 0 /* isStaticName */,
+                         nameIndex,
+                         HPACK::Q_LITERAL_STATIC,
+                         HPACK::Q_LITERAL_NAME_REF_NEVER,
+                         HPACK::Q_LITERAL_NEVER);
+    return;
+  }
+
   uint32_t index = getStaticTable().getIndex(header);
   if (index > 0) {
     // static reference
@@ -34,9 +34,9 @@ uint32_t getMinFree(uint32_t tableSize) {
 namespace proxygen {
 
 QPACKHeaderTable::QPACKHeaderTable(uint32_t capacityVal, bool trackReferences)
-    : HeaderTable(capacityVal) {
-  if (trackReferences) {
-    refCount_ = std::make_unique<std::vector<uint16_t>>(table_.size(), 0);
+    : HeaderTable(capacityVal), trackReferences_(trackReferences) {
+  if (trackReferences_) {
+    refCount_.resize(table_.size(), 0);
     minFree_ = getMinFree(capacityVal);
   } else {
     minFree_ = 0;
@@ -54,8 +54,8 @@ bool QPACKHeaderTable::add(HPACKHeader header) {
   if (!HeaderTable::add(std::move(header))) {
     return false;
   }
-  if (refCount_) {
-    (*refCount_)[head_] = 0;
+  if (trackReferences_) {
+    refCount_[head_] = 0;
   }
   DCHECK_EQ(internalToAbsolute(head_), insertCount_);
   // Increase minUsable_ until the free space + drainedBytes is >= minFree.
@@ -75,7 +75,7 @@ bool QPACKHeaderTable::setCapacity(uint32_t capacity) {
   if (!HeaderTable::setCapacity(capacity)) {
     return false;
   }
-  if (refCount_) {
+  if (trackReferences_) {
     minFree_ = getMinFree(capacity);
   } // else minFree is always 0
   return true;
@@ -130,8 +130,8 @@ const HPACKHeader& QPACKHeaderTable::getHeader(uint32_t index,
 
 uint32_t QPACKHeaderTable::removeLast() {
   auto idx = tail();
-  if (refCount_) {
-    CHECK_EQ((*refCount_)[idx], 0) << "Removed header with nonzero references";
+  if (trackReferences_) {
+    CHECK_EQ(refCount_[idx], 0) << "Removed header with nonzero references";
   }
   auto removedBytes = HeaderTable::removeLast();
   // Only non-zero when minUsable_ > insertCount_ - size_.
@@ -162,18 +162,18 @@ void QPACKHeaderTable::increaseTableLengthTo(uint32_t newLength) {
 
 void QPACKHeaderTable::resizeTable(uint32_t newLength) {
   HeaderTable::resizeTable(newLength);
-  if (refCount_) {
-    refCount_->resize(newLength);
+  if (trackReferences_) {
+    refCount_.resize(newLength);
   }
 }
 
 void QPACKHeaderTable::updateResizedTable(
     uint32_t oldTail, uint32_t oldLength, uint32_t newLength) {
   HeaderTable::updateResizedTable(oldTail, oldLength, newLength);
-  if (refCount_) {
-    std::move_backward(refCount_->begin() + oldTail,
-                       refCount_->begin() + oldLength,
-                       refCount_->begin() + newLength);
+  if (trackReferences_) {
+    std::move_backward(refCount_.begin() + oldTail,
+                       refCount_.begin() + oldLength,
+                       refCount_.begin() + newLength);
   }
 }
 
@@ -186,21 +186,21 @@ uint32_t QPACKHeaderTable::evict(uint32_t needed, uint32_t desiredCapacity) {
 }
 
 bool QPACKHeaderTable::canEvict(uint32_t needed) {
-  if (size_ == 0 || !refCount_) {
+  if (size_ == 0 || !trackReferences_) {
     return needed <= capacity_;
   }
   uint32_t freeable = 0;
   uint32_t i = tail();
   uint32_t nChecked = 0;
   while (nChecked++ < size() && freeable < needed &&
-         ((*refCount_)[i] == 0) && // don't evict referenced or unacked headers
+         (refCount_[i] == 0) && // don't evict referenced or unacked headers
          internalToAbsolute(i) <= ackedInsertCount_) {
     freeable += table_[i].bytes();
     i = next(i);
   }
   if (freeable < needed) {
     VLOG(5) << "header=" << table_[i].name << " blocked eviction, recount="
-            << (*refCount_)[i];
+            << refCount_[i];
     return false;
   }
   return true;
@@ -251,15 +251,15 @@ std::pair<bool, uint32_t> QPACKHeaderTable::maybeDuplicate(
 void QPACKHeaderTable::addRef(uint32_t absIndex) {
   // refCount is 16 bits.  It should really never get this big in practice,
   // unless a decoder is not sending HEADER_ACK in a timely way.
-  CHECK(refCount_);
-  (*refCount_)[absoluteToInternal(absIndex)]++;
+  CHECK(trackReferences_);
+  refCount_[absoluteToInternal(absIndex)]++;
 }
 
 void QPACKHeaderTable::subRef(uint32_t absIndex) {
-  CHECK(refCount_);
+  CHECK(trackReferences_);
   uint32_t index = absoluteToInternal(absIndex);
-  CHECK_GT((*refCount_)[index], 0);
-  (*refCount_)[index]--;
+  CHECK_GT(refCount_[index], 0);
+  refCount_[index]--;
 }
 
 // Converts an array index in [0..table_.size() - 1] to an absolute
@@ -213,7 +213,10 @@ class QPACKHeaderTable : public HeaderTable {
   uint32_t minUsable_{1};
   uint32_t ackedInsertCount_{0};
   uint32_t minFree_{0};
-  std::unique_ptr<std::vector<uint16_t>> refCount_;
+  // Resized in lockstep with table_, so a refcount shares the entry's
+  // power-of-two index arithmetic and add/evict/ref touch no allocator
+  std::vector<uint16_t> refCount_;
+  bool trackReferences_{false};
 };
 
 }
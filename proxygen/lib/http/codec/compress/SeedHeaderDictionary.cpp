@@ -0,0 +1,128 @@
+/*
+ *  Copyright (c) 2015-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include <proxygen/lib/http/codec/compress/SeedHeaderDictionary.h>
+
+#include <fcntl.h>
+#include <folly/FileUtil.h>
+#include <folly/ScopeGuard.h>
+#include <folly/lang/Bits.h>
+#include <glog/logging.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace {
+
+constexpr uint32_t kMagic = 0x50584844; // 'PXHD'
+constexpr uint32_t kVersion = 1;
+
+// Bounds-checked little-endian reads off the mapping
+template <typename T>
+bool readInt(const uint8_t*& cursor, const uint8_t* end, T& out) {
+  if (static_cast<size_t>(end - cursor) < sizeof(T)) {
+    return false;
+  }
+  memcpy(&out, cursor, sizeof(T));
+  out = folly::Endian::little(out);
+  cursor += sizeof(T);
+  return true;
+}
+
+bool readBytes(const uint8_t*& cursor,
+               const uint8_t* end,
+               size_t len,
+               folly::StringPiece& out) {
+  if (static_cast<size_t>(end - cursor) < len) {
+    return false;
+  }
+  out = folly::StringPiece(reinterpret_cast<const char*>(cursor), len);
+  cursor += len;
+  return true;
+}
+
+} // namespace
+
+namespace proxygen {
+
+std::shared_ptr<const SeedHeaderDictionary> SeedHeaderDictionary::fromFile(
+    const std::string& path) {
+  const int fd = folly::openNoInt(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    PLOG(ERROR) << "cannot open seed dictionary " << path;
+    return nullptr;
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size < 0) {
+    PLOG(ERROR) << "cannot stat seed dictionary " << path;
+    folly::closeNoInt(fd);
+    return nullptr;
+  }
+  const size_t len = st.st_size;
+  void* mapping = mmap(nullptr, len, PROT_READ, MAP_PRIVATE, fd, 0);
+  folly::closeNoInt(fd);
+  if (mapping == MAP_FAILED) {
+    PLOG(ERROR) << "cannot mmap seed dictionary " << path;
+    return nullptr;
+  }
+  auto guard = folly::makeGuard([=] { munmap(mapping, len); });
+
+  const uint8_t* cursor = static_cast<const uint8_t*>(mapping);
+  const uint8_t* end = cursor + len;
+  uint32_t magic = 0;
+  uint32_t version = 0;
+  uint32_t fingerprint = 0;
+  uint32_t count = 0;
+  if (!readInt(cursor, end, magic) || magic != kMagic ||
+      !readInt(cursor, end, version) || version != kVersion ||
+      !readInt(cursor, end, fingerprint) || !readInt(cursor, end, count)) {
+    LOG(ERROR) << "malformed seed dictionary header in " << path;
+    return nullptr;
+  }
+
+  std::shared_ptr<SeedHeaderDictionary> dict(new SeedHeaderDictionary());
+  dict->fingerprint_ = fingerprint;
+  dict->entries_.reserve(count);
+  for (uint32_t i = 0; i < count; i++) {
+    uint16_t nameLen = 0;
+    uint16_t valueLen = 0;
+    folly::StringPiece name;
+    folly::StringPiece value;
+    if (!readInt(cursor, end, nameLen) || !readInt(cursor, end, valueLen) ||
+        !readBytes(cursor, end, nameLen, name) ||
+        !readBytes(cursor, end, valueLen, value) || name.empty()) {
+      LOG(ERROR) << "malformed seed dictionary entry " << i << " in " << path;
+      return nullptr;
+    }
+    dict->entries_.emplace_back(name, value);
+    dict->names_[dict->entries_.back().name].push_back(i + 1);
+  }
+  VLOG(4) << "loaded seed dictionary " << path << " fingerprint="
+          << fingerprint << " entries=" << count;
+  return dict;
+}
+
+uint32_t SeedHeaderDictionary::getIndex(const HPACKHeader& header) const {
+  auto it = names_.find(header.name);
+  if (it == names_.end()) {
+    return 0;
+  }
+  for (auto index : it->second) {
+    if (entries_[index - 1].value == header.value) {
+      return index;
+    }
+  }
+  return 0;
+}
+
+uint32_t SeedHeaderDictionary::nameIndex(const HPACKHeaderName& name) const {
+  auto it = names_.find(name);
+  return it == names_.end() ? 0 : it->second.front();
+}
+
+} // namespace proxygen
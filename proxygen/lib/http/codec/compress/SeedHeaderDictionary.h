@@ -0,0 +1,84 @@
+/*
+ *  Copyright (c) 2015-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#pragma once
+
+#include <memory>
+#include <proxygen/lib/http/codec/compress/HPACKHeader.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace proxygen {
+
+/**
+ * A pre-agreed extension of the HPACK static table, generated offline
+ * from fleet header statistics.  The RFC static table is tuned for
+ * browser traffic; internal service-to-service headers compress poorly
+ * against it.  Both peers load the same artifact and negotiate its use
+ * via SETTINGS (see SettingsId::HEADER_SEED_DICTIONARY); entries are
+ * addressed in a disjoint high index range so enabling the dictionary
+ * never re-maps dynamic table indexes mid-connection.
+ *
+ * Artifact layout (little-endian, produced by the offline generator):
+ *
+ *   u32 magic 0x50584844 ('PXHD')
+ *   u32 version (currently 1)
+ *   u32 fingerprint - identifies the generation; exchanged in SETTINGS
+ *   u32 entry count
+ *   repeated { u16 nameLen, u16 valueLen, name bytes, value bytes }
+ *
+ * The file is mmap'd read-only while parsing so concurrent loaders
+ * share page cache; lookup structures are materialized in memory since
+ * the table is consulted on every header.  Instances are immutable
+ * after load and shared across all sessions of a worker.
+ */
+class SeedHeaderDictionary {
+ public:
+  /**
+   * Load an artifact; returns nullptr and logs on any parse or I/O
+   * error so a bad push of the artifact degrades to RFC-only
+   * compression instead of taking the process down.
+   */
+  static std::shared_ptr<const SeedHeaderDictionary> fromFile(
+      const std::string& path);
+
+  uint32_t getFingerprint() const {
+    return fingerprint_;
+  }
+
+  uint32_t size() const {
+    return entries_.size();
+  }
+
+  bool isValid(uint32_t index) const {
+    return index > 0 && index <= entries_.size();
+  }
+
+  /** Entry at 1-based index; index must be valid */
+  const HPACKHeader& getHeader(uint32_t index) const {
+    return entries_[index - 1];
+  }
+
+  /** 1-based index of an exact name/value match, or 0 */
+  uint32_t getIndex(const HPACKHeader& header) const;
+
+  /** 1-based index of the first entry with the given name, or 0 */
+  uint32_t nameIndex(const HPACKHeaderName& name) const;
+
+ private:
+  SeedHeaderDictionary() = default;
+
+  uint32_t fingerprint_{0};
+  std::vector<HPACKHeader> entries_;
+  // Same shape as HeaderTable::names_: per-name list of 1-based indexes
+  std::unordered_map<HPACKHeaderName, std::vector<uint32_t>> names_;
+};
+
+} // namespace proxygen
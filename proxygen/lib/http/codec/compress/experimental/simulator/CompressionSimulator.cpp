@@ -9,6 +9,7 @@
  */
 #include "proxygen/lib/http/codec/compress/experimental/simulator/CompressionSimulator.h"
 #include "proxygen/lib/http/codec/compress/experimental/simulator/CompressionUtils.h"
+#include "proxygen/lib/http/codec/compress/experimental/simulator/HeaderTrace.h"
 #include "proxygen/lib/http/codec/compress/experimental/simulator/HPACKScheme.h"
 #include "proxygen/lib/http/codec/compress/experimental/simulator/QPACKScheme.h"
 #include "proxygen/lib/http/codec/compress/experimental/simulator/QMINScheme.h"
@@ -17,6 +18,8 @@
 #include <proxygen/lib/utils/TestUtils.h>
 #include <proxygen/lib/utils/Time.h>
 
+#include <limits>
+
 using namespace std;
 using namespace folly;
 
@@ -68,6 +71,47 @@ bool CompressionSimulator::readInputFromFileAndSchedule(
   return true;
 }
 
+bool CompressionSimulator::readInputFromTraceAndSchedule(
+    const string& filename) {
+  std::vector<TraceRecord> records;
+  if (!HeaderTraceReader::readFromFile(filename, records) ||
+      records.empty()) {
+    return false;
+  }
+  // Request sequence numbers are 16 bits throughout the simulator
+  constexpr size_t kMaxRecords = std::numeric_limits<uint16_t>::max();
+  if (records.size() > kMaxRecords) {
+    LOG(WARNING) << "Trace has " << records.size()
+                 << " records; simulating the first " << kMaxRecords;
+    records.resize(kMaxRecords);
+  }
+  std::chrono::milliseconds last(0);
+  std::chrono::milliseconds cumulativeDelay(0);
+  uint16_t index = 0;
+  for (auto& record : records) {
+    auto delayFromPrevious = record.relativeTime - last;
+    // Shrink quiescent gaps, same as the HAR path
+    if (delayFromPrevious > std::chrono::milliseconds(1000)) {
+      delayFromPrevious = std::chrono::milliseconds(1000);
+    }
+    last = record.relativeTime;
+    cumulativeDelay += delayFromPrevious;
+    setupRequest(index++, std::move(record.message), cumulativeDelay);
+  }
+  for (auto& kv : domains_) {
+    flushRequests(kv.second.get());
+  }
+  return true;
+}
+
+uint32_t CompressionSimulator::getHolBlockCount() const {
+  uint32_t holBlockCount = 0;
+  for (const auto& scheme : domains_) {
+    holBlockCount += scheme.second->getHolBlockCount();
+  }
+  return holBlockCount;
+}
+
 void CompressionSimulator::run() {
 #ifndef HAVE_REAL_QMIN
   if (params_.type == SchemeType::QMIN) {
@@ -78,10 +122,7 @@ void CompressionSimulator::run() {
 
   LOG(INFO) << "Starting run";
   eventBase_.loop();
-  uint32_t holBlockCount = 0;
-  for (auto& scheme : domains_) {
-    holBlockCount += scheme.second->getHolBlockCount();
-  }
+  uint32_t holBlockCount = getHolBlockCount();
   LOG(INFO) << "Complete"
             << "\nStats:"
                "\nSeed: "
@@ -94,6 +135,8 @@ void CompressionSimulator::run() {
             << "\nMax Queue Buffer Bytes: " << stats_.maxQueueBufferBytes
             << "\nUncompressed Bytes: " << stats_.uncompressed
             << "\nCompressed Bytes: " << stats_.compressed
+            << "\nEncode CPU (us): " << stats_.encodeCpu.count()
+            << "\nDecode CPU (us): " << stats_.decodeCpu.count()
             << "\nCompression Ratio: "
             << int(100 - double(100 * stats_.compressed) / stats_.uncompressed);
 }
@@ -290,7 +333,10 @@ std::pair<FrameFlags, unique_ptr<IOBuf>> CompressionSimulator::encode(
       requests_[index], cookies);
 
   auto before = stats_.uncompressed;
+  auto start = std::chrono::steady_clock::now();
   auto res = scheme->encode(newPacket, std::move(allHeaders), stats_);
+  stats_.encodeCpu += std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::steady_clock::now() - start);
   VLOG(1) << "Encoded request=" << index << " for host="
           << requests_[index].getHeaders().getSingleOrEmpty(HTTP_HEADER_HOST)
           << " orig size=" << (stats_.uncompressed - before)
@@ -305,7 +351,10 @@ void CompressionSimulator::decode(CompressionScheme* scheme,
                                   FrameFlags flags,
                                   unique_ptr<IOBuf> encodedReq,
                                   SimStreamingCallback& cb) {
+  auto start = std::chrono::steady_clock::now();
   scheme->decode(flags, std::move(encodedReq), stats_, cb);
+  stats_.decodeCpu += std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::steady_clock::now() - start);
 }
 
 void CompressionSimulator::decodePacket(
@@ -371,11 +420,17 @@ std::chrono::milliseconds CompressionSimulator::deliveryDelay() {
 }
 
 std::chrono::milliseconds CompressionSimulator::rtt() {
+  if (!params_.rttDistribution.empty()) {
+    // Each draw is an independent sample, so per-packet jitter follows
+    // the measured distribution
+    return params_.rttDistribution[Random::rand32(
+        uint32_t(params_.rttDistribution.size()), rng_)];
+  }
   return params_.rtt;
 }
 
 std::chrono::milliseconds CompressionSimulator::one_half_rtt() {
-  return params_.rtt / 2;
+  return rtt() / 2;
 }
 
 std::chrono::milliseconds CompressionSimulator::rxmitDelay() {
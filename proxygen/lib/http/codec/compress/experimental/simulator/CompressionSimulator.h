@@ -26,8 +26,23 @@ class CompressionSimulator {
   }
 
   bool readInputFromFileAndSchedule(const std::string& filename);
+
+  /**
+   * Like readInputFromFileAndSchedule, but for the compact binary trace
+   * format (see HeaderTrace.h).  The path is used as given rather than
+   * being resolved relative to the source directory, since traces are
+   * sampled from the fleet rather than checked in next to the code.
+   */
+  bool readInputFromTraceAndSchedule(const std::string& filename);
+
   void run();
 
+  const SimStats& getStats() const {
+    return stats_;
+  }
+
+  uint32_t getHolBlockCount() const;
+
   // Called from CompressionScheme::runLoopCallback
   void flushSchemePackets(CompressionScheme* scheme);
   void flushPacket(CompressionScheme* scheme);
@@ -10,6 +10,7 @@
 #pragma once
 
 #include <chrono>
+#include <vector>
 
 namespace proxygen { namespace compress {
 enum class SchemeType { QPACK, QMIN, HPACK };
@@ -37,6 +38,9 @@ struct SimParams {
   bool samePacketCompression;
   uint32_t tableSize;
   uint32_t maxBlocking;
+  // When non-empty, each packet draws its RTT uniformly from these
+  // measured samples instead of using the fixed rtt above
+  std::vector<std::chrono::milliseconds> rttDistribution;
 };
 
 struct SimStats {
@@ -47,5 +51,8 @@ struct SimStats {
   uint64_t uncompressed{0};
   uint64_t compressed{0};
   uint64_t packets{0};
+  // Wall time spent inside the scheme's encode/decode calls
+  std::chrono::microseconds encodeCpu{0};
+  std::chrono::microseconds decodeCpu{0};
 };
 }} // namespace proxygen::compress
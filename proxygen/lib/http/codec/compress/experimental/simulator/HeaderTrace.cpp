@@ -0,0 +1,156 @@
+/*
+ *  Copyright (c) 2015-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include "proxygen/lib/http/codec/compress/experimental/simulator/HeaderTrace.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+#include <folly/Varint.h>
+#include <folly/system/MemoryMapping.h>
+
+#include <proxygen/lib/utils/Time.h>
+
+using namespace std;
+using namespace folly;
+
+namespace {
+
+const uint8_t kMagic[4] = {'H', 'T', 'R', 'C'};
+const uint32_t kVersion = 1;
+
+void appendVarint(string& out, uint64_t val) {
+  uint8_t buf[folly::kMaxVarintLength64];
+  out.append(reinterpret_cast<char*>(buf), folly::encodeVarint(val, buf));
+}
+
+void appendString(string& out, folly::StringPiece s) {
+  appendVarint(out, s.size());
+  out.append(s.data(), s.size());
+}
+
+void appendU32(string& out, uint32_t val) {
+  for (int i = 0; i < 4; i++) {
+    out.push_back(char(val >> (8 * i)));
+  }
+}
+
+uint32_t readU32(ByteRange& range) {
+  if (range.size() < 4) {
+    throw std::runtime_error("trace header truncated");
+  }
+  uint32_t val = 0;
+  for (int i = 0; i < 4; i++) {
+    val |= uint32_t(range[i]) << (8 * i);
+  }
+  range.advance(4);
+  return val;
+}
+
+StringPiece readString(ByteRange& range) {
+  auto len = folly::decodeVarint(range);
+  if (len > range.size()) {
+    throw std::runtime_error("string extends past end of trace");
+  }
+  StringPiece s(reinterpret_cast<const char*>(range.data()), len);
+  range.advance(len);
+  return s;
+}
+
+} // namespace
+
+namespace proxygen { namespace compress {
+
+bool HeaderTraceWriter::writeToFile(const std::vector<HTTPMessage>& requests,
+                                    const std::string& filename) {
+  string out;
+  out.append(reinterpret_cast<const char*>(kMagic), sizeof(kMagic));
+  appendU32(out, kVersion);
+  appendU32(out, requests.size());
+  if (!requests.empty()) {
+    TimePoint last = requests.front().getStartTime();
+    for (const auto& msg : requests) {
+      auto delta = millisecondsBetween(msg.getStartTime(), last);
+      last = msg.getStartTime();
+      appendVarint(out, std::max<int64_t>(delta.count(), 0));
+      appendString(out, msg.getMethodString());
+      appendString(out, msg.getURL());
+      const auto& headers = msg.getHeaders();
+      appendVarint(out, headers.size());
+      headers.forEach([&out](const string& name, const string& value) {
+        appendString(out, name);
+        appendString(out, value);
+      });
+    }
+  }
+
+  std::ofstream file(filename, ios::binary | ios::trunc);
+  if (!file) {
+    LOG(ERROR) << "Cannot open " << filename << " for writing";
+    return false;
+  }
+  file.write(out.data(), out.size());
+  file.close();
+  if (!file) {
+    LOG(ERROR) << "Failed writing " << out.size() << " bytes to " << filename;
+    return false;
+  }
+  VLOG(1) << "Wrote " << requests.size() << " records (" << out.size()
+          << " bytes) to " << filename;
+  return true;
+}
+
+bool HeaderTraceReader::readFromFile(const std::string& filename,
+                                     std::vector<TraceRecord>& records) {
+  try {
+    folly::MemoryMapping mapping(filename.c_str());
+    ByteRange range = mapping.range();
+    if (range.size() < sizeof(kMagic) ||
+        memcmp(range.data(), kMagic, sizeof(kMagic)) != 0) {
+      LOG(ERROR) << filename << " is not a header trace";
+      return false;
+    }
+    range.advance(sizeof(kMagic));
+    auto version = readU32(range);
+    if (version != kVersion) {
+      LOG(ERROR) << filename << " has unsupported trace version " << version;
+      return false;
+    }
+    auto count = readU32(range);
+    records.clear();
+    records.reserve(count);
+    std::chrono::milliseconds relative(0);
+    for (uint32_t i = 0; i < count; i++) {
+      TraceRecord record;
+      relative += std::chrono::milliseconds(folly::decodeVarint(range));
+      record.relativeTime = relative;
+      record.message.setMethod(readString(range));
+      record.message.setURL(readString(range).str());
+      auto headerCount = folly::decodeVarint(range);
+      auto& headers = record.message.getHeaders();
+      for (uint64_t h = 0; h < headerCount; h++) {
+        auto name = readString(range);
+        headers.add(name, readString(range));
+      }
+      records.push_back(std::move(record));
+    }
+    if (!range.empty()) {
+      LOG(WARNING) << range.size() << " trailing bytes in " << filename;
+    }
+    return true;
+  } catch (const std::exception& ex) {
+    LOG(ERROR) << "Failed to read trace " << filename << ": "
+               << folly::exceptionStr(ex);
+    return false;
+  }
+}
+
+}} // namespace proxygen::compress
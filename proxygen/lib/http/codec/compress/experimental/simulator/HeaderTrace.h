@@ -0,0 +1,67 @@
+/*
+ *  Copyright (c) 2015-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#pragma once
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include <proxygen/lib/http/HTTPMessage.h>
+
+namespace proxygen { namespace compress {
+
+/**
+ * Compact binary header trace, for replaying sampled production requests
+ * through the simulator.  HAR is convenient for hand-captured sessions but
+ * a JSON parse of a multi-million-request fleet sample takes longer than
+ * the simulation; this format is read straight out of an mmap.
+ *
+ * Layout (all integers little-endian, varints in folly::Varint encoding):
+ *
+ *   u8[4]   magic "HTRC"
+ *   u32     version, currently 1
+ *   u32     record count
+ *   records, each:
+ *     varint  start-time delta from the previous record, in milliseconds
+ *     string  method
+ *     string  url
+ *     varint  header count
+ *     header count x (string name, string value)
+ *
+ *   string = varint length followed by that many raw bytes
+ */
+
+struct TraceRecord {
+  HTTPMessage message;
+  // Start time relative to the first record in the trace
+  std::chrono::milliseconds relativeTime{0};
+};
+
+class HeaderTraceReader {
+ public:
+  /**
+   * mmap filename and decode it into records.  Returns false and logs on
+   * a missing, truncated or mismatched file.
+   */
+  static bool readFromFile(const std::string& filename,
+                           std::vector<TraceRecord>& records);
+};
+
+class HeaderTraceWriter {
+ public:
+  /**
+   * Serialize requests, which must be sorted by start time, into
+   * filename.  Negative inter-request gaps are clamped to zero.
+   */
+  static bool writeToFile(const std::vector<HTTPMessage>& requests,
+                          const std::string& filename);
+};
+
+}} // namespace proxygen::compress
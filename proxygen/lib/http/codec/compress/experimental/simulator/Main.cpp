@@ -7,14 +7,37 @@
  *  of patent rights can be found in the PATENTS file in the same directory.
  *
  */
+#include <algorithm>
+#include <fstream>
+
+#include <folly/String.h>
 #include <folly/init/Init.h>
 #include <folly/portability/GFlags.h>
 
 #include "proxygen/lib/http/codec/compress/experimental/simulator/CompressionSimulator.h"
+#include "proxygen/lib/http/codec/compress/experimental/simulator/HeaderTrace.h"
 #include <proxygen/lib/http/codec/compress/HPACKEncoder.h>
 #include <proxygen/lib/http/codec/compress/HPACKHeader.h>
+#include <proxygen/lib/http/codec/compress/test/HTTPArchive.h>
 
 DEFINE_string(input, "", "File containing requests");
+DEFINE_string(input_trace,
+              "",
+              "Binary header trace (see HeaderTrace.h); takes precedence "
+              "over --input");
+DEFINE_string(convert_to_trace,
+              "",
+              "Convert the --input HAR into a binary trace at this path "
+              "and exit");
+DEFINE_string(rtt_dist,
+              "",
+              "File of measured RTT samples in ms, one per line; when set, "
+              "each packet draws its RTT from these instead of --rtt");
+DEFINE_string(sweep,
+              "",
+              "Comma-separated table_size:max_blocking pairs, e.g. "
+              "4096:100,8192:0; runs one simulation per pair with the same "
+              "seed and input and prints a RESULT line for each");
 DEFINE_string(scheme,
               "qpack",
               "Scheme: <qpack|qmin|hpack>");
@@ -42,11 +65,37 @@ int main(int argc, char* argv[]) {
     LOG(WARNING) << "Same packet compression no longer supported";
   }
 
-  if (FLAGS_input.empty()) {
+  if (FLAGS_input.empty() && FLAGS_input_trace.empty()) {
     LOG(ERROR) << "Must supply a filename";
     return 1;
   }
 
+  if (!FLAGS_convert_to_trace.empty()) {
+    if (FLAGS_input.empty()) {
+      LOG(ERROR) << "--convert_to_trace requires a --input HAR";
+      return 1;
+    }
+    std::unique_ptr<proxygen::HTTPArchive> har;
+    try {
+      har = proxygen::HTTPArchive::fromFile(FLAGS_input);
+    } catch (const std::exception& ex) {
+      LOG(ERROR) << folly::exceptionStr(ex);
+    }
+    if (!har || har->requests.empty()) {
+      LOG(ERROR) << "Cannot read requests from " << FLAGS_input;
+      return 1;
+    }
+    std::sort(har->requests.begin(),
+              har->requests.end(),
+              [](const proxygen::HTTPMessage& a, const proxygen::HTTPMessage& b) {
+                return a.getStartTime() < b.getStartTime();
+              });
+    return HeaderTraceWriter::writeToFile(har->requests,
+                                          FLAGS_convert_to_trace)
+               ? 0
+               : 1;
+  }
+
   SchemeType t = SchemeType::QPACK;
   if (FLAGS_scheme == "qpack") {
     LOG(INFO) << "Using QPACK";
@@ -77,10 +126,61 @@ int main(int argc, char* argv[]) {
               FLAGS_same_packet_compression,
               uint32_t(FLAGS_table_size),
               uint32_t(FLAGS_max_blocking)};
-  CompressionSimulator sim(p);
-  if (sim.readInputFromFileAndSchedule(FLAGS_input)) {
+
+  if (!FLAGS_rtt_dist.empty()) {
+    std::ifstream file(FLAGS_rtt_dist);
+    std::string line;
+    while (std::getline(file, line)) {
+      auto sample = folly::trimWhitespace(line);
+      if (sample.empty()) {
+        continue;
+      }
+      p.rttDistribution.emplace_back(folly::to<uint32_t>(sample));
+    }
+    if (p.rttDistribution.empty()) {
+      LOG(ERROR) << "No RTT samples in " << FLAGS_rtt_dist;
+      return 1;
+    }
+    LOG(INFO) << "Loaded " << p.rttDistribution.size() << " RTT samples";
+  }
+
+  auto runOne = [](const SimParams& params) {
+    CompressionSimulator sim(params);
+    bool scheduled = FLAGS_input_trace.empty()
+                         ? sim.readInputFromFileAndSchedule(FLAGS_input)
+                         : sim.readInputFromTraceAndSchedule(FLAGS_input_trace);
+    if (!scheduled) {
+      return false;
+    }
     sim.run();
+    // One greppable line per configuration, for sweeps
+    const auto& stats = sim.getStats();
+    LOG(INFO) << "RESULT scheme=" << FLAGS_scheme
+              << " table_size=" << params.tableSize
+              << " max_blocking=" << params.maxBlocking
+              << " uncompressed=" << stats.uncompressed
+              << " compressed=" << stats.compressed
+              << " encode_cpu_us=" << stats.encodeCpu.count()
+              << " decode_cpu_us=" << stats.decodeCpu.count()
+              << " hol_blocks=" << sim.getHolBlockCount()
+              << " hol_delay_ms=" << stats.holDelay.count();
+    return true;
+  };
+
+  if (FLAGS_sweep.empty()) {
+    return runOne(p) ? 0 : 1;
   }
 
+  std::vector<folly::StringPiece> combos;
+  folly::split(',', FLAGS_sweep, combos, true);
+  for (auto combo : combos) {
+    if (!folly::split(':', combo, p.tableSize, p.maxBlocking)) {
+      LOG(ERROR) << "Bad sweep entry: " << combo;
+      return 1;
+    }
+    if (!runOne(p)) {
+      return 1;
+    }
+  }
   return 0;
 }
@@ -127,6 +127,18 @@ TEST_F(HPACKBufferTests, EncodeHuffmanLiteral) {
   EXPECT_EQ(data_[11], 0x7f);
 }
 
+TEST_F(HPACKBufferTests, EncodeHuffmanSkippedWhenLarger) {
+  // \xFF huffman encodes to 26 bits apiece, so this would more than
+  // triple in size; the encoder must fall back to the plain layout
+  string literal("\xFF\xFF\xFF\xFF");
+  HPACKEncodeBuffer encoder(512, true);
+  uint32_t size = encoder.encodeLiteral(literal);
+  EXPECT_EQ(size, 5);
+  releaseData(encoder);
+  EXPECT_EQ(buf_->length(), 5);
+  EXPECT_EQ(data_[0], 4); // no huffman bit, plain length
+}
+
 TEST_F(HPACKBufferTests, EncodeHuffmanLiteralN) {
   string accept("accept-encoding");
   HPACKEncodeBuffer encoder(512, true);
@@ -307,6 +319,85 @@ TEST_F(HPACKBufferTests, DecodeHuffmanLiteralMultiBuffer) {
   EXPECT_EQ(literal.rfind("gzip"), literal.size() - 4);
 }
 
+TEST_F(HPACKBufferTests, DecodeHuffmanWorstCaseExpansion) {
+  // a literal made entirely of 5-bit codes hits the maximum 8/5
+  // expansion the decoder reserves for up front
+  folly::fbstring value(400, '0');
+  HPACKEncodeBuffer encoder(512, true);
+  encoder.encodeLiteral(folly::StringPiece(value.data(), value.size()));
+  releaseData(encoder);
+  resetDecoder();
+  folly::fbstring literal;
+  EXPECT_EQ(decoder_.decodeLiteral(literal), DecodeError::NONE);
+  EXPECT_EQ(literal, value);
+}
+
+TEST_F(HPACKBufferTests, DecodeHuffmanLiteralFragmented) {
+  // huffman literal scattered over many small buffers, splitting
+  // codewords at arbitrary bit positions
+  std::array<uint8_t, 3> gzip{0x9b, 0xd9, 0xab};
+  uint32_t size = 3 * 40;
+  releaseData();
+  uint32_t sizeLen = encoder_.encodeInteger(size, 128, 7);
+  releaseData();
+  auto head = IOBuf::create(sizeLen);
+  memcpy(head->writableData(), buf_->data(), sizeLen);
+  head->append(sizeLen);
+  for (uint32_t i = 0; i < size; i++) {
+    auto frag = IOBuf::create(1);
+    frag->writableData()[0] = gzip[i % 3];
+    frag->append(1);
+    head->prependChain(std::move(frag));
+  }
+  resetDecoder(head.get());
+  folly::fbstring literal;
+  EXPECT_EQ(decoder_.decodeLiteral(literal), DecodeError::NONE);
+  EXPECT_EQ(literal.size(), 4 * (size / 3));
+  EXPECT_EQ(literal.find("gzip"), 0);
+  EXPECT_EQ(literal.rfind("gzip"), literal.size() - 4);
+}
+
+TEST_F(HPACKBufferTests, DecodeLiteralArena) {
+  // plain and huffman literals decoded into a scratch arena come back as
+  // pieces of arena storage, with no per-literal allocation
+  StringArena arena;
+  decoder_.setScratchArena(&arena);
+
+  buf_ = IOBuf::create(128);
+  uint8_t* wdata = buf_->writableData();
+  buf_->append(5);
+  wdata[0] = 4; // plain literal, size 4
+  memcpy(wdata + 1, "gzip", 4);
+  resetDecoder();
+  folly::StringPiece piece;
+  EXPECT_EQ(decoder_.decodeLiteral(piece), DecodeError::NONE);
+  EXPECT_EQ(piece, "gzip");
+
+  // huffman-coded "gzip"
+  std::array<uint8_t, 3> gzip{0x9b, 0xd9, 0xab};
+  wdata[0] = 0x80 | 3;
+  memcpy(wdata + 1, gzip.data(), 3);
+  resetDecoder();
+  folly::StringPiece huffPiece;
+  EXPECT_EQ(decoder_.decodeLiteral(huffPiece), DecodeError::NONE);
+  EXPECT_EQ(huffPiece, "gzip");
+  // the first piece still points at valid arena storage
+  EXPECT_EQ(piece, "gzip");
+
+  // literal spanning two buffers in the chain
+  auto buf1 = IOBuf::create(8);
+  buf1->writableData()[0] = 6;
+  memcpy(buf1->writableData() + 1, "abc", 3);
+  buf1->append(4);
+  auto buf2 = IOBuf::create(8);
+  memcpy(buf2->writableData(), "def", 3);
+  buf2->append(3);
+  buf1->appendChain(std::move(buf2));
+  resetDecoder(buf1.get());
+  EXPECT_EQ(decoder_.decodeLiteral(piece), DecodeError::NONE);
+  EXPECT_EQ(piece, "abcdef");
+}
+
 TEST_F(HPACKBufferTests, DecodeHuffmanLiteralN) {
   // "gzip" fits perfectly in a 3 bytes block
   std::array<uint8_t, 3> gzip{0x9b, 0xd9, 0xab};
@@ -10,6 +10,7 @@
 #include <folly/Range.h>
 #include <folly/io/Cursor.h>
 #include <folly/io/IOBuf.h>
+#include <folly/io/IOBufQueue.h>
 #include <folly/portability/GTest.h>
 #include <glog/logging.h>
 #include <proxygen/lib/http/codec/compress/HPACKCodec.h>
@@ -69,6 +70,20 @@ uint64_t bufLen(const std::unique_ptr<IOBuf>& buf) {
   return 0;
 }
 
+// Feed the pending bytes to the fragment decoder the way a codec would,
+// retaining only what it didn't consume
+uint32_t feedFragment(HPACKCodec& codec,
+                      folly::IOBufQueue& pending,
+                      bool endOfBlock,
+                      TestStreamingCallback& cb) {
+  folly::IOBuf empty;
+  Cursor cursor(pending.front() ? pending.front() : &empty);
+  auto consumed = codec.decodeStreamingFragment(
+      cursor, pending.chainLength(), endOfBlock, &cb);
+  pending.trimStart(consumed);
+  return consumed;
+}
+
 } // namespace
 
 class HPACKCodecTests : public testing::Test {
@@ -85,6 +100,32 @@ TEST_F(HPACKCodecTests, Request) {
   }
 }
 
+TEST_F(HPACKCodecTests, StaticOnlyEncode) {
+  // Static-only blocks carry no connection compression state, so encoding
+  // the same headers twice yields identical bytes and either block decodes
+  // on a codec that never saw the other.
+  auto req1 = basicHeaders();
+  unique_ptr<IOBuf> first = client.encodeStaticOnly(req1);
+  auto req2 = basicHeaders();
+  unique_ptr<IOBuf> second = client.encodeStaticOnly(req2);
+  EXPECT_TRUE(folly::IOBufEqualTo()(*first, *second));
+
+  Cursor c1(first.get());
+  auto result = decode(server, c1, c1.totalLength());
+  EXPECT_TRUE(!result.hasError());
+  EXPECT_EQ(result->headers.size(), 12);
+
+  HPACKCodec fresh{TransportDirection::DOWNSTREAM};
+  Cursor c2(second.get());
+  auto result2 = decode(fresh, c2, c2.totalLength());
+  EXPECT_TRUE(!result2.hasError());
+  EXPECT_EQ(result2->headers.size(), 12);
+
+  // neither side accumulated dynamic table entries
+  EXPECT_EQ(client.getCompressionInfo().egress.headersStored_, 0);
+  EXPECT_EQ(server.getCompressionInfo().ingress.headersStored_, 0);
+}
+
 TEST_F(HPACKCodecTests, Response) {
   vector<vector<string>> headers = {{"content-length", "80"},
                                     {"content-encoding", "gzip"},
@@ -254,6 +295,88 @@ TEST_F(HPACKCodecTests, SizeLimitStats) {
   EXPECT_EQ(stats.tooLarge, 1);
 }
 
+/**
+ * a block split at every byte boundary decodes the same as a whole one;
+ * fields are delivered as soon as their last byte arrives and only a
+ * cut-off field stays pending
+ */
+TEST_F(HPACKCodecTests, StreamingFragments) {
+  auto req = basicHeaders();
+  unique_ptr<IOBuf> encoded = client.encode(req);
+  auto len = bufLen(encoded);
+  for (uint64_t split = 0; split <= len; split++) {
+    HPACKCodec decoder{TransportDirection::DOWNSTREAM};
+    TestStreamingCallback cb;
+    folly::IOBufQueue block{folly::IOBufQueue::cacheChainLength()};
+    folly::IOBufQueue pending{folly::IOBufQueue::cacheChainLength()};
+    block.append(encoded->clone());
+    if (split > 0) {
+      pending.append(block.split(split));
+    }
+    feedFragment(decoder, pending, false, cb);
+    EXPECT_FALSE(cb.hasError());
+    pending.append(block.move());
+    feedFragment(decoder, pending, true, cb);
+    EXPECT_FALSE(cb.hasError());
+    EXPECT_EQ(pending.chainLength(), 0);
+    EXPECT_EQ(cb.headers.size(), 12);
+  }
+}
+
+/**
+ * fragmented decode keeps the dynamic table consistent, so a later block
+ * full of index references still decodes when fed one byte at a time
+ */
+TEST_F(HPACKCodecTests, StreamingFragmentsTable) {
+  auto req1 = basicHeaders();
+  unique_ptr<IOBuf> first = client.encode(req1);
+  auto req2 = basicHeaders();
+  unique_ptr<IOBuf> second = client.encode(req2);
+
+  folly::IOBufQueue pending{folly::IOBufQueue::cacheChainLength()};
+  TestStreamingCallback cb1;
+  pending.append(first->clone());
+  feedFragment(server, pending, true, cb1);
+  EXPECT_FALSE(cb1.hasError());
+  EXPECT_EQ(cb1.headers.size(), 12);
+
+  TestStreamingCallback cb2;
+  auto len = bufLen(second);
+  Cursor bytes(second.get());
+  for (uint64_t i = 0; i < len; i++) {
+    uint8_t byte = bytes.read<uint8_t>();
+    pending.append(IOBuf::copyBuffer(&byte, 1));
+    feedFragment(server, pending, i == len - 1, cb2);
+    EXPECT_FALSE(cb2.hasError());
+  }
+  EXPECT_EQ(pending.chainLength(), 0);
+  EXPECT_EQ(cb2.headers.size(), 12);
+}
+
+/**
+ * the uncompressed size limit trips while fragments are still arriving,
+ * before the full block has been buffered
+ */
+TEST_F(HPACKCodecTests, StreamingFragmentsTooLarge) {
+  vector<vector<string>> headers;
+  for (int i = 0; i < 100; i++) {
+    vector<string> header = {"x-fb-debug", folly::to<string>(i)};
+    headers.push_back(header);
+  }
+  auto encHeaders = headersFromArray(headers);
+  unique_ptr<IOBuf> encoded = client.encode(encHeaders);
+  server.setMaxUncompressed(512);
+
+  folly::IOBufQueue block{folly::IOBufQueue::cacheChainLength()};
+  block.append(encoded->clone());
+  folly::IOBufQueue pending{folly::IOBufQueue::cacheChainLength()};
+  pending.append(block.split(block.chainLength() / 2));
+  TestStreamingCallback cb;
+  feedFragment(server, pending, false, cb);
+  EXPECT_TRUE(cb.hasError());
+  EXPECT_EQ(cb.error, HPACK::DecodeError::HEADERS_TOO_LARGE);
+}
+
 TEST_F(HPACKCodecTests, DefaultHeaderIndexingStrategy) {
   vector<Header> headers = basicHeaders();
   size_t headersIndexableSize = 4;
@@ -281,6 +404,36 @@ TEST_F(HPACKCodecTests, DefaultHeaderIndexingStrategy) {
             headersIndexableSize);
 }
 
+TEST_F(HPACKCodecTests, NeverIndexedMetadata) {
+  // Metadata headers bypass the indexing strategy and the dynamic table:
+  // nothing is stored regardless of how indexable the header looks, and
+  // the block leads with the never-index instruction (0001xxxx)
+  string name("trace-id");
+  string value1("4bf92f3577b34da6");
+  string value2("00f067aa0ba902b7");
+  vector<Header> block1{Header::makeHeaderForTest(name, value1)};
+  block1[0].neverIndex = true;
+  unique_ptr<IOBuf> first = client.encode(block1);
+  vector<Header> block2{Header::makeHeaderForTest(name, value2)};
+  block2[0].neverIndex = true;
+  unique_ptr<IOBuf> second = client.encode(block2);
+  EXPECT_EQ(client.getCompressionInfo().egress.headersStored_, 0);
+  EXPECT_EQ(first->data()[0] & 0xf0, 0x10);
+
+  Cursor c1(first.get());
+  auto result = decode(server, c1, c1.totalLength());
+  EXPECT_TRUE(!result.hasError());
+  EXPECT_EQ(result->headers.size(), 2);
+  EXPECT_EQ(result->headers[0].str, "trace-id");
+  EXPECT_EQ(result->headers[1].str, value1);
+
+  Cursor c2(second.get());
+  auto result2 = decode(server, c2, c2.totalLength());
+  EXPECT_TRUE(!result2.hasError());
+  EXPECT_EQ(result2->headers[1].str, value2);
+  EXPECT_EQ(server.getCompressionInfo().ingress.headersStored_, 0);
+}
+
 class HPACKQueueTests : public testing::TestWithParam<int> {
  public:
   HPACKQueueTests() : queue(std::make_unique<HPACKQueue>(server)) {
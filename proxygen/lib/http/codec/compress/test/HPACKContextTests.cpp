@@ -78,7 +78,7 @@ TEST_F(HPACKContextTests, StaticTable) {
 
 TEST_F(HPACKContextTests, StaticTableHeaderNamesAreCommon) {
   auto& table = StaticHeaderTable::get();
-  for (std::pair<HPACKHeaderName, std::list<uint32_t>> entry : table.names()) {
+  for (const auto& entry : table.names()) {
     EXPECT_TRUE(entry.first.isCommonHeader());
   }
 }
@@ -251,6 +251,30 @@ TEST_F(HPACKContextTests, DecodeErrors) {
   checkError(buf.get(), HPACK::DecodeError::INTEGER_OVERFLOW);
 }
 
+TEST_F(HPACKContextTests, EncoderIndexCacheInvalidation) {
+  HPACKEncoder encoder(true);
+  HPACKDecoder decoder;
+  vector<HPACKHeader> req;
+  req.push_back(HPACKHeader("x-fb-debug", "cache-me"));
+  // The first block inserts the pair, the second is served from the
+  // encoder's full-match index cache
+  for (int i = 0; i < 2; i++) {
+    unique_ptr<IOBuf> encoded = encoder.encode(req);
+    auto decoded = proxygen::hpack::decode(decoder, encoded.get());
+    EXPECT_EQ(*decoded, req);
+  }
+  // A new insert shifts every dynamic index, so the cached entry must be
+  // dropped rather than replayed
+  vector<HPACKHeader> req2;
+  req2.push_back(HPACKHeader("x-fb-random", "shift"));
+  unique_ptr<IOBuf> encoded = encoder.encode(req2);
+  auto decoded = proxygen::hpack::decode(decoder, encoded.get());
+  EXPECT_EQ(*decoded, req2);
+  encoded = encoder.encode(req);
+  decoded = proxygen::hpack::decode(decoder, encoded.get());
+  EXPECT_EQ(*decoded, req);
+}
+
 TEST_F(HPACKContextTests, ExcludeHeadersLargerThanTable) {
   HPACKEncoder encoder{true, 128};
   std::string longer = std::string(150, '.');
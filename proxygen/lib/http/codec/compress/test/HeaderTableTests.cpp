@@ -51,8 +51,8 @@ class HeaderTableTests : public testing::Test {
 };
 
 TEST_F(HeaderTableTests, IndexTranslation) {
-  // simple cases
-  length_ = 10;
+  // simple cases; lengths are always powers of two
+  length_ = 16;
   head_ = 5;
   xcheck(0, 6);
   xcheck(3, 3);
@@ -61,8 +61,8 @@ TEST_F(HeaderTableTests, IndexTranslation) {
   // wrap
   head_ = 1;
   xcheck(0, 2);
-  xcheck(8, 4);
-  xcheck(5, 7);
+  xcheck(8, 10);
+  xcheck(14, 4);
 }
 
 TEST_F(HeaderTableTests, Add) {
@@ -298,28 +298,31 @@ TEST_F(HeaderTableTests, IncreaseLengthOfFullTable) {
   HPACKHeader smallHeader("Accept", "All-Content");
 
   HeaderTable table(448);
-  CHECK_EQ(table.length(), 7);
+  CHECK_EQ(table.length(), 8);
 
   for (uint8_t count = 0; count < 3; count++) {
     table.add(largeHeader.copy());
     table.add(smallHeader.copy());
-  } // tail is at index 0
-  CHECK_EQ(table.length(), 7);
+  }
+  CHECK_EQ(table.length(), 8);
+
+  // Adding small headers evicts the large ones one at a time until the
+  // table holds eight small headers and the ring has wrapped
+  for (uint8_t count = 0; count < 7; count++) {
+    table.add(smallHeader.copy());
+  }
+  CHECK_EQ(table.length(), 8);
 
-  table.add(smallHeader.copy());
-  table.add(smallHeader.copy()); // tail is at index 1
   table.add(smallHeader.copy()); // resize on this add
-  EXPECT_EQ(table.length(), 11);
+  EXPECT_EQ(table.length(), 16);
 
   // Check table is correct after resize
-  CHECK_EQ(table.getHeader(1), smallHeader);
-  CHECK_EQ(table.getHeader(2), smallHeader);
-  CHECK_EQ(table.getHeader(3), smallHeader);
-  CHECK_EQ(table.getHeader(4), smallHeader);
-  CHECK_EQ(table.getHeader(5), largeHeader);
-  CHECK_EQ(table.getHeader(6), smallHeader);
-  CHECK_EQ(table.getHeader(7), largeHeader);
-  CHECK_EQ(table.getHeader(8), smallHeader);
+  EXPECT_EQ(table.size(), 9);
+  for (uint8_t i = 1; i <= 9; i++) {
+    CHECK_EQ(table.getHeader(i), smallHeader);
+  }
+  EXPECT_EQ(table.getIndex(smallHeader), 1);
+  EXPECT_EQ(table.getIndex(largeHeader), 0);
 }
 
 TEST_F(HeaderTableTests, SmallTable) {
@@ -0,0 +1,88 @@
+/*
+ *  Copyright (c) 2015-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include <folly/Benchmark.h>
+#include <folly/io/IOBufQueue.h>
+#include <proxygen/lib/http/codec/compress/Huffman.h>
+
+#include <vector>
+
+using namespace folly;
+using namespace proxygen::huffman;
+
+namespace {
+
+std::vector<fbstring> getLiterals() {
+  return {
+      "www.facebook.com",
+      "/graphql",
+      "gzip, deflate, br",
+      "en-US,en;q=0.8",
+      "Mozilla/5.0 (iPhone; CPU iPhone OS 7_0_4 like Mac OS X) "
+      "AppleWebKit/537.51.1 (KHTML, like Gecko) Mobile/11B554a",
+      "text/html,application/xhtml+xml,application/xml;q=0.9,"
+      "image/webp,*/*;q=0.8",
+  };
+}
+
+std::vector<std::pair<std::unique_ptr<IOBuf>, uint32_t>> getEncoded() {
+  std::vector<std::pair<std::unique_ptr<IOBuf>, uint32_t>> encoded;
+  for (const auto& literal : getLiterals()) {
+    IOBufQueue bufQueue;
+    io::QueueAppender appender(&bufQueue, 512);
+    appender.ensure(512);
+    uint32_t size = huffTree().encode(literal, appender);
+    encoded.emplace_back(bufQueue.move(), size);
+  }
+  return encoded;
+}
+
+} // anonymous namespace
+
+void decodeDfaBench(int iters) {
+  std::vector<std::pair<std::unique_ptr<IOBuf>, uint32_t>> encoded;
+  BENCHMARK_SUSPEND {
+    encoded = getEncoded();
+  }
+  for (int i = 0; i < iters; i++) {
+    for (const auto& pair : encoded) {
+      fbstring literal;
+      huffTree().decode(pair.first->data(), pair.second, literal);
+      doNotOptimizeAway(literal.size());
+    }
+  }
+}
+
+void decodeTreeWalkBench(int iters) {
+  std::vector<std::pair<std::unique_ptr<IOBuf>, uint32_t>> encoded;
+  BENCHMARK_SUSPEND {
+    encoded = getEncoded();
+  }
+  for (int i = 0; i < iters; i++) {
+    for (const auto& pair : encoded) {
+      fbstring literal;
+      huffTree().decodeTreeWalk(pair.first->data(), pair.second, literal);
+      doNotOptimizeAway(literal.size());
+    }
+  }
+}
+
+BENCHMARK(DfaDecode, iters) {
+  decodeDfaBench(iters);
+}
+
+BENCHMARK(TreeWalkDecode, iters) {
+  decodeTreeWalkBench(iters);
+}
+
+int main(int argc, char** argv) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  runBenchmarks();
+  return 0;
+}
@@ -164,6 +164,37 @@ TEST_F(HuffmanTests, UserAgent) {
   CHECK_EQ(user_agent, decoded);
 }
 
+TEST_F(HuffmanTests, DfaMatchesTreeWalk) {
+  // the DFA and the original tree walk must agree on valid streams
+  folly::fbstring literal;
+  for (uint32_t i = 0; i < 256; i++) {
+    literal.push_back(static_cast<char>(i));
+  }
+  IOBufQueue bufQueue;
+  QueueAppender appender(&bufQueue, 1024);
+  appender.ensure(1024);
+  uint32_t size = tree_.encode(literal, appender);
+
+  folly::fbstring viaDfa;
+  folly::fbstring viaTree;
+  EXPECT_TRUE(tree_.decode(bufQueue.front()->data(), size, viaDfa));
+  EXPECT_TRUE(tree_.decodeTreeWalk(bufQueue.front()->data(), size, viaTree));
+  EXPECT_EQ(literal, viaDfa);
+  EXPECT_EQ(viaDfa, viaTree);
+}
+
+TEST_F(HuffmanTests, DfaRejectsInvalidStreams) {
+  folly::fbstring literal;
+  // padding must be all ones; 'a' is 00011 so 0x08 pads with zeros
+  uint8_t badPadding[1] = {0x08};
+  EXPECT_FALSE(tree_.decode(badPadding, 1, literal));
+
+  // a stream containing the EOS code must be rejected
+  uint8_t eos[4] = {0xFF, 0xFF, 0xFF, 0xFF};
+  literal.clear();
+  EXPECT_FALSE(tree_.decode(eos, 4, literal));
+}
+
 /*
  * this test is verifying the CHECK for length at the end of huffman::encode()
  */
@@ -91,6 +91,28 @@ TEST_F(QPACKTests, TestSimple) {
   EXPECT_GT(server.getCompressionInfo().ingress.headersStored_, 0);
 }
 
+TEST_F(QPACKTests, TestNeverIndexedMetadata) {
+  // Metadata headers encode as never-indexed literals on the request
+  // stream only: no encoder stream output, no dynamic table entries and
+  // no references, so the block can never block the decoder
+  string name("trace-id");
+  string value("4bf92f3577b34da6");
+  vector<Header> req{Header::makeHeaderForTest(name, value)};
+  req[0].neverIndex = true;
+  auto encodeResult = client.encode(req, 1);
+  EXPECT_EQ(encodeResult.control.get(), nullptr);
+  EXPECT_EQ(client.getCompressionInfo().egress.headersStored_, 0);
+
+  TestStreamingCallback cb;
+  auto length = encodeResult.stream->computeChainDataLength();
+  server.decodeStreaming(1, std::move(encodeResult.stream), length, &cb);
+  headerAck(1);
+  auto result = cb.getResult();
+  EXPECT_TRUE(!result.hasError());
+  headersEq(req, result->headers);
+  EXPECT_EQ(server.getCompressionInfo().ingress.headersStored_, 0);
+}
+
 TEST_F(QPACKTests, TestAbsoluteIndex) {
   EXPECT_TRUE(client.setEncoderHeaderTableSize(4096));
   int flights = 10;
@@ -190,6 +212,61 @@ TEST_F(QPACKTests, TestWithQueue) {
   EXPECT_GT(server.getCompressionInfo().ingress.headersStored_, 0);
 }
 
+TEST_F(QPACKTests, TestBlockedStreamsBudget) {
+  EXPECT_TRUE(client.setEncoderHeaderTableSize(4096));
+  // With a zero budget, blocks may not reference unacknowledged entries, so
+  // they decode without the encoder stream
+  client.setBlockedStreamsBudget(0);
+  vector<Header> req = basicHeaders();
+  auto res1 = client.encode(req, 1);
+  ASSERT_NE(res1.control.get(), nullptr);
+  TestStreamingCallback cb1;
+  auto len1 = res1.stream->computeChainDataLength();
+  server.decodeStreaming(1, std::move(res1.stream), len1, &cb1);
+  EXPECT_EQ(server.getQueuedBytes(), 0);
+  auto result1 = cb1.getResult();
+  EXPECT_TRUE(!result1.hasError());
+  headersEq(req, result1->headers);
+
+  // Restore the negotiated limit; the same headers now produce a blocking
+  // reference to the still-unacknowledged entries
+  client.setBlockedStreamsBudget(folly::none);
+  auto res2 = client.encode(req, 2);
+  TestStreamingCallback cb2;
+  auto len2 = res2.stream->computeChainDataLength();
+  server.decodeStreaming(2, std::move(res2.stream), len2, &cb2);
+  EXPECT_GT(server.getQueuedBytes(), 0);
+  // Delivering the deferred encoder stream bytes unblocks the stream
+  EXPECT_EQ(server.decodeEncoderStream(std::move(res1.control)),
+            HPACK::DecodeError::NONE);
+  EXPECT_EQ(server.getQueuedBytes(), 0);
+  auto result2 = cb2.getResult();
+  EXPECT_TRUE(!result2.hasError());
+  headersEq(req, result2->headers);
+  headerAck(2);
+}
+
+TEST_F(QPACKTests, TestHolBlockDelayStats) {
+  EXPECT_TRUE(client.setEncoderHeaderTableSize(4096));
+  vector<Header> req = basicHeaders();
+  auto res = client.encode(req, 1);
+  ASSERT_NE(res.control.get(), nullptr);
+  TestStreamingCallback cb;
+  auto len = res.stream->computeChainDataLength();
+  // Withhold the encoder stream so the block queues
+  server.decodeStreaming(1, std::move(res.stream), len, &cb);
+  EXPECT_GT(server.getQueuedBytes(), 0);
+  EXPECT_EQ(server.decodeEncoderStream(std::move(res.control)),
+            HPACK::DecodeError::NONE);
+  auto result = cb.getResult();
+  EXPECT_TRUE(!result.hasError());
+  headersEq(req, result->headers);
+  auto info = server.getCompressionInfo();
+  EXPECT_EQ(info.ingress.holBlockCount_, 1);
+  EXPECT_GE(info.ingress.holBlockDelayUs_, info.ingress.maxHolBlockDelayUs_);
+  headerAck(1);
+}
+
 TEST_F(QPACKTests, HeaderCodecStats) {
   vector<vector<string>> headers = {
       {"Content-Length", "80"},
@@ -0,0 +1,158 @@
+/*
+ *  Copyright (c) 2015-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include <folly/FileUtil.h>
+#include <folly/experimental/TestUtil.h>
+#include <folly/io/Cursor.h>
+#include <folly/portability/GTest.h>
+#include <proxygen/lib/http/codec/compress/HPACKCodec.h>
+#include <proxygen/lib/http/codec/compress/SeedHeaderDictionary.h>
+#include <proxygen/lib/http/codec/compress/test/TestStreamingCallback.h>
+
+using namespace folly;
+using namespace proxygen;
+using proxygen::compress::Header;
+
+namespace {
+
+void appendLE32(std::string& out, uint32_t v) {
+  v = folly::Endian::little(v);
+  out.append(reinterpret_cast<const char*>(&v), sizeof(v));
+}
+
+void appendLE16(std::string& out, uint16_t v) {
+  v = folly::Endian::little(v);
+  out.append(reinterpret_cast<const char*>(&v), sizeof(v));
+}
+
+std::string buildArtifact(
+    uint32_t fingerprint,
+    const std::vector<std::pair<std::string, std::string>>& entries) {
+  std::string out;
+  appendLE32(out, 0x50584844); // 'PXHD'
+  appendLE32(out, 1);          // version
+  appendLE32(out, fingerprint);
+  appendLE32(out, entries.size());
+  for (const auto& entry : entries) {
+    appendLE16(out, entry.first.size());
+    appendLE16(out, entry.second.size());
+    out += entry.first;
+    out += entry.second;
+  }
+  return out;
+}
+
+std::shared_ptr<const SeedHeaderDictionary> writeAndLoad(
+    const folly::test::TemporaryFile& file, const std::string& artifact) {
+  CHECK(folly::writeFile(artifact, file.path().c_str()));
+  return SeedHeaderDictionary::fromFile(file.path().string());
+}
+
+} // namespace
+
+TEST(SeedHeaderDictionaryTests, LoadAndLookup) {
+  folly::test::TemporaryFile file;
+  auto dict = writeAndLoad(
+      file,
+      buildArtifact(0xabcd1234,
+                    {{"x-fb-service", "tupperware"},
+                     {"x-fb-service", "proxygen"},
+                     {"x-fb-region", "prn1"}}));
+  ASSERT_NE(dict, nullptr);
+  EXPECT_EQ(dict->getFingerprint(), 0xabcd1234);
+  EXPECT_EQ(dict->size(), 3);
+
+  HPACKHeader exact("x-fb-service", "proxygen");
+  EXPECT_EQ(dict->getIndex(exact), 2);
+  EXPECT_EQ(dict->nameIndex(exact.name), 1);
+  HPACKHeader miss("x-fb-service", "unknown");
+  EXPECT_EQ(dict->getIndex(miss), 0);
+  HPACKHeader nameMiss("x-unknown", "whatever");
+  EXPECT_EQ(dict->nameIndex(nameMiss.name), 0);
+  EXPECT_EQ(dict->getHeader(3).value, "prn1");
+  EXPECT_TRUE(dict->isValid(3));
+  EXPECT_FALSE(dict->isValid(4));
+  EXPECT_FALSE(dict->isValid(0));
+}
+
+TEST(SeedHeaderDictionaryTests, RejectsMalformed) {
+  folly::test::TemporaryFile file;
+  // Truncated mid-entry
+  auto artifact =
+      buildArtifact(1, {{"x-fb-service", "tupperware"}}).substr(0, 20);
+  EXPECT_EQ(writeAndLoad(file, artifact), nullptr);
+
+  folly::test::TemporaryFile badMagic;
+  auto bad = buildArtifact(1, {});
+  bad[0] = 'X';
+  EXPECT_EQ(writeAndLoad(badMagic, bad), nullptr);
+}
+
+TEST(SeedHeaderDictionaryTests, HPACKRoundTripThroughSeedIndexes) {
+  folly::test::TemporaryFile file;
+  auto dict = writeAndLoad(
+      file,
+      buildArtifact(7, {{"x-fb-service", "tupperware"},
+                        {"x-fb-trace-id", ""}}));
+  ASSERT_NE(dict, nullptr);
+
+  HPACKCodec client(TransportDirection::UPSTREAM);
+  HPACKCodec server(TransportDirection::DOWNSTREAM);
+  client.setEncoderSeedDictionary(dict);
+  server.setDecoderSeedDictionary(dict);
+
+  std::string svcName{"x-fb-service"};
+  std::string svcValue{"tupperware"};
+  std::string traceName{"x-fb-trace-id"};
+  std::string traceValue{"deadbeef"};
+  std::vector<Header> req;
+  req.push_back(Header::makeHeaderForTest(svcName, svcValue));
+  req.push_back(Header::makeHeaderForTest(traceName, traceValue));
+
+  auto exactOnly = client.encode(req);
+  // The exact match costs one 3-byte index instead of a literal
+  EXPECT_LT(exactOnly->computeChainDataLength(),
+            svcName.size() + svcValue.size() + traceValue.size());
+
+  TestStreamingCallback cb;
+  folly::io::Cursor cursor(exactOnly.get());
+  server.decodeStreaming(cursor, exactOnly->computeChainDataLength(), &cb);
+  ASSERT_FALSE(cb.hasError());
+  auto result = cb.getResult();
+  ASSERT_EQ(result->headers.size(), 4);
+  EXPECT_EQ(result->headers[0].str, "x-fb-service");
+  EXPECT_EQ(result->headers[1].str, "tupperware");
+  EXPECT_EQ(result->headers[2].str, "x-fb-trace-id");
+  EXPECT_EQ(result->headers[3].str, "deadbeef");
+}
+
+TEST(SeedHeaderDictionaryTests, SeedIndexInvalidWithoutDictionary) {
+  folly::test::TemporaryFile file;
+  auto dict =
+      writeAndLoad(file, buildArtifact(7, {{"x-fb-service", "tupperware"}}));
+  ASSERT_NE(dict, nullptr);
+
+  HPACKCodec client(TransportDirection::UPSTREAM);
+  HPACKCodec server(TransportDirection::DOWNSTREAM);
+  // Encoder armed but the decoder never was - e.g. a bug in settings
+  // negotiation; the seed index must decode as a clean error
+  client.setEncoderSeedDictionary(dict);
+
+  std::string name{"x-fb-service"};
+  std::string value{"tupperware"};
+  std::vector<Header> req;
+  req.push_back(Header::makeHeaderForTest(name, value));
+  auto encoded = client.encode(req);
+
+  TestStreamingCallback cb;
+  folly::io::Cursor cursor(encoded.get());
+  server.decodeStreaming(cursor, encoded->computeChainDataLength(), &cb);
+  EXPECT_TRUE(cb.hasError());
+  EXPECT_EQ(cb.error, HPACK::DecodeError::INVALID_INDEX);
+}
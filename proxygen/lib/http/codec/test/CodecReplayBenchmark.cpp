@@ -0,0 +1,248 @@
+/*
+ *  Copyright (c) 2015-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+
+/**
+ * Corpus replay benchmark for the ingress codecs.
+ *
+ * Replays recorded ingress traces - one file per connection, raw bytes as
+ * they came off the wire - through HTTP1xCodec and HTTP2Codec at full
+ * speed.  Point --h1_corpus / --h2_corpus at directories of trace files
+ * (the fuzzer corpora work as-is); without a corpus a small synthetic
+ * workload is generated so the binary always produces numbers.
+ *
+ * Besides the usual folly benchmark table, a summary is printed with
+ * parse throughput in MB/s and heap allocations per parsed message,
+ * counted by interposing malloc.  Wire this into CI next to
+ * compare_benchmarks.py to catch parse regressions per commit.
+ */
+
+#include <chrono>
+#include <dirent.h>
+#include <folly/Benchmark.h>
+#include <folly/FileUtil.h>
+#include <folly/io/IOBuf.h>
+#include <folly/io/IOBufQueue.h>
+#include <proxygen/lib/http/codec/HTTP1xCodec.h>
+#include <proxygen/lib/http/codec/HTTP2Codec.h>
+#include <vector>
+
+using namespace folly;
+using namespace proxygen;
+
+DEFINE_string(h1_corpus, "", "Directory of recorded HTTP/1.x ingress traces");
+DEFINE_string(h2_corpus, "", "Directory of recorded HTTP/2 ingress traces");
+
+// Allocation counting via malloc interposition.  glibc only; elsewhere
+// the summary reports throughput without allocation counts.
+#if defined(__GLIBC__)
+extern "C" void* __libc_malloc(size_t size);
+extern "C" void* __libc_calloc(size_t n, size_t size);
+extern "C" void* __libc_realloc(void* ptr, size_t size);
+
+static uint64_t gMallocCount = 0;
+
+extern "C" void* malloc(size_t size) {
+  gMallocCount++;
+  return __libc_malloc(size);
+}
+
+extern "C" void* calloc(size_t n, size_t size) {
+  gMallocCount++;
+  return __libc_calloc(n, size);
+}
+
+extern "C" void* realloc(void* ptr, size_t size) {
+  gMallocCount++;
+  return __libc_realloc(ptr, size);
+}
+
+static uint64_t mallocCount() {
+  return gMallocCount;
+}
+#else
+static uint64_t mallocCount() {
+  return 0;
+}
+#endif
+
+namespace {
+
+// Minimal counting callback; benchmarks cannot use the gtest-based
+// FakeHTTPCodecCallback from TestUtils.h
+class BenchCodecCallback : public HTTPCodec::Callback {
+ public:
+  void onMessageBegin(HTTPCodec::StreamID, HTTPMessage*) override {
+  }
+  void onHeadersComplete(HTTPCodec::StreamID,
+                         std::unique_ptr<HTTPMessage>) override {
+    headers++;
+  }
+  void onBody(HTTPCodec::StreamID,
+              std::unique_ptr<folly::IOBuf> chain,
+              uint16_t) override {
+    bodyBytes += chain->computeChainDataLength();
+  }
+  void onTrailersComplete(HTTPCodec::StreamID,
+                          std::unique_ptr<HTTPHeaders>) override {
+  }
+  void onMessageComplete(HTTPCodec::StreamID, bool) override {
+    complete++;
+  }
+  void onError(HTTPCodec::StreamID, const HTTPException&, bool) override {
+    errors++;
+  }
+
+  uint64_t headers{0};
+  uint64_t bodyBytes{0};
+  uint64_t complete{0};
+  uint64_t errors{0};
+};
+
+struct Corpus {
+  std::vector<std::unique_ptr<IOBuf>> traces;
+  uint64_t totalBytes{0};
+
+  void add(std::unique_ptr<IOBuf> trace) {
+    totalBytes += trace->computeChainDataLength();
+    traces.push_back(std::move(trace));
+  }
+};
+
+Corpus loadCorpus(const std::string& dir) {
+  Corpus corpus;
+  DIR* d = opendir(dir.c_str());
+  if (!d) {
+    LOG(FATAL) << "cannot open corpus directory " << dir;
+  }
+  while (struct dirent* ent = readdir(d)) {
+    if (ent->d_name[0] == '.') {
+      continue;
+    }
+    std::string contents;
+    const auto path = dir + "/" + ent->d_name;
+    if (!folly::readFile(path.c_str(), contents)) {
+      LOG(FATAL) << "cannot read trace " << path;
+    }
+    corpus.add(IOBuf::copyBuffer(contents));
+  }
+  closedir(d);
+  CHECK(!corpus.traces.empty()) << "empty corpus directory " << dir;
+  return corpus;
+}
+
+Corpus syntheticH1Corpus() {
+  Corpus corpus;
+  std::string conn;
+  for (int i = 0; i < 100; i++) {
+    conn +=
+        "GET /some/long/enough/path?with=a&query=string HTTP/1.1\r\n"
+        "Host: www.facebook.com\r\n"
+        "User-Agent: Mozilla/5.0 (Macintosh; Intel Mac OS X 10_12_6)\r\n"
+        "Accept-Encoding: gzip, deflate, br\r\n"
+        "Accept-Language: en-US,en;q=0.8\r\n"
+        "\r\n";
+  }
+  corpus.add(IOBuf::copyBuffer(conn));
+  return corpus;
+}
+
+Corpus syntheticH2Corpus() {
+  Corpus corpus;
+  HTTP2Codec egressCodec(TransportDirection::UPSTREAM);
+  IOBufQueue output(IOBufQueue::cacheChainLength());
+  egressCodec.generateConnectionPreface(output);
+  egressCodec.generateSettings(output);
+  HTTPMessage req;
+  req.setHTTPVersion(1, 1);
+  req.setURL("/some/long/enough/path?with=a&query=string");
+  req.setMethod("GET");
+  req.getHeaders().set("host", "www.facebook.com");
+  req.getHeaders().set("accept-encoding", "gzip, deflate, br");
+  for (int i = 0; i < 100; i++) {
+    auto id = egressCodec.createStream();
+    egressCodec.generateHeader(output, id, req, false);
+    egressCodec.generateBody(output,
+                             id,
+                             IOBuf::copyBuffer(std::string(512, 'x')),
+                             HTTPCodec::NoPadding,
+                             true /* eom */);
+  }
+  corpus.add(output.move());
+  return corpus;
+}
+
+// One full pass over the corpus: a fresh codec per trace, since each
+// trace is one connection's ingress
+template <typename CodecT>
+uint64_t replayPass(const Corpus& corpus) {
+  uint64_t messages = 0;
+  for (const auto& trace : corpus.traces) {
+    CodecT codec(TransportDirection::DOWNSTREAM);
+    BenchCodecCallback callback;
+    codec.setCallback(&callback);
+    codec.onIngress(*trace);
+    messages += callback.headers;
+  }
+  return messages;
+}
+
+Corpus gH1Corpus;
+Corpus gH2Corpus;
+
+/**
+ * Timed pass outside the folly benchmark loop, reporting the numbers CI
+ * tracks: parse throughput and allocations per message.
+ */
+template <typename CodecT>
+void printSummary(const char* name, const Corpus& corpus) {
+  constexpr uint32_t passes = 50;
+  const auto allocsBefore = mallocCount();
+  const auto start = std::chrono::steady_clock::now();
+  uint64_t messages = 0;
+  for (uint32_t i = 0; i < passes; i++) {
+    messages += replayPass<CodecT>(corpus);
+  }
+  const std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+  const auto allocs = mallocCount() - allocsBefore;
+  const double mbPerSec =
+      corpus.totalBytes * passes / elapsed.count() / (1024 * 1024);
+  printf("%s: %zu traces, %.1f MB/s, %.1f allocs/msg\n",
+         name,
+         corpus.traces.size(),
+         mbPerSec,
+         messages ? static_cast<double>(allocs) / messages : 0.0);
+}
+
+} // namespace
+
+BENCHMARK(h1CorpusReplay, iters) {
+  for (size_t i = 0; i < iters; i++) {
+    replayPass<HTTP1xCodec>(gH1Corpus);
+  }
+}
+
+BENCHMARK(h2CorpusReplay, iters) {
+  for (size_t i = 0; i < iters; i++) {
+    replayPass<HTTP2Codec>(gH2Corpus);
+  }
+}
+
+int main(int argc, char** argv) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  gH1Corpus = FLAGS_h1_corpus.empty() ? syntheticH1Corpus()
+                                      : loadCorpus(FLAGS_h1_corpus);
+  gH2Corpus = FLAGS_h2_corpus.empty() ? syntheticH2Corpus()
+                                      : loadCorpus(FLAGS_h2_corpus);
+  folly::runBenchmarks();
+  printSummary<HTTP1xCodec>("h1CorpusReplay", gH1Corpus);
+  printSummary<HTTP2Codec>("h2CorpusReplay", gH2Corpus);
+  return 0;
+}
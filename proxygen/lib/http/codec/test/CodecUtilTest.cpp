@@ -0,0 +1,114 @@
+/*
+ *  Copyright (c) 2015-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include <folly/portability/GTest.h>
+#include <proxygen/lib/http/codec/CodecUtil.h>
+
+using namespace proxygen;
+
+namespace {
+
+folly::ByteRange range(const std::string& s) {
+  return folly::ByteRange(folly::StringPiece(s));
+}
+
+// The predicate validateURL has always implemented, byte at a time
+bool validateURLScalar(const std::string& url) {
+  for (uint8_t p : url) {
+    if (p <= 0x20 || p == 0x7f) {
+      return false;
+    }
+  }
+  return true;
+}
+
+} // namespace
+
+// The vectorized scan must agree with the scalar predicate for a bad
+// byte at every offset, so block boundaries and the tail are all hit
+TEST(CodecUtil, ValidateURLMatchesScalarAtEveryOffset) {
+  for (size_t len : {0, 1, 15, 16, 17, 31, 32, 40}) {
+    std::string good(len, 'a');
+    EXPECT_EQ(CodecUtil::validateURL(range(good)), validateURLScalar(good))
+        << "len=" << len;
+    for (size_t pos = 0; pos < len; ++pos) {
+      for (char bad : {' ', '\x7f', '\0', '\r'}) {
+        std::string url = good;
+        url[pos] = bad;
+        EXPECT_FALSE(CodecUtil::validateURL(range(url)))
+            << "len=" << len << " pos=" << pos;
+      }
+    }
+  }
+}
+
+TEST(CodecUtil, ValidateHeaderValuePlainText) {
+  // Long plain values ride the fast path end to end; spaces and tabs
+  // are ordinary TEXT
+  std::string value(100, 'x');
+  value[40] = ' ';
+  value[41] = '\t';
+  EXPECT_TRUE(CodecUtil::validateHeaderValue(range(value),
+                                             CodecUtil::STRICT));
+  EXPECT_TRUE(CodecUtil::validateHeaderValue(range(value),
+                                             CodecUtil::COMPLIANT));
+
+  // A ctl or DEL deep inside a long value is still caught
+  for (size_t pos : {0, 15, 16, 50, 99}) {
+    std::string bad = value;
+    bad[pos] = '\x01';
+    EXPECT_FALSE(CodecUtil::validateHeaderValue(range(bad),
+                                                CodecUtil::STRICT));
+    bad[pos] = '\x7f';
+    EXPECT_FALSE(CodecUtil::validateHeaderValue(range(bad),
+                                                CodecUtil::COMPLIANT));
+  }
+}
+
+TEST(CodecUtil, ValidateHeaderValueLws) {
+  // \r\n followed by whitespace is legal line folding, with or without
+  // surrounding padding that keeps it off a 16 byte boundary
+  for (const std::string& pad : {std::string(), std::string(20, 'p')}) {
+    std::string folded = pad + "field one\r\n field two" + pad;
+    EXPECT_TRUE(CodecUtil::validateHeaderValue(range(folded),
+                                               CodecUtil::STRICT));
+    std::string danglingCr = pad + "field one\r";
+    EXPECT_FALSE(CodecUtil::validateHeaderValue(range(danglingCr),
+                                                CodecUtil::STRICT));
+    std::string bareLf = pad + "field one\rX";
+    EXPECT_FALSE(CodecUtil::validateHeaderValue(range(bareLf),
+                                                CodecUtil::STRICT));
+  }
+  // Trailing LWS (value ends right after \r\n + WS) is accepted
+  std::string trailing = "value\r\n ";
+  EXPECT_TRUE(CodecUtil::validateHeaderValue(range(trailing),
+                                             CodecUtil::STRICT));
+}
+
+TEST(CodecUtil, ValidateHeaderValueQuotedEscapes) {
+  // An escaped CTL inside quotes is only legal in COMPLIANT mode
+  std::string escaped = "a \"quoted \\\x01 ctl\" tail";
+  EXPECT_TRUE(CodecUtil::validateHeaderValue(range(escaped),
+                                             CodecUtil::COMPLIANT));
+  EXPECT_FALSE(CodecUtil::validateHeaderValue(range(escaped),
+                                              CodecUtil::STRICT));
+
+  // Unterminated quote is TEXT; unterminated escape is not
+  std::string openQuote = "a \"quoted value";
+  EXPECT_TRUE(CodecUtil::validateHeaderValue(range(openQuote),
+                                             CodecUtil::COMPLIANT));
+  std::string danglingEscape = "a \"quoted\\";
+  EXPECT_FALSE(CodecUtil::validateHeaderValue(range(danglingEscape),
+                                              CodecUtil::COMPLIANT));
+
+  // Backslash outside quotes is ordinary TEXT
+  std::string plainBackslash = "c:\\temp\\file";
+  EXPECT_TRUE(CodecUtil::validateHeaderValue(range(plainBackslash),
+                                             CodecUtil::STRICT));
+}
@@ -12,10 +12,13 @@
 #include <proxygen/lib/http/HTTPHeaderSize.h>
 #include <proxygen/lib/http/HTTPMessage.h>
 #include <proxygen/lib/http/codec/FlowControlFilter.h>
+#include <proxygen/lib/http/codec/FrameCaptureFilter.h>
+#include <proxygen/lib/http/codec/HTTP2Framer.h>
 #include <proxygen/lib/http/codec/HTTPChecks.h>
 #include <proxygen/lib/http/codec/test/MockHTTPCodec.h>
 #include <proxygen/lib/http/codec/test/TestUtils.h>
 #include <random>
+#include <sstream>
 
 using namespace proxygen;
 using namespace std;
@@ -56,6 +59,20 @@ class HTTPChecksTest: public FilterTest {
   }
 };
 
+class FusedChecksTest: public FilterTest {
+ public:
+  void SetUp() override {
+    EXPECT_CALL(*codec_, getDefaultWindowSize())
+      .WillRepeatedly(Return(kInitialCapacity));
+
+    filter_ = new HTTPChecksFilter<FlowControlFilter>(
+        flowCallback_, writeBuf_, codec_);
+    chain_.addFilters(std::unique_ptr<FlowControlFilter>(filter_));
+  }
+  StrictMock<MockFlowControlCallback> flowCallback_;
+  FlowControlFilter* filter_;
+};
+
 template <int initSize>
 class FlowControlFilterTest: public FilterTest {
  public:
@@ -151,6 +168,44 @@ TEST_F(DefaultFlowControl, SendUpdate) {
   filter_->ingressBytesProcessed(writeBuf_, 1);
 }
 
+TEST_F(DefaultFlowControl, AutoTuneWindow) {
+  // With auto-tuning enabled and acks arriving well within two RTTs, each
+  // bulk window update doubles the receive window until the cap is reached
+  InSequence enforceSequence;
+  EXPECT_CALL(callback_, onBody(_, _, _))
+    .WillRepeatedly(Return());
+  filter_->enableAutoTuning(kInitialCapacity * 4);
+  filter_->onRttSample(std::chrono::hours(1));
+
+  // The first update just starts the pacing clock, no growth
+  callbackStart_->onBody(1, makeBuf(kInitialCapacity / 2 + 1), 0);
+  EXPECT_CALL(*codec_, generateWindowUpdate(_, 0, kInitialCapacity / 2 + 1));
+  filter_->ingressBytesProcessed(writeBuf_, kInitialCapacity / 2 + 1);
+
+  // The second update comes in under two RTTs, so the window doubles and
+  // the extra capacity rides along with the ack
+  callbackStart_->onBody(1, makeBuf(kInitialCapacity / 2 + 1), 0);
+  EXPECT_CALL(*codec_,
+              generateWindowUpdate(_, 0,
+                                   kInitialCapacity / 2 + 1 +
+                                   kInitialCapacity));
+  filter_->ingressBytesProcessed(writeBuf_, kInitialCapacity / 2 + 1);
+
+  // Doubling again would exceed the cap, so growth stops right at it.
+  // Note the ack threshold has scaled with the window
+  callbackStart_->onBody(1, makeBuf(kInitialCapacity + 1), 0);
+  EXPECT_CALL(*codec_,
+              generateWindowUpdate(_, 0,
+                                   kInitialCapacity + 1 +
+                                   kInitialCapacity * 2));
+  filter_->ingressBytesProcessed(writeBuf_, kInitialCapacity + 1);
+
+  // At the cap the updates go back to plain acks
+  callbackStart_->onBody(1, makeBuf(kInitialCapacity * 2 + 1), 0);
+  EXPECT_CALL(*codec_, generateWindowUpdate(_, 0, kInitialCapacity * 2 + 1));
+  filter_->ingressBytesProcessed(writeBuf_, kInitialCapacity * 2 + 1);
+}
+
 TEST_F(BigWindow, RecvTooMuch) {
   // Constructing the filter with a large capacity causes a WINDOW_UPDATE
   // for stream zero to be generated
@@ -212,6 +267,74 @@ TEST_F(BigWindow, RemoteIncrease) {
   ASSERT_FALSE(chain_->isReusable());
 }
 
+TEST_F(DefaultFlowControl, BatchedWindowUpdates) {
+  filter_->enableUpdateBatching(1000);
+
+  // Stream-level updates accumulate instead of each writing a frame
+  EXPECT_EQ(0, chain_->generateWindowUpdate(writeBuf_, 1, 500));
+  EXPECT_EQ(0, chain_->generateWindowUpdate(writeBuf_, 1, 1700));
+  EXPECT_EQ(0, chain_->generateWindowUpdate(writeBuf_, 3, 999));
+  EXPECT_TRUE(filter_->hasPendingWindowUpdates());
+
+  // A conn-level ack past the threshold merges into the same batch
+  EXPECT_CALL(callback_, onBody(_, _, _));
+  callbackStart_->onBody(1, makeBuf(kInitialCapacity / 2 + 10), 0);
+  EXPECT_TRUE(
+      filter_->ingressBytesProcessed(writeBuf_, kInitialCapacity / 2 + 1));
+
+  // One flush: the conn update goes first, then stream 1's quantized
+  // total; stream 3 is still below the quantum so its bytes stay pending
+  InSequence enforceSequence;
+  EXPECT_CALL(*codec_, generateWindowUpdate(_, 0, 6000)).WillOnce(Return(9));
+  EXPECT_CALL(*codec_, generateWindowUpdate(_, 1, 2000)).WillOnce(Return(9));
+  filter_->flushWindowUpdates(writeBuf_);
+
+  // Sub-quantum remainders ride along with the next flush
+  EXPECT_EQ(0, chain_->generateWindowUpdate(writeBuf_, 3, 1));
+  EXPECT_CALL(*codec_, generateWindowUpdate(_, 3, 1000)).WillOnce(Return(9));
+  filter_->flushWindowUpdates(writeBuf_);
+}
+
+TEST_F(DefaultFlowControl, BatchedRecvAccounting) {
+  // Ingress reservations accumulate as one pending delta and settle at
+  // ack time; the strict capacity check still fires on exactly the
+  // overflowing frame
+  InSequence enforceSequence;
+  EXPECT_CALL(callback_, onBody(_, _, _)).Times(13);
+  for (int i = 0; i < 12; i++) {
+    callbackStart_->onBody(1, makeBuf(1000), 0);
+  }
+  callbackStart_->onBody(1, makeBuf(kInitialCapacity - 12000), 0);
+  ASSERT_TRUE(chain_->isReusable());
+
+  // One byte past the (entirely un-settled) window is still an error
+  EXPECT_CALL(callback_, onError(0, IsFlowException(), _))
+      .WillOnce(Invoke([](HTTPCodec::StreamID,
+                          std::shared_ptr<HTTPException> exc,
+                          bool /*newTxn*/) {
+        ASSERT_EQ(
+            "Failed to reserve receive window, window size=0, "
+            "amount=1",
+            std::string(exc->what()));
+      }));
+  callbackStart_->onBody(1, makeBuf(1), 0);
+  ASSERT_FALSE(chain_->isReusable());
+}
+
+TEST_F(DefaultFlowControl, BatchedRecvSettlesOnAck) {
+  // After the settle-and-ack, the window opens again for a full round
+  InSequence enforceSequence;
+  EXPECT_CALL(callback_, onBody(_, _, _)).Times(2);
+  callbackStart_->onBody(1, makeBuf(kInitialCapacity), 0);
+
+  EXPECT_CALL(*codec_, generateWindowUpdate(_, 0, kInitialCapacity))
+      .WillOnce(Return(9));
+  EXPECT_TRUE(filter_->ingressBytesProcessed(writeBuf_, kInitialCapacity));
+
+  callbackStart_->onBody(1, makeBuf(kInitialCapacity), 0);
+  ASSERT_TRUE(chain_->isReusable());
+}
+
 TEST_F(HTTPChecksTest, SendTraceBodyDeath) {
   // It is NOT allowed to send a TRACE with a body.
 
@@ -252,3 +375,86 @@ TEST_F(HTTPChecksTest, RecvTraceBody) {
 
   callbackStart_->onHeadersComplete(0, std::move(msg));
 }
+
+TEST_F(FusedChecksTest, RecvTraceBody) {
+  // The checks still run when fused into the flow control filter
+
+  EXPECT_CALL(callback_, onError(_, _, _))
+    .WillOnce(Invoke([] (HTTPCodec::StreamID,
+                         std::shared_ptr<HTTPException> exc,
+                         bool newTxn) {
+                       ASSERT_TRUE(newTxn);
+                       ASSERT_EQ(exc->getHttpStatusCode(), 400);
+        }));
+
+  auto msg = makePostRequest();
+  msg->setMethod("TRACE");
+
+  callbackStart_->onHeadersComplete(0, std::move(msg));
+}
+
+TEST_F(FusedChecksTest, SingleNodeFlowControl) {
+  // The fused filter still does conn-level flow control accounting
+
+  EXPECT_CALL(callback_, onBody(_, _, _));
+  callbackStart_->onBody(1, makeBuf(kInitialCapacity / 2 + 10), 0);
+
+  EXPECT_CALL(*codec_, generateWindowUpdate(_, 0, _))
+    .WillOnce(Return(10));
+  // Ack enough bytes to cross the half-window threshold
+  EXPECT_TRUE(
+      filter_->ingressBytesProcessed(writeBuf_, kInitialCapacity / 2 + 1));
+}
+
+class FrameCaptureFilterTest: public FilterTest {
+ public:
+  void SetUp() override {
+    EXPECT_CALL(*codec_, getProtocol())
+      .WillRepeatedly(Return(CodecProtocol::HTTP_2));
+
+    filter_ = new FrameCaptureFilter();
+    chain_.addFilters(std::unique_ptr<FrameCaptureFilter>(filter_));
+  }
+  FrameCaptureFilter* filter_;
+};
+
+TEST_F(FrameCaptureFilterTest, CapturesFrameHeaders) {
+  EXPECT_CALL(callback_, onFrameHeader(_, _, _, _, _)).Times(2);
+
+  callbackStart_->onFrameHeader(
+      1, 0x4, 100, uint64_t(http2::FrameType::HEADERS));
+  callbackStart_->onFrameHeader(1, 0, 200, uint64_t(http2::FrameType::DATA));
+
+  EXPECT_EQ(filter_->getNumCaptured(), 2);
+  std::ostringstream history;
+  filter_->dumpHistory(history);
+  EXPECT_NE(history.str().find("HEADERS"), std::string::npos);
+  EXPECT_NE(history.str().find("DATA"), std::string::npos);
+}
+
+TEST_F(FrameCaptureFilterTest, RingSaturatesAtCapacity) {
+  EXPECT_CALL(callback_, onFrameHeader(_, _, _, _, _))
+    .Times(FrameCaptureFilter::kCapacity + 10);
+
+  for (size_t i = 0; i < FrameCaptureFilter::kCapacity + 10; i++) {
+    callbackStart_->onFrameHeader(
+        1, 0, i, uint64_t(http2::FrameType::DATA));
+  }
+
+  EXPECT_EQ(filter_->getNumCaptured(), FrameCaptureFilter::kCapacity);
+  // Only the newest kCapacity frames survive
+  std::ostringstream history;
+  filter_->dumpHistory(history);
+  EXPECT_EQ(history.str().find("length=5 "), std::string::npos);
+  EXPECT_NE(history.str().find("length=10"), std::string::npos);
+}
+
+TEST_F(FrameCaptureFilterTest, SessionErrorForwarded) {
+  EXPECT_CALL(callback_, onFrameHeader(_, _, _, _, _));
+  EXPECT_CALL(callback_, onError(0, _, _));
+
+  callbackStart_->onFrameHeader(
+      3, 0, 17, uint64_t(http2::FrameType::WINDOW_UPDATE));
+  HTTPException ex(HTTPException::Direction::INGRESS, "bad frame");
+  callbackStart_->onError(0, ex, false);
+}
@@ -208,6 +208,20 @@ TEST_F(HQCodecTest, DataFrame) {
   EXPECT_EQ(callbacks_.bodyLength, data->length());
 }
 
+TEST_F(HQCodecTest, DataFrameZeroCopy) {
+  auto data = makeBuf(500);
+  writeFrameHeaderManual(
+      queue_, static_cast<uint64_t>(FrameType::DATA), data->length());
+  queue_.append(data->clone());
+  parse();
+  EXPECT_EQ(callbacks_.bodyCalls, 1);
+  EXPECT_EQ(callbacks_.bodyLength, data->length());
+  // The body delivered to the callback is a refcounted slice of the
+  // ingress chain, not a copy
+  ASSERT_FALSE(callbacks_.data.empty());
+  EXPECT_EQ(callbacks_.data.front()->data(), data->data());
+}
+
 TEST_F(HQPRCodecTest, DataFrameZeroLength) {
   const auto& ingressPrBodyTracker =
       downstreamCodec_->getIngressPrBodyTracker();
@@ -0,0 +1,141 @@
+/*
+ *  Copyright (c) 2015-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include <folly/Benchmark.h>
+#include <folly/io/IOBuf.h>
+#include <proxygen/lib/http/codec/HTTP1xCodec.h>
+
+using namespace folly;
+using namespace proxygen;
+
+namespace {
+
+// Minimal counting callback; benchmarks cannot use the gtest-based
+// FakeHTTPCodecCallback from TestUtils.h
+class BenchCodecCallback : public HTTPCodec::Callback {
+ public:
+  void onMessageBegin(HTTPCodec::StreamID, HTTPMessage*) override {
+    messages++;
+  }
+  void onHeadersComplete(HTTPCodec::StreamID,
+                         std::unique_ptr<HTTPMessage>) override {
+    headers++;
+  }
+  void onBody(HTTPCodec::StreamID,
+              std::unique_ptr<folly::IOBuf> chain,
+              uint16_t) override {
+    bodyBytes += chain->computeChainDataLength();
+  }
+  void onTrailersComplete(HTTPCodec::StreamID,
+                          std::unique_ptr<HTTPHeaders>) override {
+  }
+  void onMessageComplete(HTTPCodec::StreamID, bool) override {
+    complete++;
+  }
+  void onError(HTTPCodec::StreamID,
+               const HTTPException&,
+               bool) override {
+    errors++;
+  }
+
+  uint64_t messages{0};
+  uint64_t headers{0};
+  uint64_t bodyBytes{0};
+  uint64_t complete{0};
+  uint64_t errors{0};
+};
+
+std::unique_ptr<IOBuf> buildRequestBatch(size_t count) {
+  std::string batch;
+  for (size_t i = 0; i < count; i++) {
+    batch +=
+        "GET /some/long/enough/path?with=a&query=string HTTP/1.1\r\n"
+        "Host: www.facebook.com\r\n"
+        "User-Agent: Mozilla/5.0 (Macintosh; Intel Mac OS X 10_12_6) "
+        "AppleWebKit/537.36 (KHTML, like Gecko) Chrome/60.0.3100.0 "
+        "Safari/537.36\r\n"
+        "Accept-Encoding: gzip, deflate, br\r\n"
+        "Accept-Language: en-US,en;q=0.8\r\n"
+        "Cookie: session=deadbeefdeadbeefdeadbeef; tracking=0123456789\r\n"
+        "\r\n";
+  }
+  return IOBuf::copyBuffer(batch);
+}
+
+std::unique_ptr<IOBuf> buildResponseBatch(size_t count) {
+  std::string body(4096, 'x');
+  std::string batch;
+  for (size_t i = 0; i < count; i++) {
+    batch +=
+        "HTTP/1.1 200 OK\r\n"
+        "Date: Mon, 01 Jan 2019 00:00:00 GMT\r\n"
+        "Content-Type: text/html; charset=utf-8\r\n"
+        "Content-Length: 4096\r\n"
+        "\r\n" +
+        body;
+  }
+  return IOBuf::copyBuffer(batch);
+}
+
+void parseRequests(size_t iters, size_t batchSize) {
+  BenchmarkSuspender susp;
+  auto buf = buildRequestBatch(batchSize);
+  for (size_t i = 0; i < iters; i++) {
+    HTTP1xCodec codec(TransportDirection::DOWNSTREAM);
+    BenchCodecCallback callback;
+    codec.setCallback(&callback);
+    susp.dismiss();
+    codec.onIngress(*buf);
+    susp.rehire();
+    CHECK_EQ(callback.complete, batchSize);
+    CHECK_EQ(callback.errors, 0);
+  }
+}
+
+void parseResponses(size_t iters, size_t batchSize) {
+  BenchmarkSuspender susp;
+  auto buf = buildResponseBatch(batchSize);
+  for (size_t i = 0; i < iters; i++) {
+    HTTP1xCodec codec(TransportDirection::UPSTREAM);
+    BenchCodecCallback callback;
+    codec.setCallback(&callback);
+    susp.dismiss();
+    for (size_t j = 0; j < batchSize; j++) {
+      codec.createStream();
+    }
+    codec.onIngress(*buf);
+    susp.rehire();
+    CHECK_EQ(callback.headers, batchSize);
+    CHECK_EQ(callback.errors, 0);
+  }
+}
+
+} // namespace
+
+BENCHMARK(http1xOnIngressRequest1, iters) {
+  parseRequests(iters, 1);
+}
+
+BENCHMARK(http1xOnIngressRequest100, iters) {
+  parseRequests(iters, 100);
+}
+
+BENCHMARK(http1xOnIngressResponse1, iters) {
+  parseResponses(iters, 1);
+}
+
+BENCHMARK(http1xOnIngressResponse100, iters) {
+  parseResponses(iters, 100);
+}
+
+int main(int argc, char** argv) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  folly::runBenchmarks();
+  return 0;
+}
@@ -11,6 +11,7 @@
 #include <proxygen/lib/http/HTTPHeaderSize.h>
 #include <proxygen/lib/http/HTTPMessage.h>
 #include <proxygen/lib/http/codec/HTTP1xCodec.h>
+#include <proxygen/lib/http/codec/compress/GzipHeaderCodec.h>
 #include <proxygen/lib/http/codec/test/MockHTTPCodec.h>
 #include <proxygen/lib/http/codec/test/TestUtils.h>
 #include <proxygen/lib/utils/Base64.h>
@@ -84,6 +85,55 @@ TEST(HTTP1xCodecTest, TestSimpleHeaders) {
   EXPECT_EQ(callbacks.headerSize.compressed, callbacks.headerSize.uncompressed);
 }
 
+TEST(HTTP1xCodecTest, TestSimdHeaderParsing) {
+  // The vectorized tokenizer must produce exactly what the scalar path does
+  string longValue(500, 'x');
+  string req =
+      "GET /yeah HTTP/1.1\r\n"
+      "Host: www.facebook.com\r\n"
+      "X-Long: " + longValue + "\r\n"
+      "X-Quoted: \"quoted, value\"\r\n"
+      "X-Short: a\r\n\r\n";
+  auto buffer = folly::IOBuf::copyBuffer(req);
+
+  HTTP1xCodec scalarCodec(TransportDirection::DOWNSTREAM);
+  HTTP1xCodecCallback scalarCallbacks;
+  scalarCodec.setCallback(&scalarCallbacks);
+  scalarCodec.onIngress(*buffer);
+
+  HTTP1xCodec simdCodec(TransportDirection::DOWNSTREAM,
+                        false /* forceUpstream1_1 */,
+                        true /* useSimdParsing */);
+  HTTP1xCodecCallback simdCallbacks;
+  simdCodec.setCallback(&simdCallbacks);
+  simdCodec.onIngress(*buffer);
+
+  EXPECT_EQ(simdCallbacks.headersComplete, 1);
+  EXPECT_EQ(simdCallbacks.errors, 0);
+  ASSERT_TRUE(simdCallbacks.msg_ != nullptr);
+  auto& simdHeaders = simdCallbacks.msg_->getHeaders();
+  auto& scalarHeaders = scalarCallbacks.msg_->getHeaders();
+  EXPECT_EQ(simdHeaders.size(), scalarHeaders.size());
+  EXPECT_EQ(simdHeaders.getSingleOrEmpty("X-Long"), longValue);
+  EXPECT_EQ(simdHeaders.getSingleOrEmpty("X-Quoted"),
+            scalarHeaders.getSingleOrEmpty("X-Quoted"));
+  EXPECT_EQ(simdHeaders.getSingleOrEmpty("X-Short"), "a");
+}
+
+TEST(HTTP1xCodecTest, TestSimdBadHeaderValue) {
+  // Control characters still fail parsing on the vectorized path
+  HTTP1xCodec codec(TransportDirection::DOWNSTREAM,
+                    false /* forceUpstream1_1 */,
+                    true /* useSimdParsing */);
+  HTTP1xCodecCallback callbacks;
+  codec.setCallback(&callbacks);
+  string padding(64, 'y');
+  auto buffer = folly::IOBuf::copyBuffer(
+      "GET /yeah HTTP/1.1\r\nX-Bad: " + padding + "\x01rest\r\n\r\n");
+  codec.onIngress(*buffer);
+  EXPECT_EQ(callbacks.errors, 1);
+}
+
 TEST(HTTP1xCodecTest, Test09Req) {
   HTTP1xCodec codec(TransportDirection::DOWNSTREAM);
   HTTP1xCodecCallback callbacks;
@@ -175,6 +225,38 @@ TEST(HTTP1xCodecTest, TestHeadRequestChunkedResponse) {
   EXPECT_TRUE(respStr.find("0\r\n") == string::npos);
 }
 
+TEST(HTTP1xCodecTest, TestStatusLineSerialization) {
+  // Standard reason phrases come from the precomputed status-line table,
+  // custom ones are assembled piecewise; the bytes must not differ
+  HTTP1xCodec codec(TransportDirection::DOWNSTREAM);
+  HTTP1xCodecCallback callbacks;
+  codec.setCallback(&callbacks);
+
+  auto reqBuf = folly::IOBuf::copyBuffer(
+      "GET /www.facebook.com HTTP/1.1\nHost: www.facebook.com\n\n"
+      "GET /www.facebook.com HTTP/1.1\nHost: www.facebook.com\n\n");
+  auto txnID = codec.createStream();
+  codec.onIngress(*reqBuf);
+  codec.createStream();
+  EXPECT_EQ(callbacks.headersComplete, 2);
+
+  HTTPMessage resp;
+  resp.setHTTPVersion(1, 1);
+  resp.setStatusCode(200);
+  resp.setStatusMessage("OK");
+  resp.getHeaders().set(HTTP_HEADER_CONTENT_LENGTH, "0");
+  folly::IOBufQueue respBuf(folly::IOBufQueue::cacheChainLength());
+  codec.generateHeader(respBuf, txnID, resp, true);
+  auto respStr = respBuf.move()->moveToFbString();
+  EXPECT_EQ(respStr.find("HTTP/1.1 200 OK\r\n"), 0);
+  EXPECT_TRUE(respStr.find("Connection: keep-alive\r\n") != string::npos);
+
+  resp.setStatusMessage("Okey Dokey");
+  codec.generateHeader(respBuf, txnID + 1, resp, true);
+  respStr = respBuf.move()->moveToFbString();
+  EXPECT_EQ(respStr.find("HTTP/1.1 200 Okey Dokey\r\n"), 0);
+}
+
 TEST(HTTP1xCodecTest, TestGetRequestChunkedResponse) {
   HTTP1xCodec codec(TransportDirection::DOWNSTREAM);
   HTTP1xCodecCallback callbacks;
@@ -284,6 +366,73 @@ TEST(HTTP1xCodecTest, TestChunkedUpstream) {
   ASSERT_EQ("5\r\nWorld\r\n0\r\n\r\n", eomFromBuf->moveToFbString());
 }
 
+TEST(HTTP1xCodecTest, TestChunkCoalescing) {
+  HTTP1xCodec codec(TransportDirection::UPSTREAM);
+
+  auto txnID = codec.createStream();
+
+  HTTPMessage msg;
+  msg.setHTTPVersion(1, 1);
+  msg.setURL("https://www.facebook.com/");
+  msg.getHeaders().set(HTTP_HEADER_HOST, "www.facebook.com");
+  msg.getHeaders().set(HTTP_HEADER_TRANSFER_ENCODING, "chunked");
+  msg.setIsChunked(true);
+
+  folly::IOBufQueue buf(folly::IOBufQueue::cacheChainLength());
+  codec.generateHeader(buf, txnID, msg, false);
+  buf.move();
+
+  // small chunks pack into the write buffer with their framing instead of
+  // contributing three chain elements apiece
+  for (int i = 0; i < 10; i++) {
+    auto body = folly::IOBuf::copyBuffer(std::string(100, 'a'));
+    codec.generateBody(buf, txnID, std::move(body), HTTPCodec::NoPadding,
+                       false);
+  }
+  auto smallChunks = buf.move();
+  EXPECT_EQ(smallChunks->countChainElements(), 1);
+  EXPECT_EQ(smallChunks->computeChainDataLength(), 10 * (4 + 100 + 2));
+
+  // large chunks are still linked in without a copy
+  auto bigBody = folly::IOBuf::copyBuffer(std::string(64 * 1024, 'b'));
+  codec.generateBody(buf, txnID, std::move(bigBody), HTTPCodec::NoPadding,
+                     false);
+  auto bigChunk = buf.move();
+  EXPECT_GT(bigChunk->countChainElements(), 1);
+  EXPECT_EQ(bigChunk->computeChainDataLength(), 5 + 2 + 64 * 1024 + 2);
+}
+
+TEST(HTTP1xCodecTest, TestContentLengthBodyPacking) {
+  HTTP1xCodec codec(TransportDirection::UPSTREAM);
+
+  auto txnID = codec.createStream();
+
+  HTTPMessage msg;
+  msg.setHTTPVersion(1, 1);
+  msg.setMethod("POST");
+  msg.setURL("/upload");
+  msg.getHeaders().set(HTTP_HEADER_HOST, "www.facebook.com");
+  msg.getHeaders().set(HTTP_HEADER_CONTENT_LENGTH, "1000");
+
+  folly::IOBufQueue buf(folly::IOBufQueue::cacheChainLength());
+  codec.generateHeader(buf, txnID, msg, false);
+  // the session reserves the declared size at header time
+  buf.preallocate(2048, 2048);
+  const auto elementsAfterHeader = buf.front()->countChainElements();
+
+  // a small content-length body packs into the reserved tailroom
+  codec.generateBody(buf, txnID,
+                     folly::IOBuf::copyBuffer(std::string(1000, 'a')),
+                     HTTPCodec::NoPadding, false);
+  EXPECT_EQ(buf.front()->countChainElements(), elementsAfterHeader);
+
+  // large bodies are still linked in without a copy
+  codec.generateBody(buf, txnID,
+                     folly::IOBuf::copyBuffer(std::string(64 * 1024, 'b')),
+                     HTTPCodec::NoPadding, false);
+  EXPECT_GT(buf.front()->countChainElements(), elementsAfterHeader);
+}
+
 TEST(HTTP1xCodecTest, TestBadPost100) {
   HTTP1xCodec codec(TransportDirection::DOWNSTREAM);
   MockHTTPCodecCallback callbacks;
@@ -717,6 +866,128 @@ TEST(HTTP1xCodecTest, TestHeaderValueWhiteSpaces) {
   EXPECT_EQ(headers.getSingleOrEmpty("X-FB-HEADER"), "yay");
 }
 
+TEST(HTTP1xCodecTest, HeaderCompressionNegotiationAndRoundTrip) {
+  HTTP1xCodec upstream(TransportDirection::UPSTREAM);
+  HTTP1xCodec downstream(TransportDirection::DOWNSTREAM);
+  upstream.enableHeaderCompression();
+  downstream.enableHeaderCompression();
+  HTTP1xCodecCallback upstreamCallbacks;
+  HTTP1xCodecCallback downstreamCallbacks;
+  upstream.setCallback(&upstreamCallbacks);
+  downstream.setCallback(&downstreamCallbacks);
+  folly::IOBufQueue writeBuf(folly::IOBufQueue::cacheChainLength());
+
+  // Request 1: nothing negotiated yet, so headers are in the clear plus the
+  // advertisement
+  HTTPMessage req;
+  req.setMethod(HTTPMethod::GET);
+  req.setHTTPVersion(1, 1);
+  req.setURL("/");
+  req.getHeaders().set(HTTP_HEADER_HOST, "www.facebook.com");
+  req.getHeaders().set("X-Custom-Header", "custom-value");
+  auto id = upstream.createStream();
+  upstream.generateHeader(writeBuf, id, req, true);
+  auto req1Bytes = writeBuf.move()->moveToFbString().toStdString();
+  EXPECT_NE(req1Bytes.find("Proxygen-Header-Compression: gzip"),
+            string::npos);
+  EXPECT_NE(req1Bytes.find("X-Custom-Header: custom-value"), string::npos);
+  EXPECT_FALSE(upstream.isHeaderCompressionActive());
+
+  auto req1Buf = folly::IOBuf::copyBuffer(req1Bytes);
+  downstream.onIngress(*req1Buf);
+  EXPECT_EQ(downstreamCallbacks.headersComplete, 1);
+  EXPECT_TRUE(downstream.isHeaderCompressionActive());
+  auto& req1Headers = downstreamCallbacks.msg_->getHeaders();
+  EXPECT_EQ(req1Headers.getSingleOrEmpty("X-Custom-Header"), "custom-value");
+  // the negotiation header is hop-by-hop
+  EXPECT_EQ(req1Headers.getSingleOrEmpty("Proxygen-Header-Compression"),
+            empty_string);
+
+  // Response 1: downstream compresses and echoes the advertisement
+  HTTPMessage resp;
+  resp.setHTTPVersion(1, 1);
+  resp.setStatusCode(200);
+  resp.setStatusMessage("OK");
+  resp.getHeaders().set(HTTP_HEADER_CONTENT_TYPE, "text/html");
+  resp.getHeaders().set(HTTP_HEADER_CONTENT_LENGTH, "0");
+  downstream.generateHeader(writeBuf, id, resp, true);
+  auto resp1Bytes = writeBuf.move()->moveToFbString().toStdString();
+  EXPECT_NE(resp1Bytes.find("Proxygen-Compressed-Headers: "), string::npos);
+  EXPECT_NE(resp1Bytes.find("Proxygen-Header-Compression: gzip"),
+            string::npos);
+  EXPECT_EQ(resp1Bytes.find("Content-Type"), string::npos);
+  // framing headers stay in the clear
+  EXPECT_NE(resp1Bytes.find("Content-Length: 0"), string::npos);
+
+  auto resp1Buf = folly::IOBuf::copyBuffer(resp1Bytes);
+  upstream.onIngress(*resp1Buf);
+  EXPECT_EQ(upstreamCallbacks.headersComplete, 1);
+  EXPECT_EQ(upstreamCallbacks.messageComplete, 1);
+  EXPECT_EQ(upstreamCallbacks.errors, 0);
+  EXPECT_TRUE(upstream.isHeaderCompressionActive());
+  auto& resp1Headers = upstreamCallbacks.msg_->getHeaders();
+  EXPECT_EQ(resp1Headers.getSingleOrEmpty(HTTP_HEADER_CONTENT_TYPE),
+            "text/html");
+  EXPECT_EQ(resp1Headers.getSingleOrEmpty("Proxygen-Compressed-Headers"),
+            empty_string);
+
+  // Request 2: the client now compresses too
+  id = upstream.createStream();
+  upstream.generateHeader(writeBuf, id, req, true);
+  auto req2Bytes = writeBuf.move()->moveToFbString().toStdString();
+  EXPECT_NE(req2Bytes.find("Proxygen-Compressed-Headers: "), string::npos);
+  EXPECT_EQ(req2Bytes.find("X-Custom-Header"), string::npos);
+
+  auto req2Buf = folly::IOBuf::copyBuffer(req2Bytes);
+  downstream.onIngress(*req2Buf);
+  EXPECT_EQ(downstreamCallbacks.headersComplete, 2);
+  EXPECT_EQ(downstreamCallbacks.errors, 0);
+  auto& req2Headers = downstreamCallbacks.msg_->getHeaders();
+  EXPECT_EQ(req2Headers.getSingleOrEmpty("X-Custom-Header"), "custom-value");
+  EXPECT_EQ(req2Headers.getSingleOrEmpty(HTTP_HEADER_HOST),
+            "www.facebook.com");
+}
+
+TEST(HTTP1xCodecTest, HeaderCompressionRejectsFramingHeaders) {
+  // A framing header tucked inside the compressed block never participated
+  // in the parser's framing decisions, so the message must be rejected
+  GzipHeaderCodec gzipCodec(4);
+  std::string name("content-length");
+  std::string value("1000");
+  std::vector<compress::Header> headers{
+    compress::Header::makeHeaderForTest(name, value)};
+  auto block = gzipCodec.encode(headers);
+  auto encoded = Base64::encode(block->coalesce());
+
+  HTTP1xCodec codec(TransportDirection::DOWNSTREAM);
+  codec.enableHeaderCompression();
+  HTTP1xCodecCallback callbacks;
+  codec.setCallback(&callbacks);
+  auto buf = folly::IOBuf::copyBuffer(
+      folly::to<string>("GET / HTTP/1.1\r\n"
+                        "Host: www.facebook.com\r\n"
+                        "Proxygen-Compressed-Headers: ", encoded, "\r\n"
+                        "\r\n"));
+  codec.onIngress(*buf);
+  EXPECT_EQ(callbacks.headersComplete, 0);
+  EXPECT_EQ(callbacks.errors, 1);
+}
+
+TEST(HTTP1xCodecTest, HeaderCompressionBadBlock) {
+  HTTP1xCodec codec(TransportDirection::DOWNSTREAM);
+  codec.enableHeaderCompression();
+  HTTP1xCodecCallback callbacks;
+  codec.setCallback(&callbacks);
+  auto buf = folly::IOBuf::copyBuffer(
+      "GET / HTTP/1.1\r\n"
+      "Host: www.facebook.com\r\n"
+      "Proxygen-Compressed-Headers: bm90IGEgemxpYiBibG9jaw==\r\n"
+      "\r\n");
+  codec.onIngress(*buf);
+  EXPECT_EQ(callbacks.headersComplete, 0);
+  EXPECT_EQ(callbacks.errors, 1);
+}
+
 class ConnectionHeaderTest:
     public TestWithParam<std::pair<std::list<string>, string>> {
  public:
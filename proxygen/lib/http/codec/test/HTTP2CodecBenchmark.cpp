@@ -0,0 +1,127 @@
+/*
+ *  Copyright (c) 2015-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include <folly/Benchmark.h>
+#include <folly/io/IOBuf.h>
+#include <folly/io/IOBufQueue.h>
+#include <proxygen/lib/http/codec/HTTP2Codec.h>
+
+using namespace folly;
+using namespace proxygen;
+
+namespace {
+
+// Minimal counting callback; benchmarks cannot use the gtest-based
+// FakeHTTPCodecCallback from TestUtils.h
+class BenchCodecCallback : public HTTPCodec::Callback {
+ public:
+  void onMessageBegin(HTTPCodec::StreamID, HTTPMessage*) override {
+    messages++;
+  }
+  void onHeadersComplete(HTTPCodec::StreamID,
+                         std::unique_ptr<HTTPMessage>) override {
+    headers++;
+  }
+  void onBody(HTTPCodec::StreamID,
+              std::unique_ptr<folly::IOBuf> chain,
+              uint16_t) override {
+    bodyBytes += chain->computeChainDataLength();
+  }
+  void onTrailersComplete(HTTPCodec::StreamID,
+                          std::unique_ptr<HTTPHeaders>) override {
+  }
+  void onMessageComplete(HTTPCodec::StreamID, bool) override {
+    complete++;
+  }
+  void onError(HTTPCodec::StreamID,
+               const HTTPException&,
+               bool) override {
+    errors++;
+  }
+
+  uint64_t messages{0};
+  uint64_t headers{0};
+  uint64_t bodyBytes{0};
+  uint64_t complete{0};
+  uint64_t errors{0};
+};
+
+HTTPMessage makeRequest() {
+  HTTPMessage req;
+  req.setHTTPVersion(1, 1);
+  req.setURL("/some/long/enough/path?with=a&query=string");
+  req.setMethod("GET");
+  req.getHeaders().set("host", "www.facebook.com");
+  req.getHeaders().set(
+      "user-agent",
+      "Mozilla/5.0 (Macintosh; Intel Mac OS X 10_12_6) AppleWebKit/537.36 "
+      "(KHTML, like Gecko) Chrome/60.0.3100.0 Safari/537.36");
+  req.getHeaders().set("accept-encoding", "gzip, deflate, br");
+  req.getHeaders().set("accept-language", "en-US,en;q=0.8");
+  return req;
+}
+
+/**
+ * A full session's worth of ingress: connection preface, SETTINGS, then
+ * `streams` request streams each carrying HEADERS plus a DATA frame.
+ */
+std::unique_ptr<IOBuf> buildSessionIngress(size_t streams, size_t bodyLen) {
+  HTTP2Codec egressCodec(TransportDirection::UPSTREAM);
+  IOBufQueue output(IOBufQueue::cacheChainLength());
+  egressCodec.generateConnectionPreface(output);
+  egressCodec.generateSettings(output);
+  auto req = makeRequest();
+  for (size_t i = 0; i < streams; i++) {
+    auto id = egressCodec.createStream();
+    egressCodec.generateHeader(output, id, req, bodyLen == 0);
+    if (bodyLen > 0) {
+      egressCodec.generateBody(output,
+                               id,
+                               IOBuf::copyBuffer(std::string(bodyLen, 'x')),
+                               HTTPCodec::NoPadding,
+                               true /* eom */);
+    }
+  }
+  return output.move();
+}
+
+void parseSession(size_t iters, size_t streams, size_t bodyLen) {
+  BenchmarkSuspender susp;
+  auto buf = buildSessionIngress(streams, bodyLen);
+  for (size_t i = 0; i < iters; i++) {
+    HTTP2Codec codec(TransportDirection::DOWNSTREAM);
+    BenchCodecCallback callback;
+    codec.setCallback(&callback);
+    susp.dismiss();
+    codec.onIngress(*buf);
+    susp.rehire();
+    CHECK_EQ(callback.complete, streams);
+    CHECK_EQ(callback.errors, 0);
+  }
+}
+
+} // namespace
+
+BENCHMARK(http2SessionParse1Stream, iters) {
+  parseSession(iters, 1, 0);
+}
+
+BENCHMARK(http2SessionParse100Streams, iters) {
+  parseSession(iters, 100, 0);
+}
+
+BENCHMARK(http2SessionParse100StreamsWithBody, iters) {
+  parseSession(iters, 100, 4096);
+}
+
+int main(int argc, char** argv) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  folly::runBenchmarks();
+  return 0;
+}
@@ -10,6 +10,7 @@
 #include <proxygen/lib/http/codec/test/HTTPParallelCodecTest.h>
 #include <proxygen/lib/http/codec/test/MockHTTPCodec.h>
 #include <folly/io/Cursor.h>
+#include <proxygen/lib/http/codec/CodecUtil.h>
 #include <proxygen/lib/http/codec/HTTP2Codec.h>
 #include <proxygen/lib/http/codec/test/HTTP2FramerTest.h>
 #include <proxygen/lib/http/HTTPHeaderSize.h>
@@ -185,6 +186,26 @@ TEST_F(HTTP2CodecTest, InvalidExHeadersSetting) {
   EXPECT_EQ(callbacks_.sessionErrors, 1);
 }
 
+TEST_F(HTTP2CodecTest, BatchedHeaders) {
+  HTTPMessage req = getGetRequest("/guacamole");
+  req.getHeaders().add(HTTP_HEADER_USER_AGENT, "coolio");
+
+  // Prepare the full header list once and hand it to the codec in a batch
+  std::vector<std::string> temps;
+  std::vector<compress::Header> allHeaders;
+  CodecUtil::prepareMessageForCompression(req, allHeaders, temps);
+  HTTPHeaderSize size;
+  EXPECT_TRUE(upstreamCodec_.generateHeaders(
+      output_, 1, allHeaders, true /* eom */, &size));
+  EXPECT_GT(size.compressed, 0);
+
+  parse();
+  callbacks_.expectMessage(true, 2, "/guacamole");
+  const auto& headers = callbacks_.msg->getHeaders();
+  EXPECT_EQ("coolio", headers.getSingleOrEmpty(HTTP_HEADER_USER_AGENT));
+  EXPECT_EQ("www.foo.com", headers.getSingleOrEmpty(HTTP_HEADER_HOST));
+}
+
 TEST_F(HTTP2CodecTest, BasicHeader) {
   HTTPMessage req = getGetRequest("/guacamole");
   req.getHeaders().add(HTTP_HEADER_USER_AGENT, "coolio");
@@ -203,6 +224,53 @@ TEST_F(HTTP2CodecTest, BasicHeader) {
   EXPECT_EQ("www.foo.com", headers.getSingleOrEmpty(HTTP_HEADER_HOST));
 }
 
+TEST_F(HTTP2CodecTest, ImmutableSharedHeaderSnapshot) {
+  HTTPMessage req = getGetRequest("/static/app.js");
+  req.getHeaders().add(HTTP_HEADER_USER_AGENT, "coolio");
+  req.setHeaderBlockReusable(true);
+  // The first send caches a connection-state-free block on the message
+  upstreamCodec_.generateHeader(output_, 1, req, true /* eom */);
+  parse();
+  callbacks_.expectMessage(true, 2, "/static/app.js");
+  ASSERT_NE(req.getReusableHeaderBlock(), nullptr);
+
+  auto snapshot = HTTPMessage::makeImmutableShared(std::move(req));
+  const auto* frozenBlock = snapshot->getReusableHeaderBlock();
+  ASSERT_NE(frozenBlock, nullptr);
+
+  // A fresh stream replays the frozen block verbatim, and the codec
+  // never writes a cache back into the shared snapshot
+  callbacks_.reset();
+  upstreamCodec_.generateHeader(output_, 3, *snapshot, true /* eom */);
+  parse();
+  callbacks_.expectMessage(true, 2, "/static/app.js");
+  EXPECT_EQ(snapshot->getReusableHeaderBlock(), frozenBlock);
+
+  // A consecutive repeat of the same snapshot re-encodes through the
+  // connection's dynamic table; the result still decodes identically
+  callbacks_.reset();
+  upstreamCodec_.generateHeader(output_, 5, *snapshot, true /* eom */);
+  parse();
+  callbacks_.expectMessage(true, 2, "/static/app.js");
+  EXPECT_EQ(
+      "coolio",
+      callbacks_.msg->getHeaders().getSingleOrEmpty(HTTP_HEADER_USER_AGENT));
+  EXPECT_EQ(snapshot->getReusableHeaderBlock(), frozenBlock);
+}
+
+TEST_F(HTTP2CodecTest, MetadataHeaders) {
+  // Pass-through metadata rides in the HEADERS frame as never-indexed
+  // literals and surfaces as regular headers at the peer
+  HTTPMessage req = getGetRequest("/guacamole");
+  req.setMetadataHeader("trace-id", "4bf92f3577b34da6");
+  upstreamCodec_.generateHeader(output_, 1, req, true /* eom */);
+
+  parse();
+  callbacks_.expectMessage(true, 2, "/guacamole");
+  const auto& headers = callbacks_.msg->getHeaders();
+  EXPECT_EQ("4bf92f3577b34da6", headers.getSingleOrEmpty("trace-id"));
+}
+
 TEST_F(HTTP2CodecTest, RequestFromServer) {
   // this is to test EX_HEADERS frame, which carrys the HTTP request initiated
   // by server side
@@ -433,6 +501,41 @@ TEST_F(HTTP2CodecTest, BadHeaderValues) {
   EXPECT_EQ(callbacks_.sessionErrors, 0);
 }
 
+TEST_F(HTTP2CodecTest, TrustedIngressSkipsByteValidation) {
+  // A trusted listener's codec delivers values the strict scans would
+  // reject; only the per-byte validation is off, so the message still
+  // completes normally
+  downstreamCodec_.setStrictValidation(false);
+
+  static const std::string kMethod("GET");
+  static const std::string kPath("/");
+  static const std::string kScheme("http");
+  static const std::string kBadAuthority("abc.com\\13\\10");
+  std::vector<proxygen::compress::Header> allHeaders = {
+    Header::makeHeaderForTest(headers::kMethod, kMethod),
+    Header::makeHeaderForTest(headers::kPath, kPath),
+    Header::makeHeaderForTest(headers::kScheme, kScheme),
+    Header::makeHeaderForTest(headers::kAuthority, kBadAuthority),
+  };
+
+  HPACKCodec headerCodec(TransportDirection::UPSTREAM);
+  auto encodedHeaders = headerCodec.encode(allHeaders);
+  http2::writeHeaders(output_,
+                      std::move(encodedHeaders),
+                      1,
+                      folly::none,
+                      http2::kNoPadding,
+                      true,
+                      true);
+
+  parse();
+  EXPECT_EQ(callbacks_.messageBegin, 1);
+  EXPECT_EQ(callbacks_.headersComplete, 1);
+  EXPECT_EQ(callbacks_.messageComplete, 1);
+  EXPECT_EQ(callbacks_.streamErrors, 0);
+  EXPECT_EQ(callbacks_.sessionErrors, 0);
+}
+
 /**
  * Ingress bytes with an empty header name
  */
@@ -672,6 +775,18 @@ TEST_F(HTTP2CodecTest, Cookies) {
   EXPECT_EQ(callbacks_.msg->getCookie("oatmeal-raisin"), "4");
 }
 
+TEST_F(HTTP2CodecTest, SingleCookie) {
+  // A lone cookie header skips the crumb-combining pass entirely
+  HTTPMessage req = getGetRequest("/guacamole");
+  req.getHeaders().add("Cookie", "chocolate-chip=1");
+  req.setSecure(true);
+  upstreamCodec_.generateHeader(output_, 1, req);
+
+  parse();
+  callbacks_.expectMessage(false, 2, "/guacamole");
+  EXPECT_EQ(callbacks_.msg->getCookie("chocolate-chip"), "1");
+}
+
 TEST_F(HTTP2CodecTest, BasicContinuation) {
   HTTPMessage req = getBigGetRequest();
   upstreamCodec_.generateHeader(output_, 1, req);
@@ -861,13 +976,51 @@ TEST_F(HTTP2CodecTest, LongData) {
   EXPECT_EQ(callbacks_.messageBegin, 0);
   EXPECT_EQ(callbacks_.headersComplete, 0);
   EXPECT_EQ(callbacks_.messageComplete, 1);
-  EXPECT_EQ(callbacks_.bodyCalls, 7);
+  // All 7 DATA frames are buffered, so they coalesce into one onBody
+  EXPECT_EQ(callbacks_.bodyCalls, 1);
   EXPECT_EQ(callbacks_.bodyLength, 100);
   EXPECT_EQ(callbacks_.streamErrors, 0);
   EXPECT_EQ(callbacks_.sessionErrors, 0);
   EXPECT_EQ(callbacks_.data.move()->moveToFbString(), buf->moveToFbString());
 }
 
+TEST_F(HTTP2CodecTest, DataFrameTrain) {
+  // Consecutive buffered DATA frames for one stream coalesce into a single
+  // onBody call; a frame for another stream starts a new delivery
+  upstreamCodec_.generateBody(output_, 1, makeBuf(20), HTTPCodec::NoPadding,
+                              false);
+  upstreamCodec_.generateBody(output_, 1, makeBuf(20), HTTPCodec::NoPadding,
+                              false);
+  upstreamCodec_.generateBody(output_, 1, makeBuf(20), HTTPCodec::NoPadding,
+                              false);
+  upstreamCodec_.generateBody(output_, 3, makeBuf(10), HTTPCodec::NoPadding,
+                              false);
+  upstreamCodec_.generateBody(output_, 1, makeBuf(20), HTTPCodec::NoPadding,
+                              true);
+
+  parse();
+  EXPECT_EQ(callbacks_.bodyCalls, 3);
+  EXPECT_EQ(callbacks_.bodyLength, 90);
+  EXPECT_EQ(callbacks_.messageComplete, 1);
+  EXPECT_EQ(callbacks_.streamErrors, 0);
+  EXPECT_EQ(callbacks_.sessionErrors, 0);
+}
+
+TEST_F(HTTP2CodecTest, DataFrameTrainPadding) {
+  // Padded frames are delivered individually so per-frame padding reaches
+  // the callback for flow control accounting
+  upstreamCodec_.generateBody(output_, 1, makeBuf(20), 10, false);
+  upstreamCodec_.generateBody(output_, 1, makeBuf(20), 10, true);
+
+  parse();
+  EXPECT_EQ(callbacks_.bodyCalls, 2);
+  EXPECT_EQ(callbacks_.bodyLength, 40);
+  EXPECT_EQ(callbacks_.paddingBytes, 22);
+  EXPECT_EQ(callbacks_.messageComplete, 1);
+  EXPECT_EQ(callbacks_.streamErrors, 0);
+  EXPECT_EQ(callbacks_.sessionErrors, 0);
+}
+
 TEST_F(HTTP2CodecTest, MalformedPaddingLength) {
   const uint8_t badInput[] = {0x50, 0x52, 0x49, 0x20, 0x2a, 0x20, 0x48, 0x54,
                               0x54, 0x50, 0x2f, 0x32, 0x2e, 0x30, 0x0d, 0x0a,
@@ -1228,6 +1381,37 @@ TEST_F(HTTP2CodecTest, BasicSetting) {
   EXPECT_EQ(callbacks_.sessionErrors, 0);
 }
 
+TEST_F(HTTP2CodecTest, SettingsFrameMemoized) {
+  auto settings = upstreamCodec_.getEgressSettings();
+  settings->setSetting(SettingsId::MAX_CONCURRENT_STREAMS, 37);
+  upstreamCodec_.generateSettings(output_);
+
+  parse();
+  EXPECT_EQ(callbacks_.settings, 1);
+  EXPECT_EQ(callbacks_.maxStreams, 37);
+
+  // A second codec with an identical settings list replays the memoized
+  // frame; the clone must parse the same as a freshly rendered one
+  HTTP2Codec upstream2(TransportDirection::UPSTREAM);
+  upstream2.getEgressSettings()->setSetting(SettingsId::MAX_CONCURRENT_STREAMS,
+                                            37);
+  upstream2.generateSettings(output_);
+
+  parse();
+  EXPECT_EQ(callbacks_.settings, 2);
+  EXPECT_EQ(callbacks_.maxStreams, 37);
+
+  // Changing a value misses the memo and re-renders
+  settings->setSetting(SettingsId::MAX_CONCURRENT_STREAMS, 55);
+  upstreamCodec_.generateSettings(output_);
+
+  parse();
+  EXPECT_EQ(callbacks_.settings, 3);
+  EXPECT_EQ(callbacks_.maxStreams, 55);
+  EXPECT_EQ(callbacks_.streamErrors, 0);
+  EXPECT_EQ(callbacks_.sessionErrors, 0);
+}
+
 TEST_F(HTTP2CodecTest, SettingsAck) {
   upstreamCodec_.generateSettingsAck(output_);
 
@@ -1950,6 +2134,67 @@ TEST_F(HTTP2CodecTest, Trailers) {
 #endif
 }
 
+TEST_F(HTTP2CodecTest, TrailersThenNextMessage) {
+  // The trailer block's carrier message is recycled; the next header
+  // block on the codec must come out fully reset
+  HTTPMessage req1 = getGetRequest("/guacamole");
+  upstreamCodec_.generateHeader(output_, 1, req1);
+  HTTPHeaders trailers;
+  trailers.add("x-trailer-1", "pico-de-gallo");
+  upstreamCodec_.generateTrailers(output_, 1, trailers);
+
+  HTTPMessage req2 = getGetRequest("/chips");
+  req2.getHeaders().add(HTTP_HEADER_USER_AGENT, "coolio");
+  upstreamCodec_.generateHeader(output_, 3, req2);
+
+  parse();
+
+  EXPECT_EQ(callbacks_.messageBegin, 2);
+  EXPECT_EQ(callbacks_.headersComplete, 2);
+  EXPECT_EQ(callbacks_.trailers, 1);
+  EXPECT_EQ(callbacks_.msg->getURL(), "/chips");
+  EXPECT_EQ("coolio",
+            callbacks_.msg->getHeaders().getSingleOrEmpty(
+                HTTP_HEADER_USER_AGENT));
+  EXPECT_FALSE(callbacks_.msg->getHeaders().exists("x-trailer-1"));
+  EXPECT_EQ(callbacks_.streamErrors, 0);
+  EXPECT_EQ(callbacks_.sessionErrors, 0);
+}
+
+TEST_F(HTTP2CodecTest, TrailersRepeatedAcrossStreams) {
+  // gRPC-style traffic ends every response with the same trailer set.
+  // The second identical set is encoded connection-state-free and later
+  // ones replay the cached block; all of them must decode identically.
+  HTTPHeaders trailers;
+  trailers.add("grpc-status", "0");
+  for (auto stream : {1, 3, 5}) {
+    HTTPMessage req = getGetRequest("/guacamole");
+    upstreamCodec_.generateHeader(output_, stream, req);
+    upstreamCodec_.generateTrailers(output_, stream, trailers);
+    parse();
+    EXPECT_EQ(callbacks_.streamErrors, 0);
+    EXPECT_EQ(callbacks_.sessionErrors, 0);
+    ASSERT_NE(nullptr, callbacks_.msg->getTrailers());
+    EXPECT_EQ("0",
+              callbacks_.msg->getTrailers()->getSingleOrEmpty("grpc-status"));
+  }
+  EXPECT_EQ(callbacks_.trailers, 3);
+
+  // A changed set must fall off the cached block and re-encode
+  HTTPHeaders errTrailers;
+  errTrailers.add("grpc-status", "14");
+  HTTPMessage req = getGetRequest("/chips");
+  upstreamCodec_.generateHeader(output_, 7, req);
+  upstreamCodec_.generateTrailers(output_, 7, errTrailers);
+  parse();
+  EXPECT_EQ(callbacks_.trailers, 4);
+  ASSERT_NE(nullptr, callbacks_.msg->getTrailers());
+  EXPECT_EQ("14",
+            callbacks_.msg->getTrailers()->getSingleOrEmpty("grpc-status"));
+  EXPECT_EQ(callbacks_.streamErrors, 0);
+  EXPECT_EQ(callbacks_.sessionErrors, 0);
+}
+
 TEST_F(HTTP2CodecTest, TrailersWithPseudoHeaders) {
   HTTPMessage req = getGetRequest("/guacamole");
   req.getHeaders().add(HTTP_HEADER_USER_AGENT, "coolio");
@@ -107,6 +107,96 @@ TEST_F(HTTP2FramerTest, ManyDataFrameSizes) {
   }
 }
 
+TEST_F(HTTP2FramerTest, WriteDataFramesBatch) {
+  auto body = makeBuf(1000);
+  auto written = writeDataFrames(queue_, body->clone(), 1, 300, true);
+  EXPECT_EQ(written, 4 * kFrameHeaderSize + 1000);
+
+  Cursor cursor(queue_.front());
+  std::unique_ptr<IOBuf> out;
+  for (uint32_t i = 0; i < 4; i++) {
+    const bool last = (i == 3);
+    FrameHeader outHeader;
+    ASSERT_EQ(parseFrameHeader(cursor, outHeader), ErrorCode::NO_ERROR);
+    EXPECT_EQ(outHeader.type, FrameType::DATA);
+    EXPECT_EQ(outHeader.stream, 1);
+    EXPECT_EQ(outHeader.length, last ? 100 : 300);
+    EXPECT_EQ(outHeader.flags & END_STREAM, last ? END_STREAM : 0);
+    std::unique_ptr<IOBuf> outBuf;
+    uint16_t padding = 0;
+    ASSERT_EQ(parseData(cursor, outHeader, outBuf, padding),
+              ErrorCode::NO_ERROR);
+    EXPECT_EQ(padding, 0);
+    if (out) {
+      out->prependChain(std::move(outBuf));
+    } else {
+      out = std::move(outBuf);
+    }
+  }
+  EXPECT_EQ(cursor.totalLength(), 0);
+  EXPECT_EQ(out->moveToFbString(), body->moveToFbString());
+}
+
+TEST_F(HTTP2FramerTest, WriteDataFramesEmpty) {
+  auto written = writeDataFrames(queue_, nullptr, 1, 16384, true);
+  EXPECT_EQ(written, kFrameHeaderSize);
+
+  FrameHeader outHeader;
+  std::unique_ptr<IOBuf> outBuf;
+  uint16_t padding = 0;
+  parse(&parseData, outHeader, outBuf, padding);
+  EXPECT_EQ(outHeader.length, 0);
+  EXPECT_TRUE(outHeader.flags & END_STREAM);
+  EXPECT_EQ(padding, 0);
+}
+
+TEST_F(HTTP2FramerTest, WriteEmptyDataEom) {
+  auto written = writeEmptyDataEom(queue_, 77);
+  EXPECT_EQ(written, kFrameHeaderSize);
+
+  FrameHeader outHeader;
+  std::unique_ptr<IOBuf> outBuf;
+  uint16_t padding = 0;
+  parse(&parseData, outHeader, outBuf, padding);
+  EXPECT_EQ(outHeader.type, FrameType::DATA);
+  EXPECT_EQ(outHeader.stream, 77);
+  EXPECT_EQ(outHeader.length, 0);
+  EXPECT_TRUE(outHeader.flags & END_STREAM);
+  EXPECT_EQ(padding, 0);
+}
+
+TEST_F(HTTP2FramerTest, WriteSmallData) {
+  auto body = makeBuf(40);
+  auto written = writeSmallData(queue_, body->clone(), 3, true);
+  EXPECT_EQ(written, kFrameHeaderSize + 40);
+
+  FrameHeader outHeader;
+  std::unique_ptr<IOBuf> outBuf;
+  uint16_t padding = 0;
+  parse(&parseData, outHeader, outBuf, padding);
+  EXPECT_EQ(outHeader.type, FrameType::DATA);
+  EXPECT_EQ(outHeader.stream, 3);
+  EXPECT_EQ(outHeader.length, 40);
+  EXPECT_TRUE(outHeader.flags & END_STREAM);
+  EXPECT_EQ(outBuf->moveToFbString(), body->moveToFbString());
+}
+
+TEST_F(HTTP2FramerTest, WriteSmallDataChained) {
+  // The payload copy must walk the whole chain
+  auto body = makeBuf(30);
+  body->prependChain(makeBuf(25));
+  auto written = writeSmallData(queue_, body->clone(), 5, false);
+  EXPECT_EQ(written, kFrameHeaderSize + 55);
+
+  FrameHeader outHeader;
+  std::unique_ptr<IOBuf> outBuf;
+  uint16_t padding = 0;
+  parse(&parseData, outHeader, outBuf, padding);
+  EXPECT_EQ(outHeader.length, 55);
+  EXPECT_FALSE(outHeader.flags & END_STREAM);
+  EXPECT_EQ(outBuf->moveToFbString(), body->moveToFbString());
+}
+
 TEST_F(HTTP2FramerTest, BadStreamData) {
   writeFrameHeaderManual(queue_, 0,
                          static_cast<uint8_t>(FrameType::DATA),
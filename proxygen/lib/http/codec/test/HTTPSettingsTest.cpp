@@ -0,0 +1,58 @@
+/*
+ *  Copyright (c) 2015-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include <folly/portability/GTest.h>
+#include <proxygen/lib/http/codec/HTTPSettings.h>
+
+using namespace proxygen;
+
+TEST(HTTPSettings, Defaults) {
+  HTTPSettings settings;
+  EXPECT_EQ(3, settings.getNumSettings());
+  EXPECT_EQ(4096, settings.getSetting(SettingsId::HEADER_TABLE_SIZE, 0));
+  EXPECT_EQ(1, settings.getSetting(SettingsId::ENABLE_PUSH, 0));
+  EXPECT_EQ(16384, settings.getSetting(SettingsId::MAX_FRAME_SIZE, 0));
+  EXPECT_EQ(nullptr, settings.getSetting(SettingsId::MAX_HEADER_LIST_SIZE));
+}
+
+TEST(HTTPSettings, SetGetUnset) {
+  HTTPSettings settings;
+  settings.setSetting(SettingsId::MAX_FRAME_SIZE, 32768);
+  EXPECT_EQ(3, settings.getNumSettings());
+  EXPECT_EQ(32768, settings.getSetting(SettingsId::MAX_FRAME_SIZE, 0));
+
+  // Non-standard ids resolve via the fallback scan
+  settings.setSetting(SettingsId::ENABLE_EX_HEADERS, 1);
+  EXPECT_EQ(1, settings.getSetting(SettingsId::ENABLE_EX_HEADERS, 0));
+
+  // Unset swaps the back entry into the vacated slot; both the removed
+  // and the moved ids must still resolve correctly afterwards
+  settings.setSetting(SettingsId::MAX_HEADER_LIST_SIZE, 1 << 17);
+  settings.unsetSetting(SettingsId::ENABLE_PUSH);
+  EXPECT_EQ(nullptr, settings.getSetting(SettingsId::ENABLE_PUSH));
+  EXPECT_EQ(1 << 17, settings.getSetting(SettingsId::MAX_HEADER_LIST_SIZE, 0));
+  EXPECT_EQ(32768, settings.getSetting(SettingsId::MAX_FRAME_SIZE, 0));
+  EXPECT_EQ(4, settings.getNumSettings());
+
+  // Re-adding after unset works
+  settings.setSetting(SettingsId::ENABLE_PUSH, 0);
+  EXPECT_EQ(0, settings.getSetting(SettingsId::ENABLE_PUSH, 1));
+
+  settings.clearSettings();
+  EXPECT_EQ(0, settings.getNumSettings());
+  EXPECT_EQ(nullptr, settings.getSetting(SettingsId::MAX_FRAME_SIZE));
+}
+
+TEST(HTTPSettings, InitializerListDedupes) {
+  HTTPSettings settings({{SettingsId::HEADER_TABLE_SIZE, 4096},
+                         {SettingsId::HEADER_TABLE_SIZE, 8192},
+                         {SettingsId::ENABLE_PUSH, 1}});
+  EXPECT_EQ(2, settings.getNumSettings());
+  EXPECT_EQ(8192, settings.getSetting(SettingsId::HEADER_TABLE_SIZE, 0));
+}
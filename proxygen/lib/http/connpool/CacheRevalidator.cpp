@@ -0,0 +1,168 @@
+/*
+ *  Copyright (c) 2019-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include "proxygen/lib/http/connpool/CacheRevalidator.h"
+
+#include <folly/Conv.h>
+
+namespace proxygen {
+
+CacheRevalidator::CacheRevalidator(SessionPool* pool, Config config)
+    : pool_(pool),
+      config_(config),
+      tokens_(config.burst),
+      lastRefill_(std::chrono::steady_clock::now()) {
+  CHECK(pool_);
+}
+
+CacheRevalidator::~CacheRevalidator() {
+  for (auto& kv : fetches_) {
+    kv.second->abandon();
+  }
+  fetches_.clear();
+}
+
+bool CacheRevalidator::takeToken() {
+  auto now = std::chrono::steady_clock::now();
+  std::chrono::duration<double> elapsed = now - lastRefill_;
+  lastRefill_ = now;
+  tokens_ = std::min(config_.burst,
+                     tokens_ + elapsed.count() * config_.ratePerSec);
+  if (tokens_ < 1) {
+    return false;
+  }
+  tokens_ -= 1;
+  return true;
+}
+
+bool CacheRevalidator::revalidate(const HTTPMessage& request,
+                                  Callback* callback) {
+  auto key = folly::to<std::string>(
+      request.getMethodString(),
+      ' ',
+      request.getHeaders().getSingleOrEmpty(HTTP_HEADER_HOST),
+      ' ',
+      request.getURL());
+  if (fetches_.find(key) != fetches_.end()) {
+    // someone already kicked this entry's refresh; the stale entry will
+    // be fixed up when it lands
+    return true;
+  }
+  if (!takeToken()) {
+    throttledCount_++;
+    return false;
+  }
+  auto fetch = std::make_unique<Fetch>(this, key, callback);
+  auto txn = pool_->getTransaction(fetch.get());
+  if (!txn) {
+    return false;
+  }
+  fetches_.emplace(std::move(key), fetch.get());
+  txn->sendHeadersWithEOM(request);
+  // Owns itself now; deleted on detachTransaction
+  fetch.release();
+  return true;
+}
+
+void CacheRevalidator::cancelRevalidation(Callback* callback) {
+  for (auto& kv : fetches_) {
+    kv.second->clearCallback(callback);
+  }
+}
+
+void CacheRevalidator::fetchComplete(Fetch* fetch) {
+  fetches_.erase(fetch->getKey());
+}
+
+CacheRevalidator::Fetch::Fetch(CacheRevalidator* revalidator,
+                               std::string key,
+                               Callback* callback)
+    : revalidator_(revalidator), key_(std::move(key)), callback_(callback) {
+}
+
+void CacheRevalidator::Fetch::clearCallback(Callback* callback) {
+  if (callback_ == callback) {
+    callback_ = nullptr;
+  }
+}
+
+void CacheRevalidator::Fetch::abandon() {
+  callback_ = nullptr;
+  revalidator_ = nullptr;
+  if (txn_) {
+    txn_->sendAbort();
+  }
+}
+
+void CacheRevalidator::Fetch::complete() {
+  if (revalidator_) {
+    revalidator_->fetchComplete(this);
+    revalidator_ = nullptr;
+  }
+}
+
+void CacheRevalidator::Fetch::setTransaction(HTTPTransaction* txn) noexcept {
+  txn_ = txn;
+}
+
+void CacheRevalidator::Fetch::detachTransaction() noexcept {
+  complete();
+  delete this;
+}
+
+void CacheRevalidator::Fetch::onHeadersComplete(
+    std::unique_ptr<HTTPMessage> msg) noexcept {
+  respHeaders_ = std::move(msg);
+}
+
+void CacheRevalidator::Fetch::onBody(
+    std::unique_ptr<folly::IOBuf> chain) noexcept {
+  respBody_.append(std::move(chain));
+}
+
+void CacheRevalidator::Fetch::onChunkHeader(size_t /*length*/) noexcept {
+}
+
+void CacheRevalidator::Fetch::onChunkComplete() noexcept {
+}
+
+void CacheRevalidator::Fetch::onTrailers(
+    std::unique_ptr<HTTPHeaders> /*trailers*/) noexcept {
+}
+
+void CacheRevalidator::Fetch::onEOM() noexcept {
+  if (callback_ && respHeaders_) {
+    if (respHeaders_->getStatusCode() == 304) {
+      callback_->onNotModified();
+    } else {
+      callback_->onRevalidated(std::move(respHeaders_), respBody_.move());
+    }
+    callback_ = nullptr;
+  }
+  complete();
+}
+
+void CacheRevalidator::Fetch::onUpgrade(UpgradeProtocol /*protocol*/) noexcept {
+}
+
+void CacheRevalidator::Fetch::onError(const HTTPException& /*error*/) noexcept {
+  if (callback_) {
+    callback_->onRevalidationFailed();
+    callback_ = nullptr;
+  }
+  complete();
+}
+
+void CacheRevalidator::Fetch::onEgressPaused() noexcept {
+}
+
+void CacheRevalidator::Fetch::onEgressResumed() noexcept {
+}
+
+} // namespace proxygen
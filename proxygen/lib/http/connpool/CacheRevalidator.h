@@ -0,0 +1,156 @@
+/*
+ *  Copyright (c) 2019-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#pragma once
+
+#include <chrono>
+#include <map>
+#include <string>
+
+#include <folly/io/IOBufQueue.h>
+
+#include "proxygen/lib/http/connpool/SessionPool.h"
+#include "proxygen/lib/http/session/HTTPTransaction.h"
+
+namespace proxygen {
+
+/**
+ * Stale-while-revalidate driver over SessionPool.
+ *
+ * When a cache entry expires, the owner keeps serving it stale and asks
+ * this class to refresh it in the background.  Revalidations are
+ * deduplicated per cache key - concurrent requests for the same stale
+ * entry trigger one upstream fetch - and paced by a token bucket so a
+ * wave of simultaneous expiries becomes smooth background traffic to
+ * the endpoint instead of a miss storm.  Since a SessionPool fronts one
+ * endpoint, the bucket is per endpoint by construction.
+ *
+ * The fresh response is handed back whole (headers plus the complete
+ * body) on the Callback; the cache owner rebuilds its pre-framed
+ * variants from it and swaps them in place.  A 304 is surfaced
+ * separately so the owner can just extend the entry's lifetime.  The
+ * caller builds the revalidation request, including any conditional
+ * headers (If-None-Match / If-Modified-Since) from the stale entry's
+ * validators.
+ *
+ * Like SessionPool and RequestCoalescer, this class is single-threaded.
+ */
+class CacheRevalidator {
+ public:
+  struct Config {
+    /** Sustained revalidations per second toward the endpoint. */
+    double ratePerSec{20};
+    /** Bucket depth: how many revalidations may burst at once. */
+    double burst{5};
+  };
+
+  /**
+   * Completion interface; the entry owner applies the result in place.
+   * Exactly one of the three methods is invoked per revalidate() call
+   * that returned true.
+   */
+  class Callback {
+   public:
+    virtual ~Callback() = default;
+
+    /** Full fresh response; rebuild the entry's variants from it. */
+    virtual void onRevalidated(std::unique_ptr<HTTPMessage> headers,
+                               std::unique_ptr<folly::IOBuf> body) noexcept = 0;
+
+    /** Upstream said 304; the stale entry is still good. */
+    virtual void onNotModified() noexcept = 0;
+
+    /** The fetch failed; keep serving stale and try again later. */
+    virtual void onRevalidationFailed() noexcept = 0;
+  };
+
+  explicit CacheRevalidator(SessionPool* pool, Config config = Config());
+
+  /**
+   * Aborts in-flight revalidations; callbacks are not invoked.
+   */
+  ~CacheRevalidator();
+
+  /**
+   * Kick off a background refresh for the stale entry the request
+   * identifies.  Returns true if a revalidation is now (or already was)
+   * in flight for the key - when already in flight, the callback is NOT
+   * registered and will not fire.  Returns false when the token bucket
+   * is empty or the pool has no usable session; the caller keeps
+   * serving stale and retries on a later request.
+   */
+  bool revalidate(const HTTPMessage& request, Callback* callback);
+
+  /**
+   * Detach a callback; it will not be invoked.  The upstream fetch is
+   * left to finish so the work already paid for is not wasted.
+   */
+  void cancelRevalidation(Callback* callback);
+
+  size_t getNumInFlight() const {
+    return fetches_.size();
+  }
+
+  uint64_t getThrottledCount() const {
+    return throttledCount_;
+  }
+
+ private:
+  /**
+   * Handler for one background fetch.  Owns itself: the revalidator's
+   * map holds a raw pointer and the Fetch deletes itself on
+   * detachTransaction(), the usual handler lifecycle.
+   */
+  class Fetch : public HTTPTransaction::Handler {
+   public:
+    Fetch(CacheRevalidator* revalidator, std::string key, Callback* callback);
+
+    const std::string& getKey() const {
+      return key_;
+    }
+    void clearCallback(Callback* callback);
+    void abandon();
+
+    // HTTPTransaction::Handler
+    void setTransaction(HTTPTransaction* txn) noexcept override;
+    void detachTransaction() noexcept override;
+    void onHeadersComplete(std::unique_ptr<HTTPMessage> msg) noexcept override;
+    void onBody(std::unique_ptr<folly::IOBuf> chain) noexcept override;
+    void onChunkHeader(size_t length) noexcept override;
+    void onChunkComplete() noexcept override;
+    void onTrailers(std::unique_ptr<HTTPHeaders> trailers) noexcept override;
+    void onEOM() noexcept override;
+    void onUpgrade(UpgradeProtocol protocol) noexcept override;
+    void onError(const HTTPException& error) noexcept override;
+    void onEgressPaused() noexcept override;
+    void onEgressResumed() noexcept override;
+
+   private:
+    void complete();
+
+    CacheRevalidator* revalidator_;
+    const std::string key_;
+    Callback* callback_;
+    HTTPTransaction* txn_{nullptr};
+    std::unique_ptr<HTTPMessage> respHeaders_;
+    folly::IOBufQueue respBody_{folly::IOBufQueue::cacheChainLength()};
+  };
+
+  bool takeToken();
+  void fetchComplete(Fetch* fetch);
+
+  SessionPool* pool_;
+  const Config config_;
+  double tokens_;
+  std::chrono::steady_clock::time_point lastRefill_;
+  std::map<std::string, Fetch*> fetches_;
+  uint64_t throttledCount_{0};
+};
+
+} // namespace proxygen
@@ -0,0 +1,71 @@
+/*
+ *  Copyright (c) 2015-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include "proxygen/lib/http/connpool/EndpointSettingsCache.h"
+
+namespace proxygen {
+
+namespace {
+bool isWorthRemembering(SettingsId id) {
+  switch (id) {
+    case SettingsId::HEADER_TABLE_SIZE:
+    case SettingsId::MAX_CONCURRENT_STREAMS:
+    case SettingsId::INITIAL_WINDOW_SIZE:
+    case SettingsId::MAX_FRAME_SIZE:
+    case SettingsId::MAX_HEADER_LIST_SIZE:
+      return true;
+    default:
+      return false;
+  }
+}
+} // namespace
+
+EndpointSettingsCache::EndpointSettingsCache(Config config)
+    : config_(config) {
+}
+
+void EndpointSettingsCache::store(const Endpoint& endpoint,
+                                  const SettingsList& settings) {
+  SettingsList remembered;
+  for (const auto& setting : settings) {
+    if (isWorthRemembering(setting.id)) {
+      remembered.push_back(setting);
+    }
+  }
+  if (remembered.empty()) {
+    return;
+  }
+  auto it = entries_.find(endpoint);
+  if (it != entries_.end()) {
+    lru_.erase(it->second.lruIt);
+  } else if (entries_.size() >= config_.capacity) {
+    entries_.erase(lru_.back());
+    lru_.pop_back();
+  }
+  lru_.push_front(endpoint);
+  entries_[endpoint] =
+      Entry{std::move(remembered), getCurrentTime(), lru_.begin()};
+}
+
+folly::Optional<SettingsList> EndpointSettingsCache::lookup(
+    const Endpoint& endpoint) {
+  auto it = entries_.find(endpoint);
+  if (it == entries_.end()) {
+    return folly::none;
+  }
+  if (getCurrentTime() - it->second.storedAt > config_.maxAge) {
+    lru_.erase(it->second.lruIt);
+    entries_.erase(it);
+    return folly::none;
+  }
+  lru_.splice(lru_.begin(), lru_, it->second.lruIt);
+  return it->second.settings;
+}
+
+} // namespace proxygen
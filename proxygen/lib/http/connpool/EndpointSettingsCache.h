@@ -0,0 +1,77 @@
+/*
+ *  Copyright (c) 2015-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#pragma once
+
+#include <chrono>
+#include <list>
+#include <unordered_map>
+
+#include <folly/Optional.h>
+
+#include "proxygen/lib/http/codec/HTTPSettings.h"
+#include "proxygen/lib/http/connpool/Endpoint.h"
+#include "proxygen/lib/utils/Time.h"
+
+namespace proxygen {
+
+/**
+ * Remembers the SETTINGS a server advertised on previous connections, so
+ * a fresh session to the same endpoint can start from those values
+ * instead of the conservative protocol defaults while the real SETTINGS
+ * frame is in flight (the same optimism the TLS session/PSK caches apply
+ * to the handshake).  Servers change their settings rarely, so replaying
+ * the last observed values is almost always right; when it is not, the
+ * real frame corrects the connection through the normal path.
+ *
+ * Only the settings worth replaying are stored: table size, stream
+ * limit, window sizes, frame and header-list limits.  Like SessionPool,
+ * the cache is per worker and single-threaded.
+ */
+class EndpointSettingsCache {
+ public:
+  struct Config {
+    // Endpoints remembered before the least recently used is evicted.
+    size_t capacity{128};
+    // Entries older than this are dropped at lookup.
+    std::chrono::seconds maxAge{std::chrono::seconds(3600)};
+  };
+
+  explicit EndpointSettingsCache(Config config = Config());
+
+  /**
+   * Record the settings observed on a live session to this endpoint,
+   * replacing whatever was remembered before.
+   */
+  void store(const Endpoint& endpoint, const SettingsList& settings);
+
+  /**
+   * Remembered settings for the endpoint, or none if the endpoint is
+   * unknown or its entry has aged out.
+   */
+  folly::Optional<SettingsList> lookup(const Endpoint& endpoint);
+
+  size_t size() const {
+    return entries_.size();
+  }
+
+ private:
+  struct Entry {
+    SettingsList settings;
+    TimePoint storedAt;
+    std::list<Endpoint>::iterator lruIt;
+  };
+
+  const Config config_;
+  // Most recently used endpoint at the front.
+  std::list<Endpoint> lru_;
+  std::unordered_map<Endpoint, Entry, EndpointHash, EndpointEqual> entries_;
+};
+
+} // namespace proxygen
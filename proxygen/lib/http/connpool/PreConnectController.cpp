@@ -0,0 +1,239 @@
+/*
+ *  Copyright (c) 2015-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include "proxygen/lib/http/connpool/PreConnectController.h"
+
+#include <cmath>
+
+#include <folly/Random.h>
+#include <proxygen/lib/http/session/HTTPUpstreamSession.h>
+
+namespace proxygen {
+
+namespace {
+// Weight of the newest tick in the arrival rate EWMA.
+constexpr double kRateAlpha = 0.3;
+
+// Fire-and-forget handler for the priming OPTIONS request: the response
+// is irrelevant, the point is making the server resolve the route once
+// before real traffic lands on the session.
+class PrimingHandler : public HTTPTransactionHandler {
+ public:
+  void setTransaction(HTTPTransaction* /*txn*/) noexcept override {
+  }
+  void detachTransaction() noexcept override {
+    delete this;
+  }
+  void onHeadersComplete(
+      std::unique_ptr<HTTPMessage> /*msg*/) noexcept override {
+  }
+  void onBody(std::unique_ptr<folly::IOBuf> /*chain*/) noexcept override {
+  }
+  void onTrailers(std::unique_ptr<HTTPHeaders> /*trailers*/) noexcept override {
+  }
+  void onEOM() noexcept override {
+  }
+  void onUpgrade(UpgradeProtocol /*protocol*/) noexcept override {
+  }
+  void onError(const HTTPException& /*error*/) noexcept override {
+  }
+  void onEgressPaused() noexcept override {
+  }
+  void onEgressResumed() noexcept override {
+  }
+};
+} // namespace
+
+struct PreConnectController::PendingConnect : HTTPConnector::Callback {
+  explicit PendingConnect(PreConnectController& inParent)
+      : parent(inParent), connector(this, inParent.timeout_) {
+  }
+
+  void connectSuccess(HTTPUpstreamSession* session) override {
+    parent.onConnectSuccess(this, session);
+  }
+
+  void connectError(const folly::AsyncSocketException& ex) override {
+    parent.onConnectError(this, ex);
+  }
+
+  PreConnectController& parent;
+  HTTPConnector connector;
+};
+
+PreConnectController::PreConnectController(
+    folly::EventBase* evb,
+    SessionPool* pool,
+    Endpoint endpoint,
+    folly::SocketAddress connectAddr,
+    std::shared_ptr<folly::SSLContext> sslContext,
+    const WheelTimerInstance& timeout,
+    Config config)
+    : folly::AsyncTimeout(evb),
+      evb_(evb),
+      pool_(pool),
+      endpoint_(std::move(endpoint)),
+      connectAddr_(std::move(connectAddr)),
+      sslContext_(std::move(sslContext)),
+      timeout_(timeout),
+      config_(config),
+      backoffUntil_(getCurrentTime()) {
+  DCHECK(!endpoint_.isSecure() || sslContext_);
+}
+
+PreConnectController::~PreConnectController() {
+  stop();
+}
+
+void PreConnectController::start() {
+  CHECK(evb_->isInEventBaseThread());
+  started_ = true;
+  scheduleNextTick();
+}
+
+void PreConnectController::stop() {
+  started_ = false;
+  cancelTimeout();
+  // Deleting an HTTPConnector cancels its connect without callbacks.
+  pending_.clear();
+}
+
+void PreConnectController::noteRequest() {
+  ++arrivalsSinceTick_;
+}
+
+uint32_t PreConnectController::getWarmTarget() const {
+  auto windowSec =
+      std::chrono::duration_cast<std::chrono::duration<double>>(
+          config_.warmupWindow)
+          .count();
+  auto target = static_cast<uint32_t>(std::ceil(arrivalRate_ * windowSec));
+  return std::min(std::max(target, config_.minWarmSessions),
+                  config_.maxWarmSessions);
+}
+
+void PreConnectController::timeoutExpired() noexcept {
+  updateArrivalRate();
+  maybeDial();
+  scheduleNextTick();
+}
+
+void PreConnectController::updateArrivalRate() {
+  auto tickSec = std::chrono::duration_cast<std::chrono::duration<double>>(
+                     config_.interval)
+                     .count();
+  arrivalRate_ = kRateAlpha * (arrivalsSinceTick_ / tickSec) +
+                 (1 - kRateAlpha) * arrivalRate_;
+  arrivalsSinceTick_ = 0;
+}
+
+void PreConnectController::maybeDial() {
+  auto warm = pool_->getNumSessions() + pending_.size();
+  auto target = getWarmTarget();
+  if (warm >= target || getCurrentTime() < backoffUntil_) {
+    return;
+  }
+  auto deficit = std::min<size_t>(target - warm, config_.maxDialsPerTick);
+  VLOG(4) << "pre-connecting " << deficit << " session(s) to " << connectAddr_
+          << " (warm=" << warm << ", target=" << target << ")";
+  for (size_t i = 0; i < deficit; i++) {
+    dial();
+  }
+}
+
+void PreConnectController::scheduleNextTick() {
+  if (!started_) {
+    return;
+  }
+  // Jitter each tick so workers sharing a config do not dial in lockstep
+  auto spread = 1.0 + config_.jitter * (2 * folly::Random::randDouble01() - 1);
+  auto delay = std::chrono::milliseconds(std::max<int64_t>(
+      1, static_cast<int64_t>(config_.interval.count() * spread)));
+  scheduleTimeout(delay);
+}
+
+void PreConnectController::dial() {
+  pending_.push_back(std::make_unique<PendingConnect>(*this));
+  auto& connect = *pending_.back();
+  if (sslContext_) {
+    connect.connector.connectSSL(evb_,
+                                 connectAddr_,
+                                 sslContext_,
+                                 nullptr,
+                                 config_.connectTimeout,
+                                 folly::AsyncSocket::emptyOptionMap,
+                                 folly::AsyncSocket::anyAddress(),
+                                 endpoint_.getHostname());
+  } else {
+    connect.connector.connect(evb_, connectAddr_, config_.connectTimeout);
+  }
+}
+
+void PreConnectController::onConnectSuccess(PendingConnect* pending,
+                                            HTTPUpstreamSession* session) {
+  VLOG(4) << "pre-connected session to " << connectAddr_;
+  erasePending(pending);
+  warmSession(session);
+  pool_->putSession(session);
+}
+
+void PreConnectController::warmSession(HTTPUpstreamSession* session) {
+  if (config_.settingsCache) {
+    auto hint = config_.settingsCache->lookup(endpoint_);
+    if (hint) {
+      VLOG(4) << "applying remembered settings hint for " << connectAddr_;
+      session->applySettingsHint(*hint);
+    }
+    // SessionHolder preserves and forwards this, so the server's real
+    // SETTINGS are recorded even after the session enters the pool
+    session->setInfoCallback(&settingsRecorder_);
+  }
+  if (config_.primeNewSessions) {
+    primeSession(session);
+  }
+}
+
+void PreConnectController::primeSession(HTTPUpstreamSession* session) {
+  auto handler = new PrimingHandler();
+  auto txn = session->newTransaction(handler);
+  if (!txn) {
+    delete handler;
+    return;
+  }
+  HTTPMessage request;
+  request.setHTTPVersion(1, 1);
+  request.setMethod(HTTPMethod::OPTIONS);
+  request.setURL(config_.primingUrl);
+  request.getHeaders().set(HTTP_HEADER_HOST, endpoint_.getHostname());
+  txn->sendHeadersWithEOM(request);
+}
+
+void PreConnectController::SettingsRecorder::onSettings(
+    const HTTPSessionBase&, const SettingsList& settings) {
+  DCHECK(parent.config_.settingsCache);
+  parent.config_.settingsCache->store(parent.endpoint_, settings);
+}
+
+void PreConnectController::onConnectError(
+    PendingConnect* pending, const folly::AsyncSocketException& ex) {
+  VLOG(3) << "pre-connect to " << connectAddr_ << " failed: " << ex.what();
+  backoffUntil_ = getCurrentTime() + config_.errorBackoff;
+  erasePending(pending);
+}
+
+void PreConnectController::erasePending(PendingConnect* pending) {
+  for (auto it = pending_.begin(); it != pending_.end(); ++it) {
+    if (it->get() == pending) {
+      pending_.erase(it);
+      return;
+    }
+  }
+}
+
+} // namespace proxygen
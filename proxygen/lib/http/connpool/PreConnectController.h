@@ -0,0 +1,169 @@
+/*
+ *  Copyright (c) 2015-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#pragma once
+
+#include <chrono>
+#include <list>
+#include <memory>
+
+#include <folly/io/async/AsyncTimeout.h>
+#include <folly/io/async/EventBase.h>
+
+#include "proxygen/lib/http/HTTPConnector.h"
+#include "proxygen/lib/http/connpool/Endpoint.h"
+#include "proxygen/lib/http/connpool/EndpointSettingsCache.h"
+#include "proxygen/lib/http/connpool/SessionPool.h"
+
+namespace proxygen {
+
+/**
+ * PreConnectController keeps a per-worker SessionPool warm ahead of demand.
+ *
+ * It tracks the request arrival rate for one endpoint with an exponentially
+ * weighted moving average, derives a warm-session target from it, and dials
+ * new upstream connections through HTTPConnector whenever the pool (plus
+ * connects already in flight) falls short of that target. Each established
+ * session is handed to the pool with putSession(). Dials are paced by a
+ * jittered timer tick so a fleet of workers does not stampede the upstream
+ * with synchronized connects, and a connect error pauses dialing for a
+ * configurable backoff.
+ *
+ * Like SessionPool, this class is single-threaded: construct, drive, and
+ * destroy it in the pool's event base thread.
+ */
+class PreConnectController : private folly::AsyncTimeout {
+ public:
+  struct Config {
+    // Bounds on the warm-session target.
+    uint32_t minWarmSessions{0};
+    uint32_t maxWarmSessions{8};
+    // How much future demand the warm pool should cover; the target is
+    // ceil(arrival rate * warmupWindow), clamped to the bounds above.
+    std::chrono::milliseconds warmupWindow{std::chrono::milliseconds(250)};
+    // Base tick interval; each tick is jittered by +/- jitter * interval.
+    std::chrono::milliseconds interval{std::chrono::milliseconds(100)};
+    double jitter{0.2};
+    // At most this many connects are started per tick.
+    uint32_t maxDialsPerTick{2};
+    std::chrono::milliseconds connectTimeout{std::chrono::milliseconds(1000)};
+    // How long to stop dialing after a connect error.
+    std::chrono::milliseconds errorBackoff{std::chrono::milliseconds(1000)};
+    // Optional per-endpoint SETTINGS memory. Remembered values are
+    // applied to each new session before it enters the pool, and the
+    // settings the server then advertises are recorded back. Must
+    // outlive the controller; may be shared by the worker's controllers.
+    EndpointSettingsCache* settingsCache{nullptr};
+    // Send a single OPTIONS request on each new session before pooling
+    // it, warming server-side route caches ahead of real traffic.
+    bool primeNewSessions{false};
+    std::string primingUrl{"/"};
+  };
+
+  /**
+   * @param evb         The pool's event base.
+   * @param pool        Receives established sessions via putSession().
+   *                    Must outlive this controller.
+   * @param endpoint    The endpoint being warmed; the hostname doubles as
+   *                    the SNI name for secure dials.
+   * @param connectAddr Resolved address to dial.
+   * @param sslContext  SSL context for secure endpoints, nullptr for
+   *                    plaintext.
+   * @param timeout     Transaction timeout set for the new sessions.
+   */
+  PreConnectController(folly::EventBase* evb,
+                       SessionPool* pool,
+                       Endpoint endpoint,
+                       folly::SocketAddress connectAddr,
+                       std::shared_ptr<folly::SSLContext> sslContext,
+                       const WheelTimerInstance& timeout,
+                       Config config = Config());
+  ~PreConnectController() override;
+
+  /**
+   * Start/stop the pacing timer. stop() also cancels any connects still
+   * in flight.
+   */
+  void start();
+  void stop();
+
+  /**
+   * Callers report each request routed at the endpoint here so the
+   * controller can track the arrival rate. Cheap; call on every request.
+   */
+  void noteRequest();
+
+  /**
+   * Current warm-session target (exposed mainly for tests and stats).
+   */
+  uint32_t getWarmTarget() const;
+
+  double getArrivalRate() const {
+    return arrivalRate_;
+  }
+
+  size_t getNumPendingConnects() const {
+    return pending_.size();
+  }
+
+ protected:
+  void timeoutExpired() noexcept override;
+
+  /**
+   * Fold the arrivals seen since the last tick into the rate EWMA.
+   */
+  void updateArrivalRate();
+
+  /**
+   * Start up to maxDialsPerTick connects if the warm count is below target.
+   */
+  void maybeDial();
+
+ private:
+  struct PendingConnect;
+
+  // Records the settings each warmed session's server advertises into
+  // the endpoint cache; sessions keep it as their info callback in the
+  // pool (SessionHolder forwards to it).
+  struct SettingsRecorder : HTTPSessionBase::InfoCallback {
+    explicit SettingsRecorder(PreConnectController& inParent)
+        : parent(inParent) {
+    }
+    void onSettings(const HTTPSessionBase&,
+                    const SettingsList& settings) override;
+    PreConnectController& parent;
+  };
+
+  void scheduleNextTick();
+  void dial();
+  void warmSession(HTTPUpstreamSession* session);
+  void primeSession(HTTPUpstreamSession* session);
+  void onConnectSuccess(PendingConnect* pending, HTTPUpstreamSession* session);
+  void onConnectError(PendingConnect* pending,
+                      const folly::AsyncSocketException& ex);
+  void erasePending(PendingConnect* pending);
+
+  folly::EventBase* const evb_;
+  SessionPool* const pool_;
+  const Endpoint endpoint_;
+  const folly::SocketAddress connectAddr_;
+  const std::shared_ptr<folly::SSLContext> sslContext_;
+  const WheelTimerInstance timeout_;
+  const Config config_;
+
+  std::list<std::unique_ptr<PendingConnect>> pending_;
+  SettingsRecorder settingsRecorder_{*this};
+  // Requests per second, updated once per tick.
+  double arrivalRate_{0};
+  uint64_t arrivalsSinceTick_{0};
+  TimePoint backoffUntil_;
+  bool started_{false};
+};
+
+} // namespace proxygen
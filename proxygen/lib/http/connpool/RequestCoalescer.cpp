@@ -0,0 +1,194 @@
+/*
+ *  Copyright (c) 2019-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include "proxygen/lib/http/connpool/RequestCoalescer.h"
+
+#include <algorithm>
+#include <folly/Conv.h>
+
+namespace proxygen {
+
+RequestCoalescer::RequestCoalescer(SessionPool* pool) : pool_(pool) {
+  CHECK(pool_);
+}
+
+RequestCoalescer::~RequestCoalescer() {
+  for (auto& kv : fetches_) {
+    kv.second->abandon();
+  }
+  fetches_.clear();
+}
+
+bool RequestCoalescer::isCoalescible(const HTTPMessage& request) {
+  const auto method = request.getMethod();
+  return method == HTTPMethod::GET || method == HTTPMethod::HEAD;
+}
+
+std::string RequestCoalescer::makeKey(const HTTPMessage& request) const {
+  std::string key = folly::to<std::string>(
+      request.getMethodString(),
+      ' ',
+      request.getHeaders().getSingleOrEmpty(HTTP_HEADER_HOST),
+      ' ',
+      request.getURL());
+  for (const auto& name : varyHeaders_) {
+    key += '\0';
+    key += request.getHeaders().getSingleOrEmpty(name);
+  }
+  return key;
+}
+
+bool RequestCoalescer::sendRequest(const HTTPMessage& request,
+                                   Callback* callback) {
+  DCHECK(isCoalescible(request));
+  auto key = makeKey(request);
+  auto it = fetches_.find(key);
+  if (it != fetches_.end()) {
+    coalescedCount_++;
+    it->second->addFollower(callback);
+    return true;
+  }
+  auto fetch = std::make_unique<Fetch>(this, key);
+  auto txn = pool_->getTransaction(fetch.get());
+  if (!txn) {
+    return false;
+  }
+  fetch->addFollower(callback);
+  fetches_.emplace(std::move(key), fetch.get());
+  txn->sendHeadersWithEOM(request);
+  // Owns itself now; deleted on detachTransaction
+  fetch.release();
+  return true;
+}
+
+void RequestCoalescer::cancelRequest(Callback* callback) {
+  for (auto& kv : fetches_) {
+    auto fetch = kv.second;
+    if (fetch->removeFollower(callback)) {
+      if (!fetch->hasFollowers()) {
+        // Nobody is waiting for this response any more
+        fetch->abandon();
+        fetches_.erase(kv.first);
+      }
+      return;
+    }
+  }
+}
+
+void RequestCoalescer::fetchComplete(Fetch* fetch) {
+  fetches_.erase(fetch->getKey());
+}
+
+RequestCoalescer::Fetch::Fetch(RequestCoalescer* coalescer, std::string key)
+    : coalescer_(coalescer), key_(std::move(key)) {
+}
+
+void RequestCoalescer::Fetch::addFollower(Callback* callback) {
+  followers_.push_back(callback);
+  // Replay the response so far so every follower sees the full message
+  if (respHeaders_) {
+    callback->onHeadersComplete(std::make_unique<HTTPMessage>(*respHeaders_));
+    if (!respBody_.empty()) {
+      callback->onBody(respBody_.front()->clone());
+    }
+  }
+}
+
+bool RequestCoalescer::Fetch::removeFollower(Callback* callback) {
+  auto it = std::find(followers_.begin(), followers_.end(), callback);
+  if (it == followers_.end()) {
+    return false;
+  }
+  followers_.erase(it);
+  return true;
+}
+
+void RequestCoalescer::Fetch::abandon() {
+  followers_.clear();
+  coalescer_ = nullptr;
+  if (txn_) {
+    txn_->sendAbort();
+  }
+}
+
+void RequestCoalescer::Fetch::complete() {
+  if (coalescer_) {
+    coalescer_->fetchComplete(this);
+    coalescer_ = nullptr;
+  }
+  followers_.clear();
+}
+
+void RequestCoalescer::Fetch::setTransaction(HTTPTransaction* txn) noexcept {
+  txn_ = txn;
+}
+
+void RequestCoalescer::Fetch::detachTransaction() noexcept {
+  complete();
+  delete this;
+}
+
+void RequestCoalescer::Fetch::onHeadersComplete(
+    std::unique_ptr<HTTPMessage> msg) noexcept {
+  respHeaders_ = std::move(msg);
+  for (auto callback : followers_) {
+    callback->onHeadersComplete(std::make_unique<HTTPMessage>(*respHeaders_));
+  }
+}
+
+void RequestCoalescer::Fetch::onBody(
+    std::unique_ptr<folly::IOBuf> chain) noexcept {
+  if (!chain || chain->computeChainDataLength() == 0) {
+    return;
+  }
+  // Clones share the underlying buffers; the bytes are written once and
+  // fanned out by reference
+  for (auto callback : followers_) {
+    callback->onBody(chain->clone());
+  }
+  respBody_.append(std::move(chain));
+}
+
+void RequestCoalescer::Fetch::onChunkHeader(size_t /*length*/) noexcept {
+}
+
+void RequestCoalescer::Fetch::onChunkComplete() noexcept {
+}
+
+void RequestCoalescer::Fetch::onTrailers(
+    std::unique_ptr<HTTPHeaders> trailers) noexcept {
+  for (auto callback : followers_) {
+    callback->onTrailers(std::make_unique<HTTPHeaders>(*trailers));
+  }
+}
+
+void RequestCoalescer::Fetch::onEOM() noexcept {
+  for (auto callback : followers_) {
+    callback->onEOM();
+  }
+  complete();
+}
+
+void RequestCoalescer::Fetch::onUpgrade(UpgradeProtocol /*protocol*/) noexcept {
+}
+
+void RequestCoalescer::Fetch::onError(const HTTPException& error) noexcept {
+  for (auto callback : followers_) {
+    callback->onError(error);
+  }
+  complete();
+}
+
+void RequestCoalescer::Fetch::onEgressPaused() noexcept {
+}
+
+void RequestCoalescer::Fetch::onEgressResumed() noexcept {
+}
+
+} // namespace proxygen
@@ -0,0 +1,164 @@
+/*
+ *  Copyright (c) 2019-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#pragma once
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include <folly/io/IOBufQueue.h>
+
+#include "proxygen/lib/http/connpool/SessionPool.h"
+#include "proxygen/lib/http/session/HTTPTransaction.h"
+
+namespace proxygen {
+
+/**
+ * A collapsed-forwarding layer over SessionPool.
+ *
+ * Concurrent idempotent requests with the same cache key (method,
+ * authority, path, plus a configurable subset of vary headers) share one
+ * upstream transaction: the first request becomes the leader and opens a
+ * transaction through the pool, later arrivals attach as followers.  The
+ * response fans out to every attached callback; headers are copied per
+ * follower, body is delivered as clones of the same immutable IOBuf
+ * chain, so the bytes themselves are never duplicated.  The response so
+ * far is buffered until EOM so followers attaching mid-response see the
+ * full message; once a fetch completes its entry is gone -- this
+ * deduplicates in-flight fetches, it is not a response cache.
+ *
+ * Like SessionPool, this class is single-threaded.
+ */
+class RequestCoalescer {
+ public:
+  /**
+   * Response callback for attached requests.  Every attached request --
+   * the one that triggered the fetch included -- observes the response
+   * through this interface, never through the transaction directly.
+   */
+  class Callback {
+   public:
+    virtual ~Callback() = default;
+    virtual void onHeadersComplete(
+        std::unique_ptr<HTTPMessage> msg) noexcept = 0;
+    virtual void onBody(std::unique_ptr<folly::IOBuf> chain) noexcept = 0;
+    virtual void onTrailers(
+        std::unique_ptr<HTTPHeaders> trailers) noexcept = 0;
+    virtual void onEOM() noexcept = 0;
+    virtual void onError(const HTTPException& error) noexcept = 0;
+  };
+
+  explicit RequestCoalescer(SessionPool* pool);
+
+  /**
+   * Aborts any in-flight fetches; attached callbacks are not invoked.
+   */
+  ~RequestCoalescer();
+
+  /**
+   * Only requests that are safe to collapse qualify: GET or HEAD with no
+   * body.  Callers must route anything else to the pool directly.
+   */
+  static bool isCoalescible(const HTTPMessage& request);
+
+  /**
+   * Send a request, attaching to an identical in-flight fetch when one
+   * exists.  The request must satisfy isCoalescible().  Returns false if
+   * a new upstream transaction was needed but the pool had no usable
+   * session; the caller falls back as it would for
+   * SessionPool::getTransaction() returning nullptr.
+   */
+  bool sendRequest(const HTTPMessage& request, Callback* callback);
+
+  /**
+   * Detach a callback from whatever fetch it is attached to; it will not
+   * be invoked again.  Aborts the upstream fetch if no other callback
+   * remains attached.
+   */
+  void cancelRequest(Callback* callback);
+
+  /**
+   * Header names (beyond method, authority and path) whose values
+   * participate in the cache key.  Defaults to Accept-Encoding.
+   */
+  void setVaryHeaders(std::vector<std::string> varyHeaders) {
+    varyHeaders_ = std::move(varyHeaders);
+  }
+
+  std::string makeKey(const HTTPMessage& request) const;
+
+  size_t getNumInFlightFetches() const {
+    return fetches_.size();
+  }
+
+  uint64_t getCoalescedCount() const {
+    return coalescedCount_;
+  }
+
+ private:
+  /**
+   * The leader handler for one deduplicated upstream fetch.  Buffers the
+   * response and fans it out to attached callbacks.  Owns itself: the
+   * coalescer's map holds a raw pointer and the Fetch deletes itself on
+   * detachTransaction(), the usual handler lifecycle.
+   */
+  class Fetch : public HTTPTransaction::Handler {
+   public:
+    Fetch(RequestCoalescer* coalescer, std::string key);
+
+    void addFollower(Callback* callback);
+    bool removeFollower(Callback* callback);
+    bool hasFollowers() const {
+      return !followers_.empty();
+    }
+    const std::string& getKey() const {
+      return key_;
+    }
+    /**
+     * Called by the coalescer when it is destroyed first: detach all
+     * followers and abort the upstream transaction.
+     */
+    void abandon();
+
+    // HTTPTransaction::Handler
+    void setTransaction(HTTPTransaction* txn) noexcept override;
+    void detachTransaction() noexcept override;
+    void onHeadersComplete(std::unique_ptr<HTTPMessage> msg) noexcept override;
+    void onBody(std::unique_ptr<folly::IOBuf> chain) noexcept override;
+    void onChunkHeader(size_t length) noexcept override;
+    void onChunkComplete() noexcept override;
+    void onTrailers(std::unique_ptr<HTTPHeaders> trailers) noexcept override;
+    void onEOM() noexcept override;
+    void onUpgrade(UpgradeProtocol protocol) noexcept override;
+    void onError(const HTTPException& error) noexcept override;
+    void onEgressPaused() noexcept override;
+    void onEgressResumed() noexcept override;
+
+   private:
+    void complete();
+
+    RequestCoalescer* coalescer_;
+    const std::string key_;
+    HTTPTransaction* txn_{nullptr};
+    std::vector<Callback*> followers_;
+    // Response so far, replayed to followers that attach mid-response
+    std::unique_ptr<HTTPMessage> respHeaders_;
+    folly::IOBufQueue respBody_{folly::IOBufQueue::cacheChainLength()};
+  };
+
+  void fetchComplete(Fetch* fetch);
+
+  SessionPool* pool_;
+  std::vector<std::string> varyHeaders_{"Accept-Encoding"};
+  std::map<std::string, Fetch*> fetches_;
+  uint64_t coalescedCount_{0};
+};
+
+} // namespace proxygen
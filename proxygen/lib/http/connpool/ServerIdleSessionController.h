@@ -11,6 +11,8 @@
 
 #include "proxygen/lib/http/connpool/SessionPool.h"
 
+#include <atomic>
+#include <folly/MPMCQueue.h>
 #include <folly/futures/Future.h>
 
 namespace proxygen {
@@ -24,16 +26,42 @@ namespace proxygen {
  */
 class ServerIdleSessionController {
  public:
-  explicit ServerIdleSessionController(unsigned int maxIdleCount = 2)
-      : maxIdleCount_(maxIdleCount) {
+  explicit ServerIdleSessionController(unsigned int maxIdleCount = 2,
+                                       size_t exchangeCapacity = 64)
+      : transferExchange_(exchangeCapacity),
+        maxIdleCount_(maxIdleCount),
+        exchangeCapacity_(exchangeCapacity) {
   }
 
   /**
    * Transfer idle session from another thread, if available.
    * Returns nullptr if nothing is available.
+   *
+   * If the lock-free exchange holds a pre-detached session, the returned
+   * future is already fulfilled and no cross-thread hop takes place.
+   * Otherwise the session is detached in its owning thread and delivered
+   * via the future as before.
    */
   folly::Future<HTTPSessionBase*> getIdleSession();
 
+  /**
+   * Detach the given idle session from its thread locals and publish it
+   * on the lock-free exchange, where any thread can claim it with
+   * popDetachedIdleSession(). Must be called from the session's event base
+   * thread, with a session that has already been released from its pool.
+   *
+   * Returns false (leaving the session attached and untouched) if the
+   * exchange is full or the controller is marked for death.
+   */
+  bool parkDetachedIdleSession(HTTPSessionBase* session);
+
+  /**
+   * Claim a pre-detached session from the exchange, or nullptr if it is
+   * empty. Wait-free; may be called from any thread. The caller owns the
+   * session and must attachThreadLocals() it before use.
+   */
+  HTTPSessionBase* FOLLY_NULLABLE popDetachedIdleSession();
+
   /**
    * Add/remove session info (called by SessionPool when state changes).
    */
@@ -61,11 +89,17 @@ class ServerIdleSessionController {
   SessionPool* FOLLY_NULLABLE popBestIdlePool();
 
   bool isMarkedForDeath() {
-    std::lock_guard<std::mutex> lock(lock_);
-    return markedForDeath_;
+    return markedForDeath_.load(std::memory_order_acquire);
   }
 
   std::mutex lock_;
+  /*
+   * Bounded MPMC exchange of sessions that have already been detached from
+   * their thread locals. Writers reserve a slot in parkedCount_ first so a
+   * session is never detached unless it is guaranteed to be published.
+   */
+  folly::MPMCQueue<HTTPSessionBase*> transferExchange_;
+  std::atomic<uint32_t> parkedCount_{0};
   /*
    * List of idle sessions. Normally, addIdleSession() adds to the end and
    * popBestIdlePool() removes from the beginning, thus keeping the list sorted
@@ -77,9 +111,10 @@ class ServerIdleSessionController {
   IdleSessionList sessionsByIdleAge_;
   // Store iterators in sessionsByIdleAge_ to be able to find sessions.
   std::unordered_map<const HTTPSessionBase*, IdleSessionListIter> sessionMap_;
-  bool markedForDeath_{false};
+  std::atomic<bool> markedForDeath_{false};
 
   const unsigned int maxIdleCount_;
+  const size_t exchangeCapacity_;
 };
 
 } // namespace proxygen
@@ -18,6 +18,15 @@ using folly::SocketAddress;
 
 namespace {
 const double kJitterPct = 0.3;
+
+// Quality score tuning; see SessionHolder::getQualityScore.  All terms
+// are in TTFB-equivalent milliseconds, lower scores being better.
+const double kTTFBSampleWeight = 0.25;   // EWMA weight of a new sample
+const double kColdSessionScoreMs = 500;  // score with no TTFB sample yet
+const double kCongestionPenaltyMs = 50;  // per recent congestion event
+const double kPendingTxnPenaltyMs = 10;  // per in-flight transaction
+const double kIdleDecayPerMs = 0.01;     // fade toward cold while idle
+const uint32_t kMaxCongestionEvents = 16;
 }
 
 namespace proxygen {
@@ -68,6 +77,21 @@ std::chrono::steady_clock::time_point SessionHolder::getLastUseTime() const {
   return lastUseTime_;
 }
 
+double SessionHolder::getQualityScore() const {
+  double score = ttfbEwmaMs_ >= 0 ? ttfbEwmaMs_ : kColdSessionScoreMs;
+  score += congestionEvents_ * kCongestionPenaltyMs;
+  score += session_->getNumOutgoingStreams() * kPendingTxnPenaltyMs;
+  if (ttfbEwmaMs_ >= 0 && score < kColdSessionScoreMs) {
+    // Fade a proven score toward cold the longer the session sits
+    // unused; its congestion window is fading with it
+    auto idleMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+                      std::chrono::steady_clock::now() - lastUseTime_)
+                      .count();
+    score = std::min(score + idleMs * kIdleDecayPerMs, kColdSessionScoreMs);
+  }
+  return score;
+}
+
 void SessionHolder::drain() {
   VLOG(4) << "draining holder=" << *this;
   if (state_ != ListState::DETACHED) {
@@ -184,6 +208,12 @@ void SessionHolder::onWrite(const HTTPSessionBase& session,
 }
 
 void SessionHolder::onRequestBegin(const HTTPSessionBase& session) {
+  if (!awaitingFirstResponse_) {
+    // TTFB measurement; with concurrent requests outstanding only the
+    // earliest one is timed, which is the conservative sample
+    awaitingFirstResponse_ = true;
+    requestBeginTime_ = std::chrono::steady_clock::now();
+  }
   if (originalSessionInfoCb_) {
     originalSessionInfoCb_->onRequestBegin(session);
   }
@@ -231,12 +261,31 @@ void SessionHolder::onDestroy(const HTTPSessionBase& session) {
 
 void SessionHolder::onIngressMessage(const HTTPSessionBase& session,
                                      const HTTPMessage& msg) {
+  if (awaitingFirstResponse_) {
+    awaitingFirstResponse_ = false;
+    double sampleMs =
+        std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - requestBeginTime_)
+            .count();
+    if (ttfbEwmaMs_ < 0) {
+      ttfbEwmaMs_ = sampleMs;
+    } else {
+      ttfbEwmaMs_ = kTTFBSampleWeight * sampleMs +
+                    (1 - kTTFBSampleWeight) * ttfbEwmaMs_;
+    }
+    // Each completed measurement also decays the congestion count, so
+    // old incidents stop tainting a session that has recovered
+    congestionEvents_ /= 2;
+  }
   if (originalSessionInfoCb_) {
     originalSessionInfoCb_->onIngressMessage(session, msg);
   }
 }
 
 void SessionHolder::onIngressLimitExceeded(const HTTPSessionBase& session) {
+  if (congestionEvents_ < kMaxCongestionEvents) {
+    congestionEvents_++;
+  }
   if (originalSessionInfoCb_) {
     originalSessionInfoCb_->onIngressLimitExceeded(session);
   }
@@ -290,12 +339,18 @@ void SessionHolder::onSettingsOutgoingStreamsNotFull(
 }
 
 void SessionHolder::onFlowControlWindowClosed(const HTTPSessionBase& session) {
+  if (congestionEvents_ < kMaxCongestionEvents) {
+    congestionEvents_++;
+  }
   if (originalSessionInfoCb_) {
     originalSessionInfoCb_->onFlowControlWindowClosed(session);
   }
 }
 
 void SessionHolder::onEgressBuffered(const HTTPSessionBase& session) {
+  if (congestionEvents_ < kMaxCongestionEvents) {
+    congestionEvents_++;
+  }
   if (originalSessionInfoCb_) {
     originalSessionInfoCb_->onEgressBuffered(session);
   }
@@ -104,6 +104,18 @@ class SessionHolder : private HTTPSessionBase::InfoCallback {
   bool shouldAgeOut(std::chrono::milliseconds maxAge) const;
   void describe(std::ostream& os) const;
 
+  /**
+   * Quality score for upstream selection; lower is better.  Built from
+   * events the holder already observes: a TTFB (request begin to first
+   * response message) EWMA, recent congestion signals (closed flow
+   * control windows, buffered egress, ingress limit), the session's
+   * in-flight transaction count, and how long it has sat idle - a
+   * proven-fast session fades toward cold while unused, since its
+   * congestion window fades with it.  Sessions with no TTFB sample yet
+   * score as cold.  See SessionPool::setQualityAwareSelection.
+   */
+  double getQualityScore() const;
+
   Endpoint getEndpoint() {
     return endpoint_;
   }
@@ -146,6 +158,10 @@ class SessionHolder : private HTTPSessionBase::InfoCallback {
   // Hook in the second session pool list if necessary.
   folly::SafeIntrusiveListHook secondaryListHook;
 
+  // Expiry epoch of the idle bucket this holder sits in; written by
+  // ThreadIdleSessionController so detach can find the bucket directly.
+  uint64_t idleEpoch{0};
+
  private:
   void handleTransactionDetached();
 
@@ -164,6 +180,12 @@ class SessionHolder : private HTTPSessionBase::InfoCallback {
   ListState state_{ListState::DETACHED};
   Endpoint endpoint_;
   HTTPSessionBase::InfoCallback* originalSessionInfoCb_;
+
+  // Quality tracking; see getQualityScore()
+  double ttfbEwmaMs_{-1};
+  std::chrono::steady_clock::time_point requestBeginTime_;
+  bool awaitingFirstResponse_{false};
+  uint32_t congestionEvents_{0};
 };
 typedef folly::CountedIntrusiveList<SessionHolder, &SessionHolder::listHook>
     SessionList;
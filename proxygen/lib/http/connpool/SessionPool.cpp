@@ -162,7 +162,7 @@ HTTPTransaction* SessionPool::attemptOpenTransaction(
     HTTPTransaction::Handler* upstreamHandler, SessionList& list) {
   SessionHolder* holder = nullptr;
   while (!list.empty()) {
-    holder = &list.front();
+    holder = qualityAwareSelection_ ? pickBestQuality(list) : &list.front();
     if (holder->shouldAgeOut(maxAge_)) {
       holder->drain(); // implicit unlink and delete
       continue;
@@ -179,6 +179,19 @@ HTTPTransaction* SessionPool::attemptOpenTransaction(
   return nullptr;
 }
 
+SessionHolder* SessionPool::pickBestQuality(SessionList& list) {
+  SessionHolder* best = &list.front();
+  double bestScore = best->getQualityScore();
+  for (auto& holder : list) {
+    double score = holder.getQualityScore();
+    if (score < bestScore) {
+      best = &holder;
+      bestScore = score;
+    }
+  }
+  return best;
+}
+
 // SessionHolder::Callback methods
 
 void SessionPool::detachIdle(SessionHolder* sess) {
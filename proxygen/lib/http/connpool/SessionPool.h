@@ -86,6 +86,19 @@ class SessionPool : private SessionHolder::Callback {
   void setTimeout(std::chrono::milliseconds);
   std::chrono::milliseconds getTimeout() const;
 
+  /**
+   * When enabled, getTransaction() picks the idle session with the best
+   * quality score (see SessionHolder::getQualityScore) instead of the
+   * front of the FIFO, preferring proven-fast warm sessions over stale
+   * cold ones that would pay the slow-start tax.  The score's
+   * congestion and staleness penalties take over the FIFO's role of
+   * keeping load off slow servers.  Selection scans the idle list, so
+   * the cost is bounded by the idle session cap.
+   */
+  void setQualityAwareSelection(bool enabled) {
+    qualityAwareSelection_ = enabled;
+  }
+
   /**
    * Returns the number of idle sessions. That is, sessions with no open
    * outgoing transactions.
@@ -198,6 +211,12 @@ class SessionPool : private SessionHolder::Callback {
   HTTPTransaction* attemptOpenTransaction(
       HTTPTransaction::Handler* upstreamHandler, SessionList& list);
 
+  /**
+   * Returns the holder with the best (lowest) quality score in the
+   * non-empty list.
+   */
+  SessionHolder* pickBestQuality(SessionList& list);
+
   // SessionHolder::Callback methods
   void detachIdle(SessionHolder*) override;
   void detachPartiallyFilled(SessionHolder*) override;
@@ -212,6 +231,8 @@ class SessionPool : private SessionHolder::Callback {
   uint32_t maxConns_;
   std::chrono::milliseconds timeout_;
   std::chrono::milliseconds maxAge_;
+  // Pick idle sessions by quality score instead of FIFO order
+  bool qualityAwareSelection_{false};
 
   // List of all idle sessions in this SessionPool. Sessions
   // are sorted in descending order of lastUseTime in the list.
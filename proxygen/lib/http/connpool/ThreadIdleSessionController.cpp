@@ -9,30 +9,104 @@
  */
 #include "proxygen/lib/http/connpool/ThreadIdleSessionController.h"
 
+#include <algorithm>
+#include <glog/logging.h>
+#include <proxygen/lib/utils/Time.h>
+
+namespace {
+
+// Cross-thread gauge of idle sessions; relaxed is fine since readers
+// only need an approximate figure for pool sizing
+std::atomic<uint64_t> gGlobalIdleSessions{0};
+
+} // namespace
+
 namespace proxygen {
 
 ThreadIdleSessionController::ThreadIdleSessionController(
-    uint32_t totalIdleSessions)
-    : totalIdleSessions_(totalIdleSessions) {
+    uint32_t totalIdleSessions, std::chrono::milliseconds idleTimeout)
+    : totalIdleSessions_(totalIdleSessions),
+      tickInterval_(std::max(idleTimeout / 10, std::chrono::milliseconds(10))),
+      timeoutTicks_(idleTimeout.count() > 0
+                        ? (idleTimeout + tickInterval_ -
+                           std::chrono::milliseconds(1)) /
+                              tickInterval_
+                        : 0) {
+}
+
+uint64_t ThreadIdleSessionController::currentEpoch() const {
+  return millisecondsSinceEpoch().count() / tickInterval_.count();
+}
+
+ThreadIdleSessionController::Bucket& ThreadIdleSessionController::bucketFor(
+    uint64_t epoch) {
+  // attaches are in time order, so the bucket is at the back or new
+  if (buckets_.empty() || buckets_.back().epoch < epoch) {
+    buckets_.emplace_back(epoch);
+  }
+  return buckets_.back();
 }
 
 void ThreadIdleSessionController::onAttachIdle(SessionHolder* holder) {
-  idleSessionsLRU_.push_back(*holder);
+  auto epoch = currentEpoch();
+  holder->idleEpoch = epoch;
+  bucketFor(epoch).sessions.push_back(*holder);
+  ++numIdle_;
+  gGlobalIdleSessions.fetch_add(1, std::memory_order_relaxed);
   purgeExcessIdleSessions();
 }
 
 void ThreadIdleSessionController::onDetachIdle(SessionHolder* holder) {
-  idleSessionsLRU_.erase(idleSessionsLRU_.iterator_to(*holder));
+  // buckets_ is sorted by epoch; find the holder's bucket directly
+  auto it = std::lower_bound(buckets_.begin(),
+                             buckets_.end(),
+                             holder->idleEpoch,
+                             [](const Bucket& bucket, uint64_t epoch) {
+                               return bucket.epoch < epoch;
+                             });
+  CHECK(it != buckets_.end() && it->epoch == holder->idleEpoch);
+  it->sessions.erase(it->sessions.iterator_to(*holder));
+  --numIdle_;
+  gGlobalIdleSessions.fetch_sub(1, std::memory_order_relaxed);
+  trimEmptyBuckets();
 }
 
 void ThreadIdleSessionController::purgeExcessIdleSessions() {
-  while (idleSessionsLRU_.size() > totalIdleSessions_) {
-    SessionHolder& holder = idleSessionsLRU_.front();
+  while (numIdle_ > totalIdleSessions_) {
+    // oldest bucket first; trimEmptyBuckets keeps the front non-empty
+    SessionHolder& holder = buckets_.front().sessions.front();
     holder.drain();
   }
 }
 
+void ThreadIdleSessionController::purgeExpiredIdleSessions() {
+  if (timeoutTicks_ == 0) {
+    return;
+  }
+  auto nowEpoch = currentEpoch();
+  while (!buckets_.empty() &&
+         buckets_.front().epoch + timeoutTicks_ <= nowEpoch) {
+    // the whole bucket expired together; live buckets are never touched
+    auto& bucket = buckets_.front();
+    while (!bucket.sessions.empty()) {
+      bucket.sessions.front().drain();
+    }
+    trimEmptyBuckets();
+  }
+}
+
+void ThreadIdleSessionController::trimEmptyBuckets() {
+  while (!buckets_.empty() && buckets_.front().sessions.empty()) {
+    buckets_.pop_front();
+  }
+}
+
 uint32_t ThreadIdleSessionController::getTotalIdleSessions() const {
-  return idleSessionsLRU_.size();
+  return numIdle_;
+}
+
+uint64_t ThreadIdleSessionController::getGlobalIdleSessions() {
+  return gGlobalIdleSessions.load(std::memory_order_relaxed);
 }
+
 } // namespace proxygen
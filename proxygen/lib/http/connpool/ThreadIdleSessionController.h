@@ -9,6 +9,9 @@
  */
 #pragma once
 
+#include <atomic>
+#include <deque>
+
 #include "proxygen/lib/http/connpool/SessionHolder.h"
 #include "proxygen/lib/http/connpool/SessionPool.h"
 
@@ -26,6 +29,13 @@
  *    * If you have an uneven number of connections to upstream destinations,
  *    reclaiming connections to lesser used destinations will allow for better
  *    usage of the resources in the system.
+ *
+ * Idle sessions are bucketed timing-wheel style by expiry epoch: all
+ * sessions share one idle timeout, so expiry order is attach order and
+ * every session going idle in the same quantized tick shares a bucket.
+ * A time-based purge drains whole expired buckets off the front and
+ * never walks live sessions, keeping purge cost proportional to what
+ * actually expired rather than to pool size.
  */
 namespace proxygen {
 
@@ -35,8 +45,12 @@ class ThreadIdleSessionController {
    * Construct an idle session controller.
    * @param totalIdleSessions The maximum number of idle sessions on a given
    * thread.
+   * @param idleTimeout If nonzero, sessions idle for longer than this are
+   * drained by purgeExpiredIdleSessions().
    */
-  explicit ThreadIdleSessionController(uint32_t totalIdleSessions = 0);
+  explicit ThreadIdleSessionController(
+      uint32_t totalIdleSessions = 0,
+      std::chrono::milliseconds idleTimeout = std::chrono::milliseconds(0));
   /*
    * Callback used to indicate a new session has been attached.
    */
@@ -52,14 +66,46 @@ class ThreadIdleSessionController {
    */
   void purgeExcessIdleSessions();
 
+  /**
+   * Drains every session whose idle timeout has elapsed.  Only expired
+   * buckets are touched, so this is safe to call from a periodic timer
+   * even with very large idle pools.  No-op when no idle timeout was
+   * given.
+   */
+  void purgeExpiredIdleSessions();
+
   /**
    * Get the number of total idle sessions.
    */
   uint32_t getTotalIdleSessions() const;
 
+  /**
+   * Process-wide count of idle sessions across every controller on
+   * every thread, for pool-sizing logic.  Maintained with relaxed
+   * atomics, so reads are cheap and approximately current.
+   */
+  static uint64_t getGlobalIdleSessions();
+
  private:
+  // Sessions going idle in the same tick share a bucket; buckets_ is
+  // ordered by epoch, and ticks with no attaches get no bucket
+  struct Bucket {
+    explicit Bucket(uint64_t epochIn) : epoch(epochIn) {
+    }
+    uint64_t epoch;
+    SecondarySessionList sessions;
+  };
+
+  uint64_t currentEpoch() const;
+  Bucket& bucketFor(uint64_t epoch);
+  void trimEmptyBuckets();
+
   uint32_t totalIdleSessions_;
-  SecondarySessionList idleSessionsLRU_;
+  const std::chrono::milliseconds tickInterval_;
+  // Number of ticks a session may sit idle; 0 disables expiry
+  const uint64_t timeoutTicks_;
+  std::deque<Bucket> buckets_;
+  size_t numIdle_{0};
 };
 
 } // namespace proxygen
@@ -0,0 +1,161 @@
+/*
+ *  Copyright (c) 2019-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include "proxygen/lib/http/connpool/CacheRevalidator.h"
+#include "proxygen/lib/http/connpool/test/SessionPoolTestFixture.h"
+
+using namespace proxygen;
+using namespace testing;
+
+namespace {
+
+class RecordingCallback : public CacheRevalidator::Callback {
+ public:
+  void onRevalidated(std::unique_ptr<HTTPMessage> headers,
+                     std::unique_ptr<folly::IOBuf> body) noexcept override {
+    revalidated++;
+    headers_ = std::move(headers);
+    bodyBytes = body ? body->computeChainDataLength() : 0;
+  }
+  void onNotModified() noexcept override {
+    notModified++;
+  }
+  void onRevalidationFailed() noexcept override {
+    failed++;
+  }
+
+  uint32_t revalidated{0};
+  uint32_t notModified{0};
+  uint32_t failed{0};
+  uint64_t bodyBytes{0};
+  std::unique_ptr<HTTPMessage> headers_;
+};
+
+HTTPMessage makeRevalidationRequest(const std::string& path) {
+  HTTPMessage req;
+  req.setMethod(HTTPMethod::GET);
+  req.setHTTPVersion(1, 1);
+  req.setURL(path);
+  req.getHeaders().set(HTTP_HEADER_HOST, "www.facebook.com");
+  req.getHeaders().set(HTTP_HEADER_IF_NONE_MATCH, "\"stale-etag\"");
+  return req;
+}
+
+} // namespace
+
+class CacheRevalidatorFixture : public SessionPoolFixture {
+ public:
+  HTTPUpstreamSession* makeObservableSession() {
+    auto codec = makeParallelCodec();
+    EXPECT_CALL(*codec, setCallback(_))
+        .WillRepeatedly(SaveArg<0>(&codecCb_));
+    EXPECT_CALL(*codec, generateHeader(_, _, _, _, _))
+        .WillRepeatedly(SaveArg<1>(&lastEgressId_));
+    return makeSession(std::move(codec));
+  }
+
+  void deliverResponse(HTTPCodec::StreamID id,
+                       size_t bodyLen,
+                       uint16_t statusCode = 200) {
+    auto resp = std::make_unique<HTTPMessage>();
+    resp->setHTTPVersion(1, 1);
+    resp->setStatusCode(statusCode);
+    codecCb_->onMessageBegin(id, resp.get());
+    codecCb_->onHeadersComplete(id, std::move(resp));
+    if (bodyLen > 0) {
+      codecCb_->onBody(
+          id, folly::IOBuf::copyBuffer(std::string(bodyLen, 'x')), 0);
+    }
+    codecCb_->onMessageComplete(id, false);
+  }
+
+ protected:
+  HTTPCodec::Callback* codecCb_{nullptr};
+  HTTPCodec::StreamID lastEgressId_{0};
+};
+
+TEST_F(CacheRevalidatorFixture, DeliversFreshResponse) {
+  SessionPool p(this, 1);
+  p.putSession(makeObservableSession());
+  CacheRevalidator revalidator(&p);
+
+  RecordingCallback cb;
+  ASSERT_TRUE(revalidator.revalidate(makeRevalidationRequest("/stale"), &cb));
+  EXPECT_EQ(revalidator.getNumInFlight(), 1);
+  evb_.loopOnce();
+
+  deliverResponse(lastEgressId_, 100);
+  EXPECT_EQ(cb.revalidated, 1);
+  EXPECT_EQ(cb.headers_->getStatusCode(), 200);
+  EXPECT_EQ(cb.bodyBytes, 100);
+  EXPECT_EQ(revalidator.getNumInFlight(), 0);
+
+  p.setMaxIdleSessions(0);
+  evb_.loop();
+}
+
+TEST_F(CacheRevalidatorFixture, SurfacesNotModified) {
+  SessionPool p(this, 1);
+  p.putSession(makeObservableSession());
+  CacheRevalidator revalidator(&p);
+
+  RecordingCallback cb;
+  ASSERT_TRUE(revalidator.revalidate(makeRevalidationRequest("/stale"), &cb));
+  evb_.loopOnce();
+
+  deliverResponse(lastEgressId_, 0, 304);
+  EXPECT_EQ(cb.notModified, 1);
+  EXPECT_EQ(cb.revalidated, 0);
+
+  p.setMaxIdleSessions(0);
+  evb_.loop();
+}
+
+TEST_F(CacheRevalidatorFixture, DeduplicatesPerKey) {
+  SessionPool p(this, 2);
+  p.putSession(makeObservableSession());
+  CacheRevalidator revalidator(&p);
+
+  RecordingCallback cb1;
+  RecordingCallback cb2;
+  ASSERT_TRUE(revalidator.revalidate(makeRevalidationRequest("/stale"), &cb1));
+  // Second request for the same key rides the in-flight refresh; its
+  // callback is not registered
+  ASSERT_TRUE(revalidator.revalidate(makeRevalidationRequest("/stale"), &cb2));
+  EXPECT_EQ(revalidator.getNumInFlight(), 1);
+  evb_.loopOnce();
+
+  deliverResponse(lastEgressId_, 50);
+  EXPECT_EQ(cb1.revalidated, 1);
+  EXPECT_EQ(cb2.revalidated, 0);
+
+  p.setMaxIdleSessions(0);
+  evb_.loop();
+}
+
+TEST_F(CacheRevalidatorFixture, TokenBucketThrottles) {
+  SessionPool p(this, 10);
+  p.putSession(makeObservableSession());
+  CacheRevalidator::Config config;
+  config.ratePerSec = 0.001; // effectively no refill during the test
+  config.burst = 2;
+  CacheRevalidator revalidator(&p, config);
+
+  RecordingCallback cb;
+  EXPECT_TRUE(revalidator.revalidate(makeRevalidationRequest("/a"), &cb));
+  EXPECT_TRUE(revalidator.revalidate(makeRevalidationRequest("/b"), &cb));
+  // Bucket exhausted: the caller keeps serving stale and tries later
+  EXPECT_FALSE(revalidator.revalidate(makeRevalidationRequest("/c"), &cb));
+  EXPECT_EQ(revalidator.getThrottledCount(), 1);
+  EXPECT_EQ(revalidator.getNumInFlight(), 2);
+
+  revalidator.cancelRevalidation(&cb);
+  p.setMaxIdleSessions(0);
+  evb_.loop();
+}
@@ -0,0 +1,77 @@
+/*
+ *  Copyright (c) 2015-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include <folly/portability/GTest.h>
+#include <proxygen/lib/http/connpool/EndpointSettingsCache.h>
+
+using namespace proxygen;
+
+TEST(EndpointSettingsCache, StoresReplayableSettingsOnly) {
+  EndpointSettingsCache cache;
+  Endpoint endpoint("server.example.com", 443, true);
+
+  SettingsList settings;
+  settings.emplace_back(SettingsId::INITIAL_WINDOW_SIZE, 1 << 20);
+  settings.emplace_back(SettingsId::MAX_CONCURRENT_STREAMS, 100);
+  // ENABLE_PUSH is connection policy, not worth replaying
+  settings.emplace_back(SettingsId::ENABLE_PUSH, 0);
+  cache.store(endpoint, settings);
+
+  auto remembered = cache.lookup(endpoint);
+  ASSERT_TRUE(remembered.hasValue());
+  ASSERT_EQ(remembered->size(), 2);
+  EXPECT_EQ((*remembered)[0].id, SettingsId::INITIAL_WINDOW_SIZE);
+  EXPECT_EQ((*remembered)[0].value, 1 << 20);
+  EXPECT_EQ((*remembered)[1].id, SettingsId::MAX_CONCURRENT_STREAMS);
+
+  EXPECT_FALSE(
+      cache.lookup(Endpoint("other.example.com", 443, true)).hasValue());
+}
+
+TEST(EndpointSettingsCache, EvictsLeastRecentlyUsed) {
+  EndpointSettingsCache::Config config;
+  config.capacity = 2;
+  EndpointSettingsCache cache(config);
+
+  SettingsList settings;
+  settings.emplace_back(SettingsId::MAX_CONCURRENT_STREAMS, 100);
+  Endpoint a("a.example.com", 443, true);
+  Endpoint b("b.example.com", 443, true);
+  Endpoint c("c.example.com", 443, true);
+
+  cache.store(a, settings);
+  cache.store(b, settings);
+  // Touch a so b becomes the eviction candidate
+  EXPECT_TRUE(cache.lookup(a).hasValue());
+  cache.store(c, settings);
+
+  EXPECT_EQ(cache.size(), 2);
+  EXPECT_TRUE(cache.lookup(a).hasValue());
+  EXPECT_FALSE(cache.lookup(b).hasValue());
+  EXPECT_TRUE(cache.lookup(c).hasValue());
+}
+
+TEST(EndpointSettingsCache, RestoreOverwritesPriorEntry) {
+  EndpointSettingsCache cache;
+  Endpoint endpoint("server.example.com", 443, true);
+
+  SettingsList first;
+  first.emplace_back(SettingsId::MAX_CONCURRENT_STREAMS, 100);
+  cache.store(endpoint, first);
+
+  SettingsList second;
+  second.emplace_back(SettingsId::MAX_CONCURRENT_STREAMS, 250);
+  cache.store(endpoint, second);
+
+  auto remembered = cache.lookup(endpoint);
+  ASSERT_TRUE(remembered.hasValue());
+  ASSERT_EQ(remembered->size(), 1);
+  EXPECT_EQ((*remembered)[0].value, 250);
+  EXPECT_EQ(cache.size(), 1);
+}
@@ -0,0 +1,228 @@
+/*
+ *  Copyright (c) 2019-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include "proxygen/lib/http/connpool/RequestCoalescer.h"
+#include "proxygen/lib/http/connpool/test/SessionPoolTestFixture.h"
+
+using namespace proxygen;
+using namespace testing;
+
+namespace {
+
+class CollectingCallback : public RequestCoalescer::Callback {
+ public:
+  void onHeadersComplete(std::unique_ptr<HTTPMessage> msg) noexcept override {
+    headersComplete++;
+    msg_ = std::move(msg);
+  }
+  void onBody(std::unique_ptr<folly::IOBuf> chain) noexcept override {
+    bodyBytes += chain->computeChainDataLength();
+    lastBody = std::move(chain);
+  }
+  void onTrailers(std::unique_ptr<HTTPHeaders> /*trailers*/) noexcept
+      override {
+    trailers++;
+  }
+  void onEOM() noexcept override {
+    eom++;
+  }
+  void onError(const HTTPException& /*error*/) noexcept override {
+    errors++;
+  }
+
+  uint32_t headersComplete{0};
+  uint32_t trailers{0};
+  uint32_t eom{0};
+  uint32_t errors{0};
+  uint64_t bodyBytes{0};
+  std::unique_ptr<HTTPMessage> msg_;
+  std::unique_ptr<folly::IOBuf> lastBody;
+};
+
+HTTPMessage makeGet(const std::string& path) {
+  HTTPMessage req;
+  req.setMethod(HTTPMethod::GET);
+  req.setHTTPVersion(1, 1);
+  req.setURL(path);
+  req.getHeaders().set(HTTP_HEADER_HOST, "www.facebook.com");
+  req.getHeaders().set(HTTP_HEADER_ACCEPT_ENCODING, "gzip");
+  return req;
+}
+
+} // namespace
+
+class RequestCoalescerFixture : public SessionPoolFixture {
+ public:
+  HTTPUpstreamSession* makeObservableSession() {
+    auto codec = makeParallelCodec();
+    EXPECT_CALL(*codec, setCallback(_))
+        .WillRepeatedly(SaveArg<0>(&codecCb_));
+    EXPECT_CALL(*codec, generateHeader(_, _, _, _, _))
+        .WillRepeatedly(SaveArg<1>(&lastEgressId_));
+    return makeSession(std::move(codec));
+  }
+
+  void deliverResponse(HTTPCodec::StreamID id,
+                       size_t bodyLen,
+                       uint16_t statusCode = 200) {
+    auto resp = std::make_unique<HTTPMessage>();
+    resp->setHTTPVersion(1, 1);
+    resp->setStatusCode(statusCode);
+    codecCb_->onMessageBegin(id, resp.get());
+    codecCb_->onHeadersComplete(id, std::move(resp));
+    if (bodyLen > 0) {
+      codecCb_->onBody(
+          id, folly::IOBuf::copyBuffer(std::string(bodyLen, 'x')), 0);
+    }
+    codecCb_->onMessageComplete(id, false);
+  }
+
+ protected:
+  HTTPCodec::Callback* codecCb_{nullptr};
+  HTTPCodec::StreamID lastEgressId_{0};
+};
+
+TEST_F(RequestCoalescerFixture, CoalescesConcurrentGets) {
+  SessionPool p(this, 1);
+  p.putSession(makeObservableSession());
+  RequestCoalescer coalescer(&p);
+
+  auto req = makeGet("/hot-object");
+  CollectingCallback c1;
+  CollectingCallback c2;
+  ASSERT_TRUE(coalescer.sendRequest(req, &c1));
+  ASSERT_TRUE(coalescer.sendRequest(req, &c2));
+  // One upstream transaction for both requests
+  EXPECT_EQ(coalescer.getNumInFlightFetches(), 1);
+  EXPECT_EQ(coalescer.getCoalescedCount(), 1);
+  evb_.loopOnce();
+
+  deliverResponse(lastEgressId_, 100);
+  EXPECT_EQ(c1.headersComplete, 1);
+  EXPECT_EQ(c2.headersComplete, 1);
+  EXPECT_EQ(c1.msg_->getStatusCode(), 200);
+  EXPECT_EQ(c1.bodyBytes, 100);
+  EXPECT_EQ(c2.bodyBytes, 100);
+  EXPECT_EQ(c1.eom, 1);
+  EXPECT_EQ(c2.eom, 1);
+  EXPECT_EQ(coalescer.getNumInFlightFetches(), 0);
+
+  p.setMaxIdleSessions(0);
+  evb_.loop();
+}
+
+TEST_F(RequestCoalescerFixture, BodyFanOutSharesBuffers) {
+  SessionPool p(this, 1);
+  p.putSession(makeObservableSession());
+  RequestCoalescer coalescer(&p);
+
+  auto req = makeGet("/hot-object");
+  CollectingCallback c1;
+  CollectingCallback c2;
+  ASSERT_TRUE(coalescer.sendRequest(req, &c1));
+  ASSERT_TRUE(coalescer.sendRequest(req, &c2));
+  evb_.loopOnce();
+
+  deliverResponse(lastEgressId_, 1000);
+  ASSERT_TRUE(c1.lastBody != nullptr);
+  ASSERT_TRUE(c2.lastBody != nullptr);
+  // Followers receive clones of the same immutable chain, not copies
+  EXPECT_EQ(c1.lastBody->data(), c2.lastBody->data());
+
+  p.setMaxIdleSessions(0);
+  evb_.loop();
+}
+
+TEST_F(RequestCoalescerFixture, DistinctKeysDoNotCoalesce) {
+  SessionPool p(this, 1);
+  p.putSession(makeObservableSession());
+  RequestCoalescer coalescer(&p);
+
+  CollectingCallback c1;
+  CollectingCallback c2;
+  CollectingCallback c3;
+  ASSERT_TRUE(coalescer.sendRequest(makeGet("/a"), &c1));
+  ASSERT_TRUE(coalescer.sendRequest(makeGet("/b"), &c2));
+  EXPECT_EQ(coalescer.getNumInFlightFetches(), 2);
+
+  // A different vary-header value is a different key
+  auto req = makeGet("/a");
+  req.getHeaders().set(HTTP_HEADER_ACCEPT_ENCODING, "identity");
+  ASSERT_TRUE(coalescer.sendRequest(req, &c3));
+  EXPECT_EQ(coalescer.getNumInFlightFetches(), 3);
+  EXPECT_EQ(coalescer.getCoalescedCount(), 0);
+
+  coalescer.cancelRequest(&c1);
+  coalescer.cancelRequest(&c2);
+  coalescer.cancelRequest(&c3);
+  EXPECT_EQ(coalescer.getNumInFlightFetches(), 0);
+
+  p.setMaxIdleSessions(0);
+  evb_.loop();
+}
+
+TEST_F(RequestCoalescerFixture, LateFollowerSeesBufferedResponse) {
+  SessionPool p(this, 1);
+  p.putSession(makeObservableSession());
+  RequestCoalescer coalescer(&p);
+
+  auto req = makeGet("/hot-object");
+  CollectingCallback c1;
+  ASSERT_TRUE(coalescer.sendRequest(req, &c1));
+  evb_.loopOnce();
+
+  // Headers and part of the body arrive before the second request
+  auto resp = std::make_unique<HTTPMessage>();
+  resp->setHTTPVersion(1, 1);
+  resp->setStatusCode(200);
+  codecCb_->onMessageBegin(lastEgressId_, resp.get());
+  codecCb_->onHeadersComplete(lastEgressId_, std::move(resp));
+  codecCb_->onBody(
+      lastEgressId_, folly::IOBuf::copyBuffer(std::string(40, 'x')), 0);
+
+  CollectingCallback c2;
+  ASSERT_TRUE(coalescer.sendRequest(req, &c2));
+  EXPECT_EQ(coalescer.getCoalescedCount(), 1);
+  // The late follower was caught up on attach
+  EXPECT_EQ(c2.headersComplete, 1);
+  EXPECT_EQ(c2.bodyBytes, 40);
+
+  codecCb_->onBody(
+      lastEgressId_, folly::IOBuf::copyBuffer(std::string(60, 'y')), 0);
+  codecCb_->onMessageComplete(lastEgressId_, false);
+  EXPECT_EQ(c1.bodyBytes, 100);
+  EXPECT_EQ(c2.bodyBytes, 100);
+  EXPECT_EQ(c1.eom, 1);
+  EXPECT_EQ(c2.eom, 1);
+
+  p.setMaxIdleSessions(0);
+  evb_.loop();
+}
+
+TEST_F(RequestCoalescerFixture, CancelLastFollowerAbortsFetch) {
+  SessionPool p(this, 1);
+  p.putSession(makeObservableSession());
+  RequestCoalescer coalescer(&p);
+
+  auto req = makeGet("/hot-object");
+  CollectingCallback c1;
+  CollectingCallback c2;
+  ASSERT_TRUE(coalescer.sendRequest(req, &c1));
+  ASSERT_TRUE(coalescer.sendRequest(req, &c2));
+
+  coalescer.cancelRequest(&c1);
+  EXPECT_EQ(coalescer.getNumInFlightFetches(), 1);
+  coalescer.cancelRequest(&c2);
+  EXPECT_EQ(coalescer.getNumInFlightFetches(), 0);
+  EXPECT_EQ(c1.errors, 0);
+  EXPECT_EQ(c2.errors, 0);
+
+  p.setMaxIdleSessions(0);
+  evb_.loop();
+}
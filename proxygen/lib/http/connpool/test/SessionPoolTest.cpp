@@ -9,6 +9,7 @@
  */
 #include "proxygen/lib/http/connpool/test/SessionPoolTestFixture.h"
 
+#include "proxygen/lib/http/connpool/PreConnectController.h"
 #include "proxygen/lib/http/connpool/ServerIdleSessionController.h"
 #include "proxygen/lib/http/connpool/SessionHolder.h"
 #include "proxygen/lib/http/connpool/SessionPool.h"
@@ -16,6 +17,7 @@
 
 #include <folly/io/async/EventBaseManager.h>
 #include <folly/portability/GFlags.h>
+#include <thread>
 #include <wangle/acceptor/ConnectionManager.h>
 
 using namespace proxygen;
@@ -86,6 +88,67 @@ TEST_F(SessionPoolFixture, ParallelPoolBasic) {
   ASSERT_EQ(closed_, 1);
 }
 
+namespace {
+class StubHolderCallback : public SessionHolder::Callback {
+ public:
+  void detachIdle(SessionHolder*) override {}
+  void detachPartiallyFilled(SessionHolder*) override {}
+  void detachFilled(SessionHolder*) override {}
+  void attachIdle(SessionHolder*) override {}
+  void attachPartiallyFilled(SessionHolder*) override {}
+  void attachFilled(SessionHolder*) override {}
+  void addDrainingSession(HTTPSessionBase*) override {}
+};
+}
+
+TEST_F(SessionPoolFixture, QualityScoreOrdering) {
+  StubHolderCallback cb;
+  auto warmSession = makeParallelSession();
+  auto coldSession = makeParallelSession();
+  auto warm = new SessionHolder(warmSession, &cb);
+  auto cold = new SessionHolder(coldSession, &cb);
+  warm->link();
+  cold->link();
+
+  // A fast TTFB measurement makes the warm session preferable to one
+  // that has never been measured
+  warm->onRequestBegin(*warmSession);
+  warm->onIngressMessage(*warmSession, HTTPMessage());
+  EXPECT_LT(warm->getQualityScore(), cold->getQualityScore());
+
+  // Piling on congestion signals pushes it back behind cold
+  for (int i = 0; i < 20; ++i) {
+    warm->onFlowControlWindowClosed(*warmSession);
+  }
+  EXPECT_GE(warm->getQualityScore(), cold->getQualityScore());
+
+  warm->release()->dropConnection();
+  cold->release()->dropConnection();
+  evb_.loop();
+}
+
+TEST_F(SessionPoolFixture, QualityAwareSelection) {
+  const int numTxns = 4;
+  HTTPTransaction* txns[numTxns];
+
+  SessionPool p(this, 2);
+  p.setQualityAwareSelection(true);
+  p.putSession(makeParallelSession());
+  p.putSession(makeParallelSession());
+
+  // With no samples every session scores cold and selection still works
+  for (int i = 0; i < numTxns; ++i) {
+    txns[i] = p.getTransaction(this);
+    ASSERT_TRUE(txns[i] != nullptr);
+  }
+  p.setMaxIdleSessions(0);
+  for (int i = 0; i < numTxns; ++i) {
+    txns[i]->sendAbort();
+  }
+  evb_.loop();
+  ASSERT_EQ(closed_, 2);
+}
+
 TEST_F(SessionPoolFixture, SerialPoolPurge) {
   // Put more sessions into the pool than can fit. Then open several
   // transactions on this pool and make sure we can't get out more
@@ -492,6 +555,8 @@ TEST_F(SessionPoolFixture, DrainOnShutdown) {
 
 class TestIdleController : public ServerIdleSessionController {
  public:
+  using ServerIdleSessionController::ServerIdleSessionController;
+
   // expose this method as public for tests.
   SessionPool* popBestIdlePool() {
     return ServerIdleSessionController::popBestIdlePool();
@@ -597,6 +662,84 @@ TEST_F(SessionPoolFixture, ServerIdleSessionControllerTest) {
   s3->drain();
 }
 
+TEST_F(SessionPoolFixture, IdleSessionExchangeTest) {
+  TestIdleController ctrl;
+  auto s1 = makeParallelSession();
+
+  EXPECT_EQ(ctrl.popDetachedIdleSession(), nullptr);
+  EXPECT_TRUE(ctrl.parkDetachedIdleSession(s1));
+
+  // A parked session satisfies getIdleSession() synchronously, with no
+  // event base hop.
+  auto fut = ctrl.getIdleSession();
+  ASSERT_TRUE(fut.isReady());
+  EXPECT_EQ(std::move(fut).get(), s1);
+  EXPECT_EQ(ctrl.popDetachedIdleSession(), nullptr);
+  s1->drain();
+}
+
+TEST_F(SessionPoolFixture, IdleSessionExchangeCapacityTest) {
+  // Capacity 1: the second park must fail without detaching the session
+  TestIdleController ctrl(/*maxIdleCount=*/2, /*exchangeCapacity=*/1);
+  auto s1 = makeParallelSession(), s2 = makeParallelSession();
+
+  EXPECT_TRUE(ctrl.parkDetachedIdleSession(s1));
+  EXPECT_FALSE(ctrl.parkDetachedIdleSession(s2));
+
+  EXPECT_EQ(ctrl.popDetachedIdleSession(), s1);
+  // Popping frees the slot again
+  EXPECT_TRUE(ctrl.parkDetachedIdleSession(s2));
+
+  ctrl.markForDeath();
+  // markForDeath drains the exchange (s2 was drained there)
+  EXPECT_EQ(ctrl.popDetachedIdleSession(), nullptr);
+  s1->drain();
+}
+
+class TestPreConnectController : public PreConnectController {
+ public:
+  using PreConnectController::PreConnectController;
+  using PreConnectController::updateArrivalRate;
+};
+
+TEST_F(SessionPoolFixture, PreConnectWarmTargetTest) {
+  SessionPool pool(this, 10);
+  WheelTimerInstance timeout(std::chrono::milliseconds(500), &evb_);
+  PreConnectController::Config config;
+  config.maxWarmSessions = 4;
+  config.interval = std::chrono::milliseconds(100);
+  config.warmupWindow = std::chrono::milliseconds(200);
+  TestPreConnectController ctrl(&evb_,
+                                &pool,
+                                Endpoint("127.0.0.1", 80, false),
+                                folly::SocketAddress("127.0.0.1", 80),
+                                nullptr,
+                                timeout,
+                                config);
+
+  // No traffic yet: no sessions should be kept warm
+  EXPECT_DOUBLE_EQ(ctrl.getArrivalRate(), 0);
+  EXPECT_EQ(ctrl.getWarmTarget(), 0);
+
+  // 50 arrivals in a 100ms tick is 500 rps; the EWMA admits 30% of it.
+  // 150 rps over a 200ms warmup window wants 30 sessions, clamped to 4.
+  for (int i = 0; i < 50; i++) {
+    ctrl.noteRequest();
+  }
+  ctrl.updateArrivalRate();
+  EXPECT_DOUBLE_EQ(ctrl.getArrivalRate(), 150);
+  EXPECT_EQ(ctrl.getWarmTarget(), 4);
+
+  // Quiet ticks decay the rate; a trickle keeps a single warm session
+  // until the rate reaches zero
+  for (int i = 0; i < 40; i++) {
+    ctrl.updateArrivalRate();
+  }
+  EXPECT_LT(ctrl.getArrivalRate(), 1);
+  EXPECT_EQ(ctrl.getWarmTarget(), 1);
+  EXPECT_EQ(ctrl.getNumPendingConnects(), 0);
+}
+
 TEST_F(SessionPoolFixture, WritePausedSessionNotMarkedAsIdle) {
   auto codec = makeParallelCodec();
   EXPECT_CALL(*codec, generateHeader(_, _, _, _, _))
@@ -714,6 +857,33 @@ TEST_F(SessionPoolFixture, ThreadIdleSessionControllerTrackSessionPoolChanges) {
   EXPECT_EQ(p2.getNumIdleSessions(), 1);
 }
 
+TEST_F(SessionPoolFixture, ThreadIdleSessionControllerPurgesExpired) {
+  auto idleBefore = ThreadIdleSessionController::getGlobalIdleSessions();
+  ThreadIdleSessionController controller(10, std::chrono::milliseconds(50));
+  SessionPool p1(this,
+                 2,
+                 std::chrono::seconds(10),
+                 std::chrono::seconds(10),
+                 &controller);
+
+  p1.putSession(makeSerialSession());
+  p1.putSession(makeSerialSession());
+  EXPECT_EQ(controller.getTotalIdleSessions(), 2);
+  EXPECT_EQ(ThreadIdleSessionController::getGlobalIdleSessions(),
+            idleBefore + 2);
+
+  // Not expired yet; the purge must not touch live buckets.
+  controller.purgeExpiredIdleSessions();
+  EXPECT_EQ(controller.getTotalIdleSessions(), 2);
+
+  /* sleep override */
+  std::this_thread::sleep_for(std::chrono::milliseconds(120));
+  controller.purgeExpiredIdleSessions();
+  evb_.loop();
+  EXPECT_EQ(controller.getTotalIdleSessions(), 0);
+  EXPECT_EQ(ThreadIdleSessionController::getGlobalIdleSessions(), idleBefore);
+}
+
 // So we can have -v work
 int main(int argc, char** argv) {
   testing::InitGoogleTest(&argc, argv);
@@ -236,8 +236,15 @@ IOBufQueue RFC1867Codec::readToBoundary(bool& foundBoundary) {
       /* calculate length after match */
       uint64_t readlen = (ptr - head->data());
       len = head->length() - readlen;
-      boundaryResult =
-        isBoundary(*head, readlen, boundary_.data(), boundary_.length());
+      if (len >= 3 && (ptr[1] != '-' || ptr[2] != '-')) {
+        // Cheap prefilter: every boundary continues "--", so a bare
+        // newline in field data is rejected on two byte compares without
+        // the full chain-aware comparison below
+        boundaryResult = BoundaryResult::NO;
+      } else {
+        boundaryResult =
+          isBoundary(*head, readlen, boundary_.data(), boundary_.length());
+      }
       if (boundaryResult == BoundaryResult::YES) {
         CHECK(readlen < head->length());
         bool hasCr = false;
@@ -245,11 +252,9 @@ IOBufQueue RFC1867Codec::readToBoundary(bool& foundBoundary) {
           pendingCR_.reset();
         }
         if (readlen > 0) {
-          // If the last read char is a CR omit from result
-          Cursor c(head);
-          c.skip(readlen - 1);
-          uint8_t ch = c.read<uint8_t>();
-          if (ch == '\r') {
+          // If the last read char is a CR omit from result; readlen is
+          // within head, so the byte is read in place
+          if (head->data()[readlen - 1] == '\r') {
             --readlen;
             hasCr = true;
           }
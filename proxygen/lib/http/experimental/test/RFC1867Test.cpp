@@ -198,6 +198,18 @@ TEST_F(RFC1867Test, TestSimplePost) {
   testSimple(std::move(data), 3 + 5 + fileSize, 0, 3);
 }
 
+TEST_F(RFC1867Test, TestNewlineDenseContent) {
+  // Field data full of bare newlines, dashes and near-boundary prefixes
+  // exercises the first-bytes prefilter in the boundary scan; split at
+  // every size so the prefixes also land across chunk edges
+  string content =
+      "line1\nline2\n-\n--\n---\n--abcde\r\n--abcdexyz\n\r\n-- \n\n";
+  for (size_t i = 1; i < content.size() + 2; i++) {
+    auto data = makePost({{"foo", "bar"}}, {{"file1", {"", content}}}, {});
+    testSimple(std::move(data), 3 + content.size(), i, 2);
+  }
+}
+
 TEST_F(RFC1867Test, TestSplits) {
   for (size_t i = 1; i < 500; i++) {
     size_t fileSize = 1000 + i;
@@ -14,10 +14,25 @@
 namespace proxygen {
 
 struct AckLatencyEvent {
+  // Which clock produced the timestamp behind this measurement.  NIC
+  // hardware timestamps don't wander with host scheduling load the way
+  // software ones do, so consumers may want to weight them differently.
+  enum class TimestampSource : uint8_t {
+    // host clock read when the transport callback was delivered
+    SOFTWARE,
+    // kernel software timestamp from the socket error queue
+    // (SOF_TIMESTAMPING_TX_SOFTWARE / _ACK)
+    KERNEL,
+    // NIC hardware timestamp (SOF_TIMESTAMPING_TX_HARDWARE), already
+    // converted to the host clock domain by the producer
+    HARDWARE,
+  };
+
   // The byte number that was acknowledged.
   unsigned int byteNo;
   // The latency between sending the byte and receiving the ack for that byte.
   std::chrono::nanoseconds latency;
+  TimestampSource source{TimestampSource::SOFTWARE};
 };
 
 } // namespace proxygen
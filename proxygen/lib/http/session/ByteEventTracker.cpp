@@ -13,6 +13,12 @@
 #include <string>
 
 
+namespace {
+// Smoothing factor for the delivery rate EWMA; favors recent samples so a
+// connection that stalls mid-drain is detected within a few write cycles.
+constexpr double kDeliveryRateAlpha = 0.3;
+} // namespace
+
 namespace proxygen {
 
 ByteEventTracker::~ByteEventTracker() {
@@ -21,6 +27,11 @@ ByteEventTracker::~ByteEventTracker() {
 
 void ByteEventTracker::absorb(ByteEventTracker&& other) {
   byteEvents_ = std::move(other.byteEvents_);
+  // carry the delivery rate estimate across tracker replacement so drain
+  // projections don't restart from scratch
+  deliveryRateBytesPerMs_ = other.deliveryRateBytesPerMs_;
+  lastProcessTime_ = other.lastProcessTime_;
+  deliveryRateValid_ = other.deliveryRateValid_;
 }
 
 // The purpose of self is to represent shared ownership during
@@ -30,6 +41,22 @@ bool ByteEventTracker::processByteEvents(std::shared_ptr<ByteEventTracker> self,
                                          uint64_t bytesWritten) {
   // update our local cache of the number of bytes written so far
   DCHECK(bytesWritten >= bytesWritten_);
+  auto now = getCurrentTime();
+  if (lastProcessTime_) {
+    auto elapsed = millisecondsBetween(now, *lastProcessTime_).count();
+    if (elapsed > 0) {
+      double sampleRate = double(bytesWritten - bytesWritten_) / elapsed;
+      if (deliveryRateValid_) {
+        deliveryRateBytesPerMs_ = kDeliveryRateAlpha * sampleRate +
+                                  (1 - kDeliveryRateAlpha) *
+                                      deliveryRateBytesPerMs_;
+      } else {
+        deliveryRateBytesPerMs_ = sampleRate;
+        deliveryRateValid_ = true;
+      }
+    }
+  }
+  lastProcessTime_ = now;
   bytesWritten_ = bytesWritten;
 
   while (!byteEvents_.empty() &&
@@ -76,6 +103,26 @@ bool ByteEventTracker::processByteEvents(std::shared_ptr<ByteEventTracker> self,
   return self.use_count() == 1;
 }
 
+folly::Optional<std::chrono::milliseconds>
+ByteEventTracker::projectedDrainTime() const {
+  if (byteEvents_.empty()) {
+    return std::chrono::milliseconds(0);
+  }
+  if (!deliveryRateValid_ || deliveryRateBytesPerMs_ <= 0) {
+    // no usable rate sample yet; the caller should fall back to its
+    // coarse drain timeout
+    return folly::none;
+  }
+  // byteEvents_ is sorted by offset, so the back is the furthest byte the
+  // session still has to deliver
+  uint64_t lastOffset = byteEvents_.back().byteOffset_;
+  if (lastOffset <= bytesWritten_) {
+    return std::chrono::milliseconds(0);
+  }
+  return std::chrono::milliseconds(static_cast<int64_t>(
+      double(lastOffset - bytesWritten_) / deliveryRateBytesPerMs_));
+}
+
 size_t ByteEventTracker::drainByteEvents() {
   size_t numEvents = 0;
   // everything is dead from here on, let's just drop all extra refs to txns
@@ -9,6 +9,7 @@
  */
 #pragma once
 
+#include <folly/Optional.h>
 #include <proxygen/lib/http/session/AckLatencyEvent.h>
 #include <proxygen/lib/http/session/HTTPTransaction.h>
 #include <proxygen/lib/http/session/TransactionByteEvents.h>
@@ -36,6 +37,13 @@ class ByteEventTracker {
     virtual void onTxnByteEventWrittenToBuf(
         const ByteEvent& event) noexcept = 0;
     virtual void onDeleteTxnByteEvent() noexcept = 0;
+
+    /**
+     * Delivered by ACK-tracking ByteEventTrackers when a transport ack
+     * timestamp arrives for a tracked last byte.
+     */
+    virtual void onAckLatencyEvent(const AckLatencyEvent& /*event*/) noexcept {
+    }
   };
 
   virtual ~ByteEventTracker();
@@ -65,6 +73,16 @@ class ByteEventTracker {
   virtual bool processByteEvents(std::shared_ptr<ByteEventTracker> self,
                                  uint64_t bytesWritten);
 
+  /**
+   * Estimates how long the transport will take to accept the remaining
+   * tracked bytes, based on an EWMA of the delivery rate observed across
+   * processByteEvents calls.  Returns 0ms when no byte events are pending,
+   * and folly::none when no rate has been observed yet (e.g. before the
+   * second processByteEvents call).  HTTPSession uses this during drain to
+   * abort sessions that cannot finish within a shutdown SLA.
+   */
+  folly::Optional<std::chrono::milliseconds> projectedDrainTime() const;
+
   /**
    * The following methods add byte events for tracking
    */
@@ -126,6 +144,12 @@ class ByteEventTracker {
   // should always increase
   uint64_t bytesWritten_ = 0;
 
+  // EWMA of the rate at which the transport accepts bytes, sampled on
+  // each processByteEvents call.  Invalid until two calls have been seen.
+  double deliveryRateBytesPerMs_{0};
+  folly::Optional<TimePoint> lastProcessTime_;
+  bool deliveryRateValid_{false};
+
   // byteEvents_ is in the ascending order of ByteEvent::byteOffset_
   folly::CountedIntrusiveList<ByteEvent, &ByteEvent::listHook> byteEvents_;
 
@@ -12,9 +12,61 @@
 #include <proxygen/lib/http/session/ByteEvents.h>
 
 #include <proxygen/lib/utils/Time.h>
+#include <vector>
+
+namespace {
+
+// Bound on recycled blocks kept per thread
+constexpr size_t kEventPoolSize = 512;
+
+struct ByteEventPool {
+  ~ByteEventPool() {
+    for (auto block : blocks) {
+      ::operator delete(block);
+    }
+  }
+  std::vector<void*> blocks;
+};
+
+ByteEventPool& eventPool() {
+  static thread_local ByteEventPool pool;
+  return pool;
+}
+
+} // namespace
 
 namespace proxygen {
 
+void* ByteEvent::operator new(size_t size) {
+  if (size > kPooledBlockSize) {
+    return ::operator new(size);
+  }
+  auto& pool = eventPool();
+  if (!pool.blocks.empty()) {
+    void* block = pool.blocks.back();
+    pool.blocks.pop_back();
+    return block;
+  }
+  return ::operator new(kPooledBlockSize);
+}
+
+void ByteEvent::operator delete(void* p, size_t size) {
+  // Events are freed on the thread that processes them, which is the
+  // thread that allocated them unless the session migrated; either way the
+  // block just joins the freeing thread's pool.
+  if (size <= kPooledBlockSize) {
+    auto& pool = eventPool();
+    if (pool.blocks.size() < kEventPoolSize) {
+      pool.blocks.push_back(p);
+      return;
+    }
+  }
+  ::operator delete(p);
+}
+
+static_assert(sizeof(PingByteEvent) <= ByteEvent::kPooledBlockSize,
+              "ByteEvent subclasses must fit the pooled block size");
+
 const char* const kTypeStrings[] = {
     "FIRST_BYTE",
     "LAST_BYTE",
@@ -35,6 +35,18 @@ class ByteEvent {
   }
   virtual ~ByteEvent() {
   }
+
+  /**
+   * Byte events churn on every egress write, so they are carved from a
+   * per-thread pool of recycled fixed-size blocks instead of hitting the
+   * global allocator for each one.  Applies to all subclasses.
+   */
+  static void* operator new(size_t size);
+  static void operator delete(void* p, size_t size);
+
+  /** Pooled block size; every subclass must fit (larger ones would still
+   *  work but silently bypass the pool) */
+  static constexpr size_t kPooledBlockSize = 192;
   EventType getType() const {
     return eventType_;
   }
@@ -10,12 +10,19 @@
 #include <proxygen/lib/http/session/CodecErrorResponseHandler.h>
 
 #include <folly/Conv.h>
+#include <proxygen/lib/utils/StructuredLog.h>
 
 using folly::IOBuf;
 using std::unique_ptr;
 
 namespace proxygen {
 
+namespace {
+uint64_t txnID(const HTTPTransaction* txn) {
+  return txn ? static_cast<uint64_t>(txn->getID()) : 0;
+}
+} // namespace
+
 CodecErrorResponseHandler::CodecErrorResponseHandler(ErrorCode /*statusCode*/)
     : txn_(nullptr) {
 }
@@ -33,16 +40,17 @@ void CodecErrorResponseHandler::detachTransaction() noexcept {
 
 void CodecErrorResponseHandler::onHeadersComplete(
     std::unique_ptr<HTTPMessage> /*msg*/) noexcept {
-  VLOG(4) << "discarding headers";
+  PROXYGEN_SLOG(CODEC_DISCARD_HEADERS, txnID(txn_), 0);
 }
 
-void CodecErrorResponseHandler::onBody(unique_ptr<IOBuf> /*chain*/) noexcept {
-  VLOG(4) << "discarding request body";
+void CodecErrorResponseHandler::onBody(unique_ptr<IOBuf> chain) noexcept {
+  PROXYGEN_SLOG(CODEC_DISCARD_BODY, txnID(txn_),
+                chain ? chain->computeChainDataLength() : 0);
 }
 
 void CodecErrorResponseHandler::onTrailers(
     unique_ptr<HTTPHeaders> /*trailers*/) noexcept {
-  VLOG(4) << "discarding request trailers";
+  PROXYGEN_SLOG(CODEC_DISCARD_TRAILERS, txnID(txn_), 0);
 }
 
 void CodecErrorResponseHandler::onEOM() noexcept {
@@ -53,7 +61,10 @@ void CodecErrorResponseHandler::onUpgrade(
 }
 
 void CodecErrorResponseHandler::onError(const HTTPException& error) noexcept {
-  VLOG(4) << "processing error " << error;
+  // Record the binary facts; the exception text is only rendered when an
+  // inspection thread formats the drained record
+  PROXYGEN_SLOG(CODEC_ERROR, txnID(txn_),
+                static_cast<uint64_t>(error.getProxygenError()));
   txn_->sendAbort();
 }
 
@@ -0,0 +1,53 @@
+/*
+ *  Copyright (c) 2015-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include <proxygen/lib/http/session/DirectPathResponder.h>
+
+#include <folly/Conv.h>
+
+namespace proxygen {
+
+DirectPathResponder::DirectPathResponder(
+    const std::map<std::string, AcceptorConfiguration::DirectResponse>&
+        config) {
+  for (const auto& entry : config) {
+    Response response;
+    response.headers.setHTTPVersion(1, 1);
+    response.headers.setStatusCode(entry.second.statusCode);
+    response.headers.setStatusMessage(
+        entry.second.statusMessage.empty()
+            ? HTTPMessage::getDefaultReason(entry.second.statusCode)
+            : entry.second.statusMessage);
+    if (!entry.second.contentType.empty()) {
+      response.headers.getHeaders().add(HTTP_HEADER_CONTENT_TYPE,
+                                        entry.second.contentType);
+    }
+    response.headers.getHeaders().add(
+        HTTP_HEADER_CONTENT_LENGTH,
+        folly::to<std::string>(entry.second.body.size()));
+    if (!entry.second.body.empty()) {
+      response.body = folly::IOBuf::copyBuffer(entry.second.body);
+    }
+    responses_.emplace(entry.first, std::move(response));
+  }
+}
+
+const DirectPathResponder::Response* DirectPathResponder::match(
+    const HTTPMessage& request) const {
+  if (request.getMethod() != HTTPMethod::GET) {
+    return nullptr;
+  }
+  auto it = responses_.find(request.getPath());
+  if (it == responses_.end()) {
+    return nullptr;
+  }
+  return &it->second;
+}
+
+} // namespace proxygen
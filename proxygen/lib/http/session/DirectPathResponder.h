@@ -0,0 +1,83 @@
+/*
+ *  Copyright (c) 2015-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#pragma once
+
+#include <map>
+#include <proxygen/lib/http/session/HTTPTransaction.h>
+#include <proxygen/lib/services/AcceptorConfiguration.h>
+
+namespace proxygen {
+
+/**
+ * Answers a configured set of exact request paths (health checks and the
+ * like) straight from the session, without a controller lookup or a
+ * handler pipeline per request.
+ *
+ * The acceptor builds one responder per AcceptorConfiguration from
+ * directResponsePaths.  Response headers are built once as HTTPMessage
+ * prototypes and bodies once as IOBuf chains; on a hit the session sends
+ * the prototype and a clone of the body through the transaction and
+ * installs this object as the stream's Handler.  Every handler callback
+ * is a no-op and detachTransaction does not delete, so one immortal
+ * responder serves every direct-answered stream on the acceptor and a hit
+ * performs no per-request allocations beyond the body clone.
+ *
+ * Unlike HTTPCannedResponseCache, which serves pre-encoded
+ * connection-terminating responses, these replies ride the normal
+ * transaction egress so keep-alive and flow control accounting stay
+ * correct for the health checkers polling the connection.
+ */
+class DirectPathResponder : public HTTPTransaction::Handler {
+ public:
+  struct Response {
+    HTTPMessage headers;
+    std::unique_ptr<folly::IOBuf> body;
+  };
+
+  explicit DirectPathResponder(
+      const std::map<std::string, AcceptorConfiguration::DirectResponse>&
+          config);
+
+  /**
+   * Returns the canned response for the request, or nullptr if the
+   * request is not a GET for one of the configured paths.
+   */
+  const Response* match(const HTTPMessage& request) const;
+
+  // HTTPTransaction::Handler methods.  The session already egressed the
+  // response before installing this handler, so there is nothing to do.
+  void setTransaction(HTTPTransaction* /*txn*/) noexcept override {
+  }
+  void detachTransaction() noexcept override {
+  }
+  void onHeadersComplete(std::unique_ptr<HTTPMessage> /*msg*/) noexcept
+      override {
+  }
+  void onBody(std::unique_ptr<folly::IOBuf> /*chain*/) noexcept override {
+  }
+  void onTrailers(std::unique_ptr<HTTPHeaders> /*trailers*/) noexcept
+      override {
+  }
+  void onEOM() noexcept override {
+  }
+  void onUpgrade(UpgradeProtocol /*protocol*/) noexcept override {
+  }
+  void onError(const HTTPException& /*error*/) noexcept override {
+  }
+  void onEgressPaused() noexcept override {
+  }
+  void onEgressResumed() noexcept override {
+  }
+
+ private:
+  std::map<std::string, Response> responses_;
+};
+
+} // namespace proxygen
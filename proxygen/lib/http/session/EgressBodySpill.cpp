@@ -0,0 +1,178 @@
+/*
+ *  Copyright (c) 2015-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include <proxygen/lib/http/session/EgressBodySpill.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <folly/FileUtil.h>
+#include <folly/portability/Unistd.h>
+#include <glog/logging.h>
+#include <vector>
+
+namespace proxygen {
+
+EgressBodySpill::EgressBodySpill(folly::EventBase* evb,
+                                 folly::Executor* ioExecutor,
+                                 const std::string& spillDir,
+                                 uint64_t watermark,
+                                 Callback* callback)
+    : evb_(CHECK_NOTNULL(evb)),
+      ioExecutor_(CHECK_NOTNULL(ioExecutor)),
+      spillDir_(spillDir),
+      watermark_(watermark),
+      callback_(CHECK_NOTNULL(callback)),
+      aliveToken_(std::make_shared<size_t>(0)) {
+}
+
+EgressBodySpill::~EgressBodySpill() {
+  // aliveToken_ expiring drops any queued completions.  file_ may
+  // outlive us in the capture of an in-flight I/O lambda; the fd is
+  // closed when the last such reference goes away.
+}
+
+bool EgressBodySpill::openFile() {
+  if (file_) {
+    return true;
+  }
+  std::string templ = spillDir_ + "/proxygen-spill.XXXXXX";
+  std::vector<char> buf(templ.begin(), templ.end());
+  buf.push_back('\0');
+  int fd = mkstemp(buf.data());
+  if (fd < 0) {
+    PLOG(ERROR) << "failed to create spill file in " << spillDir_;
+    return false;
+  }
+  // Unlink right away; the fd keeps the space alive and nothing can
+  // observe the body bytes through the filesystem
+  unlink(buf.data());
+  file_ = std::make_shared<folly::File>(fd, /*ownsFd=*/true);
+  return true;
+}
+
+void EgressBodySpill::append(std::unique_ptr<folly::IOBuf> body) {
+  if (failed_ || !body) {
+    return;
+  }
+  if (!openFile()) {
+    fail("spill file creation failed");
+    return;
+  }
+  bytesAppended_ += body->computeChainDataLength();
+  pendingWrites_.append(std::move(body));
+  if (!writeInFlight_) {
+    startWrite();
+  }
+}
+
+void EgressBodySpill::startWrite() {
+  DCHECK(!writeInFlight_);
+  auto data = pendingWrites_.move();
+  if (!data) {
+    return;
+  }
+  writeInFlight_ = true;
+  auto evb = evb_;
+  // The lambda's reference keeps the fd alive even if the spill is
+  // destroyed while the write is queued or running
+  auto file = file_;
+  auto offset = fileEnd_;
+  std::weak_ptr<size_t> alive = aliveToken_;
+  auto sharedData = std::shared_ptr<folly::IOBuf>(std::move(data));
+  ioExecutor_->add([this, evb, file, offset, alive, sharedData]() {
+    ssize_t written = 0;
+    for (const folly::IOBuf* buf = sharedData.get(); buf;) {
+      auto rc = folly::pwriteFull(file->fd(), buf->data(), buf->length(),
+                                  offset + written);
+      if (rc < 0 || static_cast<size_t>(rc) != buf->length()) {
+        written = -1;
+        break;
+      }
+      written += rc;
+      buf = buf->next();
+      if (buf == sharedData.get()) {
+        break;
+      }
+    }
+    evb->runInEventBaseThread([this, alive, written]() {
+      if (alive.expired()) {
+        return;
+      }
+      writeInFlight_ = false;
+      if (written < 0) {
+        fail("spill write failed");
+        return;
+      }
+      fileEnd_ += written;
+      if (!pendingWrites_.empty()) {
+        startWrite();
+      }
+      if (requestedRead_ > 0 && !readInFlight_) {
+        startRead();
+      }
+    });
+  });
+}
+
+void EgressBodySpill::requestRead(uint32_t maxBytes) {
+  if (failed_ || maxBytes == 0) {
+    return;
+  }
+  requestedRead_ = std::max(requestedRead_, maxBytes);
+  if (!readInFlight_) {
+    startRead();
+  }
+}
+
+void EgressBodySpill::startRead() {
+  DCHECK(!readInFlight_);
+  const uint64_t available = fileEnd_ - readOffset_;
+  const auto len = std::min<uint64_t>(available, requestedRead_);
+  if (len == 0) {
+    // Nothing durable yet; the write completion re-arms us
+    return;
+  }
+  readInFlight_ = true;
+  requestedRead_ = 0;
+  auto evb = evb_;
+  auto file = file_;
+  auto offset = readOffset_;
+  std::weak_ptr<size_t> alive = aliveToken_;
+  auto buf = std::shared_ptr<folly::IOBuf>(folly::IOBuf::create(len));
+  ioExecutor_->add([this, evb, file, offset, len, alive, buf]() {
+    auto rc = folly::preadFull(file->fd(), buf->writableData(), len, offset);
+    evb->runInEventBaseThread([this, alive, buf, rc]() {
+      if (alive.expired()) {
+        return;
+      }
+      readInFlight_ = false;
+      if (rc < 0) {
+        fail("spill read failed");
+        return;
+      }
+      buf->append(rc);
+      readOffset_ += rc;
+      bytesReadBack_ += rc;
+      // The IOBuf is uniquely owned again once the I/O lambda is gone;
+      // clone the data out to hand over ownership
+      callback_->onSpillReadData(buf->cloneOne());
+    });
+  });
+}
+
+void EgressBodySpill::fail(const std::string& msg) {
+  if (failed_) {
+    return;
+  }
+  failed_ = true;
+  PLOG(ERROR) << msg;
+  callback_->onSpillError(msg);
+}
+
+} // namespace proxygen
@@ -0,0 +1,136 @@
+/*
+ *  Copyright (c) 2015-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#pragma once
+
+#include <folly/Executor.h>
+#include <folly/File.h>
+#include <folly/io/IOBufQueue.h>
+#include <folly/io/async/EventBase.h>
+#include <memory>
+#include <string>
+
+namespace proxygen {
+
+/**
+ * Disk overflow buffer for egress body bytes.
+ *
+ * When a slow client reads a large response, buffered egress either
+ * eats memory or stalls the upstream once the buffer limit pauses the
+ * handler.  This class gives HTTPTransaction a third option: bytes
+ * beyond the in-memory watermark spill to an unlinked temp file and
+ * stream back as the client window opens, so the upstream side can
+ * finish and be freed while the client drains from disk.
+ *
+ * File I/O runs on the caller-supplied executor; completions post back
+ * to the transaction's EventBase, so all public methods and callbacks
+ * stay on the event loop.  One write and one read are in flight at a
+ * time, writes are coalesced, and reads never enter the region an
+ * in-flight write is still producing, so byte order is preserved
+ * end-to-end.  The temp file is unlinked at creation and its space is
+ * reclaimed by the kernel when the spill is destroyed.
+ */
+class EgressBodySpill {
+ public:
+  class Callback {
+   public:
+    virtual ~Callback() {
+    }
+    /** Spilled bytes read back, in the order they were appended. */
+    virtual void onSpillReadData(
+        std::unique_ptr<folly::IOBuf> data) noexcept = 0;
+    /** Unrecoverable file error; the spilled bytes are lost. */
+    virtual void onSpillError(const std::string& msg) noexcept = 0;
+  };
+
+  // Default ceiling for a single readback chunk
+  static constexpr uint32_t kDefaultReadSize = 64 * 1024;
+
+  /**
+   * @param evb Event base all callbacks are delivered on.
+   * @param ioExecutor Executor the blocking file I/O runs on; must
+   *                   outlive this object.
+   * @param spillDir Directory for the (immediately unlinked) temp file.
+   * @param watermark In-memory byte level above which the owning
+   *                  transaction diverts bytes here; stored for the
+   *                  owner's convenience, not enforced by this class.
+   * @param callback Receives read-back data and errors; must outlive
+   *                 this object.
+   */
+  EgressBodySpill(folly::EventBase* evb,
+                  folly::Executor* ioExecutor,
+                  const std::string& spillDir,
+                  uint64_t watermark,
+                  Callback* callback);
+
+  /**
+   * Pending I/O completions are dropped; the unlinked file vanishes
+   * once the in-flight operation (if any) releases its fd reference.
+   */
+  ~EgressBodySpill();
+
+  uint64_t getWatermark() const {
+    return watermark_;
+  }
+
+  /**
+   * True while any appended bytes have not yet been handed back to the
+   * callback, including bytes still queued for write.
+   */
+  bool hasSpilledData() const {
+    return bytesAppended_ > bytesReadBack_;
+  }
+
+  uint64_t getBytesOnDisk() const {
+    return fileEnd_ - readOffset_;
+  }
+
+  /**
+   * Queue body bytes for spilling.  Opens the temp file on first use.
+   */
+  void append(std::unique_ptr<folly::IOBuf> body);
+
+  /**
+   * Ask for up to maxBytes of spilled data to be read back.  At most
+   * one read is outstanding; extra requests while one is pending (or
+   * while the requested bytes are still being written) are remembered
+   * and serviced as soon as possible.
+   */
+  void requestRead(uint32_t maxBytes = kDefaultReadSize);
+
+ private:
+  bool openFile();
+  void startWrite();
+  void startRead();
+  void fail(const std::string& msg);
+
+  folly::EventBase* evb_;
+  folly::Executor* ioExecutor_;
+  std::string spillDir_;
+  uint64_t watermark_;
+  Callback* callback_;
+
+  // Shared with every in-flight I/O lambda, so the fd cannot be closed
+  // (or its number reused) under an operation another thread is running;
+  // the kernel reclaims the unlinked file when the last reference drops
+  std::shared_ptr<folly::File> file_;
+  folly::IOBufQueue pendingWrites_{folly::IOBufQueue::cacheChainLength()};
+  uint64_t bytesAppended_{0};
+  uint64_t bytesReadBack_{0};
+  uint64_t fileEnd_{0};
+  uint64_t readOffset_{0};
+  uint32_t requestedRead_{0};
+  bool writeInFlight_{false};
+  bool readInFlight_{false};
+  bool failed_{false};
+  // Guards completions against a destroyed spill
+  std::shared_ptr<size_t> aliveToken_;
+};
+
+} // namespace proxygen
@@ -32,8 +32,11 @@ void HQDownstreamSession::onConnectionErrorHandler(
 
 void HQDownstreamSession::setupOnHeadersComplete(HTTPTransaction* txn,
                                                  HTTPMessage* msg) {
-  HTTPTransaction::Handler* handler =
-      getController()->getRequestHandler(*txn, msg);
+  // A registered route matcher gets first crack at the request
+  HTTPTransaction::Handler* handler = routeRequest(msg);
+  if (!handler) {
+    handler = getController()->getRequestHandler(*txn, msg);
+  }
   CHECK(handler);
   txn->setHandler(handler);
   setNewTransactionPauseState(txn);
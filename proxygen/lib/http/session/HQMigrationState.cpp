@@ -0,0 +1,126 @@
+/*
+ *  Copyright (c) 2019-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include <proxygen/lib/http/session/HQMigrationState.h>
+
+#include <folly/io/Cursor.h>
+#include <folly/io/IOBufQueue.h>
+#include <quic/codec/QuicInteger.h>
+
+namespace {
+// Guards against a corrupt length varint making parse() try to read an
+// absurd string; no real header comes close
+constexpr uint64_t kMaxEntryLength = 1u << 20;
+} // namespace
+
+namespace proxygen { namespace hq {
+
+constexpr uint32_t HQMigrationState::kMagic;
+constexpr uint64_t HQMigrationState::kVersion;
+
+std::unique_ptr<folly::IOBuf> HQMigrationState::serialize() const {
+  folly::IOBufQueue queue{folly::IOBufQueue::cacheChainLength()};
+  folly::io::QueueAppender appender(&queue, 512);
+
+  appender.writeBE<uint32_t>(kMagic);
+  quic::encodeQuicInteger(kVersion, appender);
+
+  quic::encodeQuicInteger(peerSettings.size(), appender);
+  for (const auto& setting : peerSettings) {
+    quic::encodeQuicInteger(static_cast<uint64_t>(setting.id), appender);
+    quic::encodeQuicInteger(setting.value, appender);
+  }
+
+  quic::encodeQuicInteger(qpackTableCapacity, appender);
+  quic::encodeQuicInteger(qpackTable.size(), appender);
+  for (const auto& entry : qpackTable) {
+    quic::encodeQuicInteger(entry.name.size(), appender);
+    appender.push(folly::StringPiece(entry.name));
+    quic::encodeQuicInteger(entry.value.size(), appender);
+    appender.push(folly::StringPiece(entry.value));
+  }
+
+  quic::encodeQuicInteger(streams.size(), appender);
+  for (const auto& stream : streams) {
+    quic::encodeQuicInteger(stream.streamId, appender);
+    quic::encodeQuicInteger(stream.egressByteOffset, appender);
+  }
+
+  return queue.move();
+}
+
+folly::Optional<HQMigrationState> HQMigrationState::parse(
+    const folly::IOBuf& blob) {
+  folly::io::Cursor cursor(&blob);
+
+  if (!cursor.canAdvance(sizeof(uint32_t)) ||
+      cursor.readBE<uint32_t>() != kMagic) {
+    return folly::none;
+  }
+  auto version = quic::decodeQuicInteger(cursor);
+  if (!version || version->first != kVersion) {
+    return folly::none;
+  }
+
+  HQMigrationState state;
+
+  auto numSettings = quic::decodeQuicInteger(cursor);
+  if (!numSettings) {
+    return folly::none;
+  }
+  for (uint64_t i = 0; i < numSettings->first; i++) {
+    auto id = quic::decodeQuicInteger(cursor);
+    auto value = quic::decodeQuicInteger(cursor);
+    if (!id || !value) {
+      return folly::none;
+    }
+    state.peerSettings.emplace_back(static_cast<SettingsId>(id->first),
+                                    value->first);
+  }
+
+  auto capacity = quic::decodeQuicInteger(cursor);
+  auto numEntries = quic::decodeQuicInteger(cursor);
+  if (!capacity || !numEntries) {
+    return folly::none;
+  }
+  state.qpackTableCapacity = capacity->first;
+  for (uint64_t i = 0; i < numEntries->first; i++) {
+    TableEntry entry;
+    auto nameLen = quic::decodeQuicInteger(cursor);
+    if (!nameLen || nameLen->first > kMaxEntryLength ||
+        !cursor.canAdvance(nameLen->first)) {
+      return folly::none;
+    }
+    entry.name = cursor.readFixedString(nameLen->first);
+    auto valueLen = quic::decodeQuicInteger(cursor);
+    if (!valueLen || valueLen->first > kMaxEntryLength ||
+        !cursor.canAdvance(valueLen->first)) {
+      return folly::none;
+    }
+    entry.value = cursor.readFixedString(valueLen->first);
+    state.qpackTable.push_back(std::move(entry));
+  }
+
+  auto numStreams = quic::decodeQuicInteger(cursor);
+  if (!numStreams) {
+    return folly::none;
+  }
+  for (uint64_t i = 0; i < numStreams->first; i++) {
+    auto id = quic::decodeQuicInteger(cursor);
+    auto offset = quic::decodeQuicInteger(cursor);
+    if (!id || !offset) {
+      return folly::none;
+    }
+    state.streams.push_back(StreamState{id->first, offset->first});
+  }
+
+  return state;
+}
+
+}} // namespace proxygen::hq
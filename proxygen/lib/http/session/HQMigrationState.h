@@ -0,0 +1,69 @@
+/*
+ *  Copyright (c) 2019-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#pragma once
+
+#include <folly/Optional.h>
+#include <folly/io/IOBuf.h>
+#include <proxygen/lib/http/codec/HTTPSettings.h>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace proxygen { namespace hq {
+
+/**
+ * Resumable HTTP/3-layer session state for warm process handoff.
+ *
+ * During a deploy the old process serializes each draining HQSession's
+ * HTTP-layer state into this blob and ships it (alongside the QUIC
+ * transport's own migration payload -- connection IDs, keys and
+ * congestion state travel at that layer, not here) to the new binary,
+ * which rebuilds the session instead of forcing the peer to reconnect.
+ *
+ * The blob carries exactly the state the HTTP layer cannot recompute:
+ * the peer's advertised SETTINGS, the QPACK dynamic table contents in
+ * insertion order, and the committed egress byte offset of every open
+ * stream.  Everything is varint-coded in the QUIC style, so a blob for
+ * a typical session is a few hundred bytes.
+ *
+ * The format is versioned; parse() rejects blobs from unknown versions
+ * or truncated transfers rather than resuming from garbage.
+ */
+struct HQMigrationState {
+  struct TableEntry {
+    std::string name;
+    std::string value;
+  };
+
+  struct StreamState {
+    uint64_t streamId{0};
+    // Bytes committed to the transport for this stream; egress resumes
+    // from here in the new process
+    uint64_t egressByteOffset{0};
+  };
+
+  SettingsList peerSettings;
+  uint32_t qpackTableCapacity{0};
+  std::vector<TableEntry> qpackTable; // oldest insertion first
+  std::vector<StreamState> streams;
+
+  std::unique_ptr<folly::IOBuf> serialize() const;
+
+  /**
+   * Parses a serialized blob.  Returns folly::none on bad magic,
+   * unknown version, or truncation.
+   */
+  static folly::Optional<HQMigrationState> parse(const folly::IOBuf& blob);
+
+  static constexpr uint32_t kMagic = 0x48334D47; // 'H3MG'
+  static constexpr uint64_t kVersion = 1;
+};
+
+}} // namespace proxygen::hq
@@ -0,0 +1,71 @@
+/*
+ *  Copyright (c) 2019-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include <proxygen/lib/http/session/HQPriorityScheduler.h>
+
+#include <algorithm>
+
+namespace proxygen {
+
+constexpr uint8_t HQPriorityScheduler::kNumUrgencies;
+constexpr uint8_t HQPriorityScheduler::kDefaultUrgency;
+
+void HQPriorityScheduler::setUrgency(HTTPCodec::StreamID id,
+                                     uint8_t urgency,
+                                     bool incremental) {
+  urgencies_[id] = StreamPriority{
+      std::min(urgency, uint8_t(kNumUrgencies - 1)), incremental};
+}
+
+HQPriorityScheduler::StreamPriority HQPriorityScheduler::getPriority(
+    HTTPCodec::StreamID id) const {
+  auto it = urgencies_.find(id);
+  if (it == urgencies_.end()) {
+    return StreamPriority{kDefaultUrgency, true};
+  }
+  return it->second;
+}
+
+void HQPriorityScheduler::buildSchedule(
+    HTTP2PriorityQueue::NextEgressResult& streams) {
+  if (streams.size() < 2) {
+    return;
+  }
+  uint8_t top = kNumUrgencies - 1;
+  for (const auto& entry : streams) {
+    top = std::min(top, getPriority(entry.first->getID()).urgency);
+  }
+  HTTP2PriorityQueue::NextEgressResult incremental;
+  for (auto& entry : streams) {
+    auto priority = getPriority(entry.first->getID());
+    if (priority.urgency != top) {
+      continue;
+    }
+    if (!priority.incremental) {
+      // the first non-incremental stream of the top bucket is served to
+      // completion before its peers get bandwidth
+      auto sequential = entry;
+      streams.clear();
+      sequential.second = 1;
+      streams.push_back(sequential);
+      return;
+    }
+    incremental.push_back(entry);
+  }
+  // rotate so successive rounds lead with a different stream
+  auto start = nextIncremental_[top]++ % incremental.size();
+  streams.clear();
+  for (size_t i = 0; i < incremental.size(); i++) {
+    auto entry = incremental[(start + i) % incremental.size()];
+    entry.second = 1.0 / incremental.size();
+    streams.push_back(entry);
+  }
+}
+
+} // namespace proxygen
@@ -0,0 +1,82 @@
+/*
+ *  Copyright (c) 2019-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#pragma once
+
+#include <array>
+#include <unordered_map>
+
+#include <proxygen/lib/http/session/HTTP2PriorityQueue.h>
+
+namespace proxygen {
+
+/**
+ * Bridges the urgency/incremental priority model onto HQSession egress.
+ *
+ * The h2 tier interleaves responses through HTTP2PriorityQueue's
+ * dependency tree, but h3 priorities use the flat urgency model: eight
+ * urgency levels, and within a level incremental streams share bandwidth
+ * round robin while non-incremental streams are served to completion in
+ * order.  Rather than replace the transaction egress queue, HQSession
+ * keeps using it to learn which streams are writable each round and
+ * passes the result through buildSchedule(), which keeps only the
+ * streams of the highest-urgency bucket with data pending and orders
+ * them per the model.  Streams with no registered urgency get the
+ * default urgency, incremental.
+ *
+ * The per-bucket state is a dense array indexed by urgency; the round
+ * robin is a rotation offset per bucket, advanced once per write round.
+ */
+class HQPriorityScheduler {
+ public:
+  static constexpr uint8_t kNumUrgencies = 8;
+  static constexpr uint8_t kDefaultUrgency = 3;
+
+  /**
+   * Registers or updates the egress priority of a stream.  Urgencies
+   * beyond the last bucket are clamped.
+   */
+  void setUrgency(HTTPCodec::StreamID id, uint8_t urgency, bool incremental);
+
+  void erase(HTTPCodec::StreamID id) {
+    urgencies_.erase(id);
+  }
+
+  /**
+   * The scheduler only engages once some stream has registered a
+   * priority; until then HQSession writes in egress queue order.
+   */
+  bool enabled() const {
+    return !urgencies_.empty();
+  }
+
+  /**
+   * Rewrites one write round's worth of writable streams in place:
+   * only the highest-urgency bucket survives, a non-incremental stream
+   * preempts incremental peers and is served alone, and incremental
+   * streams are rotated so successive rounds start with a different
+   * stream.  The egress ratios are evened out across the survivors.
+   */
+  void buildSchedule(HTTP2PriorityQueue::NextEgressResult& streams);
+
+ private:
+  struct StreamPriority {
+    uint8_t urgency;
+    bool incremental;
+  };
+
+  StreamPriority getPriority(HTTPCodec::StreamID id) const;
+
+  std::unordered_map<HTTPCodec::StreamID, StreamPriority> urgencies_;
+
+  // Round-robin rotation offset for each urgency bucket
+  std::array<uint32_t, kNumUrgencies> nextIncremental_{{}};
+};
+
+} // namespace proxygen
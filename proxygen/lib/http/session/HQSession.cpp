@@ -35,6 +35,10 @@
 
 namespace {
 static const uint16_t kMaxReadsPerLoop = 16;
+// Approximate UDP payload per QUIC packet, used to size GSO batch hints.
+// Deliberately conservative so the hint never exceeds what the transport
+// can fit in one segment.
+static const uint64_t kApproxUDPPayloadLen = 1400;
 static const std::string kNoProtocolString("");
 static const std::string kH1QV1ProtocolString("h1q-fb");
 static const std::string kH1QLigerProtocolString("h1q");
@@ -839,6 +843,23 @@ void HQSession::dropConnection() {
       kErrorDropped);
 }
 
+hq::HQMigrationState HQSession::captureMigrationState() {
+  hq::HQMigrationState state;
+  state.peerSettings = ingressSettings_.getAllSettings();
+  state.qpackTableCapacity =
+      qpackCodec_.getCompressionInfo().ingress.headerTableSize_;
+  for (auto& entry : qpackCodec_.dumpDecoderTable()) {
+    state.qpackTable.push_back(
+        {std::move(entry.first), std::move(entry.second)});
+  }
+  invokeOnAllStreams([&state](HQStreamTransportBase* stream) {
+    state.streams.push_back(hq::HQMigrationState::StreamState{
+        static_cast<uint64_t>(stream->getStreamId()),
+        stream->streamWriteByteOffset()});
+  });
+  return state;
+}
+
 void HQSession::dropConnectionAsync(
     std::pair<quic::QuicErrorCode, std::string> errorCode,
     ProxygenError proxygenError) {
@@ -1012,15 +1033,23 @@ HQSession::findStreamImpl(quic::StreamId streamId,
                           bool includeIngress,
                           bool includeDetached) {
   HQStreamTransportBase* pstream{nullptr};
-  auto it = streams_.find(streamId);
-  if (it != streams_.end()) {
-    pstream = &it->second;
-  }
-  if (!pstream && includeIngress) {
-    pstream = findIngressPushStream(streamId);
-  }
-  if (!pstream && includeEgress) {
-    pstream = findEgressPushStream(streamId);
+  // The cache only ever holds bidirectional request streams, which qualify
+  // as both ingress and egress, so a hit is valid for any filter.
+  if (lastLookupStream_ && lastLookupStreamId_ == streamId) {
+    pstream = lastLookupStream_;
+  } else {
+    auto it = streams_.find(streamId);
+    if (it != streams_.end()) {
+      pstream = &it->second;
+      lastLookupStreamId_ = streamId;
+      lastLookupStream_ = pstream;
+    }
+    if (!pstream && includeIngress) {
+      pstream = findIngressPushStream(streamId);
+    }
+    if (!pstream && includeEgress) {
+      pstream = findEgressPushStream(streamId);
+    }
   }
   if (!pstream) {
     return nullptr;
@@ -1105,6 +1134,8 @@ HQSession::findControlStream(quic::StreamId streamId) {
 }
 
 bool HQSession::eraseStream(quic::StreamId streamId) {
+  invalidateStreamLookupCache();
+  egressPriorityScheduler_.erase(streamId);
   // Try different possible locations and remove the
   // stream
   uint8_t erasedBitmask = 0;
@@ -1148,6 +1179,7 @@ bool HQSession::eraseStream(quic::StreamId streamId) {
 }
 
 bool HQSession::eraseStreamByPushId(hq::PushId pushId) {
+  invalidateStreamLookupCache();
 
   bool erased = ingressPushStreams_.erase(pushId);
 
@@ -1221,6 +1253,13 @@ void HQSession::runLoopCallback() noexcept {
 
   readsPerLoop_ = 0;
 
+  // Apply the timeout refresh deferred by the read callbacks, once for the
+  // whole burst
+  if (pendingResetTimeout_) {
+    pendingResetTimeout_ = false;
+    resetTimeout();
+  }
+
   // First process the read data
   //   - and maybe resume reads on the stream
   processReadData();
@@ -1228,6 +1267,11 @@ void HQSession::runLoopCallback() noexcept {
   versionUtils_->readDataProcessed();
 
   // Then handle the writes
+  // Tell the transport (or an external pacer) how big this burst will be
+  // before any of it is written
+  if (maxToSend_ > 0) {
+    emitEgressBatchHint(maxToSend_);
+  }
   // Write all the control streams first
   maxToSend_ -= writeControlStreams(maxToSend_);
   // Then write the request streams
@@ -1259,7 +1303,7 @@ void HQSession::HQVersionUtils::readDataProcessed() {
     auto QPACKDecoderStream =
         session_.findControlStream(UnidirectionalStreamType::QPACK_DECODER);
     DCHECK(QPACKDecoderStream);
-    QPACKDecoderStream->writeBuf_.append(std::move(ici));
+    QPACKDecoderStream->writeBuf_.append(std::move(ici), true /* pack */);
     // don't need to explicitly schedule write because this is called in the
     // loop before control streams are written
   }
@@ -1315,6 +1359,21 @@ void HQSession::scheduleLoopCallback(bool thisIteration) {
   }
 }
 
+void HQSession::emitEgressBatchHint(uint64_t maxToSend) {
+  lastEgressBatchHint_.targetBurstBytes = maxToSend;
+  lastEgressBatchHint_.gsoSegments = static_cast<uint32_t>(
+      (maxToSend + kApproxUDPPayloadLen - 1) / kApproxUDPPayloadLen);
+  if (egressBatchHintCb_) {
+    egressBatchHintCb_(lastEgressBatchHint_);
+  }
+}
+
+void HQSession::resetTimeoutCoalesced() {
+  pendingResetTimeout_ = true;
+  // Guarantees the refresh is applied in this loop iteration
+  scheduleLoopCallback(true);
+}
+
 void HQSession::resumeReads(quic::StreamId streamId) {
   VLOG(4) << __func__ << " sess=" << *this << ": resuming reads";
   sock_->resumeRead(streamId);
@@ -1525,7 +1584,7 @@ void HQSession::readControlStream(HQControlStream* ctrlStream) {
               {readRes.error(), folly::StringPiece("sync read error")});
     return;
   }
-  resetTimeout();
+  resetTimeoutCoalesced();
   quic::Buf data = std::move(readRes.value().first);
   auto readSize = data ? data->computeChainDataLength() : 0;
   VLOG(4) << "Read " << readSize << " bytes from control stream";
@@ -1750,7 +1809,7 @@ void HQSession::readRequestStream(quic::StreamId id) noexcept {
     return;
   }
 
-  resetTimeout();
+  resetTimeoutCoalesced();
   quic::Buf data = std::move(readRes.value().first);
   auto readSize = data ? data->computeChainDataLength() : 0;
   hqStream->readEOF_ = readRes.value().second;
@@ -2174,13 +2233,19 @@ void HQSession::handleSessionError(HQStreamBase* stream,
 uint64_t HQSession::writeRequestStreams(uint64_t maxEgress) noexcept {
   // requestStreamWriteImpl may call txn->onWriteReady
   txnEgressQueue_.nextEgress(nextEgressResults_);
+  if (egressPriorityScheduler_.enabled()) {
+    egressPriorityScheduler_.buildSchedule(nextEgressResults_);
+  }
   for (auto it = nextEgressResults_.begin(); it != nextEgressResults_.end();
        ++it) {
     auto& ratio = it->second;
     auto hqStream =
         static_cast<HQStreamTransportBase*>(&it->first->getTransport());
+    // Cork every write but the last of the round, so the transport sees the
+    // whole burst before packetizing (and can coalesce it with GSO)
+    bool cork = std::next(it) != nextEgressResults_.end();
     // TODO: scale maxToSend by ratio?
-    auto sent = requestStreamWriteImpl(hqStream, maxEgress, ratio);
+    auto sent = requestStreamWriteImpl(hqStream, maxEgress, ratio, cork);
     DCHECK_LE(sent, maxEgress);
     maxEgress -= sent;
 
@@ -2233,12 +2298,13 @@ folly::Expected<size_t, quic::LocalErrorCode> HQSession::writeBase(
     std::unique_ptr<folly::IOBuf> data,
     size_t tryToSend,
     bool sendEof,
-    quic::QuicSocket::DeliveryCallback* deliveryCallback) {
+    quic::QuicSocket::DeliveryCallback* deliveryCallback,
+    bool cork) {
 
   auto writeRes = sock_->writeChain(id,
                                     std::move(data),
                                     sendEof,
-                                    false, // cork
+                                    cork,
                                     deliveryCallback);
   if (writeRes.hasError()) {
     LOG(ERROR) << " Got error=" << writeRes.error() << " streamID=" << id;
@@ -2267,7 +2333,8 @@ folly::Expected<size_t, quic::LocalErrorCode> HQSession::writeBase(
 size_t HQSession::handleWrite(HQStreamTransportBase* hqStream,
                               std::unique_ptr<folly::IOBuf> data,
                               size_t tryToSend,
-                              bool sendEof) {
+                              bool sendEof,
+                              bool cork) {
   quic::QuicSocket::DeliveryCallback* deliveryCallback =
       sendEof ? this : nullptr;
 
@@ -2276,7 +2343,8 @@ size_t HQSession::handleWrite(HQStreamTransportBase* hqStream,
                             std::move(data),
                             tryToSend,
                             sendEof,
-                            deliveryCallback);
+                            deliveryCallback,
+                            cork);
   if (writeRes.hasError()) {
     handleWriteError(hqStream, writeRes.error());
     return 0;
@@ -2301,7 +2369,8 @@ size_t HQSession::handleWrite(HQStreamTransportBase* hqStream,
 
 uint64_t HQSession::requestStreamWriteImpl(HQStreamTransportBase* hqStream,
                                            uint64_t maxEgress,
-                                           double ratio) {
+                                           double ratio,
+                                           bool cork) {
   CHECK(hqStream->queueHandle_.isStreamTransportEnqueued());
   HTTPTransaction::DestructorGuard dg(&hqStream->txn_);
 
@@ -2350,14 +2419,21 @@ uint64_t HQSession::requestStreamWriteImpl(HQStreamTransportBase* hqStream,
   auto tryWriteBuf = hqStream->writeBuf_.splitAtMost(canSend);
   bool sendEof = (hqStream->pendingEOM_ && !hqStream->hasPendingBody());
 
+  // If this write exhausts the round's budget the caller breaks out of the
+  // write loop, so it must flush the corked batch
+  if (sendLen >= maxEgress) {
+    cork = false;
+  }
+
   CHECK(sendLen > 0 || sendEof);
   VLOG(4) << __func__ << " before write sess=" << *this
           << ": streamID=" << streamId << " maxEgress=" << maxEgress
           << " sendWindow=" << streamSendWindow
           << " tryToSend=" << tryWriteBuf->computeChainDataLength()
-          << " sendEof=" << sendEof;
+          << " sendEof=" << sendEof << " cork=" << cork;
 
-  size_t sent = handleWrite(hqStream, std::move(tryWriteBuf), sendLen, sendEof);
+  size_t sent =
+      handleWrite(hqStream, std::move(tryWriteBuf), sendLen, sendEof, cork);
 
   VLOG(4) << __func__ << " after write sess=" << *this
           << ": streamID=" << streamId << " sent=" << sent
@@ -2832,6 +2908,15 @@ bool HQSession::HQStreamTransportBase::processReadData() {
     errorOnTransaction(std::move(ex));
     return false;
   }
+  // The codec parses straight off the transport-owned chain below and
+  // clones refcounted slices for the body bytes it hands to the handler,
+  // so nothing on this path copies payload.  Drop any empty buffers at
+  // the head of the chain first: the transport may deliver them, and a
+  // zero-length head must not stall parsing of the data queued behind it.
+  while ((currentReadBuf = readBuf_.front()) != nullptr &&
+         currentReadBuf->length() == 0) {
+    readBuf_.pop_front();
+  }
   while (!ingressError_ && (currentReadBuf = readBuf_.front()) != nullptr &&
          currentReadBuf->length() != 0) {
     size_t bytesParsed = codecFilterChain->onIngress(*currentReadBuf);
@@ -3051,7 +3136,7 @@ void HQSession::HQVersionUtils::abortStream(quic::StreamId id) {
   auto QPACKDecoderStream =
       session_.findControlStream(hq::UnidirectionalStreamType::QPACK_DECODER);
   DCHECK(QPACKDecoderStream);
-  QPACKDecoderStream->writeBuf_.append(std::move(cancel));
+  QPACKDecoderStream->writeBuf_.append(std::move(cancel), true /* pack */);
   session_.scheduleWrite();
 }
 
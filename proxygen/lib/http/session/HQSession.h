@@ -10,6 +10,7 @@
 
 #pragma once
 
+#include <folly/Function.h>
 #include <folly/io/IOBufQueue.h>
 #include <folly/io/async/AsyncSocket.h>
 #include <folly/io/async/DelayedDestructionBase.h>
@@ -27,6 +28,8 @@
 #include <proxygen/lib/http/codec/QPACKDecoderCodec.h>
 #include <proxygen/lib/http/codec/QPACKEncoderCodec.h>
 #include <proxygen/lib/http/session/ByteEventTracker.h>
+#include <proxygen/lib/http/session/HQPriorityScheduler.h>
+#include <proxygen/lib/http/session/HQMigrationState.h>
 #include <proxygen/lib/http/session/HQStreamBase.h>
 #include <proxygen/lib/http/session/HQStreamLookup.h>
 #include <proxygen/lib/http/session/HQUnidirectionalCallbacks.h>
@@ -325,6 +328,32 @@ class HQSession
     return &unidirectionalReadDispatcher_;
   }
 
+  /**
+   * Pacing/batching hint describing the egress round about to be handed to
+   * the transport: how many bytes the session intends to write in this
+   * burst, and how many MTU-sized segments that amounts to for transports
+   * that support UDP GSO.
+   */
+  struct EgressBatchHint {
+    uint64_t targetBurstBytes{0};
+    uint32_t gsoSegments{0};
+  };
+
+  using EgressBatchHintCallback = folly::Function<void(const EgressBatchHint&)>;
+
+  /**
+   * Invoked once per write round, before any stream data is written, so an
+   * embedder can forward the burst size / segment count to a GSO-capable
+   * UDP socket or an external pacer.
+   */
+  void setEgressBatchHintCallback(EgressBatchHintCallback cb) {
+    egressBatchHintCb_ = std::move(cb);
+  }
+
+  const EgressBatchHint& getLastEgressBatchHint() const {
+    return lastEgressBatchHint_;
+  }
+
   /**
    * Set flow control properties on an already started session.
    * QUIC requires both stream and connection flow control window sizes to be
@@ -364,6 +393,16 @@ class HQSession
     // need transport API
   }
 
+  /**
+   * Sets the urgency/incremental egress priority for a request stream,
+   * engaging the priority scheduler for this session.  See
+   * HQPriorityScheduler for the scheduling model.
+   */
+  void setStreamUrgency(quic::StreamId id, uint8_t urgency, bool incremental) {
+    egressPriorityScheduler_.setUrgency(id, urgency, incremental);
+    scheduleWrite();
+  }
+
   /**
    * Send a settings frame
    */
@@ -414,6 +453,15 @@ class HQSession
     return false;
   }
 
+  /**
+   * Serializes this session's resumable HTTP/3-layer state (peer
+   * SETTINGS, QPACK dynamic table, per-stream committed egress offsets)
+   * for warm process handoff.  See HQMigrationState for the format and
+   * what deliberately does not travel in the blob.  Intended to be
+   * called while draining, after egress has quiesced.
+   */
+  hq::HQMigrationState captureMigrationState();
+
   // From ManagedConnection
   void timeoutExpired() noexcept override;
 
@@ -451,6 +499,16 @@ class HQSession
         [this, stats] { versionUtils_->setHeaderCodecStats(stats); });
   }
 
+  /**
+   * Tune the QPACK blocked-stream budget at run time, e.g. from the
+   * transport's RTT estimate.  See QPACKCodec::setBlockedStreamsBudget for
+   * the clamping rules; folly::none restores the settings-negotiated limits.
+   */
+  void setQPACKBlockedStreamsBudget(folly::Optional<uint32_t> budget) {
+    versionUtilsReady_.then(
+        [this, budget] { versionUtils_->setBlockedStreamsBudget(budget); });
+  }
+
   void enableDoubleGoawayDrain() override {
   }
 
@@ -767,7 +825,8 @@ class HQSession
   size_t handleWrite(HQStreamTransportBase* hqStream,
                      std::unique_ptr<folly::IOBuf> data,
                      size_t length,
-                     bool sendEof);
+                     bool sendEof,
+                     bool cork = false);
 
   /**
    * Wraps calls to the socket writeChain and handles the case where the
@@ -782,7 +841,8 @@ class HQSession
       std::unique_ptr<folly::IOBuf> data,
       size_t tryToSend,
       bool sendEof,
-      quic::QuicSocket::DeliveryCallback* deliveryCallback = nullptr);
+      quic::QuicSocket::DeliveryCallback* deliveryCallback = nullptr,
+      bool cork = false);
 
   /**
    * Helper function to perform writes on a single request stream
@@ -793,7 +853,14 @@ class HQSession
    */
   uint64_t requestStreamWriteImpl(HQStreamTransportBase* hqStream,
                                   uint64_t maxEgress,
-                                  double ratio);
+                                  double ratio,
+                                  bool cork = false);
+
+  /**
+   * Compute and publish the EgressBatchHint for a write round of up to
+   * maxToSend bytes.
+   */
+  void emitEgressBatchHint(uint64_t maxToSend);
 
   uint64_t writeControlStreams(uint64_t maxEgress);
   uint64_t controlStreamWriteImpl(HQControlStream* ctrlStream,
@@ -821,6 +888,22 @@ class HQSession
                                         bool includeIngress = true,
                                         bool includeDetached = true);
 
+  /**
+   * Drop the one-entry lookup cache in front of findStreamImpl. Must be
+   * called whenever a stream is erased from any of the stream maps.
+   */
+  void invalidateStreamLookupCache() {
+    lastLookupStream_ = nullptr;
+  }
+
+  /**
+   * Coalesced resetTimeout() for the hot read path. QUIC delivers read
+   * callbacks in bursts within one loop iteration; instead of refreshing
+   * the wheel timer once per stream, note the refresh here and apply it
+   * once in runLoopCallback().
+   */
+  void resetTimeoutCoalesced();
+
   /**
    * Shared implementation of "numberOfXXX" methods
    */
@@ -1924,6 +2007,8 @@ class HQSession
     }
     virtual void setHeaderCodecStats(HeaderCodec::Stats*) {
     }
+    virtual void setBlockedStreamsBudget(folly::Optional<uint32_t>) {
+    }
     virtual bool isPartialReliabilityEnabled() const noexcept = 0;
     virtual folly::Expected<uint64_t, hq::UnframedBodyOffsetTrackerError>
     onIngressPeekDataAvailable(uint64_t /* streamOffset */) {
@@ -2070,6 +2155,10 @@ class HQSession
       qpackCodec_.setStats(stats);
     }
 
+    void setBlockedStreamsBudget(folly::Optional<uint32_t> budget) override {
+      qpackCodec_.setBlockedStreamsBudget(budget);
+    }
+
     bool isPartialReliabilityEnabled() const noexcept override {
       return session_.sock_ && session_.sock_->isPartiallyReliableTransport();
     }
@@ -2163,6 +2252,12 @@ class HQSession
    */
   HTTP2PriorityQueue::NextEgressResult nextEgressResults_;
 
+  /**
+   * Reorders each write round per the urgency/incremental model once any
+   * stream has registered a priority
+   */
+  HQPriorityScheduler egressPriorityScheduler_;
+
   // Bidirectional transport streams
   std::unordered_map<quic::StreamId, HQStreamTransport> streams_;
 
@@ -2206,11 +2301,22 @@ class HQSession
   uint64_t maxToSend_{0};
   bool scheduledWrite_{false};
 
+  EgressBatchHintCallback egressBatchHintCb_;
+  EgressBatchHint lastEgressBatchHint_;
+
   bool forceUpstream1_1_{true};
 
   /** Reads in the current loop iteration */
   uint16_t readsPerLoop_{0};
   std::unordered_set<quic::StreamId> pendingProcessReadSet_;
+  /**
+   * One-entry MRU cache for findStreamImpl; QUIC events for the same
+   * stream arrive in bursts, so most lookups repeat the previous one.
+   */
+  quic::StreamId lastLookupStreamId_{0};
+  HQStreamTransportBase* lastLookupStream_{nullptr};
+  /** Whether a coalesced timeout refresh is pending for this iteration */
+  bool pendingResetTimeout_{false};
   std::shared_ptr<QuicProtocolInfo> quicInfo_;
   folly::Optional<HQVersion> version_;
   std::string alpn_;
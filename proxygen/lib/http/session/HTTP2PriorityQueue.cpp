@@ -9,8 +9,8 @@
  */
 #include <proxygen/lib/http/session/HTTP2PriorityQueue.h>
 
-using std::list;
-using std::unique_ptr;
+#include <algorithm>
+#include <new>
 
 namespace proxygen {
 
@@ -18,6 +18,12 @@ uint32_t HTTP2PriorityQueue::kMaxRebuilds_ = 3;
 std::chrono::milliseconds HTTP2PriorityQueue::kNodeLifetime_ =
     std::chrono::seconds(30);
 
+void HTTP2PriorityQueue::NodeDestructor::operator()(Node* node) {
+  auto& pool = node->queue_.nodePool_;
+  node->~Node();
+  pool.recycle(node);
+}
+
 HTTP2PriorityQueue::Node::Node(HTTP2PriorityQueue& queue,
                                HTTP2PriorityQueue::Node* inParent,
                                HTTPCodec::StreamID id,
@@ -37,13 +43,16 @@ HTTP2PriorityQueue::Node::~Node() {
   if (!txn_) {
     queue_.numVirtualNodes_--;
   }
+  if (budget_) {
+    queue_.numEgressBudgets_--;
+  }
 }
 
 // Add a new node as a child of this node
 HTTP2PriorityQueue::Node* HTTP2PriorityQueue::Node::emplaceNode(
-    unique_ptr<HTTP2PriorityQueue::Node> node, bool exclusive) {
+    HTTP2PriorityQueue::NodePtr node, bool exclusive) {
   CHECK(!node->isEnqueued());
-  list<unique_ptr<Node>> children;
+  NodeList children;
   CHECK_NE(id_, node->id_) << "Tried to create a loop in the tree";
   if (exclusive) {
     // this->children become new node's children
@@ -63,8 +72,8 @@ HTTP2PriorityQueue::Node* HTTP2PriorityQueue::Node::emplaceNode(
   return res;
 }
 
-void HTTP2PriorityQueue::Node::addChildren(list<unique_ptr<Node>>&& children) {
-  list<unique_ptr<Node>> emptyChilden;
+void HTTP2PriorityQueue::Node::addChildren(NodeList&& children) {
+  NodeList emptyChilden;
   uint64_t totalEnqueuedWeight = 0;
   for (auto& child : children) {
     if (child->inEgressTree()) {
@@ -87,22 +96,25 @@ void HTTP2PriorityQueue::Node::addChildren(list<unique_ptr<Node>>&& children) {
 }
 
 HTTP2PriorityQueue::Node* HTTP2PriorityQueue::Node::addChild(
-    unique_ptr<HTTP2PriorityQueue::Node> child) {
+    HTTP2PriorityQueue::NodePtr child) {
   CHECK_NE(id_, child->id_) << "Tried to create a loop in the tree";
   child->parent_ = this;
   totalChildWeight_ += child->weight_;
   Node* raw = child.get();
-  raw->self_ = children_.insert(children_.end(), std::move(child));
+  children_.emplace_back(std::move(child));
   cancelTimeout();
   return raw;
 }
 
-unique_ptr<HTTP2PriorityQueue::Node> HTTP2PriorityQueue::Node::detachChild(
-    Node* node) {
+HTTP2PriorityQueue::NodePtr HTTP2PriorityQueue::Node::detachChild(Node* node) {
   CHECK(!node->isEnqueued());
   totalChildWeight_ -= node->weight_;
-  auto it = node->self_;
-  auto res = std::move(*node->self_);
+  auto it = std::find_if(
+      children_.begin(), children_.end(), [node](const NodePtr& child) {
+        return child.get() == node;
+      });
+  CHECK(it != children_.end());
+  auto res = std::move(*it);
   children_.erase(it);
   node->parent_ = nullptr;
   if (children_.empty() && !txn_ && !isPermanent_) {
@@ -263,15 +275,70 @@ bool HTTP2PriorityQueue::Node::iterate(
   if (parent_ /* exclude root */ && (all || isEnqueued())) {
     stop = fn(id_, txn_, getRelativeWeight());
   }
-  for (auto& child : children_) {
+  // fn may remove the current child, which erases it from children_ and
+  // appends its children at the back - only advance if it is still in place
+  size_t i = 0;
+  while (i < children_.size()) {
     if (stop || stopFn()) {
       return true;
     }
+    auto child = children_[i].get();
     stop = child->iterate(fn, stopFn, all);
+    if (i < children_.size() && children_[i].get() == child) {
+      i++;
+    }
   }
   return stop;
 }
 
+void HTTP2PriorityQueue::Node::setEgressBudget(uint64_t bytesPerSecond,
+                                               uint64_t maxBurstBytes) {
+  if (!budget_) {
+    budget_ = std::make_unique<EgressBudget>();
+    queue_.numEgressBudgets_++;
+  }
+  budget_->bytesPerSecond = bytesPerSecond;
+  budget_->maxBurstBytes = maxBurstBytes;
+  // Start with a full bucket so the first burst goes out unthrottled
+  budget_->tokens = maxBurstBytes;
+  budget_->lastRefill = getCurrentTime();
+}
+
+void HTTP2PriorityQueue::Node::clearEgressBudget() {
+  if (budget_) {
+    budget_.reset();
+    queue_.numEgressBudgets_--;
+  }
+}
+
+bool HTTP2PriorityQueue::Node::budgetAllowsEgress(TimePoint now) {
+  auto& budget = *budget_;
+  auto elapsed = millisecondsBetween(now, budget.lastRefill);
+  if (elapsed.count() > 0) {
+    budget.tokens =
+        std::min<double>(budget.maxBurstBytes,
+                         budget.tokens + static_cast<double>(
+                                             budget.bytesPerSecond) *
+                                             elapsed.count() / 1000.0);
+    budget.lastRefill = now;
+  }
+  return budget.tokens >= 1.0;
+}
+
+void HTTP2PriorityQueue::Node::chargeEgressBudgets(uint64_t bytes) {
+  for (Node* node = this; node; node = node->parent_) {
+    if (node->budget_) {
+      // The bucket may go negative, e.g. from work-conserving fallback
+      // sends, but cap the debt at one burst so a subtree that had the
+      // connection to itself is not locked out for long once competing
+      // traffic shows up
+      node->budget_->tokens =
+          std::max(node->budget_->tokens - static_cast<double>(bytes),
+                   -static_cast<double>(node->budget_->maxBurstBytes));
+    }
+  }
+}
+
 bool HTTP2PriorityQueue::Node::visitBFS(
     double relativeParentWeight,
     const std::function<bool(HTTP2PriorityQueue& queue,
@@ -281,6 +348,12 @@ bool HTTP2PriorityQueue::Node::visitBFS(
     bool all,
     PendingList& pendingNodes,
     bool enqueuedChildren) {
+  if (queue_.enforceBudgets_ && budget_ &&
+      !budgetAllowsEgress(queue_.budgetWalkTime_)) {
+    // Empty bucket: the whole subtree sits this walk out
+    queue_.budgetThrottleCount_++;
+    return false;
+  }
   bool invoke = (parent_ != nullptr && (all || isEnqueued()));
   auto relativeEnqueuedWeight = getRelativeEnqueuedWeight();
 
@@ -333,9 +406,15 @@ void HTTP2PriorityQueue::Node::updateEnqueuedWeight(bool activeNodes) {
 #endif
 
 void HTTP2PriorityQueue::Node::dropPriorityNodes() {
-  for (auto it = children_.begin(); it != children_.end();) {
-    auto& child = *it++;
+  // A dropped child erases itself from children_ and appends its children
+  // at the back - only advance if the current child is still in place
+  size_t i = 0;
+  while (i < children_.size()) {
+    auto child = children_[i].get();
     child->dropPriorityNodes();
+    if (i < children_.size() && children_[i].get() == child) {
+      i++;
+    }
   }
   if (!txn_ && !isPermanent_) {
     removeFromTree();
@@ -364,7 +443,7 @@ uint64_t HTTP2PriorityQueue::Node::calculateDepth(bool includeVirtual) const {
 }
 
 void HTTP2PriorityQueue::Node::flattenSubtree() {
-  std::list<std::unique_ptr<Node>> oldChildren_;
+  NodeList oldChildren_;
   // Move the old children to a temporary list
   std::swap(oldChildren_, children_);
   // Reparent the children
@@ -380,7 +459,7 @@ void HTTP2PriorityQueue::Node::flattenSubtree() {
   totalChildWeight_ = 0;
   std::for_each(children_.begin(),
                 children_.end(),
-                [this](const std::unique_ptr<Node>& child) {
+                [this](const NodePtr& child) {
                   totalChildWeight_ += child->weight_;
                   if (child->enqueued_) {
                     totalEnqueuedWeight_ += child->weight_;
@@ -398,8 +477,8 @@ void HTTP2PriorityQueue::Node::flattenSubtreeDFS(Node* subtreeRoot) {
   }
 }
 
-void HTTP2PriorityQueue::Node::addChildToNewSubtreeRoot(
-    std::unique_ptr<Node> child, Node* subtreeRoot) {
+void HTTP2PriorityQueue::Node::addChildToNewSubtreeRoot(NodePtr child,
+                                                        Node* subtreeRoot) {
   child->children_.clear();
   child->parent_ = subtreeRoot;
   child->weight_ = kDefaultWeight;
@@ -408,9 +487,7 @@ void HTTP2PriorityQueue::Node::addChildToNewSubtreeRoot(
 #ifndef NDEBUG
   child->totalEnqueuedWeightCheck_ = 0;
 #endif
-  Node* raw = child.get();
-  raw->self_ = subtreeRoot->children_.insert(subtreeRoot->children_.end(),
-                                             std::move(child));
+  subtreeRoot->children_.emplace_back(std::move(child));
 }
 
 /// class HTTP2PriorityQueue
@@ -503,7 +580,8 @@ HTTP2PriorityQueue::Handle HTTP2PriorityQueue::addTransaction(
   }
   VLOG(4) << "Adding id=" << id << " with parent=" << parent->getID()
           << " and weight=" << ((uint16_t)pri.weight + 1);
-  auto node = std::make_unique<Node>(*this, parent, id, pri.weight, txn);
+  NodePtr node(new (nodePool_.allocate())
+                   Node(*this, parent, id, pri.weight, txn));
   if (permanent) {
     node->setPermanent();
   } else if (!txn) {
@@ -650,6 +728,25 @@ void HTTP2PriorityQueue::nextEgress(
   nextEgressResults_ = &result;
 
   updateEnqueuedWeight();
+  enforceBudgets_ = numEgressBudgets_ > 0;
+  if (enforceBudgets_) {
+    budgetWalkTime_ = getCurrentTime();
+  }
+  nextEgressWalk(result, spdyMode);
+  if (result.empty() && enforceBudgets_) {
+    // Everything with pending egress is throttled.  Budgets bound a
+    // subtree's share against competing traffic, they never idle the
+    // connection, so rerun the walk without enforcement.
+    enforceBudgets_ = false;
+    nextEgressWalk(result, spdyMode);
+  }
+  enforceBudgets_ = false;
+  std::sort(result.begin(), result.end(), WeightCmp());
+  nextEgressResults_ = nullptr;
+}
+
+void HTTP2PriorityQueue::nextEgressWalk(
+    HTTP2PriorityQueue::NextEgressResult& result, bool spdyMode) {
   Node::PendingList pendingNodes;
   Node::PendingList pendingNodesTmp;
   pendingNodes.emplace_back(rootNodeId_, &root_, 1.0);
@@ -681,8 +778,25 @@ void HTTP2PriorityQueue::nextEgress(
     }
     std::swap(pendingNodes, pendingNodesTmp);
   } while (!stop && !pendingNodes.empty());
-  std::sort(result.begin(), result.end(), WeightCmp());
-  nextEgressResults_ = nullptr;
+}
+
+void HTTP2PriorityQueue::setSubtreeEgressBudget(Handle handle,
+                                                uint64_t bytesPerSecond,
+                                                uint64_t maxBurstBytes) {
+  CHECK_NOTNULL(dynamic_cast<Node*>(handle))
+      ->setEgressBudget(bytesPerSecond, maxBurstBytes);
+}
+
+void HTTP2PriorityQueue::clearSubtreeEgressBudget(Handle handle) {
+  CHECK_NOTNULL(dynamic_cast<Node*>(handle))->clearEgressBudget();
+}
+
+void HTTP2PriorityQueue::consumeEgressBudget(HTTPCodec::StreamID id,
+                                             uint64_t bytes) {
+  Node* node = findInternal(id);
+  if (node) {
+    node->chargeEgressBudgets(bytes);
+  }
 }
 
 HTTP2PriorityQueue::Node* HTTP2PriorityQueue::find(HTTPCodec::StreamID id,
@@ -11,13 +11,17 @@
 
 #include <folly/IntrusiveList.h>
 #include <folly/io/async/HHWheelTimer.h>
+#include <folly/small_vector.h>
 #include <proxygen/lib/http/codec/HTTP2Framer.h>
 #include <proxygen/lib/http/codec/HTTPCodec.h>
+#include <proxygen/lib/utils/Time.h>
 #include <proxygen/lib/utils/WheelTimerInstance.h>
 
 #include <boost/intrusive/unordered_set.hpp>
 #include <deque>
-#include <list>
+#include <memory>
+#include <type_traits>
+#include <vector>
 
 namespace proxygen {
 
@@ -71,6 +75,15 @@ class HTTP2PriorityQueue : public HTTP2PriorityQueueBase {
 
  private:
   class Node;
+
+  // Destroys a pool-allocated Node and returns its storage to the queue's
+  // NodePool.  The root node is a direct member and never goes through this.
+  struct NodeDestructor {
+    void operator()(Node* node);
+  };
+  using NodePtr = std::unique_ptr<Node, NodeDestructor>;
+  using NodeList = folly::small_vector<NodePtr, 2>;
+
   using NodeMap = boost::intrusive::
       unordered_set<Node, boost::intrusive::constant_time_size<false>>;
 
@@ -168,6 +181,38 @@ class HTTP2PriorityQueue : public HTTP2PriorityQueueBase {
 
   void nextEgress(NextEgressResult& result, bool spdyMode = false);
 
+  /**
+   * Attach a token-bucket byte budget to the priority subtree rooted at
+   * handle.  While the bucket is empty, nextEgress skips the subtree, so
+   * its streams cannot exceed bytesPerSecond on average no matter what
+   * weights they advertise.  Budgets are work-conserving: if every stream
+   * with pending egress is throttled, the walk reruns without enforcement
+   * rather than idling the connection.
+   */
+  void setSubtreeEgressBudget(Handle h,
+                              uint64_t bytesPerSecond,
+                              uint64_t maxBurstBytes);
+
+  void clearSubtreeEgressBudget(Handle h);
+
+  bool hasEgressBudgets() const {
+    return numEgressBudgets_ > 0;
+  }
+
+  /**
+   * Charge bytes granted to the given stream against every budget on its
+   * ancestor chain.  Buckets may go negative; the debt keeps the subtree
+   * throttled until refill catches up.
+   */
+  void consumeEgressBudget(HTTPCodec::StreamID id, uint64_t bytes);
+
+  // Number of subtrees budget enforcement skipped since the last call
+  uint64_t getAndResetBudgetThrottleCount() {
+    auto count = budgetThrottleCount_;
+    budgetThrottleCount_ = 0;
+    return count;
+  }
+
   static void setNodeLifetime(std::chrono::milliseconds lifetime) {
     kNodeLifetime_ = lifetime;
   }
@@ -211,6 +256,8 @@ class HTTP2PriorityQueue : public HTTP2PriorityQueueBase {
                                HTTPTransaction* txn,
                                double r);
 
+  void nextEgressWalk(NextEgressResult& result, bool spdyMode);
+
   void updateEnqueuedWeight();
 
  private:
@@ -284,7 +331,7 @@ class HTTP2PriorityQueue : public HTTP2PriorityQueueBase {
     }
 
     // Add a new node as a child of this node
-    Node* emplaceNode(std::unique_ptr<Node> node, bool exclusive);
+    Node* emplaceNode(NodePtr node, bool exclusive);
 
     // Removes the node from the tree
     void removeFromTree();
@@ -373,6 +420,21 @@ class HTTP2PriorityQueue : public HTTP2PriorityQueueBase {
 
     void updateEnqueuedWeight(bool activeNodes);
 
+    void setEgressBudget(uint64_t bytesPerSecond, uint64_t maxBurstBytes);
+
+    void clearEgressBudget();
+
+    bool hasEgressBudget() const {
+      return budget_ != nullptr;
+    }
+
+    // Refills the bucket from elapsed time, then reports whether the
+    // subtree may produce egress in this walk
+    bool budgetAllowsEgress(TimePoint now);
+
+    // Charge bytes against this node's budget and those of its ancestors
+    void chargeEgressBudgets(uint64_t bytes);
+
     void dropPriorityNodes();
 
     void convertVirtualNode(HTTPTransaction* txn);
@@ -382,15 +444,25 @@ class HTTP2PriorityQueue : public HTTP2PriorityQueueBase {
     // Internal error recovery
     void flattenSubtree();
     void flattenSubtreeDFS(Node* subtreeRoot);
-    static void addChildToNewSubtreeRoot(std::unique_ptr<Node> child,
-                                         Node* subtreeRoot);
+    static void addChildToNewSubtreeRoot(NodePtr child, Node* subtreeRoot);
 
    private:
-    Node* addChild(std::unique_ptr<Node> child);
+    friend struct NodeDestructor;
+
+    // Token-bucket state for a budgeted subtree, heap-allocated only for
+    // the few nodes that carry one
+    struct EgressBudget {
+      uint64_t bytesPerSecond{0};
+      uint64_t maxBurstBytes{0};
+      double tokens{0};
+      TimePoint lastRefill;
+    };
+
+    Node* addChild(NodePtr child);
 
-    void addChildren(std::list<std::unique_ptr<Node>>&& children);
+    void addChildren(NodeList&& children);
 
-    std::unique_ptr<Node> detachChild(Node* node);
+    NodePtr detachChild(Node* node);
 
     void addEnqueuedChild(HTTP2PriorityQueue::Node* node);
 
@@ -418,6 +490,7 @@ class HTTP2PriorityQueue : public HTTP2PriorityQueueBase {
     HTTPCodec::StreamID id_;
     uint16_t weight_{kDefaultWeight};
     HTTPTransaction* txn_{nullptr};
+    std::unique_ptr<EgressBudget> budget_;
     bool isPermanent_{false};
     bool enqueued_{false};
 #ifndef NDEBUG
@@ -425,8 +498,7 @@ class HTTP2PriorityQueue : public HTTP2PriorityQueueBase {
 #endif
     uint64_t totalEnqueuedWeight_{0};
     uint64_t totalChildWeight_{0};
-    std::list<std::unique_ptr<Node>> children_;
-    std::list<std::unique_ptr<Node>>::iterator self_;
+    NodeList children_;
     // enqueuedChildren_ includes all children that are themselves enqueued_
     // or have enqueued descendants. Therefore, enqueuedChildren_ may contain
     // direct children that have enqueued_ == false
@@ -434,6 +506,44 @@ class HTTP2PriorityQueue : public HTTP2PriorityQueueBase {
     folly::IntrusiveList<Node, &Node::enqueuedHook_> enqueuedChildren_;
   };
 
+  /**
+   * Node storage.  Nodes are carved from contiguous slabs and recycled
+   * through a free list instead of being heap-allocated individually, so
+   * the tree for a connection stays packed in a few cache-friendly regions.
+   * Addresses are stable for the lifetime of the queue, which the Handle
+   * API and the intrusive hooks rely on.
+   */
+  class NodePool {
+   public:
+    void* allocate() {
+      if (!freeList_.empty()) {
+        auto storage = freeList_.back();
+        freeList_.pop_back();
+        return storage;
+      }
+      if (slabs_.empty() || slabUsed_ == kNodesPerSlab) {
+        slabs_.emplace_back(std::make_unique<Storage[]>(kNodesPerSlab));
+        slabUsed_ = 0;
+      }
+      return &slabs_.back()[slabUsed_++];
+    }
+
+    void recycle(void* storage) {
+      freeList_.push_back(storage);
+    }
+
+   private:
+    using Storage =
+        typename std::aligned_storage<sizeof(Node), alignof(Node)>::type;
+    static const size_t kNodesPerSlab = 64;
+
+    std::vector<std::unique_ptr<Storage[]>> slabs_;
+    size_t slabUsed_{0};
+    std::vector<void*> freeList_;
+  };
+
+  // Declared before root_ so recycled children outlive their storage
+  NodePool nodePool_;
   typename NodeMap::bucket_type nodeBuckets_[kNumBuckets];
   NodeMap nodes_;
   Node root_;
@@ -446,6 +556,13 @@ class HTTP2PriorityQueue : public HTTP2PriorityQueueBase {
   bool pendingWeightChange_{false};
   WheelTimerInstance timeout_;
 
+  // Token-bucket budget state; enforceBudgets_/budgetWalkTime_ are only
+  // meaningful for the duration of a nextEgress walk
+  uint32_t numEgressBudgets_{0};
+  uint64_t budgetThrottleCount_{0};
+  bool enforceBudgets_{false};
+  TimePoint budgetWalkTime_;
+
   NextEgressResult* nextEgressResults_{nullptr};
   static std::chrono::milliseconds kNodeLifetime_;
 };
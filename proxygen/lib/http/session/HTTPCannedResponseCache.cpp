@@ -0,0 +1,140 @@
+/*
+ *  Copyright (c) 2015-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include <proxygen/lib/http/session/HTTPCannedResponseCache.h>
+
+#include <folly/Conv.h>
+#include <proxygen/lib/http/HTTPMessage.h>
+#include <proxygen/lib/http/codec/CodecUtil.h>
+#include <proxygen/lib/http/codec/HTTP2Framer.h>
+#include <proxygen/lib/http/codec/compress/HPACKCodec.h>
+#include <proxygen/lib/http/codec/compress/QPACKCodec.h>
+
+using folly::IOBuf;
+
+namespace {
+
+proxygen::HTTPMessage makeCannedResponse(uint16_t statusCode) {
+  proxygen::HTTPMessage response;
+  response.setHTTPVersion(1, 1);
+  response.setStatusCode(statusCode);
+  response.setStatusMessage(proxygen::HTTPMessage::getDefaultReason(statusCode));
+  response.getHeaders().add(proxygen::HTTP_HEADER_CONTENT_LENGTH, "0");
+  return response;
+}
+
+} // anonymous namespace
+
+namespace proxygen {
+
+HTTPCannedResponseCache& HTTPCannedResponseCache::getInstance() {
+  static HTTPCannedResponseCache instance;
+  return instance;
+}
+
+std::unique_ptr<IOBuf> HTTPCannedResponseCache::getHTTP1Response(
+    uint16_t statusCode) {
+  Key key{CodecProtocol::HTTP_1_1, statusCode};
+  {
+    auto cache = cache_.rlock();
+    auto it = cache->find(key);
+    if (it != cache->end()) {
+      return it->second->clone();
+    }
+  }
+  // Matches the serialization HTTP1xCodec produces for a body-less
+  // downstream response
+  std::string bytes = folly::to<std::string>(
+      "HTTP/1.1 ", statusCode, " ",
+      HTTPMessage::getDefaultReason(statusCode),
+      "\r\nConnection: close\r\nContent-Length: 0\r\n\r\n");
+  auto cache = cache_.wlock();
+  auto& entry = (*cache)[key];
+  if (!entry) {
+    entry = IOBuf::copyBuffer(bytes);
+  }
+  return entry->clone();
+}
+
+std::unique_ptr<IOBuf> HTTPCannedResponseCache::getHTTP2HeaderBlock(
+    uint16_t statusCode) {
+  Key key{CodecProtocol::HTTP_2, statusCode};
+  {
+    auto cache = cache_.rlock();
+    auto it = cache->find(key);
+    if (it != cache->end()) {
+      return it->second->clone();
+    }
+  }
+  auto response = makeCannedResponse(statusCode);
+  std::vector<compress::Header> allHeaders;
+  std::vector<std::string> temps;
+  CodecUtil::prepareMessageForCompression(response, allHeaders, temps);
+
+  // A zero-capacity table forces every header out as a literal with at
+  // most a static-table name reference.  The size change itself is
+  // signalled in the first block the encoder emits, so prime it with a
+  // throwaway encode; the cached block then carries no table size update
+  // and no dynamic references, making it valid on any connection.
+  HPACKCodec codec(TransportDirection::DOWNSTREAM);
+  codec.setEncoderHeaderTableSize(0);
+  codec.encode(allHeaders);
+
+  auto block = codec.encode(allHeaders);
+  auto cache = cache_.wlock();
+  auto& entry = (*cache)[key];
+  if (!entry) {
+    entry = std::move(block);
+  }
+  return entry->clone();
+}
+
+size_t HTTPCannedResponseCache::writeHTTP2Response(folly::IOBufQueue& writeBuf,
+                                                   uint32_t stream,
+                                                   uint16_t statusCode) {
+  return http2::writeHeaders(writeBuf,
+                             getHTTP2HeaderBlock(statusCode),
+                             stream,
+                             folly::none,
+                             http2::kNoPadding,
+                             true /* endStream */,
+                             true /* endHeaders */);
+}
+
+std::unique_ptr<IOBuf> HTTPCannedResponseCache::getHQHeaderBlock(
+    uint16_t statusCode) {
+  Key key{CodecProtocol::HQ, statusCode};
+  {
+    auto cache = cache_.rlock();
+    auto it = cache->find(key);
+    if (it != cache->end()) {
+      return it->second->clone();
+    }
+  }
+  auto response = makeCannedResponse(statusCode);
+  std::vector<compress::Header> allHeaders;
+  std::vector<std::string> temps;
+  CodecUtil::prepareMessageForCompression(response, allHeaders, temps);
+
+  // QPACK starts with a zero-capacity dynamic table, so a fresh encoder
+  // yields a block with required insert count 0 and static references
+  // only; no encoder stream bytes are produced
+  QPACKCodec codec;
+  auto result = codec.encode(allHeaders, 0 /* id */);
+  DCHECK(!result.control);
+
+  auto cache = cache_.wlock();
+  auto& entry = (*cache)[key];
+  if (!entry) {
+    entry = std::move(result.stream);
+  }
+  return entry->clone();
+}
+
+} // namespace proxygen
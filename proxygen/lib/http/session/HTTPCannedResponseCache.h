@@ -0,0 +1,68 @@
+/*
+ *  Copyright (c) 2015-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#pragma once
+
+#include <map>
+#include <memory>
+
+#include <folly/Synchronized.h>
+#include <folly/io/IOBuf.h>
+#include <folly/io/IOBufQueue.h>
+#include <proxygen/lib/http/codec/CodecProtocol.h>
+
+namespace proxygen {
+
+/**
+ * Process-wide cache of pre-encoded, body-less direct responses (4xx/5xx,
+ * health checks, redirect shells), keyed by (protocol, status code).
+ *
+ * During upstream outages a proxy can serve millions of identical 503s a
+ * minute; building an HTTPMessage and running the codec for each one is
+ * pure waste.  Entries are encoded once on first use and handed out as
+ * clones sharing the cached buffer:
+ *
+ *  - HTTP/1.1: the complete serialized response (status line, headers,
+ *    terminating CRLF), ready to write to the transport.
+ *  - HTTP/2: an HPACK header block containing only static-table
+ *    references, so it is valid on any connection regardless of dynamic
+ *    table state; writeHTTP2Response() frames it per stream.
+ *  - HTTP/3: the equivalent QPACK block with required insert count zero,
+ *    for the session to wrap in an HQ HEADERS frame.
+ *
+ * All cached responses carry Content-Length: 0; the HTTP/1.1 variant also
+ * sends Connection: close since direct responses terminate the connection.
+ */
+class HTTPCannedResponseCache {
+ public:
+  static HTTPCannedResponseCache& getInstance();
+
+  std::unique_ptr<folly::IOBuf> getHTTP1Response(uint16_t statusCode);
+
+  std::unique_ptr<folly::IOBuf> getHTTP2HeaderBlock(uint16_t statusCode);
+
+  /**
+   * Write a complete HEADERS frame with END_STREAM/END_HEADERS carrying
+   * the cached block for the given stream.  Returns bytes written.
+   */
+  size_t writeHTTP2Response(folly::IOBufQueue& writeBuf,
+                            uint32_t stream,
+                            uint16_t statusCode);
+
+  std::unique_ptr<folly::IOBuf> getHQHeaderBlock(uint16_t statusCode);
+
+ private:
+  HTTPCannedResponseCache() {
+  }
+
+  using Key = std::pair<CodecProtocol, uint16_t>;
+  folly::Synchronized<std::map<Key, std::unique_ptr<folly::IOBuf>>> cache_;
+};
+
+} // namespace proxygen
@@ -18,39 +18,51 @@ namespace proxygen {
 
 HTTPDefaultSessionCodecFactory::HTTPDefaultSessionCodecFactory(
     const AcceptorConfiguration& accConfig)
-    : accConfig_(accConfig) {
-  // set up codec defaults in the case of plaintext connections
-  auto version = SPDYCodec::getVersion(accConfig.plaintextProtocol);
-  if (version) {
-    alwaysUseSPDYVersion_ = *version;
-  } else if (accConfig.plaintextProtocol == http2::kProtocolCleartextString) {
-    alwaysUseHTTP2_ = true;
-  }
+    : config_(CodecConfig::fromAcceptorConfiguration(accConfig)) {
+}
+
+HTTPDefaultSessionCodecFactory::HTTPDefaultSessionCodecFactory(
+    CodecConfig::Ptr config)
+    : config_(std::move(config)) {
+  CHECK(config_);
 }
 
 std::unique_ptr<HTTPCodec> HTTPDefaultSessionCodecFactory::getCodec(
     const std::string& nextProtocol, TransportDirection direction, bool isTLS) {
-  if (!isTLS && alwaysUseSPDYVersion_) {
+  // Hold the snapshot across construction in case a config swap lands
+  // from a callback mid-way
+  CodecConfig::Ptr config = config_;
+  auto makeHTTP2Codec = [&]() {
+    auto codec = std::make_unique<HTTP2Codec>(direction);
+    if (config->trustedIngress) {
+      // every peer on a trusted listener is authenticated before HTTP is
+      // spoken, so skip the redundant per-byte header scans
+      codec->setStrictValidation(false);
+    }
+    codec->setHeaderIndexingStrategy(config->headerIndexingStrategy);
+    return codec;
+  };
+  if (!isTLS && config->plaintextSpdyVersion) {
     return std::make_unique<SPDYCodec>(direction,
-                                       alwaysUseSPDYVersion_.value(),
-                                       accConfig_.spdyCompressionLevel);
-  } else if (!isTLS && alwaysUseHTTP2_) {
-    return std::make_unique<HTTP2Codec>(direction);
+                                       config->plaintextSpdyVersion.value(),
+                                       config->spdyCompressionLevel);
+  } else if (!isTLS && config->plaintextHTTP2) {
+    return makeHTTP2Codec();
   } else if (nextProtocol.empty() ||
              HTTP1xCodec::supportsNextProtocol(nextProtocol)) {
     auto codec = std::make_unique<HTTP1xCodec>(direction);
     if (!isTLS) {
       codec->setAllowedUpgradeProtocols(
-          accConfig_.allowedPlaintextUpgradeProtocols);
+          config->allowedPlaintextUpgradeProtocols);
     }
     return std::move(codec);
   } else if (auto version = SPDYCodec::getVersion(nextProtocol)) {
     return std::make_unique<SPDYCodec>(
-        direction, *version, accConfig_.spdyCompressionLevel);
+        direction, *version, config->spdyCompressionLevel);
   } else if (nextProtocol == http2::kProtocolString ||
              nextProtocol == http2::kProtocolDraftString ||
              nextProtocol == http2::kProtocolExperimentalString) {
-    return std::make_unique<HTTP2Codec>(direction);
+    return makeHTTP2Codec();
   } else {
     VLOG(2) << "Client requested unrecognized next protocol " << nextProtocol;
   }
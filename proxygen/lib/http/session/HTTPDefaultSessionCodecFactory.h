@@ -9,19 +9,38 @@
  */
 #pragma once
 
+#include <proxygen/lib/http/codec/CodecConfig.h>
 #include <proxygen/lib/http/codec/HTTPCodecFactory.h>
-#include <proxygen/lib/http/codec/SPDYVersion.h>
 #include <proxygen/lib/services/AcceptorConfiguration.h>
 
 namespace proxygen {
 
 class HTTPDefaultSessionCodecFactory : public HTTPCodecFactory {
  public:
+  /**
+   * Snapshots the acceptor configuration at construction; later changes
+   * to accConfig are not observed (use updateCodecConfig for that).
+   */
   explicit HTTPDefaultSessionCodecFactory(
       const AcceptorConfiguration& accConfig);
+
+  explicit HTTPDefaultSessionCodecFactory(CodecConfig::Ptr config);
+
   ~HTTPDefaultSessionCodecFactory() override {
   }
 
+  /**
+   * Swap in a new pre-validated config snapshot; codecs constructed
+   * after this call use it.  Must be called on the factory's thread.
+   */
+  void updateCodecConfig(CodecConfig::Ptr config) {
+    config_ = std::move(config);
+  }
+
+  const CodecConfig::Ptr& getCodecConfig() const {
+    return config_;
+  }
+
   /**
    * Get a codec instance
    */
@@ -30,9 +49,7 @@ class HTTPDefaultSessionCodecFactory : public HTTPCodecFactory {
                                       bool isTLS) override;
 
  protected:
-  const AcceptorConfiguration& accConfig_;
-  folly::Optional<SPDYVersion> alwaysUseSPDYVersion_{};
-  folly::Optional<bool> alwaysUseHTTP2_{};
+  CodecConfig::Ptr config_;
 };
 
 } // namespace proxygen
@@ -47,9 +47,15 @@ void HTTPDownstreamSession::setupOnHeadersComplete(HTTPTransaction* txn,
   // ingress and egress messages have completed (or failed).
   HTTPTransaction::Handler* handler = nullptr;
 
+  // A registered route matcher gets first crack at the request; on a
+  // match the controller's generic dispatch is skipped entirely.
+  handler = routeRequest(msg);
+
   // In the general case, delegate to the handler factory to generate
   // a handler for the transaction.
-  handler = getController()->getRequestHandler(*txn, msg);
+  if (!handler) {
+    handler = getController()->getRequestHandler(*txn, msg);
+  }
   CHECK(handler);
 
   DestructorGuard dg(this);
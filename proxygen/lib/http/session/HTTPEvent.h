@@ -9,9 +9,12 @@
  */
 #pragma once
 
+#include <folly/Memory.h>
 #include <glog/logging.h>
+#include <new>
 #include <proxygen/lib/http/HTTPConstants.h>
 #include <proxygen/lib/http/codec/HTTPCodec.h>
+#include <utility>
 
 namespace proxygen {
 
@@ -152,4 +155,91 @@ class HTTPEvent {
 
 std::ostream& operator<<(std::ostream& os, HTTPEvent::Type e);
 
+/**
+ * FIFO of HTTPEvents backed by a circular buffer of in-place slots.
+ *
+ * A paused transaction can defer thousands of BODY events; queueing them
+ * in a node-per-event container means an allocation per body chunk right
+ * when the session is already under backpressure.  This queue constructs
+ * events directly into a contiguous power-of-two ring and only touches
+ * the allocator when the ring doubles.  Events are strictly move-only;
+ * popping destroys the slot in place.
+ */
+class HTTPEventQueue {
+ public:
+  HTTPEventQueue() {
+  }
+
+  ~HTTPEventQueue() {
+    while (!empty()) {
+      pop();
+    }
+    folly::aligned_free(slots_);
+  }
+
+  HTTPEventQueue(const HTTPEventQueue&) = delete;
+  HTTPEventQueue& operator=(const HTTPEventQueue&) = delete;
+
+  bool empty() const {
+    return size_ == 0;
+  }
+
+  size_t size() const {
+    return size_;
+  }
+
+  template <typename... Args>
+  void emplace(Args&&... args) {
+    if (size_ == capacity_) {
+      grow();
+    }
+    new (slot((head_ + size_) & (capacity_ - 1)))
+        HTTPEvent(std::forward<Args>(args)...);
+    ++size_;
+  }
+
+  HTTPEvent& front() {
+    DCHECK_GT(size_, 0);
+    return *slot(head_);
+  }
+
+  void pop() {
+    DCHECK_GT(size_, 0);
+    slot(head_)->~HTTPEvent();
+    head_ = (head_ + 1) & (capacity_ - 1);
+    --size_;
+  }
+
+ private:
+  // Two cache lines' worth of slots up front; most transactions that
+  // pause at all defer more than a couple of events
+  static const size_t kInitialCapacity = 16;
+
+  HTTPEvent* slot(size_t idx) {
+    return reinterpret_cast<HTTPEvent*>(slots_) + idx;
+  }
+
+  void grow() {
+    size_t newCapacity = capacity_ ? capacity_ * 2 : kInitialCapacity;
+    auto newSlots = folly::aligned_malloc(newCapacity * sizeof(HTTPEvent),
+                                          alignof(HTTPEvent));
+    CHECK(newSlots);
+    for (size_t i = 0; i < size_; ++i) {
+      HTTPEvent* src = slot((head_ + i) & (capacity_ - 1));
+      new (reinterpret_cast<HTTPEvent*>(newSlots) + i)
+          HTTPEvent(std::move(*src));
+      src->~HTTPEvent();
+    }
+    folly::aligned_free(slots_);
+    slots_ = newSlots;
+    capacity_ = newCapacity;
+    head_ = 0;
+  }
+
+  void* slots_{nullptr};
+  size_t capacity_{0};
+  size_t head_{0};
+  size_t size_{0};
+};
+
 } // namespace proxygen
@@ -20,8 +20,12 @@
 #include <proxygen/lib/http/HTTPHeaderSize.h>
 #include <proxygen/lib/http/codec/HTTP2Codec.h>
 #include <proxygen/lib/http/codec/HTTPChecks.h>
+#include <proxygen/lib/http/session/DirectPathResponder.h>
 #include <proxygen/lib/http/session/HTTPSessionController.h>
 #include <proxygen/lib/http/session/HTTPSessionStats.h>
+#include <proxygen/lib/utils/CycleProbe.h>
+#include <proxygen/lib/utils/DeferredDestructionQueue.h>
+#include <proxygen/lib/utils/WorkerBufferPool.h>
 #include <wangle/acceptor/ConnectionManager.h>
 #include <wangle/acceptor/SocketOptions.h>
 
@@ -41,10 +45,27 @@ namespace {
 static const uint32_t kMinReadSize = 1460;
 static const uint32_t kWriteReadyMax = 65536;
 
+// Consecutive sub-MSS reads before the adaptive read window steps back
+// down one doubling
+static const uint8_t kSparseReadsBeforeShrink = 3;
+
 // Lower = higher latency, better prioritization
 // Higher = lower latency, less prioritization
 static const uint32_t kMaxWritesPerLoop = 32;
 
+// Dynamic TLS record sizing: the per-write cap starts at ~2 MSS so the
+// first records decrypt without the client buffering 16KB, doubles on
+// each promptly-completed write, and falls back after a quiet gap
+static const uint32_t kTLSInitialRecordSize = 2 * 1448;
+static const uint32_t kTLSMaxRecordSize = 16 * 1024;
+static const std::chrono::milliseconds kTLSRecordSizeIdleReset{1000};
+
+// Messages with a declared payload size up to this get a single exact
+// write-buffer reservation at header time; see HTTPSession::sendHeaders
+static const uint64_t kMaxExactEgressReservation = 16 * 1024;
+// Room for the serialized headers and frame overhead on top of the payload
+static const uint64_t kEgressReservationOverhead = 1024;
+
 static constexpr folly::StringPiece kClientLabel =
     "EXPORTER HTTP CERTIFICATE client";
 static constexpr folly::StringPiece kServerLabel =
@@ -145,12 +166,20 @@ HTTPSession::HTTPSession(const WheelTimerInstance& timeout,
       writes_(SocketState::UNPAUSED),
       ingressUpgraded_(false),
       resetSocketOnShutdown_(false),
-      inLoopCallback_(false) {
+      inLoopCallback_(false),
+      bulkTeardown_(false) {
   byteEventTracker_ = std::make_shared<ByteEventTracker>(this);
   initialReceiveWindow_ = receiveStreamWindowSize_ = receiveSessionWindowSize_ =
       codec_->getDefaultWindowSize();
 
-  codec_.add<HTTPChecks>();
+  if (codec_->supportsSessionFlowControl()) {
+    // setupCodec() will install a flow control filter; fuse the HTTP
+    // checks into it instead of spending a chain node (and a virtual hop
+    // on every per-frame callback) on a standalone filter
+    fusedChecksFilter_ = true;
+  } else {
+    codec_.add<HTTPChecks>();
+  }
 
   setupCodec();
 
@@ -234,7 +263,8 @@ bool HTTPSession::verifyCertAuthSetting(uint32_t value) {
 
 void HTTPSession::setupCodec() {
   if (!codec_->supportsParallelRequests()) {
-    // until we support upstream pipelining
+    // serial sessions default to one transaction at a time; upstream
+    // pipelining can widen this via HTTPUpstreamSession::enablePipelining
     maxConcurrentIncomingStreams_ = 1;
     maxConcurrentOutgoingStreamsRemote_ = isDownstream() ? 0 : 1;
   }
@@ -258,10 +288,21 @@ void HTTPSession::setupCodec() {
   codec_->generateConnectionPreface(writeBuf_);
 
   if (codec_->supportsSessionFlowControl() && !connFlowControl_) {
-    connFlowControl_ = new FlowControlFilter(*this, writeBuf_, codec_.call());
+    if (fusedChecksFilter_) {
+      connFlowControl_ = new HTTPChecksFilter<FlowControlFilter>(
+          *this, writeBuf_, codec_.call());
+    } else {
+      connFlowControl_ = new FlowControlFilter(*this, writeBuf_, codec_.call());
+    }
     codec_.addFilters(std::unique_ptr<FlowControlFilter>(connFlowControl_));
     // if we really support switching from spdy <-> h2, we need to update
     // existing flow control filter
+    if (connFlowControlAutoTuneMax_ > 0) {
+      connFlowControl_->enableAutoTuning(connFlowControlAutoTuneMax_);
+    }
+    if (windowUpdateBatchQuantum_ > 0) {
+      connFlowControl_->enableUpdateBatching(windowUpdateBatchQuantum_);
+    }
   }
 
   codec_.setCallback(this);
@@ -283,6 +324,10 @@ HTTPSession::~HTTPSession() {
     flowControlTimeout_.cancelTimeout();
   }
 
+  if (pacingTimeout_.isScheduled()) {
+    pacingTimeout_.cancelTimeout();
+  }
+
   runDestroyCallbacks();
 }
 
@@ -339,6 +384,70 @@ void HTTPSession::setFlowControl(size_t initialReceiveWindow,
   }
 }
 
+void HTTPSession::setConnFlowControlAutoTuning(uint32_t maxCapacity) {
+  connFlowControlAutoTuneMax_ = maxCapacity;
+  if (connFlowControl_) {
+    connFlowControl_->enableAutoTuning(maxCapacity);
+  }
+}
+
+void HTTPSession::enableWindowUpdateBatching(uint32_t quantum) {
+  windowUpdateBatchQuantum_ = quantum;
+  if (connFlowControl_ && quantum > 0) {
+    connFlowControl_->enableUpdateBatching(quantum);
+  }
+}
+
+void HTTPSession::setDynamicTLSRecordSizing(bool enabled) {
+  dynamicTLSRecordSizing_ = enabled;
+  tlsRecordSizeLimit_ = enabled ? kTLSInitialRecordSize : 0;
+  lastWriteSuccessTime_ = std::chrono::steady_clock::now();
+}
+
+void HTTPSession::setEgressPacing(uint64_t bytesPerSec, uint64_t burstBytes) {
+  pacingRateBytesPerSec_ = bytesPerSec;
+  pacingBurstBytes_ = burstBytes > 0 ? burstBytes : kWriteReadyMax;
+  pacingTokens_ = pacingBurstBytes_;
+  pacingLastRefill_ = getCurrentTime();
+  if (!egressPacingEnabled() && pacingTimeout_.isScheduled()) {
+    pacingTimeout_.cancelTimeout();
+  }
+}
+
+void HTTPSession::refillPacingTokens() {
+  auto now = getCurrentTime();
+  int64_t elapsedMs = millisecondsBetween(now, pacingLastRefill_).count();
+  int64_t refill = pacingRateBytesPerSec_ * elapsedMs / 1000;
+  if (refill <= 0) {
+    // Sub-millisecond gap; leave the refill marker alone so frequent
+    // calls cannot starve the bucket by rounding every interval to zero
+    return;
+  }
+  pacingLastRefill_ = now;
+  pacingTokens_ = std::min<int64_t>(pacingTokens_ + refill, pacingBurstBytes_);
+}
+
+void HTTPSession::schedulePacingTimeout() {
+  if (pacingTimeout_.isScheduled()) {
+    return;
+  }
+  // Wake once the bucket is positive again, at wheel-tick granularity.
+  // Sessions paced on the same event base share the wheel's ticks, so a
+  // thread full of paced connections doesn't turn into a timer per
+  // session per write.
+  int64_t deficit = 1 - pacingTokens_;
+  int64_t delayMs =
+      (deficit * 1000 + pacingRateBytesPerSec_ - 1) / pacingRateBytesPerSec_;
+  timeout_.scheduleTimeout(
+      &pacingTimeout_,
+      std::chrono::milliseconds(std::max<int64_t>(delayMs, 1)));
+}
+
+void HTTPSession::pacingTimeoutExpired() noexcept {
+  VLOG(5) << *this << " pacing timeout expired";
+  scheduleWrite();
+}
+
 void HTTPSession::setEgressSettings(const SettingsList& inSettings) {
   VLOG_IF(4, started_) << "Must flush egress settings to peer";
   HTTPSettings* settings = codec_->getEgressSettings();
@@ -394,8 +503,10 @@ void HTTPSession::readTimeoutExpired() noexcept {
   setCloseReason(ConnectionCloseReason::TIMEOUT);
   auto controller = getController();
   if (controller) {
-    timeout_.scheduleTimeout(&drainTimeout_,
-                             controller->getGracefulShutdownTimeout());
+    // Shutdown grace periods are long and imprecise by nature; keep them
+    // off the fine wheel.
+    timeout_.scheduleCoarseTimeout(&drainTimeout_,
+                                   controller->getGracefulShutdownTimeout());
   }
   notifyPendingShutdown();
 }
@@ -455,6 +566,23 @@ void HTTPSession::closeWhenIdle() {
   if (!isBusy() && !hasMoreWrites()) {
     // if we're already idle, close now
     dropConnection();
+  } else if (egressDrainSLA_ && byteEventTracker_) {
+    // Not idle yet.  If the peer's delivery rate projects the remaining
+    // egress past the shutdown SLA, don't let it pin this session (and its
+    // buffers) until the coarse drain timeout fires.
+    auto projected = byteEventTracker_->projectedDrainTime();
+    if (projected) {
+      auto elapsed = millisecondsSince(drainStartTime_);
+      auto remaining = (elapsed < *egressDrainSLA_)
+                           ? *egressDrainSLA_ - elapsed
+                           : std::chrono::milliseconds(0);
+      if (*projected > remaining) {
+        VLOG(3) << *this << " dropping slow-draining session: projected "
+                << projected->count() << "ms to flush, " << remaining.count()
+                << "ms left in drain SLA";
+        dropConnection();
+      }
+    }
   }
 }
 
@@ -506,12 +634,45 @@ bool HTTPSession::isDownstream() const {
 
 void HTTPSession::getReadBuffer(void** buf, size_t* bufSize) {
   FOLLY_SCOPED_TRACE_SECTION("HTTPSession - getReadBuffer");
+  if (HTTPSessionBase::getReadBufferPoolEnabled()) {
+    if (!pooledReadBuf_) {
+      pooledReadBuf_ = WorkerBufferPool::get()->allocate();
+    }
+    *buf = pooledReadBuf_->writableTail();
+    *bufSize = pooledReadBuf_->tailroom();
+    return;
+  }
   pair<void*, uint32_t> readSpace =
-      readBuf_.preallocate(kMinReadSize, HTTPSessionBase::maxReadBufferSize_);
+      readBuf_.preallocate(kMinReadSize, getAdaptiveReadSize());
   *buf = readSpace.first;
   *bufSize = readSpace.second;
 }
 
+uint32_t HTTPSession::getAdaptiveReadSize() const {
+  return std::min(kMinReadSize << readSizeShift_,
+                  HTTPSessionBase::maxReadBufferSize_);
+}
+
+void HTTPSession::updateReadSize(size_t readSize) {
+  const uint32_t window = getAdaptiveReadSize();
+  if (readSize >= window) {
+    // Filled the window; the socket likely had more.  Double up.
+    if (window < HTTPSessionBase::maxReadBufferSize_) {
+      readSizeShift_++;
+    }
+    sparseReads_ = 0;
+  } else if (readSize < kMinReadSize) {
+    // A sub-MSS read; a few in a row means this connection is trickling
+    // and doesn't need a large reservation
+    if (++sparseReads_ >= kSparseReadsBeforeShrink && readSizeShift_ > 0) {
+      readSizeShift_--;
+      sparseReads_ = 0;
+    }
+  } else {
+    sparseReads_ = 0;
+  }
+}
+
 void HTTPSession::readDataAvailable(size_t readSize) noexcept {
   FOLLY_SCOPED_TRACE_SECTION(
       "HTTPSession - readDataAvailable", "readSize", readSize);
@@ -519,7 +680,36 @@ void HTTPSession::readDataAvailable(size_t readSize) noexcept {
 
   DestructorGuard dg(this);
   resetTimeout();
+  if (pooledReadBuf_) {
+    // Wrap the newly filled region in a view that refcounts the slab and
+    // append it zero-copy, so the codec parses decrypted bytes in place.
+    // The slab keeps accepting reads until its tailroom is gone; its
+    // storage goes back to the worker pool once the codec releases the
+    // last view into it.
+    const size_t offset = pooledReadBuf_->length();
+    pooledReadBuf_->append(readSize);
+    auto view = pooledReadBuf_->cloneOne();
+    view->trimStart(offset);
+    if (pooledReadBuf_->tailroom() == 0) {
+      pooledReadBuf_.reset();
+    }
+
+    if (infoCallback_) {
+      infoCallback_->onRead(*this, readSize);
+    }
+
+    if (readBuf_.empty()) {
+      // Fused path: the codec parses the decrypt output right here in
+      // the read callback; only an unparsed remainder touches readBuf_
+      processDirectRead(std::move(view));
+    } else {
+      readBuf_.append(std::move(view));
+      processReadData();
+    }
+    return;
+  }
   readBuf_.postallocate(readSize);
+  updateReadSize(readSize);
 
   if (infoCallback_) {
     infoCallback_->onRead(*this, readSize);
@@ -540,17 +730,61 @@ void HTTPSession::readBufferAvailable(std::unique_ptr<IOBuf> readBuf) noexcept {
 
   DestructorGuard dg(this);
   resetTimeout();
-  readBuf_.append(std::move(readBuf));
 
   if (infoCallback_) {
     infoCallback_->onRead(*this, readSize);
   }
 
-  processReadData();
+  if (readBuf_.empty()) {
+    processDirectRead(std::move(readBuf));
+  } else {
+    readBuf_.append(std::move(readBuf));
+    processReadData();
+  }
+}
+
+void HTTPSession::processDirectRead(std::unique_ptr<IOBuf> buf) {
+  FOLLY_SCOPED_TRACE_SECTION("HTTPSession - processDirectRead");
+  PROXYGEN_CYCLE_PROBE(SESSION_READ);
+  DCHECK(readBuf_.empty());
+
+  // Same parse loop as processReadData, run on the buffer the transport
+  // just delivered so a fully parsed read never pays the readBuf_
+  // append/trim round trip.  A queue rather than the raw IOBuf: codecs
+  // parse across the whole chain, so the trim has to be chain-aware too,
+  // which IOBuf::trimStart is not.
+  folly::IOBufQueue directBuf{folly::IOBufQueue::cacheChainLength()};
+  directBuf.append(std::move(buf));
+  while (!ingressError_ && readsUnpaused() && !directBuf.empty()) {
+    // Skip any 0 length buffers before invoking the codec. Since the
+    // queue is not empty, we are guaranteed to find a non-empty buffer.
+    while (directBuf.front()->length() == 0) {
+      directBuf.pop_front();
+    }
+
+    codec_->setParserPaused(false);
+    lastIngressLowPri_ = false;
+    size_t bytesParsed = codec_->onIngress(*directBuf.front());
+    if (bytesParsed == 0) {
+      // The codec needs more input to make progress
+      break;
+    }
+    directBuf.trimStart(bytesParsed);
+    if (!directBuf.empty() && shouldYieldIngress()) {
+      scheduleIngressResume();
+      break;
+    }
+  }
+  if (!directBuf.empty()) {
+    // Partial frame or paused reads: queue the remainder; the next
+    // processReadData pass picks it up where the codec stopped
+    readBuf_.append(directBuf.move());
+  }
 }
 
 void HTTPSession::processReadData() {
   FOLLY_SCOPED_TRACE_SECTION("HTTPSession - processReadData");
+  PROXYGEN_CYCLE_PROBE(SESSION_READ);
 
   // Pass the ingress data through the codec to parse it. The codec
   // will invoke various methods of the HTTPSession as callbacks.
@@ -563,6 +797,7 @@ void HTTPSession::processReadData() {
 
     // We're about to parse, make sure the parser is not paused
     codec_->setParserPaused(false);
+    lastIngressLowPri_ = false;
     size_t bytesParsed = codec_->onIngress(*readBuf_.front());
     if (bytesParsed == 0) {
       // If the codec didn't make any progress with current input, we
@@ -570,6 +805,37 @@ void HTTPSession::processReadData() {
       break;
     }
     readBuf_.trimStart(bytesParsed);
+    if (!readBuf_.empty() && shouldYieldIngress()) {
+      scheduleIngressResume();
+      break;
+    }
+  }
+}
+
+bool HTTPSession::shouldYieldIngress() const {
+  if (ingressYieldBudget_.count() == 0 || !lastIngressLowPri_) {
+    return false;
+  }
+  // getAvgLoopTime is an exponentially-smoothed per-loop busy time in
+  // microseconds; above the budget the loop is running behind and
+  // further bulk-stream parsing would delay control frames and
+  // higher-priority work already queued in this iteration
+  return sock_->getEventBase()->getAvgLoopTime() > ingressYieldBudget_.count();
+}
+
+void HTTPSession::scheduleIngressResume() {
+  VLOG(4) << *this << " yielding ingress parse under loop pressure";
+  if (!ingressResumeCb_.isLoopCallbackScheduled()) {
+    // Not thisIteration: everything already queued in the loop -
+    // including other sessions' control frames - runs first
+    sock_->getEventBase()->runInLoop(&ingressResumeCb_);
+  }
+}
+
+void HTTPSession::resumeDeferredIngress() noexcept {
+  DestructorGuard dg(this);
+  if (!ingressError_ && readsUnpaused() && !readBuf_.empty()) {
+    processReadData();
   }
 }
 
@@ -898,7 +1164,8 @@ void HTTPSession::onHeadersComplete(HTTPCodec::StreamID streamID,
       onError(streamID, ex, true);
       return;
     }
-  } else {
+  } else if (!maybeShedExpiredRequest(txn, *msg) &&
+             !maybeSendDirectResponse(txn, *msg)) {
     setupOnHeadersComplete(txn, msg.get());
   }
 
@@ -919,6 +1186,71 @@ void HTTPSession::onHeadersComplete(HTTPCodec::StreamID streamID,
   txn->onIngressHeadersComplete(std::move(msg));
 }
 
+bool HTTPSession::maybeShedExpiredRequest(HTTPTransaction* txn,
+                                          const HTTPMessage& msg) {
+  const auto& deadlineHeader = HTTPTransaction::getDeadlineHeaderName();
+  if (deadlineHeader.empty() || !isDownstream() || txn->getHandler()) {
+    return false;
+  }
+  const auto& budget = msg.getHeaders().getSingleOrEmpty(deadlineHeader);
+  if (budget.empty()) {
+    return false;
+  }
+  auto budgetMs = folly::tryTo<int64_t>(budget);
+  if (!budgetMs.hasValue()) {
+    return false;
+  }
+  txn->setRequestDeadline(getCurrentTime() +
+                          std::chrono::milliseconds(*budgetMs));
+  if (!txn->isRequestDeadlineExpired()) {
+    return false;
+  }
+  VLOG(4) << *this << " shedding expired request, budget=" << *budgetMs
+          << "ms, streamID=" << txn->getID();
+  // The caller already gave up on this request; answer 504 from the
+  // session instead of burning a handler on work nobody will read.  Like
+  // direct responses, the reply rides the transaction so keep-alive and
+  // flow control accounting stay correct, absorbed by a shared no-op
+  // handler.
+  static DirectPathResponder shedResponder{{}};
+  static const HTTPMessage shedResponse = [] {
+    HTTPMessage resp;
+    resp.setHTTPVersion(1, 1);
+    resp.setStatusCode(504);
+    resp.setStatusMessage("Gateway Timeout");
+    resp.getHeaders().add(HTTP_HEADER_CONTENT_LENGTH, "0");
+    return resp;
+  }();
+  txn->setHandler(&shedResponder);
+  txn->sendHeaders(shedResponse);
+  txn->sendEOM();
+  return true;
+}
+
+bool HTTPSession::maybeSendDirectResponse(HTTPTransaction* txn,
+                                          const HTTPMessage& msg) {
+  if (!directPathResponder_ || !isDownstream() || txn->getHandler()) {
+    return false;
+  }
+  auto canned = directPathResponder_->match(msg);
+  if (!canned) {
+    return false;
+  }
+  VLOG(4) << *this << " direct response for path=" << msg.getPath()
+          << ", streamID=" << txn->getID();
+  // The shared responder absorbs the remaining transaction callbacks
+  // (ingress EOM, detach); nothing is allocated for this stream beyond
+  // the body clone.  Egress rides the transaction so keep-alive and flow
+  // control accounting stay correct.
+  txn->setHandler(directPathResponder_.get());
+  txn->sendHeaders(canned->headers);
+  if (canned->body) {
+    txn->sendBody(canned->body->clone());
+  }
+  txn->sendEOM();
+  return true;
+}
+
 void HTTPSession::onBody(HTTPCodec::StreamID streamID,
                          unique_ptr<IOBuf> chain,
                          uint16_t padding) {
@@ -937,6 +1269,11 @@ void HTTPSession::onBody(HTTPCodec::StreamID streamID,
     return;
   }
 
+  // Feed the ingress yield heuristic: bulk streams are the ones whose
+  // senders deprioritized them below the default weight
+  lastIngressLowPri_ =
+      txn->getPriority().weight < http2::DefaultPriority.weight;
+
   if (HTTPSessionBase::onBodyImpl(std::move(chain), length, padding, txn)) {
     VLOG(4) << *this << " pausing due to read limit exceeded.";
     pauseReads();
@@ -1112,7 +1449,16 @@ void HTTPSession::onError(HTTPCodec::StreamID streamID,
   }
 
   txn->onError(error);
-  if (!codec_->isReusable() && transactions_.empty()) {
+  if (isUpstream() && !codec_->supportsParallelRequests() &&
+      maxConcurrentOutgoingStreamsRemote_ > 1 && !transactions_.empty()) {
+    // A pipelined upstream session cannot resynchronize the response
+    // stream after an ingress error, so the transactions queued behind
+    // the failed one will never get answers.  Close conservatively and
+    // error them out now so their handlers can retry elsewhere.
+    VLOG(4) << *this << "shutdown pipelined session from onError";
+    setCloseReason(ConnectionCloseReason::SESSION_PARSE_ERROR);
+    shutdownTransport(true, true);
+  } else if (!codec_->isReusable() && transactions_.empty()) {
     VLOG(4) << *this << "shutdown from onError";
     setCloseReason(ConnectionCloseReason::SESSION_PARSE_ERROR);
     shutdownTransport(true, true);
@@ -1181,6 +1527,7 @@ void HTTPSession::onGoaway(uint64_t lastGoodStreamID,
   // successfully at the remote end. Upstream transactions are created
   // with odd transaction IDs and downstream transactions with even IDs.
   std::vector<HTTPCodec::StreamID> ids;
+  ids.reserve(transactions_.size());
   auto firstStream = HTTPCodec::NoStream;
 
   for (const auto& txn : transactions_) {
@@ -1580,6 +1927,23 @@ void HTTPSession::sendHeaders(HTTPTransaction* txn,
     }
   }
 
+  // Small messages with a declared size get one exact reservation
+  // covering the serialized headers, framing, and payload, so egress
+  // fills a single tail buffer instead of growing the queue through
+  // doubling as the codec appends.
+  uint64_t declaredSize = 0;
+  const auto& contentLength =
+      headers.getHeaders().getSingleOrEmpty(HTTP_HEADER_CONTENT_LENGTH);
+  if (!contentLength.empty()) {
+    declaredSize = folly::tryTo<uint64_t>(contentLength).value_or(0);
+  } else if (txn->getEgressBodySizeHint()) {
+    declaredSize = *txn->getEgressBodySizeHint();
+  }
+  if (declaredSize > 0 && declaredSize <= kMaxExactEgressReservation) {
+    writeBuf_.preallocate(declaredSize + kEgressReservationOverhead,
+                          declaredSize + kEgressReservationOverhead);
+  }
+
   const bool wasReusable = codec_->isReusable();
   const uint64_t oldOffset = sessionByteOffset();
   auto exAttributes = txn->getExAttributes();
@@ -1764,7 +2128,11 @@ size_t HTTPSession::sendAbort(HTTPTransaction* txn,
     setCloseReason(ConnectionCloseReason::TRANSACTION_ABORT);
   }
 
-  scheduleWrite();
+  // During a bulk teardown the batch driver schedules one write for all
+  // the aborts it provoked
+  if (!bulkTeardown_) {
+    scheduleWrite();
+  }
 
   bool sendTcpRstFallback = !rstStreamSize;
   onEgressMessageFinished(txn, sendTcpRstFallback);
@@ -1843,8 +2211,10 @@ void HTTPSession::decrementTransactionCount(HTTPTransaction* txn,
 // and there is still a pipelinable stream, then it was pipelining
 bool HTTPSession::maybeResumePausedPipelinedTransaction(size_t oldStreamCount,
                                                         uint32_t txnSeqn) {
-  if (!codec_->supportsParallelRequests() && !transactions_.empty() &&
-      getPipelineStreamCount() < oldStreamCount &&
+  // Upstream pipelining never pauses ingress between transactions --
+  // responses are parsed back-to-back -- so this only applies downstream.
+  if (isDownstream() && !codec_->supportsParallelRequests() &&
+      !transactions_.empty() && getPipelineStreamCount() < oldStreamCount &&
       getPipelineStreamCount() == 1) {
     auto txnIt = transactions_.find(txnSeqn + 2);
     CHECK(txnIt != transactions_.end());
@@ -1893,6 +2263,13 @@ void HTTPSession::detach(HTTPTransaction* txn) noexcept {
 
   auto oldStreamCount = getPipelineStreamCount();
   decrementTransactionCount(txn, true, true);
+  // Hand any body bytes the transaction was still buffering to the
+  // end-of-loop drain so the chain's free doesn't interleave with the
+  // parsing and write work still pending this iteration.
+  auto evb = getEventBase();
+  if (evb) {
+    DeferredDestructionQueue::get(*evb).add(txn->moveBufferedEgressBody());
+  }
   transactions_.erase(it);
 
   if (transactions_.empty()) {
@@ -1941,7 +2318,9 @@ void HTTPSession::detach(HTTPTransaction* txn) noexcept {
 size_t HTTPSession::sendWindowUpdate(HTTPTransaction* txn,
                                      uint32_t bytes) noexcept {
   size_t sent = codec_->generateWindowUpdate(writeBuf_, txn->getID(), bytes);
-  if (sent) {
+  // A batched update writes nothing now but still needs the loop callback
+  // to flush it
+  if (sent || (connFlowControl_ && connFlowControl_->hasPendingWindowUpdates())) {
     scheduleWrite();
   }
   return sent;
@@ -1995,6 +2374,9 @@ bool HTTPSession::getCurrentTransportInfo(TransportInfo* tinfo) {
     if (tinfo->tcpinfo.tcpi_rtt > 0) {
       transportInfo_.tcpinfo.tcpi_rtt = tinfo->tcpinfo.tcpi_rtt;
       transportInfo_.rtt = std::chrono::microseconds(tinfo->tcpinfo.tcpi_rtt);
+      if (connFlowControl_) {
+        connFlowControl_->onRttSample(transportInfo_.rtt);
+      }
     }
     transportInfo_.rtx = tinfo->rtx;
 #endif
@@ -2007,16 +2389,56 @@ HTTPTransaction::Transport::Type HTTPSession::getSessionType() const noexcept {
   return getType();
 }
 
+void HTTPSession::applyDeadlineSchedule(
+    HTTP2PriorityQueue::NextEgressResult& results) {
+  auto earliest = results.end();
+  for (auto it = results.begin(); it != results.end(); ++it) {
+    const auto& deadline = it->first->getEgressDeadline();
+    if (deadline && (earliest == results.end() ||
+                     *deadline < *earliest->first->getEgressDeadline())) {
+      earliest = it;
+    }
+  }
+  if (earliest == results.end()) {
+    // Nothing pending has a deadline, keep the priority ordering
+    return;
+  }
+  if (++deadlineLoopCount_ >= kDeadlineStarvationLimit) {
+    // Starvation bound: let the priority ordering through periodically so
+    // bulk streams make progress behind a stream of deadline transactions
+    deadlineLoopCount_ = 0;
+    return;
+  }
+  VLOG(4) << *this << " deadline egress to txnID=" << earliest->first->getID();
+  auto winner = *earliest;
+  winner.second = 1;
+  results.clear();
+  results.emplace_back(winner);
+}
+
 unique_ptr<IOBuf> HTTPSession::getNextToSend(
     bool* cork, bool* timestampTx, bool* timestampAck) {
-  // limit ourselves to one outstanding write at a time (onWriteSuccess calls
-  // scheduleWrite)
-  if (numActiveWrites_ > 0 || writesShutdown()) {
+  // limit outstanding writes; by default one at a time (onWriteSuccess calls
+  // scheduleWrite), more if the session opted into pipelined writes
+  if (numActiveWrites_ >= maxConcurrentOutgoingWrites_ || writesShutdown()) {
     VLOG(4) << "skipping write during this loop, numActiveWrites_="
             << numActiveWrites_ << " writesShutdown()=" << writesShutdown();
     return nullptr;
   }
 
+  if (egressPacingEnabled()) {
+    refillPacingTokens();
+    if (pacingTokens_ <= 0) {
+      // Bucket is dry; the pacing timeout resumes the flush
+      VLOG(4) << *this << " pacing deferred write, tokens=" << pacingTokens_;
+      schedulePacingTimeout();
+      if (sessionStats_) {
+        sessionStats_->recordEgressPacingDeferred();
+      }
+      return nullptr;
+    }
+  }
+
   // We always tack on at least one body packet to the current write buf
   // This ensures that a short HTTPS response will go out in a single SSL record
   while (!txnEgressQueue_.empty()) {
@@ -2032,6 +2454,9 @@ unique_ptr<IOBuf> HTTPSession::getNextToSend(
     txnEgressQueue_.nextEgress(nextEgressResults_,
                                isSpdyCodecProtocol(codec_->getProtocol()));
     CHECK(!nextEgressResults_.empty()); // Queue was non empty, so this must be
+    if (egressScheduler_ == EgressScheduler::DEADLINE) {
+      applyDeadlineSchedule(nextEgressResults_);
+    }
     // The maximum we will send for any transaction in this loop
     uint32_t txnMaxToSend = toSend * nextEgressResults_.front().second;
     if (txnMaxToSend == 0) {
@@ -2064,9 +2489,21 @@ unique_ptr<IOBuf> HTTPSession::getNextToSend(
 
       VLOG(4) << *this << " egressing txnID=" << txnPair.first->getID()
               << " allowed=" << txnAllowed;
+      const auto bufLenBefore = writeBuf_.chainLength();
       txnPair.first->onWriteReady(txnAllowed, txnPair.second);
+      if (txnEgressQueue_.hasEgressBudgets()) {
+        // Charge what the transaction actually serialized, not the grant
+        txnEgressQueue_.consumeEgressBudget(
+            txnPair.first->getID(), writeBuf_.chainLength() - bufLenBefore);
+      }
     }
     nextEgressResults_.clear();
+    if (sessionStats_) {
+      auto throttled = txnEgressQueue_.getAndResetBudgetThrottleCount();
+      if (throttled > 0) {
+        sessionStats_->recordEgressBudgetThrottled(throttled);
+      }
+    }
     // it can be empty because of HTTPTransaction rate limiting.  We should
     // change rate limiting to clearPendingEgress while waiting.
     if (!writeBuf_.empty()) {
@@ -2100,6 +2537,25 @@ unique_ptr<IOBuf> HTTPSession::getNextToSend(
 
   // cork if there are txns with pending egress and room to send them
   *cork = !txnEgressQueue_.empty() && !isConnWindowFull();
+  if (dynamicTLSRecordSizing_ && !*timestampTx && !*timestampAck &&
+      writeBuf_.chainLength() > tlsRecordSizeLimit_) {
+    // Hand the transport at most one record's worth per buffer; the
+    // remainder stays queued and goes out under the then-current limit.
+    // Timestamped chunks go out whole - their flags apply to the byte
+    // event at the end of the buffer
+    *cork = true;
+    return writeBuf_.split(tlsRecordSizeLimit_);
+  }
+  if (egressPacingEnabled() &&
+      writeBuf_.chainLength() > static_cast<uint64_t>(pacingTokens_)) {
+    // Hand the transport only the bucket balance; the pacing timeout
+    // releases the rest once the bucket refills
+    *cork = true;
+    if (sessionStats_) {
+      sessionStats_->recordEgressPacingDeferred();
+    }
+    return writeBuf_.split(pacingTokens_);
+  }
   return writeBuf_.move();
 }
 
@@ -2122,6 +2578,41 @@ void HTTPSession::runLoopCallback() noexcept {
   });
   VLOG(5) << *this << " in loop callback";
 
+  // Drain any WINDOW_UPDATEs batched since the last pass into the egress
+  // buffer ahead of this pass's writes
+  if (connFlowControl_) {
+    connFlowControl_->flushWindowUpdates(writeBuf_);
+  }
+
+  // Coalesce the chunks generated this loop pass into a single chain so
+  // the transport sees one scatter write and one completion callback,
+  // rather than a WriteSegment per chunk.  Chunks carrying timestamp
+  // flags still get their own segment since those flags apply per write.
+  unique_ptr<IOBuf> aggregated;
+  bool aggregatedCork = true;
+  auto flushAggregated = [this, &aggregated, &aggregatedCork] {
+    if (!aggregated) {
+      return;
+    }
+    uint64_t len = aggregated->computeChainDataLength();
+    WriteSegment* segment = new WriteSegment(this, len);
+    segment->setCork(aggregatedCork);
+    pendingWrites_.push_back(*segment);
+    if (!writeTimeout_.isScheduled()) {
+      timeout_.scheduleTimeout(&writeTimeout_);
+    }
+    numActiveWrites_++;
+    VLOG(4) << *this << " writing " << len
+            << ", activeWrites=" << numActiveWrites_
+            << " cork:" << aggregatedCork;
+    bytesScheduled_ += len;
+    sock_->writeChain(segment, std::move(aggregated), segment->getFlags());
+    if (numActiveWrites_ > 0) {
+      updateWriteCount();
+      HTTPSessionBase::notifyEgressBodyBuffered(len, false);
+    }
+  };
+
   for (uint32_t i = 0; i < kMaxWritesPerLoop; ++i) {
     bodyBytesPerWriteBuf_ = 0;
     if (isPrioritySampled()) {
@@ -2139,11 +2630,15 @@ void HTTPSession::runLoopCallback() noexcept {
       break;
     }
     uint64_t len = writeBuf->computeChainDataLength();
+    if (egressPacingEnabled()) {
+      pacingTokens_ -= len;
+    }
     VLOG(11) << *this << " bytes of egress to be written: " << len
              << " cork:" << cork
              << " timestampTx:" << timestampTx
              << " timestampAck:" << timestampAck;
     if (len == 0) {
+      flushAggregated();
       checkForShutdown();
       return;
     }
@@ -2153,6 +2648,20 @@ void HTTPSession::runLoopCallback() noexcept {
                               bodyBytesPerWriteBuf_);
     }
 
+    if (!timestampTx && !timestampAck) {
+      // No per-write flags needed; fold this chunk into the batch
+      aggregatedCork = cork;
+      if (aggregated) {
+        aggregated->prependChain(std::move(writeBuf));
+      } else {
+        aggregated = std::move(writeBuf);
+      }
+      continue;
+    }
+
+    // Timestamped chunks need their own write; sync any batched bytes
+    // ahead of them first
+    flushAggregated();
     WriteSegment* segment = new WriteSegment(this, len);
     segment->setCork(cork);
     segment->setTimestampTX(timestampTx);
@@ -2179,8 +2688,15 @@ void HTTPSession::runLoopCallback() noexcept {
     }
     // writeChain can result in a writeError and trigger the shutdown code path
   }
-  if (numActiveWrites_ == 0 && !writesShutdown() && hasMoreWrites() &&
-      (!connFlowControl_ || connFlowControl_->getAvailableSend())) {
+  flushAggregated();
+  if (egressPacingEnabled() && pacingTokens_ <= 0 && !writesShutdown() &&
+      hasMoreWrites()) {
+    // Rescheduling the loop callback would spin until the bucket goes
+    // positive; wait for the pacing timeout instead
+    schedulePacingTimeout();
+  } else if (numActiveWrites_ < maxConcurrentOutgoingWrites_ &&
+             !writesShutdown() && hasMoreWrites() &&
+             (!connFlowControl_ || connFlowControl_->getAvailableSend())) {
     scheduleWrite();
   }
 
@@ -2346,6 +2862,7 @@ void HTTPSession::shutdownTransportWithReset(ProxygenError errorCode,
     }
     VLOG(4) << *this << " cancel write timer";
     writeTimeout_.cancelTimeout();
+    pacingTimeout_.cancelTimeout();
     resetSocketOnShutdown_ = true;
   }
 
@@ -2412,6 +2929,7 @@ void HTTPSession::drain() {
   if (!draining_) {
     VLOG(4) << *this << " draining";
     draining_ = true;
+    drainStartTime_ = getCurrentTime();
     setCloseReason(ConnectionCloseReason::SHUTDOWN);
 
     if (allTransactionsStarted()) {
@@ -2656,6 +3174,21 @@ void HTTPSession::onWriteSuccess(uint64_t bytesWritten) {
     infoCallback_->onWrite(*this, bytesWritten);
   }
 
+  if (dynamicTLSRecordSizing_) {
+    auto now = std::chrono::steady_clock::now();
+    if (now - lastWriteSuccessTime_ > kTLSRecordSizeIdleReset) {
+      // The connection went quiet; the congestion window has likely
+      // collapsed, so start the next burst with small records again
+      tlsRecordSizeLimit_ = kTLSInitialRecordSize;
+    } else if (tlsRecordSizeLimit_ < kTLSMaxRecordSize) {
+      // Prompt delivery - this is behaving like a bulk transfer, let the
+      // records grow toward the TLS maximum
+      tlsRecordSizeLimit_ =
+          std::min(kTLSMaxRecordSize, tlsRecordSizeLimit_ * 2);
+    }
+    lastWriteSuccessTime_ = now;
+  }
+
   VLOG(5) << "total bytesWritten_: " << bytesWritten_;
 
   // processByteEvents will return true if it has been replaced with another
@@ -2683,7 +3216,7 @@ void HTTPSession::onWriteSuccess(uint64_t bytesWritten) {
     //             in the future we may want to have a pull model
     //             whereby the socket asks us for a given amount of
     //             data to send...
-    if (numActiveWrites_ == 0 && hasMoreWrites()) {
+    if (numActiveWrites_ < maxConcurrentOutgoingWrites_ && hasMoreWrites()) {
       runLoopCallback();
     } else {
       invokeOnAllTransactions(
@@ -2818,6 +3351,7 @@ bool HTTPSession::hasMoreWrites() const {
 void HTTPSession::errorOnAllTransactions(ProxygenError err,
                                          const std::string& errorMsg) {
   std::vector<HTTPCodec::StreamID> ids;
+  ids.reserve(transactions_.size());
   for (const auto& txn : transactions_) {
     ids.push_back(txn.first);
   }
@@ -2828,19 +3362,33 @@ void HTTPSession::errorOnTransactionIds(
     const std::vector<HTTPCodec::StreamID>& ids,
     ProxygenError err,
     const std::string& errorMsg) {
+  if (ids.empty()) {
+    return;
+  }
+  DestructorGuard g(this);
   std::string extraErrorMsg;
   if (!errorMsg.empty()) {
     extraErrorMsg = folly::to<std::string>(". ", errorMsg);
   }
-
+  // Format the invariant part of the message once; only the stream id
+  // differs per transaction.
+  const std::string msgPrefix =
+      folly::to<std::string>(getErrorString(err), " on transaction id: ");
+
+  // Deliver the whole batch of errors in one pass.  Any aborts the
+  // transactions generate in response land in writeBuf_ without a
+  // per-transaction scheduling round trip; a single scheduleWrite() at
+  // the end flushes all of the RST_STREAM/final frames together.
+  const bool wasBulk = bulkTeardown_;
+  bulkTeardown_ = true;
   for (auto id : ids) {
-    HTTPException ex(
-        HTTPException::Direction::INGRESS_AND_EGRESS,
-        folly::to<std::string>(
-            getErrorString(err), " on transaction id: ", id, extraErrorMsg));
+    HTTPException ex(HTTPException::Direction::INGRESS_AND_EGRESS,
+                     folly::to<std::string>(msgPrefix, id, extraErrorMsg));
     ex.setProxygenError(err);
     errorOnTransactionId(id, std::move(ex));
   }
+  bulkTeardown_ = wasBulk;
+  scheduleWrite();
 }
 
 void HTTPSession::errorOnTransactionId(HTTPCodec::StreamID id,
@@ -2966,4 +3514,65 @@ bool HTTPSession::isDetachable(bool checkSocket) const {
          !writeTimeout_.isScheduled() && !drainTimeout_.isScheduled();
 }
 
+void HTTPSession::attachThreadLocals(folly::EventBase* eventBase,
+                                     folly::SSLContextPtr sslContext,
+                                     const WheelTimerInstance& timeout,
+                                     HTTPSessionStats* stats,
+                                     FilterIteratorFn fn,
+                                     HeaderCodec::Stats* headerCodecStats,
+                                     HTTPSessionController* controller) {
+  txnEgressQueue_.attachThreadLocals(timeout);
+  timeout_ = timeout;
+  setController(controller);
+  setSessionStats(stats);
+  if (sock_) {
+    sock_->attachEventBase(eventBase);
+    maybeAttachSSLContext(sslContext);
+  }
+  codec_.foreach (fn);
+  codec_->setHeaderCodecStats(headerCodecStats);
+  resumeReadsImpl();
+  rescheduleLoopCallbacks();
+}
+
+void HTTPSession::maybeAttachSSLContext(folly::SSLContextPtr sslContext) const {
+#ifndef NO_ASYNCSSLSOCKET
+  auto sslSocket = sock_->getUnderlyingTransport<folly::AsyncSSLSocket>();
+  if (sslSocket && sslContext) {
+    sslSocket->attachSSLContext(sslContext);
+  }
+#endif
+}
+
+void HTTPSession::detachThreadLocals(bool detachSSLContext) {
+  CHECK(transactions_.empty());
+  cancelLoopCallbacks();
+  pauseReadsImpl();
+  if (sock_) {
+    if (detachSSLContext) {
+      maybeDetachSSLContext();
+    }
+    sock_->detachEventBase();
+  }
+  txnEgressQueue_.detachThreadLocals();
+  setController(nullptr);
+  setSessionStats(nullptr);
+  // The codec filters *shouldn't* be accessible while the socket is detached,
+  // I hope
+  codec_->setHeaderCodecStats(nullptr);
+  auto cm = getConnectionManager();
+  if (cm) {
+    cm->removeConnection(this);
+  }
+}
+
+void HTTPSession::maybeDetachSSLContext() const {
+#ifndef NO_ASYNCSSLSOCKET
+  auto sslSocket = sock_->getUnderlyingTransport<folly::AsyncSSLSocket>();
+  if (sslSocket) {
+    sslSocket->detachSSLContext();
+  }
+#endif
+}
+
 } // namespace proxygen
@@ -13,6 +13,7 @@
 #include <fizz/record/Types.h>
 #include <folly/IntrusiveList.h>
 #include <folly/Optional.h>
+#include <folly/container/F14Map.h>
 #include <folly/io/IOBufQueue.h>
 #include <folly/io/async/AsyncSSLSocket.h>
 #include <folly/io/async/AsyncSocket.h>
@@ -28,6 +29,7 @@
 #include <proxygen/lib/http/session/HTTPSessionBase.h>
 #include <proxygen/lib/http/session/HTTPTransaction.h>
 #include <proxygen/lib/http/session/SecondaryAuthManagerBase.h>
+#include <proxygen/lib/utils/NodePoolAllocator.h>
 #include <proxygen/lib/utils/WheelTimerInstance.h>
 #include <queue>
 #include <set>
@@ -104,6 +106,29 @@ class HTTPSession
 
   void setByteEventTracker(std::shared_ptr<ByteEventTracker> byteEventTracker);
 
+  /**
+   * Bound how long a draining session may take to flush its buffered
+   * egress.  Once draining, closeWhenIdle compares the ByteEventTracker's
+   * projected drain time against the time left in the SLA and drops the
+   * connection early when a slow peer cannot finish, freeing its buffers
+   * rather than riding out the full drain timeout.
+   */
+  void setEgressDrainSLA(std::chrono::milliseconds sla) {
+    egressDrainSLA_ = sla;
+  }
+
+  /**
+   * Allow up to limit writeChain submissions to be outstanding on the
+   * transport at once instead of the default one-at-a-time.  Keeping the
+   * transport's submission queue fed batches more bytes per event-loop pass;
+   * completion processing (ByteEventTracker) already amortizes across
+   * however many submissions complete in one burst.
+   */
+  void setMaxConcurrentOutgoingWrites(uint32_t limit) {
+    CHECK_GT(limit, 0);
+    maxConcurrentOutgoingWrites_ = limit;
+  }
+
   void setSessionStats(HTTPSessionStats* stats) override;
   /**
    * Set flow control properties on the session.
@@ -120,6 +145,61 @@ class HTTPSession
                       size_t receiveStreamWindowSize,
                       size_t receiveSessionWindowSize) override;
 
+  /**
+   * Enable BDP-based auto-tuning of the per-session receive window.  The
+   * window starts at receiveSessionWindowSize and grows toward maxCapacity
+   * while observed RTT and delivery pacing indicate it is the bottleneck.
+   * Has no effect on codecs without session flow control.
+   */
+  void setConnFlowControlAutoTuning(uint32_t maxCapacity);
+
+  /**
+   * Batch WINDOW_UPDATE frames across a loop pass instead of emitting one
+   * per threshold crossing, merging stream and session level updates into
+   * a single egress flush. Updates go out in multiples of quantum; the
+   * sub-quantum remainder stays pending. Has no effect on codecs without
+   * session flow control.
+   */
+  void enableWindowUpdateBatching(uint32_t quantum);
+
+  /**
+   * Enable dynamic TLS record sizing.  Egress is chunked to a record size
+   * limit that starts at ~2 MSS - so a freshly-loaded client can decrypt
+   * the first bytes without buffering a full 16KB record - and doubles on
+   * each promptly-completed write up to the TLS maximum.  A quiet gap on
+   * the connection resets the limit to the initial size, since the
+   * congestion window has likely collapsed with it.  Only meaningful on
+   * secure transports; the caller checks that.
+   */
+  void setDynamicTLSRecordSizing(bool enabled);
+
+  /**
+   * Enable egress pacing for this session.  By default the write buffer
+   * is flushed as fast as the transport accepts it, producing line-rate
+   * bursts that can overrun shallow-buffered switches.  With pacing,
+   * writes are metered by a token bucket refilled at bytesPerSec with a
+   * bucket depth of burstBytes (0 picks one write's worth).  When the
+   * bucket runs dry the remainder stays queued and a timeout on the
+   * event base's shared timer wheel resumes the flush, so many paced
+   * sessions share wheel ticks instead of each arming its own timer.
+   * A rate of 0 disables pacing.
+   */
+  void setEgressPacing(uint64_t bytesPerSec, uint64_t burstBytes);
+
+  /**
+   * Bound priority inversion in the ingress parse loop under CPU
+   * pressure.  When the event loop is running behind - average loop
+   * time above the budget - and the codec just delivered DATA for a
+   * stream prioritized below the HTTP/2 default weight, the rest of the
+   * read buffer is left unparsed and a loop callback resumes it on the
+   * next loop iteration, after control frames and higher-priority work
+   * already queued in the loop have been serviced.  Zero (the default)
+   * disables yielding.
+   */
+  void setIngressYieldBudget(std::chrono::microseconds budget) {
+    ingressYieldBudget_ = budget;
+  }
+
   /**
    * Set outgoing settings for this session
    */
@@ -266,6 +346,19 @@ class HTTPSession
 
   bool isDetachable(bool checkSocket = true) const override;
 
+  void attachThreadLocals(folly::EventBase* eventBase,
+                          folly::SSLContextPtr sslContext,
+                          const WheelTimerInstance& timeout,
+                          HTTPSessionStats* stats,
+                          FilterIteratorFn fn,
+                          HeaderCodec::Stats* headerCodecStats,
+                          HTTPSessionController* controller) override;
+
+  void detachThreadLocals(bool detachSSLContext = false) override;
+
+  void maybeAttachSSLContext(folly::SSLContextPtr sslContext) const;
+  void maybeDetachSSLContext() const;
+
   /**
    * Returns true if this session is draining. This can happen if drain()
    * is called explicitly, if a GOAWAY frame is received, or during shutdown.
@@ -358,6 +451,14 @@ class HTTPSession
                                               bool* timestampTx,
                                               bool* timestampAck);
 
+  /**
+   * Reshapes the results of nextEgress for the DEADLINE egress scheduler:
+   * the transaction with the earliest deadline takes the entire write.
+   * Every kDeadlineStarvationLimit'th write loop, and when no pending
+   * transaction carries a deadline, the priority ordering is left intact.
+   */
+  void applyDeadlineSchedule(HTTP2PriorityQueue::NextEgressResult& results);
+
   void decrementTransactionCount(HTTPTransaction* txn,
                                  bool ingressEOM,
                                  bool egressEOM);
@@ -388,9 +489,21 @@ class HTTPSession
   // AsyncTransportWrapper::ReadCallback methods
   void getReadBuffer(void** buf, size_t* bufSize) override;
   void readDataAvailable(size_t readSize) noexcept override;
+  // Current adaptive read window, and the post-read feedback that grows
+  // or shrinks it
+  uint32_t getAdaptiveReadSize() const;
+  void updateReadSize(size_t readSize);
   bool isBufferMovable() noexcept override;
   void readBufferAvailable(std::unique_ptr<folly::IOBuf>) noexcept override;
   void processReadData();
+  // Parse a freshly delivered buffer in the read callback itself,
+  // bypassing readBuf_ unless the codec leaves a remainder.  Requires
+  // readBuf_ to be empty so parse order is preserved.
+  void processDirectRead(std::unique_ptr<folly::IOBuf> buf);
+  // Ingress yield budget plumbing (see setIngressYieldBudget)
+  bool shouldYieldIngress() const;
+  void scheduleIngressResume();
+  void resumeDeferredIngress() noexcept;
   void readEOF() noexcept override;
   void readErr(const folly::AsyncSocketException&) noexcept override;
 
@@ -620,7 +733,7 @@ class HTTPSession
 
   /**
    * This function invokes a callback on all transactions. It is safe,
-   * but runs in O(n*log n) and if the callback *adds* transactions,
+   * but runs in O(n) and if the callback *adds* transactions,
    * they will not get the callback.
    */
   template <typename... Args1, typename... Args2>
@@ -646,7 +759,7 @@ class HTTPSession
 
   /**
    * This function invokes a callback on all transactions. It is safe,
-   * but runs in O(n*log n) and if the callback *adds* transactions,
+   * but runs in O(n) and if the callback *adds* transactions,
    * they will not get the callback.
    */
   void errorOnAllTransactions(ProxygenError err, const std::string& errorMsg);
@@ -710,6 +823,9 @@ class HTTPSession
     if (shutdownTransportCb_) {
       shutdownTransportCb_->cancelLoopCallback();
     }
+    if (ingressResumeCb_.isLoopCallbackScheduled()) {
+      ingressResumeCb_.cancelLoopCallback();
+    }
   }
 
   // protected members
@@ -729,13 +845,86 @@ class HTTPSession
   };
   WriteTimeout writeTimeout_;
 
+  // Releases egress held back by pacing (see setEgressPacing) once the
+  // token bucket has gone positive again
+  class PacingTimeout : public folly::HHWheelTimer::Callback {
+   public:
+    explicit PacingTimeout(HTTPSession* session) : session_(session) {
+    }
+
+    void timeoutExpired() noexcept override {
+      session_->pacingTimeoutExpired();
+    }
+
+   private:
+    HTTPSession* session_;
+  };
+  PacingTimeout pacingTimeout_{this};
+
+  // Resumes a parse deferred by the ingress yield budget (see
+  // setIngressYieldBudget) on the next loop iteration
+  class IngressResumeCallback : public folly::EventBase::LoopCallback {
+   public:
+    explicit IngressResumeCallback(HTTPSession* session) : session_(session) {
+    }
+
+    void runLoopCallback() noexcept override {
+      session_->resumeDeferredIngress();
+    }
+
+   private:
+    HTTPSession* session_;
+  };
+  IngressResumeCallback ingressResumeCb_{this};
+
   /** Queue of egress IOBufs */
   folly::IOBufQueue writeBuf_{folly::IOBufQueue::cacheChainLength()};
 
   /** Chain of ingress IOBufs */
   folly::IOBufQueue readBuf_{folly::IOBufQueue::cacheChainLength()};
 
-  std::unordered_map<HTTPCodec::StreamID, HTTPTransaction> transactions_;
+  // See setIngressYieldBudget; zero disables yielding
+  std::chrono::microseconds ingressYieldBudget_{0};
+
+  // Whether the most recent codec_->onIngress call delivered body bytes
+  // for a stream prioritized below the HTTP/2 default weight
+  bool lastIngressLowPri_{false};
+
+  /**
+   * Slab drawn from the worker's buffer pool that transport reads land
+   * in when the read buffer pool is enabled.  It accepts reads until its
+   * tailroom is exhausted; each read's bytes are handed to the parser as
+   * refcounted views into the slab (see readDataAvailable).
+   */
+  std::unique_ptr<folly::IOBuf> pooledReadBuf_;
+
+  /**
+   * Adaptive read sizing state for the non-pooled read path.  The
+   * current window is kMinReadSize << readSizeShift_, capped at
+   * maxReadBufferSize_; it doubles after a read that filled the window
+   * and steps back down after several near-empty reads in a row, so bulk
+   * connections read in large chunks while idle ones stop reserving
+   * oversized blocks.  See getReadBuffer/updateReadSize.
+   */
+  uint8_t readSizeShift_{0};
+  uint8_t sparseReads_{0};
+
+  /**
+   * Live transactions by stream ID.  F14NodeMap probes an open-addressing
+   * index (no per-frame tree or bucket-chain walk) while keeping node
+   * storage, so HTTPTransaction* handed out by findTransaction stay valid
+   * across rehashes.  The ~1KB transaction nodes are recycled through a
+   * per-worker freelist instead of the global allocator, since sessions
+   * create and destroy one per request.
+   */
+  using TransactionMapNode =
+      std::pair<const HTTPCodec::StreamID, HTTPTransaction>;
+  folly::F14NodeMap<HTTPCodec::StreamID,
+                    HTTPTransaction,
+                    folly::f14::DefaultHasher<HTTPCodec::StreamID>,
+                    folly::f14::DefaultKeyEqual<HTTPCodec::StreamID>,
+                    NodePoolAllocator<TransactionMapNode>>
+      transactions_;
 
   /** Count of transactions awaiting input */
   uint32_t liveTransactions_{0};
@@ -750,6 +939,21 @@ class HTTPSession
    */
   unsigned numActiveWrites_{0};
 
+  /**
+   * Maximum number of outstanding transport writes; see
+   * setMaxConcurrentOutgoingWrites.
+   */
+  uint32_t maxConcurrentOutgoingWrites_{1};
+
+  /**
+   * Write loops since the DEADLINE egress scheduler last let the priority
+   * ordering through; bounds how long deadline transactions can starve the
+   * rest of the connection.
+   */
+  uint32_t deadlineLoopCount_{0};
+
+  static const uint32_t kDeadlineStarvationLimit{8};
+
   /**
    * Indicates if the session is waiting for existing transactions to close.
    * Once all transactions close, the session will be deleted.
@@ -762,6 +966,14 @@ class HTTPSession
   bool resetAfterDrainingWrites_ : 1;
   bool ingressError_ : 1;
 
+  /**
+   * Raise the remote limit on outgoing streams for serial codec sessions.
+   * setupCodec() pins it to 1; upstream pipelining uses this to widen it.
+   */
+  void setMaxConcurrentOutgoingStreamsRemote(uint32_t num) {
+    maxConcurrentOutgoingStreamsRemote_ = num;
+  }
+
  private:
   uint32_t getMaxConcurrentOutgoingStreamsRemote() const override {
     return maxConcurrentOutgoingStreamsRemote_;
@@ -806,6 +1018,22 @@ class HTTPSession
   void invalidStream(HTTPCodec::StreamID stream,
                      ErrorCode code = ErrorCode::_SPDY_INVALID_STREAM);
 
+  /**
+   * If a direct-path responder is installed and the ingress request
+   * matches one of its paths, egresses the canned response and installs
+   * the responder as the transaction's handler.  Returns true on a hit,
+   * in which case the controller is never consulted.
+   */
+  bool maybeSendDirectResponse(HTTPTransaction* txn, const HTTPMessage& msg);
+
+  /**
+   * If deadline plumbing is enabled (HTTPTransaction::setDeadlineHeaderName)
+   * and the ingress request carries a time budget, records the deadline on
+   * the transaction.  When the budget is already spent, egresses a 504
+   * without dispatching a handler and returns true.
+   */
+  bool maybeShedExpiredRequest(HTTPTransaction* txn, const HTTPMessage& msg);
+
   http2::PriorityUpdate getMessagePriority(const HTTPMessage* msg);
 
   bool isConnWindowFull() const {
@@ -971,6 +1199,27 @@ class HTTPSession
    */
   FlowControlFilter* connFlowControl_{nullptr};
 
+  /**
+   * True when the HTTP checks are fused into connFlowControl_ rather than
+   * installed as their own filter. Decided at construction; after a codec
+   * upgrade the standalone checks filter is already in the chain, so the
+   * rebuilt flow control filter must stay unfused.
+   */
+  bool fusedChecksFilter_{false};
+
+  /**
+   * Cap for auto-tuning the conn-level receive window; 0 disables it.
+   * Kept here so it survives a codec upgrade, which rebuilds the filter.
+   */
+  uint32_t connFlowControlAutoTuneMax_{0};
+
+  /**
+   * Quantum for batched WINDOW_UPDATE generation; 0 leaves updates
+   * unbatched. Kept here so it survives a codec upgrade, which rebuilds
+   * the filter.
+   */
+  uint32_t windowUpdateBatchQuantum_{0};
+
   /**
    * The received setting for the maximum number of concurrent
    * transactions that this session may create. We may assume the
@@ -1045,11 +1294,44 @@ class HTTPSession
 
   std::shared_ptr<ByteEventTracker> byteEventTracker_{nullptr};
 
+  /**
+   * Shutdown SLA for draining sessions; see setEgressDrainSLA().
+   * drainStartTime_ is stamped when draining begins.
+   */
+  folly::Optional<std::chrono::milliseconds> egressDrainSLA_;
+  TimePoint drainStartTime_;
+
   /**
    * Max number of bytes to egress per session
    */
   uint64_t egressBytesLimit_{0};
 
+  /**
+   * Dynamic TLS record sizing state; see setDynamicTLSRecordSizing().
+   * The limit caps how many bytes each write hands the transport, which
+   * bounds the resulting TLS record sizes.
+   */
+  bool dynamicTLSRecordSizing_{false};
+  uint32_t tlsRecordSizeLimit_{0};
+  std::chrono::steady_clock::time_point lastWriteSuccessTime_;
+
+  /**
+   * Egress pacing state; see setEgressPacing().  The balance can go
+   * negative when an unsplittable chunk exceeds it (e.g. a timestamped
+   * write, or a TLS-record-sized chunk larger than the balance); the
+   * deficit just extends the next release delay.
+   */
+  bool egressPacingEnabled() const {
+    return pacingRateBytesPerSec_ > 0;
+  }
+  void refillPacingTokens();
+  void schedulePacingTimeout();
+  void pacingTimeoutExpired() noexcept;
+  uint64_t pacingRateBytesPerSec_{0};
+  uint64_t pacingBurstBytes_{0};
+  int64_t pacingTokens_{0};
+  TimePoint pacingLastRefill_;
+
   // Flow control settings
   size_t initialReceiveWindow_{0};
   size_t receiveStreamWindowSize_{0};
@@ -1138,6 +1420,9 @@ class HTTPSession
   bool resetSocketOnShutdown_ : 1;
   // indicates a fatal error that prevents further ingress data processing
   bool inLoopCallback_ : 1;
+  // True while errorOnTransactionIds delivers a batch of transaction
+  // errors; sendAbort defers its write scheduling to the end of the batch
+  bool bulkTeardown_ : 1;
   bool inResume_ : 1;
   bool pendingPause_ : 1;
 };
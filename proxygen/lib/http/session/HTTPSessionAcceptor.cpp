@@ -10,8 +10,11 @@
 #include <proxygen/lib/http/session/HTTPSessionAcceptor.h>
 #include <proxygen/lib/http/codec/HTTP1xCodec.h>
 #include <proxygen/lib/http/codec/HTTP2Codec.h>
+#include <proxygen/lib/http/session/DirectPathResponder.h>
 #include <proxygen/lib/http/session/HTTPDefaultSessionCodecFactory.h>
 #include <proxygen/lib/http/session/HTTPDirectResponseHandler.h>
+#include <proxygen/lib/http/stats/ConnectionStats.h>
+#include <proxygen/lib/utils/KTLSUtil.h>
 
 using folly::SocketAddress;
 using std::string;
@@ -19,6 +22,12 @@ using std::unique_ptr;
 
 namespace proxygen {
 
+namespace {
+// A worker must be this much busier than its peer before idle sessions
+// start moving over
+constexpr double kRebalanceLoadRatio = 2.0;
+} // namespace
+
 const SocketAddress HTTPSessionAcceptor::unknownSocketAddress_("0.0.0.0", 0);
 
 HTTPSessionAcceptor::HTTPSessionAcceptor(const AcceptorConfiguration& accConfig)
@@ -35,6 +44,10 @@ HTTPSessionAcceptor::HTTPSessionAcceptor(
     codecFactory_ =
         std::make_shared<HTTPDefaultSessionCodecFactory>(accConfig_);
   }
+  if (!accConfig.directResponsePaths.empty()) {
+    directPathResponder_ =
+        std::make_shared<DirectPathResponder>(accConfig.directResponsePaths);
+  }
 }
 
 HTTPSessionAcceptor::~HTTPSessionAcceptor() {
@@ -61,11 +74,54 @@ void HTTPSessionAcceptor::onNewConnection(
     wangle::SecureTransportType,
     const wangle::TransportInfo& tinfo) {
 
+  const bool shed = shedPolicy_ != ShedPolicy::NONE && isOverloaded();
+  if (shed && shedPolicy_ == ShedPolicy::RESET) {
+    // Cheapest possible rejection: the peer sees an immediate reset and
+    // can retry elsewhere, and this worker spends no further cycles
+    VLOG(3) << "shedding new connection from " << *peerAddress
+            << ", worker overloaded";
+    if (connectionStats_) {
+      connectionStats_->recordConnectionShed();
+    }
+    sock->closeWithReset();
+    return;
+  }
+
+  if (affinityExtractor_ && affinityConsumer_) {
+    // a returning client's ticket can name the pop/worker that served
+    // it last; surface that before the session exists so routing and
+    // cache layers can act on it
+    auto token = affinityExtractor_->getToken(*sock, tinfo);
+    if (token) {
+      affinityConsumer_(*peerAddress, *token);
+    }
+  }
+
+  // we assume if security protocol isn't empty, then it's TLS
+  const bool isTLS = !sock->getSecurityProtocol().empty();
+
+  bool ktlsOffloaded = false;
+  if (accConfig_.enableKTLSOffload && isTLS) {
+    // Must run before any application data moves; see KTLSUtil
+    auto offload = KTLSUtil::tryOffload(std::move(sock));
+    if (!offload.transport) {
+      // the kernel was left partially configured; neither stack can
+      // carry the connection now
+      VLOG(2) << "dropping connection from " << *peerAddress
+              << ", kTLS offload failed mid-configuration";
+      onSessionCreationError(ProxygenError::kErrorSSL);
+      return;
+    }
+    sock = std::move(offload.transport);
+    ktlsOffloaded = offload.offloaded;
+    VLOG_IF(4, ktlsOffloaded)
+        << "kTLS offload enabled for peer " << *peerAddress;
+  }
+
   unique_ptr<HTTPCodec> codec = codecFactory_->getCodec(
       nextProtocol,
       TransportDirection::DOWNSTREAM,
-      // we assume if security protocol isn't empty, then it's TLS
-      !sock->getSecurityProtocol().empty());
+      isTLS);
 
   if (!codec) {
     VLOG(2) << "codecFactory_ failed to provide codec";
@@ -119,11 +175,78 @@ void HTTPSessionAcceptor::onNewConnection(
                           accConfig_.receiveStreamWindowSize,
                           accConfig_.receiveSessionWindowSize);
   if (accConfig_.writeBufferLimit > 0) {
-    session->setWriteBufferLimit(accConfig_.writeBufferLimit);
+    session->setWriteBufferWatermarks(
+        accConfig_.writeBufferLimit,
+        accConfig_.writeBufferResumeLimit > 0
+            ? accConfig_.writeBufferResumeLimit
+            : accConfig_.writeBufferLimit);
+  }
+  // With kTLS the kernel frames records; userspace chunking would only
+  // split writes for no benefit
+  if (accConfig_.enableDynamicTLSRecordSizing && isTLS && !ktlsOffloaded) {
+    session->setDynamicTLSRecordSizing(true);
+  }
+  if (accConfig_.egressPacingBytesPerSec > 0) {
+    session->setEgressPacing(accConfig_.egressPacingBytesPerSec,
+                             accConfig_.egressPacingBurstBytes);
+  }
+  if (qualitySampler_ && !sessionInfoCb_) {
+    // Removal rides on onDestroy, so sessions are only sampled while
+    // this acceptor is their InfoCallback
+    qualitySampler_->addSession(session);
   }
   session->setSessionStats(downstreamSessionStats_);
+  if (directPathResponder_) {
+    session->setDirectPathResponder(directPathResponder_);
+  }
   Acceptor::addConnection(session);
   session->startNow();
+  if (shed) {
+    // ERROR_503: the session came up so the first request can get a
+    // canned 503 (see SimpleController::getRequestHandler), but drain it
+    // right away so the connection doesn't outlive the overload
+    VLOG(3) << "draining shed connection from " << *peerAddress
+            << ", worker overloaded";
+    if (connectionStats_) {
+      connectionStats_->recordConnectionShed();
+    }
+    session->drain();
+  }
+}
+
+void HTTPSessionAcceptor::setAdmissionControl(
+    std::chrono::microseconds loopTimeBudget,
+    size_t maxSessions,
+    ShedPolicy policy,
+    ConnectionStats* stats) {
+  loopTimeBudget_ = loopTimeBudget;
+  maxSessions_ = maxSessions;
+  shedPolicy_ = policy;
+  connectionStats_ = stats;
+}
+
+void HTTPSessionAcceptor::enableConnectionQualitySampling(
+    std::chrono::milliseconds samplePeriod, size_t batchSize) {
+  CHECK(getEventBase()->isInEventBaseThread());
+  if (!qualitySampler_) {
+    qualitySampler_ = std::make_unique<ConnectionQualitySampler>(
+        getEventBase(), samplePeriod, batchSize);
+  }
+  qualitySampler_->start();
+}
+
+bool HTTPSessionAcceptor::isOverloaded() const {
+  if (shedPolicy_ == ShedPolicy::NONE) {
+    return false;
+  }
+  if (maxSessions_ > 0 && getNumConnections() >= maxSessions_) {
+    return true;
+  }
+  if (memoryLedger_ && memoryLedger_->overSoftLimit()) {
+    return true;
+  }
+  return loopTimeBudget_.count() > 0 &&
+         getEventBase()->getAvgLoopTime() > loopTimeBudget_.count();
 }
 
 size_t HTTPSessionAcceptor::dropIdleConnections(size_t num) {
@@ -132,4 +255,74 @@ size_t HTTPSessionAcceptor::dropIdleConnections(size_t num) {
   return downstreamConnectionManager_->dropIdleConnections(num);
 }
 
+size_t HTTPSessionAcceptor::migrateIdleSessions(HTTPSessionAcceptor& target,
+                                                size_t num) {
+  CHECK(getEventBase()->isInEventBaseThread());
+  size_t migrated = 0;
+  auto it = idleSessions_.begin();
+  while (it != idleSessions_.end() && migrated < num) {
+    auto session = *it;
+    if (!session->isDetachable(true /* checkSocket */)) {
+      ++it;
+      continue;
+    }
+    it = idleSessions_.erase(it);
+    if (qualitySampler_) {
+      qualitySampler_->removeSession(session);
+    }
+    session->detachThreadLocals();
+    auto targetAcceptor = &target;
+    target.getEventBase()->runInEventBaseThread(
+        [targetAcceptor, session] { targetAcceptor->adoptSession(session); });
+    migrated++;
+  }
+  VLOG(4) << "migrated " << migrated << " idle sessions";
+  return migrated;
+}
+
+size_t HTTPSessionAcceptor::maybeRebalanceIdleSessions(
+    HTTPSessionAcceptor& target, size_t num) {
+  auto localLoad = getEventBase()->getAvgLoopTime();
+  auto targetLoad = target.getEventBase()->getAvgLoopTime();
+  if (localLoad < kRebalanceLoadRatio * targetLoad) {
+    return 0;
+  }
+  return migrateIdleSessions(target, num);
+}
+
+void HTTPSessionAcceptor::adoptSession(HTTPSessionBase* session) {
+  CHECK(getEventBase()->isInEventBaseThread());
+  // Events from here on are this acceptor's business, including the idle
+  // bookkeeping below
+  session->setInfoCallback(getSessionInfoCallback());
+  session->attachThreadLocals(getEventBase(),
+                              nullptr /* sslContext */,
+                              getTransactionTimeoutSet(),
+                              downstreamSessionStats_,
+                              [](HTTPCodecFilter*) {},
+                              nullptr /* headerCodecStats */,
+                              getController());
+  Acceptor::addConnection(session);
+  idleSessions_.insert(session);
+  if (qualitySampler_ && !sessionInfoCb_) {
+    qualitySampler_->addSession(session);
+  }
+}
+
+void HTTPSessionAcceptor::onActivateConnection(const HTTPSessionBase& session) {
+  idleSessions_.erase(const_cast<HTTPSessionBase*>(&session));
+}
+
+void HTTPSessionAcceptor::onDeactivateConnection(
+    const HTTPSessionBase& session) {
+  idleSessions_.insert(const_cast<HTTPSessionBase*>(&session));
+}
+
+void HTTPSessionAcceptor::onDestroy(const HTTPSessionBase& session) {
+  idleSessions_.erase(const_cast<HTTPSessionBase*>(&session));
+  if (qualitySampler_) {
+    qualitySampler_->removeSession(const_cast<HTTPSessionBase*>(&session));
+  }
+}
+
 } // namespace proxygen
@@ -9,16 +9,25 @@
  */
 #pragma once
 
+#include <chrono>
+#include <unordered_set>
+
+#include <folly/Function.h>
+#include <folly/Optional.h>
 #include <folly/io/async/AsyncSSLSocket.h>
 #include <proxygen/lib/http/codec/HTTPCodecFactory.h>
 #include <proxygen/lib/http/codec/SPDYCodec.h>
 #include <proxygen/lib/http/session/HTTPDownstreamSession.h>
 #include <proxygen/lib/http/session/HTTPErrorPage.h>
 #include <proxygen/lib/http/session/SimpleController.h>
+#include <proxygen/lib/services/ConnectionQualitySampler.h>
 #include <proxygen/lib/services/HTTPAcceptor.h>
+#include <proxygen/lib/services/WorkerMemoryLedger.h>
 
 namespace proxygen {
 
+class ConnectionStats;
+class DirectPathResponder;
 class HTTPSessionStats;
 
 /**
@@ -109,6 +118,139 @@ class HTTPSessionAcceptor
     return accConfig_.HTTP2PrioritiesEnabled;
   }
 
+  /**
+   * Hand up to num idle sessions over to target, which re-attaches them on
+   * its own EventBase. Only sessions with no transactions and a detachable
+   * socket move; busy sessions stay put. Must be invoked on this acceptor's
+   * EventBase, and both acceptors must outlive the migration. Idle sessions
+   * are only tracked while this acceptor is their InfoCallback, i.e. when
+   * no setSessionInfoCallback() override is installed.
+   *
+   * Returns the number of sessions handed off.
+   */
+  virtual size_t migrateIdleSessions(HTTPSessionAcceptor& target, size_t num);
+
+  /**
+   * Migrate as above, but only when this acceptor's event loop is
+   * measurably busier than target's, judged by the smoothed per-loop
+   * busy time of the two EventBases.
+   */
+  virtual size_t maybeRebalanceIdleSessions(HTTPSessionAcceptor& target,
+                                            size_t num);
+
+  /**
+   * Take ownership of a session detached from another acceptor's
+   * EventBase. Invoked on this acceptor's EventBase; the session joins
+   * this acceptor's connection manager, controller and stats.
+   */
+  virtual void adoptSession(HTTPSessionBase* session);
+
+  /**
+   * How an overloaded worker sheds new connections.
+   */
+  enum class ShedPolicy : uint8_t {
+    NONE,      // accept unconditionally
+    RESET,     // close the socket immediately with a TCP reset
+    ERROR_503, // accept, serve 503 to requests, and drain the connection
+  };
+
+  /**
+   * Enable admission control on this acceptor. A worker is considered
+   * overloaded while its smoothed per-loop busy time exceeds
+   * loopTimeBudget or while it carries maxSessions or more live
+   * connections (0 disables the session cap). Overloaded workers shed
+   * new connections per the policy; shedding early at the acceptor
+   * keeps loop lag bounded instead of letting every session time out.
+   *
+   * Shed decisions are counted on stats (may be nullptr).
+   */
+  void setAdmissionControl(std::chrono::microseconds loopTimeBudget,
+                           size_t maxSessions,
+                           ShedPolicy policy,
+                           ConnectionStats* stats = nullptr);
+
+  /**
+   * Attach this worker's memory ledger; while the ledger is over its
+   * soft limit the worker counts as overloaded and sheds per the
+   * configured policy, bounding pool growth before the kernel OOM
+   * killer gets involved.
+   */
+  void setMemoryLedger(std::shared_ptr<const WorkerMemoryLedger> ledger) {
+    memoryLedger_ = std::move(ledger);
+  }
+
+  /**
+   * Enable periodic transport quality sampling (TCP_INFO) for this
+   * acceptor's sessions; see ConnectionQualitySampler for the sampling
+   * model.  Must be called on the acceptor's EventBase after init().
+   * Like the idle-session tracking, sessions are only sampled while
+   * this acceptor is their InfoCallback.
+   */
+  void enableConnectionQualitySampling(
+      std::chrono::milliseconds samplePeriod =
+          ConnectionQualitySampler::kDefaultSamplePeriod,
+      size_t batchSize = ConnectionQualitySampler::kDefaultBatchSize);
+
+  /**
+   * @returns the sampler, or nullptr if sampling was never enabled.
+   *          getSummary() on it is safe from any thread, e.g. for a
+   *          Resources implementation feeding ResourceStats.
+   */
+  ConnectionQualitySampler* getConnectionQualitySampler() const {
+    return qualitySampler_.get();
+  }
+
+  /**
+   * Derives a client affinity token from an accepted transport's
+   * session ticket / PSK state - typically an opaque value the TLS
+   * layer minted into the ticket naming the pop/worker that served the
+   * client last.  Implementations know the deployment's ticket format;
+   * this class only defines where the token surfaces.
+   */
+  class AffinityTokenExtractor {
+   public:
+    virtual ~AffinityTokenExtractor() {
+    }
+    virtual folly::Optional<std::string> getToken(
+        const folly::AsyncTransportWrapper& sock,
+        const wangle::TransportInfo& tinfo) noexcept = 0;
+  };
+
+  using AffinityTokenConsumer = folly::Function<void(
+      const folly::SocketAddress& clientAddr, const std::string& token)>;
+
+  /**
+   * Surface resumption affinity tokens at accept time.  When both an
+   * extractor and a consumer are installed, onNewConnection runs the
+   * extractor on each accepted transport and hands any token to the
+   * consumer before the session is created, so LB layers and
+   * worker-local caches can act on a returning client immediately
+   * (e.g. steer it to the worker whose caches it warmed).
+   */
+  void setAffinityTokenExtractor(
+      std::unique_ptr<AffinityTokenExtractor> extractor) {
+    affinityExtractor_ = std::move(extractor);
+  }
+
+  void setAffinityTokenConsumer(AffinityTokenConsumer consumer) {
+    affinityConsumer_ = std::move(consumer);
+  }
+
+  /**
+   * @returns true while this worker is over its latency budget or
+   *          session cap. Always false if admission control is off.
+   */
+  bool isOverloaded() const;
+
+  /**
+   * Consulted by SimpleController per request: under the ERROR_503
+   * policy, requests arriving while the worker is overloaded are
+   * answered with a canned 503 instead of a real handler.
+   */
+  bool shouldShedRequest() const {
+    return shedPolicy_ == ShedPolicy::ERROR_503 && isOverloaded();
+  }
+
  protected:
   /**
    * This function is invoked when a new session is created to get the
@@ -148,6 +290,14 @@ class HTTPSessionAcceptor
   HTTPSessionAcceptor(const HTTPSessionAcceptor&) = delete;
   HTTPSessionAcceptor& operator=(const HTTPSessionAcceptor&) = delete;
 
+  // HTTPSessionBase::InfoCallback
+  void onActivateConnection(const HTTPSessionBase& session) override;
+  void onDeactivateConnection(const HTTPSessionBase& session) override;
+  void onDestroy(const HTTPSessionBase& session) override;
+
+  /** Sessions with no live transactions, candidates for migration */
+  std::unordered_set<HTTPSessionBase*> idleSessions_;
+
   /** General-case error page generator */
   std::unique_ptr<HTTPErrorPage> defaultErrorPage_;
 
@@ -156,10 +306,29 @@ class HTTPSessionAcceptor
 
   std::shared_ptr<HTTPCodecFactory> codecFactory_{};
 
+  /** Canned responses served without a handler; shared by all sessions */
+  std::shared_ptr<DirectPathResponder> directPathResponder_;
+
   SimpleController simpleController_;
 
   HTTPSession::InfoCallback* sessionInfoCb_{nullptr};
 
+  /** Admission control knobs; NONE means accept unconditionally */
+  std::chrono::microseconds loopTimeBudget_{0};
+  size_t maxSessions_{0};
+  ShedPolicy shedPolicy_{ShedPolicy::NONE};
+  ConnectionStats* connectionStats_{nullptr};
+
+  /** This worker's pool memory ledger; over-limit counts as overloaded */
+  std::shared_ptr<const WorkerMemoryLedger> memoryLedger_;
+
+  /** Transport quality sampler; nullptr until sampling is enabled */
+  std::unique_ptr<ConnectionQualitySampler> qualitySampler_;
+
+  /** Resumption affinity plumbing; both must be set to take effect */
+  std::unique_ptr<AffinityTokenExtractor> affinityExtractor_;
+  AffinityTokenConsumer affinityConsumer_;
+
   /**
    * 0.0.0.0:0, a valid address to use if getsockname() or getpeername() fails
    */
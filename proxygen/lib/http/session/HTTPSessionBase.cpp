@@ -13,6 +13,7 @@
 #include <proxygen/lib/http/session/ByteEventTracker.h>
 #include <proxygen/lib/http/session/HTTPSessionController.h>
 #include <proxygen/lib/http/session/HTTPSessionStats.h>
+#include <proxygen/lib/utils/DeferredDestructionQueue.h>
 
 using folly::SocketAddress;
 using wangle::TransportInfo;
@@ -20,6 +21,7 @@ using wangle::TransportInfo;
 namespace proxygen {
 uint32_t HTTPSessionBase::kDefaultReadBufLimit = 65536;
 uint32_t HTTPSessionBase::maxReadBufferSize_ = 4000;
+bool HTTPSessionBase::readBufferPoolEnabled_ = false;
 uint32_t HTTPSessionBase::egressBodySizeLimit_ = 4096;
 uint32_t HTTPSessionBase::kDefaultWriteBufLimit = 65536;
 
@@ -44,7 +46,8 @@ HTTPSessionBase::HTTPSessionBase(const SocketAddress& localAddr,
       h2PrioritiesEnabled_(true),
       inResume_(false),
       pendingPause_(false),
-      exHeadersEnabled_(false) {
+      exHeadersEnabled_(false),
+      destroyDeferred_(false) {
 
   // If we receive IPv4-mapped IPv6 addresses, convert them to IPv4.
   localAddr_.tryConvertToIPv4();
@@ -53,6 +56,19 @@ HTTPSessionBase::HTTPSessionBase(const SocketAddress& localAddr,
   setController(controller);
 }
 
+void HTTPSessionBase::destroy() {
+  // Park a guard in the per-EventBase drain before the base destroy, so
+  // even once every other guard is gone the destructor itself runs in the
+  // end-of-loop batch together with all the other frees that became due
+  // this iteration.
+  auto evb = getEventBase();
+  if (evb && evb->isInEventBaseThread() && !destroyDeferred_) {
+    destroyDeferred_ = true;
+    DeferredDestructionQueue::get(*evb).add(DestructorGuard(this));
+  }
+  ManagedConnection::destroy();
+}
+
 void HTTPSessionBase::runDestroyCallbacks() {
   if (infoCallback_) {
     infoCallback_->onDestroy(*this);
@@ -139,9 +155,20 @@ void HTTPSessionBase::updateWriteBufSize(int64_t delta) {
   bool wasExceeded = egressLimitExceeded();
   DCHECK(delta >= 0 || uint64_t(-delta) <= pendingWriteSize_);
   pendingWriteSize_ += delta;
+  if (pendingWriteSize_ > writeBufLimit_) {
+    writeBufLimitExceeded_ = true;
+  } else if (pendingWriteSize_ <= writeBufResumeLimit_) {
+    writeBufLimitExceeded_ = false;
+  }
+  // Between the watermarks the previous state sticks (hysteresis)
 
   if (egressLimitExceeded() && !wasExceeded) {
     // Exceeded limit. Pause reading on the incoming stream.
+    if (++numEgressBufferPauses_ > 1 && sessionStats_) {
+      // Any pause after the first is a re-pause of streams we just
+      // resumed
+      sessionStats_->recordEgressWriteBufferFlap();
+    }
     if (inResume_) {
       VLOG(3) << "Pausing txn egress for " << *this << " deferred";
       pendingPause_ = true;
@@ -250,6 +277,18 @@ void HTTPSessionBase::attachToSessionController() {
   }
 }
 
+HTTPTransaction::Handler* HTTPSessionBase::routeRequest(
+    const HTTPMessage* msg) {
+  if (!requestRouter_ || !msg) {
+    return nullptr;
+  }
+  return requestRouter_->matchRoute(
+      msg->getMethodString(),
+      msg->getHeaders().getSingleOrEmpty(HTTP_HEADER_HOST),
+      msg->getPath(),
+      *msg);
+}
+
 void HTTPSessionBase::handleLastByteEvents(ByteEventTracker* byteEventTracker,
                                            HTTPTransaction* txn,
                                            size_t encodedSize,
@@ -19,6 +19,7 @@
 #include <wangle/acceptor/TransportInfo.h>
 
 namespace proxygen {
+class DirectPathResponder;
 class HTTPSessionController;
 class HTTPSessionStats;
 class HTTPTransaction;
@@ -101,6 +102,34 @@ class HTTPSessionBase : public wangle::ManagedConnection {
     }
   };
 
+  /**
+   * Optional pre-resolved routing hook. A registered router sees every
+   * downstream request's (method, authority, path) during
+   * onHeadersComplete, before a handler is attached. Returning a handler
+   * claims the request and skips the controller's generic dispatch;
+   * returning nullptr falls through to
+   * HTTPSessionController::getRequestHandler. Routing this early lets a
+   * matcher pick specialized handlers (and their setup costs) per route.
+   */
+  class RequestRouter {
+   public:
+    virtual ~RequestRouter() {
+    }
+
+    /**
+     * @param method    The request method string.
+     * @param authority The Host header (":authority" for HTTP/2).
+     * @param path      The request path, as parsed from the URL.
+     * @param msg       The full ingress message, for matchers that need
+     *                  more than the route triple.
+     * @return a handler to install on the transaction, or nullptr.
+     */
+    virtual HTTPTransaction::Handler* matchRoute(folly::StringPiece method,
+                                                 folly::StringPiece authority,
+                                                 folly::StringPiece path,
+                                                 const HTTPMessage& msg) = 0;
+  };
+
   HTTPSessionBase(const folly::SocketAddress& localAddr,
                   const folly::SocketAddress& peerAddr,
                   HTTPSessionController* controller,
@@ -121,10 +150,27 @@ class HTTPSessionBase : public wangle::ManagedConnection {
     VLOG(3) << "read buffer limit: " << int(limit / 1000) << "KB";
   }
 
+  static uint32_t getDefaultReadBufferLimit() {
+    return kDefaultReadBufLimit;
+  }
+
   static void setMaxReadBufferSize(uint32_t bytes) {
     maxReadBufferSize_ = bytes;
   }
 
+  /**
+   * Read transport data into fixed-size blocks drawn from the worker's
+   * WorkerBufferPool instead of growing each session's read queue through
+   * the allocator.  Applies to all new reads on all sessions.
+   */
+  static void setReadBufferPoolEnabled(bool enabled) {
+    readBufferPoolEnabled_ = enabled;
+  }
+
+  static bool getReadBufferPoolEnabled() {
+    return readBufferPoolEnabled_;
+  }
+
   /**
    * Set the maximum egress body size for any outbound body bytes per loop,
    * when there are > 1 transactions.
@@ -145,6 +191,14 @@ class HTTPSessionBase : public wangle::ManagedConnection {
     infoCallback_ = callback;
   }
 
+  /**
+   * Install a route matcher consulted ahead of the controller for each
+   * downstream request. The router must outlive the session.
+   */
+  void setRequestRouter(RequestRouter* router) {
+    requestRouter_ = router;
+  }
+
   InfoCallback* getInfoCallback() const {
     return infoCallback_;
   }
@@ -153,6 +207,15 @@ class HTTPSessionBase : public wangle::ManagedConnection {
     sessionStats_ = stats;
   }
 
+  /**
+   * Install the acceptor's shared direct-path responder; requests for its
+   * configured paths are answered by the session without a controller
+   * lookup or a per-request handler.
+   */
+  void setDirectPathResponder(std::shared_ptr<DirectPathResponder> responder) {
+    directPathResponder_ = std::move(responder);
+  }
+
   virtual HTTPTransaction::Transport::Type getType() const noexcept = 0;
 
   virtual folly::AsyncTransportWrapper* getTransport() = 0;
@@ -239,6 +302,25 @@ class HTTPSessionBase : public wangle::ManagedConnection {
    */
   virtual void setEgressSettings(const SettingsList& inSettings) = 0;
 
+  /**
+   * Policy used to divide each write among transactions with pending egress.
+   *
+   * PRIORITY walks the HTTP/2 priority tree (the default).  DEADLINE serves
+   * the transaction with the earliest deadline - see
+   * HTTPTransaction::setEgressDeadline - first, falling back to the priority
+   * ordering periodically and for transactions without deadlines, so bulk
+   * streams sharing the connection cannot be starved.
+   */
+  enum class EgressScheduler : uint8_t { PRIORITY, DEADLINE };
+
+  void setEgressScheduler(EgressScheduler scheduler) {
+    egressScheduler_ = scheduler;
+  }
+
+  EgressScheduler getEgressScheduler() const {
+    return egressScheduler_;
+  }
+
   /**
    * Global flag for turning HTTP2 priorities off
    **/
@@ -274,8 +356,32 @@ class HTTPSessionBase : public wangle::ManagedConnection {
   }
 
   void setWriteBufferLimit(uint32_t limit) {
-    writeBufLimit_ = limit;
-    VLOG(4) << "write buffer limit: " << int(limit / 1000) << "KB";
+    setWriteBufferWatermarks(limit, limit);
+  }
+
+  /**
+   * Set separate pause/resume watermarks for buffered egress.  Egress
+   * pauses once more than high bytes are buffered and resumes only after
+   * the buffer drains to low or below; in between, the previous state
+   * sticks.  The gap keeps sessions from pause/resume flapping -- each
+   * flap re-walks the whole egress queue -- when buffered egress hovers
+   * near a single threshold.  low is clamped to high, and setting the
+   * two equal restores the historical single-threshold behavior.
+   */
+  void setWriteBufferWatermarks(uint32_t high, uint32_t low) {
+    writeBufLimit_ = high;
+    writeBufResumeLimit_ = low > high ? high : low;
+    VLOG(4) << "write buffer watermarks: high=" << int(high / 1000)
+            << "KB low=" << int(writeBufResumeLimit_ / 1000) << "KB";
+  }
+
+  /**
+   * Number of times buffered egress crossed the high watermark and
+   * paused all this session's transactions.  A count that keeps growing
+   * on one session indicates watermark flapping.
+   */
+  uint64_t getNumEgressBufferPauses() const {
+    return numEgressBufferPauses_;
   }
 
   void setReadBufferLimit(uint32_t limit) {
@@ -463,6 +569,13 @@ class HTTPSessionBase : public wangle::ManagedConnection {
    */
   virtual void drain() = 0;
 
+  /**
+   * Defers the final free to the end-of-loop drain of the session's
+   * EventBase (see DeferredDestructionQueue), so sessions torn down during
+   * an iteration destruct in one batch instead of inline at the call site.
+   */
+  void destroy() override;
+
   virtual folly::Optional<const HTTPMessage::HTTPPriority> getHTTPPriority(
       uint8_t level) = 0;
 
@@ -562,16 +675,33 @@ class HTTPSessionBase : public wangle::ManagedConnection {
    */
   void attachToSessionController();
 
+  /**
+   * Ask the registered route matcher for a handler for msg. Returns
+   * nullptr when no router is installed or the router declines the
+   * request, in which case the caller falls back to the controller.
+   */
+  HTTPTransaction::Handler* routeRequest(const HTTPMessage* msg);
+
   HTTPSessionStats* sessionStats_{nullptr};
 
   InfoCallback* infoCallback_{nullptr}; // maybe can move to protected
 
+  // Consulted ahead of the controller for downstream requests; null
+  // unless setRequestRouter() was called
+  RequestRouter* requestRouter_{nullptr};
+
+  // Shared with the acceptor and every session it accepts; null unless
+  // direct response paths are configured
+  std::shared_ptr<DirectPathResponder> directPathResponder_;
+
   wangle::TransportInfo transportInfo_;
 
   HTTPCodecFilterChain codec_;
 
   HTTP2PriorityQueue txnEgressQueue_;
 
+  EgressScheduler egressScheduler_{EgressScheduler::PRIORITY};
+
   /**
    * Maximum number of ingress body bytes that can be buffered across all
    * transactions for this single session/connection.
@@ -583,6 +713,11 @@ class HTTPSessionBase : public wangle::ManagedConnection {
    */
   static uint32_t maxReadBufferSize_;
 
+  /**
+   * Whether sessions read into pooled blocks, see setReadBufferPoolEnabled.
+   */
+  static bool readBufferPoolEnabled_;
+
   /**
    * Maximum number of bytes that can be buffered across all transactions before
    * this session will start applying backpressure to its transactions.
@@ -619,8 +754,10 @@ class HTTPSessionBase : public wangle::ManagedConnection {
    * Returns true iff egress should stop on this session.
    */
   bool egressLimitExceeded() const {
-    // Changed to >
-    return pendingWriteSize_ > writeBufLimit_;
+    // Watermark state maintained by updateWriteBufSize: set above
+    // writeBufLimit_, cleared at or below writeBufResumeLimit_, sticky
+    // in between
+    return writeBufLimitExceeded_;
   }
 
   /**
@@ -662,6 +799,24 @@ class HTTPSessionBase : public wangle::ManagedConnection {
   uint32_t readBufLimit_{kDefaultReadBufLimit};
   uint32_t writeBufLimit_{kDefaultWriteBufLimit};
 
+  /**
+   * Low watermark: once writeBufLimit_ is exceeded, egress stays paused
+   * until pendingWriteSize_ drains to this value or below.
+   */
+  uint32_t writeBufResumeLimit_{kDefaultWriteBufLimit};
+
+  /**
+   * Whether buffered egress is currently considered over limit; carries
+   * the hysteresis state between the two watermarks.
+   */
+  bool writeBufLimitExceeded_{false};
+
+  /**
+   * How many times this session's egress has been paused by the write
+   * buffer watermark.
+   */
+  uint64_t numEgressBufferPauses_{0};
+
   /**
    * Bytes of egress data sent to the socket but not yet written
    * to the network.
@@ -689,6 +844,12 @@ class HTTPSessionBase : public wangle::ManagedConnection {
    * Indicates whether Ex Headers is supported in HTTPSession
    */
   bool exHeadersEnabled_ : 1;
+
+  /**
+   * Set once destroy() has handed a guard to the end-of-loop drain, so
+   * repeated destroy() calls enqueue only one
+   */
+  bool destroyDeferred_ : 1;
 };
 
 } // namespace proxygen
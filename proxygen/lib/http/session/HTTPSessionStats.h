@@ -15,6 +15,8 @@
 
 namespace proxygen {
 
+struct HTTPTransactionTimings;
+
 // This may be retired with a byte events refactor
 class HTTPSessionStats : public TTLBAStats {
  public:
@@ -29,6 +31,30 @@ class HTTPSessionStats : public TTLBAStats {
   }
   virtual void recordTransactionStalled() noexcept = 0;
   virtual void recordSessionStalled() noexcept = 0;
+  virtual void recordEgressBudgetThrottled(uint64_t /*numSubtrees*/) noexcept {
+  }
+  /**
+   * An egress flush was held back or truncated by session pacing (see
+   * HTTPSession::setEgressPacing); the remainder leaves on a later
+   * token-bucket release.
+   */
+  virtual void recordEgressPacingDeferred() noexcept {
+  }
+  /**
+   * The session's write buffer crossed the high watermark again after a
+   * previous pause/resume cycle.  A high rate means sessions are
+   * flapping around the egress watermarks, re-walking their egress
+   * queues each time.
+   */
+  virtual void recordEgressWriteBufferFlap() noexcept {
+  }
+  /**
+   * Per-transaction timing breakdown, recorded once when the
+   * transaction detaches (see HTTPTransactionTimings).
+   */
+  virtual void recordTransactionTimings(
+      const HTTPTransactionTimings& /*timings*/) noexcept {
+  }
 };
 
 } // namespace proxygen
@@ -24,6 +24,7 @@
 #include <proxygen/lib/http/Window.h>
 #include <proxygen/lib/http/codec/HTTPCodec.h>
 #include <proxygen/lib/http/session/ByteEvents.h>
+#include <proxygen/lib/http/session/EgressBodySpill.h>
 #include <proxygen/lib/http/session/HTTP2PriorityQueue.h>
 #include <proxygen/lib/http/session/HTTPEvent.h>
 #include <proxygen/lib/http/session/HTTPTransactionEgressSM.h>
@@ -129,6 +130,60 @@ class TransactionInfo {
   bool isCompleted{false};
 };
 
+/**
+ * Compact per-transaction timing breakdown, accumulated in plain member
+ * fields as the transaction runs - no allocation - and handed to the
+ * handler and the stats sink immediately before detach.  Deltas are
+ * milliseconds from startTime, clamped to a minimum of 1 so a recorded
+ * event is distinguishable from the zero "never happened".
+ */
+struct HTTPTransactionTimings {
+  /** When the transaction was created */
+  TimePoint startTime;
+  /** Ingress headers fully parsed */
+  uint32_t ingressHeadersMs{0};
+  /** Handler attached (request dispatched) */
+  uint32_t handlerAttachedMs{0};
+  /** First egress header byte handed to the transport */
+  uint32_t firstEgressByteMs{0};
+  /** Egress EOM handed to the transport */
+  uint32_t egressEomMs{0};
+  /** Total time egress sat blocked on the send flow control window */
+  uint32_t flowControlBlockedMs{0};
+  /** Total time the transport held this transaction's egress paused */
+  uint32_t egressPausedMs{0};
+};
+
+/**
+ * An end-to-end timeout budget for the transaction, debited as it moves
+ * through its lifecycle phases instead of arming a fresh timer per phase.
+ * The boundaries piggyback on the timing stamps already taken for
+ * HTTPTransactionTimings, so advancing a phase costs no extra clock read,
+ * and the transaction's single wheel entry is re-armed only at phase
+ * transitions.  Per-phase spent time is kept so an expiry can be
+ * attributed to the phase that consumed the budget.
+ */
+struct HTTPTransactionTimeoutBudget {
+  enum Phase : uint8_t {
+    /** Waiting on the peer's request (budget set -> handler attached) */
+    INGRESS = 0,
+    /** Handler working (handler attached -> first egress header byte) */
+    HANDLER = 1,
+    /** Writing the response (first egress header byte -> egress EOM) */
+    EGRESS = 2,
+    NUM_PHASES = 3
+  };
+  /** Budget left; the wheel entry is always armed for exactly this */
+  std::chrono::milliseconds remaining{0};
+  /** Start of the current phase, ms since the transaction started */
+  uint32_t phaseStartMs{0};
+  /** Budget spent in each completed or current phase, in ms */
+  uint32_t phaseSpentMs[NUM_PHASES]{0, 0, 0};
+  Phase phase{INGRESS};
+  bool active{false};
+};
+
+class BodyDigest;
 class HTTPSessionStats;
 class HTTPTransaction;
 class HTTPTransactionHandler {
@@ -148,6 +203,13 @@ class HTTPTransactionHandler {
    */
   virtual void detachTransaction() noexcept = 0;
 
+  /**
+   * The transaction's timing breakdown, delivered immediately before
+   * detachTransaction().  The default ignores it.
+   */
+  virtual void onTimings(const HTTPTransactionTimings& /*timings*/) noexcept {
+  }
+
   /**
    * Called at most once per transaction. This is usually the first
    * ingress callback. It is possible to get a read error before this
@@ -388,7 +450,8 @@ class HTTPTransactionTransportCallback {
 
 class HTTPTransaction
     : public folly::HHWheelTimer::Callback
-    , public folly::DelayedDestructionBase {
+    , public folly::DelayedDestructionBase
+    , private EgressBodySpill::Callback {
  public:
   using Handler = HTTPTransactionHandler;
   using PushHandler = HTTPPushTransactionHandler;
@@ -598,9 +661,37 @@ class HTTPTransaction
     handler_ = handler;
     if (handler_) {
       handler_->setTransaction(this);
+      if (timings_.handlerAttachedMs == 0) {
+        timings_.handlerAttachedMs = timingsDeltaMs();
+        advanceTimeoutBudget(HTTPTransactionTimeoutBudget::HANDLER,
+                             timings_.handlerAttachedMs);
+      }
     }
   }
 
+  const HTTPTransactionTimings& getTimings() const {
+    return timings_;
+  }
+
+  /**
+   * Give the transaction an end-to-end timeout budget.  The budget is
+   * debited at phase boundaries (handler attach, first egress byte,
+   * egress EOM) and the transaction's single wheel entry is armed for
+   * exactly the remaining budget, superseding the idle timeout until the
+   * budget completes at egress EOM.  If the budget runs out the
+   * transaction times out, and getTimeoutBudget() names the phase that
+   * spent it.
+   */
+  void setTimeoutBudget(std::chrono::milliseconds total);
+
+  bool hasTimeoutBudget() const {
+    return timeoutBudget_.active;
+  }
+
+  const HTTPTransactionTimeoutBudget& getTimeoutBudget() const {
+    return timeoutBudget_;
+  }
+
   const Handler* getHandler() const {
     return handler_;
   }
@@ -610,8 +701,8 @@ class HTTPTransaction
   }
 
   std::tuple<uint64_t, uint64_t, double> getPrioritySummary() const {
-    return std::make_tuple(insertDepth_,
-                           currentDepth_,
+    return std::make_tuple(cold_->insertDepth_,
+                           cold_->currentDepth_,
                            egressCalls_ > 0 ? cumulativeRatio_ / egressCalls_
                                             : 0);
   }
@@ -695,6 +786,38 @@ class HTTPTransaction
     return maxDeferredIngress_;
   }
 
+  /**
+   * Opt into ingress body coalescing.  Instead of forwarding every
+   * codec-delivered chunk to the handler, the transaction accumulates
+   * ingress until thresholdBytes have been buffered or maxDelay has
+   * elapsed since the first buffered byte, then delivers one larger
+   * onBody callback.  Flow-control credit is still returned as each
+   * chunk arrives, and any buffered body is flushed ahead of other
+   * handler events (chunk boundaries, trailers, EOM) to preserve
+   * ordering.  A zero threshold disables coalescing and flushes
+   * anything pending.
+   */
+  void setIngressBodyCoalescing(uint32_t thresholdBytes,
+                                std::chrono::milliseconds maxDelay);
+
+  /**
+   * Attach a digest tap to ingress.  Every body chunk is hashed as it
+   * is delivered - ahead of coalescing or splicing, so each byte is
+   * hashed exactly once and never flattened - and the digest is
+   * complete by the time the handler sees EOM, with no second pass over
+   * the assembled body.  Attach before any body arrives, e.g. from
+   * onHeadersComplete.
+   */
+  void setIngressDigest(std::unique_ptr<BodyDigest> digest);
+
+  /**
+   * The attached ingress digest, or nullptr.  Typically read (and
+   * finished) from onEOM.
+   */
+  BodyDigest* getIngressDigest() {
+    return ingressDigest_.get();
+  }
+
   /**
    * Invoked by the session when the ingress headers are complete
    */
@@ -993,6 +1116,65 @@ class HTTPTransaction
    */
   virtual void sendBody(std::unique_ptr<folly::IOBuf> body);
 
+  /**
+   * Callback that produces egress body bytes on demand; see
+   * setBodyGenerator().
+   */
+  class BodyGenerator {
+   public:
+    virtual ~BodyGenerator() {}
+
+    /**
+     * Produce up to maxBytes of body.  Return nullptr when no bytes are
+     * available yet; once more bytes can be produced, call
+     * HTTPTransaction::notifyBodyGenerated() to be polled again.  Set
+     * eom when the returned bytes - possibly none - complete the
+     * message.
+     */
+    virtual std::unique_ptr<folly::IOBuf> generateBody(size_t maxBytes,
+                                                       bool& eom) noexcept = 0;
+  };
+
+  /**
+   * Switch body egress to pull mode.  Instead of the handler buffering
+   * the whole body via sendBody(), the transaction polls the generator
+   * just in time as the transport grants egress window, so buffered
+   * egress stays bounded by roughly one window's worth of bytes.  The
+   * generator must stay valid until it emits EOM (by setting the eom
+   * out-parameter) or is cleared with setBodyGenerator(nullptr); the
+   * handler must not call sendBody()/sendEOM() while a generator is
+   * installed.  Not supported together with sendChunkHeader() chunking.
+   */
+  void setBodyGenerator(BodyGenerator* generator);
+
+  /**
+   * Tell a pull-mode transaction that its generator, having previously
+   * returned no bytes, can produce more now.
+   */
+  void notifyBodyGenerated();
+
+  /**
+   * Let this transaction spill egress body bytes to disk instead of
+   * buffering them all in memory.  Once the deferred egress buffer
+   * would exceed watermark bytes, further sendBody() data goes to an
+   * unlinked temp file in spillDir and is streamed back into the buffer
+   * as the peer drains it, so a fast upstream can finish a large
+   * response to a slow client without holding the body in memory.  The
+   * EOM is held until every spilled byte has been sent.  A spill file
+   * error aborts the transaction.  Not supported together with
+   * sendChunkHeader() chunking or pull-mode egress.
+   *
+   * @param evb The transaction's event base.
+   * @param ioExecutor Executor for the blocking file I/O; must outlive
+   *                   the transaction.
+   * @param spillDir Directory for the temp file.
+   * @param watermark In-memory bytes to buffer before spilling.
+   */
+  void setEgressBodySpill(folly::EventBase* evb,
+                          folly::Executor* ioExecutor,
+                          const std::string& spillDir,
+                          uint64_t watermark);
+
   /**
    * Write any protocol framing required for the subsequent call(s)
    * to sendBody(). This method does not actually write the message out on
@@ -1007,7 +1189,7 @@ class HTTPTransaction
         << __func__ << ": chunking not supported in partially reliable mode.";
     // TODO: move this logic down to session/codec
     if (!transport_.getCodec().supportsParallelRequests()) {
-      chunkHeaders_.emplace_back(Chunk(length));
+      cold_->chunkHeaders_.emplace_back(Chunk(length));
     }
   }
 
@@ -1028,7 +1210,13 @@ class HTTPTransaction
    * Send message trailers to the Transport. This method does
    * not actually write the message out on the wire immediately. All
    * writes happen at the end of the event loop at the earliest.
-   * Note: This method may be called at most once per message.
+   *
+   * Trailers are buffered and only emitted together with the EOM, so
+   * they may be declared any time after sendHeaders - reserving them
+   * for the end of the message - with body sent afterwards.  Calling
+   * this again before sendEOM replaces the pending trailers, letting a
+   * handler reserve the set early and fill in final values (e.g.
+   * grpc-status) once they are known.
    *
    * @param trailers  Message trailers.
    */
@@ -1038,7 +1226,7 @@ class HTTPTransaction
     CHECK(!partiallyReliable_)
         << __func__
         << ": trailers are not supported in partially reliable mode.";
-    trailers_.reset(new HTTPHeaders(trailers));
+    cold_->trailers_.reset(new HTTPHeaders(trailers));
   }
 
   /**
@@ -1084,6 +1272,35 @@ class HTTPTransaction
    */
   virtual void resumeIngress();
 
+  /**
+   * Splice ingress body from this transaction directly into the egress of
+   * `peer`. While spliced, ingress body chains bypass the handler's
+   * onBody() and are appended to the peer's deferred egress queue, with
+   * backpressure: ingress is paused when the peer's egress buffer exceeds
+   * the splice buffer limit and resumed as the peer drains. Everything
+   * else (headers, trailers, EOM, errors) is still delivered to the
+   * handler, so the handler keeps forwarding EOM and owns teardown.
+   *
+   * Call on the ingress-side transaction after the peer's egress headers
+   * have been sent; both transactions must run in the same thread. The
+   * splice is one-directional - splice both transactions onto each other
+   * for a bidirectional tunnel. It is dissolved by unspliceBody() or
+   * automatically when either transaction is destroyed.
+   */
+  void spliceBodyTo(HTTPTransaction* peer);
+
+  /**
+   * Dissolve a body splice involving this transaction in either direction.
+   */
+  void unspliceBody();
+
+  /**
+   * @return true iff ingress body on this transaction is spliced to a peer
+   */
+  bool isBodySpliced() const {
+    return spliceEgressPeer_ != nullptr;
+  }
+
   /**
    * @return true iff ingress processing is paused for the handler
    */
@@ -1122,6 +1339,69 @@ class HTTPTransaction
    */
   void setEgressRateLimit(uint64_t bitsPerSecond);
 
+  /**
+   * Advisory hint for how many body bytes this transaction will egress in
+   * total, set before sendHeaders() by handlers that know the response
+   * size up front.  The session and filters may consult it for buffering
+   * and compression decisions where Content-Length is unavailable;
+   * nothing enforces that the body matches it.
+   */
+  void setEgressBodySizeHint(uint64_t bytes) {
+    cold_->egressBodySizeHint_ = bytes;
+  }
+
+  const folly::Optional<uint64_t>& getEgressBodySizeHint() const {
+    return cold_->egressBodySizeHint_;
+  }
+
+  /**
+   * Set an egress deadline this far in the future.  Only consulted when the
+   * session runs the deadline egress scheduler, where transactions with the
+   * earliest deadlines are served first regardless of priority.
+   */
+  void setEgressDeadline(std::chrono::milliseconds budget) {
+    cold_->egressDeadline_ = getCurrentTime() + budget;
+  }
+
+  void clearEgressDeadline() {
+    cold_->egressDeadline_ = folly::none;
+  }
+
+  const folly::Optional<proxygen::TimePoint>& getEgressDeadline() const {
+    return cold_->egressDeadline_;
+  }
+
+  /**
+   * Absolute end-to-end deadline for the request this transaction
+   * carries.  Distinct from the egress scheduler deadline above: this is
+   * the remaining time budget the load balancer granted for producing a
+   * response at all.  Downstream sessions set it once at ingress from
+   * the configured budget header (see setDeadlineHeaderName) and shed
+   * already-expired requests before handler dispatch; proxies copy it
+   * onto their upstream transaction, where sendHeaders() re-encodes the
+   * remaining budget automatically as a metadata header.
+   */
+  void setRequestDeadline(proxygen::TimePoint when) {
+    cold_->requestDeadline_ = when;
+  }
+
+  const folly::Optional<proxygen::TimePoint>& getRequestDeadline() const {
+    return cold_->requestDeadline_;
+  }
+
+  bool isRequestDeadlineExpired() const {
+    return cold_->requestDeadline_ &&
+           getCurrentTime() >= *cold_->requestDeadline_;
+  }
+
+  /**
+   * Name of the hop-by-hop header carrying the request's remaining time
+   * budget in milliseconds.  Empty (the default) disables deadline
+   * plumbing.  Process-wide; set at startup.
+   */
+  static void setDeadlineHeaderName(const std::string& name);
+  static const std::string& getDeadlineHeaderName();
+
   /**
    * @return true iff egress processing is paused for the handler
    */
@@ -1165,7 +1445,7 @@ class HTTPTransaction
     }
     auto txn = transport_.newPushedTransaction(id_, handler);
     if (txn) {
-      pushedTransactions_.insert(txn->getID());
+      cold_->pushedTransactions_.insert(txn->getID());
     }
     return txn;
   }
@@ -1181,7 +1461,7 @@ class HTTPTransaction
                                             bool unidirectional = false) {
     auto txn = transport_.newExTransaction(handler, id_, unidirectional);
     if (txn) {
-      exTransactions_.insert(txn->getID());
+      cold_->exTransactions_.insert(txn->getID());
     }
     return txn;
   }
@@ -1205,15 +1485,15 @@ class HTTPTransaction
    * True if this transaction is a server push transaction
    */
   bool isPushed() const {
-    return assocStreamId_.has_value();
+    return cold_->assocStreamId_.has_value();
   }
 
   bool isExTransaction() const {
-    return exAttributes_.has_value();
+    return cold_->exAttributes_.has_value();
   }
 
   bool isUnidirectional() const {
-    return isExTransaction() && exAttributes_->unidirectional;
+    return isExTransaction() && cold_->exAttributes_->unidirectional;
   }
 
   /**
@@ -1261,7 +1541,7 @@ class HTTPTransaction
    * Returns the associated transaction ID for pushed transactions, 0 otherwise
    */
   folly::Optional<HTTPCodec::StreamID> getAssocTxnId() const {
-    return assocStreamId_;
+    return cold_->assocStreamId_;
   }
 
   /**
@@ -1269,28 +1549,29 @@ class HTTPTransaction
    * folly::none otherwise
    */
   folly::Optional<HTTPCodec::StreamID> getControlStream() const {
-    return exAttributes_ ? exAttributes_->controlStream : HTTPCodec::NoStream;
+    return cold_->exAttributes_ ? cold_->exAttributes_->controlStream
+                                : HTTPCodec::NoStream;
   }
 
   /*
    * Returns attributes of EX stream (folly::none if not an EX transaction)
    */
   folly::Optional<HTTPCodec::ExAttributes> getExAttributes() const {
-    return exAttributes_;
+    return cold_->exAttributes_;
   }
 
   /**
    * Get a set of server-pushed transactions associated with this transaction.
    */
   const std::set<HTTPCodec::StreamID>& getPushedTransactions() const {
-    return pushedTransactions_;
+    return cold_->pushedTransactions_;
   }
 
   /**
    * Get a set of exTransactions associated with this transaction.
    */
   std::set<HTTPCodec::StreamID> getExTransactions() const {
-    return exTransactions_;
+    return cold_->exTransactions_;
   }
 
   /**
@@ -1298,22 +1579,33 @@ class HTTPTransaction
    * associated with this txn.
    */
   void removePushedTransaction(HTTPCodec::StreamID pushStreamId) {
-    pushedTransactions_.erase(pushStreamId);
+    cold_->pushedTransactions_.erase(pushStreamId);
   }
 
   /**
    * Remove the exTxn ID from the control stream txn.
    */
   void removeExTransaction(HTTPCodec::StreamID exStreamId) {
-    exTransactions_.erase(exStreamId);
+    cold_->exTransactions_.erase(exStreamId);
   }
 
   /**
-   * Schedule or refresh the timeout for this transaction
+   * Schedule or refresh the timeout for this transaction.  Refreshing is
+   * lazy: once the timeout is armed, further activity only stamps
+   * lastActivity_ and the staleness check happens when the wheel fires,
+   * so per-byte refreshes never touch the timing wheel.
    */
   void refreshTimeout() {
+    if (timeoutBudget_.active) {
+      // The wheel entry is armed for the remaining budget; idle activity
+      // neither extends nor shortens it
+      return;
+    }
     if (timer_ && hasIdleTimeout()) {
-      timer_->scheduleTimeout(this, transactionTimeout_.value());
+      lastActivity_ = getCurrentTime();
+      if (!isScheduled()) {
+        timer_->scheduleTimeout(this, transactionTimeout_.value());
+      }
     }
   }
 
@@ -1340,6 +1632,11 @@ class HTTPTransaction
   bool testAndSetFirstHeaderByteSent() {
     bool ret = firstHeaderByteSent_;
     firstHeaderByteSent_ = true;
+    if (!ret) {
+      timings_.firstEgressByteMs = timingsDeltaMs();
+      advanceTimeoutBudget(HTTPTransactionTimeoutBudget::EGRESS,
+                           timings_.firstEgressByteMs);
+    }
     return ret;
   }
 
@@ -1362,8 +1659,23 @@ class HTTPTransaction
   /**
    * Timeout callback for this transaction.  The timer is active
    * until the ingress message is complete or terminated by error.
+   * If activity was stamped since the timeout was armed, the wheel
+   * entry is pushed out by the remaining idle budget instead of firing.
    */
   void timeoutExpired() noexcept override {
+    if (timeoutBudget_.active) {
+      // The entry was armed for exactly the remaining budget, so firing
+      // means the budget is exhausted; the current phase is the culprit
+      transport_.transactionTimeout(this);
+      return;
+    }
+    if (hasIdleTimeout()) {
+      const auto idle = millisecondsSince(lastActivity_);
+      if (idle < transactionTimeout_.value()) {
+        timer_->scheduleTimeout(this, transactionTimeout_.value() - idle);
+        return;
+      }
+    }
     transport_.transactionTimeout(this);
   }
 
@@ -1440,6 +1752,15 @@ class HTTPTransaction
     return deferredEgressBody_.chainLength();
   }
 
+  /**
+   * Hands off any body bytes still buffered for egress so the caller can
+   * batch their release; only called by the transport while this
+   * transaction is detaching.
+   */
+  std::unique_ptr<folly::IOBuf> moveBufferedEgressBody() {
+    return deferredEgressBody_.move();
+  }
+
   void setLastByteFlushedTrackingEnabled(bool enabled) {
     enableLastByteFlushedTracking_ = enabled;
   }
@@ -1514,6 +1835,84 @@ peek(PeekCallback peekCallback);
   HTTPTransaction(const HTTPTransaction&) = delete;
   HTTPTransaction& operator=(const HTTPTransaction&) = delete;
 
+  /**
+   * Hot block: the state touched on essentially every ingress or egress
+   * callback.  Declared first so it occupies the leading cache lines of
+   * the member area - checkHotFieldLayout() pins the block to two lines.
+   * Everything configured once per transaction or consulted only on rare
+   * paths lives further down, or out of line in ColdFields.
+   */
+  const TransportDirection direction_;
+  HTTPCodec::StreamID id_;
+  uint32_t seqNo_;
+  Handler* handler_{nullptr};
+  Transport& transport_;
+  HTTPTransactionEgressSM::State egressState_{
+      HTTPTransactionEgressSM::getNewInstance()};
+  HTTPTransactionIngressSM::State ingressState_{
+      HTTPTransactionIngressSM::getNewInstance()};
+
+  bool ingressPaused_ : 1;
+  bool egressPaused_ : 1;
+  bool flowControlPaused_ : 1;
+  bool handlerEgressPaused_ : 1;
+  bool egressRateLimited_ : 1;
+  bool useFlowControl_ : 1;
+  bool aborted_ : 1;
+  bool deleting_ : 1;
+  bool firstByteSent_ : 1;
+  bool firstHeaderByteSent_ : 1;
+  bool inResume_ : 1;
+  bool inActiveSet_ : 1;
+  bool ingressErrorSeen_ : 1;
+  bool priorityFallback_ : 1;
+  bool headRequest_ : 1;
+  bool enableLastByteFlushedTracking_ : 1;
+  bool enableBodyLastByteDeliveryTracking_ : 1;
+
+  /**
+   * bytes we need to acknowledge to the remote end using a window update
+   */
+  int32_t recvToAck_{0};
+
+  /**
+   * The recv window and associated data. This keeps track of how many
+   * bytes we are allowed to buffer.
+   */
+  Window recvWindow_;
+
+  /**
+   * The send window and associated data. This keeps track of how many
+   * bytes we are allowed to send and have outstanding.
+   */
+  Window sendWindow_;
+
+  // Keeps track for body offset processed so far.
+  // Includes skipped bytes for partially reliable transactions.
+  uint64_t ingressBodyOffset_{0};
+
+  /**
+   * When ingress/egress last touched this transaction; consulted by
+   * timeoutExpired() so refreshTimeout() can skip rescheduling.
+   */
+  proxygen::TimePoint lastActivity_{getCurrentTime()};
+
+  folly::HHWheelTimer* timer_;
+
+  /**
+   * Reference to our priority queue
+   */
+  HTTP2PriorityQueueBase& egressQueue_;
+
+  /**
+   * Handle to our position in the priority queue.
+   */
+  HTTP2PriorityQueueBase::Handle queueHandle_;
+
+  // Compile-time layout check for the hot block above; defined in the
+  // .cpp and never called.
+  static void checkHotFieldLayout();
+
   void onDelayedDestroy(bool delayed) override;
 
   /**
@@ -1563,6 +1962,16 @@ peek(PeekCallback peekCallback);
 
   size_t sendDeferredBody(uint32_t maxEgress);
 
+  /**
+   * Poll the installed BodyGenerator to fill the deferred egress buffer
+   * up to maxBytes.  Re-entrancy from the sendBody/sendEOM calls it
+   * makes is suppressed with inBodyPull_.
+   */
+  size_t pullBodyFromGenerator(uint32_t maxBytes);
+
+  // How many bytes pull-mode egress is willing to buffer right now
+  uint32_t maxPullBytes() const;
+
   bool maybeDelayForRateLimit();
 
   bool isEnqueued() const {
@@ -1575,7 +1984,9 @@ peek(PeekCallback peekCallback);
   }
 
   bool hasPendingEOM() const {
-    return deferredEgressBody_.chainLength() == 0 && isEgressEOMQueued();
+    // The EOM may not pass body bytes still parked in the spill file
+    return deferredEgressBody_.chainLength() == 0 && isEgressEOMQueued() &&
+           (!egressSpill_ || !egressSpill_->hasSpilledData());
   }
 
   bool isExpectingIngress() const;
@@ -1633,11 +2044,43 @@ peek(PeekCallback peekCallback);
 
   RateLimitCallback rateLimitCallback_{*this};
 
+  void flushCoalescedIngress();
+
+  class IngressCoalescingCallback : public folly::HHWheelTimer::Callback {
+   public:
+    explicit IngressCoalescingCallback(HTTPTransaction& txn) : txn_(txn) {
+    }
+
+    void timeoutExpired() noexcept override {
+      txn_.flushCoalescedIngress();
+    }
+    void callbackCanceled() noexcept override {
+      // no op
+    }
+
+   private:
+    HTTPTransaction& txn_;
+  };
+
+  IngressCoalescingCallback ingressCoalescingCallback_{*this};
+
+  /**
+   * Ingress body held back while coalescing, and the body offset of its
+   * first byte.
+   */
+  folly::IOBufQueue coalescedIngress_{folly::IOBufQueue::cacheChainLength()};
+  uint64_t coalescedIngressOffset_{0};
+  uint32_t ingressCoalesceThreshold_{0};
+  std::chrono::milliseconds ingressCoalesceDelay_{0};
+
+  // Ingress digest tap (see setIngressDigest)
+  std::unique_ptr<BodyDigest> ingressDigest_;
+
   /**
    * Queue to hold any events that we receive from the Transaction
    * while the ingress is supposed to be paused.
    */
-  std::unique_ptr<std::queue<HTTPEvent>> deferredIngress_;
+  std::unique_ptr<HTTPEventQueue> deferredIngress_;
 
   uint32_t maxDeferredIngress_{0};
 
@@ -1647,81 +2090,18 @@ peek(PeekCallback peekCallback);
    */
   folly::IOBufQueue deferredEgressBody_{folly::IOBufQueue::cacheChainLength()};
 
-  const TransportDirection direction_;
-  HTTPCodec::StreamID id_;
-  uint32_t seqNo_;
-  Handler* handler_{nullptr};
-  Transport& transport_;
-  HTTPTransactionEgressSM::State egressState_{
-      HTTPTransactionEgressSM::getNewInstance()};
-  HTTPTransactionIngressSM::State ingressState_{
-      HTTPTransactionIngressSM::getNewInstance()};
-
   HTTPSessionStats* stats_{nullptr};
 
   CompressionInfo tableInfo_;
 
-  /**
-   * The recv window and associated data. This keeps track of how many
-   * bytes we are allowed to buffer.
-   */
-  Window recvWindow_;
-
-  /**
-   * The send window and associated data. This keeps track of how many
-   * bytes we are allowed to send and have outstanding.
-   */
-  Window sendWindow_;
-
   TransportCallback* transportCallback_{nullptr};
 
-  /**
-   * Trailers to send, if any.
-   */
-  std::unique_ptr<HTTPHeaders> trailers_;
-
   struct Chunk {
     explicit Chunk(size_t inLength) : length(inLength), headerSent(false) {
     }
     size_t length;
     bool headerSent;
   };
-  std::list<Chunk> chunkHeaders_;
-
-  /**
-   * Reference to our priority queue
-   */
-  HTTP2PriorityQueueBase& egressQueue_;
-
-  /**
-   * Handle to our position in the priority queue.
-   */
-  HTTP2PriorityQueueBase::Handle queueHandle_;
-
-  /**
-   * bytes we need to acknowledge to the remote end using a window update
-   */
-  int32_t recvToAck_{0};
-
-  /**
-   * ID of request transaction (for pushed txns only)
-   */
-  folly::Optional<HTTPCodec::StreamID> assocStreamId_;
-
-  /**
-   * Attributes of http2 Ex_HEADERS
-   */
-  folly::Optional<HTTPCodec::ExAttributes> exAttributes_;
-
-  /**
-   * Set of all push transactions IDs associated with this transaction.
-   */
-  std::set<HTTPCodec::StreamID> pushedTransactions_;
-
-  /**
-   * Set of all exTransaction IDs associated with this transaction.
-   */
-  std::set<HTTPCodec::StreamID> exTransactions_;
 
   /**
    * Priority of this transaction
@@ -1729,18 +2109,9 @@ peek(PeekCallback peekCallback);
   http2::PriorityUpdate priority_;
 
   /**
-   * Information about this transaction's priority.
-   *
-   * insertDepth_ is the depth of this node in the tree when the txn was created
-   * currentDepth_ is the depth of this node in the tree after the last
-   *               onPriorityUpdate. It may not reflect its real position in
-   *               realtime, since after the last onPriorityUpdate, it may get
-   *               reparented as parent transactions complete.
-   * cumulativeRatio_ / egressCalls_ is the average relative weight of this
-   *                                 txn during egress
-   */
-  uint64_t insertDepth_{0};
-  uint64_t currentDepth_{0};
+   * cumulativeRatio_ / egressCalls_ is the average relative weight of
+   * this txn during egress
+   */
   double cumulativeRatio_{0};
   uint64_t egressCalls_{0};
 
@@ -1755,30 +2126,11 @@ peek(PeekCallback peekCallback);
   uint8_t pendingByteEvents_{0};
   folly::Optional<uint64_t> expectedIngressContentLength_;
   folly::Optional<uint64_t> expectedIngressContentLengthRemaining_;
-  folly::Optional<uint64_t> expectedResponseLength_;
   folly::Optional<uint64_t> actualResponseLength_{0};
   // Keeps track of how many bytes the transaction passed to the transport so
   // far.
   uint64_t egressBodyBytesCommittedToTransport_{0};
 
-  bool ingressPaused_ : 1;
-  bool egressPaused_ : 1;
-  bool flowControlPaused_ : 1;
-  bool handlerEgressPaused_ : 1;
-  bool egressRateLimited_ : 1;
-  bool useFlowControl_ : 1;
-  bool aborted_ : 1;
-  bool deleting_ : 1;
-  bool firstByteSent_ : 1;
-  bool firstHeaderByteSent_ : 1;
-  bool inResume_ : 1;
-  bool inActiveSet_ : 1;
-  bool ingressErrorSeen_ : 1;
-  bool priorityFallback_ : 1;
-  bool headRequest_ : 1;
-  bool enableLastByteFlushedTracking_ : 1;
-  bool enableBodyLastByteDeliveryTracking_ : 1;
-
   static uint64_t egressBufferLimit_;
 
   uint64_t egressLimitBytesPerMs_{0};
@@ -1790,8 +2142,6 @@ peek(PeekCallback peekCallback);
    */
   folly::Optional<std::chrono::milliseconds> transactionTimeout_;
 
-  folly::HHWheelTimer* timer_;
-
   class PrioritySample;
   std::unique_ptr<PrioritySample> prioritySample_;
 
@@ -1804,9 +2154,121 @@ peek(PeekCallback peekCallback);
   // headers have been delivered.
   bool egressHeadersDelivered_{false};
 
-  // Keeps track for body offset processed so far.
-  // Includes skipped bytes for partially reliable transactions.
-  uint64_t ingressBodyOffset_{0};
+  // Body splice pairing (see spliceBodyTo). spliceEgressPeer_ is set on
+  // the ingress-side transaction and points at the transaction receiving
+  // the body; spliceIngressSource_ is the reverse link the peer uses for
+  // backpressure and teardown.
+  HTTPTransaction* spliceEgressPeer_{nullptr};
+  HTTPTransaction* spliceIngressSource_{nullptr};
+
+  // Pause spliced ingress when the peer has buffered more than this many
+  // egress body bytes.
+  static const uint64_t kSpliceBufferLimit = 65536;
+
+  // Pull-mode egress (see setBodyGenerator).  Cleared when the generator
+  // emits EOM.
+  BodyGenerator* bodyGenerator_{nullptr};
+  bool inBodyPull_{false};
+
+  // EgressBodySpill::Callback (see setEgressBodySpill)
+  void onSpillReadData(std::unique_ptr<folly::IOBuf> data) noexcept override;
+  void onSpillError(const std::string& msg) noexcept override;
+
+  // Milliseconds since the transaction started, clamped to >= 1 so a
+  // recorded timing is distinguishable from the zero "never happened"
+  uint32_t timingsDeltaMs() const {
+    const auto ms = millisecondsSince(timings_.startTime).count();
+    return ms < 1 ? 1 : folly::to<uint32_t>(ms);
+  }
+
+  // Close any open blocked/paused interval before the timings are
+  // reported at detach
+  void finalizeTimings();
+
+  // Charge the current budget phase up to nowDeltaMs and re-arm the
+  // wheel entry for what is left.  nowDeltaMs is a timing stamp the
+  // caller just took, so boundaries cost no extra clock read.
+  void advanceTimeoutBudget(HTTPTransactionTimeoutBudget::Phase next,
+                            uint32_t nowDeltaMs);
+
+  // Final debit at egress EOM; deactivates the budget and hands the
+  // wheel entry back to the idle timeout scheme
+  void completeTimeoutBudget(uint32_t nowDeltaMs);
+
+  HTTPTransactionTimings timings_;
+  HTTPTransactionTimeoutBudget timeoutBudget_;
+  // Interval starts for the two accumulated durations
+  TimePoint flowControlBlockedStart_;
+  TimePoint egressPausedStart_;
+
+  // Disk overflow for deferredEgressBody_ (see setEgressBodySpill)
+  std::unique_ptr<EgressBodySpill> egressSpill_;
+
+  /**
+   * Cold block: fields only touched at setup, teardown, or by a
+   * rarely-exercised feature (push, ex-streams, chunked encoding,
+   * trailers, deadlines, priority introspection).  Held out of line so
+   * they do not dilute the hot cache lines at the top of the class; the
+   * blocks come from the per-thread node pool since one is allocated
+   * for every transaction.
+   */
+  struct ColdFields {
+    static ColdFields* create();
+    void destroy();
+
+    /**
+     * Trailers to send, if any.
+     */
+    std::unique_ptr<HTTPHeaders> trailers_;
+
+    std::list<Chunk> chunkHeaders_;
+
+    /**
+     * ID of request transaction (for pushed txns only)
+     */
+    folly::Optional<HTTPCodec::StreamID> assocStreamId_;
+
+    /**
+     * Attributes of http2 Ex_HEADERS
+     */
+    folly::Optional<HTTPCodec::ExAttributes> exAttributes_;
+
+    /**
+     * Set of all push transactions IDs associated with this transaction.
+     */
+    std::set<HTTPCodec::StreamID> pushedTransactions_;
+
+    /**
+     * Set of all exTransaction IDs associated with this transaction.
+     */
+    std::set<HTTPCodec::StreamID> exTransactions_;
+
+    /**
+     * Depth of this node in the priority tree when the txn was created,
+     * and after the last onPriorityUpdate.  The latter may not reflect
+     * its real position in realtime, since it may get reparented as
+     * parent transactions complete.
+     */
+    uint64_t insertDepth_{0};
+    uint64_t currentDepth_{0};
+
+    folly::Optional<uint64_t> expectedResponseLength_;
+
+    folly::Optional<proxygen::TimePoint> egressDeadline_;
+
+    folly::Optional<proxygen::TimePoint> requestDeadline_;
+
+    folly::Optional<uint64_t> egressBodySizeHint_;
+  };
+
+  struct ColdFieldsDeleter {
+    void operator()(ColdFields* fields) const {
+      fields->destroy();
+    }
+  };
+
+  const std::unique_ptr<ColdFields, ColdFieldsDeleter> cold_{
+      ColdFields::create()};
 };
 
 /**
@@ -9,61 +9,72 @@
  */
 #include <proxygen/lib/http/session/HTTPTransactionEgressSM.h>
 
-#include <folly/Indestructible.h>
-
 namespace proxygen {
 
+namespace {
+
+using State = HTTPTransactionEgressSMData::State;
+using Event = HTTPTransactionEgressSMData::Event;
+using Table = TransitionTable<State,
+                              Event,
+                              static_cast<size_t>(State::NumStates),
+                              static_cast<size_t>(Event::NumEvents)>;
+
+//             +--> ChunkHeaderSent -> ChunkBodySent
+//             |      ^                    v
+//             |      |   ChunkTerminatorSent -> TrailersSent
+//             |      |__________|        |          |
+//             |                          |          v
+// Start -> HeadersSent                   +----> EOMQueued --> SendingDone
+//             |                                     ^
+//             +------------> RegularBodySent -------+
+//
+// TrailersSent additionally self-loops on sendBody and sendTrailers:
+// trailers may be declared as soon as headers are sent - reserving them
+// for the end of the message - then replaced and interleaved with more
+// body until EOM, since they are only flushed with the EOM.
+
+constexpr Table::Transition kTransitions[] = {
+    {{State::Start, Event::sendHeaders}, State::HeadersSent},
+
+    // For HTTP sending 100 response, then a regular response
+    {{State::HeadersSent, Event::sendHeaders}, State::HeadersSent},
+
+    {{State::HeadersSent, Event::sendBody}, State::RegularBodySent},
+    {{State::HeadersSent, Event::sendTrailers}, State::TrailersSent},
+    {{State::HeadersSent, Event::sendChunkHeader}, State::ChunkHeaderSent},
+    {{State::HeadersSent, Event::sendEOM}, State::EOMQueued},
+
+    {{State::RegularBodySent, Event::sendBody}, State::RegularBodySent},
+    {{State::RegularBodySent, Event::sendTrailers}, State::TrailersSent},
+    {{State::RegularBodySent, Event::sendEOM}, State::EOMQueued},
+
+    {{State::ChunkHeaderSent, Event::sendBody}, State::ChunkBodySent},
+
+    {{State::ChunkBodySent, Event::sendBody}, State::ChunkBodySent},
+    {{State::ChunkBodySent, Event::sendChunkTerminator},
+     State::ChunkTerminatorSent},
+
+    {{State::ChunkTerminatorSent, Event::sendChunkHeader},
+     State::ChunkHeaderSent},
+    {{State::ChunkTerminatorSent, Event::sendTrailers}, State::TrailersSent},
+    {{State::ChunkTerminatorSent, Event::sendEOM}, State::EOMQueued},
+
+    {{State::TrailersSent, Event::sendBody}, State::TrailersSent},
+    {{State::TrailersSent, Event::sendTrailers}, State::TrailersSent},
+    {{State::TrailersSent, Event::sendEOM}, State::EOMQueued},
+
+    {{State::EOMQueued, Event::eomFlushed}, State::SendingDone}};
+
+// The whole matrix lives in .rodata; no static initializer runs
+constexpr Table kTransitionTable{kTransitions};
+
+} // namespace
+
 std::pair<HTTPTransactionEgressSMData::State, bool>
 HTTPTransactionEgressSMData::find(HTTPTransactionEgressSMData::State s,
                                   HTTPTransactionEgressSMData::Event e) {
-  using State = HTTPTransactionEgressSMData::State;
-  using Event = HTTPTransactionEgressSMData::Event;
-
-  //             +--> ChunkHeaderSent -> ChunkBodySent
-  //             |      ^                    v
-  //             |      |   ChunkTerminatorSent -> TrailersSent
-  //             |      |__________|        |          |
-  //             |                          |          v
-  // Start -> HeadersSent                   +----> EOMQueued --> SendingDone
-  //             |                                     ^
-  //             +------------> RegularBodySent -------+
-
-  static const folly::Indestructible<TransitionTable<State, Event>> transitions{
-      TransitionTable<State, Event>{
-          static_cast<uint64_t>(State::NumStates),
-          static_cast<uint64_t>(Event::NumEvents),
-          {{{State::Start, Event::sendHeaders}, State::HeadersSent},
-
-           // For HTTP sending 100 response, then a regular response
-           {{State::HeadersSent, Event::sendHeaders}, State::HeadersSent},
-
-           {{State::HeadersSent, Event::sendBody}, State::RegularBodySent},
-           {{State::HeadersSent, Event::sendTrailers}, State::TrailersSent},
-           {{State::HeadersSent, Event::sendChunkHeader},
-            State::ChunkHeaderSent},
-           {{State::HeadersSent, Event::sendEOM}, State::EOMQueued},
-
-           {{State::RegularBodySent, Event::sendBody}, State::RegularBodySent},
-           {{State::RegularBodySent, Event::sendTrailers}, State::TrailersSent},
-           {{State::RegularBodySent, Event::sendEOM}, State::EOMQueued},
-
-           {{State::ChunkHeaderSent, Event::sendBody}, State::ChunkBodySent},
-
-           {{State::ChunkBodySent, Event::sendBody}, State::ChunkBodySent},
-           {{State::ChunkBodySent, Event::sendChunkTerminator},
-            State::ChunkTerminatorSent},
-
-           {{State::ChunkTerminatorSent, Event::sendChunkHeader},
-            State::ChunkHeaderSent},
-           {{State::ChunkTerminatorSent, Event::sendTrailers},
-            State::TrailersSent},
-           {{State::ChunkTerminatorSent, Event::sendEOM}, State::EOMQueued},
-
-           {{State::TrailersSent, Event::sendEOM}, State::EOMQueued},
-
-           {{State::EOMQueued, Event::eomFlushed}, State::SendingDone}}}};
-
-  return transitions->find(s, e);
+  return kTransitionTable.find(s, e);
 }
 
 std::ostream& operator<<(std::ostream& os,
@@ -9,10 +9,17 @@
  */
 #include <proxygen/lib/http/session/HTTPTransactionIngressSM.h>
 
-#include <folly/Indestructible.h>
-
 namespace proxygen {
 
+namespace {
+
+using State = HTTPTransactionIngressSMData::State;
+using Event = HTTPTransactionIngressSMData::Event;
+using Table = TransitionTable<State,
+                              Event,
+                              static_cast<size_t>(State::NumStates),
+                              static_cast<size_t>(Event::NumEvents)>;
+
 //             +--> ChunkHeaderReceived -> ChunkBodyReceived
 //             |        ^                     v
 //             |        |          ChunkCompleted -> TrailersReceived
@@ -24,17 +31,8 @@ namespace proxygen {
 //             |                                   |
 //             +---------> UpgradeComplete --------+
 
-std::pair<HTTPTransactionIngressSMData::State, bool>
-HTTPTransactionIngressSMData::find(HTTPTransactionIngressSMData::State s,
-                                   HTTPTransactionIngressSMData::Event e) {
-  using State = HTTPTransactionIngressSMData::State;
-  using Event = HTTPTransactionIngressSMData::Event;
-
-  static const folly::Indestructible<TransitionTable<State, Event>> transitions{
-    TransitionTable<State, Event>{
-      static_cast<uint64_t>(State::NumStates),
-      static_cast<uint64_t>(Event::NumEvents),
-    {{{State::Start, Event::onHeaders}, State::HeadersReceived},
+constexpr Table::Transition kTransitions[] = {
+    {{State::Start, Event::onHeaders}, State::HeadersReceived},
 
     // For HTTP receiving 100 response, then a regular response
     {{State::HeadersReceived, Event::onHeaders}, State::HeadersReceived},
@@ -70,11 +68,17 @@ HTTPTransactionIngressSMData::find(HTTPTransactionIngressSMData::State s,
     {{State::UpgradeComplete, Event::onBody}, State::UpgradeComplete},
     {{State::UpgradeComplete, Event::onEOM}, State::EOMQueued},
 
-    {{State::EOMQueued, Event::eomFlushed}, State::ReceivingDone}
-    }}
-  };
+    {{State::EOMQueued, Event::eomFlushed}, State::ReceivingDone}};
+
+// The whole matrix lives in .rodata; no static initializer runs
+constexpr Table kTransitionTable{kTransitions};
+
+} // namespace
 
-  return transitions->find(s, e);
+std::pair<HTTPTransactionIngressSMData::State, bool>
+HTTPTransactionIngressSMData::find(HTTPTransactionIngressSMData::State s,
+                                   HTTPTransactionIngressSMData::Event e) {
+  return kTransitionTable.find(s, e);
 }
 
 std::ostream& operator<<(std::ostream& os,
@@ -10,7 +10,6 @@
 #pragma once
 
 #include <iosfwd>
-#include <map>
 #include <proxygen/lib/utils/StateMachine.h>
 
 namespace proxygen {
@@ -10,7 +10,6 @@
 #include <proxygen/lib/http/session/HTTPUpstreamSession.h>
 #include <proxygen/lib/http/session/HTTPSessionController.h>
 
-#include <folly/io/async/AsyncSSLSocket.h>
 #include <proxygen/lib/http/codec/HTTP2Codec.h>
 #include <proxygen/lib/http/session/HTTPTransaction.h>
 #include <wangle/acceptor/ConnectionManager.h>
@@ -37,13 +36,52 @@ bool HTTPUpstreamSession::isReusable() const {
           << ", hasMoreWrites()=" << hasMoreWrites()
           << ", codec_->supportsParallelRequests()="
           << codec_->supportsParallelRequests();
-  return !isClosing() && !sock_->connecting() && codec_->isReusable() &&
-         !codec_->isBusy() && !ingressError_ &&
-         (codec_->supportsParallelRequests() ||
-          (
-              // These conditions only apply to serial codec sessions
-              !hasMoreWrites() && liveTransactions_ == 0 &&
-              !writeTimeout_.isScheduled()));
+  if (isClosing() || sock_->connecting() || !codec_->isReusable() ||
+      ingressError_) {
+    return false;
+  }
+  if (codec_->supportsParallelRequests()) {
+    return !codec_->isBusy();
+  }
+  if (maxPipelinedTransactions_ > 1) {
+    // A pipelined session can take another request once the previous
+    // request (not its response) has been fully written.  codec_->isBusy()
+    // is intentionally not consulted here; it stays true while responses
+    // are outstanding, which is exactly the state pipelining queues behind.
+    return liveTransactions_ < maxPipelinedTransactions_ &&
+           allTransactionsEgressComplete() && !writeTimeout_.isScheduled();
+  }
+  // These conditions only apply to serial codec sessions
+  return !codec_->isBusy() && !hasMoreWrites() && liveTransactions_ == 0 &&
+         !writeTimeout_.isScheduled();
+}
+
+void HTTPUpstreamSession::enablePipelining(uint32_t maxDepth) {
+  if (codec_->supportsParallelRequests()) {
+    VLOG(4) << *this << " ignoring pipelining on a parallel codec session";
+    return;
+  }
+  maxPipelinedTransactions_ = std::max(maxDepth, 1u);
+  setMaxConcurrentOutgoingStreamsRemote(maxPipelinedTransactions_);
+}
+
+bool HTTPUpstreamSession::applySettingsHint(const SettingsList& settings) {
+  if (getNumOutgoingStreams() > 0 || getNumIncomingStreams() > 0) {
+    // Too late: streams already sized off the defaults, and the hint
+    // cannot retroactively resize them the way a real SETTINGS can
+    return false;
+  }
+  if (!codec_->applyIngressSettingsHint(settings)) {
+    return false;
+  }
+  for (const auto& setting : settings) {
+    if (setting.id == SettingsId::MAX_CONCURRENT_STREAMS) {
+      // New streams pick window sizes up from the codec's ingress
+      // settings, but the outgoing stream limit lives on the session
+      setMaxConcurrentOutgoingStreamsRemote(setting.value);
+    }
+  }
+  return true;
 }
 
 bool HTTPUpstreamSession::isClosing() const {
@@ -83,6 +121,13 @@ HTTPTransaction* HTTPUpstreamSession::newTransaction(
     return nullptr;
   }
 
+  if (!codec_->supportsParallelRequests() && !transactions_.empty() &&
+      !allTransactionsEgressComplete()) {
+    // Pipelining requires the previous request to be fully written before
+    // the next codec stream is created; HTTP1xCodec egresses serially.
+    return nullptr;
+  }
+
   if (!started_) {
     startNow();
   }
@@ -104,6 +149,15 @@ HTTPTransaction::Handler* HTTPUpstreamSession::getTransactionTimeoutHandler(
   return nullptr;
 }
 
+bool HTTPUpstreamSession::allTransactionsEgressComplete() const {
+  for (const auto& txn : transactions_) {
+    if (!txn.second.isEgressComplete()) {
+      return false;
+    }
+  }
+  return true;
+}
+
 bool HTTPUpstreamSession::allTransactionsStarted() const {
   for (const auto& txn : transactions_) {
     if (!txn.second.isPushed() && !txn.second.isEgressStarted()) {
@@ -149,67 +203,4 @@ void HTTPUpstreamSession::detachTransactions() {
   }
 }
 
-void HTTPUpstreamSession::attachThreadLocals(
-    folly::EventBase* eventBase,
-    folly::SSLContextPtr sslContext,
-    const WheelTimerInstance& timeout,
-    HTTPSessionStats* stats,
-    FilterIteratorFn fn,
-    HeaderCodec::Stats* headerCodecStats,
-    HTTPSessionController* controller) {
-  txnEgressQueue_.attachThreadLocals(timeout);
-  timeout_ = timeout;
-  setController(controller);
-  setSessionStats(stats);
-  if (sock_) {
-    sock_->attachEventBase(eventBase);
-    maybeAttachSSLContext(sslContext);
-  }
-  codec_.foreach (fn);
-  codec_->setHeaderCodecStats(headerCodecStats);
-  resumeReadsImpl();
-  rescheduleLoopCallbacks();
-}
-
-void HTTPUpstreamSession::maybeAttachSSLContext(
-    folly::SSLContextPtr sslContext) const {
-#ifndef NO_ASYNCSSLSOCKET
-  auto sslSocket = sock_->getUnderlyingTransport<folly::AsyncSSLSocket>();
-  if (sslSocket && sslContext) {
-    sslSocket->attachSSLContext(sslContext);
-  }
-#endif
-}
-
-void HTTPUpstreamSession::detachThreadLocals(bool detachSSLContext) {
-  CHECK(transactions_.empty());
-  cancelLoopCallbacks();
-  pauseReadsImpl();
-  if (sock_) {
-    if (detachSSLContext) {
-      maybeDetachSSLContext();
-    }
-    sock_->detachEventBase();
-  }
-  txnEgressQueue_.detachThreadLocals();
-  setController(nullptr);
-  setSessionStats(nullptr);
-  // The codec filters *shouldn't* be accessible while the socket is detached,
-  // I hope
-  codec_->setHeaderCodecStats(nullptr);
-  auto cm = getConnectionManager();
-  if (cm) {
-    cm->removeConnection(this);
-  }
-}
-
-void HTTPUpstreamSession::maybeDetachSSLContext() const {
-#ifndef NO_ASYNCSSLSOCKET
-  auto sslSocket = sock_->getUnderlyingTransport<folly::AsyncSSLSocket>();
-  if (sslSocket) {
-    sslSocket->detachSSLContext();
-  }
-#endif
-}
-
 } // namespace proxygen
@@ -88,16 +88,6 @@ class HTTPUpstreamSession final : public HTTPSession {
 
   void detachTransactions();
 
-  void attachThreadLocals(folly::EventBase* eventBase,
-                          folly::SSLContextPtr sslContext,
-                          const WheelTimerInstance& timeout,
-                          HTTPSessionStats* stats,
-                          FilterIteratorFn fn,
-                          HeaderCodec::Stats* headerCodecStats,
-                          HTTPSessionController* controller) override;
-
-  void detachThreadLocals(bool detachSSLContext = false) override;
-
   void startNow() override;
 
   /**
@@ -109,6 +99,27 @@ class HTTPUpstreamSession final : public HTTPSession {
    */
   HTTPTransaction* newTransaction(HTTPTransaction::Handler* handler) override;
 
+  /**
+   * Allow up to maxDepth pipelined transactions on a serial (HTTP/1.1)
+   * codec session. A new request may be written as soon as the previous
+   * request - not its response - has been fully egressed; responses are
+   * demultiplexed in order by the codec. Any ingress error or non-reusable
+   * response closes the connection and errors out the queued transactions,
+   * so handlers can retry them elsewhere. No-op on parallel codecs, which
+   * have their own concurrency limits. A maxDepth <= 1 disables pipelining.
+   */
+  void enablePipelining(uint32_t maxDepth);
+
+  /**
+   * Optimistically apply SETTINGS remembered from a previous session to
+   * the same endpoint, so the first requests do not run with the
+   * conservative protocol defaults while the server's real SETTINGS are
+   * in flight (those overwrite the hint when they arrive).  Only
+   * effective before the first transaction is created; returns false if
+   * the hint could not be applied.
+   */
+  bool applySettingsHint(const SettingsList& settings);
+
   /**
    * Returns true if the underlying transport has completed full handshake.
    */
@@ -160,16 +171,26 @@ class HTTPUpstreamSession final : public HTTPSession {
 
   bool allTransactionsStarted() const override;
 
+  /**
+   * Returns true iff every live transaction has flushed its entire
+   * request through the codec. This is the pipelining admission test:
+   * HTTP1xCodec can only egress one request at a time.
+   */
+  bool allTransactionsEgressComplete() const;
+
   bool onNativeProtocolUpgrade(HTTPCodec::StreamID streamID,
                                CodecProtocol protocol,
                                const std::string& protocolString,
                                HTTPMessage& msg) override;
 
-  void maybeAttachSSLContext(folly::SSLContextPtr sslContext) const;
-  void maybeDetachSSLContext() const;
-
   uint8_t maxVirtualPriorityLevel_{0};
 
+  /**
+   * Max transactions to pipeline on a serial codec session; 1 preserves
+   * the classic one-request-per-round-trip behavior.
+   */
+  uint32_t maxPipelinedTransactions_{1};
+
   std::shared_ptr<const PriorityMapFactory> priorityMapFactory_;
   std::unique_ptr<PriorityAdapter> priorityAdapter_;
 };
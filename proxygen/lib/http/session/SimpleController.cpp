@@ -21,6 +21,12 @@ SimpleController::SimpleController(HTTPSessionAcceptor* acceptor)
 
 HTTPTransactionHandler* SimpleController::getRequestHandler(
     HTTPTransaction& txn, HTTPMessage* msg) {
+  if (acceptor_->shouldShedRequest()) {
+    // Admission control: answer with a canned 503 rather than spending
+    // handler work on an overloaded worker
+    return createErrorHandler(
+        503, "Service Unavailable", acceptor_->getDefaultErrorPage());
+  }
   return acceptor_->newHandler(txn, msg);
 }
 
@@ -0,0 +1,216 @@
+/*
+ *  Copyright (c) 2015-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include <proxygen/lib/http/session/TimestampByteEventTracker.h>
+
+#include <proxygen/lib/http/session/TTLBAStats.h>
+
+namespace proxygen {
+
+static_assert(sizeof(TimestampByteEvent) <= ByteEvent::kPooledBlockSize,
+              "TimestampByteEvent must fit the pooled block size");
+
+TimestampByteEventTracker::~TimestampByteEventTracker() {
+  drainEventList(txEvents_);
+  drainEventList(ackEvents_);
+}
+
+void TimestampByteEventTracker::absorb(ByteEventTracker&& other) {
+  ByteEventTracker::absorb(std::move(other));
+  auto timestampTracker = dynamic_cast<TimestampByteEventTracker*>(&other);
+  if (timestampTracker) {
+    // in-flight timestamp waits hold the old tracker as their timeout
+    // callback and cannot be retargeted; drop them
+    drainEventList(timestampTracker->txEvents_);
+    drainEventList(timestampTracker->ackEvents_);
+  }
+}
+
+void TimestampByteEventTracker::addLastByteEvent(HTTPTransaction* txn,
+                                                 uint64_t byteNo) noexcept {
+  VLOG(5) << " adding last byte event for " << byteNo;
+  TransactionByteEvent* event =
+      new TransactionByteEvent(byteNo, ByteEvent::LAST_BYTE, txn);
+  event->timestampTx_ = txTimestamping_;
+  event->timestampAck_ = ackTimestamping_;
+  byteEvents_.push_back(*event);
+}
+
+void TimestampByteEventTracker::addTrackedByteEvent(HTTPTransaction* txn,
+                                                    uint64_t byteNo) noexcept {
+  VLOG(5) << " adding tracked byte event for " << byteNo;
+  TransactionByteEvent* event =
+      new TransactionByteEvent(byteNo, ByteEvent::TRACKED_BYTE, txn);
+  event->timestampTx_ = txTimestamping_;
+  event->timestampAck_ = ackTimestamping_;
+  byteEvents_.push_back(*event);
+}
+
+uint64_t TimestampByteEventTracker::preSend(bool* cork,
+                                            bool* timestampTx,
+                                            bool* timestampAck,
+                                            uint64_t bytesWritten) {
+  for (const auto& event : byteEvents_) {
+    if (event.byteOffset_ > bytesWritten &&
+        (event.timestampTx_ || event.timestampAck_)) {
+      // split the write so the timestamped byte ends a transport send
+      *cork = true;
+      *timestampTx = event.timestampTx_;
+      *timestampAck = event.timestampAck_;
+      if (ttlbaStats_) {
+        ttlbaStats_->recordPresendIOSplit();
+      }
+      return event.byteOffset_ - bytesWritten;
+    }
+  }
+  return 0;
+}
+
+void TimestampByteEventTracker::addTxByteEvent(uint64_t offset,
+                                               ByteEvent::EventType eventType,
+                                               HTTPTransaction* txn) {
+  VLOG(5) << " adding TX timestamp event for " << offset;
+  TimestampByteEvent* event = new TimestampByteEvent(
+      this, TimestampByteEvent::TX, offset, eventType, txn);
+  txEvents_.push_back(*event);
+  if (timeoutSet_) {
+    timeoutSet_->scheduleTimeout(event);
+  }
+  if (ttlbaStats_) {
+    ttlbaStats_->recordTTBTXTracked();
+  }
+}
+
+void TimestampByteEventTracker::addAckByteEvent(uint64_t offset,
+                                                ByteEvent::EventType eventType,
+                                                HTTPTransaction* txn) {
+  VLOG(5) << " adding ACK timestamp event for " << offset;
+  TimestampByteEvent* event = new TimestampByteEvent(
+      this, TimestampByteEvent::ACK, offset, eventType, txn);
+  ackEvents_.push_back(*event);
+  if (timeoutSet_) {
+    timeoutSet_->scheduleTimeout(event);
+  }
+  if (ttlbaStats_) {
+    ttlbaStats_->recordTTLBATracked();
+  }
+}
+
+size_t TimestampByteEventTracker::disableSocketTimestampEvents() {
+  return drainEventList(txEvents_) + drainEventList(ackEvents_);
+}
+
+bool TimestampByteEventTracker::processTxTimestamp(
+    uint64_t offset,
+    TimePoint /*timestamp*/,
+    AckLatencyEvent::TimestampSource /*source*/) {
+  auto event = findTimestampEvent(txEvents_, offset);
+  if (!event) {
+    if (ttlbaStats_) {
+      ttlbaStats_->recordTTBTXNotFound();
+    }
+    return false;
+  }
+  event->cancelTimeout();
+  if (event->eventType_ == ByteEvent::TRACKED_BYTE) {
+    event->getTransaction()->onEgressTrackedByteEventTX(*event);
+  }
+  if (ttlbaStats_) {
+    ttlbaStats_->recordTTBTXReceived();
+  }
+  txEvents_.erase_and_dispose(txEvents_.iterator_to(*event),
+                              [](ByteEvent* e) { delete e; });
+  return true;
+}
+
+bool TimestampByteEventTracker::processAckTimestamp(
+    uint64_t offset,
+    TimePoint timestamp,
+    AckLatencyEvent::TimestampSource source) {
+  auto event = findTimestampEvent(ackEvents_, offset);
+  if (!event) {
+    if (ttlbaStats_) {
+      ttlbaStats_->recordTTLBANotFound();
+    }
+    return false;
+  }
+  event->cancelTimeout();
+  auto latency = std::chrono::duration_cast<std::chrono::nanoseconds>(
+      timestamp - event->createdTime_);
+  if (latency < std::chrono::nanoseconds::zero()) {
+    latency = std::chrono::nanoseconds::zero();
+  }
+  auto txn = event->getTransaction();
+  switch (event->eventType_) {
+    case ByteEvent::LAST_BYTE: {
+      txn->onEgressLastByteAck(
+          std::chrono::duration_cast<std::chrono::milliseconds>(latency));
+      AckLatencyEvent ackEvent;
+      ackEvent.byteNo = static_cast<unsigned int>(offset);
+      ackEvent.latency = latency;
+      ackEvent.source = source;
+      if (callback_) {
+        callback_->onAckLatencyEvent(ackEvent);
+      }
+      break;
+    }
+    case ByteEvent::FIRST_HEADER_BYTE:
+      txn->onLastEgressHeaderByteAcked();
+      break;
+    case ByteEvent::TRACKED_BYTE:
+      txn->onEgressTrackedByteEventAck(*event);
+      break;
+    default:
+      break;
+  }
+  if (ttlbaStats_) {
+    ttlbaStats_->recordTTLBAReceived();
+  }
+  ackEvents_.erase_and_dispose(ackEvents_.iterator_to(*event),
+                               [](ByteEvent* e) { delete e; });
+  return true;
+}
+
+void TimestampByteEventTracker::timeoutExpired(
+    TimestampByteEvent* event) noexcept {
+  VLOG(5) << " timestamp event timed out for " << event->getByteOffset();
+  auto& events = (event->timestampType_ == TimestampByteEvent::TX)
+                     ? txEvents_
+                     : ackEvents_;
+  if (ttlbaStats_) {
+    if (event->timestampType_ == TimestampByteEvent::TX) {
+      ttlbaStats_->recordTTBTXTimeout();
+    } else {
+      ttlbaStats_->recordTTLBATimeout();
+    }
+  }
+  events.erase_and_dispose(events.iterator_to(*event),
+                           [](ByteEvent* e) { delete e; });
+}
+
+TimestampByteEvent* TimestampByteEventTracker::findTimestampEvent(
+    EventList& events, uint64_t offset) {
+  for (auto& event : events) {
+    if (event.byteOffset_ == offset) {
+      return static_cast<TimestampByteEvent*>(&event);
+    }
+  }
+  return nullptr;
+}
+
+size_t TimestampByteEventTracker::drainEventList(EventList& events) {
+  size_t numEvents = 0;
+  while (!events.empty()) {
+    events.pop_front_and_dispose([](ByteEvent* event) { delete event; });
+    ++numEvents;
+  }
+  return numEvents;
+}
+
+} // namespace proxygen
@@ -0,0 +1,124 @@
+/*
+ *  Copyright (c) 2015-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#pragma once
+
+#include <proxygen/lib/http/session/ByteEventTracker.h>
+
+namespace proxygen {
+
+/**
+ * A ByteEventTracker that additionally waits for transport TX and ACK
+ * timestamps for the bytes it watches.  HTTPSession consults preSend() to
+ * split writes at bytes requiring timestamps; when the transport later
+ * reports a timestamp for such a byte -- read off the socket error queue
+ * with NIC hardware, kernel software, or plain host-clock resolution --
+ * the owner feeds it back through processTxTimestamp() or
+ * processAckTimestamp() and the matching transaction callbacks fire with
+ * the measured latency.  Acked last bytes are also surfaced to the
+ * tracker callback as AckLatencyEvents tagged with the timestamp source,
+ * so TTLB consumers can tell NIC-level measurements from software ones
+ * that wander under load.
+ *
+ * Timestamp waits have a timeout so a lost ack or a disabled error queue
+ * cannot pin transactions forever.
+ */
+class TimestampByteEventTracker
+    : public ByteEventTracker
+    , public TimestampByteEvent::Callback {
+ public:
+  TimestampByteEventTracker(Callback* callback, AsyncTimeoutSet* timeoutSet)
+      : ByteEventTracker(callback), timeoutSet_(timeoutSet) {
+  }
+
+  ~TimestampByteEventTracker() override;
+
+  /**
+   * Pending timestamp waits reference this tracker as their timeout
+   * callback, so they cannot move to the absorbing tracker; they are
+   * dropped instead.
+   */
+  void absorb(ByteEventTracker&& other) override;
+
+  /** Request TX (wire transmit) timestamps for subsequent tracked bytes */
+  void setTxTimestamping(bool enabled) {
+    txTimestamping_ = enabled;
+  }
+
+  /** Request ACK timestamps for subsequent tracked bytes */
+  void setAckTimestamping(bool enabled) {
+    ackTimestamping_ = enabled;
+  }
+
+  void addLastByteEvent(HTTPTransaction* txn, uint64_t byteNo) noexcept
+      override;
+  void addTrackedByteEvent(HTTPTransaction* txn, uint64_t byteNo) noexcept
+      override;
+
+  uint64_t preSend(bool* cork,
+                   bool* timestampTx,
+                   bool* timestampAck,
+                   uint64_t bytesWritten) override;
+
+  void addTxByteEvent(uint64_t offset,
+                      ByteEvent::EventType eventType,
+                      HTTPTransaction* txn) override;
+  void addAckByteEvent(uint64_t offset,
+                       ByteEvent::EventType eventType,
+                       HTTPTransaction* txn) override;
+
+  size_t disableSocketTimestampEvents() override;
+
+  /**
+   * Deliver a TX timestamp for the given raw byte offset.  Returns true
+   * if a pending byte event matched.
+   */
+  bool processTxTimestamp(uint64_t offset,
+                          TimePoint timestamp,
+                          AckLatencyEvent::TimestampSource source);
+
+  /**
+   * Deliver an ACK timestamp for the given raw byte offset.  Returns true
+   * if a pending byte event matched.  Hardware timestamps must already be
+   * converted to the host clock domain by the producer.
+   */
+  bool processAckTimestamp(uint64_t offset,
+                          TimePoint timestamp,
+                          AckLatencyEvent::TimestampSource source);
+
+  // TimestampByteEvent::Callback
+  void timeoutExpired(TimestampByteEvent* event) noexcept override;
+
+  void setTTLBAStats(TTLBAStats* stats) override {
+    ttlbaStats_ = stats;
+  }
+
+ private:
+  using EventList = folly::CountedIntrusiveList<ByteEvent,
+                                                &ByteEvent::listHook>;
+
+  TimestampByteEvent* findTimestampEvent(EventList& events, uint64_t offset);
+
+  static size_t drainEventList(EventList& events);
+
+  /** TX timestamp waits, ascending byte offset */
+  EventList txEvents_;
+
+  /** ACK timestamp waits, ascending byte offset */
+  EventList ackEvents_;
+
+  AsyncTimeoutSet* timeoutSet_{nullptr};
+
+  TTLBAStats* ttlbaStats_{nullptr};
+
+  bool txTimestamping_{false};
+  bool ackTimestamping_{false};
+};
+
+} // namespace proxygen
@@ -74,6 +74,9 @@ class TimestampByteEvent
   }
 
   const TimestampType timestampType_;
+  // When the event was created, i.e. when the byte was handed to the
+  // transport; latencies are measured relative to this
+  const TimePoint createdTime_{getCurrentTime()};
 
  private:
   Callback* callback_;
@@ -11,10 +11,12 @@
 #include <folly/portability/GTest.h>
 
 #include <proxygen/lib/http/session/ByteEventTracker.h>
+#include <proxygen/lib/http/session/TimestampByteEventTracker.h>
 #include <proxygen/lib/http/session/test/HTTPSessionMocks.h>
 #include <proxygen/lib/http/session/test/HTTPTransactionMocks.h>
 
 #include <chrono>
+#include <thread>
 
 using namespace testing;
 using namespace proxygen;
@@ -25,6 +27,7 @@ class MockByteEventTrackerCallback : public ByteEventTracker::Callback {
   GMOCK_METHOD1_(
       , noexcept, , onTxnByteEventWrittenToBuf, void(const ByteEvent&));
   GMOCK_METHOD0_(, noexcept, , onDeleteTxnByteEvent, void());
+  GMOCK_METHOD1_(, noexcept, , onAckLatencyEvent, void(const AckLatencyEvent&));
 };
 
 class ByteEventTrackerTest : public Test {
@@ -72,3 +75,101 @@ TEST_F(ByteEventTrackerTest, Ttlb) {
   EXPECT_CALL(transport_, detach(_));
   byteEventTracker_->processByteEvents(byteEventTracker_, 10);
 }
+
+TEST_F(ByteEventTrackerTest, ProjectedDrainTime) {
+  // nothing pending means nothing left to drain
+  auto projected = byteEventTracker_->projectedDrainTime();
+  ASSERT_TRUE(projected.hasValue());
+  EXPECT_EQ(projected->count(), 0);
+
+  // a far-off pending event with only one rate sample point yields no
+  // projection yet
+  byteEventTracker_->addPingByteEvent(10, proxygen::getCurrentTime(), 1000000);
+  byteEventTracker_->processByteEvents(byteEventTracker_, 100);
+  EXPECT_FALSE(byteEventTracker_->projectedDrainTime().hasValue());
+
+  // a second sample establishes a delivery rate; at ~100 bytes per 20ms the
+  // remaining ~1MB projects to a clearly nonzero drain time
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  byteEventTracker_->processByteEvents(byteEventTracker_, 200);
+  projected = byteEventTracker_->projectedDrainTime();
+  ASSERT_TRUE(projected.hasValue());
+  EXPECT_GT(projected->count(), 0);
+
+  // a replacement tracker absorbs both the events and the rate estimate
+  ByteEventTracker replacement(&callback_);
+  replacement.absorb(std::move(*byteEventTracker_));
+  projected = replacement.projectedDrainTime();
+  ASSERT_TRUE(projected.hasValue());
+  EXPECT_GT(projected->count(), 0);
+}
+
+class TimestampByteEventTrackerTest : public ByteEventTrackerTest {
+ public:
+  void SetUp() override {
+    ByteEventTrackerTest::SetUp();
+    byteEventTracker_.reset(new TimestampByteEventTracker(
+        &callback_, timeoutSet_.get()));
+    tracker_ =
+        static_cast<TimestampByteEventTracker*>(byteEventTracker_.get());
+  }
+
+ protected:
+  AsyncTimeoutSet::UniquePtr timeoutSet_{
+      new AsyncTimeoutSet(&eventBase_, std::chrono::milliseconds(50))};
+  TimestampByteEventTracker* tracker_{nullptr};
+};
+
+TEST_F(TimestampByteEventTrackerTest, AckTimestamp) {
+  tracker_->setAckTimestamping(true);
+  tracker_->addLastByteEvent(&txn_, 10);
+
+  // the write is split at the timestamped byte
+  bool cork = false;
+  bool timestampTx = false;
+  bool timestampAck = false;
+  EXPECT_EQ(tracker_->preSend(&cork, &timestampTx, &timestampAck, 0), 10);
+  EXPECT_TRUE(cork);
+  EXPECT_FALSE(timestampTx);
+  EXPECT_TRUE(timestampAck);
+
+  EXPECT_CALL(transportCallback_, headerBytesGenerated(_));
+  txn_.sendAbort(); // put it in a state for detach
+  tracker_->addAckByteEvent(10, ByteEvent::LAST_BYTE, &txn_);
+  EXPECT_CALL(transportCallback_, lastByteFlushed());
+  EXPECT_CALL(callback_, onTxnByteEventWrittenToBuf(_));
+  byteEventTracker_->processByteEvents(byteEventTracker_, 10);
+
+  // the ack timestamp completes the wait and surfaces the tagged latency
+  EXPECT_CALL(transportCallback_, lastByteAcked(_));
+  EXPECT_CALL(
+      callback_,
+      onAckLatencyEvent(AllOf(
+          Field(&AckLatencyEvent::byteNo, 10u),
+          Field(&AckLatencyEvent::source,
+                AckLatencyEvent::TimestampSource::HARDWARE))));
+  EXPECT_CALL(transport_, detach(_));
+  EXPECT_TRUE(tracker_->processAckTimestamp(
+      10, getCurrentTime(), AckLatencyEvent::TimestampSource::HARDWARE));
+
+  // nothing left pending
+  EXPECT_FALSE(tracker_->processAckTimestamp(
+      10, getCurrentTime(), AckLatencyEvent::TimestampSource::HARDWARE));
+}
+
+TEST_F(TimestampByteEventTrackerTest, AckTimestampTimeout) {
+  EXPECT_CALL(transportCallback_, headerBytesGenerated(_));
+  txn_.sendAbort(); // put it in a state for detach
+  tracker_->addAckByteEvent(10, ByteEvent::LAST_BYTE, &txn_);
+  // the wait expires without a timestamp and the event is dropped
+  EXPECT_CALL(transport_, detach(_));
+  eventBase_.loop();
+  EXPECT_FALSE(tracker_->processAckTimestamp(
+      10, getCurrentTime(), AckLatencyEvent::TimestampSource::KERNEL));
+}
+
+TEST_F(TimestampByteEventTrackerTest, DisableDrainsWaits) {
+  tracker_->addAckByteEvent(10, ByteEvent::LAST_BYTE, &txn_);
+  tracker_->addTxByteEvent(10, ByteEvent::LAST_BYTE, &txn_);
+  EXPECT_EQ(tracker_->disableSocketTimestampEvents(), 2);
+}
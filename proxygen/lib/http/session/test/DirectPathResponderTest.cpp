@@ -0,0 +1,80 @@
+/*
+ *  Copyright (c) 2015-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include <proxygen/lib/http/session/DirectPathResponder.h>
+
+#include <folly/portability/GTest.h>
+
+using namespace proxygen;
+
+namespace {
+
+HTTPMessage makeGet(const std::string& path) {
+  HTTPMessage req;
+  req.setMethod(HTTPMethod::GET);
+  req.setURL(path);
+  return req;
+}
+
+}
+
+class DirectPathResponderTest : public testing::Test {
+ protected:
+  void SetUp() override {
+    std::map<std::string, AcceptorConfiguration::DirectResponse> config;
+    config["/ping"];
+    auto& status = config["/status"];
+    status.contentType = "text/plain";
+    status.body = "OK";
+    responder_ = std::make_unique<DirectPathResponder>(config);
+  }
+
+  std::unique_ptr<DirectPathResponder> responder_;
+};
+
+TEST_F(DirectPathResponderTest, MatchesExactPathsOnly) {
+  EXPECT_NE(responder_->match(makeGet("/ping")), nullptr);
+  EXPECT_NE(responder_->match(makeGet("/status")), nullptr);
+  EXPECT_EQ(responder_->match(makeGet("/ping/")), nullptr);
+  EXPECT_EQ(responder_->match(makeGet("/pong")), nullptr);
+  EXPECT_EQ(responder_->match(makeGet("/")), nullptr);
+}
+
+TEST_F(DirectPathResponderTest, MatchesGetOnly) {
+  HTTPMessage post;
+  post.setMethod(HTTPMethod::POST);
+  post.setURL("/ping");
+  EXPECT_EQ(responder_->match(post), nullptr);
+}
+
+TEST_F(DirectPathResponderTest, BuildsResponsePrototypes) {
+  auto ping = responder_->match(makeGet("/ping"));
+  ASSERT_NE(ping, nullptr);
+  EXPECT_EQ(ping->headers.getStatusCode(), 200);
+  EXPECT_EQ(ping->headers.getStatusMessage(),
+            HTTPMessage::getDefaultReason(200));
+  EXPECT_EQ(ping->headers.getHeaders().getSingleOrEmpty(
+                HTTP_HEADER_CONTENT_LENGTH),
+            "0");
+  EXPECT_EQ(ping->body, nullptr);
+
+  auto status = responder_->match(makeGet("/status"));
+  ASSERT_NE(status, nullptr);
+  EXPECT_EQ(status->headers.getHeaders().getSingleOrEmpty(
+                HTTP_HEADER_CONTENT_TYPE),
+            "text/plain");
+  EXPECT_EQ(status->headers.getHeaders().getSingleOrEmpty(
+                HTTP_HEADER_CONTENT_LENGTH),
+            "2");
+  ASSERT_NE(status->body, nullptr);
+  EXPECT_EQ(status->body->clone()->moveToFbString().toStdString(), "OK");
+
+  // Repeated lookups hand back the same prototype
+  EXPECT_EQ(responder_->match(makeGet("/ping")), ping);
+}
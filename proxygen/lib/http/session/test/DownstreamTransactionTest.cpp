@@ -7,6 +7,8 @@
  *  of patent rights can be found in the PATENTS file in the same directory.
  *
  */
+#include <folly/Conv.h>
+#include <folly/ScopeGuard.h>
 #include <folly/io/async/EventBase.h>
 #include <folly/io/async/test/MockAsyncTransport.h>
 #include <proxygen/lib/http/codec/SPDYConstants.h>
@@ -119,6 +121,255 @@ TEST_F(DownstreamTransactionTest, SimpleCallbackForwarding) {
   eventBase_.loop();
 }
 
+/**
+ * A completed request/response pair leaves a populated timing record;
+ * events that happened carry a non-zero delta and the pause durations
+ * stay zero when nothing paused.
+ */
+TEST_F(DownstreamTransactionTest, TimingsRecordedAtDetach) {
+  HTTPTransaction txn(TransportDirection::DOWNSTREAM,
+                      HTTPCodec::StreamID(1),
+                      1,
+                      transport_,
+                      txnEgressQueue_,
+                      transactionTimeouts_.get(),
+                      std::chrono::milliseconds(500));
+  setupRequestResponseFlow(&txn, 100);
+
+  txn.onIngressHeadersComplete(makeGetRequest());
+  eventBase_.loop();
+
+  const auto& timings = txn.getTimings();
+  EXPECT_GE(timings.ingressHeadersMs, 1);
+  EXPECT_GE(timings.handlerAttachedMs, 1);
+  EXPECT_GE(timings.egressEomMs, 1);
+  EXPECT_EQ(timings.egressPausedMs, 0);
+  EXPECT_EQ(timings.flowControlBlockedMs, 0);
+}
+
+/**
+ * Refreshing an armed idle timeout must not touch the timing wheel, and
+ * a firing wheel entry with fresh activity re-arms instead of timing
+ * the transaction out.
+ */
+TEST_F(DownstreamTransactionTest, LazyIdleTimeoutRefresh) {
+  HTTPTransaction txn(TransportDirection::DOWNSTREAM,
+                      HTTPCodec::StreamID(1),
+                      1,
+                      transport_,
+                      txnEgressQueue_,
+                      transactionTimeouts_.get(),
+                      std::chrono::milliseconds(500));
+  EXPECT_CALL(transport_, transactionTimeout(_)).Times(0);
+
+  txn.refreshTimeout();
+  EXPECT_EQ(transactionTimeouts_->count(), 1);
+  // Subsequent refreshes only stamp the activity time
+  txn.refreshTimeout();
+  EXPECT_EQ(transactionTimeouts_->count(), 1);
+  // The wheel fires with fresh activity: pushed out, not expired
+  txn.timeoutExpired();
+  EXPECT_EQ(transactionTimeouts_->count(), 1);
+}
+
+/**
+ * A generous timeout budget rides through a complete request/response
+ * pair without firing: phase boundaries debit it, egress EOM completes
+ * it, and the wheel entry goes back to the idle scheme.
+ */
+TEST_F(DownstreamTransactionTest, TimeoutBudgetCompletes) {
+  HTTPTransaction txn(TransportDirection::DOWNSTREAM,
+                      HTTPCodec::StreamID(1),
+                      1,
+                      transport_,
+                      txnEgressQueue_,
+                      transactionTimeouts_.get(),
+                      std::chrono::milliseconds(500));
+  EXPECT_CALL(transport_, transactionTimeout(_)).Times(0);
+  txn.setTimeoutBudget(std::chrono::milliseconds(60000));
+  EXPECT_TRUE(txn.hasTimeoutBudget());
+  EXPECT_EQ(transactionTimeouts_->count(), 1);
+  // While the budget is active, idle refreshes leave its wheel entry alone
+  txn.refreshTimeout();
+  EXPECT_EQ(transactionTimeouts_->count(), 1);
+  setupRequestResponseFlow(&txn, 100);
+
+  txn.onIngressHeadersComplete(makeGetRequest());
+  eventBase_.loop();
+
+  const auto& budget = txn.getTimeoutBudget();
+  EXPECT_FALSE(budget.active);
+  EXPECT_GT(budget.remaining.count(), 0);
+  // The handler attached, so the ingress phase closed out
+  EXPECT_GE(budget.phase, HTTPTransactionTimeoutBudget::HANDLER);
+}
+
+/**
+ * An exhausted budget times the transaction out directly - the entry was
+ * armed for exactly the remaining budget, so firing is never a stale
+ * idle check - and the budget names the phase that spent it.
+ */
+TEST_F(DownstreamTransactionTest, TimeoutBudgetExpires) {
+  HTTPTransaction txn(TransportDirection::DOWNSTREAM,
+                      HTTPCodec::StreamID(1),
+                      1,
+                      transport_,
+                      txnEgressQueue_,
+                      transactionTimeouts_.get(),
+                      std::chrono::milliseconds(500));
+  txn.setTimeoutBudget(std::chrono::milliseconds(10));
+
+  EXPECT_CALL(transport_, transactionTimeout(&txn));
+  txn.timeoutExpired();
+  EXPECT_EQ(txn.getTimeoutBudget().phase,
+            HTTPTransactionTimeoutBudget::INGRESS);
+}
+
+/**
+ * With a coalescing window set, codec-sized chunks accumulate until the
+ * byte threshold trips, and a pending remainder is flushed ahead of EOM.
+ */
+TEST_F(DownstreamTransactionTest, IngressBodyCoalescing) {
+  HTTPTransaction txn(TransportDirection::DOWNSTREAM,
+                      HTTPCodec::StreamID(1),
+                      1,
+                      transport_,
+                      txnEgressQueue_,
+                      transactionTimeouts_.get(),
+                      std::chrono::milliseconds(500));
+  txn.setIngressBodyCoalescing(250, std::chrono::milliseconds(0));
+
+  std::vector<std::pair<uint64_t, size_t>> deliveries;
+  EXPECT_CALL(handler_, setTransaction(&txn));
+  EXPECT_CALL(handler_, onHeadersComplete(_));
+  EXPECT_CALL(handler_, onBodyWithOffset(_, _))
+      .WillRepeatedly(
+          Invoke([&](uint64_t offset, std::shared_ptr<folly::IOBuf> body) {
+            deliveries.emplace_back(offset, body->computeChainDataLength());
+          }));
+  EXPECT_CALL(handler_, onEOM());
+  txn.setHandler(&handler_);
+
+  txn.onIngressHeadersComplete(makePostRequest(350));
+  txn.onIngressBody(makeBuf(100), 0);
+  txn.onIngressBody(makeBuf(100), 0);
+  EXPECT_TRUE(deliveries.empty());
+  txn.onIngressBody(makeBuf(100), 0);
+  ASSERT_EQ(deliveries.size(), 1);
+  EXPECT_EQ(deliveries[0].first, 0);
+  EXPECT_EQ(deliveries[0].second, 300);
+
+  // the sub-threshold remainder is delivered ahead of EOM
+  txn.onIngressBody(makeBuf(50), 0);
+  EXPECT_EQ(deliveries.size(), 1);
+  txn.onIngressEOM();
+  ASSERT_EQ(deliveries.size(), 2);
+  EXPECT_EQ(deliveries[1].first, 300);
+  EXPECT_EQ(deliveries[1].second, 50);
+}
+
+TEST_F(DownstreamTransactionTest, BodySplicePeer) {
+  // Ingress side of the proxied request
+  HTTPTransaction ingressTxn(TransportDirection::DOWNSTREAM,
+                             HTTPCodec::StreamID(1),
+                             1,
+                             transport_,
+                             txnEgressQueue_,
+                             transactionTimeouts_.get(),
+                             std::chrono::milliseconds(500));
+  // Egress side, on its own transport
+  MockHTTPTransactionTransport transport2;
+  EXPECT_CALL(transport2, describe(_)).WillRepeatedly(Return());
+  HTTPTransaction egressTxn(TransportDirection::DOWNSTREAM,
+                            HTTPCodec::StreamID(2),
+                            2,
+                            transport2,
+                            txnEgressQueue_,
+                            transactionTimeouts_.get(),
+                            std::chrono::milliseconds(500));
+  EXPECT_CALL(transport2, sendHeaders(&egressTxn, _, _, _));
+  egressTxn.sendHeaders(*makeResponse(200));
+
+  ingressTxn.spliceBodyTo(&egressTxn);
+  EXPECT_TRUE(ingressTxn.isBodySpliced());
+
+  // Spliced ingress body lands on the peer's egress queue, not a handler
+  ingressTxn.onIngressHeadersComplete(makeGetRequest());
+  ingressTxn.onIngressBody(makeBuf(100), 0);
+  ingressTxn.onIngressBody(makeBuf(100), 0);
+  EXPECT_EQ(egressTxn.getOutstandingEgressBodyBytes(), 200);
+  EXPECT_FALSE(ingressTxn.isIngressPaused());
+
+  // Exceeding the splice buffer limit applies backpressure to ingress
+  EXPECT_CALL(transport_, pauseIngress(&ingressTxn));
+  ingressTxn.onIngressBody(makeBuf(70000), 0);
+  EXPECT_TRUE(ingressTxn.isIngressPaused());
+
+  // Unsplicing both directions leaves no dangling pairing
+  ingressTxn.unspliceBody();
+  EXPECT_FALSE(ingressTxn.isBodySpliced());
+}
+
+namespace {
+class TestBodyGenerator : public HTTPTransaction::BodyGenerator {
+ public:
+  TestBodyGenerator(size_t remaining, size_t chunkSize)
+      : remaining_(remaining), chunkSize_(chunkSize) {}
+
+  std::unique_ptr<folly::IOBuf> generateBody(size_t maxBytes,
+                                             bool& eom) noexcept override {
+    calls_++;
+    auto len = std::min({maxBytes, remaining_, chunkSize_});
+    remaining_ -= len;
+    eom = (remaining_ == 0);
+    return len > 0 ? makeBuf(len) : nullptr;
+  }
+
+  size_t remaining_;
+  size_t chunkSize_;
+  uint32_t calls_{0};
+};
+} // namespace
+
+TEST_F(DownstreamTransactionTest, PullModeBodyGenerator) {
+  EXPECT_CALL(transport_, notifyPendingEgress()).WillRepeatedly(Return());
+  EXPECT_CALL(transport_, notifyEgressBodyBuffered(_)).WillRepeatedly(Return());
+
+  // flow control is disabled
+  HTTPTransaction txn(TransportDirection::DOWNSTREAM,
+                      HTTPCodec::StreamID(1),
+                      1,
+                      transport_,
+                      txnEgressQueue_,
+                      transactionTimeouts_.get(),
+                      std::chrono::milliseconds(500));
+  EXPECT_CALL(transport_, sendHeaders(&txn, _, _, _));
+  txn.sendHeaders(*makeResponse(200));
+
+  // The generator has 500 bytes but produces at most 200 per poll
+  TestBodyGenerator gen(500, 200);
+  txn.setBodyGenerator(&gen);
+  // Installing the generator primes one chunk and enqueues the txn;
+  // buffered egress is a chunk, not the whole body
+  EXPECT_EQ(txn.getOutstandingEgressBodyBytes(), 200);
+  EXPECT_TRUE(txn.hasPendingBody());
+
+  InSequence enforceOrder;
+  EXPECT_CALL(transport_, sendBody(&txn, _, false, _))
+      .Times(2)
+      .WillRepeatedly(Return(200));
+  EXPECT_CALL(transport_, sendBody(&txn, _, true, _)).WillOnce(Return(100));
+
+  // Each write grant sends the buffer and refills it just in time
+  EXPECT_EQ(txn.onWriteReady(200, 1), true);
+  EXPECT_EQ(txn.getOutstandingEgressBodyBytes(), 200);
+  EXPECT_EQ(txn.onWriteReady(200, 1), true);
+  // The generator emitted EOM with its last 100 bytes
+  EXPECT_EQ(txn.getOutstandingEgressBodyBytes(), 100);
+  EXPECT_EQ(txn.onWriteReady(200, 1), false);
+  EXPECT_EQ(gen.calls_, 3);
+}
+
 /**
  * Testing that we're sending a window update for simple requests
  */
@@ -583,3 +834,48 @@ TEST_F(DownstreamTransactionTest, ParseIngressErrorExTxnNonUnidirectional) {
 
   eventBase_.loop();
 }
+
+/**
+ * An upstream transaction carrying a request deadline re-encodes the
+ * remaining budget as a metadata header when the request goes out, so
+ * the next hop sees how much time is left rather than the original
+ * grant.
+ */
+TEST_F(DownstreamTransactionTest, RequestDeadlineEncodedUpstream) {
+  HTTPTransaction::setDeadlineHeaderName("x-request-budget-ms");
+  SCOPE_EXIT {
+    HTTPTransaction::setDeadlineHeaderName("");
+  };
+
+  HTTPTransaction txn(TransportDirection::UPSTREAM,
+                      HTTPCodec::StreamID(1),
+                      1,
+                      transport_,
+                      txnEgressQueue_,
+                      transactionTimeouts_.get(),
+                      std::chrono::milliseconds(500));
+  txn.setRequestDeadline(getCurrentTime() + std::chrono::seconds(30));
+
+  EXPECT_CALL(handler_, setTransaction(&txn));
+  EXPECT_CALL(transport_, sendHeaders(&txn, _, _, _))
+      .WillOnce(Invoke([](Unused, const HTTPMessage& headers, Unused, Unused) {
+        ASSERT_NE(headers.getMetadataHeaders(), nullptr);
+        auto budget = folly::to<int64_t>(
+            headers.getMetadataHeaders()->getSingleOrEmpty(
+                "x-request-budget-ms"));
+        EXPECT_GT(budget, 0);
+        EXPECT_LE(budget, 30000);
+      }));
+  EXPECT_CALL(handler_, onError(_));
+  EXPECT_CALL(transport_, sendAbort(_, _));
+  EXPECT_CALL(handler_, detachTransaction());
+  EXPECT_CALL(transport_, detach(&txn));
+
+  txn.setHandler(&handler_);
+  txn.sendHeaders(*makeGetRequest());
+
+  HTTPException err(HTTPException::Direction::INGRESS_AND_EGRESS, "test");
+  txn.onError(err);
+
+  eventBase_.loop();
+}
@@ -0,0 +1,92 @@
+/*
+ *  Copyright (c) 2019-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include <proxygen/lib/http/session/HQMigrationState.h>
+
+#include <folly/portability/GTest.h>
+
+using namespace proxygen;
+using namespace proxygen::hq;
+
+namespace {
+
+HQMigrationState makeState() {
+  HQMigrationState state;
+  state.peerSettings.emplace_back(SettingsId::HEADER_TABLE_SIZE, 4096);
+  state.peerSettings.emplace_back(SettingsId::MAX_HEADER_LIST_SIZE, 65536);
+  state.qpackTableCapacity = 4096;
+  state.qpackTable.push_back({":authority", "www.facebook.com"});
+  state.qpackTable.push_back({"x-fb-debug", "abcdef0123456789"});
+  state.streams.push_back({0, 12345});
+  state.streams.push_back({4, 0});
+  return state;
+}
+
+} // namespace
+
+TEST(HQMigrationStateTest, RoundTrip) {
+  auto state = makeState();
+  auto blob = state.serialize();
+  auto parsed = HQMigrationState::parse(*blob);
+  ASSERT_TRUE(parsed.hasValue());
+
+  ASSERT_EQ(parsed->peerSettings.size(), 2);
+  EXPECT_EQ(parsed->peerSettings[0].id, SettingsId::HEADER_TABLE_SIZE);
+  EXPECT_EQ(parsed->peerSettings[0].value, 4096);
+  EXPECT_EQ(parsed->peerSettings[1].id, SettingsId::MAX_HEADER_LIST_SIZE);
+  EXPECT_EQ(parsed->peerSettings[1].value, 65536);
+
+  EXPECT_EQ(parsed->qpackTableCapacity, 4096);
+  ASSERT_EQ(parsed->qpackTable.size(), 2);
+  EXPECT_EQ(parsed->qpackTable[0].name, ":authority");
+  EXPECT_EQ(parsed->qpackTable[0].value, "www.facebook.com");
+  EXPECT_EQ(parsed->qpackTable[1].name, "x-fb-debug");
+  EXPECT_EQ(parsed->qpackTable[1].value, "abcdef0123456789");
+
+  ASSERT_EQ(parsed->streams.size(), 2);
+  EXPECT_EQ(parsed->streams[0].streamId, 0);
+  EXPECT_EQ(parsed->streams[0].egressByteOffset, 12345);
+  EXPECT_EQ(parsed->streams[1].streamId, 4);
+  EXPECT_EQ(parsed->streams[1].egressByteOffset, 0);
+}
+
+TEST(HQMigrationStateTest, EmptyRoundTrip) {
+  HQMigrationState state;
+  auto blob = state.serialize();
+  auto parsed = HQMigrationState::parse(*blob);
+  ASSERT_TRUE(parsed.hasValue());
+  EXPECT_TRUE(parsed->peerSettings.empty());
+  EXPECT_TRUE(parsed->qpackTable.empty());
+  EXPECT_TRUE(parsed->streams.empty());
+}
+
+TEST(HQMigrationStateTest, RejectsBadMagic) {
+  auto blob = makeState().serialize();
+  blob->writableData()[0] ^= 0xff;
+  EXPECT_FALSE(HQMigrationState::parse(*blob).hasValue());
+}
+
+TEST(HQMigrationStateTest, RejectsUnknownVersion) {
+  auto blob = makeState().serialize();
+  // The version varint follows the 4-byte magic
+  blob->writableData()[4] = 0x3f;
+  EXPECT_FALSE(HQMigrationState::parse(*blob).hasValue());
+}
+
+TEST(HQMigrationStateTest, RejectsTruncation) {
+  auto blob = makeState().serialize();
+  blob->coalesce();
+  // Every proper prefix must fail to parse, never resume from garbage
+  for (size_t len = 0; len < blob->length(); len++) {
+    auto prefix = blob->clone();
+    prefix->trimEnd(blob->length() - len);
+    EXPECT_FALSE(HQMigrationState::parse(*prefix).hasValue())
+        << "prefix length " << len;
+  }
+}
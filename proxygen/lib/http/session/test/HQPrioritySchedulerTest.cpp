@@ -0,0 +1,105 @@
+/*
+ *  Copyright (c) 2019-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include <folly/portability/GTest.h>
+
+#include <proxygen/lib/http/session/HQPriorityScheduler.h>
+#include <proxygen/lib/http/session/test/HTTPTransactionMocks.h>
+
+using namespace testing;
+using namespace proxygen;
+
+class HQPrioritySchedulerTest : public Test {
+ public:
+  void SetUp() override {
+    for (HTTPCodec::StreamID id = 0; id < 4; id++) {
+      txns_.emplace_back(std::make_unique<HTTPTransaction>(
+          TransportDirection::DOWNSTREAM,
+          id,
+          0,
+          transport_,
+          txnEgressQueue_,
+          transactionTimeouts_.getWheelTimer(),
+          transactionTimeouts_.getDefaultTimeout()));
+    }
+  }
+
+  HTTP2PriorityQueue::NextEgressResult allWritable() {
+    HTTP2PriorityQueue::NextEgressResult result;
+    for (auto& txn : txns_) {
+      result.emplace_back(txn.get(), 1.0 / txns_.size());
+    }
+    return result;
+  }
+
+ protected:
+  folly::EventBase eventBase_;
+  WheelTimerInstance transactionTimeouts_{std::chrono::milliseconds(500),
+                                          &eventBase_};
+  NiceMock<MockHTTPTransactionTransport> transport_;
+  HTTP2PriorityQueue txnEgressQueue_;
+  std::vector<std::unique_ptr<HTTPTransaction>> txns_;
+  HQPriorityScheduler scheduler_;
+};
+
+TEST_F(HQPrioritySchedulerTest, DisabledUntilRegistered) {
+  EXPECT_FALSE(scheduler_.enabled());
+  scheduler_.setUrgency(1, 0, true);
+  EXPECT_TRUE(scheduler_.enabled());
+  scheduler_.erase(1);
+  EXPECT_FALSE(scheduler_.enabled());
+}
+
+TEST_F(HQPrioritySchedulerTest, TopUrgencyWins) {
+  // stream 2 outranks the others; unregistered streams get the default
+  // urgency
+  scheduler_.setUrgency(2, 1, true);
+  auto streams = allWritable();
+  scheduler_.buildSchedule(streams);
+  ASSERT_EQ(streams.size(), 1);
+  EXPECT_EQ(streams[0].first->getID(), 2);
+  EXPECT_EQ(streams[0].second, 1);
+}
+
+TEST_F(HQPrioritySchedulerTest, IncrementalRoundRobin) {
+  scheduler_.setUrgency(0, 1, true);
+  scheduler_.setUrgency(1, 1, true);
+  scheduler_.setUrgency(2, HQPriorityScheduler::kDefaultUrgency, true);
+
+  auto streams = allWritable();
+  scheduler_.buildSchedule(streams);
+  ASSERT_EQ(streams.size(), 2);
+  auto first = streams[0].first->getID();
+  EXPECT_EQ(streams[0].second, 0.5);
+
+  // the next round leads with the other stream
+  streams = allWritable();
+  scheduler_.buildSchedule(streams);
+  ASSERT_EQ(streams.size(), 2);
+  EXPECT_NE(streams[0].first->getID(), first);
+}
+
+TEST_F(HQPrioritySchedulerTest, SequentialPreemptsIncremental) {
+  scheduler_.setUrgency(1, 2, false);
+  scheduler_.setUrgency(3, 2, true);
+
+  // the non-incremental stream is served alone until it finishes
+  for (int round = 0; round < 3; round++) {
+    auto streams = allWritable();
+    scheduler_.buildSchedule(streams);
+    ASSERT_EQ(streams.size(), 1);
+    EXPECT_EQ(streams[0].first->getID(), 1);
+  }
+
+  scheduler_.erase(1);
+  auto streams = allWritable();
+  scheduler_.buildSchedule(streams);
+  ASSERT_EQ(streams.size(), 1);
+  EXPECT_EQ(streams[0].first->getID(), 3);
+}
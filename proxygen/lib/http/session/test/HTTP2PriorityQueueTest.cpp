@@ -385,6 +385,34 @@ TEST_F(QueueTest, UpdateParentDescendantExcl) {
   EXPECT_EQ(nodes_, IDList({{7, 40}, {9, 40}, {3, 20}}));
 }
 
+TEST_F(QueueTest, EgressBudget) {
+  addTransaction(1, {kRootNodeId, false, 7});
+  addTransaction(3, {kRootNodeId, false, 15});
+
+  // Unconstrained, the streams split the connection by weight
+  nextEgress();
+  EXPECT_EQ(nodes_, IDList({{3, 66}, {1, 33}}));
+
+  // Exhaust stream 3's subtree budget; only stream 1 is schedulable even
+  // though stream 3 has the higher weight
+  q_.setSubtreeEgressBudget(handles_[3], 100 /* Bps */, 1000 /* burst */);
+  q_.consumeEgressBudget(3, 100000);
+  nextEgress();
+  EXPECT_EQ(nodes_, IDList({{1, 33}}));
+  EXPECT_GT(q_.getAndResetBudgetThrottleCount(), 0);
+
+  // With no competing traffic the throttled subtree still egresses
+  signalEgress(1, false);
+  nextEgress();
+  EXPECT_EQ(nodes_, IDList({{3, 100}}));
+
+  // Clearing the budget restores weight-only scheduling
+  signalEgress(1, true);
+  q_.clearSubtreeEgressBudget(handles_[3]);
+  nextEgress();
+  EXPECT_EQ(nodes_, IDList({{3, 66}, {1, 33}}));
+}
+
 TEST_F(QueueTest, ExclusiveAdd) {
   buildSimpleTree();
 
@@ -0,0 +1,69 @@
+/*
+ *  Copyright (c) 2015-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include <map>
+#include <string>
+
+#include <folly/portability/GTest.h>
+#include <proxygen/lib/http/codec/compress/HPACKCodec.h>
+#include <proxygen/lib/http/codec/compress/test/TestStreamingCallback.h>
+#include <proxygen/lib/http/session/HTTPCannedResponseCache.h>
+
+using namespace proxygen;
+
+TEST(HTTPCannedResponseCacheTest, Http1Bytes) {
+  auto& cache = HTTPCannedResponseCache::getInstance();
+  auto buf = cache.getHTTP1Response(503);
+  ASSERT_NE(nullptr, buf);
+  EXPECT_EQ(
+      "HTTP/1.1 503 Service Unavailable\r\n"
+      "Connection: close\r\n"
+      "Content-Length: 0\r\n\r\n",
+      buf->moveToFbString().toStdString());
+
+  // Repeat hits share the cached buffer rather than re-serializing
+  auto again = cache.getHTTP1Response(503);
+  EXPECT_EQ(buf->buffer(), again->buffer());
+}
+
+TEST(HTTPCannedResponseCacheTest, Http2BlockIsStaticOnly) {
+  auto& cache = HTTPCannedResponseCache::getInstance();
+  auto block = cache.getHTTP2HeaderBlock(503);
+  ASSERT_NE(nullptr, block);
+
+  // A fresh decoder with an untouched dynamic table must accept the block
+  HPACKCodec decoder(TransportDirection::UPSTREAM);
+  TestStreamingCallback cb;
+  folly::io::Cursor cursor(block.get());
+  decoder.decodeStreaming(cursor, block->computeChainDataLength(), &cb);
+  auto result = cb.getResult();
+  ASSERT_FALSE(result.hasError());
+  std::map<std::string, std::string> decoded;
+  for (size_t i = 0; i + 1 < result->headers.size(); i += 2) {
+    decoded.emplace(result->headers[i].str.str(),
+                    result->headers[i + 1].str.str());
+  }
+  EXPECT_EQ("503", decoded[":status"]);
+  EXPECT_EQ("0", decoded["content-length"]);
+}
+
+TEST(HTTPCannedResponseCacheTest, Http2FrameWrite) {
+  auto& cache = HTTPCannedResponseCache::getInstance();
+  folly::IOBufQueue writeBuf{folly::IOBufQueue::cacheChainLength()};
+  auto written = cache.writeHTTP2Response(writeBuf, 7, 404);
+  EXPECT_GT(written, 0);
+  EXPECT_EQ(written, writeBuf.chainLength());
+}
+
+TEST(HTTPCannedResponseCacheTest, HQBlock) {
+  auto& cache = HTTPCannedResponseCache::getInstance();
+  auto block = cache.getHQHeaderBlock(500);
+  ASSERT_NE(nullptr, block);
+  EXPECT_GT(block->computeChainDataLength(), 0);
+}
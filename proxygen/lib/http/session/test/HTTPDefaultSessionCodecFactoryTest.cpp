@@ -100,6 +100,23 @@ TEST(HTTPDefaultSessionCodecFactoryTest, GetCodecUpgradeProtocols) {
   EXPECT_TRUE(downstreamCodec->getAllowedUpgradeProtocols().empty());
 }
 
+TEST(HTTPDefaultSessionCodecFactoryTest, UpdateCodecConfig) {
+  AcceptorConfiguration conf;
+  HTTPDefaultSessionCodecFactory factory(conf);
+
+  auto codec =
+      factory.getCodec("", TransportDirection::DOWNSTREAM, false /* isTLS */);
+  EXPECT_NE(dynamic_cast<HTTP1xCodec*>(codec.get()), nullptr);
+
+  // Swap in a snapshot forcing h2c; only codecs constructed afterwards
+  // see the new config
+  conf.plaintextProtocol = "h2c";
+  factory.updateCodecConfig(CodecConfig::fromAcceptorConfiguration(conf));
+  codec =
+      factory.getCodec("", TransportDirection::DOWNSTREAM, false /* isTLS */);
+  EXPECT_NE(dynamic_cast<HTTP2Codec*>(codec.get()), nullptr);
+}
+
 TEST(HTTPDefaultSessionCodecFactoryTest, GetCodec) {
   AcceptorConfiguration conf;
   HTTPDefaultSessionCodecFactory factory(conf);
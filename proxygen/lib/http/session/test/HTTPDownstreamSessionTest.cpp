@@ -540,6 +540,57 @@ TEST_F(HTTPDownstreamSessionTest, Http10NoHeadersEof) {
   flushRequestsAndLoop(true, milliseconds(0));
 }
 
+namespace {
+// Routes requests for a single path to a pre-resolved handler and
+// declines everything else.
+class PathRequestRouter : public HTTPSessionBase::RequestRouter {
+ public:
+  PathRequestRouter(std::string path, HTTPTransaction::Handler* handler)
+      : path_(std::move(path)), handler_(handler) {
+  }
+
+  HTTPTransaction::Handler* matchRoute(folly::StringPiece /*method*/,
+                                       folly::StringPiece /*authority*/,
+                                       folly::StringPiece path,
+                                       const HTTPMessage& /*msg*/) override {
+    return path == path_ ? handler_ : nullptr;
+  }
+
+ private:
+  std::string path_;
+  HTTPTransaction::Handler* handler_;
+};
+} // namespace
+
+TEST_F(HTTPDownstreamSessionTest, RequestRouter) {
+  // A matching route bypasses the controller entirely; the StrictMock
+  // controller would flag an unexpected getRequestHandler call.
+  NiceMock<MockHTTPHandler> routedHandler;
+  PathRequestRouter router("/routed", &routedHandler);
+  httpSession_->setRequestRouter(&router);
+
+  EXPECT_CALL(routedHandler, setTransaction(_))
+      .WillOnce(SaveArg<0>(&routedHandler.txn_));
+  routedHandler.expectHeaders([&](std::shared_ptr<HTTPMessage> msg) {
+    EXPECT_EQ("/routed", msg->getPath());
+  });
+  routedHandler.expectEOM([&] { routedHandler.sendReplyWithBody(200, 100); });
+  routedHandler.expectDetachTransaction();
+
+  // An unmatched path falls through to the controller as before
+  auto handler = addSimpleNiceHandler();
+  handler->expectHeaders([&](std::shared_ptr<HTTPMessage> msg) {
+    EXPECT_EQ("/other", msg->getPath());
+  });
+  handler->expectEOM([&] { handler->terminate(); });
+  handler->expectDetachTransaction();
+  expectDetachSession();
+
+  sendRequest("/routed");
+  sendRequest("/other");
+  flushRequestsAndLoop(true, milliseconds(0));
+}
+
 TEST_F(HTTPDownstreamSessionTest, SingleBytes) {
   InSequence enforceOrder;
 
@@ -1982,6 +2033,69 @@ TEST_F(HTTPDownstreamSessionTest, BodyPacketization) {
   EXPECT_EQ(transport_->getWriteEvents()->size(), 1);
 }
 
+TEST_F(HTTPDownstreamSessionTest, DynamicTlsRecordSizing) {
+  // With dynamic record sizing the session chunks its egress, so even a
+  // contiguous 32KB body reaches the transport as iovecs no larger than
+  // the initial record size; each iovec bounds one TLS record
+  constexpr size_t kInitialRecordSize = 2 * 1448;
+  httpSession_->setDynamicTLSRecordSizing(true);
+
+  HTTPMessage req = getGetRequest();
+  req.setHTTPVersion(1, 0);
+  req.setWantsKeepalive(false);
+  sendRequest(req);
+
+  InSequence handlerSequence;
+  auto handler1 = addSimpleNiceHandler();
+  handler1->expectHeaders();
+  handler1->expectEOM([&handler1] { handler1->sendReplyWithBody(200, 32768); });
+  handler1->expectDetachTransaction();
+
+  expectDetachSession();
+
+  HTTPSession::DestructorGuard g(httpSession_);
+  flushRequestsAndLoop();
+
+  for (const auto& event : *transport_->getWriteEvents()) {
+    for (size_t i = 0; i < event->getCount(); i++) {
+      EXPECT_LE(event->getIoVec()[i].iov_len, kInitialRecordSize);
+    }
+  }
+}
+
+TEST_F(HTTPDownstreamSessionTest, EgressPacing) {
+  // With pacing enabled a 64KB response reaches the transport in
+  // bucket-sized chunks released off the timer wheel, not one line-rate
+  // burst
+  constexpr uint64_t kBurst = 8192;
+  httpSession_->setEgressPacing(1000 * 1000 /* bytes per sec */, kBurst);
+
+  HTTPMessage req = getGetRequest();
+  req.setHTTPVersion(1, 0);
+  req.setWantsKeepalive(false);
+  sendRequest(req);
+
+  InSequence handlerSequence;
+  auto handler1 = addSimpleNiceHandler();
+  handler1->expectHeaders();
+  handler1->expectEOM([&handler1] { handler1->sendReplyWithBody(200, 65536); });
+  handler1->expectDetachTransaction();
+
+  expectDetachSession();
+
+  HTTPSession::DestructorGuard g(httpSession_);
+  flushRequestsAndLoop();
+
+  EXPECT_GT(transport_->getWriteEvents()->size(), 1);
+  for (const auto& event : *transport_->getWriteEvents()) {
+    size_t len = 0;
+    for (size_t i = 0; i < event->getCount(); i++) {
+      len += event->getIoVec()[i].iov_len;
+    }
+    EXPECT_LE(len, kBurst);
+  }
+}
+
 TEST_F(HTTPDownstreamSessionTest, HttpMalformedPkt1) {
   // Create a HTTP connection and keep sending just '\n' to the HTTP1xCodec.
   std::string data(90000, '\n');
@@ -3302,6 +3416,64 @@ TEST_F(HTTP2DownstreamSessionTest, TestDisablePriorities) {
   eventBase_.loop();
 }
 
+// Smoke test for pipelined transport writes: with several writeChain
+// submissions allowed in flight, a response spanning multiple write loops
+// still egresses completely and in order
+TEST_F(HTTP2DownstreamSessionTest, PipelinedWrites) {
+  httpSession_->setMaxConcurrentOutgoingWrites(4);
+
+  auto handler = addSimpleStrictHandler();
+  handler->expectHeaders();
+  handler->expectEOM([&handler] { handler->sendReplyWithBody(200, 32 * 1024); });
+  handler->expectDetachTransaction();
+
+  sendRequest();
+  flushRequestsAndLoop();
+  httpSession_->closeWhenIdle();
+  expectDetachSession();
+  eventBase_.loop();
+}
+
+TEST_F(HTTP2DownstreamSessionTest, TestDeadlineEgressScheduler) {
+  httpSession_->setEgressScheduler(HTTPSessionBase::EgressScheduler::DEADLINE);
+
+  // Both txn's are at equal pri=16
+  auto id1 = sendRequest();
+  auto id2 = sendRequest();
+
+  auto handler1 = addSimpleStrictHandler();
+  handler1->expectHeaders();
+  handler1->expectEOM([&] { handler1->sendReplyWithBody(200, 4 * 1024); });
+  auto handler2 = addSimpleStrictHandler();
+  handler2->expectHeaders();
+  handler2->expectEOM([&] {
+    handler2->txn_->setEgressDeadline(std::chrono::milliseconds(10));
+    handler2->sendReplyWithBody(200, 4 * 1024);
+  });
+
+  handler1->expectDetachTransaction();
+  handler2->expectDetachTransaction();
+  flushRequestsAndLoop();
+
+  // The deadline transaction's body egresses ahead of the earlier,
+  // equal-priority one, which would otherwise share each write
+  InSequence enforceOrder;
+  EXPECT_CALL(callbacks_, onSettings(_));
+  EXPECT_CALL(callbacks_, onMessageBegin(id1, _));
+  EXPECT_CALL(callbacks_, onHeadersComplete(id1, _));
+  EXPECT_CALL(callbacks_, onMessageBegin(id2, _));
+  EXPECT_CALL(callbacks_, onHeadersComplete(id2, _));
+  EXPECT_CALL(callbacks_, onBody(id2, _, _)).WillOnce(ExpectBodyLen(4 * 1024));
+  EXPECT_CALL(callbacks_, onMessageComplete(id2, _));
+  EXPECT_CALL(callbacks_, onBody(id1, _, _)).WillOnce(ExpectBodyLen(4 * 1024));
+  EXPECT_CALL(callbacks_, onMessageComplete(id1, _));
+  parseOutput(*clientCodec_);
+
+  httpSession_->closeWhenIdle();
+  expectDetachSession();
+  eventBase_.loop();
+}
+
 TEST_F(HTTP2DownstreamSessionTest, TestPriorityWeights) {
   // virtual priority node with pri=4
   auto priGroupID = clientCodec_->createStream();
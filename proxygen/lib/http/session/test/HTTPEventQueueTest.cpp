@@ -0,0 +1,72 @@
+/*
+ *  Copyright (c) 2015-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include <folly/io/IOBuf.h>
+#include <folly/portability/GTest.h>
+#include <proxygen/lib/http/HTTPMessage.h>
+#include <proxygen/lib/http/session/HTTPEvent.h>
+
+using namespace proxygen;
+
+TEST(HTTPEventQueueTest, FifoOrder) {
+  HTTPEventQueue queue;
+  EXPECT_TRUE(queue.empty());
+
+  queue.emplace(1, HTTPEvent::Type::MESSAGE_BEGIN);
+  queue.emplace(1, HTTPEvent::Type::HEADERS_COMPLETE,
+                std::make_unique<HTTPMessage>());
+  queue.emplace(1, HTTPEvent::Type::BODY,
+                folly::IOBuf::copyBuffer("hello"));
+  queue.emplace(1, HTTPEvent::Type::MESSAGE_COMPLETE);
+  EXPECT_EQ(4, queue.size());
+
+  EXPECT_EQ(HTTPEvent::Type::MESSAGE_BEGIN, queue.front().getEvent());
+  queue.pop();
+  EXPECT_EQ(HTTPEvent::Type::HEADERS_COMPLETE, queue.front().getEvent());
+  EXPECT_NE(nullptr, queue.front().getHeaders());
+  queue.pop();
+  auto body = queue.front().getBody();
+  ASSERT_NE(nullptr, body);
+  EXPECT_EQ("hello", body->moveToFbString().toStdString());
+  queue.pop();
+  EXPECT_EQ(HTTPEvent::Type::MESSAGE_COMPLETE, queue.front().getEvent());
+  queue.pop();
+  EXPECT_TRUE(queue.empty());
+}
+
+TEST(HTTPEventQueueTest, GrowWhileWrapped) {
+  HTTPEventQueue queue;
+  // Advance head so the ring is wrapped when it doubles
+  for (uint32_t i = 0; i < 12; i++) {
+    queue.emplace(i, HTTPEvent::Type::MESSAGE_BEGIN);
+  }
+  for (uint32_t i = 0; i < 8; i++) {
+    EXPECT_EQ(i, queue.front().getStreamID());
+    queue.pop();
+  }
+  for (uint32_t i = 12; i < 100; i++) {
+    queue.emplace(i, HTTPEvent::Type::BODY,
+                  folly::IOBuf::copyBuffer("chunk"));
+  }
+  for (uint32_t i = 8; i < 100; i++) {
+    EXPECT_EQ(i, queue.front().getStreamID());
+    queue.pop();
+  }
+  EXPECT_TRUE(queue.empty());
+}
+
+TEST(HTTPEventQueueTest, DestructorReleasesPending) {
+  // Events still queued at destruction time must have their payloads freed
+  HTTPEventQueue queue;
+  for (uint32_t i = 0; i < 40; i++) {
+    queue.emplace(i, HTTPEvent::Type::BODY,
+                  folly::IOBuf::copyBuffer("leftover"));
+  }
+  EXPECT_EQ(40, queue.size());
+}
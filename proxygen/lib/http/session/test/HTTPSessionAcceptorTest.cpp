@@ -167,6 +167,58 @@ TEST_F(HTTPSessionAcceptorTestNPNJunk, Npn) {
   EXPECT_EQ(acceptor_->sessionCreationErrors_, 1);
 }
 
+// Verify admission control sheds connections past the session cap
+TEST_F(HTTPSessionAcceptorTestNPN, AdmissionControlSessionCap) {
+  acceptor_->expectedProto_ = "http/1.1";
+  acceptor_->setAdmissionControl(std::chrono::microseconds(0),
+                                 1 /* maxSessions */,
+                                 HTTPSessionAcceptor::ShedPolicy::RESET);
+  SocketAddress clientAddress;
+  wangle::TransportInfo tinfo;
+  AsyncSocket::UniquePtr sock1(new AsyncSocket(&eventBase_));
+  acceptor_->connectionReady(
+      std::move(sock1), clientAddress, "", SecureTransportType::NONE, tinfo);
+  EXPECT_EQ(acceptor_->sessionsCreated_, 1);
+  EXPECT_TRUE(acceptor_->isOverloaded());
+
+  // At the cap: the next connection gets reset instead of accepted
+  AsyncSocket::UniquePtr sock2(new AsyncSocket(&eventBase_));
+  acceptor_->connectionReady(
+      std::move(sock2), clientAddress, "", SecureTransportType::NONE, tinfo);
+  EXPECT_EQ(acceptor_->sessionsCreated_, 1);
+}
+
+// Verify affinity tokens surface to the consumer before session creation
+TEST_F(HTTPSessionAcceptorTestNPN, AffinityTokenSurfacedAtAccept) {
+  class FixedTokenExtractor
+      : public HTTPSessionAcceptor::AffinityTokenExtractor {
+   public:
+    folly::Optional<std::string> getToken(
+        const folly::AsyncTransportWrapper& /*sock*/,
+        const wangle::TransportInfo& /*tinfo*/) noexcept override {
+      return std::string("pop7/worker3");
+    }
+  };
+
+  acceptor_->expectedProto_ = "http/1.1";
+  acceptor_->setAffinityTokenExtractor(
+      std::make_unique<FixedTokenExtractor>());
+  std::vector<std::string> tokens;
+  acceptor_->setAffinityTokenConsumer(
+      [&](const SocketAddress& /*clientAddr*/, const std::string& token) {
+        tokens.push_back(token);
+      });
+
+  AsyncSocket::UniquePtr sock(new AsyncSocket(&eventBase_));
+  SocketAddress clientAddress;
+  wangle::TransportInfo tinfo;
+  acceptor_->connectionReady(
+      std::move(sock), clientAddress, "", SecureTransportType::NONE, tinfo);
+  EXPECT_EQ(acceptor_->sessionsCreated_, 1);
+  ASSERT_EQ(tokens.size(), 1);
+  EXPECT_EQ(tokens[0], "pop7/worker3");
+}
+
 TEST_F(HTTPSessionAcceptorTestNPN, AcceptorConfigCapture) {
   newAcceptor();
   config_.reset();
@@ -0,0 +1,233 @@
+/*
+ *  Copyright (c) 2015-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include <folly/Benchmark.h>
+#include <folly/io/IOBuf.h>
+#include <folly/portability/GFlags.h>
+#include <proxygen/lib/http/codec/HTTP2Codec.h>
+#include <proxygen/lib/http/session/HTTP2PriorityQueue.h>
+#include <proxygen/lib/http/session/HTTPTransaction.h>
+
+using namespace proxygen;
+
+namespace {
+
+/**
+ * Deliberately gmock-free no-op transport/handler so the benchmark binary
+ * measures HTTPTransaction itself.  Run it under
+ * `valgrind --tool=cachegrind` to validate the hot/cold member layout:
+ * D1 misses attributed to HTTPTransaction members should stay confined to
+ * the hot block.
+ */
+class BenchTransport : public HTTPTransaction::Transport {
+ public:
+  void pauseIngress(HTTPTransaction*) noexcept override {
+  }
+  void resumeIngress(HTTPTransaction*) noexcept override {
+  }
+  void transactionTimeout(HTTPTransaction*) noexcept override {
+  }
+  void sendHeaders(HTTPTransaction*,
+                   const HTTPMessage&,
+                   HTTPHeaderSize*,
+                   bool) noexcept override {
+  }
+  size_t sendBody(HTTPTransaction*,
+                  std::unique_ptr<folly::IOBuf> body,
+                  bool,
+                  bool) noexcept override {
+    return body ? body->computeChainDataLength() : 0;
+  }
+  size_t sendChunkHeader(HTTPTransaction*, size_t) noexcept override {
+    return 0;
+  }
+  size_t sendChunkTerminator(HTTPTransaction*) noexcept override {
+    return 0;
+  }
+  size_t sendEOM(HTTPTransaction*, const HTTPHeaders*) noexcept override {
+    return 0;
+  }
+  size_t sendAbort(HTTPTransaction*, ErrorCode) noexcept override {
+    return 0;
+  }
+  size_t sendPriority(HTTPTransaction*,
+                      const http2::PriorityUpdate&) noexcept override {
+    return 0;
+  }
+  size_t sendWindowUpdate(HTTPTransaction*, uint32_t) noexcept override {
+    return 0;
+  }
+  void notifyPendingEgress() noexcept override {
+  }
+  void detach(HTTPTransaction*) noexcept override {
+  }
+  void notifyIngressBodyProcessed(uint32_t) noexcept override {
+  }
+  void notifyEgressBodyBuffered(int64_t) noexcept override {
+  }
+  const folly::SocketAddress& getLocalAddress() const noexcept override {
+    return addr_;
+  }
+  const folly::SocketAddress& getPeerAddress() const noexcept override {
+    return addr_;
+  }
+  void describe(std::ostream&) const override {
+  }
+  const wangle::TransportInfo& getSetupTransportInfo() const
+      noexcept override {
+    return tinfo_;
+  }
+  bool getCurrentTransportInfo(wangle::TransportInfo*) override {
+    return false;
+  }
+  Type getSessionType() const noexcept override {
+    return Type::TCP;
+  }
+  const HTTPCodec& getCodec() const noexcept override {
+    return codec_;
+  }
+  void drain() override {
+  }
+  bool isDraining() const override {
+    return false;
+  }
+  HTTPTransaction* newPushedTransaction(
+      HTTPCodec::StreamID, HTTPTransaction::PushHandler*) noexcept override {
+    return nullptr;
+  }
+  HTTPTransaction* newExTransaction(HTTPTransaction::Handler*,
+                                    HTTPCodec::StreamID,
+                                    bool) noexcept override {
+    return nullptr;
+  }
+  std::string getSecurityProtocol() const override {
+    return "";
+  }
+  void addWaitingForReplaySafety(
+      folly::AsyncTransport::ReplaySafetyCallback*) noexcept override {
+  }
+  void removeWaitingForReplaySafety(
+      folly::AsyncTransport::ReplaySafetyCallback*) noexcept override {
+  }
+  bool needToBlockForReplaySafety() const override {
+    return false;
+  }
+  const folly::AsyncTransportWrapper* getUnderlyingTransport() const
+      noexcept override {
+    return nullptr;
+  }
+  bool isReplaySafe() const override {
+    return true;
+  }
+  void setHTTP2PrioritiesEnabled(bool) override {
+  }
+  bool getHTTP2PrioritiesEnabled() const override {
+    return false;
+  }
+  folly::Optional<const HTTPMessage::HTTPPriority> getHTTPPriority(
+      uint8_t) override {
+    return folly::none;
+  }
+
+ private:
+  folly::SocketAddress addr_;
+  wangle::TransportInfo tinfo_;
+  HTTP2Codec codec_{TransportDirection::DOWNSTREAM};
+};
+
+class BenchHandler : public HTTPTransactionHandler {
+ public:
+  void setTransaction(HTTPTransaction*) noexcept override {
+  }
+  void detachTransaction() noexcept override {
+  }
+  void onHeadersComplete(std::unique_ptr<HTTPMessage>) noexcept override {
+  }
+  void onBody(std::unique_ptr<folly::IOBuf> chain) noexcept override {
+    bodyBytes += chain->computeChainDataLength();
+  }
+  void onTrailers(std::unique_ptr<HTTPHeaders>) noexcept override {
+  }
+  void onEOM() noexcept override {
+  }
+  void onUpgrade(UpgradeProtocol) noexcept override {
+  }
+  void onError(const HTTPException&) noexcept override {
+  }
+  void onEgressPaused() noexcept override {
+  }
+  void onEgressResumed() noexcept override {
+  }
+
+  uint64_t bodyBytes{0};
+};
+
+std::unique_ptr<HTTPMessage> makeRequest() {
+  auto req = std::make_unique<HTTPMessage>();
+  req->setHTTPVersion(1, 1);
+  req->setMethod(HTTPMethod::GET);
+  req->setURL("/");
+  return req;
+}
+
+} // namespace
+
+/**
+ * The per-chunk ingress path: every onIngressBody lands in the hot block
+ * (state machines, flow control off, body offset, timeout refresh).
+ */
+BENCHMARK(transactionIngressBody, iters) {
+  folly::BenchmarkSuspender suspender;
+  BenchTransport transport;
+  BenchHandler handler;
+  HTTP2PriorityQueue egressQueue;
+  HTTPTransaction txn(TransportDirection::DOWNSTREAM,
+                      HTTPCodec::StreamID(1),
+                      1,
+                      transport,
+                      egressQueue);
+  txn.setHandler(&handler);
+  txn.onIngressHeadersComplete(makeRequest());
+  auto chunk = folly::IOBuf::create(4096);
+  chunk->append(4096);
+  suspender.dismiss();
+
+  for (size_t i = 0; i < iters; i++) {
+    txn.onIngressBody(chunk->clone(), 0);
+  }
+
+  suspender.rehire();
+  txn.onIngressEOM();
+}
+
+/**
+ * Construction/teardown churn: exercises the ColdFields node pool and
+ * the priority queue linkage.
+ */
+BENCHMARK(transactionChurn, iters) {
+  folly::BenchmarkSuspender suspender;
+  BenchTransport transport;
+  HTTP2PriorityQueue egressQueue;
+  suspender.dismiss();
+
+  for (size_t i = 0; i < iters; i++) {
+    HTTPTransaction txn(TransportDirection::DOWNSTREAM,
+                        HTTPCodec::StreamID(2 * i + 1),
+                        i,
+                        transport,
+                        egressQueue);
+    folly::doNotOptimizeAway(&txn);
+  }
+}
+
+int main(int argc, char** argv) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  folly::runBenchmarks();
+  return 0;
+}
@@ -120,6 +120,18 @@ TEST_F(EgressStateMachineFixture, NormalEgressTransitionsWithTrailers) {
   follow(HTTPTransactionEgressSM::Event::eomFlushed);
 }
 
+TEST_F(EgressStateMachineFixture, DeferredTrailerEgressTransitions) {
+  // gRPC style: trailers reserved right after headers, body streamed
+  // afterwards, final trailer values set just before EOM
+  follow(HTTPTransactionEgressSM::Event::sendHeaders);
+  follow(HTTPTransactionEgressSM::Event::sendTrailers);
+  follow(HTTPTransactionEgressSM::Event::sendBody);
+  follow(HTTPTransactionEgressSM::Event::sendBody);
+  follow(HTTPTransactionEgressSM::Event::sendTrailers);
+  follow(HTTPTransactionEgressSM::Event::sendEOM);
+  follow(HTTPTransactionEgressSM::Event::eomFlushed);
+}
+
 TEST_F(EgressStateMachineFixture, WeirdEgressTransitions) {
   follow(HTTPTransactionEgressSM::Event::sendHeaders);
   follow(HTTPTransactionEgressSM::Event::sendTrailers);
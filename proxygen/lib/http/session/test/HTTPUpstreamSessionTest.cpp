@@ -1130,6 +1130,69 @@ void HTTPUpstreamTest<CodecPair>::testBasicRequestHttp10(bool keepalive) {
   }
 }
 
+TEST_F(HTTPUpstreamSessionTest, PipelinedRequests) {
+  httpSession_->enablePipelining(2);
+
+  auto handler1 = openTransaction();
+  handler1->sendRequest();
+  // Request 1 is still buffered, so a second transaction is refused
+  EXPECT_EQ(httpSession_->newTransaction(handler1.get()), nullptr);
+  eventBase_.loopOnce();
+
+  // Request 1 is on the wire; request 2 can pipeline behind it even
+  // though no response has arrived yet
+  EXPECT_TRUE(httpSession_->isReusable());
+  auto handler2 = openTransaction();
+  handler2->sendRequest();
+  EXPECT_EQ(httpSession_->getNumOutgoingStreams(), 2);
+  eventBase_.loopOnce();
+
+  InSequence enforceOrder;
+  handler1->expectHeaders([&](std::shared_ptr<HTTPMessage> msg) {
+    EXPECT_EQ(200, msg->getStatusCode());
+  });
+  handler1->expectEOM();
+  handler1->expectDetachTransaction();
+  handler2->expectHeaders([&](std::shared_ptr<HTTPMessage> msg) {
+    EXPECT_EQ(200, msg->getStatusCode());
+  });
+  handler2->expectEOM();
+  handler2->expectDetachTransaction();
+
+  // Both responses come back on one read, demultiplexed in order
+  readAndLoop(
+      "HTTP/1.1 200 OK\r\n"
+      "Transfer-Encoding: chunked\r\n\r\n"
+      "0\r\n\r\n"
+      "HTTP/1.1 200 OK\r\n"
+      "Transfer-Encoding: chunked\r\n\r\n"
+      "0\r\n\r\n");
+
+  EXPECT_EQ(httpSession_->getNumOutgoingStreams(), 0);
+  httpSession_->destroy();
+}
+
+TEST_F(HTTPUpstreamSessionTest, PipelinedErrorClosesQueuedTransactions) {
+  httpSession_->enablePipelining(2);
+
+  auto handler1 = openTransaction();
+  handler1->sendRequest();
+  eventBase_.loopOnce();
+  auto handler2 = openTransaction();
+  handler2->sendRequest();
+  eventBase_.loopOnce();
+
+  // A garbled response loses framing for everything queued behind it, so
+  // both transactions error out and the connection closes
+  handler1->expectError();
+  handler1->expectDetachTransaction();
+  handler2->expectError();
+  handler2->expectDetachTransaction();
+
+  readAndLoop("dudes where's my body?\r\n\r\n");
+  EXPECT_EQ(sessionDestroyed_, true);
+}
+
 TEST_F(HTTPUpstreamSessionTest, Http10Keepalive) {
   testBasicRequestHttp10(true);
   testBasicRequestHttp10(false);
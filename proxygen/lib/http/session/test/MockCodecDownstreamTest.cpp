@@ -10,6 +10,7 @@
 #include <boost/optional/optional_io.hpp>
 #include <fizz/record/Extensions.h>
 #include <fizz/record/Types.h>
+#include <folly/ScopeGuard.h>
 #include <folly/io/Cursor.h>
 #include <folly/io/async/EventBase.h>
 #include <folly/io/async/TimeoutManager.h>
@@ -1313,6 +1314,117 @@ TEST_F(MockCodecDownstreamTest, SendGoawayIdle) {
   testGoaway(false, false);
 }
 
+TEST_F(MockCodecDownstreamTest, ShedExpiredRequestDeadline) {
+  // A request arriving with its time budget already spent gets a 504
+  // straight from the session; the controller is never consulted.
+  HTTPTransaction::setDeadlineHeaderName("x-request-budget-ms");
+  SCOPE_EXIT {
+    HTTPTransaction::setDeadlineHeaderName("");
+  };
+
+  fakeMockCodec(*codec_);
+
+  EXPECT_CALL(mockController_, getRequestHandler(_, _)).Times(0);
+
+  uint16_t shedStatus = 0;
+  EXPECT_CALL(*codec_, generateHeader(_, 1, _, _, _))
+      .WillOnce(Invoke([&](folly::IOBufQueue& writeBuf,
+                           HTTPCodec::StreamID,
+                           const HTTPMessage& msg,
+                           bool,
+                           HTTPHeaderSize*) {
+        shedStatus = msg.getStatusCode();
+        writeBuf.append(makeBuf(10));
+      }));
+
+  auto req = makeGetRequest();
+  req->getHeaders().add("x-request-budget-ms", "0");
+  codecCallback_->onMessageBegin(HTTPCodec::StreamID(1), req.get());
+  codecCallback_->onHeadersComplete(HTTPCodec::StreamID(1), std::move(req));
+  codecCallback_->onMessageComplete(HTTPCodec::StreamID(1), false);
+  eventBase_.loop();
+
+  EXPECT_EQ(shedStatus, 504);
+
+  EXPECT_CALL(*codec_, onIngressEOF());
+  EXPECT_CALL(mockController_, detachSession(_));
+  EXPECT_CALL(*transport_, closeNow())
+      .Times(AtLeast(1))
+      .WillOnce(Assign(&transportGood_, false));
+  httpSession_->dropConnection();
+}
+
+TEST_F(MockCodecDownstreamTest, RequestDeadlineRecorded) {
+  // An unspent budget is recorded on the transaction and the request is
+  // dispatched normally.
+  HTTPTransaction::setDeadlineHeaderName("x-request-budget-ms");
+  SCOPE_EXIT {
+    HTTPTransaction::setDeadlineHeaderName("");
+  };
+
+  NiceMock<MockHTTPHandler> handler;
+  fakeMockCodec(*codec_);
+
+  EXPECT_CALL(mockController_, getRequestHandler(_, _))
+      .WillOnce(Return(&handler));
+  EXPECT_CALL(handler, setTransaction(_))
+      .WillOnce(
+          Invoke([&handler](HTTPTransaction* txn) { handler.txn_ = txn; }));
+  EXPECT_CALL(handler, onHeadersComplete(_))
+      .WillOnce(InvokeWithoutArgs([&handler] {
+        EXPECT_TRUE(handler.txn_->getRequestDeadline().hasValue());
+        EXPECT_FALSE(handler.txn_->isRequestDeadlineExpired());
+        handler.sendReplyWithBody(200, 100);
+      }));
+
+  auto req = makeGetRequest();
+  req->getHeaders().add("x-request-budget-ms", "300000");
+  codecCallback_->onMessageBegin(HTTPCodec::StreamID(1), req.get());
+  codecCallback_->onHeadersComplete(HTTPCodec::StreamID(1), std::move(req));
+  codecCallback_->onMessageComplete(HTTPCodec::StreamID(1), false);
+  eventBase_.loop();
+
+  EXPECT_CALL(*codec_, onIngressEOF());
+  EXPECT_CALL(mockController_, detachSession(_));
+  EXPECT_CALL(*transport_, closeNow())
+      .Times(AtLeast(1))
+      .WillOnce(Assign(&transportGood_, false));
+  httpSession_->dropConnection();
+}
+
+TEST_F(MockCodecDownstreamTest, AdaptiveReadWindow) {
+  // Codec consumes everything it is given
+  EXPECT_CALL(*codec_, onIngress(_))
+      .WillRepeatedly(
+          Invoke([](const IOBuf& buf) { return buf.computeChainDataLength(); }));
+
+  void* buf;
+  size_t initialSize = 0;
+  size_t grownSize = 0;
+  size_t shrunkSize = 0;
+  transportCb_->getReadBuffer(&buf, &initialSize);
+  // A read that fills the window doubles the next reservation
+  transportCb_->readDataAvailable(initialSize);
+  transportCb_->getReadBuffer(&buf, &grownSize);
+  EXPECT_GT(grownSize, initialSize);
+  // A run of sub-MSS reads steps the window back down
+  transportCb_->readDataAvailable(1);
+  for (int i = 0; i < 2; i++) {
+    size_t ignored = 0;
+    transportCb_->getReadBuffer(&buf, &ignored);
+    transportCb_->readDataAvailable(1);
+  }
+  transportCb_->getReadBuffer(&buf, &shrunkSize);
+  EXPECT_LT(shrunkSize, grownSize);
+
+  EXPECT_CALL(*codec_, onIngressEOF());
+  EXPECT_CALL(mockController_, detachSession(_));
+  EXPECT_CALL(*transport_, closeNow())
+      .Times(AtLeast(1))
+      .WillOnce(Assign(&transportGood_, false));
+  httpSession_->dropConnection();
+}
+
 TEST_F(MockCodecDownstreamTest, DropConnection) {
   NiceMock<MockHTTPHandler> handler;
   MockHTTPHandler pushHandler;
@@ -30,7 +30,8 @@ TLConnectionStats::TLConnectionStats(const std::string& prefix)
                      95,
                      99),
       currConns_(prefix + "_conn"),
-      newConns_(prefix + "_new_conn", SUM, RATE) {
+      newConns_(prefix + "_new_conn", SUM, RATE),
+      shedConns_(prefix + "_shed_conn", SUM, RATE) {
 }
 
 void TLConnectionStats::recordConnectionOpen() {
@@ -42,6 +43,10 @@ void TLConnectionStats::recordConnectionClose() {
   currConns_.incrementValue(-1);
 }
 
+void TLConnectionStats::recordConnectionShed() {
+  shedConns_.add(1);
+}
+
 void TLConnectionStats::recordRequest() {
   req_.add(1);
 }
@@ -27,6 +27,11 @@ class ConnectionStats {
 
   virtual void recordConnectionClose() = 0;
 
+  /**
+   * A new connection was refused by acceptor admission control.
+   */
+  virtual void recordConnectionShed() = 0;
+
   virtual void recordRequest() = 0;
 
   virtual void recordResponse(
@@ -55,6 +60,8 @@ class TLConnectionStats : public ConnectionStats {
 
   void recordConnectionClose() override;
 
+  void recordConnectionShed() override;
+
   void recordRequest() override;
 
   void recordResponse(
@@ -82,6 +89,7 @@ class TLConnectionStats : public ConnectionStats {
 
   BaseStats::TLCounter currConns_;
   BaseStats::TLTimeseries newConns_;
+  BaseStats::TLTimeseries shedConns_;
 };
 
 } // namespace proxygen
@@ -0,0 +1,135 @@
+/*
+ *  Copyright (c) 2015-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#pragma once
+
+#include <proxygen/lib/http/session/HTTPSessionStats.h>
+#include <proxygen/lib/utils/ShardedCounter.h>
+
+namespace proxygen {
+
+/**
+ * HTTPSessionStats implementation backed by per-core sharded counters.
+ * Every record* call is a single relaxed atomic add on a core-local
+ * cache line, so sessions on a many-core box never contend or false
+ * share on stats.  An exporter thread reads the counters with value()
+ * or drains period deltas with the counters' collect().
+ *
+ * Unlike TLHTTPSessionStats this keeps no timeseries or histograms;
+ * it is for deployments that export deltas to an external pipeline and
+ * only need the raw event counts.
+ */
+class ShardedHTTPSessionStats : public HTTPSessionStats {
+ public:
+  void recordTransactionOpened() noexcept override {
+    txnsOpen.add();
+    txnsOpened.add();
+  }
+
+  void recordTransactionClosed() noexcept override {
+    txnsOpen.sub();
+  }
+
+  void recordTransactionsServed(uint64_t num) noexcept override {
+    txnsServed.add(num);
+  }
+
+  void recordSessionReused() noexcept override {
+    sessionsReused.add();
+  }
+
+  void recordSessionIdleTime(std::chrono::seconds idleTime) noexcept override {
+    sessionIdleTimeSeconds.add(idleTime.count());
+    sessionIdleEvents.add();
+  }
+
+  void recordTransactionStalled() noexcept override {
+    txnsTransactionStalled.add();
+  }
+
+  void recordSessionStalled() noexcept override {
+    txnsSessionStalled.add();
+  }
+
+  void recordPresendIOSplit() noexcept override {
+    presendIoSplit.add();
+  }
+
+  void recordPresendExceedLimit() noexcept override {
+    presendExceedLimit.add();
+  }
+
+  void recordTTLBAExceedLimit() noexcept override {
+    ttlbaExceedLimit.add();
+  }
+
+  void recordTTLBANotFound() noexcept override {
+    ttlbaNotFound.add();
+  }
+
+  void recordTTLBAReceived() noexcept override {
+    ttlbaReceived.add();
+  }
+
+  void recordTTLBATimeout() noexcept override {
+    ttlbaTimeout.add();
+  }
+
+  void recordTTLBATracked() noexcept override {
+    ttlbaTracked.add();
+  }
+
+  void recordTTBTXExceedLimit() noexcept override {
+    ttbtxExceedLimit.add();
+  }
+
+  void recordTTBTXReceived() noexcept override {
+    ttbtxReceived.add();
+  }
+
+  void recordTTBTXTimeout() noexcept override {
+    ttbtxTimeout.add();
+  }
+
+  void recordTTBTXNotFound() noexcept override {
+    ttbtxNotFound.add();
+  }
+
+  void recordTTBTXTracked() noexcept override {
+    ttbtxTracked.add();
+  }
+
+  void recordEgressWriteBufferFlap() noexcept override {
+    egressWriteBufferFlaps.add();
+  }
+
+  ShardedCounter txnsOpen;
+  ShardedCounter txnsOpened;
+  ShardedCounter txnsServed;
+  ShardedCounter sessionsReused;
+  ShardedCounter sessionIdleTimeSeconds;
+  ShardedCounter sessionIdleEvents;
+  ShardedCounter txnsTransactionStalled;
+  ShardedCounter txnsSessionStalled;
+  ShardedCounter presendIoSplit;
+  ShardedCounter presendExceedLimit;
+  ShardedCounter ttlbaTracked;
+  ShardedCounter ttlbaReceived;
+  ShardedCounter ttlbaTimeout;
+  ShardedCounter ttlbaNotFound;
+  ShardedCounter ttlbaExceedLimit;
+  ShardedCounter ttbtxTracked;
+  ShardedCounter ttbtxReceived;
+  ShardedCounter ttbtxTimeout;
+  ShardedCounter ttbtxNotFound;
+  ShardedCounter ttbtxExceedLimit;
+  ShardedCounter egressWriteBufferFlaps;
+};
+
+} // namespace proxygen
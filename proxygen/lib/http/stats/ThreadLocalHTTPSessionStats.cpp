@@ -9,6 +9,8 @@
  */
 #include "proxygen/lib/http/stats/ThreadLocalHTTPSessionStats.h"
 
+#include <proxygen/lib/http/session/HTTPTransaction.h>
+
 namespace proxygen {
 
 TLHTTPSessionStats::TLHTTPSessionStats(const std::string& prefix)
@@ -24,6 +26,15 @@ TLHTTPSessionStats::TLHTTPSessionStats(const std::string& prefix)
       txnsSessionStalled(prefix + "_txn_session_stall",
                          facebook::fb303::SUM,
                          facebook::fb303::RATE),
+      egressBudgetThrottled(prefix + "_egress_budget_throttled",
+                            facebook::fb303::SUM,
+                            facebook::fb303::RATE),
+      egressPacingDeferred(prefix + "_egress_pacing_deferred",
+                           facebook::fb303::SUM,
+                           facebook::fb303::RATE),
+      egressWriteBufferFlaps(prefix + "_egress_write_buffer_flap",
+                             facebook::fb303::SUM,
+                             facebook::fb303::RATE),
       presendIoSplit(prefix + "_presend_io_split",
                      facebook::fb303::SUM,
                      facebook::fb303::RATE),
@@ -157,4 +168,26 @@ void TLHTTPSessionStats::recordSessionStalled() noexcept {
   txnsSessionStalled.add(1);
 }
 
+void TLHTTPSessionStats::recordEgressBudgetThrottled(
+    uint64_t numSubtrees) noexcept {
+  egressBudgetThrottled.add(numSubtrees);
+}
+
+void TLHTTPSessionStats::recordEgressPacingDeferred() noexcept {
+  egressPacingDeferred.add(1);
+}
+
+void TLHTTPSessionStats::recordEgressWriteBufferFlap() noexcept {
+  egressWriteBufferFlaps.add(1);
+}
+
+void TLHTTPSessionStats::recordTransactionTimings(
+    const HTTPTransactionTimings& timings) noexcept {
+  // Zero means the transaction never sent its EOM (see
+  // HTTPTransactionTimings); only completed transactions count
+  if (timings.egressEomMs > 0) {
+    txnLatencyMs.record(timings.egressEomMs);
+  }
+}
+
 } // namespace proxygen
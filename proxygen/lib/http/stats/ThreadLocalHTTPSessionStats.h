@@ -38,12 +38,20 @@ class TLHTTPSessionStats : public HTTPSessionStats {
   void recordSessionIdleTime(std::chrono::seconds) noexcept override;
   void recordTransactionStalled() noexcept override;
   void recordSessionStalled() noexcept override;
+  void recordEgressBudgetThrottled(uint64_t numSubtrees) noexcept override;
+  void recordEgressPacingDeferred() noexcept override;
+  void recordEgressWriteBufferFlap() noexcept override;
+  void recordTransactionTimings(
+      const HTTPTransactionTimings& timings) noexcept override;
 
   BaseStats::TLCounter txnsOpen;
   BaseStats::TLTimeseries txnsOpened;
   BaseStats::TLTimeseries txnsFromSessionReuse;
   BaseStats::TLTimeseries txnsTransactionStalled;
   BaseStats::TLTimeseries txnsSessionStalled;
+  BaseStats::TLTimeseries egressBudgetThrottled;
+  BaseStats::TLTimeseries egressPacingDeferred;
+  BaseStats::TLTimeseries egressWriteBufferFlaps;
   // Time to Last Byte Ack (TTLBA)
   BaseStats::TLTimeseries presendIoSplit;
   BaseStats::TLTimeseries presendExceedLimit;
@@ -59,6 +67,9 @@ class TLHTTPSessionStats : public HTTPSessionStats {
   BaseStats::TLTimeseries ttbtxExceedLimit;
   BaseStats::TLHistogram txnsPerSession;
   BaseStats::TLHistogram sessionIdleTime;
+  // Ingress headers to egress EOM, in milliseconds; recorded in-process
+  // (see SparseHistogram) rather than via an external histogram service
+  BaseStats::TLSparseHistogram txnLatencyMs;
 };
 
 } // namespace proxygen
@@ -42,17 +42,15 @@ DecodeError StructuredHeadersBuffer::parseItem(StructuredHeaderItem& result) {
 DecodeError StructuredHeadersBuffer::parseNumber(StructuredHeaderItem& result) {
   auto type = StructuredHeaderItem::Type::INT64;
 
-  bool positive = true;
-  std::string input;
-
   if (isEmpty()) {
     return handleDecodeError(DecodeError::UNEXPECTED_END_OF_BUFFER);
   }
 
+  auto tokenStart = content_.begin();
+  bool positive = true;
   if (peek() == '-') {
     advanceCursor();
     positive = false;
-    input.push_back('-');
   }
 
   if (isEmpty()) {
@@ -63,27 +61,27 @@ DecodeError StructuredHeadersBuffer::parseNumber(StructuredHeaderItem& result) {
     return handleDecodeError(DecodeError::INVALID_CHARACTER);
   }
 
-  while (!isEmpty()) {
-    char current = peek();
-    if (std::isdigit(current)) {
-      input.push_back(current);
-      advanceCursor();
-    } else if (type == StructuredHeaderItem::Type::INT64 && current == '.') {
-      type = StructuredHeaderItem::Type::DOUBLE;
-      input.push_back(current);
+  // Take the whole numeric run in two digit scans around an optional
+  // decimal point, rather than appending a character at a time
+  while (!isEmpty() && std::isdigit(peek())) {
+    advanceCursor();
+  }
+  if (!isEmpty() && peek() == '.') {
+    type = StructuredHeaderItem::Type::DOUBLE;
+    advanceCursor();
+    while (!isEmpty() && std::isdigit(peek())) {
       advanceCursor();
-    } else {
-      break;
     }
+  }
 
-    int numDigits = input.length() - (positive ? 0 : 1);
-    if (type == StructuredHeaderItem::Type::INT64 &&
-       numDigits > StructuredHeaders::kMaxValidIntegerLength) {
-      return handleDecodeError(DecodeError::VALUE_TOO_LONG);
-    } else if (type == StructuredHeaderItem::Type::DOUBLE &&
-       numDigits > StructuredHeaders::kMaxValidFloatLength) {
-      return handleDecodeError(DecodeError::VALUE_TOO_LONG);
-    }
+  std::string input(tokenStart, content_.begin());
+  int numDigits = input.length() - (positive ? 0 : 1);
+  if (type == StructuredHeaderItem::Type::INT64 &&
+     numDigits > StructuredHeaders::kMaxValidIntegerLength) {
+    return handleDecodeError(DecodeError::VALUE_TOO_LONG);
+  } else if (type == StructuredHeaderItem::Type::DOUBLE &&
+     numDigits > StructuredHeaders::kMaxValidFloatLength) {
+    return handleDecodeError(DecodeError::VALUE_TOO_LONG);
   }
 
   if (type == StructuredHeaderItem::Type::INT64) {
@@ -111,32 +109,39 @@ DecodeError StructuredHeadersBuffer::parseBinaryContent(
 
   advanceCursor();
 
-  while (!isEmpty()) {
-    char current = peek();
-    advanceCursor();
-    if (current == '*') {
-      if (!isValidEncodedBinaryContent(
-         outputString)) {
-        return handleDecodeError(DecodeError::UNDECODEABLE_BINARY_CONTENT);
-      }
+  // Scan the whole base64 run at once; it ends at the closing '*', the
+  // first invalid character or the end of the buffer
+  size_t runLength = 0;
+  while (runLength < content_.size() &&
+         isValidEncodedBinaryContentChar(content_[runLength])) {
+    runLength++;
+  }
 
-      std::string decodedContent = decodeBase64(outputString);
-      if (encodeBase64(decodedContent) != outputString) {
-        return handleDecodeError(DecodeError::UNDECODEABLE_BINARY_CONTENT);
-      }
+  if (runLength == content_.size()) {
+    content_.advance(runLength);
+    return handleDecodeError(DecodeError::UNEXPECTED_END_OF_BUFFER);
+  }
 
-      result.value = std::move(decodedContent);
-      result.tag = StructuredHeaderItem::Type::BINARYCONTENT;
-      return DecodeError::OK;
-    } else if (!isValidEncodedBinaryContentChar(
-        current)) {
-      return handleDecodeError(DecodeError::INVALID_CHARACTER);
-    } else {
-      outputString.push_back(current);
-    }
+  if (content_[runLength] != '*') {
+    content_.advance(runLength + 1);
+    return handleDecodeError(DecodeError::INVALID_CHARACTER);
   }
 
-  return handleDecodeError(DecodeError::UNEXPECTED_END_OF_BUFFER);
+  outputString.append(content_.begin(), runLength);
+  content_.advance(runLength + 1);
+
+  if (!isValidEncodedBinaryContent(outputString)) {
+    return handleDecodeError(DecodeError::UNDECODEABLE_BINARY_CONTENT);
+  }
+
+  std::string decodedContent = decodeBase64(outputString);
+  if (encodeBase64(decodedContent) != outputString) {
+    return handleDecodeError(DecodeError::UNDECODEABLE_BINARY_CONTENT);
+  }
+
+  result.value = std::move(decodedContent);
+  result.tag = StructuredHeaderItem::Type::BINARYCONTENT;
+  return DecodeError::OK;
 }
 
 DecodeError StructuredHeadersBuffer::parseIdentifier(
@@ -149,7 +154,7 @@ DecodeError StructuredHeadersBuffer::parseIdentifier(
     return err;
   }
 
-  result.value = outputString;
+  result.value = std::move(outputString);
   result.tag = StructuredHeaderItem::Type::IDENTIFIER;
 
   return DecodeError::OK;
@@ -166,15 +171,15 @@ DecodeError StructuredHeadersBuffer::parseIdentifier(
     return handleDecodeError(DecodeError::INVALID_CHARACTER);
   }
 
-  while (!isEmpty()) {
-    char current = peek();
-    if (!isValidIdentifierChar(current)) {
-      break;
-    } else {
-      advanceCursor();
-      result.push_back(current);
-    }
+  // Find the end of the identifier run first so the output is sized and
+  // appended in a single step
+  size_t runLength = 0;
+  while (runLength < content_.size() &&
+         isValidIdentifierChar(content_[runLength])) {
+    runLength++;
   }
+  result.append(content_.begin(), runLength);
+  content_.advance(runLength);
 
   return DecodeError::OK;
 }
@@ -218,39 +223,57 @@ DecodeError StructuredHeadersBuffer::parseString(StructuredHeaderItem& result) {
   advanceCursor();
 
   while (!isEmpty()) {
-    char current = peek();
-    if (current == '\\') {
-      advanceCursor();
-      if (isEmpty()) {
-        return handleDecodeError(DecodeError::UNEXPECTED_END_OF_BUFFER);
-      } else {
-        char nextChar = peek();
-        advanceCursor();
-        if (nextChar != '"' && nextChar != '\\') {
-          return handleDecodeError(DecodeError::INVALID_CHARACTER);
-        }
-        outputString.push_back(nextChar);
+    // Vectorized scan (SSE4.2 under the hood) to the next escape or
+    // closing quote; the plain run in between is validated and appended
+    // in one step instead of a character at a time
+    auto interesting = content_.find_first_of(folly::StringPiece("\"\\"));
+    size_t runLength =
+        (interesting == folly::StringPiece::npos) ? content_.size()
+                                                  : interesting;
+    for (size_t i = 0; i < runLength; i++) {
+      if (!isValidStringChar(content_[i])) {
+        content_.advance(i);
+        return handleDecodeError(DecodeError::INVALID_CHARACTER);
       }
-    } else if (current == '"') {
+    }
+    outputString.append(content_.begin(), runLength);
+    content_.advance(runLength);
+
+    if (isEmpty()) {
+      break;
+    }
+
+    if (peek() == '"') {
       advanceCursor();
-      result.value = outputString;
+      result.value = std::move(outputString);
       result.tag = StructuredHeaderItem::Type::STRING;
       return DecodeError::OK;
-    } else if (!isValidStringChar(current)) {
+    }
+
+    // Escape sequence; only \" and \\ are legal
+    advanceCursor();
+    if (isEmpty()) {
+      return handleDecodeError(DecodeError::UNEXPECTED_END_OF_BUFFER);
+    }
+    char nextChar = peek();
+    advanceCursor();
+    if (nextChar != '"' && nextChar != '\\') {
       return handleDecodeError(DecodeError::INVALID_CHARACTER);
-    } else {
-      advanceCursor();
-      outputString.push_back(current);
     }
+    outputString.push_back(nextChar);
   }
 
   return handleDecodeError(DecodeError::UNEXPECTED_END_OF_BUFFER);
 }
 
 DecodeError StructuredHeadersBuffer::removeOptionalWhitespace() {
-  while (peek() == ' ' || peek() == '\t') {
-    advanceCursor();
+  // Bounded scan; peek() must not be called on an empty buffer
+  size_t runLength = 0;
+  while (runLength < content_.size() &&
+         (content_[runLength] == ' ' || content_[runLength] == '\t')) {
+    runLength++;
   }
+  content_.advance(runLength);
   return DecodeError::OK;
 }
 
@@ -35,7 +35,7 @@ DecodeError StructuredHeadersDecoder::decodeList(
       return err;
     }
 
-    result.push_back(item);
+    result.push_back(std::move(item));
 
     buf_.removeOptionalWhitespace();
 
@@ -81,7 +81,7 @@ DecodeError StructuredHeadersDecoder::decodeParameterisedList(
       return err;
     }
 
-    result.emplace_back(primaryIdentifier);
+    result.emplace_back(std::move(primaryIdentifier));
 
     buf_.removeOptionalWhitespace();
 
@@ -124,27 +124,27 @@ DecodeError StructuredHeadersDecoder::decodeMap(
       return err;
     }
 
-    if (result.find(thisKey) != result.end()) {
+    // Single hash lookup: the emplace doubles as the duplicate check and
+    // the value is parsed in place
+    auto emplaceResult = result.emplace(std::move(thisKey),
+                                        StructuredHeaderItem());
+    if (!emplaceResult.second) {
       return buf_.handleDecodeError(DecodeError::DUPLICATE_KEY);
     }
+    StructuredHeaderItem& value = emplaceResult.first->second;
 
     err = buf_.removeSymbol("=", mapType == MapType::DICTIONARY);
     if (err != DecodeError::OK) {
       if (mapType == MapType::DICTIONARY) {
         return err;
       } else {
-        StructuredHeaderItem value;
         value.tag = StructuredHeaderItem::Type::NONE;
-        result[thisKey] = value;
       }
     } else {
-      StructuredHeaderItem value;
       err = buf_.parseItem(value);
       if (err != DecodeError::OK) {
         return err;
       }
-
-      result[thisKey] = value;
     }
 
     buf_.removeOptionalWhitespace();
@@ -310,6 +310,34 @@ TEST_F(StructuredHeadersBufferTest, TestConsumeMessy) {
   }
 }
 
+TEST_F(StructuredHeadersBufferTest, TestStringRunsWithEscapes) {
+  // Exercises the bulk scan: plain runs on either side of each escape
+  // are appended whole
+  std::string input = "\"the quick \\\"brown\\\" fox \\\\ jumped\"";
+  StructuredHeadersBuffer shd(input);
+  StructuredHeaderItem output;
+  auto err = shd.parseItem(output);
+  EXPECT_EQ(err, StructuredHeaders::DecodeError::OK);
+  EXPECT_EQ(output.tag, StructuredHeaderItem::Type::STRING);
+  EXPECT_EQ(output, std::string("the quick \"brown\" fox \\ jumped"));
+}
+
+TEST_F(StructuredHeadersBufferTest, TestStringInvalidCharacterMidRun) {
+  std::string input = "\"abcdef\x01ghi\"";
+  StructuredHeadersBuffer shd(input);
+  StructuredHeaderItem output;
+  auto err = shd.parseItem(output);
+  EXPECT_EQ(err, StructuredHeaders::DecodeError::INVALID_CHARACTER);
+}
+
+TEST_F(StructuredHeadersBufferTest, TestWhitespaceOnlyBuffer) {
+  std::string input = "   \t ";
+  StructuredHeadersBuffer shd(input);
+  StructuredHeaderItem output;
+  auto err = shd.parseItem(output);
+  EXPECT_EQ(err, StructuredHeaders::DecodeError::UNEXPECTED_END_OF_BUFFER);
+}
+
 TEST_F(StructuredHeadersBufferTest, TestInequalityOperator) {
   StructuredHeaderItem integerItem;
   integerItem.value = int64_t(999);
@@ -0,0 +1,156 @@
+/*
+ *  Copyright (c) 2015-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include <deque>
+
+#include <folly/portability/GTest.h>
+#include <proxygen/lib/http/DnsCache.h>
+
+using namespace proxygen;
+
+namespace {
+
+// Resolver with manually completed requests, so tests control exactly
+// when and how each resolution finishes
+class StubResolver : public DnsResolver {
+ public:
+  void resolve(const std::string& hostname, Callback* cb) override {
+    pending.emplace_back(hostname, cb);
+  }
+
+  void cancelResolve(Callback* cb) override {
+    for (auto it = pending.begin(); it != pending.end(); ++it) {
+      if (it->second == cb) {
+        pending.erase(it);
+        return;
+      }
+    }
+  }
+
+  void completeNext(std::vector<folly::IPAddress> addrs,
+                    std::chrono::seconds ttl) {
+    ASSERT_FALSE(pending.empty());
+    auto cb = pending.front().second;
+    pending.pop_front();
+    cb->resolveSuccess(Answer{std::move(addrs), ttl});
+  }
+
+  void failNext(const std::string& msg) {
+    ASSERT_FALSE(pending.empty());
+    auto cb = pending.front().second;
+    pending.pop_front();
+    cb->resolveError(msg);
+  }
+
+  std::deque<std::pair<std::string, Callback*>> pending;
+};
+
+class RecordingCallback : public DnsCache::Callback {
+ public:
+  void resolveSuccess(DnsResolver::Answer answer) noexcept override {
+    successes.push_back(std::move(answer));
+  }
+  void resolveError(const std::string& msg) noexcept override {
+    errors.push_back(msg);
+  }
+
+  std::vector<DnsResolver::Answer> successes;
+  std::vector<std::string> errors;
+};
+
+} // namespace
+
+TEST(DnsCache, HitAnswersInlineWithoutResolver) {
+  StubResolver resolver;
+  DnsCache cache(&resolver);
+  RecordingCallback cb;
+
+  cache.getAddresses("host.example.com", &cb);
+  EXPECT_EQ(resolver.pending.size(), 1);
+  EXPECT_TRUE(cb.successes.empty());
+  resolver.completeNext({folly::IPAddress("10.0.0.1")},
+                        std::chrono::seconds(60));
+  ASSERT_EQ(cb.successes.size(), 1);
+  EXPECT_EQ(cb.successes[0].addrs.size(), 1);
+
+  // second lookup answers from cache with no new resolver traffic
+  cache.getAddresses("host.example.com", &cb);
+  EXPECT_EQ(cb.successes.size(), 2);
+  EXPECT_TRUE(resolver.pending.empty());
+}
+
+TEST(DnsCache, ConcurrentMissesShareOneResolution) {
+  StubResolver resolver;
+  DnsCache cache(&resolver);
+  RecordingCallback cb1;
+  RecordingCallback cb2;
+
+  cache.getAddresses("host.example.com", &cb1);
+  cache.getAddresses("host.example.com", &cb2);
+  EXPECT_EQ(resolver.pending.size(), 1);
+
+  resolver.completeNext({folly::IPAddress("10.0.0.1")},
+                        std::chrono::seconds(60));
+  EXPECT_EQ(cb1.successes.size(), 1);
+  EXPECT_EQ(cb2.successes.size(), 1);
+}
+
+TEST(DnsCache, NegativeEntrySuppressesRetries) {
+  StubResolver resolver;
+  DnsCache cache(&resolver);
+  RecordingCallback cb;
+
+  cache.getAddresses("down.example.com", &cb);
+  resolver.failNext("NXDOMAIN");
+  ASSERT_EQ(cb.errors.size(), 1);
+
+  // within the negative TTL the error answers from cache
+  cache.getAddresses("down.example.com", &cb);
+  EXPECT_EQ(cb.errors.size(), 2);
+  EXPECT_TRUE(resolver.pending.empty());
+}
+
+TEST(DnsCache, StaleEntryTriggersBackgroundRefresh) {
+  StubResolver resolver;
+  DnsCache::Config config;
+  // refreshAt == insertion time, so the very next lookup is past it
+  config.refreshThreshold = 0;
+  DnsCache cache(&resolver, config);
+  RecordingCallback cb;
+
+  cache.getAddresses("host.example.com", &cb);
+  resolver.completeNext({folly::IPAddress("10.0.0.1")},
+                        std::chrono::seconds(60));
+  ASSERT_EQ(cb.successes.size(), 1);
+
+  // served inline from cache, refresh kicked off in the background
+  cache.getAddresses("host.example.com", &cb);
+  EXPECT_EQ(cb.successes.size(), 2);
+  ASSERT_EQ(resolver.pending.size(), 1);
+
+  resolver.completeNext({folly::IPAddress("10.0.0.2")},
+                        std::chrono::seconds(60));
+  // refresh had no waiter, but the cache now serves the new answer
+  cache.getAddresses("host.example.com", &cb);
+  ASSERT_EQ(cb.successes.size(), 3);
+  EXPECT_EQ(cb.successes[2].addrs[0], folly::IPAddress("10.0.0.2"));
+}
+
+TEST(DnsCache, CancelledWaiterGetsNoCallback) {
+  StubResolver resolver;
+  DnsCache cache(&resolver);
+  RecordingCallback cb;
+
+  cache.getAddresses("host.example.com", &cb);
+  cache.cancelLookup(&cb);
+  resolver.completeNext({folly::IPAddress("10.0.0.1")},
+                        std::chrono::seconds(60));
+  EXPECT_TRUE(cb.successes.empty());
+  EXPECT_TRUE(cb.errors.empty());
+}
@@ -30,6 +30,36 @@ TEST_F(HTTPCommonHeadersTests, TestHashing) {
   EXPECT_EQ(commonCode1, commonCode2);
 }
 
+TEST_F(HTTPCommonHeadersTests, TestHashingStableUnderCache) {
+  // The thread-local lookup cache must never change an answer: repeated
+  // lookups, case variants, and tag-colliding neighbors all have to
+  // agree with the perfect hash
+  std::string common("X-Forwarded-For");
+  // Same length and first eight bytes as the common name above, but not
+  // a common header
+  std::string neighbor("X-Forwarded-Fox");
+  std::string miss("x-fb-internal-routing");
+
+  auto commonCode = HTTPCommonHeaders::hash(common);
+  EXPECT_NE(commonCode, HTTPHeaderCode::HTTP_HEADER_OTHER);
+
+  for (int i = 0; i < 3; i++) {
+    EXPECT_EQ(HTTPCommonHeaders::hash(common), commonCode);
+    EXPECT_EQ(HTTPCommonHeaders::hash("x-forwarded-for"), commonCode);
+    EXPECT_EQ(HTTPCommonHeaders::hash(neighbor),
+              HTTPHeaderCode::HTTP_HEADER_OTHER);
+    EXPECT_EQ(HTTPCommonHeaders::hash(miss),
+              HTTPHeaderCode::HTTP_HEADER_OTHER);
+  }
+
+  // Names longer than the cache key bypass the cache and still resolve
+  std::string longCommon("Access-Control-Allow-Credentials");
+  EXPECT_NE(HTTPCommonHeaders::hash(longCommon),
+            HTTPHeaderCode::HTTP_HEADER_OTHER);
+  EXPECT_EQ(HTTPCommonHeaders::hash(longCommon),
+            HTTPCommonHeaders::hash("access-control-allow-credentials"));
+}
+
 TEST_F(HTTPCommonHeadersTests, TestTwoTablesInitialized) {
   std::string common("Content-Length");
   HTTPHeaderCode code = HTTPCommonHeaders::hash(common);
@@ -83,6 +83,30 @@ BENCHMARK(HTTPCommonHeadersGetHeaderCodeFromTableCommonHeaderName, iters) {
   HTTPCommonHeadersGetHeaderCodeFromTableCommonHeaderNameBench(iters);
 }
 
+// Production-shaped lookup mix: a small hot set of common names plus
+// recurring unknown ones, exercising the thread-local cache in front of
+// the perfect hash (including its cached known-miss path)
+void HTTPCommonHeadersHashSkewedBench(int iters) {
+  static const std::vector<std::string> hotNames = {
+      "Host",
+      "content-length",
+      "User-Agent",
+      "Accept-Encoding",
+      "Cookie",
+      "x-fb-internal-routing", // miss
+      "x-request-budget-ms",   // miss
+  };
+  for (int i = 0; i < iters; ++i) {
+    for (auto const& name : hotNames) {
+      folly::doNotOptimizeAway(HTTPCommonHeaders::hash(name));
+    }
+  }
+}
+
+BENCHMARK(HTTPCommonHeadersHashSkewed, iters) {
+  HTTPCommonHeadersHashSkewedBench(iters);
+}
+
 void memchrBench(int iters) {
   for (int i = 0; i < iters; ++i) {
     for (uint64_t j = HTTPHeaderCodeCommonOffset;
@@ -8,6 +8,7 @@
  *
  */
 #include <fcntl.h>
+#include <folly/Conv.h>
 #include <folly/portability/GTest.h>
 #include <proxygen/lib/http/HTTPMessage.h>
 #include <proxygen/lib/utils/TestUtils.h>
@@ -57,6 +58,78 @@ TEST(HTTPMessage, TestParseCookiesMultipleCookies) {
   EXPECT_EQ(msg.getCookie("Name"), "");
 }
 
+TEST(HTTPMessage, TestGetCookiesSortedView) {
+  HTTPMessage msg;
+
+  msg.getHeaders().add("Cookie", "zeta=3; alpha=1; mid=2");
+  const auto& cookies = msg.getCookies();
+  ASSERT_EQ(cookies.size(), 3);
+  EXPECT_EQ(cookies[0].first, "alpha");
+  EXPECT_EQ(cookies[0].second, "1");
+  EXPECT_EQ(cookies[1].first, "mid");
+  EXPECT_EQ(cookies[2].first, "zeta");
+}
+
+TEST(HTTPMessage, TestDuplicateCookieKeepsFirst) {
+  HTTPMessage msg;
+
+  msg.getHeaders().add("Cookie", "dup=first; dup=second");
+  EXPECT_EQ(msg.getCookie("dup"), "first");
+}
+
+TEST(HTTPMessage, TestUnparseCookiesPicksUpNewHeader) {
+  HTTPMessage msg;
+
+  msg.getHeaders().add("Cookie", "id=1");
+  EXPECT_EQ(msg.getCookie("id"), "1");
+  // The index is built once; editing the Cookie header requires
+  // unparseCookies() per the getCookie() contract
+  msg.getHeaders().add("Cookie", "extra=2");
+  msg.unparseCookies();
+  EXPECT_EQ(msg.getCookie("extra"), "2");
+  EXPECT_EQ(msg.getCookie("id"), "1");
+}
+
+TEST(HTTPMessage, TestTypedConstruction) {
+  // The typed subclasses commit the direction at construction
+  HTTPRequestMessage req;
+  EXPECT_TRUE(req.isRequest());
+  EXPECT_FALSE(req.isResponse());
+  req.setMethod(HTTPMethod::GET);
+  EXPECT_EQ(req.getMethod(), HTTPMethod::GET);
+
+  HTTPResponseMessage resp;
+  EXPECT_TRUE(resp.isResponse());
+  EXPECT_FALSE(resp.isRequest());
+  resp.setStatusCode(200);
+  EXPECT_EQ(resp.getStatusCode(), 200);
+
+  // Slicing back down to the interchange type keeps the direction
+  HTTPMessage plain = req;
+  EXPECT_TRUE(plain.isRequest());
+}
+
+TEST(HTTPMessage, TestMakeImmutableShared) {
+  HTTPMessage msg;
+  msg.setMethod(HTTPMethod::GET);
+  msg.setURL("/static/app.js?v=3");
+  msg.getHeaders().add(HTTP_HEADER_HOST, "www.facebook.com");
+  msg.getHeaders().add(HTTP_HEADER_COOKIE, "id=1");
+
+  auto snapshot = HTTPMessage::makeImmutableShared(std::move(msg));
+  EXPECT_TRUE(snapshot->isImmutableShared());
+  EXPECT_TRUE(snapshot->isHeaderBlockReusable());
+  // The lazy caches were all built during the freeze, so these const
+  // reads hit them instead of writing them
+  EXPECT_EQ(snapshot->getQueryParam("v"), "3");
+  EXPECT_EQ(snapshot->getCookie("id"), "1");
+  EXPECT_EQ(snapshot->getPathAsStringPiece(), "/static/app.js");
+
+  // Copying a snapshot yields an ordinary mutable message
+  HTTPMessage copy = *snapshot;
+  EXPECT_FALSE(copy.isImmutableShared());
+}
+
 TEST(HTTPMessage, TestParseQueryParamsSimple) {
   HTTPMessage msg;
   string url = "/test?seq=123456&userid=1256679245&dup=1&dup=2&helloWorld"
@@ -417,6 +490,130 @@ TEST(HTTPHeaders, AddStringPiece) {
   EXPECT_EQ("value", headers.getSingleOrEmpty("name"));
 }
 
+TEST(HTTPMessage, LazyURLParsing) {
+  HTTPMessage msg;
+  msg.setURLLazy("/foo/bar?baz=1");
+  // The raw URL is available without decomposition
+  EXPECT_EQ(msg.getURL(), "/foo/bar?baz=1");
+  // First touch of path/query decomposes on demand
+  EXPECT_EQ(msg.getPath(), "/foo/bar");
+  EXPECT_EQ(msg.getQueryString(), "baz=1");
+  EXPECT_EQ(msg.getQueryParam("baz"), "1");
+
+  // Re-setting lazily resets the derived state
+  msg.setURLLazy("/other");
+  EXPECT_EQ(msg.getQueryParams().size(), 0);
+  EXPECT_EQ(msg.getPath(), "/other");
+  EXPECT_EQ(msg.getQueryString(), "");
+
+  // Query params work even if the first touch is the param map
+  msg.setURLLazy("/x?a=b&c=d");
+  EXPECT_EQ(msg.getQueryParam("c"), "d");
+}
+
+TEST(HTTPHeaders, BorrowedValues) {
+  std::string ingress("x-custom-of-mine: borrowed bytes \r\n");
+  folly::StringPiece buf(ingress);
+  HTTPHeaders headers;
+  headers.addFromCodecBorrowed(buf.data(), 16, buf.subpiece(18, 16));
+  EXPECT_TRUE(headers.hasBorrowedValues());
+
+  // Zero-copy iteration hands out views into the ingress buffer
+  headers.forEachWithCodePiece([&](HTTPHeaderCode code,
+                                   const std::string& name,
+                                   folly::StringPiece value) {
+    EXPECT_EQ(code, HTTP_HEADER_OTHER);
+    EXPECT_EQ(name, "x-custom-of-mine");
+    EXPECT_EQ(value, "borrowed bytes");
+    EXPECT_GE(value.data(), ingress.data());
+    EXPECT_LT(value.data(), ingress.data() + ingress.size());
+  });
+  EXPECT_TRUE(headers.hasBorrowedValues());
+
+  // String access materializes lazily
+  EXPECT_EQ("borrowed bytes", headers.getSingleOrEmpty("x-custom-of-mine"));
+  EXPECT_FALSE(headers.hasBorrowedValues());
+}
+
+TEST(HTTPHeaders, BorrowedValuesDetach) {
+  auto ingress = std::make_unique<std::string>("value-from-the-wire");
+  HTTPHeaders headers;
+  headers.addFromCodecBorrowed("X-Borrowed", 10, *ingress);
+  EXPECT_TRUE(headers.hasBorrowedValues());
+
+  // Clone-on-detach before the ingress buffer goes away
+  headers.materializeBorrowedValues();
+  EXPECT_FALSE(headers.hasBorrowedValues());
+  ingress.reset();
+  EXPECT_EQ("value-from-the-wire", headers.getSingleOrEmpty("X-Borrowed"));
+}
+
+TEST(HTTPHeaders, InternedNames) {
+  HTTPHeaderInternTable::enable();
+
+  const std::string* first = nullptr;
+  {
+    HTTPHeaders headers;
+    headers.add("X-Fb-Custom-Routing", "a");
+    headers.forEachWithCode([&] (HTTPHeaderCode code,
+                                 const std::string& name,
+                                 const std::string& /*value*/) {
+      EXPECT_EQ(HTTP_HEADER_OTHER, code);
+      first = &name;
+    });
+    ASSERT_NE(nullptr, first);
+    EXPECT_TRUE(HTTPHeaderInternTable::isInterned(first));
+  }
+  // The interned name survives the headers that referenced it; a second
+  // message with the same custom name gets the exact same pointer back
+  HTTPHeaders headers2;
+  headers2.add("X-Fb-Custom-Routing", "b");
+  headers2.forEachWithCode([&] (HTTPHeaderCode /*code*/,
+                                const std::string& name,
+                                const std::string& /*value*/) {
+    EXPECT_EQ(first, &name);
+  });
+  // remove() must not delete the interned name out from under the table
+  EXPECT_TRUE(headers2.remove("X-Fb-Custom-Routing"));
+  EXPECT_EQ("X-Fb-Custom-Routing", *first);
+
+  HTTPHeaderInternTable::disable();
+}
+
+TEST(HTTPHeaders, OverflowIndex) {
+  HTTPHeaders headers;
+  // Push the list well past the indexing threshold with a mix of common
+  // codes (some repeated) and uncommon names
+  for (int i = 0; i < 10; i++) {
+    headers.add("X-Padding-" + folly::to<std::string>(i), "pad");
+  }
+  headers.add(HTTP_HEADER_SET_COOKIE, "a=1");
+  headers.add(HTTP_HEADER_SET_COOKIE, "b=2");
+  headers.add("X-Custom-Route", "cell7");
+  for (int i = 10; i < 20; i++) {
+    headers.add("X-Padding-" + folly::to<std::string>(i), "pad");
+  }
+  headers.add(HTTP_HEADER_SET_COOKIE, "c=3");
+  ASSERT_GT(headers.size(), 16);
+
+  // Lookups by code and by uncommon name both go through the index
+  EXPECT_EQ(3, headers.getNumberOfValues(HTTP_HEADER_SET_COOKIE));
+  EXPECT_EQ("a=1, b=2, c=3", headers.combine(HTTP_HEADER_SET_COOKIE));
+  EXPECT_EQ("cell7", headers.getSingleOrEmpty("x-custom-route"));
+  EXPECT_EQ("pad", headers.getSingleOrEmpty("X-Padding-15"));
+  EXPECT_EQ("", headers.getSingleOrEmpty("X-Not-Present"));
+  EXPECT_EQ(0, headers.getNumberOfValues(HTTP_HEADER_CONNECTION));
+
+  // Mutations invalidate the index; subsequent lookups see fresh state
+  EXPECT_TRUE(headers.remove(HTTP_HEADER_SET_COOKIE));
+  EXPECT_EQ(0, headers.getNumberOfValues(HTTP_HEADER_SET_COOKIE));
+  EXPECT_TRUE(headers.remove("X-Custom-Route"));
+  EXPECT_EQ("", headers.getSingleOrEmpty("X-Custom-Route"));
+  headers.add("X-Custom-Route", "cell9");
+  EXPECT_EQ("cell9", headers.getSingleOrEmpty("X-Custom-Route"));
+  EXPECT_EQ("pad", headers.getSingleOrEmpty("X-Padding-0"));
+}
+
 TEST(HTTPHeaders, InitializerList) {
   HTTPHeaders hdrs;
 
@@ -531,6 +728,50 @@ TEST(HTTPMessage, TestCheckForHeaderToken) {
                                        true));
 }
 
+TEST(HTTPMessage, TestGetContentLength) {
+  HTTPMessage msg;
+  EXPECT_FALSE(msg.getContentLength().hasValue());
+
+  HTTPMessage msg2;
+  msg2.getHeaders().add(HTTP_HEADER_CONTENT_LENGTH, "37");
+  EXPECT_EQ(*msg2.getContentLength(), 37);
+  // the parse is cached
+  EXPECT_EQ(*msg2.getContentLength(), 37);
+
+  HTTPMessage msg3;
+  msg3.getHeaders().add(HTTP_HEADER_CONTENT_LENGTH, "pizza");
+  EXPECT_FALSE(msg3.getContentLength().hasValue());
+}
+
+TEST(HTTPMessage, TestGetMaxForwards) {
+  HTTPMessage msg;
+  msg.setMethod(HTTPMethod::TRACE);
+  EXPECT_FALSE(msg.getMaxForwards().hasValue());
+  msg.getHeaders().add(HTTP_HEADER_MAX_FORWARDS, "5");
+  EXPECT_EQ(*msg.getMaxForwards(), 5);
+  // processMaxForwards rewrites the header and the cached value
+  EXPECT_EQ(msg.processMaxForwards(), 0);
+  EXPECT_EQ(*msg.getMaxForwards(), 4);
+  EXPECT_EQ(msg.getHeaders().getSingleOrEmpty(HTTP_HEADER_MAX_FORWARDS), "4");
+}
+
+TEST(HTTPMessage, TestConnectionTokenBitmask) {
+  HTTPMessage msg;
+  HTTPHeaders& headers = msg.getHeaders();
+
+  headers.add(HTTP_HEADER_CONNECTION, "Keep-Alive, Upgrade");
+  headers.add(HTTP_HEADER_CONNECTION, "HTTP2-Settings");
+  EXPECT_TRUE(msg.hasConnectionToken(HTTPMessage::CONN_KEEP_ALIVE));
+  EXPECT_TRUE(msg.hasConnectionToken(HTTPMessage::CONN_UPGRADE));
+  EXPECT_FALSE(msg.hasConnectionToken(HTTPMessage::CONN_CLOSE));
+
+  HTTPMessage closeMsg;
+  closeMsg.setHTTPVersion(1, 1);
+  closeMsg.getHeaders().add(HTTP_HEADER_CONNECTION, "close");
+  EXPECT_TRUE(closeMsg.hasConnectionToken(HTTPMessage::CONN_CLOSE));
+  EXPECT_FALSE(closeMsg.computeKeepalive());
+}
+
 TEST(HttpMessage, TestProtocolStringHTTPVersion) {
   HTTPMessage msg;
   msg.setHTTPVersion(1, 1);
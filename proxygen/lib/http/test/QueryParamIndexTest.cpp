@@ -0,0 +1,65 @@
+/*
+ *  Copyright (c) 2015-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include <folly/portability/GTest.h>
+#include <proxygen/lib/http/QueryParamIndex.h>
+
+using namespace proxygen;
+
+TEST(QueryParamIndex, SlotLookup) {
+  QueryParamIndex index({"user_id", "fields", "limit", "cursor"});
+  ASSERT_EQ(index.numParams(), 4);
+  for (size_t slot = 0; slot < index.numParams(); ++slot) {
+    auto found = index.slotOf(index.nameOf(slot));
+    ASSERT_TRUE(found.hasValue());
+    EXPECT_EQ(*found, slot);
+  }
+  EXPECT_FALSE(index.slotOf("not_in_schema").hasValue());
+  EXPECT_FALSE(index.slotOf("").hasValue());
+}
+
+TEST(QueryParamIndex, ParseMatchesHTTPMessageSemantics) {
+  QueryParamIndex index({"a", "b", "c"});
+  // duplicate a: last wins; b has no value; unknown d is skipped
+  auto parsed = index.parse("a=1&b&d=skipped&a=2&=novalue");
+
+  EXPECT_TRUE(parsed.hasParam(*index.slotOf("a")));
+  EXPECT_EQ(parsed.rawValue(*index.slotOf("a")), "2");
+  EXPECT_TRUE(parsed.hasParam(*index.slotOf("b")));
+  EXPECT_EQ(parsed.rawValue(*index.slotOf("b")), "");
+  EXPECT_FALSE(parsed.hasParam(*index.slotOf("c")));
+}
+
+TEST(QueryParamIndex, DecodedValues) {
+  QueryParamIndex index({"q", "bad"});
+  auto parsed = index.parse("q=hello%20world%2Fagain&bad=trailing%2");
+
+  auto decoded = parsed.decodedValue(*index.slotOf("q"));
+  ASSERT_TRUE(decoded.hasValue());
+  EXPECT_EQ(*decoded, "hello world/again");
+  // repeated access returns the same arena-backed storage
+  auto again = parsed.decodedValue(*index.slotOf("q"));
+  ASSERT_TRUE(again.hasValue());
+  EXPECT_EQ(decoded->data(), again->data());
+
+  EXPECT_FALSE(parsed.decodedValue(*index.slotOf("bad")).hasValue());
+}
+
+TEST(QueryParamIndex, LargerSchemaStaysCollisionFree) {
+  std::vector<std::string> names;
+  for (int i = 0; i < 40; ++i) {
+    names.push_back("param_" + std::to_string(i));
+  }
+  QueryParamIndex index(names);
+  for (size_t slot = 0; slot < names.size(); ++slot) {
+    auto found = index.slotOf(names[slot]);
+    ASSERT_TRUE(found.hasValue());
+    EXPECT_EQ(*found, slot);
+  }
+}
@@ -0,0 +1,90 @@
+/*
+ *  Copyright (c) 2015-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include <folly/FileUtil.h>
+#include <folly/experimental/TestUtil.h>
+#include <folly/portability/GTest.h>
+#include <proxygen/lib/http/RouteProfileStore.h>
+
+using namespace proxygen;
+
+TEST(RouteProfileStore, RecordsAndProfilesPerRoute) {
+  RouteProfileStore store;
+  EXPECT_FALSE(store.getProfile("/unseen").hasValue());
+
+  // a small-header, small-body route and a large-body route
+  for (int i = 0; i < 100; i++) {
+    store.recordTransaction("/ping", 300, 100);
+    store.recordTransaction("/upload", 2000, 500 * 1024);
+  }
+  EXPECT_EQ(store.getNumRoutes(), 2);
+
+  auto ping = store.getProfile("/ping");
+  ASSERT_TRUE(ping.hasValue());
+  EXPECT_EQ(ping->txnCount, 100);
+  EXPECT_LE(ping->arenaBytesP99, 1024);
+  EXPECT_EQ(ping->suggestedArenaBlockSize(), 1024);
+  EXPECT_EQ(ping->suggestedCoalescingWindow(), 4 * 1024);
+
+  auto upload = store.getProfile("/upload");
+  ASSERT_TRUE(upload.hasValue());
+  EXPECT_GE(upload->bodyBytesP99, 500 * 1024);
+  // body p99 exceeds the window cap, so the clamp applies
+  EXPECT_EQ(upload->suggestedCoalescingWindow(), 64 * 1024);
+  EXPECT_EQ(upload->suggestedEgressReservation(), 256 * 1024);
+}
+
+TEST(RouteProfileStore, P99IgnoresOutliers) {
+  RouteProfileStore store;
+  // 1% of requests are huge; the p99 suggestion shouldn't chase them
+  for (int i = 0; i < 990; i++) {
+    store.recordTransaction("/api", 500, 1000);
+  }
+  for (int i = 0; i < 10; i++) {
+    store.recordTransaction("/api", 500, 10 * 1024 * 1024);
+  }
+  auto profile = store.getProfile("/api");
+  ASSERT_TRUE(profile.hasValue());
+  EXPECT_LE(profile->bodyBytesP99, 2048);
+}
+
+TEST(RouteProfileStore, PersistsAcrossRestart) {
+  folly::test::TemporaryFile file("route_profiles");
+  std::string path = file.path().string();
+
+  RouteProfileStore store;
+  for (int i = 0; i < 50; i++) {
+    store.recordTransaction("/checkout", 5000, 8192);
+  }
+  ASSERT_TRUE(store.saveToFile(path));
+
+  RouteProfileStore restarted;
+  ASSERT_TRUE(restarted.loadFromFile(path));
+  EXPECT_EQ(restarted.getNumRoutes(), 1);
+  auto profile = restarted.getProfile("/checkout");
+  ASSERT_TRUE(profile.hasValue());
+  EXPECT_EQ(profile->txnCount, 50);
+  EXPECT_EQ(profile->suggestedArenaBlockSize(),
+            store.getProfile("/checkout")->suggestedArenaBlockSize());
+
+  // loading again merges histograms rather than double-inserting routes
+  ASSERT_TRUE(restarted.loadFromFile(path));
+  EXPECT_EQ(restarted.getNumRoutes(), 1);
+  EXPECT_EQ(restarted.getProfile("/checkout")->txnCount, 100);
+}
+
+TEST(RouteProfileStore, RejectsCorruptFile) {
+  folly::test::TemporaryFile file("route_profiles");
+  std::string path = file.path().string();
+  ASSERT_TRUE(folly::writeFile(std::string("not a profile file"), path.c_str()));
+
+  RouteProfileStore store;
+  EXPECT_FALSE(store.loadFromFile(path));
+  EXPECT_EQ(store.getNumRoutes(), 0);
+}
@@ -35,6 +35,22 @@ void FileServerListGenerator::FileGenerator::run(milliseconds /*timeout*/) {
 
   VLOG(4) << "Looking up server list from File Handle " << params_->fileName;
 
+  // If the file hasn't changed since the last successful parse, serve
+  // the cached list instead of re-reading and re-parsing it.  A file
+  // replaced between this stat and the read is picked up on the next
+  // refresh, when its mtime no longer matches.
+  struct stat st;
+  const bool statOk = ::stat(params_->fileName.c_str(), &st) == 0;
+  if (statOk && params_->hasCache && st.st_ino == params_->cachedStat.st_ino &&
+      st.st_size == params_->cachedStat.st_size &&
+      st.st_mtime == params_->cachedStat.st_mtime) {
+    VLOG(4) << "File " << params_->fileName << " unchanged, serving "
+            << params_->cachedServers.size() << " cached servers";
+    callback_->serverListAvailable(params_->cachedServers);
+    delete this;
+    return;
+  }
+
   std::string content;
   try {
     readFile(params_->fileName, content);
@@ -86,6 +102,11 @@ void FileServerListGenerator::FileGenerator::run(milliseconds /*timeout*/) {
 
   VLOG(4) << "Found " << servers.size() << " usable servers from File "
           << params_->fileName;
+  if (statOk) {
+    params_->hasCache = true;
+    params_->cachedStat = st;
+    params_->cachedServers = servers;
+  }
   callback_->serverListAvailable(std::move(servers));
   delete this;
 }
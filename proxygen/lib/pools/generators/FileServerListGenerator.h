@@ -43,6 +43,15 @@ class FileServerListGenerator : public ServerListGenerator {
     std::string fileName;
     FileType fileType;
     std::string poolName;
+
+    // Cache of the last successfully parsed server list, keyed by the
+    // file's identity and modification time.  Periodic refreshes of an
+    // unchanged file skip the read and the per-entry parse entirely.
+    // Accessed only from the thread calling listServers(), like the
+    // rest of Params.
+    bool hasCache{false};
+    struct stat cachedStat {};
+    std::vector<ServerConfig> cachedServers;
   };
 
   class FileGenerator : public ServerListGenerator::Generator {
@@ -0,0 +1,71 @@
+/*
+ *  Copyright (c) 2015-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include "proxygen/lib/pools/generators/ServerListSnapshot.h"
+
+#include <atomic>
+
+namespace {
+
+bool sameConfig(const proxygen::ServerListGenerator::ServerConfig& a,
+                const proxygen::ServerListGenerator::ServerConfig& b) {
+  return a.address == b.address && a.groupId_ == b.groupId_ &&
+         a.properties == b.properties;
+}
+
+} // namespace
+
+namespace proxygen {
+
+ServerMembership::Delta ServerMembership::update(
+    std::vector<ServerListGenerator::ServerConfig> servers) {
+  Delta delta;
+  auto next = std::make_shared<ServerListSnapshot>();
+  next->epoch = snapshot_->epoch + 1;
+  next->servers.reserve(servers.size());
+
+  decltype(index_) nextIndex;
+  nextIndex.reserve(servers.size());
+
+  for (auto& server : servers) {
+    auto it = index_.find(server.name);
+    std::shared_ptr<const ServerListGenerator::ServerConfig> entry;
+    if (it != index_.end() && sameConfig(*it->second, server)) {
+      // Unchanged server: share the existing config so its identity (and
+      // anything keyed off the pointer) survives the update.
+      entry = it->second;
+    } else {
+      delta.addedOrChanged.push_back(server.name);
+      entry = std::make_shared<const ServerListGenerator::ServerConfig>(
+          std::move(server));
+    }
+    nextIndex.emplace(entry->name, entry);
+    next->servers.push_back(std::move(entry));
+  }
+
+  for (const auto& kv : index_) {
+    if (nextIndex.find(kv.first) == nextIndex.end()) {
+      delta.removed.push_back(kv.first);
+    }
+  }
+
+  index_ = std::move(nextIndex);
+  std::atomic_store_explicit(
+      &snapshot_,
+      std::shared_ptr<const ServerListSnapshot>(std::move(next)),
+      std::memory_order_release);
+  return delta;
+}
+
+std::shared_ptr<const ServerListSnapshot> ServerMembership::getSnapshot()
+    const {
+  return std::atomic_load_explicit(&snapshot_, std::memory_order_acquire);
+}
+
+} // namespace proxygen
@@ -0,0 +1,91 @@
+/*
+ *  Copyright (c) 2015-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#pragma once
+
+#include <memory>
+#include <unordered_map>
+
+#include "proxygen/lib/pools/generators/ServerListGenerator.h"
+
+namespace proxygen {
+
+/**
+ * An immutable, epoch-versioned view of a pool's membership.  Routing
+ * code holds a shared_ptr to a snapshot and reads it without any
+ * locking; updates never mutate a published snapshot, they publish a
+ * new one with a higher epoch.
+ */
+struct ServerListSnapshot {
+  uint64_t epoch{0};
+  std::vector<std::shared_ptr<const ServerListGenerator::ServerConfig>>
+      servers;
+};
+
+/**
+ * Maintains the current ServerListSnapshot for a pool and computes the
+ * diff between consecutive server list updates.
+ *
+ * update() takes the full list a ServerListGenerator produced, reuses
+ * the existing ServerConfig objects for servers that did not change,
+ * and atomically swaps in a new snapshot.  The returned Delta names the
+ * servers that were added, changed, or removed, so a consistent hash
+ * built over the membership (e.g. RendezvousHash seeds) only needs to
+ * be rebuilt when the delta is non-empty, and host-keyed caches only
+ * need to drop entries for the removed names.
+ *
+ * Thread model: update() must be serialized by the caller (typically it
+ * runs on the thread driving the generator refresh); getSnapshot() is
+ * safe from any thread and never blocks.
+ */
+class ServerMembership {
+ public:
+  struct Delta {
+    // Servers that are new in this update or whose address, properties,
+    // or group changed.
+    std::vector<std::string> addedOrChanged;
+    // Servers present in the previous snapshot but not in this update.
+    std::vector<std::string> removed;
+
+    bool empty() const {
+      return addedOrChanged.empty() && removed.empty();
+    }
+  };
+
+  /**
+   * Diff the given list against the current snapshot and publish a new
+   * snapshot with the next epoch.  An update with an empty delta still
+   * publishes a new epoch so callers can tell a refresh happened.
+   */
+  Delta update(std::vector<ServerListGenerator::ServerConfig> servers);
+
+  /**
+   * Returns the current snapshot.  The snapshot is immutable; callers
+   * may cache it and compare epochs to detect staleness.
+   */
+  std::shared_ptr<const ServerListSnapshot> getSnapshot() const;
+
+  uint64_t getEpoch() const {
+    return getSnapshot()->epoch;
+  }
+
+ private:
+  // Published snapshot.  Readers load it atomically; only update()
+  // stores it.
+  std::shared_ptr<const ServerListSnapshot> snapshot_{
+      std::make_shared<const ServerListSnapshot>()};
+
+  // Writer-side index of the current snapshot by server name, used to
+  // diff the next update without rescanning the snapshot vector.
+  std::unordered_map<std::string,
+                     std::shared_ptr<const ServerListGenerator::ServerConfig>>
+      index_;
+};
+
+} // namespace proxygen
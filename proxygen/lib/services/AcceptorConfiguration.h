@@ -14,6 +14,7 @@
 #include <folly/String.h>
 #include <wangle/acceptor/ServerSocketConfig.h>
 #include <list>
+#include <map>
 #include <string>
 #include <sys/stat.h>
 #include <sys/types.h>
@@ -38,6 +39,15 @@ struct AcceptorConfiguration : public wangle::ServerSocketConfig {
    */
   bool internal{false};
 
+  /**
+   * Marks a listener whose peers are all authenticated before any HTTP
+   * is spoken (e.g. service-mesh sidecars over mTLS on loopback).  The
+   * codecs built for such a listener elide the redundant per-byte
+   * header/URL validation on ingress; semantic protocol checks remain.
+   * Never set this on a listener reachable by unauthenticated clients.
+   */
+  bool trustedIngress{false};
+
   /**
   * Determines if connection should respect HTTP2 priorities
   **/
@@ -75,6 +85,20 @@ struct AcceptorConfiguration : public wangle::ServerSocketConfig {
    */
   uint32_t maxConcurrentIncomingStreams{0};
 
+  /**
+   * Exact request paths (health checks and the like) that sessions answer
+   * themselves from a canned response, skipping the controller and handler
+   * pipeline.  Maps path to the response served for GET requests on it.
+   * Empty disables the fast path.
+   */
+  struct DirectResponse {
+    uint16_t statusCode{200};
+    std::string statusMessage;
+    std::string contentType;
+    std::string body;
+  };
+  std::map<std::string, DirectResponse> directResponsePaths;
+
   /**
    * Flow control parameters.
    *
@@ -96,6 +120,42 @@ struct AcceptorConfiguration : public wangle::ServerSocketConfig {
    * built-in HTTPSession default (64kb)
    */
   int64_t writeBufferLimit{-1};
+
+  /**
+   * Low watermark for resuming egress once writeBufferLimit has paused
+   * it: transactions stay paused until the session's buffered egress
+   * drains to this many bytes or fewer.  The gap between the two
+   * watermarks prevents pause/resume flapping when buffered egress
+   * hovers near a single threshold.  -1 means resume at
+   * writeBufferLimit, the historical behavior.
+   */
+  int64_t writeBufferResumeLimit{-1};
+
+  /**
+   * If true, sessions on secure transports chunk their egress writes so TLS
+   * records start small and grow as the connection proves bulk behavior.
+   * See HTTPSession::setDynamicTLSRecordSizing().  Ignored for plaintext
+   * connections.
+   */
+  bool enableDynamicTLSRecordSizing{false};
+
+  /**
+   * If true, hand record protection for eligible accepted TLS
+   * connections (TLS 1.2 AES-128-GCM) to the kernel right after the
+   * handshake; the session then reads and writes plaintext on a plain
+   * socket.  See KTLSUtil::tryOffload().  Ineligible connections fall
+   * back to the userspace stack; dynamic TLS record sizing is skipped
+   * on offloaded connections since the kernel frames records.
+   */
+  bool enableKTLSOffload{false};
+
+  /**
+   * Per-session egress pacing: token bucket rate in bytes per second and
+   * bucket depth in bytes.  See HTTPSession::setEgressPacing().  A rate
+   * of 0 disables pacing.
+   */
+  uint64_t egressPacingBytesPerSec{0};
+  uint64_t egressPacingBurstBytes{0};
 };
 
 } // proxygen
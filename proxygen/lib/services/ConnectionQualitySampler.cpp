@@ -0,0 +1,178 @@
+/*
+ *  Copyright (c) 2015-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include <proxygen/lib/services/ConnectionQualitySampler.h>
+
+#include <algorithm>
+#include <glog/logging.h>
+#include <proxygen/lib/http/session/HTTPSessionBase.h>
+#include <proxygen/lib/utils/Time.h>
+#include <wangle/acceptor/TransportInfo.h>
+
+namespace proxygen {
+
+constexpr std::chrono::milliseconds
+    ConnectionQualitySampler::kDefaultSamplePeriod;
+constexpr size_t ConnectionQualitySampler::kDefaultBatchSize;
+constexpr size_t ConnectionQualitySampler::kRingSize;
+
+ConnectionQualitySampler::ConnectionQualitySampler(
+    folly::EventBase* eventBase,
+    std::chrono::milliseconds samplePeriod,
+    size_t batchSize)
+    : folly::AsyncTimeout(CHECK_NOTNULL(eventBase)),
+      eventBase_(eventBase),
+      samplePeriod_(samplePeriod),
+      batchSize_(std::max<size_t>(batchSize, 1)) {
+}
+
+ConnectionQualitySampler::~ConnectionQualitySampler() {
+  stop();
+}
+
+void ConnectionQualitySampler::start() {
+  if (running_) {
+    return;
+  }
+  running_ = true;
+  scheduleTimeout(samplePeriod_);
+}
+
+void ConnectionQualitySampler::stop() {
+  running_ = false;
+  cancelTimeout();
+  if (isLoopCallbackScheduled()) {
+    cancelLoopCallback();
+  }
+}
+
+void ConnectionQualitySampler::addSession(HTTPSessionBase* session) {
+  if (sessionIndex_.count(session)) {
+    return;
+  }
+  sessionIndex_[session] = sessions_.size();
+  SessionEntry entry;
+  entry.session = session;
+  sessions_.push_back(entry);
+}
+
+void ConnectionQualitySampler::removeSession(HTTPSessionBase* session) {
+  auto it = sessionIndex_.find(session);
+  if (it == sessionIndex_.end()) {
+    return;
+  }
+  size_t index = it->second;
+  sessionIndex_.erase(it);
+  if (index != sessions_.size() - 1) {
+    sessions_[index] = sessions_.back();
+    sessionIndex_[sessions_[index].session] = index;
+  }
+  sessions_.pop_back();
+}
+
+void ConnectionQualitySampler::timeoutExpired() noexcept {
+  // Defer the getsockopt batch to the end of this loop iteration so it
+  // runs after the iteration's request work
+  eventBase_->runInLoop(this, true /* thisIteration */);
+}
+
+void ConnectionQualitySampler::runLoopCallback() noexcept {
+  sampleBatch();
+  if (running_) {
+    scheduleTimeout(samplePeriod_);
+  }
+}
+
+void ConnectionQualitySampler::sampleBatch() {
+  if (sessions_.empty()) {
+    return;
+  }
+  const size_t numToSample = std::min(batchSize_, sessions_.size());
+  const auto now = std::chrono::steady_clock::now();
+  const auto nowMs = millisecondsSinceEpoch();
+  for (size_t i = 0; i < numToSample; i++) {
+    auto& entry = sessions_[cursor_ % sessions_.size()];
+    cursor_++;
+    wangle::TransportInfo tinfo;
+    // The updating variant refreshes the session's cached transport info
+    // too, so handlers read fresh rtt/rtx without their own syscalls
+    if (!entry.session->getCurrentTransportInfo(&tinfo)) {
+      continue;
+    }
+    Sample sample;
+    sample.time = nowMs;
+    sample.rttUs = tinfo.rtt.count() > 0 ? tinfo.rtt.count() : -1;
+    sample.cwndPackets = tinfo.cwnd;
+    if (entry.lastRetransmits >= 0 && tinfo.rtx >= entry.lastRetransmits) {
+      sample.retransmits = tinfo.rtx - entry.lastRetransmits;
+    }
+    if (entry.lastTotalBytes >= 0 && tinfo.totalBytes >= entry.lastTotalBytes) {
+      auto elapsedUs = std::chrono::duration_cast<std::chrono::microseconds>(
+                           now - entry.lastSampleTime)
+                           .count();
+      if (elapsedUs > 0) {
+        sample.sendRateBytesPerSec =
+            (tinfo.totalBytes - entry.lastTotalBytes) * 1000000 / elapsedUs;
+      }
+    }
+    entry.lastRetransmits = tinfo.rtx;
+    entry.lastTotalBytes = tinfo.totalBytes;
+    entry.lastSampleTime = now;
+    recordSample(sample);
+  }
+}
+
+void ConnectionQualitySampler::recordSample(const Sample& sample) {
+  std::lock_guard<std::mutex> guard(ringMutex_);
+  ring_[sampleCount_ % kRingSize] = sample;
+  sampleCount_++;
+}
+
+ConnectionQualitySampler::Summary ConnectionQualitySampler::getSummary()
+    const {
+  Summary summary;
+  std::lock_guard<std::mutex> guard(ringMutex_);
+  summary.sampleCount = sampleCount_;
+  const size_t retained = std::min<uint64_t>(sampleCount_, kRingSize);
+  uint64_t rttSamples = 0;
+  uint64_t cwndSamples = 0;
+  uint64_t rateSamples = 0;
+  double rttSumUs = 0;
+  double cwndSum = 0;
+  double rateSum = 0;
+  for (size_t i = 0; i < retained; i++) {
+    const auto& sample = ring_[i];
+    if (sample.rttUs >= 0) {
+      rttSumUs += sample.rttUs;
+      summary.maxRttUs = std::max(summary.maxRttUs, sample.rttUs);
+      rttSamples++;
+    }
+    if (sample.cwndPackets >= 0) {
+      cwndSum += sample.cwndPackets;
+      cwndSamples++;
+    }
+    if (sample.sendRateBytesPerSec >= 0) {
+      rateSum += sample.sendRateBytesPerSec;
+      rateSamples++;
+    }
+    summary.retransmits += sample.retransmits;
+  }
+  if (rttSamples > 0) {
+    summary.avgRttUs = rttSumUs / rttSamples;
+  }
+  if (cwndSamples > 0) {
+    summary.avgCwndPackets = cwndSum / cwndSamples;
+  }
+  if (rateSamples > 0) {
+    summary.avgSendRateBytesPerSec = rateSum / rateSamples;
+  }
+  return summary;
+}
+
+} // namespace proxygen
@@ -0,0 +1,149 @@
+/*
+ *  Copyright (c) 2015-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <folly/io/async/AsyncTimeout.h>
+#include <folly/io/async/EventBase.h>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace proxygen {
+
+class HTTPSessionBase;
+
+/**
+ * Periodic transport quality sampling for the sessions of one worker.
+ *
+ * Every sample period the sampler schedules itself at the end of the
+ * current event loop iteration and reads TCP_INFO for the next batchSize
+ * registered sessions, round robin, so the getsockopt cost is bounded and
+ * paid in one batch after the loop's request work rather than scattered
+ * through it.  Reading through HTTPSessionBase::getCurrentTransportInfo
+ * also refreshes the session's cached transport info, so request handlers
+ * get up-to-date rtt and retransmit data from the cached copy without
+ * issuing their own syscalls.
+ *
+ * Each reading lands in a fixed ring as a compact sample (rtt, cwnd,
+ * retransmits and send rate since the session's previous sample).
+ * getSummary() aggregates the ring and may be called from any thread,
+ * e.g. by a Resources implementation feeding ResourceData/ResourceStats;
+ * everything else must run on the worker's EventBase.
+ *
+ * See HTTPSessionAcceptor::enableConnectionQualitySampling for wiring.
+ */
+class ConnectionQualitySampler
+    : private folly::AsyncTimeout
+    , private folly::EventBase::LoopCallback {
+ public:
+  static constexpr std::chrono::milliseconds kDefaultSamplePeriod{100};
+  static constexpr size_t kDefaultBatchSize = 16;
+
+  // Number of samples retained; old samples are overwritten.
+  static constexpr size_t kRingSize = 256;
+
+  struct Sample {
+    // Time the sample was taken, ms since epoch.
+    std::chrono::milliseconds time{0};
+    // Smoothed round-trip time in usec, -1 if unavailable.
+    int64_t rttUs{-1};
+    // Congestion window in packets, -1 if unavailable.
+    int64_t cwndPackets{-1};
+    // Retransmits since the same session's previous sample.
+    int64_t retransmits{0};
+    // Bytes written to the transport per second since the same session's
+    // previous sample, -1 for a session's first sample.
+    int64_t sendRateBytesPerSec{-1};
+  };
+
+  struct Summary {
+    // Total samples recorded, including ones no longer in the ring.
+    uint64_t sampleCount{0};
+    // Aggregates over the samples still in the ring; rtt and cwnd
+    // averages skip samples where the field was unavailable.
+    double avgRttUs{0};
+    int64_t maxRttUs{0};
+    double avgCwndPackets{0};
+    uint64_t retransmits{0};
+    double avgSendRateBytesPerSec{0};
+  };
+
+  explicit ConnectionQualitySampler(
+      folly::EventBase* eventBase,
+      std::chrono::milliseconds samplePeriod = kDefaultSamplePeriod,
+      size_t batchSize = kDefaultBatchSize);
+
+  ~ConnectionQualitySampler() override;
+
+  /**
+   * Start and stop the periodic sampling.  Registered sessions are kept
+   * across a stop/start cycle.
+   */
+  void start();
+  void stop();
+
+  /**
+   * Register a session for sampling.  The caller must remove the session
+   * before it is destroyed (see HTTPSessionAcceptor::onDestroy).
+   */
+  void addSession(HTTPSessionBase* session);
+  void removeSession(HTTPSessionBase* session);
+
+  size_t getNumSessions() const {
+    return sessions_.size();
+  }
+
+  /**
+   * Appends a sample to the ring.  Called by the batch sampling path;
+   * public so alternative feeders (and tests) can record samples taken
+   * elsewhere.
+   */
+  void recordSample(const Sample& sample);
+
+  /**
+   * Aggregates the retained samples.  May be called from any thread.
+   */
+  Summary getSummary() const;
+
+ private:
+  void timeoutExpired() noexcept override;
+  void runLoopCallback() noexcept override;
+  void sampleBatch();
+
+  folly::EventBase* eventBase_{nullptr};
+  const std::chrono::milliseconds samplePeriod_;
+  const size_t batchSize_;
+  bool running_{false};
+
+  struct SessionEntry {
+    HTTPSessionBase* session{nullptr};
+    // Cumulative counters at the previous sample, for deltas; -1 until
+    // the session has been sampled once.
+    int64_t lastRetransmits{-1};
+    int64_t lastTotalBytes{-1};
+    std::chrono::steady_clock::time_point lastSampleTime;
+  };
+
+  /** Registered sessions; cursor_ walks this round robin across batches */
+  std::vector<SessionEntry> sessions_;
+  /** Index of each session in sessions_, for O(1) swap-pop removal */
+  std::unordered_map<HTTPSessionBase*, size_t> sessionIndex_;
+  size_t cursor_{0};
+
+  /** Guards the ring so getSummary() can run off-thread */
+  mutable std::mutex ringMutex_;
+  std::array<Sample, kRingSize> ring_;
+  uint64_t sampleCount_{0};
+};
+
+} // namespace proxygen
@@ -49,6 +49,23 @@ class HTTPAcceptor : public wangle::Acceptor {
   const AcceptorConfiguration& getConfig() const {
     return accConfig_;
   }
+
+  /**
+   * Replace this acceptor's configuration in place.  Must be called on
+   * the acceptor's event base, so the swap lands at a loop boundary with
+   * no locking against the request path.  Connections accepted after the
+   * call see the new values (including the transaction idle timeout and
+   * anything the codec factory reads through its config reference);
+   * established connections keep the settings they were created with, and
+   * the listener-level socket/TLS configuration held by wangle::Acceptor
+   * is not touched.
+   */
+  virtual void updateConfig(AcceptorConfiguration config) {
+    accConfig_ = std::move(config);
+    if (timer_) {
+      timer_->setDefaultTimeout(accConfig_.transactionIdleTimeout);
+    }
+  }
   const wangle::ServerSocketConfig& getServerSocketConfig() {
     return Acceptor::getConfig();
   }
@@ -11,6 +11,8 @@
 
 #include <folly/io/async/EventBaseManager.h>
 #include <proxygen/lib/services/ServiceWorker.h>
+#include <proxygen/lib/services/WorkerMemoryLedger.h>
+#include <proxygen/lib/services/WorkerThreadProfiler.h>
 
 namespace proxygen {
 
@@ -21,6 +23,8 @@ RequestWorkerThread::RequestWorkerThread(
   FinishCallback& callback, uint8_t threadId, const std::string& evbName)
     : WorkerThread(folly::EventBaseManager::get(), evbName),
       nextRequestId_(static_cast<uint64_t>(threadId) << requestIdBits),
+      profiler_(std::make_shared<WorkerThreadProfiler>(this)),
+      memoryLedger_(std::make_shared<WorkerMemoryLedger>()),
       callback_(callback) {
 }
 
@@ -44,10 +48,12 @@ void RequestWorkerThread::flushStats() {
 
 void RequestWorkerThread::setup() {
   WorkerThread::setup();
+  getEventBase()->setObserver(profiler_);
   callback_.workerStarted(this);
 }
 
 void RequestWorkerThread::cleanup() {
+  getEventBase()->setObserver(nullptr);
   WorkerThread::cleanup();
   callback_.workerFinished(this);
 }
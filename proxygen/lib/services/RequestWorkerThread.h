@@ -11,12 +11,15 @@
 
 #include <cstdint>
 #include <map>
+#include <memory>
 #include <proxygen/lib/services/WorkerThread.h>
 
 namespace proxygen {
 
 class Service;
 class ServiceWorker;
+class WorkerMemoryLedger;
+class WorkerThreadProfiler;
 
 /**
  * RequestWorkerThread extends WorkerThread, and also contains a list of
@@ -52,6 +55,35 @@ class RequestWorkerThread : public WorkerThread {
    */
   uint8_t getWorkerId() const;
 
+  /**
+   * Return the id nextRequestId() will hand out next on this worker.
+   * Only meaningful when called from within the worker thread.
+   */
+  uint64_t getNextRequestId() const {
+    return nextRequestId_;
+  }
+
+  /**
+   * Return the sampling event loop profiler for this worker.  The profiler
+   * is attached to the EventBase for the lifetime of the worker's loop; see
+   * WorkerThreadProfiler for what it records and how to export it through
+   * ResourceStats.
+   */
+  const std::shared_ptr<WorkerThreadProfiler>& getProfiler() const {
+    return profiler_;
+  }
+
+  /**
+   * Return this worker's memory ledger.  Pools owned by the worker
+   * (session buffers, transaction slabs, compression contexts, header
+   * arenas) debit and credit it as they grow and shrink; see
+   * WorkerMemoryLedger for the accounting model and how the data feeds
+   * ResourceStats and admission control.
+   */
+  const std::shared_ptr<WorkerMemoryLedger>& getMemoryLedger() const {
+    return memoryLedger_;
+  }
+
   static RequestWorkerThread* getRequestWorkerThread() {
     RequestWorkerThread* self = dynamic_cast<RequestWorkerThread*>(
       WorkerThread::getCurrentWorkerThread());
@@ -95,6 +127,14 @@ class RequestWorkerThread : public WorkerThread {
   // The ServiceWorkers executing in this worker
   std::map<Service*, ServiceWorker*> serviceWorkers_;
 
+  // Samples this worker's event loop; attached in setup(), detached in
+  // cleanup()
+  std::shared_ptr<WorkerThreadProfiler> profiler_;
+
+  // Memory held by this worker's pools; debited/credited by the pools
+  // themselves
+  std::shared_ptr<WorkerMemoryLedger> memoryLedger_;
+
   FinishCallback& callback_;
 };
 
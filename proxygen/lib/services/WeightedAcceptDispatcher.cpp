@@ -0,0 +1,77 @@
+/*
+ *  Copyright (c) 2015-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include <proxygen/lib/services/WeightedAcceptDispatcher.h>
+
+#include <folly/FileUtil.h>
+#include <glog/logging.h>
+
+namespace proxygen {
+
+void WeightedAcceptDispatcher::addWorker(
+    folly::EventBase* evb,
+    folly::AsyncServerSocket::AcceptCallback* callback) {
+  workers_.push_back(Worker{CHECK_NOTNULL(evb), CHECK_NOTNULL(callback)});
+}
+
+size_t WeightedAcceptDispatcher::pickWorker() {
+  DCHECK(!workers_.empty());
+  // getAvgLoopTime is an exponentially-smoothed per-loop busy time and
+  // is safe to read from off the loop; the same signal drives admission
+  // control and idle-session rebalancing
+  size_t best = scanStart_;
+  double bestLoad = workers_[best].evb->getAvgLoopTime();
+  for (size_t i = 1; i < workers_.size(); i++) {
+    const size_t idx = (scanStart_ + i) % workers_.size();
+    const double load = workers_[idx].evb->getAvgLoopTime();
+    if (load < bestLoad) {
+      best = idx;
+      bestLoad = load;
+    }
+  }
+  scanStart_ = (scanStart_ + 1) % workers_.size();
+  return best;
+}
+
+void WeightedAcceptDispatcher::connectionAccepted(
+    int fd, const folly::SocketAddress& clientAddr) noexcept {
+  const auto& worker = workers_[pickWorker()];
+  auto callback = worker.callback;
+  if (!worker.evb->runInEventBaseThread(
+          [callback, fd, clientAddr]() noexcept {
+            callback->connectionAccepted(fd, clientAddr);
+          })) {
+    // Worker loop is gone (shutdown race); don't leak the connection
+    LOG(ERROR) << "failed to dispatch accepted connection from "
+               << clientAddr << ", closing";
+    folly::closeNoInt(fd);
+  }
+}
+
+void WeightedAcceptDispatcher::acceptError(const std::exception& ex) noexcept {
+  LOG(ERROR) << "accept error: " << ex.what();
+}
+
+void WeightedAcceptDispatcher::acceptStarted() noexcept {
+  for (auto& worker : workers_) {
+    auto callback = worker.callback;
+    worker.evb->runInEventBaseThread(
+        [callback]() noexcept { callback->acceptStarted(); });
+  }
+}
+
+void WeightedAcceptDispatcher::acceptStopped() noexcept {
+  for (auto& worker : workers_) {
+    auto callback = worker.callback;
+    worker.evb->runInEventBaseThread(
+        [callback]() noexcept { callback->acceptStopped(); });
+  }
+}
+
+} // namespace proxygen
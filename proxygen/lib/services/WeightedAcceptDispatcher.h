@@ -0,0 +1,70 @@
+/*
+ *  Copyright (c) 2015-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#pragma once
+
+#include <folly/io/async/AsyncServerSocket.h>
+#include <folly/io/async/EventBase.h>
+#include <vector>
+
+namespace proxygen {
+
+/**
+ * Load-aware replacement for AsyncServerSocket's round-robin accept
+ * dispatch.
+ *
+ * Instead of registering one accept callback per worker (which makes
+ * the server socket rotate blindly between them), register a single
+ * dispatcher on the accept thread and add each worker's event base and
+ * accept callback to it.  Every accepted fd is forwarded to the worker
+ * whose event base currently reports the lowest smoothed loop time, so
+ * new connections land on the least-loaded loop rather than the next
+ * one in line.  With heterogeneous connection cost, round-robin
+ * routinely strands capacity on lightly-loaded workers while others lag.
+ *
+ * Ties (e.g. an idle server, where every loop time is zero) fall back
+ * to rotation so the dispatcher never herds connections onto one
+ * worker.  Workers must be added before the socket starts accepting and
+ * must outlive the dispatcher; the forwarded callback runs on the
+ * worker's event base, exactly as if it had been registered directly.
+ *
+ * This helps deployments dispatching from one accept thread; under
+ * SO_REUSEPORT sharding the kernel owns the placement decision instead.
+ */
+class WeightedAcceptDispatcher : public folly::AsyncServerSocket::AcceptCallback {
+ public:
+  void addWorker(folly::EventBase* evb,
+                 folly::AsyncServerSocket::AcceptCallback* callback);
+
+  // AcceptCallback; runs on the accept thread
+  void connectionAccepted(int fd,
+                          const folly::SocketAddress& clientAddr)
+      noexcept override;
+  void acceptError(const std::exception& ex) noexcept override;
+  void acceptStarted() noexcept override;
+  void acceptStopped() noexcept override;
+
+  size_t getNumWorkers() const {
+    return workers_.size();
+  }
+
+ private:
+  struct Worker {
+    folly::EventBase* evb;
+    folly::AsyncServerSocket::AcceptCallback* callback;
+  };
+
+  size_t pickWorker();
+
+  std::vector<Worker> workers_;
+  // Rotating scan start so ties distribute instead of herding
+  size_t scanStart_{0};
+};
+
+} // namespace proxygen
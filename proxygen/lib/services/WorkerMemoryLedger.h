@@ -0,0 +1,128 @@
+/*
+ *  Copyright (c) 2015-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+namespace proxygen {
+
+/**
+ * A per-worker ledger of the memory held by that worker's pools:
+ * session read/write buffers, pooled transaction storage, compression
+ * contexts, header arenas.  Pools debit on allocation and credit on
+ * release; both are single relaxed atomic adds, cheap enough for hot
+ * paths.  The ledger is deliberately approximate -- it tracks what the
+ * pools report, not RSS -- but unlike RSS it is attributable to one
+ * worker and it moves immediately with the load on that worker.
+ *
+ * A soft limit may be configured; overSoftLimit() is intended as an
+ * admission-control input (see HTTPSessionAcceptor::isOverloaded) so a
+ * worker sheds new work while its pools are bloated instead of growing
+ * until the kernel OOM killer picks the process.  getSummary() may be
+ * called from any thread, e.g. by a Resources implementation feeding
+ * ResourceData/ResourceStats.
+ */
+class WorkerMemoryLedger {
+ public:
+  enum class Category : uint8_t {
+    SessionBuffers = 0,   // session read and write buffers
+    TransactionSlabs,     // pooled transaction storage
+    CompressionContexts,  // HPACK/QPACK tables, deflate/zstd state
+    HeaderArenas,         // header interning and arena storage
+    Other,
+  };
+  static constexpr size_t kNumCategories = 5;
+
+  struct Summary {
+    std::array<uint64_t, kNumCategories> categoryBytes{{}};
+    uint64_t totalBytes{0};
+    uint64_t peakBytes{0};
+    uint64_t softLimitBytes{0};
+
+    bool overSoftLimit() const {
+      return softLimitBytes != 0 && totalBytes > softLimitBytes;
+    }
+  };
+
+  void debit(Category cat, uint64_t bytes) {
+    auto total = totalBytes_.fetch_add(bytes, std::memory_order_relaxed) +
+        bytes;
+    categoryBytes_[idx(cat)].fetch_add(bytes, std::memory_order_relaxed);
+    // Advisory peak; a racing store may miss a transient maximum
+    if (total > peakBytes_.load(std::memory_order_relaxed)) {
+      peakBytes_.store(total, std::memory_order_relaxed);
+    }
+  }
+
+  void credit(Category cat, uint64_t bytes) {
+    totalBytes_.fetch_sub(bytes, std::memory_order_relaxed);
+    categoryBytes_[idx(cat)].fetch_sub(bytes, std::memory_order_relaxed);
+  }
+
+  uint64_t getTotalBytes() const {
+    return totalBytes_.load(std::memory_order_relaxed);
+  }
+
+  uint64_t getPeakBytes() const {
+    return peakBytes_.load(std::memory_order_relaxed);
+  }
+
+  uint64_t getCategoryBytes(Category cat) const {
+    return categoryBytes_[idx(cat)].load(std::memory_order_relaxed);
+  }
+
+  /**
+   * 0 disables the limit.  May be changed at runtime from any thread.
+   */
+  void setSoftLimitBytes(uint64_t limitBytes) {
+    softLimitBytes_.store(limitBytes, std::memory_order_relaxed);
+  }
+
+  uint64_t getSoftLimitBytes() const {
+    return softLimitBytes_.load(std::memory_order_relaxed);
+  }
+
+  bool overSoftLimit() const {
+    auto limit = softLimitBytes_.load(std::memory_order_relaxed);
+    return limit != 0 &&
+        totalBytes_.load(std::memory_order_relaxed) > limit;
+  }
+
+  /**
+   * Snapshots the ledger.  Category bytes and the total are read
+   * independently, so the snapshot may be slightly torn under
+   * concurrent traffic; fine for stats.
+   */
+  Summary getSummary() const {
+    Summary summary;
+    for (size_t i = 0; i < kNumCategories; i++) {
+      summary.categoryBytes[i] =
+          categoryBytes_[i].load(std::memory_order_relaxed);
+    }
+    summary.totalBytes = getTotalBytes();
+    summary.peakBytes = getPeakBytes();
+    summary.softLimitBytes = getSoftLimitBytes();
+    return summary;
+  }
+
+ private:
+  static size_t idx(Category cat) {
+    return static_cast<size_t>(cat);
+  }
+
+  std::atomic<uint64_t> totalBytes_{0};
+  std::atomic<uint64_t> peakBytes_{0};
+  std::atomic<uint64_t> softLimitBytes_{0};
+  std::array<std::atomic<uint64_t>, kNumCategories> categoryBytes_{};
+};
+
+} // namespace proxygen
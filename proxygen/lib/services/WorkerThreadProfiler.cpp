@@ -0,0 +1,124 @@
+/*
+ *  Copyright (c) 2015-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include <proxygen/lib/services/WorkerThreadProfiler.h>
+
+#include <algorithm>
+#include <folly/lang/Bits.h>
+#include <glog/logging.h>
+#include <proxygen/lib/services/RequestWorkerThread.h>
+#include <proxygen/lib/utils/Time.h>
+
+namespace proxygen {
+
+constexpr uint32_t WorkerThreadProfiler::kDefaultSampleRate;
+constexpr size_t WorkerThreadProfiler::kNumBuckets;
+constexpr size_t WorkerThreadProfiler::kNumSlowSamples;
+
+WorkerThreadProfiler::WorkerThreadProfiler(RequestWorkerThread* worker,
+                                           uint32_t sampleRate)
+    : worker_(CHECK_NOTNULL(worker)),
+      sampleRate_(std::max(sampleRate, 1u)) {
+  for (auto& bucket : busyHistogram_) {
+    bucket.store(0, std::memory_order_relaxed);
+  }
+}
+
+size_t WorkerThreadProfiler::getBucket(int64_t busyTimeUs) {
+  if (busyTimeUs <= 0) {
+    return 0;
+  }
+  return std::min<size_t>(
+      folly::findLastSet(static_cast<uint64_t>(busyTimeUs)) - 1,
+      kNumBuckets - 1);
+}
+
+void WorkerThreadProfiler::loopSample(int64_t busyTime, int64_t idleTime) {
+  sampledLoops_.fetch_add(1, std::memory_order_relaxed);
+  busyTimeSumUs_.fetch_add(busyTime, std::memory_order_relaxed);
+  idleTimeSumUs_.fetch_add(idleTime, std::memory_order_relaxed);
+  busyHistogram_[getBucket(busyTime)].fetch_add(1, std::memory_order_relaxed);
+
+  if (busyTime <= slowThresholdUs_.load(std::memory_order_relaxed)) {
+    return;
+  }
+
+  SlowSample sample;
+  sample.busyTimeUs = busyTime;
+  sample.nextRequestId = worker_->getNextRequestId();
+  sample.time = millisecondsSinceEpoch();
+
+  std::lock_guard<std::mutex> guard(slowSamplesMutex_);
+  auto slowest = std::min_element(
+      slowSamples_.begin(), slowSamples_.end(),
+      [] (const SlowSample& a, const SlowSample& b) {
+        return a.busyTimeUs < b.busyTimeUs;
+      });
+  // The threshold check above is only a racy fast path; re-check under the
+  // mutex before evicting.
+  if (sample.busyTimeUs > slowest->busyTimeUs) {
+    *slowest = sample;
+    slowest = std::min_element(
+        slowSamples_.begin(), slowSamples_.end(),
+        [] (const SlowSample& a, const SlowSample& b) {
+          return a.busyTimeUs < b.busyTimeUs;
+        });
+    slowThresholdUs_.store(slowest->busyTimeUs, std::memory_order_relaxed);
+  }
+}
+
+WorkerThreadProfiler::Summary WorkerThreadProfiler::getSummary() const {
+  Summary summary;
+  summary.sampledLoops = sampledLoops_.load(std::memory_order_relaxed);
+  summary.busyTimeSumUs = busyTimeSumUs_.load(std::memory_order_relaxed);
+  summary.idleTimeSumUs = idleTimeSumUs_.load(std::memory_order_relaxed);
+  for (size_t i = 0; i < kNumBuckets; i++) {
+    summary.busyHistogram[i] = busyHistogram_[i].load(
+        std::memory_order_relaxed);
+  }
+  {
+    std::lock_guard<std::mutex> guard(slowSamplesMutex_);
+    for (const auto& sample : slowSamples_) {
+      if (sample.busyTimeUs > 0) {
+        summary.slowSamples.push_back(sample);
+      }
+    }
+  }
+  std::sort(summary.slowSamples.begin(), summary.slowSamples.end(),
+            [] (const SlowSample& a, const SlowSample& b) {
+              return a.busyTimeUs > b.busyTimeUs;
+            });
+  return summary;
+}
+
+double WorkerThreadProfiler::Summary::getAvgBusyTimeUs() const {
+  if (sampledLoops == 0) {
+    return 0;
+  }
+  return static_cast<double>(busyTimeSumUs) / sampledLoops;
+}
+
+int64_t WorkerThreadProfiler::Summary::estimateBusyTimePctileUs(
+    double pctile) const {
+  if (sampledLoops == 0) {
+    return 0;
+  }
+  auto target = std::max<uint64_t>(
+      1, static_cast<uint64_t>(pctile * static_cast<double>(sampledLoops)));
+  uint64_t seen = 0;
+  for (size_t i = 0; i < kNumBuckets; i++) {
+    seen += busyHistogram[i];
+    if (seen >= target) {
+      return int64_t(1) << (i + 1);
+    }
+  }
+  return int64_t(1) << kNumBuckets;
+}
+
+} // proxygen
@@ -0,0 +1,117 @@
+/*
+ *  Copyright (c) 2015-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <folly/io/async/EventBase.h>
+#include <mutex>
+#include <vector>
+
+namespace proxygen {
+
+class RequestWorkerThread;
+
+/**
+ * An always-on sampling profiler for the event loop of a
+ * RequestWorkerThread.
+ *
+ * The profiler hangs off folly's EventBaseObserver hook, so every
+ * sampleRate-th loop iteration reports its busy and idle time.  Those
+ * samples are folded into:
+ *  - a log2 histogram of iteration busy time, exposing the latency
+ *    composition of the loop (many short iterations vs a few long stalls),
+ *  - running busy/idle time totals, and
+ *  - the slowest sampled iterations, each tagged with the next request id
+ *    the worker was going to hand out, so a stall can be correlated with
+ *    the requests in flight at the time via the request id log.
+ *
+ * The sampling path runs inline in the worker thread and only touches
+ * relaxed atomics; the slow-sample list takes a mutex only when a sample
+ * beats the current slowest set.  getSummary() is safe to call from any
+ * thread and is intended as the feed for a Resources implementation so the
+ * data can be exported through ResourceStats.
+ */
+class WorkerThreadProfiler : public folly::EventBaseObserver {
+ public:
+  // Sample every 16th loop iteration unless told otherwise.
+  static constexpr uint32_t kDefaultSampleRate = 16;
+
+  // Number of log2 histogram buckets; bucket i counts sampled iterations
+  // with busy time in [2^i, 2^(i+1)) usec and the last bucket is a
+  // catch-all.
+  static constexpr size_t kNumBuckets = 24;
+
+  // Number of slowest sampled iterations retained.
+  static constexpr size_t kNumSlowSamples = 8;
+
+  struct SlowSample {
+    // Busy time of the sampled iteration in usec.
+    int64_t busyTimeUs{0};
+    // The id nextRequestId() was going to hand out on the worker when the
+    // sample was taken.
+    uint64_t nextRequestId{0};
+    // Time the sample was taken, ms since epoch.
+    std::chrono::milliseconds time{0};
+  };
+
+  struct Summary {
+    uint64_t sampledLoops{0};
+    int64_t busyTimeSumUs{0};
+    int64_t idleTimeSumUs{0};
+    std::array<uint64_t, kNumBuckets> busyHistogram{{}};
+    // Slowest sampled iterations, slowest first.
+    std::vector<SlowSample> slowSamples;
+
+    double getAvgBusyTimeUs() const;
+
+    /**
+     * Estimates the given busy time percentile (e.g. 0.99) from the
+     * histogram.  Returns the upper bound of the bucket the percentile
+     * falls in, so the estimate is only as fine as the bucket granularity.
+     */
+    int64_t estimateBusyTimePctileUs(double pctile) const;
+  };
+
+  explicit WorkerThreadProfiler(RequestWorkerThread* worker,
+                                uint32_t sampleRate = kDefaultSampleRate);
+
+  uint32_t getSampleRate() const override {
+    return sampleRate_;
+  }
+
+  void loopSample(int64_t busyTime, int64_t idleTime) override;
+
+  /**
+   * Snapshots the data recorded so far.  May be called from any thread.
+   */
+  Summary getSummary() const;
+
+ private:
+  static size_t getBucket(int64_t busyTimeUs);
+
+  RequestWorkerThread* const worker_;
+  const uint32_t sampleRate_;
+
+  std::atomic<uint64_t> sampledLoops_{0};
+  std::atomic<int64_t> busyTimeSumUs_{0};
+  std::atomic<int64_t> idleTimeSumUs_{0};
+  std::array<std::atomic<uint64_t>, kNumBuckets> busyHistogram_;
+
+  // Smallest busy time currently retained in slowSamples_, so the common
+  // case skips the mutex with a single relaxed load.
+  std::atomic<int64_t> slowThresholdUs_{0};
+  mutable std::mutex slowSamplesMutex_;
+  std::array<SlowSample, kNumSlowSamples> slowSamples_;
+};
+
+} // proxygen
@@ -0,0 +1,87 @@
+/*
+ *  Copyright (c) 2015-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include <proxygen/lib/services/ConnectionQualitySampler.h>
+
+#include <folly/io/async/EventBase.h>
+#include <folly/portability/GTest.h>
+
+using namespace proxygen;
+
+using Sample = ConnectionQualitySampler::Sample;
+
+namespace {
+
+Sample makeSample(int64_t rttUs,
+                  int64_t cwndPackets,
+                  int64_t retransmits,
+                  int64_t sendRateBytesPerSec) {
+  Sample sample;
+  sample.rttUs = rttUs;
+  sample.cwndPackets = cwndPackets;
+  sample.retransmits = retransmits;
+  sample.sendRateBytesPerSec = sendRateBytesPerSec;
+  return sample;
+}
+
+}
+
+class ConnectionQualitySamplerTest : public testing::Test {
+ protected:
+  folly::EventBase eventBase_;
+  ConnectionQualitySampler sampler_{&eventBase_};
+};
+
+TEST_F(ConnectionQualitySamplerTest, AggregatesSamples) {
+  sampler_.recordSample(makeSample(1000, 10, 0, 1000000));
+  sampler_.recordSample(makeSample(3000, 20, 2, 3000000));
+  // Unavailable rtt/cwnd/rate must not drag down the averages
+  sampler_.recordSample(makeSample(-1, -1, 1, -1));
+
+  auto summary = sampler_.getSummary();
+  EXPECT_EQ(summary.sampleCount, 3);
+  EXPECT_DOUBLE_EQ(summary.avgRttUs, 2000);
+  EXPECT_EQ(summary.maxRttUs, 3000);
+  EXPECT_DOUBLE_EQ(summary.avgCwndPackets, 15);
+  EXPECT_EQ(summary.retransmits, 3);
+  EXPECT_DOUBLE_EQ(summary.avgSendRateBytesPerSec, 2000000);
+}
+
+TEST_F(ConnectionQualitySamplerTest, EmptySummary) {
+  auto summary = sampler_.getSummary();
+  EXPECT_EQ(summary.sampleCount, 0);
+  EXPECT_DOUBLE_EQ(summary.avgRttUs, 0);
+  EXPECT_EQ(summary.maxRttUs, 0);
+  EXPECT_EQ(summary.retransmits, 0);
+}
+
+TEST_F(ConnectionQualitySamplerTest, RingOverwritesOldSamples) {
+  // Fill the ring with retransmitting samples, then overwrite every slot
+  // with clean ones; only the retained window should be aggregated
+  for (size_t i = 0; i < ConnectionQualitySampler::kRingSize; i++) {
+    sampler_.recordSample(makeSample(1000, 10, 1, -1));
+  }
+  for (size_t i = 0; i < ConnectionQualitySampler::kRingSize; i++) {
+    sampler_.recordSample(makeSample(2000, 10, 0, -1));
+  }
+
+  auto summary = sampler_.getSummary();
+  EXPECT_EQ(summary.sampleCount, 2 * ConnectionQualitySampler::kRingSize);
+  EXPECT_DOUBLE_EQ(summary.avgRttUs, 2000);
+  EXPECT_EQ(summary.retransmits, 0);
+}
+
+TEST_F(ConnectionQualitySamplerTest, StartStopWithoutSessions) {
+  // The periodic machinery must be safe to run with nothing registered
+  sampler_.start();
+  eventBase_.loopOnce(EVLOOP_NONBLOCK);
+  sampler_.stop();
+  EXPECT_EQ(sampler_.getNumSessions(), 0);
+  EXPECT_EQ(sampler_.getSummary().sampleCount, 0);
+}
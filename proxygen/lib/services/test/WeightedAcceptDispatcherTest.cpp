@@ -0,0 +1,75 @@
+/*
+ *  Copyright (c) 2015-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include <proxygen/lib/services/WeightedAcceptDispatcher.h>
+
+#include <atomic>
+#include <folly/FileUtil.h>
+#include <folly/io/async/ScopedEventBaseThread.h>
+#include <folly/portability/GTest.h>
+
+using namespace proxygen;
+
+namespace {
+
+class RecordingCallback : public folly::AsyncServerSocket::AcceptCallback {
+ public:
+  void connectionAccepted(int fd,
+                          const folly::SocketAddress&) noexcept override {
+    connections++;
+    folly::closeNoInt(fd);
+  }
+  void acceptError(const std::exception&) noexcept override {
+  }
+  void acceptStarted() noexcept override {
+    started++;
+  }
+  void acceptStopped() noexcept override {
+    stopped++;
+  }
+
+  std::atomic<uint32_t> connections{0};
+  std::atomic<uint32_t> started{0};
+  std::atomic<uint32_t> stopped{0};
+};
+
+} // namespace
+
+TEST(WeightedAcceptDispatcherTest, ForwardsToWorkerEventBases) {
+  folly::ScopedEventBaseThread worker1;
+  folly::ScopedEventBaseThread worker2;
+  RecordingCallback cb1;
+  RecordingCallback cb2;
+  WeightedAcceptDispatcher dispatcher;
+  dispatcher.addWorker(worker1.getEventBase(), &cb1);
+  dispatcher.addWorker(worker2.getEventBase(), &cb2);
+  EXPECT_EQ(dispatcher.getNumWorkers(), 2);
+
+  dispatcher.acceptStarted();
+
+  folly::SocketAddress clientAddr("127.0.0.1", 4242);
+  constexpr uint32_t kConnections = 8;
+  for (uint32_t i = 0; i < kConnections; i++) {
+    int fds[2];
+    PCHECK(pipe(fds) == 0);
+    folly::closeNoInt(fds[1]);
+    dispatcher.connectionAccepted(fds[0], clientAddr);
+  }
+  dispatcher.acceptStopped();
+
+  // Drain both worker loops before checking the counters
+  worker1.getEventBase()->runInEventBaseThreadAndWait([] {});
+  worker2.getEventBase()->runInEventBaseThreadAndWait([] {});
+
+  EXPECT_EQ(cb1.connections + cb2.connections, kConnections);
+  EXPECT_EQ(cb1.started, 1);
+  EXPECT_EQ(cb2.started, 1);
+  EXPECT_EQ(cb1.stopped, 1);
+  EXPECT_EQ(cb2.stopped, 1);
+}
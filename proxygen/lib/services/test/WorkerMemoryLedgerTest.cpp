@@ -0,0 +1,50 @@
+/*
+ *  Copyright (c) 2015-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include <proxygen/lib/services/WorkerMemoryLedger.h>
+
+#include <folly/portability/GTest.h>
+
+using namespace proxygen;
+
+using Category = WorkerMemoryLedger::Category;
+
+TEST(WorkerMemoryLedgerTest, DebitCredit) {
+  WorkerMemoryLedger ledger;
+  ledger.debit(Category::SessionBuffers, 1000);
+  ledger.debit(Category::CompressionContexts, 500);
+  EXPECT_EQ(ledger.getTotalBytes(), 1500);
+  EXPECT_EQ(ledger.getCategoryBytes(Category::SessionBuffers), 1000);
+  EXPECT_EQ(ledger.getCategoryBytes(Category::CompressionContexts), 500);
+  EXPECT_EQ(ledger.getCategoryBytes(Category::HeaderArenas), 0);
+
+  ledger.credit(Category::SessionBuffers, 1000);
+  EXPECT_EQ(ledger.getTotalBytes(), 500);
+  // The peak survives the credit
+  EXPECT_EQ(ledger.getPeakBytes(), 1500);
+}
+
+TEST(WorkerMemoryLedgerTest, SoftLimit) {
+  WorkerMemoryLedger ledger;
+  // No limit configured: never over
+  ledger.debit(Category::TransactionSlabs, 1 << 20);
+  EXPECT_FALSE(ledger.overSoftLimit());
+
+  ledger.setSoftLimitBytes(1 << 19);
+  EXPECT_TRUE(ledger.overSoftLimit());
+
+  ledger.credit(Category::TransactionSlabs, 1 << 20);
+  EXPECT_FALSE(ledger.overSoftLimit());
+
+  auto summary = ledger.getSummary();
+  EXPECT_EQ(summary.totalBytes, 0);
+  EXPECT_EQ(summary.peakBytes, 1 << 20);
+  EXPECT_EQ(summary.softLimitBytes, 1 << 19);
+  EXPECT_FALSE(summary.overSoftLimit());
+}
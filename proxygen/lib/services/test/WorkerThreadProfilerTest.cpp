@@ -0,0 +1,91 @@
+/*
+ *  Copyright (c) 2015-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include <proxygen/lib/services/WorkerThreadProfiler.h>
+
+#include <folly/portability/GTest.h>
+#include <proxygen/lib/services/RequestWorkerThread.h>
+
+using namespace proxygen;
+
+namespace {
+
+class DummyFinishCallback : public RequestWorkerThread::FinishCallback {
+ public:
+  void workerStarted(RequestWorkerThread*) override {}
+  void workerFinished(RequestWorkerThread*) override {}
+};
+
+}
+
+class WorkerThreadProfilerTest : public testing::Test {
+ protected:
+  DummyFinishCallback callback_;
+  RequestWorkerThread worker_{callback_, 1};
+};
+
+TEST_F(WorkerThreadProfilerTest, RecordsTotalsAndHistogram) {
+  WorkerThreadProfiler profiler(&worker_);
+
+  profiler.loopSample(1, 10);
+  profiler.loopSample(100, 20);
+  profiler.loopSample(5000, 0);
+
+  auto summary = profiler.getSummary();
+  EXPECT_EQ(summary.sampledLoops, 3);
+  EXPECT_EQ(summary.busyTimeSumUs, 5101);
+  EXPECT_EQ(summary.idleTimeSumUs, 30);
+  EXPECT_DOUBLE_EQ(summary.getAvgBusyTimeUs(), 5101.0 / 3);
+  // 1 -> [1, 2), 100 -> [64, 128), 5000 -> [4096, 8192)
+  EXPECT_EQ(summary.busyHistogram[0], 1);
+  EXPECT_EQ(summary.busyHistogram[6], 1);
+  EXPECT_EQ(summary.busyHistogram[12], 1);
+}
+
+TEST_F(WorkerThreadProfilerTest, EstimatesPercentiles) {
+  WorkerThreadProfiler profiler(&worker_);
+
+  for (int i = 0; i < 99; i++) {
+    profiler.loopSample(100, 0);
+  }
+  profiler.loopSample(100000, 0);
+
+  auto summary = profiler.getSummary();
+  // The bulk of the samples land in [64, 128) usec
+  EXPECT_EQ(summary.estimateBusyTimePctileUs(0.5), 128);
+  // The single stall lands in [65536, 131072) usec
+  EXPECT_EQ(summary.estimateBusyTimePctileUs(1.0), 131072);
+}
+
+TEST_F(WorkerThreadProfilerTest, KeepsSlowestSamples) {
+  WorkerThreadProfiler profiler(&worker_);
+
+  for (int64_t i = 1; i <= 20; i++) {
+    profiler.loopSample(i * 10, 0);
+  }
+
+  auto summary = profiler.getSummary();
+  ASSERT_EQ(summary.slowSamples.size(),
+            WorkerThreadProfiler::kNumSlowSamples);
+  // Slowest first, and only the 8 slowest survive
+  for (size_t i = 0; i < summary.slowSamples.size(); i++) {
+    EXPECT_EQ(summary.slowSamples[i].busyTimeUs, (20 - int64_t(i)) * 10);
+    EXPECT_EQ(summary.slowSamples[i].nextRequestId,
+              worker_.getNextRequestId());
+  }
+}
+
+TEST_F(WorkerThreadProfilerTest, AttachedWhileWorkerRuns) {
+  ASSERT_NE(worker_.getProfiler(), nullptr);
+  worker_.start();
+  EXPECT_EQ(worker_.getEventBase()->getObserver(), worker_.getProfiler());
+  worker_.stopWhenIdle();
+  worker_.wait();
+  EXPECT_EQ(worker_.getEventBase()->getObserver(), nullptr);
+}
@@ -229,6 +229,67 @@ struct ResourceData {
            pressureUdpMemLimit_ != 0 && minUdpMemLimit_ != 0;
   }
 
+  // Gets the memory currently held by worker pools, summed across all
+  // workers' ledgers (see WorkerMemoryLedger)
+  uint64_t getWorkerMemBytes() const {
+    return workerMemBytes_;
+  }
+
+  // Gets the highest single-worker pool memory peak observed
+  uint64_t getWorkerMemPeakBytes() const {
+    return workerMemPeakBytes_;
+  }
+
+  // Gets the aggregate worker pool memory soft limit; 0 when unset
+  uint64_t getWorkerMemSoftLimitBytes() const {
+    return workerMemSoftLimitBytes_;
+  }
+
+  // Gets worker pool memory as a ratio (0-1.0) of the aggregate soft limit
+  double getWorkerMemRatio() const {
+    return calculateRatio(workerMemBytes_, workerMemSoftLimitBytes_);
+  }
+
+  // Gets the number of workers currently over their memory soft limit
+  uint64_t getNumWorkersOverMemSoftLimit() const {
+    return workersOverMemSoftLimit_;
+  }
+
+  // Gets the number of event loop iterations sampled by worker profilers
+  uint64_t getEvbLoopSampleCount() const {
+    return evbLoopSampleCount_;
+  }
+
+  // Gets the average sampled event loop iteration busy time in usec
+  double getEvbLoopAvgBusyTimeUsec() const {
+    return evbLoopAvgBusyTimeUsec_;
+  }
+
+  // Gets the estimated p99 sampled event loop iteration busy time in usec
+  uint64_t getEvbLoopP99BusyTimeUsec() const {
+    return evbLoopP99BusyTimeUsec_;
+  }
+
+  // Gets the number of transport quality samples taken by worker samplers
+  uint64_t getTcpQualitySampleCount() const {
+    return tcpQualitySampleCount_;
+  }
+
+  // Gets the average sampled smoothed round-trip time in usec
+  double getTcpAvgRttUsec() const {
+    return tcpAvgRttUsec_;
+  }
+
+  // Gets the largest sampled smoothed round-trip time in usec
+  uint64_t getTcpMaxRttUsec() const {
+    return tcpMaxRttUsec_;
+  }
+
+  // Gets the retransmits counted across the retained samples
+  uint64_t getTcpRetransmits() const {
+    return tcpRetransmits_;
+  }
+
   /**
    * Gets the time (from epoch) when this record was created (so for
    * which the utilization metrics are valid).
@@ -276,6 +337,46 @@ struct ResourceData {
     maxUdpMemLimit_ = maxThreshold;
   }
 
+  /**
+   * Sets the structure fields describing aggregated worker pool memory
+   * (see WorkerMemoryLedger).
+   */
+  void setWorkerMemStats(uint64_t usedBytes,
+                         uint64_t peakBytes,
+                         uint64_t softLimitBytes,
+                         uint64_t workersOverSoftLimit) {
+    workerMemBytes_ = usedBytes;
+    workerMemPeakBytes_ = peakBytes;
+    workerMemSoftLimitBytes_ = softLimitBytes;
+    workersOverMemSoftLimit_ = workersOverSoftLimit;
+  }
+
+  /**
+   * Sets the structure fields describing aggregated worker event loop
+   * profiler data (see WorkerThreadProfiler).
+   */
+  void setEvbLoopStats(uint64_t sampleCount,
+                       double avgBusyTimeUsec,
+                       uint64_t p99BusyTimeUsec) {
+    evbLoopSampleCount_ = sampleCount;
+    evbLoopAvgBusyTimeUsec_ = avgBusyTimeUsec;
+    evbLoopP99BusyTimeUsec_ = p99BusyTimeUsec;
+  }
+
+  /**
+   * Sets the structure fields describing aggregated transport quality
+   * samples (see ConnectionQualitySampler).
+   */
+  void setTcpQualityStats(uint64_t sampleCount,
+                          double avgRttUsec,
+                          uint64_t maxRttUsec,
+                          uint64_t retransmits) {
+    tcpQualitySampleCount_ = sampleCount;
+    tcpAvgRttUsec_ = avgRttUsec;
+    tcpMaxRttUsec_ = maxRttUsec;
+    tcpRetransmits_ = retransmits;
+  }
+
   /**
    * Refreshes the time (from epoch) when this record was created (so for
    * which the utilization metrics are valid).
@@ -316,6 +417,17 @@ struct ResourceData {
   uint64_t maxUdpMemLimit_{0};
   uint64_t pressureUdpMemLimit_{0};
   uint64_t minUdpMemLimit_{0};
+  uint64_t evbLoopSampleCount_{0};
+  double evbLoopAvgBusyTimeUsec_{0};
+  uint64_t evbLoopP99BusyTimeUsec_{0};
+  uint64_t tcpQualitySampleCount_{0};
+  double tcpAvgRttUsec_{0};
+  uint64_t tcpMaxRttUsec_{0};
+  uint64_t tcpRetransmits_{0};
+  uint64_t workerMemBytes_{0};
+  uint64_t workerMemPeakBytes_{0};
+  uint64_t workerMemSoftLimitBytes_{0};
+  uint64_t workersOverMemSoftLimit_{0};
 
   // Refresh management fields
   std::chrono::milliseconds time_{0};
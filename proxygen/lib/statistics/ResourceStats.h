@@ -92,7 +92,9 @@ class ResourceStats {
   virtual const ResourceData& getPreviousLoadData() const;
 
  protected:
-  void updateCachedData();
+  // Virtual so subclasses can hook the refresh, e.g. to export the fresh
+  // data (see SharedResourceStats).
+  virtual void updateCachedData();
 
   /**
    * Abstraction that enables callers to provide their own implementations
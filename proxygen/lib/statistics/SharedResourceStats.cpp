@@ -0,0 +1,243 @@
+/*
+ *  Copyright (c) 2019-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include "proxygen/lib/statistics/SharedResourceStats.h"
+
+#include <fcntl.h>
+#include <glog/logging.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+size_t segmentSize(uint32_t numSlots) {
+  // The header gets a full slot worth of space so slot 0 starts on its
+  // own cache line like everybody else
+  return sizeof(proxygen::ShmResourceSlot) * (size_t(numSlots) + 1);
+}
+
+const proxygen::ShmResourceSlot* slotArray(const void* mapping) {
+  return reinterpret_cast<const proxygen::ShmResourceSlot*>(
+             static_cast<const char*>(mapping) +
+             sizeof(proxygen::ShmResourceSlot));
+}
+
+} // namespace
+
+namespace proxygen {
+
+SharedResourceStats::SharedResourceStats(std::unique_ptr<Resources> resources,
+                                         const std::string& segmentName,
+                                         uint32_t slotIndex,
+                                         uint32_t numSlots)
+    : ResourceStats(std::move(resources)) {
+  if (slotIndex >= numSlots) {
+    LOG(ERROR) << "Slot index " << slotIndex << " out of range for "
+               << numSlots << " slots; stats will not be exported";
+    return;
+  }
+  int fd = shm_open(segmentName.c_str(), O_RDWR | O_CREAT, 0644);
+  if (fd < 0) {
+    PLOG(ERROR) << "Unable to open shm segment " << segmentName
+                << "; stats will not be exported";
+    return;
+  }
+  size_t size = segmentSize(numSlots);
+  if (ftruncate(fd, size) != 0) {
+    PLOG(ERROR) << "Unable to size shm segment " << segmentName;
+    close(fd);
+    return;
+  }
+  void* mapping =
+      mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (mapping == MAP_FAILED) {
+    PLOG(ERROR) << "Unable to map shm segment " << segmentName;
+    return;
+  }
+
+  auto* header = static_cast<ShmResourceSegmentHeader*>(mapping);
+  if (header->magic.load(std::memory_order_acquire) ==
+      ShmResourceSegmentHeader::kMagic) {
+    if (header->version != ShmResourceSegmentHeader::kVersion ||
+        header->numSlots != numSlots) {
+      LOG(ERROR) << "Shm segment " << segmentName
+                 << " has incompatible layout (version " << header->version
+                 << ", " << header->numSlots
+                 << " slots); stats will not be exported";
+      munmap(mapping, size);
+      return;
+    }
+  } else {
+    // Concurrent first attachers race benignly here; they write
+    // identical values
+    header->version = ShmResourceSegmentHeader::kVersion;
+    header->numSlots = numSlots;
+    header->magic.store(ShmResourceSegmentHeader::kMagic,
+                        std::memory_order_release);
+  }
+
+  mapping_ = mapping;
+  mappingSize_ = size;
+  slot_ = const_cast<ShmResourceSlot*>(slotArray(mapping)) + slotIndex;
+  publish(getCurrentLoadData());
+}
+
+SharedResourceStats::~SharedResourceStats() {
+  // The refresh thread calls our updateCachedData override; it must be
+  // gone before the mapping is
+  stopRefresh();
+  if (mapping_) {
+    munmap(mapping_, mappingSize_);
+  }
+}
+
+void SharedResourceStats::updateCachedData() {
+  ResourceStats::updateCachedData();
+  if (slot_) {
+    publish(getCurrentLoadData());
+  }
+}
+
+void SharedResourceStats::publish(const ResourceData& data) {
+  auto seq = slot_->seq.load(std::memory_order_relaxed);
+  slot_->seq.store(seq + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+
+  auto& payload = slot_->data;
+  payload.pid = getpid();
+  payload.lastUpdateTimeMs = data.getLastUpdateTime().count();
+  payload.cpuRatioUtil = data.getCpuRatioUtil();
+  payload.cpuSoftIrqRatioUtil = data.getSoftIrqCpuRatioUtil();
+  payload.usedMemBytes = data.getUsedMemBytes();
+  payload.totalMemBytes = data.getTotalMemBytes();
+  payload.tcpMemoryPages = data.getTcpMemPages();
+  payload.maxTcpMemLimit = data.getMaxTcpMemLimitPages();
+  payload.pressureTcpMemLimit = data.getPressureTcpMemLimitPages();
+  payload.minTcpMemLimit = data.getLowTcpMemLimitPages();
+  payload.udpMemoryPages = data.getUdpMemPages();
+  payload.maxUdpMemLimit = data.getMaxUdpMemLimitPages();
+  payload.pressureUdpMemLimit = data.getPressureUdpMemLimitPages();
+  payload.minUdpMemLimit = data.getLowUdpMemLimitPages();
+
+  std::atomic_thread_fence(std::memory_order_release);
+  slot_->seq.store(seq + 2, std::memory_order_relaxed);
+}
+
+SharedResourceStatsReader::SharedResourceStatsReader(
+    const std::string& segmentName) {
+  int fd = shm_open(segmentName.c_str(), O_RDONLY, 0);
+  if (fd < 0) {
+    PLOG(WARNING) << "Unable to open shm segment " << segmentName;
+    return;
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0 ||
+      size_t(st.st_size) < sizeof(ShmResourceSegmentHeader)) {
+    LOG(WARNING) << "Shm segment " << segmentName << " is malformed";
+    close(fd);
+    return;
+  }
+  size_t size = st.st_size;
+  void* mapping = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (mapping == MAP_FAILED) {
+    PLOG(WARNING) << "Unable to map shm segment " << segmentName;
+    return;
+  }
+
+  auto* header = static_cast<const ShmResourceSegmentHeader*>(mapping);
+  if (header->magic.load(std::memory_order_acquire) !=
+          ShmResourceSegmentHeader::kMagic ||
+      header->version != ShmResourceSegmentHeader::kVersion ||
+      size < segmentSize(header->numSlots)) {
+    LOG(WARNING) << "Shm segment " << segmentName
+                 << " has incompatible layout";
+    munmap(mapping, size);
+    return;
+  }
+
+  mapping_ = mapping;
+  mappingSize_ = size;
+  header_ = header;
+  slots_ = slotArray(mapping);
+}
+
+SharedResourceStatsReader::~SharedResourceStatsReader() {
+  if (mapping_) {
+    munmap(mapping_, mappingSize_);
+  }
+}
+
+bool SharedResourceStatsReader::readSlot(const ShmResourceSlot& slot,
+                                         ShmResourcePayload& out) const {
+  // A writer stalled mid-publish bounds the retries; bail rather than
+  // spin forever on its slot
+  for (int attempt = 0; attempt < 16; attempt++) {
+    auto seqBefore = slot.seq.load(std::memory_order_acquire);
+    if (seqBefore == 0 || (seqBefore & 1)) {
+      continue;
+    }
+    out = slot.data;
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (slot.seq.load(std::memory_order_relaxed) == seqBefore) {
+      return true;
+    }
+  }
+  return false;
+}
+
+size_t SharedResourceStatsReader::readMerged(
+    ResourceData& data, std::chrono::milliseconds staleness) const {
+  if (!header_) {
+    return 0;
+  }
+  auto now = ResourceData::getEpochTime().count();
+  size_t live = 0;
+  ShmResourcePayload freshest;
+  for (uint32_t i = 0; i < header_->numSlots; i++) {
+    ShmResourcePayload copy;
+    if (!readSlot(slots_[i], copy)) {
+      continue;
+    }
+    if (copy.lastUpdateTimeMs + uint64_t(staleness.count()) <
+        uint64_t(now)) {
+      // Slot owner is gone or wedged; do not let it pin old data
+      continue;
+    }
+    live++;
+    if (copy.lastUpdateTimeMs > freshest.lastUpdateTimeMs) {
+      freshest = copy;
+    }
+  }
+  if (live == 0) {
+    return 0;
+  }
+
+  // The exported fields are host-wide measurements, so "merging" is
+  // taking the freshest sample rather than summing per-process values
+  data.setCpuStats(freshest.cpuRatioUtil,
+                   freshest.cpuSoftIrqRatioUtil,
+                   std::vector<double>());
+  data.setMemStats(freshest.usedMemBytes, freshest.totalMemBytes);
+  data.setTcpMemStats(freshest.tcpMemoryPages,
+                      freshest.minTcpMemLimit,
+                      freshest.pressureTcpMemLimit,
+                      freshest.maxTcpMemLimit);
+  data.setUdpMemStats(freshest.udpMemoryPages,
+                      freshest.minUdpMemLimit,
+                      freshest.pressureUdpMemLimit,
+                      freshest.maxUdpMemLimit);
+  data.setLastUpdateTime(
+      std::chrono::milliseconds(freshest.lastUpdateTimeMs));
+  return live;
+}
+
+} // namespace proxygen
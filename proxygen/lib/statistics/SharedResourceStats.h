@@ -0,0 +1,145 @@
+/*
+ *  Copyright (c) 2019-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#pragma once
+
+#include "proxygen/lib/statistics/ResourceStats.h"
+#include <atomic>
+#include <string>
+
+namespace proxygen {
+
+/**
+ * Fixed-size, standard-layout snapshot of the scalar ResourceData fields,
+ * suitable for placement in a shared memory segment.  Each slot occupies
+ * its own set of cache lines (alignas below rounds the footprint up) so
+ * writers in different processes never contend on a line.
+ *
+ * Slots are published with a seqlock: seq is odd while a write is in
+ * flight and readers retry until they observe the same even value on
+ * both sides of the field copy.  The write path is a handful of plain
+ * stores plus two atomic stores; no syscalls and no locks.
+ *
+ * Note the alignment is a fixed 64 rather than
+ * folly::hardware_destructive_interference_size: the layout is shared
+ * across processes and must not vary with the flags a particular binary
+ * was compiled with.
+ */
+struct ShmResourcePayload {
+  uint64_t pid{0};
+  uint64_t lastUpdateTimeMs{0};
+  double cpuRatioUtil{0};
+  double cpuSoftIrqRatioUtil{0};
+  uint64_t usedMemBytes{0};
+  uint64_t totalMemBytes{0};
+  uint64_t tcpMemoryPages{0};
+  uint64_t maxTcpMemLimit{0};
+  uint64_t pressureTcpMemLimit{0};
+  uint64_t minTcpMemLimit{0};
+  uint64_t udpMemoryPages{0};
+  uint64_t maxUdpMemLimit{0};
+  uint64_t pressureUdpMemLimit{0};
+  uint64_t minUdpMemLimit{0};
+};
+
+struct alignas(64) ShmResourceSlot {
+  std::atomic<uint64_t> seq{0};
+  ShmResourcePayload data;
+};
+
+/**
+ * Header of the shared memory segment; checked by every attacher so a
+ * layout change cannot silently misread a segment left over from an
+ * older binary.
+ */
+struct ShmResourceSegmentHeader {
+  static const uint32_t kMagic = 0x50585253; // 'PXRS'
+  static const uint32_t kVersion = 1;
+
+  std::atomic<uint32_t> magic{0};
+  uint32_t version{0};
+  uint32_t numSlots{0};
+};
+
+/**
+ * SharedResourceStats:
+ *
+ * ResourceStats variant for hosts running multiple proxygen processes
+ * (e.g. SO_REUSEPORT sharding).  On top of the usual in-process behavior
+ * it publishes each refreshed ResourceData into a per-process slot of a
+ * named POSIX shared memory segment, letting a host-level reader (see
+ * SharedResourceStatsReader) merge snapshots across processes without
+ * scraping each one.  All shared memory failures degrade to plain
+ * in-process ResourceStats behavior; publishing is strictly best-effort.
+ *
+ * The slot index must be unique per process on the host, e.g. the
+ * SO_REUSEPORT shard id.  Segment creation and attachment are idempotent
+ * across processes; whichever process attaches first sizes and
+ * initializes the segment.
+ */
+class SharedResourceStats : public ResourceStats {
+ public:
+  SharedResourceStats(std::unique_ptr<Resources> resources,
+                      const std::string& segmentName,
+                      uint32_t slotIndex,
+                      uint32_t numSlots);
+
+  ~SharedResourceStats() override;
+
+ protected:
+  // Performs the base refresh and then publishes the fresh data into
+  // this process's slot.
+  void updateCachedData() override;
+
+ private:
+  void publish(const ResourceData& data);
+
+  ShmResourceSlot* slot_{nullptr};
+  void* mapping_{nullptr};
+  size_t mappingSize_{0};
+};
+
+/**
+ * Host-level reader counterpart of SharedResourceStats.  Attaches to the
+ * named segment read-only and produces merged ResourceData snapshots.
+ * As the exported fields are host-wide measurements, merging selects the
+ * freshest slot; slots that have not been updated within staleness are
+ * ignored so dead processes do not pin old data.
+ */
+class SharedResourceStatsReader {
+ public:
+  explicit SharedResourceStatsReader(const std::string& segmentName);
+
+  ~SharedResourceStatsReader();
+
+  // Returns true iff the segment was successfully attached and validated.
+  bool isAttached() const {
+    return header_ != nullptr;
+  }
+
+  /**
+   * Merges the live slots into data, returning the number of slots that
+   * contributed (0 leaves data untouched).
+   */
+  size_t readMerged(ResourceData& data,
+                    std::chrono::milliseconds staleness =
+                        std::chrono::milliseconds(60000)) const;
+
+ private:
+  // Seqlock-consistent copy of a single slot; returns false if the slot
+  // was never published or a consistent read could not be obtained.
+  bool readSlot(const ShmResourceSlot& slot, ShmResourcePayload& out) const;
+
+  const ShmResourceSegmentHeader* header_{nullptr};
+  const ShmResourceSlot* slots_{nullptr};
+  void* mapping_{nullptr};
+  size_t mappingSize_{0};
+};
+
+} // namespace proxygen
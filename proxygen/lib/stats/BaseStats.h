@@ -11,6 +11,8 @@
 
 #include "fb303/ThreadCachedServiceData.h"
 
+#include <proxygen/lib/stats/SparseHistogram.h>
+
 namespace proxygen {
 
 /*
@@ -35,6 +37,10 @@ class BaseStats {
   using TLTimeseriesMinute = facebook::fb303::MinuteOnlyTimeseriesWrapper;
   using TLTimeseriesMinuteAndAllTime = facebook::fb303::MinuteTimeseriesWrapper;
   using TLHistogram = facebook::fb303::HistogramWrapper;
+  // Native log-linear histogram with per-thread relaxed recording; unlike
+  // the wrappers above it has no external stats-service dependency, so
+  // latency can be recorded in-process instead of through a sidecar.
+  using TLSparseHistogram = proxygen::SparseHistogram;
 };
 
 } // namespace proxygen
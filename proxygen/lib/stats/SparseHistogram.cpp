@@ -0,0 +1,50 @@
+/*
+ *  Copyright (c) 2019-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include <proxygen/lib/stats/SparseHistogram.h>
+
+namespace proxygen {
+
+SparseHistogram::Snapshot SparseHistogram::getSnapshot() const {
+  std::array<uint64_t, kNumBuckets> merged{};
+  Snapshot snapshot;
+  for (const auto& local : buckets_.accessAllThreads()) {
+    for (uint32_t i = 0; i < kNumBuckets; i++) {
+      merged[i] += local.counts[i].load(std::memory_order_relaxed);
+    }
+    snapshot.sum += local.sum.load(std::memory_order_relaxed);
+  }
+  for (uint32_t i = 0; i < kNumBuckets; i++) {
+    if (merged[i] > 0) {
+      snapshot.buckets.emplace_back(indexToLowerBound(i), merged[i]);
+      snapshot.totalCount += merged[i];
+    }
+  }
+  return snapshot;
+}
+
+uint64_t SparseHistogram::Snapshot::estimatePercentile(double pct) const {
+  if (totalCount == 0) {
+    return 0;
+  }
+  const uint64_t target = static_cast<uint64_t>(
+      (pct / 100.0) * static_cast<double>(totalCount));
+  uint64_t seen = 0;
+  for (const auto& bucket : buckets) {
+    seen += bucket.second;
+    if (seen > target) {
+      const auto index = valueToIndex(bucket.first);
+      return (bucket.first + indexToUpperBound(index)) / 2;
+    }
+  }
+  return (buckets.back().first +
+          indexToUpperBound(valueToIndex(buckets.back().first))) / 2;
+}
+
+} // namespace proxygen
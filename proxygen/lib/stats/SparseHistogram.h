@@ -0,0 +1,114 @@
+/*
+ *  Copyright (c) 2019-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include <folly/ThreadLocal.h>
+#include <folly/lang/Bits.h>
+
+namespace proxygen {
+
+class SparseHistogramTLTag;
+
+/**
+ * A log-linear latency histogram in the HDR style, usable without any
+ * external stats service.
+ *
+ * Values are bucketed into power-of-two octaves, each split into
+ * kSubBuckets linear sub-buckets, bounding the relative error of any
+ * recorded value to 1/kSubBuckets regardless of magnitude.  Each recording
+ * thread owns its own bucket array: record() is a single relaxed fetch_add
+ * on the caller's array, so the hot path never contends or shares a cache
+ * line with another thread.  Readers merge every per-thread array into a
+ * Snapshot, which carries only the non-empty buckets.
+ *
+ * Units are the caller's choice; the full uint64_t range is representable.
+ */
+class SparseHistogram {
+ public:
+  static constexpr uint32_t kSubBucketBits = 5;
+  static constexpr uint32_t kSubBuckets = 1u << kSubBucketBits;
+  static constexpr uint32_t kNumBuckets =
+      (64 - kSubBucketBits) * kSubBuckets + kSubBuckets;
+
+  /**
+   * A merged, point-in-time view of the histogram.  buckets holds
+   * {lower bound, count} pairs for non-empty buckets only, in increasing
+   * value order.
+   */
+  struct Snapshot {
+    uint64_t totalCount{0};
+    uint64_t sum{0};
+    std::vector<std::pair<uint64_t, uint64_t>> buckets;
+
+    /**
+     * Estimate the given percentile (0-100) as the midpoint of the bucket
+     * containing it.  Returns 0 for an empty histogram.
+     */
+    uint64_t estimatePercentile(double pct) const;
+  };
+
+  SparseHistogram() = default;
+
+  void record(uint64_t value) noexcept {
+    auto& local = *buckets_;
+    local.counts[valueToIndex(value)].fetch_add(1, std::memory_order_relaxed);
+    local.sum.fetch_add(value, std::memory_order_relaxed);
+  }
+
+  /**
+   * Merge the per-thread bucket arrays.  Thread-safe with respect to
+   * concurrent record() calls; counts recorded by threads that have since
+   * exited are not included.
+   */
+  Snapshot getSnapshot() const;
+
+  static uint32_t valueToIndex(uint64_t value) {
+    if (value < kSubBuckets) {
+      return static_cast<uint32_t>(value);
+    }
+    const uint32_t msb = folly::findLastSet(value) - 1;
+    const uint32_t shift = msb - kSubBucketBits;
+    return ((shift + 1) << kSubBucketBits) +
+        static_cast<uint32_t>((value >> shift) - kSubBuckets);
+  }
+
+  static uint64_t indexToLowerBound(uint32_t index) {
+    if (index < kSubBuckets) {
+      return index;
+    }
+    const uint32_t shift = (index >> kSubBucketBits) - 1;
+    return (static_cast<uint64_t>(kSubBuckets) + (index & (kSubBuckets - 1)))
+        << shift;
+  }
+
+  static uint64_t indexToUpperBound(uint32_t index) {
+    if (index < kSubBuckets) {
+      return index;
+    }
+    const uint32_t shift = (index >> kSubBucketBits) - 1;
+    return indexToLowerBound(index) + ((1ULL << shift) - 1);
+  }
+
+ private:
+  struct LocalBuckets {
+    std::array<std::atomic<uint64_t>, kNumBuckets> counts{};
+    std::atomic<uint64_t> sum{0};
+  };
+
+  mutable folly::ThreadLocal<LocalBuckets, SparseHistogramTLTag> buckets_;
+};
+
+} // namespace proxygen
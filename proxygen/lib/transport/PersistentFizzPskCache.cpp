@@ -9,25 +9,72 @@
  */
 #include <proxygen/lib/transport/PersistentFizzPskCache.h>
 
+#include <cstring>
 #include <fizz/record/Types.h>
 
-using namespace folly;
+namespace proxygen {
 
-namespace folly {
-
-template <>
-dynamic toDynamic(const proxygen::PersistentCachedPsk& cached) {
-  dynamic d = dynamic::object;
-  d["psk"] = cached.serialized;
-  d["uses"] = cached.uses;
-  return d;
+std::string encodeCachedPsk(const PersistentCachedPsk& psk) {
+  std::string record;
+  record.reserve(sizeof(uint64_t) + psk.serialized.size());
+  uint64_t uses = psk.uses;
+  record.append(reinterpret_cast<const char*>(&uses), sizeof(uses));
+  record.append(psk.serialized);
+  return record;
 }
 
-template <>
-proxygen::PersistentCachedPsk convertTo(const dynamic& d) {
-  proxygen::PersistentCachedPsk psk;
-  psk.serialized = d["psk"].asString();
-  psk.uses = folly::to<size_t>(d["uses"].asInt());
+folly::Optional<PersistentCachedPsk> decodeCachedPsk(
+    const std::string& record) {
+  if (record.size() < sizeof(uint64_t)) {
+    return folly::none;
+  }
+  PersistentCachedPsk psk;
+  uint64_t uses;
+  memcpy(&uses, record.data(), sizeof(uses));
+  psk.uses = uses;
+  psk.serialized = record.substr(sizeof(uses));
   return psk;
 }
-} // namespace folly
+
+folly::Optional<fizz::client::CachedPsk> PersistentFizzPskCache::getPsk(
+    const std::string& identity) {
+  auto record = store_.get(identity);
+  if (!record) {
+    return folly::none;
+  }
+  auto cached = decodeCachedPsk(*record);
+  if (!cached) {
+    LOG(ERROR) << "Malformed cached PSK record";
+    store_.remove(identity);
+    return folly::none;
+  }
+  try {
+    auto deserialized =
+        fizz::client::deserializePsk(cached->serialized, *factory_);
+    cached->uses++;
+    if (maxPskUses_ != 0 && cached->uses >= maxPskUses_) {
+      store_.remove(identity);
+    } else {
+      store_.put(identity, encodeCachedPsk(*cached));
+    }
+    return std::move(deserialized);
+  } catch (const std::exception& ex) {
+    LOG(ERROR) << "Error deserializing PSK: " << ex.what();
+    store_.remove(identity);
+  }
+  return folly::none;
+}
+
+void PersistentFizzPskCache::putPsk(const std::string& identity,
+                                    fizz::client::CachedPsk psk) {
+  PersistentCachedPsk cached;
+  cached.serialized = fizz::client::serializePsk(psk);
+  cached.uses = 0;
+  store_.put(identity, encodeCachedPsk(cached));
+}
+
+void PersistentFizzPskCache::removePsk(const std::string& identity) {
+  store_.remove(identity);
+}
+
+} // namespace proxygen
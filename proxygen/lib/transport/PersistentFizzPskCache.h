@@ -13,6 +13,7 @@
 #include <fizz/client/PskSerializationUtils.h>
 #include <fizz/protocol/Factory.h>
 #include <fizz/protocol/OpenSSLFactory.h>
+#include <proxygen/lib/transport/PersistentPskStore.h>
 #include <wangle/client/persistence/FilePersistentCache.h>
 
 
@@ -23,6 +24,12 @@ struct PersistentCachedPsk {
   size_t uses{0};
 };
 
+/**
+ * Fizz PSK cache persisted through PersistentPskStore.  Entries are
+ * compact binary records (use count + fizz-serialized PSK) in an
+ * append-only file that is mmap'd at startup, so loading does not parse
+ * or deserialize anything; individual PSKs are decoded on first use.
+ */
 class PersistentFizzPskCache : public fizz::client::PskCache {
  public:
   ~PersistentFizzPskCache() override = default;
@@ -31,7 +38,7 @@ class PersistentFizzPskCache : public fizz::client::PskCache {
                          wangle::PersistentCacheConfig config,
                          std::unique_ptr<fizz::Factory> factory =
                              std::make_unique<fizz::OpenSSLFactory>())
-      : cache_(filename, std::move(config)), factory_(std::move(factory)) {
+      : store_(filename, config.capacity), factory_(std::move(factory)) {
   }
 
   void setMaxPskUses(size_t maxUses) {
@@ -39,52 +46,25 @@ class PersistentFizzPskCache : public fizz::client::PskCache {
   }
 
   folly::Optional<fizz::client::CachedPsk> getPsk(
-      const std::string& identity) override {
-    auto serialized = cache_.get(identity);
-    if (serialized) {
-      try {
-        auto deserialized =
-          fizz::client::deserializePsk(serialized->serialized, *factory_);
-        serialized->uses++;
-        if (maxPskUses_ != 0 && serialized->uses >= maxPskUses_) {
-          cache_.remove(identity);
-        } else {
-          cache_.put(identity, *serialized);
-        }
-        return std::move(deserialized);
-      } catch (const std::exception& ex) {
-        LOG(ERROR) << "Error deserializing PSK: " << ex.what();
-        cache_.remove(identity);
-      }
-    }
-    return folly::none;
-  }
+      const std::string& identity) override;
 
   void putPsk(const std::string& identity,
-              fizz::client::CachedPsk psk) override {
-    PersistentCachedPsk serialized;
-    serialized.serialized = fizz::client::serializePsk(psk);
-    serialized.uses = 0;
-    cache_.put(identity, std::move(serialized));
-  }
+              fizz::client::CachedPsk psk) override;
 
-  void removePsk(const std::string& identity) override {
-    cache_.remove(identity);
-  }
+  void removePsk(const std::string& identity) override;
 
  private:
-  wangle::FilePersistentCache<std::string, PersistentCachedPsk> cache_;
+  PersistentPskStore store_;
 
   size_t maxPskUses_{5};
 
   std::unique_ptr<fizz::Factory> factory_;
 };
-} // namespace proxygen
 
-namespace folly {
+// Record codec for PersistentCachedPsk; also used by
+// PersistentQuicPskCache for the fizz half of its records.
+std::string encodeCachedPsk(const PersistentCachedPsk& psk);
+folly::Optional<PersistentCachedPsk> decodeCachedPsk(
+    const std::string& record);
 
-template <>
-dynamic toDynamic(const proxygen::PersistentCachedPsk& cached);
-template <>
-proxygen::PersistentCachedPsk convertTo(const dynamic& d);
-} // namespace folly
+} // namespace proxygen
@@ -0,0 +1,329 @@
+/*
+ *  Copyright (c) 2019-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include <proxygen/lib/transport/PersistentPskStore.h>
+
+#include <cstring>
+#include <fcntl.h>
+#include <glog/logging.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+const uint32_t kMagic = 0x50585053; // 'PXPS'
+const uint32_t kVersion = 1;
+const size_t kHeaderSize = sizeof(kMagic) + sizeof(kVersion);
+
+const uint8_t kOpPut = 1;
+const uint8_t kOpRemove = 2;
+
+// op + keyLen + valueLen
+const size_t kRecordHeaderSize = 1 + 2 * sizeof(uint32_t);
+
+size_t recordSize(size_t keyLen, size_t valueLen) {
+  return kRecordHeaderSize + keyLen + valueLen;
+}
+
+bool writeFully(int fd, const void* data, size_t len) {
+  const char* p = static_cast<const char*>(data);
+  while (len > 0) {
+    ssize_t written = write(fd, p, len);
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return false;
+    }
+    p += written;
+    len -= written;
+  }
+  return true;
+}
+
+} // namespace
+
+namespace proxygen {
+
+PersistentPskStore::PersistentPskStore(const std::string& filename,
+                                       size_t maxEntries)
+    : filename_(filename), maxEntries_(maxEntries) {
+  load();
+}
+
+PersistentPskStore::~PersistentPskStore() {
+  if (mapping_) {
+    munmap(mapping_, mappingSize_);
+  }
+  if (fd_ >= 0) {
+    close(fd_);
+  }
+}
+
+void PersistentPskStore::load() {
+  fd_ = open(filename_.c_str(), O_RDWR | O_CREAT | O_APPEND, 0600);
+  if (fd_ < 0) {
+    PLOG(ERROR) << "Unable to open PSK store " << filename_
+                << "; PSKs will not persist";
+    return;
+  }
+  struct stat st;
+  if (fstat(fd_, &st) != 0) {
+    PLOG(ERROR) << "Unable to stat PSK store " << filename_;
+    close(fd_);
+    fd_ = -1;
+    return;
+  }
+  fileSize_ = st.st_size;
+
+  bool fresh = false;
+  if (fileSize_ < kHeaderSize) {
+    fresh = fileSize_ != 0;
+  } else {
+    uint32_t magic = 0;
+    uint32_t version = 0;
+    if (pread(fd_, &magic, sizeof(magic), 0) != ssize_t(sizeof(magic)) ||
+        pread(fd_, &version, sizeof(version), sizeof(magic)) !=
+            ssize_t(sizeof(version)) ||
+        magic != kMagic || version != kVersion) {
+      fresh = true;
+    }
+  }
+  if (fresh) {
+    LOG(WARNING) << "PSK store " << filename_
+                 << " is not in the current binary format; starting empty";
+  }
+  if (fresh || fileSize_ == 0) {
+    if (ftruncate(fd_, 0) != 0 ||
+        !writeFully(fd_, &kMagic, sizeof(kMagic)) ||
+        !writeFully(fd_, &kVersion, sizeof(kVersion))) {
+      PLOG(ERROR) << "Unable to initialize PSK store " << filename_;
+      close(fd_);
+      fd_ = -1;
+      return;
+    }
+    fileSize_ = kHeaderSize;
+    return;
+  }
+
+  void* mapping = mmap(nullptr, fileSize_, PROT_READ, MAP_SHARED, fd_, 0);
+  if (mapping == MAP_FAILED) {
+    PLOG(ERROR) << "Unable to map PSK store " << filename_;
+    close(fd_);
+    fd_ = -1;
+    return;
+  }
+  mapping_ = mapping;
+  mappingSize_ = fileSize_;
+
+  // One pass over the record lengths; values stay in the mapping until
+  // someone asks for them
+  const char* base = static_cast<const char*>(mapping);
+  size_t off = kHeaderSize;
+  while (off + kRecordHeaderSize <= fileSize_) {
+    uint8_t op = base[off];
+    uint32_t keyLen;
+    uint32_t valueLen;
+    memcpy(&keyLen, base + off + 1, sizeof(keyLen));
+    memcpy(&valueLen, base + off + 1 + sizeof(keyLen), sizeof(valueLen));
+    if (off + recordSize(keyLen, valueLen) > fileSize_ ||
+        (op != kOpPut && op != kOpRemove)) {
+      break;
+    }
+    std::string key(base + off + kRecordHeaderSize, keyLen);
+    auto it = index_.find(key);
+    if (it != index_.end()) {
+      deadBytes_ += recordSize(key.size(), it->second.len);
+      liveBytes_ -= recordSize(key.size(), it->second.len);
+      index_.erase(it);
+    }
+    if (op == kOpPut) {
+      Record record;
+      record.offset = off + kRecordHeaderSize + keyLen;
+      record.len = valueLen;
+      record.lastTouch = ++touchCounter_;
+      index_.emplace(std::move(key), std::move(record));
+      liveBytes_ += recordSize(keyLen, valueLen);
+    } else {
+      deadBytes_ += recordSize(keyLen, valueLen);
+    }
+    off += recordSize(keyLen, valueLen);
+  }
+  if (off != fileSize_) {
+    // Torn tail from a crash mid-append; drop it so later appends start
+    // at a record boundary
+    LOG(WARNING) << "PSK store " << filename_ << " has a truncated tail ("
+                 << (fileSize_ - off) << " bytes); discarding";
+    if (ftruncate(fd_, off) != 0) {
+      PLOG(ERROR) << "Unable to truncate PSK store " << filename_;
+    }
+    fileSize_ = off;
+  }
+}
+
+folly::StringPiece PersistentPskStore::valueOf(const Record& record) const {
+  if (record.inOverlay) {
+    return record.overlay;
+  }
+  return folly::StringPiece(
+      static_cast<const char*>(mapping_) + record.offset, record.len);
+}
+
+folly::Optional<std::string> PersistentPskStore::get(const std::string& key) {
+  std::lock_guard<std::mutex> guard(mutex_);
+  auto it = index_.find(key);
+  if (it == index_.end()) {
+    return folly::none;
+  }
+  it->second.lastTouch = ++touchCounter_;
+  return valueOf(it->second).str();
+}
+
+void PersistentPskStore::put(const std::string& key,
+                             folly::StringPiece value) {
+  std::lock_guard<std::mutex> guard(mutex_);
+  auto it = index_.find(key);
+  if (it != index_.end()) {
+    deadBytes_ += recordSize(key.size(), it->second.len);
+    liveBytes_ -= recordSize(key.size(), it->second.len);
+    index_.erase(it);
+  } else if (maxEntries_ != 0 && index_.size() >= maxEntries_) {
+    evictOne();
+  }
+  appendRecord(kOpPut, key, value);
+  Record record;
+  record.overlay = value.str();
+  record.len = value.size();
+  record.inOverlay = true;
+  record.lastTouch = ++touchCounter_;
+  index_.emplace(key, std::move(record));
+  liveBytes_ += recordSize(key.size(), value.size());
+  maybeCompact();
+}
+
+void PersistentPskStore::remove(const std::string& key) {
+  std::lock_guard<std::mutex> guard(mutex_);
+  auto it = index_.find(key);
+  if (it == index_.end()) {
+    return;
+  }
+  deadBytes_ += recordSize(key.size(), it->second.len);
+  liveBytes_ -= recordSize(key.size(), it->second.len);
+  index_.erase(it);
+  appendRecord(kOpRemove, key, folly::StringPiece());
+  deadBytes_ += recordSize(key.size(), 0);
+  maybeCompact();
+}
+
+size_t PersistentPskStore::size() {
+  std::lock_guard<std::mutex> guard(mutex_);
+  return index_.size();
+}
+
+void PersistentPskStore::appendRecord(uint8_t op,
+                                      folly::StringPiece key,
+                                      folly::StringPiece value) {
+  if (fd_ < 0) {
+    return;
+  }
+  std::string buf;
+  buf.reserve(recordSize(key.size(), value.size()));
+  buf.push_back(char(op));
+  uint32_t keyLen = key.size();
+  uint32_t valueLen = value.size();
+  buf.append(reinterpret_cast<const char*>(&keyLen), sizeof(keyLen));
+  buf.append(reinterpret_cast<const char*>(&valueLen), sizeof(valueLen));
+  buf.append(key.data(), key.size());
+  buf.append(value.data(), value.size());
+  if (!writeFully(fd_, buf.data(), buf.size())) {
+    PLOG(ERROR) << "Unable to append to PSK store " << filename_;
+    return;
+  }
+  fileSize_ += buf.size();
+}
+
+void PersistentPskStore::evictOne() {
+  auto victim = index_.begin();
+  for (auto it = index_.begin(); it != index_.end(); ++it) {
+    if (it->second.lastTouch < victim->second.lastTouch) {
+      victim = it;
+    }
+  }
+  // The tombstone record keeps the file replayable; the space is
+  // reclaimed at the next compaction
+  deadBytes_ += recordSize(victim->first.size(), victim->second.len);
+  liveBytes_ -= recordSize(victim->first.size(), victim->second.len);
+  appendRecord(kOpRemove, victim->first, folly::StringPiece());
+  deadBytes_ += recordSize(victim->first.size(), 0);
+  index_.erase(victim);
+}
+
+void PersistentPskStore::maybeCompact() {
+  // Rewrite once superseded records outweigh live ones and are worth the
+  // IO; steady-state use-count updates keep appending, so this bounds
+  // the file at roughly twice the live size
+  if (fd_ < 0 || deadBytes_ <= liveBytes_ || deadBytes_ < (64 * 1024)) {
+    return;
+  }
+  std::string tmpName = filename_ + ".tmp";
+  int tmpFd = open(tmpName.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0600);
+  if (tmpFd < 0) {
+    PLOG(ERROR) << "Unable to compact PSK store " << filename_;
+    return;
+  }
+  bool ok = writeFully(tmpFd, &kMagic, sizeof(kMagic)) &&
+            writeFully(tmpFd, &kVersion, sizeof(kVersion));
+  size_t newSize = kHeaderSize;
+  for (auto& entry : index_) {
+    if (!ok) {
+      break;
+    }
+    auto value = valueOf(entry.second);
+    std::string buf;
+    buf.reserve(recordSize(entry.first.size(), value.size()));
+    buf.push_back(char(kOpPut));
+    uint32_t keyLen = entry.first.size();
+    uint32_t valueLen = value.size();
+    buf.append(reinterpret_cast<const char*>(&keyLen), sizeof(keyLen));
+    buf.append(reinterpret_cast<const char*>(&valueLen), sizeof(valueLen));
+    buf.append(entry.first);
+    buf.append(value.data(), value.size());
+    ok = writeFully(tmpFd, buf.data(), buf.size());
+    newSize += buf.size();
+  }
+  if (!ok || fsync(tmpFd) != 0 ||
+      rename(tmpName.c_str(), filename_.c_str()) != 0) {
+    PLOG(ERROR) << "Unable to compact PSK store " << filename_;
+    close(tmpFd);
+    unlink(tmpName.c_str());
+    return;
+  }
+
+  // Move every index entry into the overlay before dropping the old
+  // mapping it may point into
+  for (auto& entry : index_) {
+    if (!entry.second.inOverlay) {
+      entry.second.overlay = valueOf(entry.second).str();
+      entry.second.inOverlay = true;
+    }
+  }
+  if (mapping_) {
+    munmap(mapping_, mappingSize_);
+    mapping_ = nullptr;
+    mappingSize_ = 0;
+  }
+  close(fd_);
+  fd_ = tmpFd;
+  fileSize_ = newSize;
+  liveBytes_ = newSize - kHeaderSize;
+  deadBytes_ = 0;
+}
+
+} // namespace proxygen
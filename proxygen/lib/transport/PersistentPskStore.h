@@ -0,0 +1,94 @@
+/*
+ *  Copyright (c) 2019-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#pragma once
+
+#include <folly/Optional.h>
+#include <folly/Range.h>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace proxygen {
+
+/**
+ * PersistentPskStore:
+ *
+ * Append-only binary key/value persistence backing the PSK caches
+ * (PersistentFizzPskCache, PersistentQuicPskCache).  The file is a small
+ * header followed by length-prefixed put/remove records; loading mmaps
+ * the file and hops record to record building an index of offsets, so
+ * startup cost is one pass over the lengths rather than a JSON parse of
+ * every entry, and entry payloads are only copied out (and deserialized
+ * by the caller) when actually requested.
+ *
+ * Updates append a record and never rewrite in place; the file is
+ * compacted down to the live entries once superseded records dominate
+ * it.  A torn final record from a crash mid-append is truncated away at
+ * load.  A file that does not carry the expected magic/version (e.g. the
+ * legacy JSON format) is discarded with a warning and started fresh.
+ *
+ * All public methods are thread-safe.  The format is native-endian; the
+ * file is host-local state, not an interchange format.
+ */
+class PersistentPskStore {
+ public:
+  /**
+   * maxEntries caps the number of live entries; once full, the least
+   * recently used entry is evicted to make room.  0 means unbounded.
+   */
+  explicit PersistentPskStore(const std::string& filename,
+                              size_t maxEntries = 0);
+
+  ~PersistentPskStore();
+
+  PersistentPskStore(const PersistentPskStore&) = delete;
+  PersistentPskStore& operator=(const PersistentPskStore&) = delete;
+
+  folly::Optional<std::string> get(const std::string& key);
+
+  void put(const std::string& key, folly::StringPiece value);
+
+  void remove(const std::string& key);
+
+  size_t size();
+
+ private:
+  struct Record {
+    // Offset into the mapped file, or the overlay value for entries
+    // written after load
+    size_t offset{0};
+    uint32_t len{0};
+    std::string overlay;
+    bool inOverlay{false};
+    uint64_t lastTouch{0};
+  };
+
+  void load();
+  void appendRecord(uint8_t op, folly::StringPiece key,
+                    folly::StringPiece value);
+  void maybeCompact();
+  void evictOne();
+  folly::StringPiece valueOf(const Record& record) const;
+
+  const std::string filename_;
+  const size_t maxEntries_;
+
+  std::mutex mutex_;
+  std::unordered_map<std::string, Record> index_;
+  int fd_{-1};
+  void* mapping_{nullptr};
+  size_t mappingSize_{0};
+  size_t fileSize_{0};
+  size_t liveBytes_{0};
+  size_t deadBytes_{0};
+  uint64_t touchCounter_{0};
+};
+
+} // namespace proxygen
@@ -9,13 +9,63 @@
  */
 #include <proxygen/lib/transport/PersistentQuicPskCache.h>
 
+#include <cstring>
 #include <folly/Conv.h>
-#include <folly/dynamic.h>
 
 namespace {
-constexpr auto FIZZ_PSK = "psk";
-constexpr auto QUIC_PARAMS = "quic";
-constexpr auto USES = "uses";
+
+// A QUIC record is the fizz record format (use count + payload) with the
+// payload holding: u32 fizz PSK length, fizz PSK, u32 affinity token
+// length, affinity token, then the serialized transport parameters.
+// Pre-token records fail the token bounds check below and are dropped as
+// malformed - a one-time resumption miss on upgrade, acceptable for
+// host-local cache state.
+std::string encodeQuicCachedPsk(const proxygen::PersistentQuicCachedPsk& psk) {
+  proxygen::PersistentCachedPsk outer;
+  outer.uses = psk.uses;
+  uint32_t fizzLen = psk.fizzPsk.size();
+  uint32_t tokenLen = psk.affinityToken.size();
+  outer.serialized.reserve(sizeof(fizzLen) + psk.fizzPsk.size() +
+                           sizeof(tokenLen) + psk.affinityToken.size() +
+                           psk.quicParams.size());
+  outer.serialized.append(reinterpret_cast<const char*>(&fizzLen),
+                          sizeof(fizzLen));
+  outer.serialized.append(psk.fizzPsk);
+  outer.serialized.append(reinterpret_cast<const char*>(&tokenLen),
+                          sizeof(tokenLen));
+  outer.serialized.append(psk.affinityToken);
+  outer.serialized.append(psk.quicParams);
+  return proxygen::encodeCachedPsk(outer);
+}
+
+folly::Optional<proxygen::PersistentQuicCachedPsk> decodeQuicCachedPsk(
+    const std::string& record) {
+  auto outer = proxygen::decodeCachedPsk(record);
+  if (!outer || outer->serialized.size() < sizeof(uint32_t)) {
+    return folly::none;
+  }
+  uint32_t fizzLen;
+  memcpy(&fizzLen, outer->serialized.data(), sizeof(fizzLen));
+  size_t offset = sizeof(fizzLen);
+  if (offset + fizzLen + sizeof(uint32_t) > outer->serialized.size()) {
+    return folly::none;
+  }
+  proxygen::PersistentQuicCachedPsk psk;
+  psk.uses = outer->uses;
+  psk.fizzPsk = outer->serialized.substr(offset, fizzLen);
+  offset += fizzLen;
+  uint32_t tokenLen;
+  memcpy(&tokenLen, outer->serialized.data() + offset, sizeof(tokenLen));
+  offset += sizeof(tokenLen);
+  if (offset + tokenLen > outer->serialized.size()) {
+    return folly::none;
+  }
+  psk.affinityToken = outer->serialized.substr(offset, tokenLen);
+  offset += tokenLen;
+  psk.quicParams = outer->serialized.substr(offset);
+  return psk;
+}
+
 } // namespace
 
 namespace proxygen {
@@ -23,7 +73,7 @@ PersistentQuicPskCache::PersistentQuicPskCache(
     const std::string& filename,
     wangle::PersistentCacheConfig config,
     std::unique_ptr<fizz::Factory> factory)
-    : cache_(filename, std::move(config)), factory_(std::move(factory)) {
+    : store_(filename, config.capacity), factory_(std::move(factory)) {
 }
 
 void PersistentQuicPskCache::setMaxPskUses(size_t maxUses) {
@@ -32,8 +82,14 @@ void PersistentQuicPskCache::setMaxPskUses(size_t maxUses) {
 
 folly::Optional<quic::QuicCachedPsk> PersistentQuicPskCache::getPsk(
     const std::string& identity) {
-  auto cachedPsk = cache_.get(identity);
+  auto record = store_.get(identity);
+  if (!record) {
+    return folly::none;
+  }
+  auto cachedPsk = decodeQuicCachedPsk(*record);
   if (!cachedPsk) {
+    LOG(ERROR) << "Malformed cached PSK record";
+    store_.remove(identity);
     return folly::none;
   }
   try {
@@ -65,14 +121,14 @@ folly::Optional<quic::QuicCachedPsk> PersistentQuicPskCache::getPsk(
 
     cachedPsk->uses++;
     if (maxPskUses_ != 0 && cachedPsk->uses >= maxPskUses_) {
-      cache_.remove(identity);
+      store_.remove(identity);
     } else {
-      cache_.put(identity, *cachedPsk);
+      store_.put(identity, encodeQuicCachedPsk(*cachedPsk));
     }
     return std::move(quicCachedPsk);
   } catch (const std::exception& ex) {
     LOG(ERROR) << "Error deserializing PSK: " << ex.what();
-    cache_.remove(identity);
+    store_.remove(identity);
     return folly::none;
   }
 }
@@ -80,6 +136,14 @@ folly::Optional<quic::QuicCachedPsk> PersistentQuicPskCache::getPsk(
 void PersistentQuicPskCache::putPsk(const std::string& identity,
                                     quic::QuicCachedPsk quicCachedPsk) {
   PersistentQuicCachedPsk cachedPsk;
+  // a ticket refresh replaces the PSK but keeps the client's affinity
+  auto existing = store_.get(identity);
+  if (existing) {
+    auto decoded = decodeQuicCachedPsk(*existing);
+    if (decoded) {
+      cachedPsk.affinityToken = std::move(decoded->affinityToken);
+    }
+  }
   cachedPsk.fizzPsk = fizz::client::serializePsk(quicCachedPsk.cachedPsk);
 
   auto quicParams = folly::IOBuf::create(0);
@@ -105,31 +169,37 @@ void PersistentQuicPskCache::putPsk(const std::string& identity,
       appender);
   cachedPsk.quicParams = quicParams->moveToFbString().toStdString();
   cachedPsk.uses = 0;
-  cache_.put(identity, std::move(cachedPsk));
+  store_.put(identity, encodeQuicCachedPsk(cachedPsk));
 }
 
 void PersistentQuicPskCache::removePsk(const std::string& identity) {
-  cache_.remove(identity);
+  store_.remove(identity);
 }
-} // namespace proxygen
-
-namespace folly {
 
-template <>
-dynamic toDynamic(const proxygen::PersistentQuicCachedPsk& cached) {
-  dynamic d = dynamic::object;
-  d[FIZZ_PSK] = cached.fizzPsk;
-  d[QUIC_PARAMS] = cached.quicParams;
-  d[USES] = cached.uses;
-  return d;
+folly::Optional<std::string> PersistentQuicPskCache::getAffinityToken(
+    const std::string& identity) {
+  auto record = store_.get(identity);
+  if (!record) {
+    return folly::none;
+  }
+  auto cachedPsk = decodeQuicCachedPsk(*record);
+  if (!cachedPsk || cachedPsk->affinityToken.empty()) {
+    return folly::none;
+  }
+  return std::move(cachedPsk->affinityToken);
 }
 
-template <>
-proxygen::PersistentQuicCachedPsk convertTo(const dynamic& d) {
-  proxygen::PersistentQuicCachedPsk psk;
-  psk.fizzPsk = d[FIZZ_PSK].asString();
-  psk.quicParams = d[QUIC_PARAMS].asString();
-  psk.uses = folly::to<size_t>(d[USES].asInt());
-  return psk;
+void PersistentQuicPskCache::setAffinityToken(const std::string& identity,
+                                              std::string token) {
+  auto record = store_.get(identity);
+  if (!record) {
+    return;
+  }
+  auto cachedPsk = decodeQuicCachedPsk(*record);
+  if (!cachedPsk) {
+    return;
+  }
+  cachedPsk->affinityToken = std::move(token);
+  store_.put(identity, encodeQuicCachedPsk(*cachedPsk));
 }
-} // namespace folly
+} // namespace proxygen
@@ -12,10 +12,9 @@
 #include <proxygen/lib/transport/PersistentFizzPskCache.h>
 
 #include <folly/Optional.h>
-#include <folly/dynamic.h>
 #include <fizz/client/PskSerializationUtils.h>
+#include <proxygen/lib/transport/PersistentPskStore.h>
 #include <quic/client/handshake/QuicPskCache.h>
-#include <wangle/client/persistence/FilePersistentCache.h>
 
 #include <chrono>
 #include <cstdint>
@@ -28,9 +27,17 @@ namespace proxygen {
 struct PersistentQuicCachedPsk {
   std::string fizzPsk;
   std::string quicParams;
+  // Opaque server-issued affinity token (e.g. which pop/worker last
+  // served this client); persisted with the PSK and re-presented on
+  // resumption so routing layers can restore affinity
+  std::string affinityToken;
   size_t uses{0};
 };
 
+/**
+ * QUIC PSK cache persisted through PersistentPskStore; shares the
+ * binary record design (and load behavior) with PersistentFizzPskCache.
+ */
 class PersistentQuicPskCache : public quic::QuicPskCache {
  public:
   PersistentQuicPskCache(const std::string& filename,
@@ -46,17 +53,24 @@ class PersistentQuicPskCache : public quic::QuicPskCache {
               quic::QuicCachedPsk quicCachedPsk) override;
   void removePsk(const std::string& identity) override;
 
+  /**
+   * The affinity token stored with the identity's PSK, or none if the
+   * identity is unknown or carries no token.
+   */
+  folly::Optional<std::string> getAffinityToken(const std::string& identity);
+
+  /**
+   * Attach an opaque affinity token to the identity's cached PSK.  The
+   * token survives use-count rewrites and putPsk() refreshes of the
+   * ticket itself, so it tracks the client relationship rather than any
+   * single ticket.  No-op if no PSK is cached for the identity.
+   */
+  void setAffinityToken(const std::string& identity, std::string token);
+
  private:
-  wangle::FilePersistentCache<std::string, PersistentQuicCachedPsk> cache_;
+  PersistentPskStore store_;
   size_t maxPskUses_{5};
   std::unique_ptr<fizz::Factory> factory_;
 };
 
 } // namespace proxygen
-
-namespace folly {
-template <>
-dynamic toDynamic(const proxygen::PersistentQuicCachedPsk& cached);
-template <>
-proxygen::PersistentQuicCachedPsk convertTo(const dynamic& d);
-} // namespace folly
@@ -11,23 +11,226 @@
 
 #include <glog/logging.h>
 
+#include <algorithm>
+#include <cstring>
+#include <folly/CpuId.h>
 #include <folly/Range.h>
-#include <folly/portability/OpenSSL.h>
-#include <openssl/buffer.h>
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#define PROXYGEN_BASE64_SSSE3 1
+#include <tmmintrin.h>
+#endif
 
 namespace {
-struct BIODeleter {
- public:
-  void operator()(BIO* bio) const { BIO_free_all(bio); };
+
+const char kEncodeTable[] =
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+// 0-63 for valid base64 alphabet bytes, -1 for everything else ('='
+// included; padding is handled by the caller)
+const int8_t kDecodeTable[256] = {
+  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 62, -1, -1, -1, 63,
+  52, 53, 54, 55, 56, 57, 58, 59, 60, 61, -1, -1, -1, -1, -1, -1,
+  -1,  0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14,
+  15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, -1, -1, -1, -1, -1,
+  -1, 26, 27, 28, 29, 30, 31, 32, 33, 34, 35, 36, 37, 38, 39, 40,
+  41, 42, 43, 44, 45, 46, 47, 48, 49, 50, 51, -1, -1, -1, -1, -1,
+  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
 };
 
+void encodeScalar(const uint8_t* in, size_t len, char* out) {
+  size_t i = 0;
+  for (; len - i >= 3; i += 3) {
+    uint32_t v = (uint32_t(in[i]) << 16) | (uint32_t(in[i + 1]) << 8) |
+        in[i + 2];
+    *out++ = kEncodeTable[(v >> 18) & 0x3f];
+    *out++ = kEncodeTable[(v >> 12) & 0x3f];
+    *out++ = kEncodeTable[(v >> 6) & 0x3f];
+    *out++ = kEncodeTable[v & 0x3f];
+  }
+  if (i < len) {
+    uint32_t v = uint32_t(in[i]) << 16;
+    if (i + 1 < len) {
+      v |= uint32_t(in[i + 1]) << 8;
+    }
+    *out++ = kEncodeTable[(v >> 18) & 0x3f];
+    *out++ = kEncodeTable[(v >> 12) & 0x3f];
+    *out++ = (i + 1 < len) ? kEncodeTable[(v >> 6) & 0x3f] : '=';
+    *out++ = '=';
+  }
+}
+
+// Decodes len (not necessarily a multiple of 4, the padding is already
+// stripped) base64 chars; returns false on any byte outside the alphabet
+bool decodeScalar(const uint8_t* in, size_t len, char* out) {
+  size_t i = 0;
+  for (; len - i >= 4; i += 4) {
+    int8_t a = kDecodeTable[in[i]];
+    int8_t b = kDecodeTable[in[i + 1]];
+    int8_t c = kDecodeTable[in[i + 2]];
+    int8_t d = kDecodeTable[in[i + 3]];
+    if ((a | b | c | d) < 0) {
+      return false;
+    }
+    uint32_t v = (uint32_t(a) << 18) | (uint32_t(b) << 12) |
+        (uint32_t(c) << 6) | uint32_t(d);
+    *out++ = char(v >> 16);
+    *out++ = char((v >> 8) & 0xff);
+    *out++ = char(v & 0xff);
+  }
+  if (i < len) {
+    // 2 or 3 chars remain, for 1 or 2 bytes of output
+    if (len - i < 2) {
+      return false;
+    }
+    int8_t a = kDecodeTable[in[i]];
+    int8_t b = kDecodeTable[in[i + 1]];
+    int8_t c = (len - i == 3) ? kDecodeTable[in[i + 2]] : int8_t(0);
+    if ((a | b | c) < 0) {
+      return false;
+    }
+    uint32_t v = (uint32_t(a) << 18) | (uint32_t(b) << 12) |
+        (uint32_t(c) << 6);
+    *out++ = char(v >> 16);
+    if (len - i == 3) {
+      *out++ = char((v >> 8) & 0xff);
+    }
+  }
+  return true;
+}
+
+#ifdef PROXYGEN_BASE64_SSSE3
+
+/**
+ * Shuffle-based kernels after Muła & Lemire, "Faster Base64 Encoding and
+ * Decoding Using AVX2 Instructions".  The 128-bit variants are used here:
+ * the tokens this codec sees are a few dozen bytes, so the wider kernel
+ * never gets a full lane and the SSSE3 form is the one that pays off.
+ * Each encode step reads 16 input bytes, consumes 12 and emits 16 chars;
+ * each decode step reads 16 chars and emits 12 bytes.
+ */
+
+__attribute__((target("ssse3")))
+void encodeSsse3(const uint8_t* in, size_t len, char* out) {
+  size_t i = 0;
+  while (len - i >= 16) {
+    __m128i data =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+    // Split the 12 input bytes into four 3-byte groups, one per 32-bit
+    // lane, bytes pre-swizzled for the bit extraction below
+    data = _mm_shuffle_epi8(
+        data,
+        _mm_setr_epi8(1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10));
+    // Extract the four 6-bit indices of each group into separate bytes
+    __m128i t0 = _mm_and_si128(data, _mm_set1_epi32(0x0fc0fc00));
+    __m128i t1 = _mm_mulhi_epu16(t0, _mm_set1_epi32(0x04000040));
+    __m128i t2 = _mm_and_si128(data, _mm_set1_epi32(0x003f03f0));
+    __m128i t3 = _mm_mullo_epi16(t2, _mm_set1_epi32(0x01000010));
+    __m128i indices = _mm_or_si128(t1, t3);
+    // Translate 0-63 to ASCII by adding a per-range offset
+    __m128i offsetLut = _mm_setr_epi8(
+        65, 71, -4, -4, -4, -4, -4, -4, -4, -4, -4, -4, -19, -16, 0, 0);
+    __m128i reduced = _mm_subs_epu8(indices, _mm_set1_epi8(51));
+    __m128i less = _mm_cmpgt_epi8(indices, _mm_set1_epi8(25));
+    reduced = _mm_sub_epi8(reduced, less);
+    __m128i ascii =
+        _mm_add_epi8(indices, _mm_shuffle_epi8(offsetLut, reduced));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out), ascii);
+    i += 12;
+    out += 16;
+  }
+  encodeScalar(in + i, len - i, out);
+}
+
+__attribute__((target("ssse3")))
+bool decodeSsse3(const uint8_t* in, size_t len, char* out) {
+  size_t i = 0;
+  while (len - i >= 16) {
+    __m128i data =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+    // Classify each byte by nibble pair; a nonzero AND of the two lookups
+    // marks a byte outside the alphabet
+    __m128i loLut = _mm_setr_epi8(
+        0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+        0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A);
+    __m128i hiLut = _mm_setr_epi8(
+        0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+        0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+    __m128i rollLut = _mm_setr_epi8(
+        0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+    __m128i hiNibbles =
+        _mm_and_si128(_mm_srli_epi32(data, 4), _mm_set1_epi8(0x0f));
+    __m128i loNibbles = _mm_and_si128(data, _mm_set1_epi8(0x0f));
+    __m128i lo = _mm_shuffle_epi8(loLut, loNibbles);
+    __m128i hi = _mm_shuffle_epi8(hiLut, hiNibbles);
+    if (_mm_movemask_epi8(
+            _mm_cmpgt_epi8(_mm_and_si128(lo, hi), _mm_setzero_si128()))) {
+      return false;
+    }
+    // Translate ASCII to 6-bit values, then pack 16 values to 12 bytes
+    __m128i eq2F = _mm_cmpeq_epi8(data, _mm_set1_epi8(0x2f));
+    __m128i roll =
+        _mm_shuffle_epi8(rollLut, _mm_add_epi8(eq2F, hiNibbles));
+    __m128i values = _mm_add_epi8(data, roll);
+    __m128i merged =
+        _mm_maddubs_epi16(values, _mm_set1_epi32(0x01400140));
+    __m128i packed = _mm_madd_epi16(merged, _mm_set1_epi32(0x00011000));
+    packed = _mm_shuffle_epi8(
+        packed,
+        _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1,
+                      -1));
+    // Only the low 12 bytes are output; stage them so the store never
+    // runs past the end of the result buffer
+    char staged[16];
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(staged), packed);
+    memcpy(out, staged, 12);
+    i += 16;
+    out += 12;
+  }
+  return decodeScalar(in + i, len - i, out);
+}
+
+bool haveSsse3() {
+  static const bool rc = folly::CpuId().ssse3();
+  return rc;
+}
+
+#endif // PROXYGEN_BASE64_SSSE3
+
+void encodeImpl(const uint8_t* in, size_t len, char* out) {
+#ifdef PROXYGEN_BASE64_SSSE3
+  if (haveSsse3()) {
+    encodeSsse3(in, len, out);
+    return;
+  }
+#endif
+  encodeScalar(in, len, out);
+}
+
+bool decodeImpl(const uint8_t* in, size_t len, char* out) {
+#ifdef PROXYGEN_BASE64_SSSE3
+  if (haveSsse3()) {
+    return decodeSsse3(in, len, out);
+  }
+#endif
+  return decodeScalar(in, len, out);
+}
+
 }
 
 namespace proxygen {
 
 // Decodes a base64url encoded string
 std::string Base64::urlDecode(const std::string& urlB64message) {
-  std::unique_ptr<BIO, BIODeleter> bio, b64;
   uint8_t padding = (4 - urlB64message.length() % 4) % 4;
   if (padding == 3) {
     return std::string();
@@ -52,55 +255,33 @@ std::string Base64::urlDecode(const std::string& urlB64message) {
 }
 
 std::string Base64::decode(const std::string& b64message, int padding) {
-  if (b64message.length() % 4 != 0 || padding >= 3) {
+  if (b64message.length() % 4 != 0 || padding >= 3 || padding < 0 ||
+      size_t(padding) > b64message.length()) {
     return std::string();
   }
 
-  std::unique_ptr<BIO, BIODeleter> bio, b64;
-  size_t decodeLen = b64message.length() * 3/4 - padding;
-  std::string result(decodeLen, '\0');
-
-  bio.reset(BIO_new_mem_buf((void*)b64message.data(), -1));
-  if (!bio) {
-    return std::string();
+  // The declared padding chars must actually be padding; everything
+  // before them must be alphabet bytes, which decodeImpl enforces
+  size_t dataLen = b64message.length() - padding;
+  for (size_t i = dataLen; i < b64message.length(); i++) {
+    if (b64message[i] != '=') {
+      return std::string();
+    }
   }
-  b64.reset(BIO_new(BIO_f_base64()));
-  if (!b64) {
-    return std::string();
-  }
-  bio.reset(BIO_push(b64.release(), bio.release()));
 
-  // Do not use newlines to flush buffer
-  BIO_set_flags(bio.get(), BIO_FLAGS_BASE64_NO_NL);
-  BIO_read(bio.get(), (char*)result.data(), b64message.length());
-  DCHECK_LE(result.length(), decodeLen);
-  if (result.length() < decodeLen) {
+  size_t decodeLen = b64message.length() * 3 / 4 - padding;
+  std::string result(decodeLen, '\0');
+  if (!decodeImpl(reinterpret_cast<const uint8_t*>(b64message.data()),
+                  dataLen,
+                  &result[0])) {
     return std::string();
   }
   return result;
 }
 
 std::string Base64::encode(folly::ByteRange buffer) {
-  std::unique_ptr<BIO, BIODeleter> bio, b64;
-  BUF_MEM* bufferPtr;
-
-  b64.reset(BIO_new(BIO_f_base64()));
-  if (!b64) {
-    throw std::bad_alloc();
-  }
-  bio.reset(BIO_new(BIO_s_mem()));
-  if (!bio) {
-    throw std::bad_alloc();
-  }
-  bio.reset(BIO_push(b64.release(), bio.release()));
-
-  // Ignore newlines - write everything in one line
-  BIO_set_flags(bio.get(), BIO_FLAGS_BASE64_NO_NL);
-  BIO_write(bio.get(), buffer.data(), buffer.size());
-  (void)BIO_flush(bio.get());
-  BIO_get_mem_ptr(bio.get(), &bufferPtr);
-
-  std::string result(bufferPtr->data, bufferPtr->length);
+  std::string result(((buffer.size() + 2) / 3) * 4, '\0');
+  encodeImpl(buffer.data(), buffer.size(), &result[0]);
   return result;
 }
 
@@ -14,8 +14,9 @@
 
 namespace proxygen {
 
-// This is a wrapper around openssl base64 encoding.  It is a temporary wrapper
-// around openssl, until a more optimized version lands in folly
+// Base64 and base64url codec.  Encode/decode use an SSSE3 shuffle kernel
+// when the CPU supports it (picked at runtime) and a table-driven scalar
+// path otherwise; both yield identical output.
 
 class Base64 {
   public:
@@ -0,0 +1,76 @@
+/*
+ *  Copyright (c) 2015-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include <proxygen/lib/utils/BodyDigest.h>
+
+#include <folly/hash/Checksum.h>
+#include <glog/logging.h>
+
+namespace proxygen {
+
+BodyDigest::BodyDigest(Algorithm algorithm) : algorithm_(algorithm) {
+  switch (algorithm_) {
+    case Algorithm::CRC32C:
+      // folly::crc32c chains by passing the previous return value back
+      // in as the starting checksum
+      crc_ = ~0U;
+      break;
+    case Algorithm::SHA256:
+      SHA256_Init(&shaCtx_);
+      break;
+  }
+}
+
+void BodyDigest::update(folly::ByteRange range) {
+  DCHECK(!finished_);
+  if (range.empty()) {
+    return;
+  }
+  switch (algorithm_) {
+    case Algorithm::CRC32C:
+      crc_ = folly::crc32c(range.data(), range.size(), crc_);
+      break;
+    case Algorithm::SHA256:
+      SHA256_Update(&shaCtx_, range.data(), range.size());
+      break;
+  }
+  bytesHashed_ += range.size();
+}
+
+void BodyDigest::update(const folly::IOBuf& chain) {
+  const folly::IOBuf* buf = &chain;
+  do {
+    update(folly::ByteRange(buf->data(), buf->length()));
+    buf = buf->next();
+  } while (buf != &chain);
+}
+
+std::string BodyDigest::finish() {
+  DCHECK(!finished_);
+  finished_ = true;
+  switch (algorithm_) {
+    case Algorithm::CRC32C: {
+      const uint32_t crc = ~crc_;
+      std::string out(4, '\0');
+      out[0] = static_cast<char>(crc >> 24);
+      out[1] = static_cast<char>(crc >> 16);
+      out[2] = static_cast<char>(crc >> 8);
+      out[3] = static_cast<char>(crc);
+      return out;
+    }
+    case Algorithm::SHA256: {
+      std::string out(SHA256_DIGEST_LENGTH, '\0');
+      SHA256_Final(reinterpret_cast<unsigned char*>(&out[0]), &shaCtx_);
+      return out;
+    }
+  }
+  return std::string();
+}
+
+} // namespace proxygen
@@ -0,0 +1,76 @@
+/*
+ *  Copyright (c) 2015-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#pragma once
+
+#include <folly/Range.h>
+#include <folly/io/IOBuf.h>
+#include <openssl/sha.h>
+#include <string>
+
+namespace proxygen {
+
+/**
+ * Incremental digest over a body that arrives in chunks.  Feeding every
+ * chunk as it is delivered leaves the digest ready the moment the
+ * message completes, instead of re-reading the assembled body in a
+ * second pass - at storage-gateway volumes that second pass is a
+ * machine's worth of memory bandwidth.
+ *
+ * update() walks IOBuf chains buffer by buffer, so nothing is ever
+ * flattened.  CRC32C rides on folly's implementation (hardware CRC32
+ * instructions where the platform has them) and SHA-256 on OpenSSL,
+ * which picks up SHA extensions the same way.
+ *
+ * See HTTPTransaction::setIngressDigest() for hashing a request body as
+ * it streams in.
+ */
+class BodyDigest {
+ public:
+  enum class Algorithm : uint8_t {
+    CRC32C,
+    SHA256,
+  };
+
+  explicit BodyDigest(Algorithm algorithm);
+
+  Algorithm getAlgorithm() const {
+    return algorithm_;
+  }
+
+  uint64_t getBytesHashed() const {
+    return bytesHashed_;
+  }
+
+  void update(folly::ByteRange range);
+
+  /**
+   * Hash every buffer of the chain, in order, in place.
+   */
+  void update(const folly::IOBuf& chain);
+
+  bool isFinished() const {
+    return finished_;
+  }
+
+  /**
+   * Seal the digest and return its raw bytes: 4 (big-endian) for
+   * CRC32C, 32 for SHA-256.  No update() may follow.
+   */
+  std::string finish();
+
+ private:
+  const Algorithm algorithm_;
+  uint64_t bytesHashed_{0};
+  bool finished_{false};
+  uint32_t crc_{0};
+  SHA256_CTX shaCtx_;
+};
+
+} // namespace proxygen
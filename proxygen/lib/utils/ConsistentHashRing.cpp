@@ -0,0 +1,98 @@
+/*
+ *  Copyright (c) 2015-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include <proxygen/lib/utils/ConsistentHashRing.h>
+#include <folly/hash/Hash.h>
+#include <algorithm>
+#include <cmath>
+
+namespace proxygen {
+
+void ConsistentHashRing::build(std::vector<std::pair<
+                               std::string, uint64_t> >&nodes) {
+  numNodes_ = nodes.size();
+  uint64_t totalWeight = 0;
+  for (const auto& node : nodes) {
+    totalWeight += node.second;
+  }
+  if (totalWeight == 0) {
+    return;
+  }
+
+  size_t totalPoints = numNodes_ * pointsPerNode_;
+  size_t minPoints = totalPoints;
+  ring_.reserve(totalPoints + numNodes_);
+  for (size_t i = 0; i < nodes.size(); i++) {
+    if (nodes[i].second == 0) {
+      continue;
+    }
+    // Points proportional to relative weight; every positive-weight node
+    // keeps at least one point so it stays reachable as a fallback
+    size_t points = std::max<size_t>(
+        1,
+        size_t((double)nodes[i].second / totalWeight * totalPoints + 0.5));
+    minPoints = std::min(minPoints, points);
+    uint64_t seed = folly::hash::fnv64_buf(nodes[i].first.c_str(),
+                                           nodes[i].first.size());
+    for (size_t p = 0; p < points; p++) {
+      ring_.emplace_back(folly::hash::twang_mix64(seed + p), i);
+    }
+  }
+  std::sort(ring_.begin(), ring_.end());
+
+  // Load on a random ring deviates from the weighted share roughly
+  // normally with relative sigma 1/sqrt(points); the node with the
+  // fewest points bounds the error, with 2 sigma of headroom
+  maxErrorRate_ = 2.0 / sqrt((double)minPoints);
+}
+
+size_t ConsistentHashRing::get(const uint64_t key, const size_t rank) const {
+  if (ring_.empty()) {
+    return 0;
+  }
+  size_t modRank = rank % numNodes_;
+
+  auto it = std::lower_bound(
+      ring_.begin(),
+      ring_.end(),
+      std::make_pair(folly::hash::twang_mix64(key), size_t(0)));
+
+  if (modRank == 0) {
+    // the common case is just the binary search
+    return (it == ring_.end()) ? ring_.front().second : it->second;
+  }
+
+  // Walk clockwise collecting distinct nodes until we reach the
+  // requested rank.  If the ring has fewer distinct nodes than
+  // modRank + 1 (zero-weight nodes own no points), the last one found
+  // wins.
+  std::vector<bool> seen(numNodes_, false);
+  size_t found = 0;
+  size_t result = 0;
+  for (size_t steps = 0; steps < ring_.size(); steps++) {
+    if (it == ring_.end()) {
+      it = ring_.begin();
+    }
+    if (!seen[it->second]) {
+      seen[it->second] = true;
+      result = it->second;
+      if (found++ == modRank) {
+        return result;
+      }
+    }
+    ++it;
+  }
+  return result;
+}
+
+double ConsistentHashRing::getMaxErrorRate() const {
+  return maxErrorRate_;
+}
+
+} // proxygen
@@ -0,0 +1,56 @@
+/*
+ *  Copyright (c) 2015-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#pragma once
+
+#include <string>
+#include <vector>
+#include <proxygen/lib/utils/ConsistentHash.h>
+
+namespace proxygen {
+
+/*
+ * Classic consistent hash ring with weighted virtual nodes.  Each node
+ * gets a share of ring points proportional to its weight and a lookup is
+ * a single binary search, so get() costs O(log(nodes * pointsPerNode))
+ * instead of RendezvousHash's O(nodes) hashing scan.  The trade-off is
+ * accuracy: load only matches the weights to within roughly
+ * 1/sqrt(pointsPerNode), where rendezvous is exact, so rendezvous remains
+ * the right choice for small pools and this ring for large ones.
+ *
+ * Weight semantics match RendezvousHash::build: weights are relative
+ * shares and zero-weight nodes receive no traffic.  Because point counts
+ * are normalized by the total weight, a membership change also remaps a
+ * small fraction of keys between surviving nodes, where rendezvous moves
+ * only the keys owned by the changed node.
+ */
+class ConsistentHashRing : public ConsistentHash {
+ public:
+  // Average ring points per node; more points cost build time and memory
+  // but tighten the load error bound
+  static const size_t kDefaultPointsPerNode = 128;
+
+  explicit ConsistentHashRing(size_t pointsPerNode = kDefaultPointsPerNode)
+      : pointsPerNode_(pointsPerNode) {}
+
+  double getMaxErrorRate() const override;
+
+  void build(std::vector<std::pair<std::string, uint64_t>>&) override;
+
+  size_t get(const uint64_t key, const size_t rank = 0) const override;
+
+ private:
+  // (point hash, node index), sorted by hash
+  std::vector<std::pair<uint64_t, size_t>> ring_;
+  size_t pointsPerNode_;
+  size_t numNodes_{0};
+  double maxErrorRate_{0};
+};
+
+} // proxygen
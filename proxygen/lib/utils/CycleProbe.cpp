@@ -0,0 +1,74 @@
+/*
+ *  Copyright (c) 2015-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include <proxygen/lib/utils/CycleProbe.h>
+
+#include <algorithm>
+
+namespace proxygen {
+
+constexpr uint64_t CycleProbe::kRingSize;
+
+void CycleProbe::Ring::push(const Record& record) {
+  auto h = head.load(std::memory_order_relaxed);
+  records[h & (kRingSize - 1)] = record;
+  head.store(h + 1, std::memory_order_release);
+}
+
+folly::ThreadLocal<CycleProbe::Ring, CycleProbe::RingTag>&
+CycleProbe::getRing() {
+  static folly::ThreadLocal<Ring, RingTag> ring;
+  return ring;
+}
+
+void CycleProbe::record(Site site,
+                        uint64_t startCycles,
+                        uint64_t deltaCycles) {
+  getRing()->push(Record{startCycles, deltaCycles, site});
+}
+
+const char* CycleProbe::getSiteName(Site site) {
+  switch (site) {
+    case Site::SESSION_READ:
+      return "session_read";
+    case Site::H2_INGRESS:
+      return "h2_ingress";
+    case Site::HPACK_DECODE:
+      return "hpack_decode";
+    case Site::NUM_SITES:
+      break;
+  }
+  return "unknown";
+}
+
+std::vector<CycleProbe::Record> CycleProbe::readAllThreads() {
+  std::vector<Record> out;
+  for (const auto& ring : getRing().accessAllThreads()) {
+    auto h = ring.head.load(std::memory_order_acquire);
+    for (auto i = (h > kRingSize) ? h - kRingSize : 0; i < h; i++) {
+      out.push_back(ring.records[i & (kRingSize - 1)]);
+    }
+  }
+  return out;
+}
+
+std::vector<CycleProbe::Record> CycleProbe::drainCurrentThread() {
+  std::vector<Record> out;
+  auto& ring = *getRing();
+  auto h = ring.head.load(std::memory_order_relaxed);
+  auto start =
+      std::max(ring.tail, (h > kRingSize) ? h - kRingSize : uint64_t(0));
+  for (auto i = start; i < h; i++) {
+    out.push_back(ring.records[i & (kRingSize - 1)]);
+  }
+  ring.tail = h;
+  return out;
+}
+
+} // namespace proxygen
@@ -0,0 +1,134 @@
+/*
+ *  Copyright (c) 2015-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+#include <folly/Preprocessor.h>
+#include <folly/ThreadLocal.h>
+
+namespace proxygen {
+
+/**
+ * A lightweight cycle-count probe lane next to the TraceEvent system.
+ *
+ * TraceEvent records wall-clock events with string metadata maps, which
+ * is far too heavy to use per frame.  CycleProbe instead writes
+ * fixed-size records with cycle-counter deltas into a per-thread ring,
+ * with no locks or allocation on the hot path.  Probe sites are
+ * registered at compile time in the Site enum and instrumented scopes
+ * are declared with PROXYGEN_CYCLE_PROBE.
+ *
+ * Rings are sampled by an inspection thread via readAllThreads(), which
+ * is best effort: a probe that laps the reader mid-scan can tear the
+ * oldest records.  That is acceptable for a production diagnostic and
+ * keeps the writer entirely wait free.
+ */
+class CycleProbe {
+ public:
+  /**
+   * Compile-time probe site registry.  Add new sites before NUM_SITES
+   * and give them a name in getSiteName().
+   */
+  enum class Site : uint8_t {
+    SESSION_READ = 0, // HTTPSession::processReadData
+    H2_INGRESS,       // HTTP2Codec::onIngress
+    HPACK_DECODE,     // HPACKDecoder::decodeStreaming
+    NUM_SITES,        // must be last
+  };
+
+  struct Record {
+    uint64_t startCycles;
+    uint64_t deltaCycles;
+    Site site;
+  };
+
+  /**
+   * RAII probe scope; records one entry when it goes out of scope.
+   */
+  class Guard {
+   public:
+    explicit Guard(Site site) : site_(site), startCycles_(readCycles()) {
+    }
+    ~Guard() {
+      record(site_, startCycles_, readCycles() - startCycles_);
+    }
+    Guard(const Guard&) = delete;
+    Guard& operator=(const Guard&) = delete;
+
+   private:
+    Site site_;
+    uint64_t startCycles_;
+  };
+
+  /**
+   * Raw cycle counter: TSC on x86, the virtual counter on aarch64, and
+   * a steady_clock fallback elsewhere.
+   */
+  static uint64_t readCycles() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __builtin_ia32_rdtsc();
+#elif defined(__aarch64__)
+    uint64_t cval;
+    asm volatile("mrs %0, cntvct_el0" : "=r"(cval));
+    return cval;
+#else
+    return std::chrono::steady_clock::now().time_since_epoch().count();
+#endif
+  }
+
+  static void record(Site site, uint64_t startCycles, uint64_t deltaCycles);
+
+  static const char* getSiteName(Site site);
+
+  /**
+   * Copy out the most recent records from every thread's ring, oldest
+   * first within each thread.  Does not consume records.
+   */
+  static std::vector<Record> readAllThreads();
+
+  /**
+   * Consume the records this thread has written since the last drain.
+   */
+  static std::vector<Record> drainCurrentThread();
+
+ private:
+  // Power of two so indexing is a mask; 4096 records is 96KB per thread
+  static constexpr uint64_t kRingSize = 4096;
+
+  struct Ring {
+    std::array<Record, kRingSize> records;
+    std::atomic<uint64_t> head{0};
+    uint64_t tail{0}; // only touched by drainCurrentThread()
+
+    void push(const Record& record);
+  };
+
+  class RingTag;
+  static folly::ThreadLocal<Ring, RingTag>& getRing();
+};
+
+/**
+ * Declares a probe scope covering the rest of the enclosing block.
+ * Compiles away entirely with -DPROXYGEN_DISABLE_CYCLE_PROBES.
+ */
+#ifndef PROXYGEN_DISABLE_CYCLE_PROBES
+#define PROXYGEN_CYCLE_PROBE(site)                                \
+  ::proxygen::CycleProbe::Guard FB_ANONYMOUS_VARIABLE(cycleProbe)(\
+      ::proxygen::CycleProbe::Site::site)
+#else
+#define PROXYGEN_CYCLE_PROBE(site)
+#endif
+
+} // namespace proxygen
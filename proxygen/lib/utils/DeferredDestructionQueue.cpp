@@ -0,0 +1,37 @@
+/*
+ *  Copyright (c) 2015-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include <proxygen/lib/utils/DeferredDestructionQueue.h>
+
+#include <folly/Indestructible.h>
+#include <folly/io/async/EventBaseLocal.h>
+
+namespace proxygen {
+
+DeferredDestructionQueue& DeferredDestructionQueue::get(
+    folly::EventBase& evb) {
+  static folly::Indestructible<folly::EventBaseLocal<DeferredDestructionQueue>>
+      local;
+  return local->getOrCreate(evb, evb);
+}
+
+void DeferredDestructionQueue::runLoopCallback() noexcept {
+  // Releasing a guard can enqueue more work (e.g. a session destructor
+  // dropping the last guard on its transactions), so drain until empty.
+  while (!pendingGuards_.empty() || !pendingChains_.empty()) {
+    auto guards = std::move(pendingGuards_);
+    pendingGuards_.clear();
+    auto chains = std::move(pendingChains_);
+    pendingChains_.clear();
+    chains.clear();
+    guards.clear();
+  }
+}
+
+} // proxygen
@@ -0,0 +1,92 @@
+/*
+ *  Copyright (c) 2015-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#pragma once
+
+#include <folly/io/IOBuf.h>
+#include <folly/io/async/DelayedDestructionBase.h>
+#include <folly/io/async/EventBase.h>
+#include <vector>
+
+namespace proxygen {
+
+/**
+ * A per-EventBase end-of-loop destruction queue.
+ *
+ * DelayedDestruction objects normally destruct wherever the last
+ * DestructorGuard happens to be released, scattering session and
+ * transaction teardown through the loop iteration between hot parsing and
+ * write work.  Handing the final guard (or an IOBuf chain about to be
+ * dropped) to this queue instead defers the free to a single drain pass at
+ * the end of the current loop iteration, so all the teardown that became
+ * due during the iteration runs back to back.  That keeps destructor code
+ * and the allocator's free paths out of the hot part of the iteration and
+ * lets the pools above reclaim in bulk during connection churn.
+ *
+ * The queue is not thread-safe; add() must be called from the EventBase
+ * thread the queue belongs to.
+ */
+class DeferredDestructionQueue : private folly::EventBase::LoopCallback {
+ public:
+  explicit DeferredDestructionQueue(folly::EventBase& evb) : evb_(evb) {
+  }
+
+  ~DeferredDestructionQueue() override {
+    runLoopCallback();
+  }
+
+  /**
+   * Returns the queue attached to the given EventBase, creating it on
+   * first use.  The queue is destroyed (after a final drain) with the
+   * EventBase.
+   */
+  static DeferredDestructionQueue& get(folly::EventBase& evb);
+
+  /**
+   * Holds the guard until the drain pass at the end of the current loop
+   * iteration.  If it is the last guard on its object by then, the object
+   * destructs in the drain.
+   */
+  void add(folly::DelayedDestructionBase::DestructorGuard guard) {
+    schedule();
+    pendingGuards_.emplace_back(std::move(guard));
+  }
+
+  /**
+   * Frees the given IOBuf chain in the drain pass at the end of the
+   * current loop iteration.  Null or empty chains are accepted and
+   * ignored.
+   */
+  void add(std::unique_ptr<folly::IOBuf> chain) {
+    if (!chain) {
+      return;
+    }
+    schedule();
+    pendingChains_.emplace_back(std::move(chain));
+  }
+
+  size_t pendingCount() const {
+    return pendingGuards_.size() + pendingChains_.size();
+  }
+
+ private:
+  void runLoopCallback() noexcept override;
+
+  void schedule() {
+    if (!isLoopCallbackScheduled()) {
+      evb_.runInLoop(this, true /* thisIteration */);
+    }
+  }
+
+  folly::EventBase& evb_;
+  std::vector<folly::DelayedDestructionBase::DestructorGuard> pendingGuards_;
+  std::vector<std::unique_ptr<folly::IOBuf>> pendingChains_;
+};
+
+} // proxygen
@@ -9,9 +9,88 @@
  */
 #include <proxygen/lib/utils/HTTPTime.h>
 
+#include <cstring>
 #include <glog/logging.h>
 
 
+namespace {
+
+const char kWeekdayNames[] = "SunMonTueWedThuFriSat";
+const char kMonthNames[] = "JanFebMarAprMayJunJulAugSepOctNovDec";
+
+// Days since the epoch for a calendar date; the usual era-based civil
+// calendar arithmetic (works for dates before 1970 too)
+int64_t daysFromCivil(int64_t y, unsigned m, unsigned d) {
+  y -= m <= 2;
+  const int64_t era = (y >= 0 ? y : y - 399) / 400;
+  const unsigned yoe = static_cast<unsigned>(y - era * 400);
+  const unsigned doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+  const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+  return era * 146097 + static_cast<int64_t>(doe) - 719468;
+}
+
+int parseDigits(const char* p, size_t count) {
+  int result = 0;
+  for (size_t i = 0; i < count; i++) {
+    if (p[i] < '0' || p[i] > '9') {
+      return -1;
+    }
+    result = result * 10 + (p[i] - '0');
+  }
+  return result;
+}
+
+void writeDigits(char* p, size_t count, unsigned value) {
+  for (size_t i = count; i > 0; i--) {
+    p[i - 1] = char('0' + value % 10);
+    value /= 10;
+  }
+}
+
+/**
+ * Parse the RFC 7231 IMF-fixdate format directly, e.g.
+ * "Sun, 06 Nov 1994 08:49:37 GMT".  This is what conformant senders emit
+ * for If-Modified-Since and friends; the obsolete formats fall back to
+ * strptime.  Returns false if the input is not in this exact shape.
+ */
+bool parseImfFixdate(const std::string& s, int64_t& result) {
+  if (s.size() != 29 || s[3] != ',' || s[4] != ' ' || s[7] != ' ' ||
+      s[11] != ' ' || s[16] != ' ' || s[19] != ':' || s[22] != ':' ||
+      memcmp(s.data() + 25, " GMT", 4) != 0) {
+    return false;
+  }
+  bool weekdayOk = false;
+  for (size_t i = 0; i < 7; i++) {
+    if (memcmp(s.data(), kWeekdayNames + 3 * i, 3) == 0) {
+      weekdayOk = true;
+      break;
+    }
+  }
+  int month = 0;
+  for (size_t i = 0; i < 12; i++) {
+    if (memcmp(s.data() + 8, kMonthNames + 3 * i, 3) == 0) {
+      month = i + 1;
+      break;
+    }
+  }
+  int day = parseDigits(s.data() + 5, 2);
+  int year = parseDigits(s.data() + 12, 4);
+  int hour = parseDigits(s.data() + 17, 2);
+  int minute = parseDigits(s.data() + 20, 2);
+  int second = parseDigits(s.data() + 23, 2);
+  // Same ranges strptime accepts, including second 60 for leap seconds
+  if (!weekdayOk || month == 0 || day < 1 || day > 31 || year < 0 ||
+      hour > 23 || hour < 0 || minute > 59 || minute < 0 || second > 60 ||
+      second < 0) {
+    return false;
+  }
+  result = daysFromCivil(year, month, day) * 86400 + hour * 3600 +
+      minute * 60 + second;
+  return true;
+}
+
+}
+
 namespace proxygen {
 
 folly::Optional<int64_t> parseHTTPDateTime(const std::string& s) {
@@ -21,6 +100,11 @@ folly::Optional<int64_t> parseHTTPDateTime(const std::string& s) {
     return folly::none;
   }
 
+  int64_t fixdate;
+  if (parseImfFixdate(s, fixdate)) {
+    return folly::Optional<int64_t>(fixdate);
+  }
+
   // Sun, 06 Nov 1994 08:49:37 GMT  ; RFC 822, updated by RFC 1123
   // Sunday, 06-Nov-94 08:49:37 GMT ; RFC 850, obsoleted by RFC 1036
   // Sun Nov 6 08:49:37 1994        ; ANSI C's asctime() format
@@ -36,4 +120,45 @@ folly::Optional<int64_t> parseHTTPDateTime(const std::string& s) {
   return folly::none;
 }
 
+std::string formatHTTPDateTime(int64_t epoch) {
+  int64_t days = epoch / 86400;
+  int64_t rem = epoch % 86400;
+  if (rem < 0) {
+    rem += 86400;
+    days -= 1;
+  }
+
+  // Inverse of daysFromCivil
+  int64_t z = days + 719468;
+  const int64_t era = (z >= 0 ? z : z - 146096) / 146097;
+  const unsigned doe = static_cast<unsigned>(z - era * 146097);
+  const unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+  const int64_t y = static_cast<int64_t>(yoe) + era * 400;
+  const unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+  const unsigned mp = (5 * doy + 2) / 153;
+  const unsigned day = doy - (153 * mp + 2) / 5 + 1;
+  const unsigned month = mp + (mp < 10 ? 3 : -9);
+  const int64_t year = y + (month <= 2);
+  const unsigned weekday = static_cast<unsigned>(
+      days >= -4 ? (days + 4) % 7 : (days + 5) % 7 + 6);
+
+  char buf[29];
+  memcpy(buf, kWeekdayNames + 3 * weekday, 3);
+  buf[3] = ',';
+  buf[4] = ' ';
+  writeDigits(buf + 5, 2, day);
+  buf[7] = ' ';
+  memcpy(buf + 8, kMonthNames + 3 * (month - 1), 3);
+  buf[11] = ' ';
+  writeDigits(buf + 12, 4, static_cast<unsigned>(year));
+  buf[16] = ' ';
+  writeDigits(buf + 17, 2, static_cast<unsigned>(rem / 3600));
+  buf[19] = ':';
+  writeDigits(buf + 20, 2, static_cast<unsigned>((rem / 60) % 60));
+  buf[22] = ':';
+  writeDigits(buf + 23, 2, static_cast<unsigned>(rem % 60));
+  memcpy(buf + 25, " GMT", 4);
+  return std::string(buf, sizeof(buf));
+}
+
 } // proxygen
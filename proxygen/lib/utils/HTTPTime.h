@@ -17,4 +17,11 @@ namespace proxygen {
 
 folly::Optional<int64_t> parseHTTPDateTime(const std::string& s);
 
+/**
+ * Render an epoch time as an RFC 7231 IMF-fixdate,
+ * e.g. "Sun, 06 Nov 1994 08:49:37 GMT", without going through
+ * gmtime/strftime.
+ */
+std::string formatHTTPDateTime(int64_t epoch);
+
 } // proxygen
@@ -0,0 +1,159 @@
+/*
+ *  Copyright (c) 2015-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include <proxygen/lib/utils/IOBufScanner.h>
+
+#include <algorithm>
+#include <cstring>
+#include <glog/logging.h>
+
+namespace {
+
+// First offset in hay where needle matches in full, or npos.  memchr
+// narrows the candidates, so the scan is vectorized for free.
+size_t findInRange(folly::ByteRange hay, folly::ByteRange needle) {
+  if (needle.size() > hay.size()) {
+    return proxygen::IOBufScanner::npos;
+  }
+  const uint8_t* p = hay.data();
+  const uint8_t* const lastStart = hay.data() + hay.size() - needle.size() + 1;
+  while (p < lastStart) {
+    p = static_cast<const uint8_t*>(memchr(p, needle[0], lastStart - p));
+    if (p == nullptr) {
+      return proxygen::IOBufScanner::npos;
+    }
+    if (memcmp(p, needle.data(), needle.size()) == 0) {
+      return p - hay.data();
+    }
+    ++p;
+  }
+  return proxygen::IOBufScanner::npos;
+}
+
+} // namespace
+
+namespace proxygen {
+
+constexpr size_t IOBufScanner::npos;
+
+IOBufScanner::IOBufScanner(const folly::IOBuf* chain)
+    : head_(chain), buf_(chain) {
+  remaining_ = chain ? chain->computeChainDataLength() : 0;
+  advanceBuffer();
+}
+
+void IOBufScanner::advanceBuffer() {
+  // Step over fully-consumed and empty buffers; remaining_ > 0
+  // guarantees a non-empty one exists ahead
+  while (remaining_ > 0 && bufOffset_ >= buf_->length()) {
+    buf_ = buf_->next();
+    bufOffset_ = 0;
+  }
+}
+
+folly::ByteRange IOBufScanner::peekSpan() const {
+  if (remaining_ == 0) {
+    return {};
+  }
+  return {buf_->data() + bufOffset_, buf_->length() - bufOffset_};
+}
+
+folly::ByteRange IOBufScanner::peek(size_t n) {
+  n = std::min(n, remaining_);
+  if (n == 0) {
+    return {};
+  }
+  auto span = peekSpan();
+  if (span.size() >= n) {
+    return span.subpiece(0, n);
+  }
+  // Stitch the straddling window together; only these n bytes are copied
+  stitchBuf_.resize(n);
+  size_t copied = 0;
+  const folly::IOBuf* b = buf_;
+  size_t off = bufOffset_;
+  while (copied < n) {
+    const size_t take = std::min(b->length() - off, n - copied);
+    memcpy(stitchBuf_.data() + copied, b->data() + off, take);
+    copied += take;
+    b = b->next();
+    off = 0;
+  }
+  return {stitchBuf_.data(), n};
+}
+
+void IOBufScanner::skip(size_t n) {
+  DCHECK_LE(n, remaining_);
+  while (n > 0) {
+    const size_t take = std::min(buf_->length() - bufOffset_, n);
+    bufOffset_ += take;
+    offset_ += take;
+    remaining_ -= take;
+    n -= take;
+    advanceBuffer();
+  }
+}
+
+size_t IOBufScanner::find(uint8_t c) {
+  while (remaining_ > 0) {
+    auto span = peekSpan();
+    const auto* hit =
+        static_cast<const uint8_t*>(memchr(span.data(), c, span.size()));
+    if (hit != nullptr) {
+      skip(hit - span.data());
+      return offset_;
+    }
+    skip(span.size());
+  }
+  return npos;
+}
+
+size_t IOBufScanner::find(folly::ByteRange needle) {
+  const size_t nlen = needle.size();
+  if (nlen == 0) {
+    return offset_;
+  }
+  while (remaining_ >= nlen) {
+    auto span = peekSpan();
+    // Matches lying entirely within this span
+    size_t pos = findInRange(span, needle);
+    if (pos != npos) {
+      skip(pos);
+      return offset_;
+    }
+    // Matches starting in the span's last nlen-1 bytes run into the next
+    // buffer; stitch just that window and search it
+    if (nlen > 1 && remaining_ > span.size()) {
+      const size_t tail = std::min(nlen - 1, span.size());
+      const size_t extra = std::min(nlen - 1, remaining_ - span.size());
+      stitchBuf_.resize(tail + extra);
+      memcpy(stitchBuf_.data(), span.end() - tail, tail);
+      size_t copied = 0;
+      const folly::IOBuf* b = buf_->next();
+      size_t off = 0;
+      while (copied < extra) {
+        const size_t take = std::min(b->length() - off, extra - copied);
+        memcpy(stitchBuf_.data() + tail + copied, b->data() + off, take);
+        copied += take;
+        b = b->next();
+        off = 0;
+      }
+      pos = findInRange({stitchBuf_.data(), tail + extra}, needle);
+      if (pos != npos) {
+        skip(span.size() - tail + pos);
+        return offset_;
+      }
+    }
+    skip(span.size());
+  }
+  skip(remaining_);
+  return npos;
+}
+
+} // namespace proxygen
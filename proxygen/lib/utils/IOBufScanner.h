@@ -0,0 +1,114 @@
+/*
+ *  Copyright (c) 2015-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#pragma once
+
+#include <folly/Range.h>
+#include <folly/io/IOBuf.h>
+#include <limits>
+#include <vector>
+
+namespace proxygen {
+
+/**
+ * Read-only cursor over an IOBuf chain for handlers that scan body
+ * content in place - content filters, protocol sniffers and the like.
+ * The usual alternative, coalesce(), flattens the chain and undoes every
+ * zero-copy hand-off upstream of the handler; the scanner instead
+ * presents the chain as a sequence of contiguous spans and only ever
+ * copies when a requested window straddles a buffer boundary, and then
+ * only the straddling bytes into a small internal stitch buffer.
+ *
+ * The find primitives ride on memchr, so the byte scan runs at the
+ * vectorized speed of the platform's libc on each contiguous span;
+ * matches that straddle spans are found via the stitch buffer.
+ *
+ * The scanner holds no ownership: the chain must stay alive and
+ * unmodified while a scanner points into it, and spans returned by
+ * peekSpan()/peek() are invalidated by the next call that moves or
+ * stitches.
+ */
+class IOBufScanner {
+ public:
+  static constexpr size_t npos = std::numeric_limits<size_t>::max();
+
+  /**
+   * chain may be nullptr or empty; the scanner starts exhausted then.
+   */
+  explicit IOBufScanner(const folly::IOBuf* chain);
+
+  /**
+   * Bytes between the cursor and the end of the chain.
+   */
+  size_t remaining() const {
+    return remaining_;
+  }
+
+  /**
+   * Cursor position as an offset from the start of the chain.
+   */
+  size_t offset() const {
+    return offset_;
+  }
+
+  bool isExhausted() const {
+    return remaining_ == 0;
+  }
+
+  /**
+   * The contiguous bytes at the cursor, without copying; empty when
+   * exhausted.  Scanning span by span visits every byte exactly once.
+   */
+  folly::ByteRange peekSpan() const;
+
+  /**
+   * Up to n bytes at the cursor as one contiguous range, clamped to
+   * remaining().  Served straight out of the current buffer when it
+   * holds enough; otherwise the bytes are stitched together across the
+   * boundary into the internal buffer.  The cursor does not move.
+   */
+  folly::ByteRange peek(size_t n);
+
+  /**
+   * Advance the cursor n bytes; n must be <= remaining().
+   */
+  void skip(size_t n);
+
+  /**
+   * Find the next occurrence of c at or after the cursor.  On a hit the
+   * cursor is left on the match and its chain offset is returned; on a
+   * miss the cursor is left exhausted and npos is returned.
+   */
+  size_t find(uint8_t c);
+
+  /**
+   * Find the next occurrence of needle at or after the cursor, including
+   * matches straddling buffer boundaries.  Cursor semantics as with
+   * find(uint8_t).  An empty needle matches at the cursor.
+   */
+  size_t find(folly::ByteRange needle);
+
+ private:
+  /**
+   * Step over fully-consumed buffers so buf_ holds at least one unread
+   * byte, or flag exhaustion.
+   */
+  void advanceBuffer();
+
+  const folly::IOBuf* head_{nullptr};
+  const folly::IOBuf* buf_{nullptr};
+  // Read position within buf_
+  size_t bufOffset_{0};
+  size_t offset_{0};
+  size_t remaining_{0};
+  // Scratch for windows that straddle buffer boundaries
+  std::vector<uint8_t> stitchBuf_;
+};
+
+} // namespace proxygen
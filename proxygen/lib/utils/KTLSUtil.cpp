@@ -0,0 +1,213 @@
+/*
+ *  Copyright (c) 2019-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include <proxygen/lib/utils/KTLSUtil.h>
+
+#include <folly/io/async/AsyncSSLSocket.h>
+#include <folly/io/async/AsyncSocket.h>
+
+#if defined(__linux__) && __has_include(<linux/tls.h>)
+#define PROXYGEN_HAVE_KTLS 1
+#include <linux/tls.h>
+#include <netinet/tcp.h>
+#include <openssl/hmac.h>
+#include <openssl/ssl.h>
+#include <sys/socket.h>
+// Present in the kernel since the tls ULP landed, but not in every
+// userspace header set proxygen builds against
+#ifndef SOL_TLS
+#define SOL_TLS 282
+#endif
+#ifndef TCP_ULP
+#define TCP_ULP 31
+#endif
+#endif
+
+namespace proxygen {
+
+bool KTLSUtil::isKTLSSupported() {
+#if PROXYGEN_HAVE_KTLS
+  return true;
+#else
+  return false;
+#endif
+}
+
+bool KTLSUtil::isCipherEligible(folly::StringPiece opensslCipherName) {
+  // The kernel tls module speaks TLS 1.2 AES-128-GCM; the suite name
+  // carries the bulk cipher as its suffix regardless of key exchange
+  // (TLS 1.3 names use underscores, so they never match)
+  return opensslCipherName.endsWith("AES128-GCM-SHA256");
+}
+
+#if PROXYGEN_HAVE_KTLS
+
+namespace {
+
+/**
+ * TLS 1.2 PRF (rfc5246 section 5) with SHA-256, the hash every eligible
+ * suite uses.  Computes P_SHA256(secret, label + seed).
+ */
+bool tls12Prf(folly::ByteRange secret,
+              folly::StringPiece label,
+              folly::ByteRange seed,
+              uint8_t* out,
+              size_t outLen) {
+  std::vector<uint8_t> labelSeed(label.begin(), label.end());
+  labelSeed.insert(labelSeed.end(), seed.begin(), seed.end());
+
+  // A(1) = HMAC(secret, label + seed)
+  uint8_t a[EVP_MAX_MD_SIZE];
+  unsigned aLen = 0;
+  if (!HMAC(EVP_sha256(), secret.data(), secret.size(),
+            labelSeed.data(), labelSeed.size(), a, &aLen)) {
+    return false;
+  }
+
+  size_t done = 0;
+  while (done < outLen) {
+    std::vector<uint8_t> input(a, a + aLen);
+    input.insert(input.end(), labelSeed.begin(), labelSeed.end());
+    uint8_t block[EVP_MAX_MD_SIZE];
+    unsigned blockLen = 0;
+    if (!HMAC(EVP_sha256(), secret.data(), secret.size(),
+              input.data(), input.size(), block, &blockLen)) {
+      return false;
+    }
+    size_t n = std::min<size_t>(blockLen, outLen - done);
+    memcpy(out + done, block, n);
+    done += n;
+
+    // A(i+1) = HMAC(secret, A(i))
+    uint8_t next[EVP_MAX_MD_SIZE];
+    unsigned nextLen = 0;
+    if (!HMAC(EVP_sha256(), secret.data(), secret.size(), a, aLen,
+              next, &nextLen)) {
+      return false;
+    }
+    memcpy(a, next, nextLen);
+    aLen = nextLen;
+  }
+  return true;
+}
+
+void fillCryptoInfo(tls12_crypto_info_aes_gcm_128& info,
+                    const uint8_t* key,
+                    const uint8_t* salt) {
+  memset(&info, 0, sizeof(info));
+  info.info.version = TLS_1_2_VERSION;
+  info.info.cipher_type = TLS_CIPHER_AES_GCM_128;
+  memcpy(info.key, key, TLS_CIPHER_AES_GCM_128_KEY_SIZE);
+  memcpy(info.salt, salt, TLS_CIPHER_AES_GCM_128_SALT_SIZE);
+  // Exactly one record - the Finished message - has gone out under the
+  // new keys in each direction when the acceptor calls us, so both
+  // sequence numbers are 1.  The explicit nonce tracks the sequence.
+  uint8_t seq[TLS_CIPHER_AES_GCM_128_REC_SEQ_SIZE] = {0, 0, 0, 0, 0, 0, 0, 1};
+  memcpy(info.rec_seq, seq, sizeof(seq));
+  memcpy(info.iv, seq, TLS_CIPHER_AES_GCM_128_IV_SIZE);
+}
+
+} // namespace
+
+KTLSUtil::OffloadResult KTLSUtil::tryOffload(
+    folly::AsyncTransportWrapper::UniquePtr sock) {
+  auto sslSock = sock->getUnderlyingTransport<folly::AsyncSSLSocket>();
+  if (!sslSock || sslSock != sock.get()) {
+    // not TLS, or wrapped in something we can't detach the fd from
+    return {std::move(sock), false};
+  }
+  SSL* ssl = const_cast<SSL*>(sslSock->getSSL());
+  if (!ssl || SSL_version(ssl) != TLS1_2_VERSION) {
+    return {std::move(sock), false};
+  }
+  const SSL_CIPHER* cipher = SSL_get_current_cipher(ssl);
+  if (!cipher || !isCipherEligible(SSL_CIPHER_get_name(cipher))) {
+    return {std::move(sock), false};
+  }
+
+  // Re-derive the record keys the way the handshake did: the key block
+  // is PRF(master, "key expansion", server_random + client_random) and
+  // for an AEAD suite lays out client key, server key, client salt,
+  // server salt
+  uint8_t master[48];
+  size_t masterLen = SSL_SESSION_get_master_key(
+      SSL_get_session(ssl), master, sizeof(master));
+  uint8_t clientRandom[32];
+  uint8_t serverRandom[32];
+  if (masterLen != sizeof(master) ||
+      SSL_get_client_random(ssl, clientRandom, sizeof(clientRandom)) !=
+          sizeof(clientRandom) ||
+      SSL_get_server_random(ssl, serverRandom, sizeof(serverRandom)) !=
+          sizeof(serverRandom)) {
+    return {std::move(sock), false};
+  }
+  uint8_t randoms[64];
+  memcpy(randoms, serverRandom, 32);
+  memcpy(randoms + 32, clientRandom, 32);
+  constexpr size_t kKeySize = TLS_CIPHER_AES_GCM_128_KEY_SIZE;
+  constexpr size_t kSaltSize = TLS_CIPHER_AES_GCM_128_SALT_SIZE;
+  uint8_t keyBlock[2 * kKeySize + 2 * kSaltSize];
+  if (!tls12Prf(folly::ByteRange(master, masterLen),
+                "key expansion",
+                folly::ByteRange(randoms, sizeof(randoms)),
+                keyBlock,
+                sizeof(keyBlock))) {
+    return {std::move(sock), false};
+  }
+  const uint8_t* clientKey = keyBlock;
+  const uint8_t* serverKey = keyBlock + kKeySize;
+  const uint8_t* clientSalt = keyBlock + 2 * kKeySize;
+  const uint8_t* serverSalt = clientSalt + kSaltSize;
+
+  const int fd = sslSock->getFd();
+  if (setsockopt(fd, SOL_TCP, TCP_ULP, "tls", sizeof("tls")) != 0) {
+    // kernel without the tls module; nothing configured yet
+    VLOG(4) << "kTLS unavailable: TCP_ULP errno=" << errno;
+    return {std::move(sock), false};
+  }
+  // The ULP alone passes traffic through unchanged, so failing RX here
+  // is still a clean fallback.  Once RX is live the userspace stack can
+  // no longer read this connection, which makes a TX failure after it
+  // fatal - hence RX first, so at most one partially-configured state
+  // exists
+  tls12_crypto_info_aes_gcm_128 rx;
+  fillCryptoInfo(rx, clientKey, clientSalt);
+  if (setsockopt(fd, SOL_TLS, TLS_RX, &rx, sizeof(rx)) != 0) {
+    VLOG(4) << "kTLS unavailable: TLS_RX errno=" << errno;
+    return {std::move(sock), false};
+  }
+  tls12_crypto_info_aes_gcm_128 tx;
+  fillCryptoInfo(tx, serverKey, serverSalt);
+  if (setsockopt(fd, SOL_TLS, TLS_TX, &tx, sizeof(tx)) != 0) {
+    LOG(ERROR) << "kTLS TLS_TX failed after TLS_RX, dropping connection,"
+               << " errno=" << errno;
+    return {nullptr, false};
+  }
+
+  // The kernel owns the record layer now; continue on a plain socket
+  // over the same fd.  The SSL object and its buffered state die with
+  // the old transport
+  auto evb = sslSock->getEventBase();
+  auto detachedFd = sslSock->detachFd();
+  sock.reset();
+  folly::AsyncTransportWrapper::UniquePtr plain(
+      new folly::AsyncSocket(evb, detachedFd));
+  return {std::move(plain), true};
+}
+
+#else // !PROXYGEN_HAVE_KTLS
+
+KTLSUtil::OffloadResult KTLSUtil::tryOffload(
+    folly::AsyncTransportWrapper::UniquePtr sock) {
+  return {std::move(sock), false};
+}
+
+#endif
+
+} // namespace proxygen
@@ -0,0 +1,73 @@
+/*
+ *  Copyright (c) 2019-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#pragma once
+
+#include <folly/Range.h>
+#include <folly/io/async/AsyncTransport.h>
+
+namespace proxygen {
+
+/**
+ * Post-handshake kernel TLS offload for downstream connections.
+ *
+ * After the userspace handshake completes, the record keys for an
+ * eligible session (TLS 1.2, AES-128-GCM) can be handed to the kernel's
+ * tls ULP so that record framing and crypto happen in the kernel and
+ * the session reads and writes plaintext through an ordinary socket.
+ * That removes the userspace encrypt/decrypt copy from every byte and
+ * lets egress batches go out as full writes without userspace record
+ * chunking.
+ *
+ * The offload must happen immediately after the handshake, before any
+ * application data moves in either direction: the kernel needs the
+ * current record sequence numbers and right after the handshake both
+ * are exactly 1 (the Finished message each side sent under the new
+ * keys).  HTTPSessionAcceptor calls this before the session exists, so
+ * that holds by construction.  Renegotiation and post-handshake tickets
+ * are not supported on an offloaded connection; close sends a bare FIN
+ * rather than close_notify, which HTTP tolerates since its framing is
+ * self-delimiting.
+ */
+class KTLSUtil {
+ public:
+  struct OffloadResult {
+    /**
+     * The transport to continue with.  On successful offload this is a
+     * plain socket on the same fd; on clean fallback it is the original
+     * transport untouched.  nullptr means the kernel was left partially
+     * configured and the connection can no longer carry either stack -
+     * the caller must drop it.
+     */
+    folly::AsyncTransportWrapper::UniquePtr transport;
+    bool offloaded{false};
+  };
+
+  /**
+   * True when proxygen was built on a system with kernel TLS headers.
+   * Runtime support still depends on the running kernel; ineligible
+   * systems fall back cleanly in tryOffload().
+   */
+  static bool isKTLSSupported();
+
+  /**
+   * True for cipher suites the kernel tls module can take over
+   * (TLS 1.2 AES-128-GCM suites, by OpenSSL name).
+   */
+  static bool isCipherEligible(folly::StringPiece opensslCipherName);
+
+  /**
+   * Attempt to move record protection for an accepted, handshaken TLS
+   * connection into the kernel.  Cipher mismatch, non-Linux hosts and
+   * kernels without the tls module all fall back cleanly.
+   */
+  static OffloadResult tryOffload(folly::AsyncTransportWrapper::UniquePtr sock);
+};
+
+} // namespace proxygen
@@ -0,0 +1,101 @@
+/*
+ *  Copyright (c) 2015-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+namespace proxygen {
+
+/**
+ * STL allocator that serves single-object allocations from a per-thread
+ * freelist so node-based containers with high element churn - e.g. the
+ * per-session transaction map, whose nodes are created and destroyed
+ * once per request - stop round-tripping the global allocator.
+ *
+ * Only allocations of exactly one object are pooled; array and bucket
+ * allocations fall through to operator new.  The freelist is shared by
+ * every container on the thread that instantiates the allocator with
+ * the same node type, and is capped at kMaxPooled entries per thread;
+ * anything beyond that is released to the heap.  Freed nodes keep their
+ * address until reuse, so containers that rely on node stability (node
+ * maps handing out element pointers) are unaffected.
+ */
+template <typename T, size_t kMaxPooled = 64>
+class NodePoolAllocator {
+ public:
+  using value_type = T;
+
+  template <typename U>
+  struct rebind {
+    using other = NodePoolAllocator<U, kMaxPooled>;
+  };
+
+  NodePoolAllocator() = default;
+
+  template <typename U>
+  /* implicit */ NodePoolAllocator(
+      const NodePoolAllocator<U, kMaxPooled>&) noexcept {}
+
+  T* allocate(size_t n) {
+    if (n == 1) {
+      auto& pool = freeList().entries;
+      if (!pool.empty()) {
+        void* node = pool.back();
+        pool.pop_back();
+        return static_cast<T*>(node);
+      }
+    }
+    return static_cast<T*>(::operator new(n * sizeof(T)));
+  }
+
+  void deallocate(T* p, size_t n) {
+    if (n == 1) {
+      auto& pool = freeList().entries;
+      if (pool.size() < kMaxPooled) {
+        pool.push_back(p);
+        return;
+      }
+    }
+    ::operator delete(p);
+  }
+
+  // Pooled nodes for the calling thread; exposed for tests and memory
+  // accounting
+  static size_t getPooledNodes() {
+    return freeList().entries.size();
+  }
+
+  friend bool operator==(const NodePoolAllocator&,
+                         const NodePoolAllocator&) noexcept {
+    return true;
+  }
+  friend bool operator!=(const NodePoolAllocator&,
+                         const NodePoolAllocator&) noexcept {
+    return false;
+  }
+
+ private:
+  struct FreeList {
+    std::vector<void*> entries;
+    ~FreeList() {
+      for (auto node : entries) {
+        ::operator delete(node);
+      }
+    }
+  };
+
+  static FreeList& freeList() {
+    static thread_local FreeList list;
+    return list;
+  }
+};
+
+} // namespace proxygen
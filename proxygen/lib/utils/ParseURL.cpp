@@ -11,7 +11,7 @@
 
 #include <algorithm>
 #include <folly/portability/Sockets.h>
-#include <proxygen/lib/utils/UtilInl.h>
+#include <proxygen/lib/utils/URLScan.h>
 
 #include <proxygen/external/http_parser/http_parser.h>
 
@@ -108,15 +108,17 @@ void ParseURL::parseNonFully() noexcept {
     return;
   }
 
-  // Check if the URL has only printable characters and no control character.
-  if (!validateURL(url_)) {
+  // One pass over the URL locates the delimiters and checks that it has
+  // only printable characters and no control character.
+  auto scan = scanURL(url_);
+  if (!scan.valid) {
     valid_ = false;
     return;
   }
 
-  auto pathStart = url_.find('/');
-  auto queryStart = url_.find('?');
-  auto hashStart = url_.find('#');
+  auto pathStart = scan.pathStart;
+  auto queryStart = scan.queryStart;
+  auto hashStart = scan.hashStart;
 
   auto queryEnd = std::min(hashStart, std::string::npos);
   auto pathEnd = std::min(queryStart, hashStart);
@@ -11,6 +11,8 @@
 
 #include <glog/logging.h>
 
+#include <algorithm>
+#include <cstring>
 #include <folly/FBVector.h>
 #include <folly/Optional.h>
 #include <proxygen/lib/utils/UtilInl.h>
@@ -152,6 +154,25 @@ class PerfectIndexMap {
     return keys_.size() - noneKeyCount_;
   }
 
+  // Occupancy counters for sizing maps from production data.  Slots are
+  // never reclaimed on removal so liveSlots / totalSlots is the effective
+  // load factor of the index.
+  struct OccupancyStats {
+    size_t totalSlots{0};     // all slots, live or not
+    size_t liveSlots{0};      // entries currently in the map
+    size_t otherKeySlots{0};  // live entries whose key hashed to OtherKey
+    size_t tombstoneSlots{0}; // removed entries still occupying slots
+  };
+
+  OccupancyStats getOccupancyStats() const {
+    OccupancyStats stats;
+    stats.totalSlots = keys_.size();
+    stats.liveSlots = keys_.size() - noneKeyCount_;
+    stats.otherKeySlots = otherKeyCount_;
+    stats.tombstoneSlots = noneKeyCount_;
+    return stats;
+  }
+
   void setOtherKey(const std::string &keyStr, const std::string &value) {
     bool set = false;
     size_t searchIndex = 0;
@@ -175,6 +196,16 @@ class PerfectIndexMap {
  private:
 
 
+  // The packed length byte stored per OtherKey name.  Lengths are clamped
+  // to one byte; two clamped lengths always compare equal and so fall
+  // through to the full string compare which settles it.  Equal true
+  // lengths always yield equal bytes so the filter can never reject a
+  // genuine match.
+  static uint8_t otherKeyNameLengthByte(const std::string &keyStr) {
+    const size_t maxLengthByte = 0xff;
+    return static_cast<uint8_t>(std::min(keyStr.size(), maxLengthByte));
+  }
+
   // Utility method for comparing strings private to this class as specified
   // by template parameters.
   bool stringsEqual(const std::string& strA, const std::string& strB) const {
@@ -290,23 +321,46 @@ class PerfectIndexMap {
   }
   std::ptrdiff_t searchForOtherKey(
       const std::string &keyStr, size_t &startIndex) const {
-    while (startIndex < otherKeyNamesKeysIndex_.size()) {
-      // The key can only be OtherKey or NoneKey
-      if (keys_[otherKeyNamesKeysIndex_[startIndex]] == OtherKey) {
-        if (CaseInsensitive) {
-          // One might be tempted to merge this statement with that above
-          // but that would be wrong.  If CaseInsensitive is true, we do not
-          // want any other check evaluating.
-          if (caseInsensitiveEqual(otherKeyNames_[startIndex], keyStr)) {
-            return otherKeyNamesKeysIndex_[startIndex];
-          }
-        } else {
-          if (otherKeyNames_[startIndex] == keyStr) {
-            return otherKeyNamesKeysIndex_[startIndex];
+    const uint8_t target = otherKeyNameLengthByte(keyStr);
+    const uint8_t* lengths = otherKeyNameLengths_.data();
+    const size_t numNames = otherKeyNameLengths_.size();
+    while (startIndex < numNames) {
+      // Reject 8 slots at a time on the packed length bytes before paying
+      // for any per-slot string compare.  A byte of diff is zero iff that
+      // slot's length byte equals the target.
+      if (numNames - startIndex >= sizeof(uint64_t)) {
+        constexpr uint64_t kEveryByte = 0x0101010101010101ULL;
+        uint64_t block;
+        memcpy(&block, lengths + startIndex, sizeof(block));
+        const uint64_t diff = block ^ (kEveryByte * target);
+        if (((diff - kEveryByte) & ~diff & (kEveryByte * 0x80)) == 0) {
+          startIndex += sizeof(uint64_t);
+          continue;
+        }
+      }
+      const size_t blockEnd =
+        std::min(numNames, startIndex + sizeof(uint64_t));
+      for (; startIndex < blockEnd; ++startIndex) {
+        if (lengths[startIndex] != target) {
+          continue;
+        }
+        // The key can only be OtherKey or NoneKey; removed slots keep
+        // their stale length byte so liveness must be confirmed here
+        if (keys_[otherKeyNamesKeysIndex_[startIndex]] == OtherKey) {
+          if (CaseInsensitive) {
+            // One might be tempted to merge this statement with that above
+            // but that would be wrong.  If CaseInsensitive is true, we do
+            // not want any other check evaluating.
+            if (caseInsensitiveEqual(otherKeyNames_[startIndex], keyStr)) {
+              return otherKeyNamesKeysIndex_[startIndex];
+            }
+          } else {
+            if (otherKeyNames_[startIndex] == keyStr) {
+              return otherKeyNamesKeysIndex_[startIndex];
+            }
           }
         }
       }
-      ++startIndex;
     }
     return -1;
   }
@@ -319,6 +373,7 @@ class PerfectIndexMap {
   void addOtherKeyToIndex(const std::string &keyStr, const std::string &value) {
     keys_.push_back(OtherKey);
     otherKeyNames_.emplace_back(keyStr);
+    otherKeyNameLengths_.push_back(otherKeyNameLengthByte(keyStr));
     otherKeyNamesKeysIndex_.push_back(keys_.size() - 1);
     values_.emplace_back(value);
     ++otherKeyCount_;
@@ -331,6 +386,7 @@ class PerfectIndexMap {
   void replaceOtherKeyAtIndex(
       size_t namesIndex, const std::string &keyStr, const std::string &value) {
     otherKeyNames_[namesIndex] = keyStr;
+    otherKeyNameLengths_[namesIndex] = otherKeyNameLengthByte(keyStr);
     values_[otherKeyNamesKeysIndex_[namesIndex]] = value;
   }
 
@@ -406,6 +462,15 @@ class PerfectIndexMap {
   // namesKeyIndex[N] refers to the entry's position in keys_.
   folly::fbvector<size_t> otherKeyNamesKeysIndex_;
 
+  // Packed, cache-line-dense metadata for otherKeyNames_: the clamped
+  // length byte of the N-th OtherKey name.  Searches scan this vector
+  // eight slots at a time and only touch the strings for length matches.
+  // Entries go stale on removal (the slot in keys_ becomes NoneKey) which
+  // is benign as every candidate is confirmed against keys_ and the full
+  // name before being returned.
+  // Strictly speaking: otherKeyNameLengths_.size() == otherKeyNames_.size().
+  folly::fbvector<uint8_t> otherKeyNameLengths_;
+
   // Storage for names whose keys are mapped to OtherKey.
   // This vector can never have more elements than the total numer of OtherKey
   // entries in the map as it should be equal to this count.
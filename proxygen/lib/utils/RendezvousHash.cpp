@@ -8,21 +8,23 @@
  *
  */
 #include <proxygen/lib/utils/RendezvousHash.h>
-#include <folly/container/Foreach.h>
 #include <folly/hash/Hash.h>
 #include <map>
 #include <algorithm>
 #include <vector>
 #include <limits>
-#include <math.h>       /* pow */
+#include <math.h>       /* log */
 
 namespace proxygen {
 void RendezvousHash::build(std::vector<std::pair<
                            std::string, uint64_t> >&nodes) {
+  seeds_.reserve(nodes.size());
+  invWeights_.reserve(nodes.size());
   for (auto it = nodes.begin(); it != nodes.end(); ++it) {
     std::string key = it->first;
     uint64_t weight = it->second;
-    weights_.emplace_back(computeHash(key.c_str(), key.size()), weight);
+    seeds_.push_back(computeHash(key.c_str(), key.size()));
+    invWeights_.push_back(weight == 0 ? 0 : 1.0 / weight);
   }
 }
 
@@ -128,6 +130,24 @@ size_t RendezvousHash::get(const uint64_t key, const size_t rank) const {
   return getNthByWeightedHash(key, rank, nullptr);
 }
 
+/*
+ * Weight-scaled hash for one node, in the log domain: maximizing
+ * pow(scaledHash, 1/weight) is the same as maximizing
+ * log(scaledHash) / weight since exp is monotonic, and log costs a
+ * fraction of pow.  Zero-weight nodes sort below everything, as their
+ * scaled weight of 0 did in the pow domain.
+ */
+double RendezvousHash::weightedHash(const uint64_t key,
+                                    const size_t i) const {
+  double invWeight = invWeights_[i];
+  if (invWeight == 0) {
+    return -std::numeric_limits<double>::infinity();
+  }
+  double scaledHash = (double)computeHash(seeds_[i] + key) /
+      std::numeric_limits<uint64_t>::max();
+  return log(scaledHash) * invWeight;
+}
+
 /*
  * Calculate Hash scaled by weight and return Top N weights.
  * */
@@ -135,26 +155,19 @@ size_t RendezvousHash::getNthByWeightedHash(
     const uint64_t key,
     const size_t rank,
     std::vector<size_t>* returnRankIds) const {
-  size_t modRank = rank % weights_.size();
+  size_t modRank = rank % seeds_.size();
   // optimize if required to return element with max weight, rank ==
-  // weights_.size(), keep track of the maxWeightIndex instead of populating
+  // seeds_.size(), keep track of the maxWeightIndex instead of populating
   // scaledWeights array.
-  double maxWeight = -1;
+  double maxWeight = -std::numeric_limits<double>::infinity();
   int maxWeightIndex = 0;
 
   std::vector<std::pair<double, size_t>> scaledWeights;
   if (modRank != 0) {
-    scaledWeights.reserve(weights_.size());
+    scaledWeights.reserve(seeds_.size());
   }
-  FOR_EACH_ENUMERATE(i, entry, weights_) {
-    // combine the hash with the cluster together
-    double combinedHash = computeHash(entry->first + key);
-    double scaledHash =
-        (double)combinedHash / std::numeric_limits<uint64_t>::max();
-    double scaledWeight = 0;
-    if (entry->second != 0) {
-      scaledWeight = pow(scaledHash, (double)1 / entry->second);
-    }
+  for (size_t i = 0; i < seeds_.size(); i++) {
+    double scaledWeight = weightedHash(key, i);
     if (modRank == 0) {
       if (scaledWeight > maxWeight) {
         maxWeight = scaledWeight;
@@ -200,8 +213,8 @@ std::vector<size_t> RendezvousHash::selectNUnweighted(const uint64_t key,
                                                       const size_t rank) const {
   std::vector<size_t> selection;
   // shortcut if rank is equal or larger than array size
-  if (rank >= weights_.size()) {
-    selection = std::vector<size_t>(weights_.size());
+  if (rank >= seeds_.size()) {
+    selection = std::vector<size_t>(seeds_.size());
     std::generate(
         selection.begin(), selection.end(), [n = 0]() mutable { return n++; });
     return selection;
@@ -211,6 +224,32 @@ std::vector<size_t> RendezvousHash::selectNUnweighted(const uint64_t key,
   return selection;
 }
 
+/*
+ * Returns the top-rank elements in weighted rendezvous order, so callers
+ * get the primary choice and its fallbacks from a single hashing pass.
+ * */
+std::vector<size_t> RendezvousHash::selectNWeighted(const uint64_t key,
+                                                    const size_t rank) const {
+  std::vector<std::pair<double, size_t>> scaledWeights;
+  scaledWeights.reserve(seeds_.size());
+  for (size_t i = 0; i < seeds_.size(); i++) {
+    scaledWeights.emplace_back(weightedHash(key, i), i);
+  }
+
+  size_t count = std::min(rank, seeds_.size());
+  std::partial_sort(scaledWeights.begin(),
+                    scaledWeights.begin() + count,
+                    scaledWeights.end(),
+                    std::greater<std::pair<double, size_t>>());
+
+  std::vector<size_t> selection;
+  selection.reserve(count);
+  for (size_t i = 0; i < count; i++) {
+    selection.push_back(scaledWeights[i].second);
+  }
+  return selection;
+}
+
 uint64_t RendezvousHash::computeHash(const char* data, size_t len) const {
   return folly::hash::fnv64_buf(data, len);
 }
@@ -32,6 +32,14 @@ class RendezvousHash : public ConsistentHash {
   std::vector<size_t> selectNUnweighted(const uint64_t key,
                                         const size_t rank) const;
 
+  /**
+   * Top-rank selection in weighted rendezvous order: element 0 is what
+   * get(key) returns, element 1 is the best fallback, and so on.  One
+   * hashing pass produces the whole retry ordering.
+   */
+  std::vector<size_t> selectNWeighted(const uint64_t key,
+                                      const size_t rank) const;
+
  private:
   size_t getNthByWeightedHash(const uint64_t key,
                               const size_t modRank,
@@ -40,7 +48,13 @@ class RendezvousHash : public ConsistentHash {
 
   uint64_t computeHash(uint64_t i) const;
 
-  std::vector<std::pair<uint64_t, uint64_t>> weights_;
+  double weightedHash(const uint64_t key, const size_t i) const;
+
+  // Node seeds and inverse weights kept as parallel contiguous arrays so
+  // the per-lookup loop streams through dense memory; a zero inverse
+  // weight marks a zero-weight node
+  std::vector<uint64_t> seeds_;
+  std::vector<double> invWeights_;
 };
 
 } // proxygen
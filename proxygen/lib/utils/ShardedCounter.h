@@ -0,0 +1,104 @@
+/*
+ *  Copyright (c) 2015-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <new>
+#include <thread>
+
+#include <folly/Memory.h>
+#include <folly/concurrency/CacheLocality.h>
+#include <folly/lang/Align.h>
+#include <folly/lang/Bits.h>
+
+namespace proxygen {
+
+/**
+ * A multi-producer counter sharded across cache-line-padded slots, one
+ * per core stripe.  Recording is a single relaxed fetch_add on the
+ * calling core's slot, so concurrent writers on different cores never
+ * touch the same cache line; there is no rendezvous with readers.
+ *
+ * Aggregation sums the slots with relaxed loads.  Because writers are
+ * relaxed, a sum is not a point-in-time snapshot, but each added value
+ * is counted exactly once, which is the contract stats pipelines need.
+ * collect() additionally returns the delta since the previous collect(),
+ * for periodic (epoch) export; it is meant to be called from a single
+ * aggregation thread.
+ */
+class ShardedCounter {
+ public:
+  explicit ShardedCounter(size_t numShards = 0) {
+    if (numShards == 0) {
+      numShards = std::thread::hardware_concurrency();
+      if (numShards == 0) {
+        numShards = 1;
+      }
+    }
+    numShards_ = folly::nextPowTwo(numShards);
+    shards_ = static_cast<Shard*>(
+        folly::aligned_malloc(numShards_ * sizeof(Shard), alignof(Shard)));
+    for (size_t i = 0; i < numShards_; i++) {
+      new (&shards_[i]) Shard();
+    }
+  }
+
+  ~ShardedCounter() {
+    folly::aligned_free(shards_);
+  }
+
+  ShardedCounter(const ShardedCounter&) = delete;
+  ShardedCounter& operator=(const ShardedCounter&) = delete;
+
+  void add(int64_t amount = 1) {
+    shard().fetch_add(amount, std::memory_order_relaxed);
+  }
+
+  void sub(int64_t amount = 1) {
+    shard().fetch_sub(amount, std::memory_order_relaxed);
+  }
+
+  /**
+   * Sum of everything recorded so far.
+   */
+  int64_t value() const {
+    int64_t sum = 0;
+    for (size_t i = 0; i < numShards_; i++) {
+      sum += shards_[i].value.load(std::memory_order_relaxed);
+    }
+    return sum;
+  }
+
+  /**
+   * Delta since the previous collect(); single aggregator thread only.
+   */
+  int64_t collect() {
+    int64_t current = value();
+    int64_t delta = current - lastCollected_;
+    lastCollected_ = current;
+    return delta;
+  }
+
+ private:
+  struct alignas(folly::hardware_destructive_interference_size) Shard {
+    std::atomic<int64_t> value{0};
+  };
+
+  std::atomic<int64_t>& shard() {
+    return shards_[folly::AccessSpreader<>::current(numShards_)].value;
+  }
+
+  Shard* shards_{nullptr};
+  size_t numShards_{0};
+  int64_t lastCollected_{0};
+};
+
+} // namespace proxygen
@@ -12,6 +12,7 @@
 #include <glog/logging.h>
 #include <tuple>
 #include <limits>
+#include <utility>
 
 namespace proxygen {
 
@@ -57,55 +58,51 @@ class StateMachine {
  * storing the index of S2 (the new state) at transitions[S1, e]. An
  * invalid transition is represented by storing a max value instead of
  * S2 index.
+ *
+ * The matrix is built entirely at compile time: declare the transition
+ * list as a constexpr array and initialize a constexpr TransitionTable
+ * from it.  find() is then a single bounds-checked array load from
+ * .rodata, and there is no static initializer to run at startup.
  */
-template <class State, class Event>
-class TransitionTable  {
- private:
-  size_t index(State s, Event e) const {
-    return static_cast<uint64_t>(s) * nEvents_ + static_cast<uint64_t>(e);
-  }
-
-  std::vector<uint8_t> transitions_;
-  const size_t nStates_{0};
-  const size_t nEvents_{0};
-
+template <class State, class Event, size_t NStates, size_t NEvents>
+class TransitionTable {
  public:
-  TransitionTable(
-    size_t nStates, size_t nEvents,
-    std::vector<std::pair<std::pair<State, Event>, State>> transitions)
-    : nStates_(nStates),
-    nEvents_(nEvents) {
-    CHECK_LT(static_cast<uint64_t>(nStates),
-             std::numeric_limits<uint8_t>::max());
-    // Set all transitions to invalid
-    transitions_.resize(nStates * nEvents,
-                        std::numeric_limits<uint8_t>::max());
+  using Transition = std::pair<std::pair<State, Event>, State>;
 
-    for (auto t: transitions) {
-      auto src_state = t.first.first;
-      auto event = t.first.second;
-      auto dst_state_idx = static_cast<uint8_t>(t.second);
-      transitions_[index(src_state, event)] = dst_state_idx;
+  template <size_t NTransitions>
+  explicit constexpr TransitionTable(
+      const Transition (&transitions)[NTransitions])
+      : transitions_{} {
+    static_assert(NStates < std::numeric_limits<uint8_t>::max(),
+                  "state index must fit in uint8_t");
+    for (size_t i = 0; i < NStates * NEvents; i++) {
+      transitions_[i] = kInvalid;
+    }
+    for (size_t i = 0; i < NTransitions; i++) {
+      transitions_[index(transitions[i].first.first,
+                         transitions[i].first.second)] =
+          static_cast<uint8_t>(transitions[i].second);
     }
   }
 
-  TransitionTable() = delete;
-  TransitionTable& operator=(const TransitionTable&) = delete;
-  TransitionTable(const TransitionTable&) = delete;
-  TransitionTable(TransitionTable&& goner)
-    : transitions_(std::move(goner.transitions_)),
-    nStates_(goner.nStates_),
-    nEvents_(goner.nEvents_) {}
-
   std::pair<State, bool> find(State s, Event e) const {
-    CHECK_LT(static_cast<uint64_t>(s), nStates_);
-    CHECK_LT(static_cast<uint64_t>(e), nEvents_);
+    CHECK_LT(static_cast<uint64_t>(s), NStates);
+    CHECK_LT(static_cast<uint64_t>(e), NEvents);
     uint8_t result = transitions_[index(s, e)];
-    if (result == std::numeric_limits<uint8_t>::max()) {
+    if (result == kInvalid) {
       return std::make_pair(s, false);
     }
     return std::make_pair(State(result), true);
   }
+
+ private:
+  static constexpr uint8_t kInvalid = std::numeric_limits<uint8_t>::max();
+
+  static constexpr size_t index(State s, Event e) {
+    return static_cast<size_t>(s) * NEvents + static_cast<size_t>(e);
+  }
+
+  uint8_t transitions_[NStates * NEvents];
 };
 
 }
@@ -0,0 +1,95 @@
+/*
+ *  Copyright (c) 2015-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include <proxygen/lib/utils/StringArena.h>
+
+#include <algorithm>
+
+#include <glog/logging.h>
+
+namespace {
+
+const size_t kAlignment = alignof(std::max_align_t);
+
+size_t alignUp(size_t n) {
+  return (n + kAlignment - 1) & ~(kAlignment - 1);
+}
+
+} // namespace
+
+namespace proxygen {
+
+StringArena::StringArena(size_t blockSize)
+    : blockSize_(alignUp(std::max(blockSize, kAlignment))) {
+}
+
+StringArena::~StringArena() {
+  clear();
+}
+
+void* StringArena::allocate(size_t size) {
+  size = alignUp(size);
+  if (LIKELY(ptr_ + size <= end_)) {
+    char* res = ptr_;
+    ptr_ += size;
+    return res;
+  }
+  return allocateSlow(size);
+}
+
+void* StringArena::allocateSlow(size_t size) {
+  if (size > blockSize_) {
+    // Oversized request: give it a dedicated block and keep bumping out of
+    // the current one.
+    Block block;
+    block.data.reset(new char[size]);
+    block.size = size;
+    bytesAllocated_ += size;
+    char* res = block.data.get();
+    blocks_.emplace_back(std::move(block));
+    return res;
+  }
+  Block block;
+  block.data.reset(new char[blockSize_]);
+  block.size = blockSize_;
+  bytesAllocated_ += blockSize_;
+  ptr_ = block.data.get();
+  end_ = ptr_ + blockSize_;
+  blocks_.emplace_back(std::move(block));
+  char* res = ptr_;
+  ptr_ += size;
+  return res;
+}
+
+const std::string* StringArena::newString(folly::StringPiece sp) {
+  void* storage = allocate(sizeof(std::string));
+  auto s = new (storage) std::string(sp.data(), sp.size());
+  strings_.push_back(s);
+  return s;
+}
+
+void StringArena::clear() {
+  for (auto s : strings_) {
+    s->~basic_string();
+  }
+  strings_.clear();
+  if (!blocks_.empty()) {
+    // Retain the first block so a recycled arena doesn't pay the warm-up
+    // allocation again.
+    blocks_.resize(1);
+    bytesAllocated_ = blocks_[0].size;
+    ptr_ = blocks_[0].data.get();
+    end_ = ptr_ + blocks_[0].size;
+  } else {
+    bytesAllocated_ = 0;
+    ptr_ = end_ = nullptr;
+  }
+}
+
+} // namespace proxygen
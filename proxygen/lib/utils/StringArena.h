@@ -0,0 +1,90 @@
+/*
+ *  Copyright (c) 2015-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#pragma once
+
+#include <folly/Range.h>
+#include <proxygen/lib/utils/Export.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace proxygen {
+
+/**
+ * A simple chunked bump allocator intended for per-request scratch storage,
+ * most notably HTTPHeaders/HTTPMessage header-name strings.  Allocations are
+ * O(1) pointer bumps out of fixed-size blocks; everything is released
+ * wholesale when the arena is cleared or destroyed.  This sidesteps
+ * per-string malloc/free churn on hot request paths where the lifetime of
+ * every small allocation is bounded by the transaction.
+ *
+ * The arena is not thread-safe; the intended usage is one arena per request,
+ * owned by the message (or transaction) and used on its event base thread
+ * only.
+ *
+ * Strings handed out via newString() are placement-constructed in arena
+ * memory and destroyed when the arena is cleared, so any out-of-line buffer
+ * a long string owns is still reclaimed correctly.  Callers must not delete
+ * or outlive the arena with these pointers.
+ */
+class StringArena {
+ public:
+  static const size_t kDefaultBlockSize = 4096;
+
+  FB_EXPORT explicit StringArena(size_t blockSize = kDefaultBlockSize);
+  FB_EXPORT ~StringArena();
+
+  StringArena(const StringArena&) = delete;
+  StringArena& operator=(const StringArena&) = delete;
+
+  /**
+   * Return size bytes of storage, aligned for any fundamental type.  Falls
+   * back to a dedicated block for requests larger than the block size.
+   */
+  void* allocate(size_t size);
+
+  /**
+   * Construct a std::string with the given contents in arena storage.  The
+   * returned pointer remains valid until clear() or destruction.
+   */
+  const std::string* newString(folly::StringPiece sp);
+
+  /**
+   * Release all allocations at once.  The arena can be reused afterwards;
+   * the first block is retained to avoid re-warming.
+   */
+  void clear();
+
+  /**
+   * Total bytes of block storage currently held, for accounting.
+   */
+  size_t bytesAllocated() const {
+    return bytesAllocated_;
+  }
+
+ private:
+  void* allocateSlow(size_t size);
+
+  struct Block {
+    std::unique_ptr<char[]> data;
+    size_t size{0};
+  };
+
+  const size_t blockSize_;
+  std::vector<Block> blocks_;
+  // Strings constructed via newString(); destroyed on clear()
+  std::vector<std::string*> strings_;
+  char* ptr_{nullptr};
+  char* end_{nullptr};
+  size_t bytesAllocated_{0};
+};
+
+} // namespace proxygen
@@ -0,0 +1,99 @@
+/*
+ *  Copyright (c) 2015-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include <proxygen/lib/utils/StructuredLog.h>
+
+#include <algorithm>
+#include <folly/Conv.h>
+
+namespace proxygen {
+
+constexpr uint64_t StructuredLog::kRingSize;
+
+std::atomic<uint32_t> StructuredLog::sampleEvery_{1};
+
+void StructuredLog::Ring::push(const Record& record) {
+  auto h = head.load(std::memory_order_relaxed);
+  records[h & (kRingSize - 1)] = record;
+  head.store(h + 1, std::memory_order_release);
+}
+
+folly::ThreadLocal<StructuredLog::Ring, StructuredLog::RingTag>&
+StructuredLog::getRing() {
+  static folly::ThreadLocal<Ring, RingTag> ring;
+  return ring;
+}
+
+void StructuredLog::log(Site site, uint64_t id, uint64_t value) noexcept {
+  auto every = sampleEvery_.load(std::memory_order_relaxed);
+  auto& ring = *getRing();
+  if (every > 1 && ++ring.sampleCounter % every != 0) {
+    return;
+  }
+  ring.push(Record{id, value, getCurrentTime(), site});
+}
+
+void StructuredLog::setSampleEvery(uint32_t n) {
+  sampleEvery_.store(std::max(n, 1u), std::memory_order_relaxed);
+}
+
+const char* StructuredLog::getSiteName(Site site) {
+  switch (site) {
+    case Site::CODEC_ERROR:
+      return "codec_error";
+    case Site::CODEC_DISCARD_HEADERS:
+      return "codec_discard_headers";
+    case Site::CODEC_DISCARD_BODY:
+      return "codec_discard_body";
+    case Site::CODEC_DISCARD_TRAILERS:
+      return "codec_discard_trailers";
+    case Site::NUM_SITES:
+      break;
+  }
+  return "unknown";
+}
+
+std::string StructuredLog::format(const Record& record) {
+  return folly::to<std::string>(
+      getSiteName(record.site),
+      " id=",
+      record.id,
+      " value=",
+      record.value,
+      " t=",
+      std::chrono::duration_cast<std::chrono::microseconds>(
+          record.time.time_since_epoch())
+          .count());
+}
+
+std::vector<StructuredLog::Record> StructuredLog::readAllThreads() {
+  std::vector<Record> out;
+  for (const auto& ring : getRing().accessAllThreads()) {
+    auto h = ring.head.load(std::memory_order_acquire);
+    for (auto i = (h > kRingSize) ? h - kRingSize : 0; i < h; i++) {
+      out.push_back(ring.records[i & (kRingSize - 1)]);
+    }
+  }
+  return out;
+}
+
+std::vector<StructuredLog::Record> StructuredLog::drainCurrentThread() {
+  std::vector<Record> out;
+  auto& ring = *getRing();
+  auto h = ring.head.load(std::memory_order_relaxed);
+  auto start =
+      std::max(ring.tail, (h > kRingSize) ? h - kRingSize : uint64_t(0));
+  for (auto i = start; i < h; i++) {
+    out.push_back(ring.records[i & (kRingSize - 1)]);
+  }
+  ring.tail = h;
+  return out;
+}
+
+} // namespace proxygen
@@ -0,0 +1,122 @@
+/*
+ *  Copyright (c) 2015-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <folly/ThreadLocal.h>
+#include <proxygen/lib/utils/Time.h>
+
+namespace proxygen {
+
+/**
+ * Deferred structured logging, a sibling of CycleProbe.
+ *
+ * A VLOG site on a hot path pays for ostream formatting on the request
+ * thread even when the message is ultimately discarded.  StructuredLog
+ * instead records a fixed-size binary entry -- site, connection or
+ * stream id, a small site-specific value, and a timestamp -- into a
+ * per-thread ring with no locks or allocation.  Text formatting happens
+ * only when an inspection thread drains the rings, and the sampling
+ * knob drops records before they ever reach the ring, so the cost of a
+ * suppressed record is one branch.
+ *
+ * Like CycleProbe, readAllThreads() is best effort: a writer that laps
+ * the reader mid-scan can tear the oldest records.
+ */
+class StructuredLog {
+ public:
+  /**
+   * Compile-time log site registry.  Add new sites before NUM_SITES and
+   * give them a name in getSiteName().
+   */
+  enum class Site : uint8_t {
+    CODEC_ERROR = 0,       // CodecErrorResponseHandler::onError
+    CODEC_DISCARD_HEADERS, // ingress dropped while erroring out
+    CODEC_DISCARD_BODY,
+    CODEC_DISCARD_TRAILERS,
+    NUM_SITES, // must be last
+  };
+
+  struct Record {
+    uint64_t id;    // connection or stream id
+    uint64_t value; // site-specific payload (error code, byte count)
+    TimePoint time;
+    Site site;
+  };
+
+  /**
+   * Record one entry on the calling thread's ring, subject to the
+   * sampling knob.
+   */
+  static void log(Site site, uint64_t id, uint64_t value) noexcept;
+
+  static const char* getSiteName(Site site);
+
+  /**
+   * Render a drained record as text; this is the only part of the
+   * pipeline that builds strings, so call it off the request threads.
+   */
+  static std::string format(const Record& record);
+
+  /**
+   * Keep one record in every `n`; 1 (the default) keeps everything.
+   * Applied at log() time so a long sample interval also stretches the
+   * window of history the ring covers.
+   */
+  static void setSampleEvery(uint32_t n);
+
+  /**
+   * Copy out the most recent records from every thread's ring, oldest
+   * first within each thread.  Does not consume records.
+   */
+  static std::vector<Record> readAllThreads();
+
+  /**
+   * Consume the records this thread has written since the last drain.
+   */
+  static std::vector<Record> drainCurrentThread();
+
+ private:
+  // Power of two so indexing is a mask
+  static constexpr uint64_t kRingSize = 4096;
+
+  struct Ring {
+    std::array<Record, kRingSize> records;
+    std::atomic<uint64_t> head{0};
+    uint64_t tail{0};          // only touched by drainCurrentThread()
+    uint64_t sampleCounter{0}; // only touched by log()
+
+    void push(const Record& record);
+  };
+
+  class RingTag;
+  static folly::ThreadLocal<Ring, RingTag>& getRing();
+
+  static std::atomic<uint32_t> sampleEvery_;
+};
+
+/**
+ * Records a structured log entry.  Compiles away entirely with
+ * -DPROXYGEN_DISABLE_STRUCTURED_LOG.
+ */
+#ifndef PROXYGEN_DISABLE_STRUCTURED_LOG
+#define PROXYGEN_SLOG(site, id, value)    \
+  ::proxygen::StructuredLog::log(         \
+      ::proxygen::StructuredLog::Site::site, (id), (value))
+#else
+#define PROXYGEN_SLOG(site, id, value)
+#endif
+
+} // namespace proxygen
@@ -0,0 +1,145 @@
+/*
+ *  Copyright (c) 2015-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include <proxygen/lib/utils/URLScan.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+int8_t hexValue(uint8_t c) {
+  if (c >= '0' && c <= '9') {
+    return c - '0';
+  }
+  if (c >= 'a' && c <= 'f') {
+    return c - 'a' + 10;
+  }
+  if (c >= 'A' && c <= 'F') {
+    return c - 'A' + 10;
+  }
+  return -1;
+}
+
+// First byte in [p, end) that is '%' or '+', or end if there is none
+const char* findEscape(const char* p, const char* end) {
+#if defined(__SSE2__)
+  while (end - p >= 16) {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    __m128i pct = _mm_cmpeq_epi8(v, _mm_set1_epi8('%'));
+    __m128i plus = _mm_cmpeq_epi8(v, _mm_set1_epi8('+'));
+    int mask = _mm_movemask_epi8(_mm_or_si128(pct, plus));
+    if (mask != 0) {
+      return p + __builtin_ctz(static_cast<unsigned>(mask));
+    }
+    p += 16;
+  }
+#endif
+  while (p != end && *p != '%' && *p != '+') {
+    p++;
+  }
+  return p;
+}
+
+}
+
+namespace proxygen {
+
+URLScanResult scanURL(folly::ByteRange url) {
+  URLScanResult result;
+  const uint8_t* begin = url.begin();
+  const uint8_t* p = begin;
+  const uint8_t* end = url.end();
+#if defined(__SSE2__)
+  while (end - p >= 16) {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    // bytes <= 0x20 (unsigned): min(v, 0x20) == v
+    __m128i ctl = _mm_cmpeq_epi8(_mm_min_epu8(v, _mm_set1_epi8(0x20)), v);
+    __m128i del = _mm_cmpeq_epi8(v, _mm_set1_epi8(0x7f));
+    if (_mm_movemask_epi8(_mm_or_si128(ctl, del)) != 0) {
+      result.valid = false;
+      return result;
+    }
+    int slash = _mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8('/')));
+    int query = _mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8('?')));
+    int hash = _mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8('#')));
+    size_t base = p - begin;
+    if (slash != 0 && result.pathStart == std::string::npos) {
+      result.pathStart = base + __builtin_ctz(static_cast<unsigned>(slash));
+    }
+    if (query != 0 && result.queryStart == std::string::npos) {
+      result.queryStart = base + __builtin_ctz(static_cast<unsigned>(query));
+    }
+    if (hash != 0 && result.hashStart == std::string::npos) {
+      result.hashStart = base + __builtin_ctz(static_cast<unsigned>(hash));
+    }
+    p += 16;
+  }
+#endif
+  for (; p != end; p++) {
+    uint8_t c = *p;
+    if (c <= 0x20 || c == 0x7f) {
+      // no controls or unescaped spaces
+      result.valid = false;
+      return result;
+    }
+    size_t off = p - begin;
+    if (c == '/' && result.pathStart == std::string::npos) {
+      result.pathStart = off;
+    } else if (c == '?' && result.queryStart == std::string::npos) {
+      result.queryStart = off;
+    } else if (c == '#' && result.hashStart == std::string::npos) {
+      result.hashStart = off;
+    }
+  }
+  return result;
+}
+
+bool urlUnescapeQuery(std::string& out, folly::StringPiece input) {
+  out.clear();
+  const char* p = input.begin();
+  const char* end = input.end();
+  const char* escape = findEscape(p, end);
+  if (escape == end) {
+    // no escapes at all; almost all query params take this path
+    out.assign(p, end);
+    return true;
+  }
+  out.reserve(input.size());
+  out.append(p, escape);
+  p = escape;
+  while (p != end) {
+    char c = *p;
+    if (c == '+') {
+      out += ' ';
+      p++;
+    } else if (c == '%') {
+      if (end - p < 3) {
+        out.clear();
+        return false;
+      }
+      int8_t hi = hexValue(p[1]);
+      int8_t lo = hexValue(p[2]);
+      if (hi < 0 || lo < 0) {
+        out.clear();
+        return false;
+      }
+      out += static_cast<char>((hi << 4) | lo);
+      p += 3;
+    } else {
+      const char* next = findEscape(p, end);
+      out.append(p, next);
+      p = next;
+    }
+  }
+  return true;
+}
+
+}
@@ -0,0 +1,45 @@
+/*
+ *  Copyright (c) 2015-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#pragma once
+
+#include <folly/Range.h>
+#include <string>
+
+namespace proxygen {
+
+/**
+ * Result of a single pass over a URL: the offset of the first '/', '?'
+ * and '#' (std::string::npos if absent), plus whether every byte passed
+ * the validateURL predicate (no control characters, unescaped spaces or
+ * DEL).
+ */
+struct URLScanResult {
+  size_t pathStart{std::string::npos};
+  size_t queryStart{std::string::npos};
+  size_t hashStart{std::string::npos};
+  bool valid{true};
+};
+
+/**
+ * Scan a URL once, 16 bytes at a time where the platform allows,
+ * classifying delimiters and invalid bytes together.  Equivalent to
+ * validateURL() plus three find() calls, in one pass.
+ */
+URLScanResult scanURL(folly::ByteRange url);
+
+/**
+ * Percent-decode input with query-string semantics ('+' decodes to space,
+ * "%XX" to the byte it names) into out.  Vector-scans for the first
+ * escape and takes a straight copy when there is none, which is the
+ * common case.  Returns false and clears out on a malformed escape.
+ */
+bool urlUnescapeQuery(std::string& out, folly::StringPiece input);
+
+}
@@ -12,8 +12,35 @@
 
 #include <folly/Singleton.h>
 #include <folly/io/async/EventBase.h>
+#include <folly/io/async/EventBaseLocal.h>
 #include <folly/io/async/EventBaseManager.h>
 
+namespace {
+
+// Tick interval for the coarse wheel.  100ms of slop is invisible on
+// idle/drain timeouts measured in tens of seconds, and the wider tick
+// means far fewer bucket cascades per wheel turn.
+constexpr std::chrono::milliseconds kCoarseTickInterval{100};
+
+// One coarse wheel per EventBase, created on first coarse schedule and
+// destroyed with the EventBase.
+folly::EventBaseLocal<folly::HHWheelTimer::UniquePtr>& coarseWheels() {
+  static folly::EventBaseLocal<folly::HHWheelTimer::UniquePtr> wheels;
+  return wheels;
+}
+
+// Sessions construct WheelTimerInstances on the hot path, so remember
+// the thread's EventBase and wheel to skip the EventBaseManager lookup
+// and the lazy-creation check in EventBase::timer().  Revalidated
+// against the manager in case the thread's EventBase is replaced.
+struct CachedWheel {
+  folly::EventBase* eventBase{nullptr};
+  folly::HHWheelTimer* wheel{nullptr};
+};
+thread_local CachedWheel localWheel;
+
+} // namespace
+
 namespace proxygen {
 
 WheelTimerInstance::WheelTimerInstance() {
@@ -34,17 +61,24 @@ WheelTimerInstance::WheelTimerInstance(
   if (!eventBase) {
     eventBase = folly::EventBaseManager::get()->getEventBase();
   }
-  wheelTimerPtr_ = &eventBase->timer();
+  if (localWheel.eventBase != eventBase) {
+    localWheel.eventBase = eventBase;
+    localWheel.wheel = &eventBase->timer();
+  }
+  eventBase_ = eventBase;
+  wheelTimerPtr_ = localWheel.wheel;
 }
 
 WheelTimerInstance::WheelTimerInstance(const WheelTimerInstance& timerInstance)
   : wheelTimerPtr_(timerInstance.wheelTimerPtr_),
+    eventBase_(timerInstance.eventBase_),
     defaultTimeoutMS_(timerInstance.defaultTimeoutMS_) {
 }
 
 WheelTimerInstance::WheelTimerInstance(
     WheelTimerInstance&& timerInstance) noexcept
   : wheelTimerPtr_(std::move(timerInstance.wheelTimerPtr_)),
+    eventBase_(std::move(timerInstance.eventBase_)),
     defaultTimeoutMS_(std::move(timerInstance.defaultTimeoutMS_)) {
 }
 
@@ -72,8 +106,39 @@ void WheelTimerInstance::scheduleTimeout(
   scheduleTimeout(callback, defaultTimeoutMS_);
 }
 
+void WheelTimerInstance::scheduleCoarseTimeout(
+    folly::HHWheelTimer::Callback* callback,
+    std::chrono::milliseconds timeout) {
+  if (!wheelTimerPtr_) {
+    VLOG(2) << "Ignoring scheduleCoarseTimeout on an empty WheelTimerInstance";
+    return;
+  }
+  if (!eventBase_) {
+    // Wrapping a bare wheel; nowhere to hang a coarse wheel off, so this
+    // timeout gets fine-grained service.
+    wheelTimerPtr_->scheduleTimeout(callback, timeout);
+    return;
+  }
+  auto& coarseWheel = coarseWheels().getOrCreateFn(
+      *eventBase_, [evb = eventBase_] {
+        return folly::HHWheelTimer::newTimer(evb, kCoarseTickInterval);
+      });
+  // Round up to a whole tick so the timeout never fires early.
+  const auto ticks =
+      (timeout + kCoarseTickInterval - std::chrono::milliseconds(1)) /
+      kCoarseTickInterval;
+  coarseWheel->scheduleTimeout(callback, ticks * kCoarseTickInterval);
+}
+
+void WheelTimerInstance::scheduleCoarseTimeout(
+    folly::HHWheelTimer::Callback* callback) {
+  CHECK_GE(defaultTimeoutMS_.count(), 0);
+  scheduleCoarseTimeout(callback, defaultTimeoutMS_);
+}
+
 WheelTimerInstance& WheelTimerInstance::operator=(const WheelTimerInstance& t) {
   wheelTimerPtr_ = t.wheelTimerPtr_;
+  eventBase_ = t.eventBase_;
   defaultTimeoutMS_ = t.defaultTimeoutMS_;
   return *this;
 }
@@ -81,6 +146,7 @@ WheelTimerInstance& WheelTimerInstance::operator=(const WheelTimerInstance& t) {
 WheelTimerInstance& WheelTimerInstance::
     operator=(const WheelTimerInstance&& timer) {
   wheelTimerPtr_ = std::move(timer.wheelTimerPtr_);
+  eventBase_ = std::move(timer.eventBase_);
   defaultTimeoutMS_ = std::move(timer.defaultTimeoutMS_);
   return *this;
 }
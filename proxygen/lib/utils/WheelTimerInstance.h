@@ -25,6 +25,13 @@ namespace proxygen {
 
 /*
  * Class to be used to schedule timeouts, has associated HHWheelTimer & timeout
+ *
+ * Timeouts come in two precision classes.  RPC deadlines and transaction
+ * timeouts go on the EventBase's fine-grained wheel via scheduleTimeout().
+ * Idle and drain style timeouts only need to be approximately right, so
+ * scheduleCoarseTimeout() parks them on a dedicated per-EventBase wheel
+ * with a 100ms tick; that keeps thousands of long idle timeouts from
+ * churning through the fine wheel's buckets as it cascades.
  */
 class WheelTimerInstance {
  public:
@@ -52,6 +59,14 @@ class WheelTimerInstance {
                        std::chrono::milliseconds timeout);
   void scheduleTimeout(folly::HHWheelTimer::Callback* callback);
 
+  // Schedule on the per-EventBase coarse wheel instead; the timeout is
+  // rounded up to the next 100ms tick so it never fires early.  Falls
+  // back to the fine wheel when this instance wraps a bare HHWheelTimer
+  // with no known EventBase.
+  void scheduleCoarseTimeout(folly::HHWheelTimer::Callback* callback,
+                             std::chrono::milliseconds timeout);
+  void scheduleCoarseTimeout(folly::HHWheelTimer::Callback* callback);
+
   WheelTimerInstance& operator=(const WheelTimerInstance& timer);
   WheelTimerInstance& operator=(const WheelTimerInstance&& timer);
 
@@ -68,6 +83,9 @@ class WheelTimerInstance {
   // external WheelTimer is
   // specified
 
+  folly::EventBase* eventBase_{nullptr};  // nullptr when constructed from a
+  // bare HHWheelTimer; needed to find the coarse wheel
+
   std::chrono::milliseconds defaultTimeoutMS_;
 };
 
@@ -0,0 +1,67 @@
+/*
+ *  Copyright (c) 2015-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include <proxygen/lib/utils/WorkerBufferPool.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <folly/ThreadLocal.h>
+#include <glog/logging.h>
+
+namespace {
+// Free blocks retained per pool; excess shrinks back to the allocator
+constexpr size_t kMaxPooledBlocks = 256;
+
+folly::ThreadLocal<proxygen::WorkerBufferPool> workerBufferPool;
+} // namespace
+
+namespace proxygen {
+
+WorkerBufferPool* WorkerBufferPool::get() {
+  return workerBufferPool.get();
+}
+
+WorkerBufferPool::~WorkerBufferPool() {
+  DCHECK_EQ(outstanding_, 0) << "blocks outlived their worker's pool";
+  for (auto block : blocks_) {
+    free(block);
+  }
+}
+
+std::unique_ptr<folly::IOBuf> WorkerBufferPool::allocate() {
+  void* block = nullptr;
+  {
+    std::lock_guard<std::mutex> g(lock_);
+    if (!blocks_.empty()) {
+      block = blocks_.back();
+      blocks_.pop_back();
+    }
+    outstanding_++;
+    highWatermark_ = std::max(highWatermark_, outstanding_);
+  }
+  if (!block) {
+    block = malloc(kBlockSize);
+  }
+  return folly::IOBuf::takeOwnership(
+      block, kBlockSize, 0 /* length */, recycleBlock, this);
+}
+
+void WorkerBufferPool::recycleBlock(void* buf, void* userData) {
+  auto pool = static_cast<WorkerBufferPool*>(userData);
+  std::lock_guard<std::mutex> g(pool->lock_);
+  DCHECK_GT(pool->outstanding_, 0);
+  pool->outstanding_--;
+  if (pool->blocks_.size() < kMaxPooledBlocks) {
+    pool->blocks_.push_back(buf);
+  } else {
+    free(buf);
+  }
+}
+
+} // namespace proxygen
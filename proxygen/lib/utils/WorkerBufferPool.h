@@ -0,0 +1,65 @@
+/*
+ *  Copyright (c) 2015-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#pragma once
+
+#include <folly/io/IOBuf.h>
+#include <mutex>
+#include <vector>
+
+namespace proxygen {
+
+/**
+ * Pool of fixed-size buffer blocks shared by all sessions on a worker
+ * thread.  Blocks hand out as IOBufs whose free function returns the
+ * storage to the pool, so steady-state transport reads stop hitting the
+ * allocator.  The high watermark of simultaneously outstanding blocks is
+ * tracked for memory accounting.
+ *
+ * Blocks normally live and die on the owning worker's event base; the
+ * recycle path takes the pool lock so a block that strayed to another
+ * thread is still returned safely, but the pool itself must outlive all
+ * of its blocks.
+ */
+class WorkerBufferPool {
+ public:
+  static const size_t kBlockSize = 16 * 1024;
+
+  // Pool for the calling worker thread
+  static WorkerBufferPool* get();
+
+  ~WorkerBufferPool();
+
+  std::unique_ptr<folly::IOBuf> allocate();
+
+  uint64_t getOutstandingBlocks() const {
+    std::lock_guard<std::mutex> g(lock_);
+    return outstanding_;
+  }
+
+  uint64_t getPooledBlocks() const {
+    std::lock_guard<std::mutex> g(lock_);
+    return blocks_.size();
+  }
+
+  uint64_t getHighWatermark() const {
+    std::lock_guard<std::mutex> g(lock_);
+    return highWatermark_;
+  }
+
+ private:
+  static void recycleBlock(void* buf, void* userData);
+
+  mutable std::mutex lock_;
+  std::vector<void*> blocks_;
+  uint64_t outstanding_{0};
+  uint64_t highWatermark_{0};
+};
+
+} // namespace proxygen
@@ -9,8 +9,13 @@
  */
 #include "proxygen/lib/utils/ZlibStreamCompressor.h"
 
+#include <cstring>
+#include <folly/ThreadLocal.h>
 #include <folly/lang/Bits.h>
 #include <folly/io/Cursor.h>
+#include <map>
+#include <utility>
+#include <vector>
 
 using folly::IOBuf;
 
@@ -44,6 +49,74 @@ int deflateHelper(z_stream* stream, IOBuf* out, int flush) {
 
   return deflate(stream, flush);
 }
+
+/**
+ * Per-thread pool of initialized deflate states, keyed by (type, level).
+ * deflateInit2 allocates a window and hash chains of several hundred KB per
+ * stream; reusing a pooled state via deflateReset skips all of that on the
+ * next response from this worker.
+ */
+constexpr size_t kMaxPooledStates = 4;
+
+struct ZlibStatePool {
+  std::map<std::pair<CompressionType, int>,
+           std::vector<std::unique_ptr<z_stream>>> states;
+
+  ~ZlibStatePool() {
+    for (auto& kv : states) {
+      for (auto& state : kv.second) {
+        deflateEnd(state.get());
+      }
+    }
+  }
+};
+
+folly::ThreadLocal<ZlibStatePool> zlibStatePool;
+
+std::unique_ptr<z_stream> acquireState(CompressionType type,
+                                       int level,
+                                       int* status) {
+  auto& pool = zlibStatePool->states[std::make_pair(type, level)];
+  if (!pool.empty()) {
+    auto state = std::move(pool.back());
+    pool.pop_back();
+    *status = deflateReset(state.get());
+    return state;
+  }
+
+  auto state = std::make_unique<z_stream>();
+  memset(state.get(), 0, sizeof(z_stream));
+  switch (type) {
+    case CompressionType::GZIP:
+      *status = deflateInit2(state.get(),
+                             level,
+                             Z_DEFLATED,
+                             GZIP_WINDOW_BITS,
+                             MAX_MEM_LEVEL,
+                             Z_DEFAULT_STRATEGY);
+      break;
+    case CompressionType::DEFLATE:
+      *status = deflateInit(state.get(), level);
+      break;
+    default:
+      DCHECK(false) << "Unsupported zlib compression type.";
+      *status = Z_STREAM_ERROR;
+      break;
+  }
+  return state;
+}
+
+void releaseState(std::unique_ptr<z_stream> state,
+                  CompressionType type,
+                  int level,
+                  bool healthy) {
+  auto& pool = zlibStatePool->states[std::make_pair(type, level)];
+  if (healthy && pool.size() < kMaxPooledStates) {
+    pool.push_back(std::move(state));
+  } else {
+    deflateEnd(state.get());
+  }
+}
 }
 
 void ZlibStreamCompressor::init(CompressionType type, int32_t level) {
@@ -55,51 +128,43 @@ void ZlibStreamCompressor::init(CompressionType type, int32_t level) {
   level_ = level;
   status_ = Z_OK;
 
-  zlibStream_.zalloc = Z_NULL;
-  zlibStream_.zfree = Z_NULL;
-  zlibStream_.opaque = Z_NULL;
-  zlibStream_.total_in = 0;
-  zlibStream_.next_in = Z_NULL;
-  zlibStream_.avail_in = 0;
-  zlibStream_.avail_out = 0;
-  zlibStream_.next_out = Z_NULL;
-
   DCHECK(level_ == Z_DEFAULT_COMPRESSION ||
          (level_ >= Z_NO_COMPRESSION && level_ <= Z_BEST_COMPRESSION))
       << "Invalid Zlib compression level. level=" << level_;
 
-  switch (type_) {
-    case CompressionType::GZIP: {
-      auto windowBits = type_ == CompressionType::GZIP ? GZIP_WINDOW_BITS
-                                                       : DEFLATE_WINDOW_BITS;
-      status_ = deflateInit2(&zlibStream_,
-                             level_,
-                             Z_DEFLATED,
-                             windowBits,
-                             MAX_MEM_LEVEL,
-                             Z_DEFAULT_STRATEGY);
-    } break;
-    case CompressionType::DEFLATE:
-      status_ = deflateInit(&zlibStream_, level);
-      break;
-    default:
-      DCHECK(false) << "Unsupported zlib compression type.";
-      break;
-  }
+  zlibStream_ = acquireState(type_, level_, &status_);
+  zlibStream_->next_in = Z_NULL;
+  zlibStream_->avail_in = 0;
+  zlibStream_->next_out = Z_NULL;
+  zlibStream_->avail_out = 0;
 
   if (status_ != Z_OK) {
     LOG(ERROR) << "error initializing zlib stream. r=" << status_;
   }
 }
 
+void ZlibStreamCompressor::setDictionary(const uint8_t* dict, size_t size) {
+  DCHECK(type_ == CompressionType::DEFLATE)
+      << "Preset dictionaries require a zlib-wrapped stream";
+  DCHECK_EQ(zlibStream_->total_in, 0)
+      << "Dictionary must be set before the first compress() call";
+  status_ = deflateSetDictionary(zlibStream_.get(), dict, size);
+  if (status_ != Z_OK) {
+    LOG(ERROR) << "error setting zlib dictionary. r=" << status_;
+  }
+}
+
 ZlibStreamCompressor::ZlibStreamCompressor(CompressionType type, int level)
     : status_(Z_OK) {
   init(type, level);
 }
 
 ZlibStreamCompressor::~ZlibStreamCompressor() {
-  if (type_ != CompressionType::NONE) {
-    status_ = deflateEnd(&zlibStream_);
+  if (zlibStream_) {
+    // A stream that ended cleanly (or was never written to) can be reset and
+    // reused; anything mid-stream or errored is torn down
+    bool healthy = status_ == Z_OK || status_ == Z_STREAM_END;
+    releaseState(std::move(zlibStream_), type_, level_, healthy);
   }
 }
 
@@ -108,24 +173,36 @@ ZlibStreamCompressor::~ZlibStreamCompressor() {
 // true on the final compression call.
 std::unique_ptr<IOBuf> ZlibStreamCompressor::compress(const IOBuf* in,
                                                       bool trailer) {
-  auto bufferLength = FLAGS_zlib_compressor_buffer_growth;
+  uint64_t bufferLength = FLAGS_zlib_compressor_buffer_growth;
+  if (trailer) {
+    // One-shot compressions (the common non-chunked response) can be sized
+    // up front from deflateBound, so the whole output lands in a single
+    // IOBuf handed to the transport instead of a chain of growth-sized ones.
+    // Cap it so a huge body still streams through chained buffers.
+    constexpr uint64_t kMaxUpfrontBufferLength = 1u << 20;
+    bufferLength = std::max<uint64_t>(
+        bufferLength,
+        std::min<uint64_t>(
+            deflateBound(zlibStream_.get(), in->computeChainDataLength()),
+            kMaxUpfrontBufferLength));
+  }
 
-  auto out = addOutputBuffer(&zlibStream_, bufferLength);
+  auto out = addOutputBuffer(zlibStream_.get(), bufferLength);
 
   for (auto& range : *in) {
     uint64_t remaining = range.size();
     uint64_t written = 0;
     while (remaining) {
       uint32_t step = remaining;
-      zlibStream_.next_in = const_cast<uint8_t*>(range.data() + written);
-      zlibStream_.avail_in = step;
+      zlibStream_->next_in = const_cast<uint8_t*>(range.data() + written);
+      zlibStream_->avail_in = step;
       remaining -= step;
       written += step;
 
-      while (zlibStream_.avail_in != 0) {
-        status_ = deflateHelper(&zlibStream_, out.get(), Z_NO_FLUSH);
+      while (zlibStream_->avail_in != 0) {
+        status_ = deflateHelper(zlibStream_.get(), out.get(), Z_NO_FLUSH);
         if (status_ != Z_OK) {
-          DLOG(FATAL) << "Deflate failed: " << zlibStream_.msg;
+          DLOG(FATAL) << "Deflate failed: " << zlibStream_->msg;
           return nullptr;
         }
       }
@@ -134,28 +211,39 @@ std::unique_ptr<IOBuf> ZlibStreamCompressor::compress(const IOBuf* in,
 
   if (trailer) {
     do {
-      status_ = deflateHelper(&zlibStream_, out.get(), Z_FINISH);
+      status_ = deflateHelper(zlibStream_.get(), out.get(), Z_FINISH);
     } while (status_ == Z_OK);
 
     if (status_ != Z_STREAM_END) {
-      DLOG(FATAL) << "Deflate failed: " << zlibStream_.msg;
+      DLOG(FATAL) << "Deflate failed: " << zlibStream_->msg;
       return nullptr;
     }
   } else {
     do {
-      status_ = deflateHelper(&zlibStream_, out.get(), Z_SYNC_FLUSH);
-    } while (zlibStream_.avail_out == 0);
+      status_ = deflateHelper(zlibStream_.get(), out.get(), Z_SYNC_FLUSH);
+    } while (zlibStream_->avail_out == 0);
 
     if (status_ != Z_OK) {
-      DLOG(FATAL) << "Deflate failed: " << zlibStream_.msg;
+      DLOG(FATAL) << "Deflate failed: " << zlibStream_->msg;
       return nullptr;
     }
   }
 
-  out->prev()->trimEnd(zlibStream_.avail_out);
+  out->prev()->trimEnd(zlibStream_->avail_out);
 
-  zlibStream_.next_out = Z_NULL;
-  zlibStream_.avail_out = 0;
+  zlibStream_->next_out = Z_NULL;
+  zlibStream_->avail_out = 0;
+
+  // Exact-fit repack.  A one-shot output sized from deflateBound holds on
+  // to the whole bound even when the body compressed well, and the buffer
+  // can sit in write queues for a while.  When most of a single upfront
+  // buffer is slack, hand back an exact-fit copy instead: the copy cost is
+  // proportional to the (small) output, the reclaimed slack to the bound.
+  constexpr uint64_t kRepackSlackThreshold = 4096;
+  if (trailer && !out->isChained() && out->tailroom() > out->length() &&
+      out->tailroom() >= kRepackSlackThreshold) {
+    out = IOBuf::copyBuffer(out->data(), out->length());
+  }
 
   return out;
 }
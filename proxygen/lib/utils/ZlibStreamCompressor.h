@@ -31,6 +31,15 @@ class ZlibStreamCompressor : public StreamCompressor {
 
   void init(CompressionType type, int level);
 
+  /**
+   * Prime the deflate window with a preset dictionary, e.g. the JSON keys
+   * common to an API tier's responses, shared out of band with the
+   * decompressor.  Only valid for CompressionType::DEFLATE - the gzip
+   * wrapper has no way to signal a dictionary id (RFC 1952).  Must be
+   * called before the first compress().
+   */
+  void setDictionary(const uint8_t* dict, size_t size);
+
   std::unique_ptr<folly::IOBuf> compress(const folly::IOBuf* in,
                                          bool trailer = true) override;
 
@@ -45,7 +54,11 @@ class ZlibStreamCompressor : public StreamCompressor {
  private:
   CompressionType type_{CompressionType::NONE};
   int level_{Z_DEFAULT_COMPRESSION};
-  z_stream zlibStream_;
+  // Heap-allocated because pooled deflate states hold internal pointers back
+  // to their z_stream.  Healthy states are returned to a per-thread pool on
+  // destruction and reused via deflateReset, skipping the expensive
+  // deflateInit2 window/state allocation on the next response.
+  std::unique_ptr<z_stream> zlibStream_;
   int status_{-1};
 };
 }
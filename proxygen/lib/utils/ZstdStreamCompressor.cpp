@@ -0,0 +1,157 @@
+/*
+ *  Copyright (c) 2015-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+
+#include "ZstdStreamCompressor.h"
+
+#include <folly/ThreadLocal.h>
+#include <folly/io/Cursor.h>
+#include <folly/io/IOBuf.h>
+#include <vector>
+
+namespace proxygen {
+
+namespace {
+
+constexpr int kDefaultZstdLevel = 3;
+constexpr size_t kMaxPooledCStreams = 4;
+
+/**
+ * Per-thread pool of compression streams.  ZSTD_createCStream allocates the
+ * full compression workspace; pooled streams keep it and are re-initialized
+ * in place per response.
+ */
+struct CStreamPool {
+  std::vector<ZSTD_CStream*> streams;
+
+  ~CStreamPool() {
+    for (auto zcs : streams) {
+      ZSTD_freeCStream(zcs);
+    }
+  }
+};
+
+folly::ThreadLocal<CStreamPool> cstreamPool;
+
+ZSTD_CStream* acquireCStream() {
+  auto& pool = cstreamPool->streams;
+  if (!pool.empty()) {
+    auto zcs = pool.back();
+    pool.pop_back();
+    return zcs;
+  }
+  return ZSTD_createCStream();
+}
+
+void releaseCStream(ZSTD_CStream* zcs) {
+  auto& pool = cstreamPool->streams;
+  if (pool.size() < kMaxPooledCStreams) {
+    pool.push_back(zcs);
+  } else {
+    ZSTD_freeCStream(zcs);
+  }
+}
+} // namespace
+
+int ZstdStreamCompressor::selectLevel(uint64_t uncompressedLength) {
+  if (uncompressedLength <= 16 * 1024) {
+    return 8;
+  }
+  if (uncompressedLength >= 4 * 1024 * 1024) {
+    return 1;
+  }
+  return kDefaultZstdLevel;
+}
+
+ZstdStreamCompressor::ZstdStreamCompressor(folly::Optional<int> level)
+    : level_(level) {
+}
+
+ZstdStreamCompressor::~ZstdStreamCompressor() {
+  if (zcs_) {
+    // ZSTD_initCStream fully re-initializes a stream, so even one dropped
+    // mid-response is safe to reuse
+    if (error_) {
+      ZSTD_freeCStream(zcs_);
+    } else {
+      releaseCStream(zcs_);
+    }
+  }
+}
+
+std::unique_ptr<folly::IOBuf> ZstdStreamCompressor::compress(
+    const folly::IOBuf* in, bool trailer) {
+  if (hasError()) {
+    return nullptr;
+  }
+
+  if (!zcs_) {
+    zcs_ = acquireCStream();
+    if (!zcs_) {
+      error_ = true;
+      return nullptr;
+    }
+    // A one-shot compression sees the whole response here; streamed bodies
+    // have no size to go on, so they take the default level
+    auto level = level_ ? *level_
+                        : (trailer ? selectLevel(in->computeChainDataLength())
+                                   : kDefaultZstdLevel);
+    auto rc = ZSTD_initCStream(zcs_, level);
+    if (ZSTD_isError(rc)) {
+      error_ = true;
+      return nullptr;
+    }
+  }
+
+  const size_t outBufAllocSize = ZSTD_CStreamOutSize();
+
+  auto out = folly::IOBuf::create(outBufAllocSize);
+  auto appender = folly::io::Appender(out.get(), outBufAllocSize);
+
+  for (const folly::ByteRange range : *in) {
+    if (range.data() == nullptr) {
+      continue;
+    }
+
+    ZSTD_inBuffer ibuf = {range.data(), range.size(), 0};
+    while (ibuf.pos < ibuf.size) {
+      appender.ensure(outBufAllocSize);
+      DCHECK_GT(appender.length(), 0);
+
+      ZSTD_outBuffer obuf = {appender.writableData(), appender.length(), 0};
+      auto ret = ZSTD_compressStream(zcs_, &obuf, &ibuf);
+      if (ZSTD_isError(ret)) {
+        error_ = true;
+        return nullptr;
+      }
+
+      appender.append(obuf.pos);
+    }
+  }
+
+  // Terminate the frame on the trailer, otherwise flush so the chunk is
+  // decodable on its own
+  while (true) {
+    appender.ensure(outBufAllocSize);
+    ZSTD_outBuffer obuf = {appender.writableData(), appender.length(), 0};
+    auto remaining =
+        trailer ? ZSTD_endStream(zcs_, &obuf) : ZSTD_flushStream(zcs_, &obuf);
+    if (ZSTD_isError(remaining)) {
+      error_ = true;
+      return nullptr;
+    }
+    appender.append(obuf.pos);
+    if (remaining == 0) {
+      break;
+    }
+  }
+
+  return out;
+}
+} // namespace proxygen
@@ -0,0 +1,61 @@
+/*
+ *  Copyright (c) 2015-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#pragma once
+
+#include <folly/Optional.h>
+#include <memory>
+#include <proxygen/lib/utils/StreamCompressor.h>
+#include <zstd.h>
+
+namespace folly {
+class IOBuf;
+}
+
+namespace proxygen {
+
+class ZstdStreamCompressor : public StreamCompressor {
+ public:
+  /**
+   * With no explicit level, one is selected from the uncompressed response
+   * size at the first compress() call - see selectLevel.
+   */
+  explicit ZstdStreamCompressor(
+      folly::Optional<int> level = folly::none);
+
+  ~ZstdStreamCompressor() override;
+
+  // May return nullptr on error.
+  std::unique_ptr<folly::IOBuf> compress(const folly::IOBuf* in,
+                                         bool trailer = true) override;
+
+  bool hasError() override {
+    return error_;
+  }
+
+  /**
+   * Pick a compression level from the uncompressed response size: small
+   * responses take a higher level where the extra cycles are negligible,
+   * very large ones drop to the fastest level to cap per-response CPU, and
+   * everything else uses the default, which tracks gzip-6 ratios at a
+   * fraction of the cost.
+   */
+  static int selectLevel(uint64_t uncompressedLength);
+
+ private:
+  /**
+   * Acquired lazily from a per-thread pool at the first compress() call and
+   * returned to it on destruction; ZSTD_initCStream re-initializes a pooled
+   * stream in place, reusing its workspace allocations across responses.
+   */
+  ZSTD_CStream* zcs_{nullptr};
+  folly::Optional<int> level_;
+  bool error_{false};
+};
+} // namespace proxygen
@@ -58,6 +58,30 @@ TEST(Base64, DecodePadding) {
   EXPECT_EQ(Base64::urlDecode("YWFh"), "aaa");
 }
 
+TEST(Base64, EncodeDecodeLong) {
+  // Long enough to exercise the vectorized kernels, with a tail
+  std::string data;
+  for (int i = 0; i < 1000; i++) {
+    data += char(i & 0xff);
+  }
+  for (size_t len = 990; len <= 1000; len++) {
+    auto sub = data.substr(0, len);
+    auto encoded = Base64::encode(range(sub.data(), sub.size()));
+    int padding = (3 - len % 3) % 3;
+    EXPECT_EQ(Base64::decode(encoded, padding), sub);
+    EXPECT_EQ(Base64::urlDecode(Base64::urlEncode(range(sub.data(),
+                                                        sub.size()))),
+              sub);
+  }
+}
+
+TEST(Base64, DecodeGarbageLong) {
+  // Invalid byte in the middle of a full vector block
+  std::string encoded = Base64::encode(range("aaaaaaaaaaaaaaaaaaaaaaaa"));
+  encoded[4] = '!';
+  EXPECT_EQ(Base64::decode(encoded, 0), "");
+}
+
 TEST(Base64, EncodeDecodeHighBits) {
   EXPECT_EQ(Base64::urlDecode("_--_"), std::string("\xff\xef\xbf", 3));
   EXPECT_EQ(Base64::urlEncode(range("\xff\xef\xbf", 3)), "_--_");
@@ -0,0 +1,50 @@
+/*
+ *  Copyright (c) 2015-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include <folly/String.h>
+#include <folly/io/IOBuf.h>
+#include <folly/portability/GTest.h>
+#include <proxygen/lib/utils/BodyDigest.h>
+
+using namespace proxygen;
+using folly::IOBuf;
+
+TEST(BodyDigest, Sha256KnownAnswer) {
+  BodyDigest digest(BodyDigest::Algorithm::SHA256);
+  digest.update(folly::StringPiece("abc"));
+  EXPECT_EQ(digest.getBytesHashed(), 3);
+  EXPECT_EQ(
+      folly::hexlify(digest.finish()),
+      "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad");
+  EXPECT_TRUE(digest.isFinished());
+}
+
+TEST(BodyDigest, Crc32cKnownAnswer) {
+  BodyDigest digest(BodyDigest::Algorithm::CRC32C);
+  digest.update(folly::StringPiece("123456789"));
+  // RFC 3720 check value for "123456789"
+  EXPECT_EQ(folly::hexlify(digest.finish()), "e3069283");
+}
+
+TEST(BodyDigest, ChainMatchesOneShot) {
+  const std::string body = "The quick brown fox jumps over the lazy dog";
+
+  BodyDigest oneShot(BodyDigest::Algorithm::SHA256);
+  oneShot.update(folly::StringPiece(body));
+
+  auto chain = IOBuf::copyBuffer(body.substr(0, 4));
+  chain->prependChain(IOBuf::create(0)); // empty buffers contribute nothing
+  chain->prependChain(IOBuf::copyBuffer(body.substr(4, 20)));
+  chain->prependChain(IOBuf::copyBuffer(body.substr(24)));
+
+  BodyDigest chained(BodyDigest::Algorithm::SHA256);
+  chained.update(*chain);
+  EXPECT_EQ(chained.getBytesHashed(), body.size());
+  EXPECT_EQ(chained.finish(), oneShot.finish());
+}
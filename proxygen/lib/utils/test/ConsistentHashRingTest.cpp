@@ -0,0 +1,116 @@
+/*
+ *  Copyright (c) 2015-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include <folly/Conv.h>
+#include <folly/portability/GTest.h>
+#include <map>
+#include <set>
+#include <vector>
+
+#include <proxygen/lib/utils/ConsistentHashRing.h>
+
+using namespace proxygen;
+
+TEST(ConsistentHashRingTest, Consistency) {
+  ConsistentHashRing ring;
+  std::vector<std::pair<std::string, uint64_t>> nodes;
+  for (int i = 0; i < 10; ++i) {
+    nodes.emplace_back(folly::to<std::string>("key", i), 1);
+  }
+  ring.build(nodes);
+
+  for (size_t rank = 0; rank < 3; rank++) {
+    std::map<uint64_t, size_t> mapping;
+    for (int i = 0; i < 10000; ++i) {
+      mapping[i] = ring.get(i, rank);
+    }
+    for (const auto& entry : mapping) {
+      EXPECT_EQ(entry.second, ring.get(entry.first, rank));
+    }
+  }
+}
+
+TEST(ConsistentHashRingTest, DistinctRanks) {
+  ConsistentHashRing ring;
+  std::vector<std::pair<std::string, uint64_t>> nodes;
+  for (int i = 0; i < 10; ++i) {
+    nodes.emplace_back(folly::to<std::string>("key", i), i % 3 + 1);
+  }
+  ring.build(nodes);
+
+  for (uint64_t key = 0; key < 1000; key++) {
+    std::set<size_t> selected;
+    for (size_t rank = 0; rank < 5; rank++) {
+      selected.insert(ring.get(key, rank));
+    }
+    EXPECT_EQ(selected.size(), 5);
+  }
+}
+
+TEST(ConsistentHashRingTest, DistributionAccuracy) {
+  ConsistentHashRing ring;
+  std::vector<std::pair<std::string, uint64_t>> nodes;
+  uint64_t totalWeight = 0;
+  for (int i = 0; i < 10; ++i) {
+    nodes.emplace_back(folly::to<std::string>("key", i), i % 5 + 1);
+    totalWeight += i % 5 + 1;
+  }
+  ring.build(nodes);
+
+  const int kKeys = 100000;
+  std::map<size_t, int> counts;
+  for (uint64_t i = 0; i < kKeys; ++i) {
+    counts[ring.get(i * 2654435761ULL)]++;
+  }
+
+  for (int i = 0; i < 10; ++i) {
+    double expected = (double)nodes[i].second / totalWeight;
+    double actual = (double)counts[i] / kKeys;
+    double error = std::abs(actual - expected) / expected;
+    EXPECT_LE(error, ring.getMaxErrorRate() * 2);
+  }
+}
+
+TEST(ConsistentHashRingTest, ZeroWeightGetsNoTraffic) {
+  ConsistentHashRing ring;
+  std::vector<std::pair<std::string, uint64_t>> nodes;
+  for (int i = 0; i < 10; ++i) {
+    nodes.emplace_back(folly::to<std::string>("key", i), i < 5 ? 0 : 1);
+  }
+  ring.build(nodes);
+
+  for (uint64_t key = 0; key < 5000; key++) {
+    EXPECT_GE(ring.get(key), 5);
+  }
+}
+
+TEST(ConsistentHashRingTest, MinimalRemappingOnNewNode) {
+  std::vector<std::pair<std::string, uint64_t>> nodes;
+  for (int i = 0; i < 20; ++i) {
+    nodes.emplace_back(folly::to<std::string>("key", i), 2);
+  }
+  ConsistentHashRing before;
+  before.build(nodes);
+
+  nodes.emplace_back("key20", 2);
+  ConsistentHashRing after;
+  after.build(nodes);
+
+  const int kKeys = 20000;
+  int moved = 0;
+  for (uint64_t key = 0; key < kKeys; key++) {
+    if (before.get(key) != after.get(key)) {
+      moved++;
+    }
+  }
+  // the new node owns ~1/21 of the space; remapping should be in that
+  // neighborhood, not a wholesale reshuffle
+  EXPECT_LT(moved, kKeys / 5);
+  EXPECT_GT(moved, 0);
+}
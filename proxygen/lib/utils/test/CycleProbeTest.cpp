@@ -0,0 +1,82 @@
+/*
+ *  Copyright (c) 2015-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include <proxygen/lib/utils/CycleProbe.h>
+
+#include <atomic>
+#include <folly/portability/GTest.h>
+#include <thread>
+
+using namespace proxygen;
+
+TEST(CycleProbeTest, GuardRecordsDelta) {
+  CycleProbe::drainCurrentThread();
+  {
+    PROXYGEN_CYCLE_PROBE(H2_INGRESS);
+  }
+  auto records = CycleProbe::drainCurrentThread();
+  ASSERT_EQ(records.size(), 1);
+  EXPECT_EQ(records[0].site, CycleProbe::Site::H2_INGRESS);
+  EXPECT_GT(records[0].startCycles, 0);
+
+  // A drained record is consumed
+  EXPECT_TRUE(CycleProbe::drainCurrentThread().empty());
+}
+
+TEST(CycleProbeTest, DrainPreservesOrder) {
+  CycleProbe::drainCurrentThread();
+  { PROXYGEN_CYCLE_PROBE(SESSION_READ); }
+  { PROXYGEN_CYCLE_PROBE(HPACK_DECODE); }
+  auto records = CycleProbe::drainCurrentThread();
+  ASSERT_EQ(records.size(), 2);
+  EXPECT_EQ(records[0].site, CycleProbe::Site::SESSION_READ);
+  EXPECT_EQ(records[1].site, CycleProbe::Site::HPACK_DECODE);
+}
+
+TEST(CycleProbeTest, ReadAllThreads) {
+  { PROXYGEN_CYCLE_PROBE(SESSION_READ); }
+  std::atomic<bool> recorded{false};
+  std::atomic<bool> done{false};
+  std::thread probeThread([&] {
+    { PROXYGEN_CYCLE_PROBE(HPACK_DECODE); }
+    recorded = true;
+    // Rings are destroyed on thread exit, so stay alive until the read
+    while (!done) {
+      std::this_thread::yield();
+    }
+  });
+  while (!recorded) {
+    std::this_thread::yield();
+  }
+
+  // readAllThreads() sees every thread's records without consuming them
+  size_t sessionReads = 0;
+  size_t hpackDecodes = 0;
+  for (const auto& record : CycleProbe::readAllThreads()) {
+    if (record.site == CycleProbe::Site::SESSION_READ) {
+      sessionReads++;
+    } else if (record.site == CycleProbe::Site::HPACK_DECODE) {
+      hpackDecodes++;
+    }
+  }
+  done = true;
+  probeThread.join();
+  EXPECT_GE(sessionReads, 1);
+  EXPECT_GE(hpackDecodes, 1);
+  EXPECT_FALSE(CycleProbe::drainCurrentThread().empty());
+}
+
+TEST(CycleProbeTest, SiteNames) {
+  EXPECT_STREQ(CycleProbe::getSiteName(CycleProbe::Site::SESSION_READ),
+               "session_read");
+  EXPECT_STREQ(CycleProbe::getSiteName(CycleProbe::Site::H2_INGRESS),
+               "h2_ingress");
+  EXPECT_STREQ(CycleProbe::getSiteName(CycleProbe::Site::HPACK_DECODE),
+               "hpack_decode");
+}
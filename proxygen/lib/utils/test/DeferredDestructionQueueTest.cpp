@@ -0,0 +1,90 @@
+/*
+ *  Copyright (c) 2015-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include <proxygen/lib/utils/DeferredDestructionQueue.h>
+
+#include <folly/io/async/DelayedDestruction.h>
+#include <folly/portability/GTest.h>
+
+using namespace proxygen;
+
+namespace {
+
+class Tracked : public folly::DelayedDestruction {
+ public:
+  explicit Tracked(uint32_t* freed) : freed_(freed) {
+  }
+
+ private:
+  ~Tracked() override {
+    (*freed_)++;
+  }
+
+  uint32_t* freed_;
+};
+
+}
+
+TEST(DeferredDestructionQueueTest, BatchesGuardedFrees) {
+  folly::EventBase evb;
+  auto& queue = DeferredDestructionQueue::get(evb);
+  uint32_t freed = 0;
+
+  auto obj1 = new Tracked(&freed);
+  auto obj2 = new Tracked(&freed);
+  queue.add(folly::DelayedDestruction::DestructorGuard(obj1));
+  queue.add(folly::DelayedDestruction::DestructorGuard(obj2));
+  obj1->destroy();
+  obj2->destroy();
+
+  // The queued guards keep both objects alive until the drain pass
+  EXPECT_EQ(freed, 0);
+  EXPECT_EQ(queue.pendingCount(), 2);
+  evb.loopOnce();
+  EXPECT_EQ(freed, 2);
+  EXPECT_EQ(queue.pendingCount(), 0);
+}
+
+TEST(DeferredDestructionQueueTest, GuardOutlivesDrainIfStillReferenced) {
+  folly::EventBase evb;
+  auto& queue = DeferredDestructionQueue::get(evb);
+  uint32_t freed = 0;
+
+  auto obj = new Tracked(&freed);
+  {
+    folly::DelayedDestruction::DestructorGuard guard(obj);
+    queue.add(folly::DelayedDestruction::DestructorGuard(obj));
+    obj->destroy();
+    evb.loopOnce();
+    // An outside guard still references the object; the drain only
+    // released its own
+    EXPECT_EQ(freed, 0);
+  }
+  EXPECT_EQ(freed, 1);
+}
+
+TEST(DeferredDestructionQueueTest, FreesChainsInDrain) {
+  folly::EventBase evb;
+  auto& queue = DeferredDestructionQueue::get(evb);
+
+  queue.add(folly::IOBuf::copyBuffer("deferred"));
+  queue.add(std::unique_ptr<folly::IOBuf>());
+  EXPECT_EQ(queue.pendingCount(), 1);
+  evb.loopOnce();
+  EXPECT_EQ(queue.pendingCount(), 0);
+}
+
+TEST(DeferredDestructionQueueTest, PerEventBaseInstances) {
+  folly::EventBase evb1;
+  folly::EventBase evb2;
+  EXPECT_EQ(&DeferredDestructionQueue::get(evb1),
+            &DeferredDestructionQueue::get(evb1));
+  EXPECT_NE(&DeferredDestructionQueue::get(evb1),
+            &DeferredDestructionQueue::get(evb2));
+}
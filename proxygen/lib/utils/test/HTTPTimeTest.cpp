@@ -10,6 +10,7 @@
 #include <folly/portability/GTest.h>
 #include <proxygen/lib/utils/HTTPTime.h>
 
+using proxygen::formatHTTPDateTime;
 using proxygen::parseHTTPDateTime;
 
 TEST(HTTPTimeTests, InvalidTimeTest) {
@@ -51,6 +52,19 @@ TEST(HTTPTimeTests, ReallyOldTimeTest) {
   EXPECT_LT(b, c);
 }
 
+TEST(HTTPTimeTests, FormatTest) {
+  EXPECT_EQ(formatHTTPDateTime(0), "Thu, 01 Jan 1970 00:00:00 GMT");
+  EXPECT_EQ(formatHTTPDateTime(-1), "Wed, 31 Dec 1969 23:59:59 GMT");
+  EXPECT_EQ(formatHTTPDateTime(784111777), "Sun, 06 Nov 1994 08:49:37 GMT");
+  EXPECT_EQ(formatHTTPDateTime(2147483647), "Tue, 19 Jan 2038 03:14:07 GMT");
+}
+
+TEST(HTTPTimeTests, FormatParseRoundTripTest) {
+  for (int64_t t = 1528926229; t < 1528926229 + 90000; t += 12345) {
+    EXPECT_EQ(parseHTTPDateTime(formatHTTPDateTime(t)).value(), t);
+  }
+}
+
 TEST(HTTPTimeTests, TzToUnixTsTest) {
   auto a = parseHTTPDateTime("Wed, 13 Jun 2018 21:43:49 GMT");
   EXPECT_EQ(a.value(), 1528926229);
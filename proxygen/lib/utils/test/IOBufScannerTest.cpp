@@ -0,0 +1,108 @@
+/*
+ *  Copyright (c) 2015-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include <proxygen/lib/utils/IOBufScanner.h>
+
+#include <folly/portability/GTest.h>
+
+using folly::IOBuf;
+using proxygen::IOBufScanner;
+
+namespace {
+
+// "The quick brown fox" split across four buffers with an empty one in
+// the middle, the way codec output tends to arrive
+std::unique_ptr<IOBuf> makeChain() {
+  auto chain = IOBuf::copyBuffer("The qui");
+  chain->prependChain(IOBuf::copyBuffer("ck br"));
+  chain->prependChain(IOBuf::create(0));
+  chain->prependChain(IOBuf::copyBuffer("own "));
+  chain->prependChain(IOBuf::copyBuffer("fox"));
+  return chain;
+}
+
+folly::ByteRange br(folly::StringPiece sp) {
+  return folly::ByteRange(sp);
+}
+
+} // namespace
+
+TEST(IOBufScanner, SpansCoverChainOnce) {
+  auto chain = makeChain();
+  IOBufScanner scanner(chain.get());
+  EXPECT_EQ(scanner.remaining(), 19);
+
+  std::string seen;
+  while (!scanner.isExhausted()) {
+    auto span = scanner.peekSpan();
+    ASSERT_FALSE(span.empty());
+    seen.append(reinterpret_cast<const char*>(span.data()), span.size());
+    scanner.skip(span.size());
+  }
+  EXPECT_EQ(seen, "The quick brown fox");
+  EXPECT_EQ(scanner.offset(), 19);
+  EXPECT_TRUE(scanner.peekSpan().empty());
+}
+
+TEST(IOBufScanner, PeekStitchesOnlyAcrossBoundaries) {
+  auto chain = makeChain();
+  IOBufScanner scanner(chain.get());
+
+  // Entirely within the first buffer: served in place, no copy
+  auto window = scanner.peek(4);
+  EXPECT_EQ(window.data(), chain->data());
+  EXPECT_EQ(folly::StringPiece(window), "The ");
+
+  // Straddling the first boundary: stitched, but still the right bytes
+  window = scanner.peek(10);
+  EXPECT_NE(window.data(), chain->data());
+  EXPECT_EQ(folly::StringPiece(window), "The quick ");
+
+  // Clamped to what is left
+  scanner.skip(15);
+  window = scanner.peek(100);
+  EXPECT_EQ(folly::StringPiece(window), " fox");
+}
+
+TEST(IOBufScanner, FindByte) {
+  auto chain = makeChain();
+  IOBufScanner scanner(chain.get());
+
+  // 'b' lives in the second buffer
+  EXPECT_EQ(scanner.find(uint8_t('b')), 10);
+  EXPECT_EQ(scanner.offset(), 10);
+  // The cursor sits on the match; step past it to find the next 'o'
+  scanner.skip(1);
+  EXPECT_EQ(scanner.find(uint8_t('o')), 12);
+  // A miss exhausts the scanner
+  EXPECT_EQ(scanner.find(uint8_t('z')), IOBufScanner::npos);
+  EXPECT_TRUE(scanner.isExhausted());
+}
+
+TEST(IOBufScanner, FindNeedle) {
+  auto chain = makeChain();
+
+  // Entirely inside one buffer
+  IOBufScanner scanner(chain.get());
+  EXPECT_EQ(scanner.find(br("qui")), 4);
+  EXPECT_EQ(scanner.offset(), 4);
+
+  // Straddling a buffer boundary ("quick" splits after "qui")
+  IOBufScanner straddle(chain.get());
+  EXPECT_EQ(straddle.find(br("quick br")), 4);
+
+  // Straddling two boundaries, across the empty buffer
+  IOBufScanner wide(chain.get());
+  EXPECT_EQ(wide.find(br("brown f")), 10);
+
+  // A miss exhausts the scanner
+  IOBufScanner miss(chain.get());
+  EXPECT_EQ(miss.find(br("quick brawn")), IOBufScanner::npos);
+  EXPECT_TRUE(miss.isExhausted());
+}
@@ -0,0 +1,42 @@
+/*
+ *  Copyright (c) 2019-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include <proxygen/lib/utils/KTLSUtil.h>
+
+#include <folly/io/async/AsyncSocket.h>
+#include <folly/io/async/EventBase.h>
+#include <folly/portability/GTest.h>
+
+using namespace proxygen;
+
+TEST(KTLSUtilTest, CipherEligibility) {
+  // TLS 1.2 AES-128-GCM suites, any key exchange
+  EXPECT_TRUE(KTLSUtil::isCipherEligible("ECDHE-ECDSA-AES128-GCM-SHA256"));
+  EXPECT_TRUE(KTLSUtil::isCipherEligible("ECDHE-RSA-AES128-GCM-SHA256"));
+  EXPECT_TRUE(KTLSUtil::isCipherEligible("DHE-RSA-AES128-GCM-SHA256"));
+  EXPECT_TRUE(KTLSUtil::isCipherEligible("AES128-GCM-SHA256"));
+
+  // Other bulk ciphers, CBC suites and TLS 1.3 names are not offloadable
+  EXPECT_FALSE(KTLSUtil::isCipherEligible("ECDHE-RSA-AES256-GCM-SHA384"));
+  EXPECT_FALSE(KTLSUtil::isCipherEligible("ECDHE-RSA-AES128-SHA256"));
+  EXPECT_FALSE(KTLSUtil::isCipherEligible("ECDHE-RSA-CHACHA20-POLY1305"));
+  EXPECT_FALSE(KTLSUtil::isCipherEligible("TLS_AES_128_GCM_SHA256"));
+  EXPECT_FALSE(KTLSUtil::isCipherEligible(""));
+}
+
+TEST(KTLSUtilTest, NonTLSTransportFallsBack) {
+  // A plaintext transport is returned untouched with no offload
+  folly::EventBase evb;
+  folly::AsyncTransportWrapper::UniquePtr sock(new folly::AsyncSocket(&evb));
+  auto* raw = sock.get();
+
+  auto result = KTLSUtil::tryOffload(std::move(sock));
+  EXPECT_FALSE(result.offloaded);
+  EXPECT_EQ(result.transport.get(), raw);
+}
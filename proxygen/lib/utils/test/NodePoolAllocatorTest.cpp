@@ -0,0 +1,60 @@
+/*
+ *  Copyright (c) 2015-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include <proxygen/lib/utils/NodePoolAllocator.h>
+
+#include <folly/portability/GTest.h>
+#include <map>
+
+using namespace proxygen;
+
+namespace {
+struct Node {
+  uint64_t payload[16];
+};
+} // namespace
+
+TEST(NodePoolAllocator, RecyclesSingleNodes) {
+  NodePoolAllocator<Node> alloc;
+  auto baseline = NodePoolAllocator<Node>::getPooledNodes();
+
+  Node* first = alloc.allocate(1);
+  alloc.deallocate(first, 1);
+  EXPECT_EQ(NodePoolAllocator<Node>::getPooledNodes(), baseline + 1);
+
+  // The freed node comes back on the next allocation
+  Node* second = alloc.allocate(1);
+  EXPECT_EQ(second, first);
+  EXPECT_EQ(NodePoolAllocator<Node>::getPooledNodes(), baseline);
+  alloc.deallocate(second, 1);
+}
+
+TEST(NodePoolAllocator, PoolIsCapped) {
+  NodePoolAllocator<Node, 4> alloc;
+  std::vector<Node*> nodes;
+  for (int i = 0; i < 8; i++) {
+    nodes.push_back(alloc.allocate(1));
+  }
+  for (auto node : nodes) {
+    alloc.deallocate(node, 1);
+  }
+  EXPECT_LE((NodePoolAllocator<Node, 4>::getPooledNodes()), 4);
+}
+
+TEST(NodePoolAllocator, WorksAsContainerAllocator) {
+  using Alloc = NodePoolAllocator<std::pair<const int, std::string>>;
+  std::map<int, std::string, std::less<int>, Alloc> m;
+  for (int round = 0; round < 3; round++) {
+    for (int i = 0; i < 10; i++) {
+      m.emplace(i, "value");
+    }
+    EXPECT_EQ(m.size(), 10);
+    m.clear();
+  }
+}
@@ -180,6 +180,44 @@ TYPED_TEST(PerfectIndexMapTests, BasicOtherKeySetAddRemoveGetSingleOrNone) {
   }
 }
 
+TYPED_TEST(PerfectIndexMapTests, OtherKeyDenseSearchAndOccupancy) {
+  // Enough same-length keys to span several of the 8-wide length-compare
+  // blocks used when searching, so candidate confirmation gets exercised
+  // and not just the vectorized reject path
+  const size_t numInserted = 20;
+  for (size_t num = 0; num < numInserted; ++num) {
+    std::string key = "x-test-key-" + std::to_string(10 + num);
+    this->testMap_.set(key, std::to_string(num));
+  }
+  auto stats = this->testMap_.getOccupancyStats();
+  EXPECT_EQ(stats.totalSlots, numInserted);
+  EXPECT_EQ(stats.liveSlots, numInserted);
+  EXPECT_EQ(stats.otherKeySlots, numInserted);
+  EXPECT_EQ(stats.tombstoneSlots, 0);
+
+  // Removals leave tombstones behind whose cached length bytes still
+  // match; searches must skip them
+  EXPECT_TRUE(this->testMap_.remove(std::string("x-test-key-13")));
+  EXPECT_FALSE(
+    this->testMap_.getSingleOrNone(std::string("x-test-key-13")).hasValue());
+  stats = this->testMap_.getOccupancyStats();
+  EXPECT_EQ(stats.totalSlots, numInserted);
+  EXPECT_EQ(stats.liveSlots, numInserted - 1);
+  EXPECT_EQ(stats.otherKeySlots, numInserted - 1);
+  EXPECT_EQ(stats.tombstoneSlots, 1);
+
+  // Verify the integrity of the map
+  for (size_t num = 0; num < numInserted; ++num) {
+    if (num == 3) {
+      continue;
+    }
+    auto optional = this->testMap_.getSingleOrNone(
+      "x-test-key-" + std::to_string(10 + num));
+    ASSERT_TRUE(optional.hasValue());
+    ASSERT_EQ(optional.value(), std::to_string(num));
+  }
+}
+
 // Note there is no corresponding key string case sensitivity test as that is
 // controlled by the specified hashing function of the map.  The user in
 // creating the map thus chooses whether the hashing function should be case
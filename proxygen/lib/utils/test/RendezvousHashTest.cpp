@@ -301,3 +301,36 @@ TEST(RendezvousHash, selectNUnweighted) {
     EXPECT_GT(different, 0);
   }
 }
+
+TEST(RendezvousHash, selectNWeighted) {
+  RendezvousHash hashes;
+  std::vector<std::pair<std::string, uint64_t>> nodes;
+  int size = 100;
+  for (int i = 0; i < size; ++i) {
+    nodes.emplace_back(folly::to<std::string>("key", i), i % 10 + 1);
+  }
+  hashes.build(nodes);
+  auto seed = 91484253;
+
+  // rank > size returns everything, still in rendezvous order
+  auto select = hashes.selectNWeighted(seed, size + 10);
+  EXPECT_EQ(select.size(), size);
+
+  int rank = size / 4;
+  select = hashes.selectNWeighted(seed, rank);
+  EXPECT_EQ(select.size(), rank);
+
+  // element 0 is the primary choice, the rest are distinct fallbacks
+  EXPECT_EQ(select[0], hashes.get(seed));
+  std::set<size_t> uniqueIndex;
+  for (auto index : select) {
+    EXPECT_EQ(uniqueIndex.count(index), 0);
+    uniqueIndex.insert(index);
+    EXPECT_LT(index, size);
+  }
+
+  // the ordering is the successive-rank ordering of get()
+  for (int r = 0; r < rank; r++) {
+    EXPECT_EQ(select[r], hashes.get(seed, r));
+  }
+}
@@ -0,0 +1,54 @@
+/*
+ *  Copyright (c) 2015-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include <proxygen/lib/utils/ShardedCounter.h>
+
+#include <folly/portability/GTest.h>
+#include <thread>
+#include <vector>
+
+using namespace proxygen;
+
+TEST(ShardedCounter, AddAndSub) {
+  ShardedCounter counter;
+  EXPECT_EQ(0, counter.value());
+  counter.add();
+  counter.add(41);
+  EXPECT_EQ(42, counter.value());
+  counter.sub(2);
+  EXPECT_EQ(40, counter.value());
+}
+
+TEST(ShardedCounter, Collect) {
+  ShardedCounter counter;
+  counter.add(10);
+  EXPECT_EQ(10, counter.collect());
+  EXPECT_EQ(0, counter.collect());
+  counter.add(5);
+  EXPECT_EQ(5, counter.collect());
+  EXPECT_EQ(15, counter.value());
+}
+
+TEST(ShardedCounter, ConcurrentAdds) {
+  ShardedCounter counter;
+  const int kThreads = 8;
+  const int kAddsPerThread = 10000;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kThreads; t++) {
+    threads.emplace_back([&counter] {
+      for (int i = 0; i < kAddsPerThread; i++) {
+        counter.add();
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(kThreads * kAddsPerThread, counter.value());
+}
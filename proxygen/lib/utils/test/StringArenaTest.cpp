@@ -0,0 +1,81 @@
+/*
+ *  Copyright (c) 2015-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include <folly/portability/GTest.h>
+#include <proxygen/lib/http/HTTPMessage.h>
+#include <proxygen/lib/utils/StringArena.h>
+
+using namespace proxygen;
+
+TEST(StringArena, BumpAllocation) {
+  StringArena arena(64);
+  auto p1 = arena.allocate(8);
+  auto p2 = arena.allocate(8);
+  EXPECT_NE(p1, nullptr);
+  EXPECT_NE(p2, nullptr);
+  EXPECT_NE(p1, p2);
+  // Both fit in the first block
+  EXPECT_EQ(arena.bytesAllocated(), 64);
+  // Force a second block
+  arena.allocate(64);
+  EXPECT_EQ(arena.bytesAllocated(), 128);
+  // An oversized request gets a dedicated block
+  arena.allocate(1024);
+  EXPECT_GE(arena.bytesAllocated(), 128 + 1024);
+}
+
+TEST(StringArena, NewStringAndClear) {
+  StringArena arena;
+  auto s = arena.newString("x-custom-header");
+  EXPECT_EQ(*s, "x-custom-header");
+  // Strings longer than SSO still round-trip; their out-of-line buffers are
+  // reclaimed by clear()
+  std::string longName(100, 'z');
+  auto l = arena.newString(longName);
+  EXPECT_EQ(*l, longName);
+  arena.clear();
+  // Arena remains usable after a wholesale release
+  auto t = arena.newString("x-other");
+  EXPECT_EQ(*t, "x-other");
+}
+
+TEST(StringArena, HeadersFromArena) {
+  auto arena = std::make_shared<StringArena>();
+  HTTPMessage msg;
+  msg.setAllocationArena(arena);
+  auto& headers = msg.getHeaders();
+  headers.add("X-Uncommon-One", "1");
+  headers.add("X-Uncommon-Two", "2");
+  headers.add(HTTP_HEADER_HOST, "example.com");
+  EXPECT_EQ(headers.getSingleOrEmpty("X-Uncommon-One"), "1");
+  EXPECT_EQ(headers.getSingleOrEmpty(HTTP_HEADER_HOST), "example.com");
+  EXPECT_EQ(headers.size(), 3);
+  EXPECT_GT(arena->bytesAllocated(), 0);
+
+  // Copies own their names independently of the arena
+  HTTPMessage copy(msg);
+  EXPECT_EQ(copy.getHeaders().getSingleOrEmpty("X-Uncommon-Two"), "2");
+
+  // Moves carry the arena along with the borrowed names
+  HTTPMessage moved(std::move(msg));
+  EXPECT_EQ(moved.getHeaders().getSingleOrEmpty("X-Uncommon-One"), "1");
+  EXPECT_EQ(moved.getAllocationArena(), arena);
+}
+
+TEST(StringArena, RemoveArenaOwnedName) {
+  auto arena = std::make_shared<StringArena>();
+  HTTPMessage msg;
+  msg.setAllocationArena(arena);
+  auto& headers = msg.getHeaders();
+  headers.add("X-Uncommon", "v");
+  EXPECT_TRUE(headers.remove("X-Uncommon"));
+  EXPECT_EQ(headers.size(), 0);
+  // The arena still owns the name storage; nothing was freed piecemeal
+  EXPECT_GT(arena->bytesAllocated(), 0);
+}
@@ -0,0 +1,48 @@
+/*
+ *  Copyright (c) 2015-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include <proxygen/lib/utils/StructuredLog.h>
+
+#include <folly/portability/GTest.h>
+
+using namespace proxygen;
+
+TEST(StructuredLogTest, LogAndDrain) {
+  StructuredLog::drainCurrentThread();
+  PROXYGEN_SLOG(CODEC_ERROR, 7, 3);
+  auto records = StructuredLog::drainCurrentThread();
+  ASSERT_EQ(records.size(), 1);
+  EXPECT_EQ(records[0].site, StructuredLog::Site::CODEC_ERROR);
+  EXPECT_EQ(records[0].id, 7);
+  EXPECT_EQ(records[0].value, 3);
+
+  // A drained record is consumed
+  EXPECT_TRUE(StructuredLog::drainCurrentThread().empty());
+}
+
+TEST(StructuredLogTest, Format) {
+  StructuredLog::drainCurrentThread();
+  PROXYGEN_SLOG(CODEC_DISCARD_BODY, 11, 1024);
+  auto records = StructuredLog::drainCurrentThread();
+  ASSERT_EQ(records.size(), 1);
+  auto text = StructuredLog::format(records[0]);
+  EXPECT_NE(text.find("codec_discard_body"), std::string::npos);
+  EXPECT_NE(text.find("id=11"), std::string::npos);
+  EXPECT_NE(text.find("value=1024"), std::string::npos);
+}
+
+TEST(StructuredLogTest, Sampling) {
+  StructuredLog::drainCurrentThread();
+  StructuredLog::setSampleEvery(10);
+  for (int i = 0; i < 100; i++) {
+    PROXYGEN_SLOG(CODEC_ERROR, i, 0);
+  }
+  EXPECT_EQ(StructuredLog::drainCurrentThread().size(), 10);
+  StructuredLog::setSampleEvery(1);
+}
@@ -0,0 +1,76 @@
+/*
+ *  Copyright (c) 2015-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include <folly/portability/GTest.h>
+#include <proxygen/lib/utils/URLScan.h>
+#include <string>
+
+using namespace proxygen;
+
+TEST(URLScanTest, Delimiters) {
+  auto scan = scanURL(folly::StringPiece("host:80/path?query#frag"));
+  EXPECT_TRUE(scan.valid);
+  EXPECT_EQ(scan.pathStart, 7);
+  EXPECT_EQ(scan.queryStart, 12);
+  EXPECT_EQ(scan.hashStart, 18);
+}
+
+TEST(URLScanTest, MissingDelimiters) {
+  auto scan = scanURL(folly::StringPiece("host:8080"));
+  EXPECT_TRUE(scan.valid);
+  EXPECT_EQ(scan.pathStart, std::string::npos);
+  EXPECT_EQ(scan.queryStart, std::string::npos);
+  EXPECT_EQ(scan.hashStart, std::string::npos);
+}
+
+TEST(URLScanTest, FirstOccurrenceWins) {
+  // Delimiters past the first of their kind are ignored, and the scan
+  // must find them across the 16-byte block boundary
+  std::string url = "/really/long/path/with/lots/of/slashes?a=1&b=2?x#y#z";
+  auto scan = scanURL(folly::StringPiece(url));
+  EXPECT_TRUE(scan.valid);
+  EXPECT_EQ(scan.pathStart, 0);
+  EXPECT_EQ(scan.queryStart, url.find('?'));
+  EXPECT_EQ(scan.hashStart, url.find('#'));
+}
+
+TEST(URLScanTest, InvalidBytes) {
+  EXPECT_FALSE(scanURL(folly::StringPiece("/pa th")).valid);
+  EXPECT_FALSE(scanURL(folly::StringPiece("/path\x7f")).valid);
+  EXPECT_FALSE(
+      scanURL(folly::StringPiece("/a/long/enough/path/to/vectorize\tx")).valid);
+}
+
+TEST(URLScanTest, UnescapeNoEscapes) {
+  std::string out;
+  EXPECT_TRUE(urlUnescapeQuery(out, "plain-value-with-no-escapes-at-all"));
+  EXPECT_EQ(out, "plain-value-with-no-escapes-at-all");
+  EXPECT_TRUE(urlUnescapeQuery(out, ""));
+  EXPECT_EQ(out, "");
+}
+
+TEST(URLScanTest, UnescapeEscapes) {
+  std::string out;
+  EXPECT_TRUE(urlUnescapeQuery(out, "a+b"));
+  EXPECT_EQ(out, "a b");
+  EXPECT_TRUE(urlUnescapeQuery(out, "%48%65%6c%6Co"));
+  EXPECT_EQ(out, "Hello");
+  EXPECT_TRUE(urlUnescapeQuery(out, "mixed%20and+plain/text%2Fhere"));
+  EXPECT_EQ(out, "mixed and plain/text/here");
+}
+
+TEST(URLScanTest, UnescapeMalformed) {
+  std::string out;
+  EXPECT_FALSE(urlUnescapeQuery(out, "truncated%4"));
+  EXPECT_EQ(out, "");
+  EXPECT_FALSE(urlUnescapeQuery(out, "bad%zzescape"));
+  EXPECT_EQ(out, "");
+  EXPECT_FALSE(urlUnescapeQuery(out, "trailing%"));
+  EXPECT_EQ(out, "");
+}
@@ -0,0 +1,76 @@
+/*
+ *  Copyright (c) 2019-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include <proxygen/lib/utils/WheelTimerInstance.h>
+
+#include <folly/io/async/EventBase.h>
+#include <folly/portability/GTest.h>
+
+using namespace proxygen;
+
+namespace {
+
+class TestCallback : public folly::HHWheelTimer::Callback {
+ public:
+  void timeoutExpired() noexcept override {
+    expired = true;
+  }
+  void callbackCanceled() noexcept override {
+    canceled = true;
+  }
+  bool expired{false};
+  bool canceled{false};
+};
+
+} // namespace
+
+TEST(WheelTimerInstanceTest, EmptyInstanceIgnoresSchedules) {
+  WheelTimerInstance timer;
+  EXPECT_FALSE(timer);
+  TestCallback cb;
+  timer.scheduleTimeout(&cb, std::chrono::milliseconds(1));
+  timer.scheduleCoarseTimeout(&cb, std::chrono::milliseconds(1));
+  EXPECT_FALSE(cb.isScheduled());
+}
+
+TEST(WheelTimerInstanceTest, FineAndCoarseTimeoutsFire) {
+  folly::EventBase evb;
+  WheelTimerInstance timer(std::chrono::milliseconds(50), &evb);
+  TestCallback fine;
+  TestCallback coarse;
+  timer.scheduleTimeout(&fine, std::chrono::milliseconds(10));
+  // Coarse schedules round up to the 100ms tick, so this fires late but
+  // never early.
+  timer.scheduleCoarseTimeout(&coarse, std::chrono::milliseconds(10));
+  evb.loop();
+  EXPECT_TRUE(fine.expired);
+  EXPECT_TRUE(coarse.expired);
+}
+
+TEST(WheelTimerInstanceTest, CoarseFallsBackOnBareWheel) {
+  folly::EventBase evb;
+  // Constructed around a bare wheel there is no EventBase to attach a
+  // coarse wheel to, so coarse schedules get fine-grained service.
+  WheelTimerInstance timer(&evb.timer());
+  TestCallback cb;
+  timer.scheduleCoarseTimeout(&cb, std::chrono::milliseconds(10));
+  evb.loop();
+  EXPECT_TRUE(cb.expired);
+}
+
+TEST(WheelTimerInstanceTest, CancelBeforeCoarseFire) {
+  folly::EventBase evb;
+  WheelTimerInstance timer(std::chrono::milliseconds(50), &evb);
+  TestCallback cb;
+  timer.scheduleCoarseTimeout(&cb, std::chrono::milliseconds(10));
+  cb.cancelTimeout();
+  evb.loop();
+  EXPECT_FALSE(cb.expired);
+  EXPECT_TRUE(cb.canceled);
+}
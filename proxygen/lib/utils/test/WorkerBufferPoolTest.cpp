@@ -0,0 +1,85 @@
+/*
+ *  Copyright (c) 2015-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include <folly/portability/GTest.h>
+#include <proxygen/lib/utils/WorkerBufferPool.h>
+
+using namespace proxygen;
+
+TEST(WorkerBufferPool, AllocateAndRecycle) {
+  WorkerBufferPool pool;
+
+  auto buf = pool.allocate();
+  ASSERT_NE(buf, nullptr);
+  EXPECT_EQ(buf->length(), 0);
+  EXPECT_EQ(buf->tailroom(), WorkerBufferPool::kBlockSize);
+  EXPECT_EQ(pool.getOutstandingBlocks(), 1);
+  EXPECT_EQ(pool.getPooledBlocks(), 0);
+
+  auto block = buf->writableTail();
+  buf.reset();
+  EXPECT_EQ(pool.getOutstandingBlocks(), 0);
+  EXPECT_EQ(pool.getPooledBlocks(), 1);
+
+  // The recycled block comes back out of the pool
+  auto buf2 = pool.allocate();
+  EXPECT_EQ(buf2->writableTail(), block);
+  EXPECT_EQ(pool.getPooledBlocks(), 0);
+}
+
+TEST(WorkerBufferPool, ViewsPinBlock) {
+  WorkerBufferPool pool;
+
+  // Refcounted views into a slab - as handed to the parser by
+  // HTTPSession::readDataAvailable - keep the block out of the pool
+  // until the last one is released
+  auto slab = pool.allocate();
+  memset(slab->writableTail(), 'x', 100);
+  slab->append(100);
+  auto view = slab->cloneOne();
+  view->trimStart(50);
+  EXPECT_EQ(view->length(), 50);
+
+  slab.reset();
+  EXPECT_EQ(pool.getOutstandingBlocks(), 1);
+  EXPECT_EQ(pool.getPooledBlocks(), 0);
+
+  view.reset();
+  EXPECT_EQ(pool.getOutstandingBlocks(), 0);
+  EXPECT_EQ(pool.getPooledBlocks(), 1);
+}
+
+TEST(WorkerBufferPool, HighWatermark) {
+  WorkerBufferPool pool;
+
+  std::vector<std::unique_ptr<folly::IOBuf>> bufs;
+  for (int i = 0; i < 5; i++) {
+    bufs.push_back(pool.allocate());
+  }
+  EXPECT_EQ(pool.getHighWatermark(), 5);
+
+  bufs.clear();
+  EXPECT_EQ(pool.getOutstandingBlocks(), 0);
+  EXPECT_EQ(pool.getPooledBlocks(), 5);
+
+  // The watermark records the peak, not the current level
+  auto buf = pool.allocate();
+  EXPECT_EQ(pool.getHighWatermark(), 5);
+}
+
+TEST(WorkerBufferPool, PerThreadInstance) {
+  auto pool = WorkerBufferPool::get();
+  ASSERT_NE(pool, nullptr);
+  EXPECT_EQ(pool, WorkerBufferPool::get());
+
+  auto buf = pool->allocate();
+  EXPECT_EQ(pool->getOutstandingBlocks(), 1);
+  buf.reset();
+  EXPECT_EQ(pool->getOutstandingBlocks(), 0);
+}
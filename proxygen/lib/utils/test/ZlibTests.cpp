@@ -7,6 +7,7 @@
  *  of patent rights can be found in the PATENTS file in the same directory.
  *
  */
+#include <cstring>
 #include <folly/Random.h>
 #include <folly/ScopeGuard.h>
 #include <folly/io/Cursor.h>
@@ -102,6 +103,24 @@ TEST_F(ZlibTests, CompressDecompressEmpty) {
       { compressThenDecompress(CompressionType::GZIP, 4, makeBuf(0)); });
 }
 
+// A highly compressible one-shot body is sized from deflateBound and then
+// repacked to exact fit; the roundtrip must survive the repack and the
+// returned buffer must not carry the bound's slack
+TEST_F(ZlibTests, CompressDecompressRepack) {
+  ASSERT_NO_FATAL_FAILURE({
+    auto buf = folly::IOBuf::create(64 * 1024);
+    memset(buf->writableData(), 'a', 64 * 1024);
+    buf->append(64 * 1024);
+
+    auto zc = std::make_unique<ZlibStreamCompressor>(CompressionType::GZIP, 6);
+    auto compressed = zc->compress(buf.get(), true);
+    ASSERT_FALSE(zc->hasError());
+    EXPECT_LT(compressed->tailroom(), 4096);
+
+    verify(CompressionType::GZIP, std::move(buf), std::move(compressed));
+  });
+}
+
 TEST_F(ZlibTests, CompressDecompressChain) {
   ASSERT_NO_FATAL_FAILURE({
     auto buf = makeBuf(4);
@@ -147,3 +166,53 @@ TEST_F(ZlibTests, CompressDecompressSmallBuffer) {
     compressThenDecompress(CompressionType::GZIP, 4, makeBuf(127));
   });
 }
+
+TEST_F(ZlibTests, PooledStateReuse) {
+  // Back to back compressors with the same (type, level) share a pooled
+  // deflate state; each must still produce an independently decodable stream
+  for (int i = 0; i < 3; i++) {
+    ASSERT_NO_FATAL_FAILURE(
+        { compressThenDecompress(CompressionType::GZIP, 6, makeBuf(2000)); });
+  }
+}
+
+TEST_F(ZlibTests, DeflateDictionary) {
+  const std::string dict =
+      "\"transaction_identifier\":\"response_status\":\"creation_timestamp\":";
+  const std::string body =
+      "{\"transaction_identifier\":123,\"response_status\":\"ok\","
+      "\"creation_timestamp\":\"2019-06-01\"}";
+  auto buf = IOBuf::copyBuffer(body);
+
+  ZlibStreamCompressor plain(CompressionType::DEFLATE, 6);
+  auto plainOut = plain.compress(buf.get(), true);
+  ASSERT_FALSE(plain.hasError());
+
+  ZlibStreamCompressor primed(CompressionType::DEFLATE, 6);
+  primed.setDictionary(reinterpret_cast<const uint8_t*>(dict.data()),
+                       dict.size());
+  auto primedOut = primed.compress(buf.get(), true);
+  ASSERT_FALSE(primed.hasError());
+  EXPECT_LT(primedOut->computeChainDataLength(),
+            plainOut->computeChainDataLength());
+
+  // Inflate with the same preset dictionary, supplied on Z_NEED_DICT
+  auto coalesced = primedOut->coalesce();
+  z_stream stream;
+  memset(&stream, 0, sizeof(stream));
+  ASSERT_EQ(inflateInit(&stream), Z_OK);
+  std::string decoded(body.size(), '\0');
+  stream.next_in = const_cast<uint8_t*>(coalesced.data());
+  stream.avail_in = coalesced.size();
+  stream.next_out = reinterpret_cast<uint8_t*>(&decoded[0]);
+  stream.avail_out = decoded.size();
+  ASSERT_EQ(inflate(&stream, Z_FINISH), Z_NEED_DICT);
+  ASSERT_EQ(
+      inflateSetDictionary(&stream,
+                           reinterpret_cast<const uint8_t*>(dict.data()),
+                           dict.size()),
+      Z_OK);
+  EXPECT_EQ(inflate(&stream, Z_FINISH), Z_STREAM_END);
+  EXPECT_EQ(decoded, body);
+  inflateEnd(&stream);
+}
@@ -14,6 +14,7 @@
 #include <folly/io/IOBuf.h>
 #include <folly/portability/GTest.h>
 #include <glog/logging.h>
+#include <proxygen/lib/utils/ZstdStreamCompressor.h>
 #include <proxygen/lib/utils/ZstdStreamDecompressor.h>
 
 using namespace folly;
@@ -163,3 +164,31 @@ TEST_F(ZstdTests, CompressDecompressStreaming) {
   ASSERT_NO_FATAL_FAILURE(
       { compressThenDecompressPieces(std::move(input_pieces)); });
 }
+
+TEST_F(ZstdTests, StreamCompressorRoundTrip) {
+  // Level picked per response size; successive compressors on the same
+  // thread exercise the pooled-CStream reuse path
+  for (int i = 0; i < 3; i++) {
+    auto zc = std::make_unique<ZstdStreamCompressor>();
+    auto buf = makeBuf(2000);
+    auto compressed = zc->compress(buf.get(), true);
+    ASSERT_FALSE(zc->hasError());
+    ASSERT_NO_FATAL_FAILURE(
+        { verify(std::move(buf), std::move(compressed)); });
+  }
+}
+
+TEST_F(ZstdTests, StreamCompressorStreaming) {
+  auto zc = std::make_unique<ZstdStreamCompressor>(3);
+  auto first = makeBuf(38);
+  auto second = makeBuf(4096);
+
+  std::vector<std::unique_ptr<folly::IOBuf>> compressed_pieces;
+  compressed_pieces.push_back(zc->compress(first.get(), false));
+  compressed_pieces.push_back(zc->compress(second.get(), true));
+  ASSERT_FALSE(zc->hasError());
+
+  first->appendChain(std::move(second));
+  ASSERT_NO_FATAL_FAILURE(
+      { verifyPieces(std::move(first), std::move(compressed_pieces)); });
+}